@@ -72,7 +72,6 @@ setup(
 
 
         'tensorflow-metadata>=0.9,<0.10',
-        'tensorflow-transform>=0.11,<0.12',
 
         # Dependencies needed for visualization.
         'IPython>=5.0,<6',
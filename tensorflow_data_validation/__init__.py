@@ -16,13 +16,18 @@
 
 # Import stats API.
 from tensorflow_data_validation.api.stats_api import GenerateStatistics
+from tensorflow_data_validation.api.stats_api import GenerateStatisticsFromBatches
 
 # Import validation API.
 from tensorflow_data_validation.api.validation_api import infer_schema
+from tensorflow_data_validation.api.validation_api import SchemaValidator
 from tensorflow_data_validation.api.validation_api import validate_statistics
+from tensorflow_data_validation.api.validation_api import validate_statistics_batch
 
 # Import coders.
 from tensorflow_data_validation.coders.csv_decoder import DecodeCSV
+from tensorflow_data_validation.coders.csv_decoder import DecodeCSVBatches
+from tensorflow_data_validation.coders.tf_example_decoder import DecodeTFExampleBatches
 from tensorflow_data_validation.coders.tf_example_decoder import TFExampleDecoder
 
 # Import stats generators.
@@ -0,0 +1,53 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/anomaly_sink.h"
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+Status CallbackAnomalySink::WriteHeader(
+    const metadata::v0::Anomalies& header) {
+  return Status::OK();
+}
+
+Status CallbackAnomalySink::WriteAnomalyInfo(
+    const string& name, const metadata::v0::AnomalyInfo& anomaly_info) {
+  return callback_(name, anomaly_info);
+}
+
+Status SerializedAnomaliesSink::WriteHeader(
+    const metadata::v0::Anomalies& header) {
+  if (!header.SerializeToString(&buffer_)) {
+    return errors::Internal("Could not serialize the header of anomalies");
+  }
+  return write_(buffer_);
+}
+
+Status SerializedAnomaliesSink::WriteAnomalyInfo(
+    const string& name, const metadata::v0::AnomalyInfo& anomaly_info) {
+  // An Anomalies proto with only this entry serializes to the entry.
+  metadata::v0::Anomalies entry;
+  (*entry.mutable_anomaly_info())[name] = anomaly_info;
+  if (!entry.SerializeToString(&buffer_)) {
+    return errors::Internal("Could not serialize the anomaly of ", name);
+  }
+  return write_(buffer_);
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
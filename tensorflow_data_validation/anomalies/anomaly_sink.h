@@ -0,0 +1,90 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Sinks that receive the schema diff of a validation one anomaly at a time
+// (see ValidateFeatureStatisticsToSink()), so that the whole Anomalies proto
+// is never held in memory.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_ANOMALY_SINK_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_ANOMALY_SINK_H_
+
+#include <functional>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/anomalies.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+class AnomalySink {
+ public:
+  virtual ~AnomalySink() = default;
+
+  // Called once, before the anomalies, with the fields of the Anomalies
+  // proto other than anomaly_info.
+  virtual Status WriteHeader(const metadata::v0::Anomalies& header) = 0;
+
+  // Called for each anomaly, with its key in Anomalies.anomaly_info. An
+  // error stops the validation, and is returned by it.
+  virtual Status WriteAnomalyInfo(
+      const string& name, const metadata::v0::AnomalyInfo& anomaly_info) = 0;
+};
+
+// An AnomalySink that passes each anomaly to a callback, and drops the
+// header.
+class CallbackAnomalySink : public AnomalySink {
+ public:
+  using Callback = std::function<Status(
+      const string& name, const metadata::v0::AnomalyInfo& anomaly_info)>;
+
+  explicit CallbackAnomalySink(Callback callback)
+      : callback_(std::move(callback)) {}
+
+  Status WriteHeader(const metadata::v0::Anomalies& header) override;
+  Status WriteAnomalyInfo(
+      const string& name,
+      const metadata::v0::AnomalyInfo& anomaly_info) override;
+
+ private:
+  const Callback callback_;
+};
+
+// An AnomalySink that serializes the header, and then each anomaly, as soon
+// as it receives them, and passes the bytes to write (e.g., to append them
+// to a file). As a serialized map is a sequence of entries, the bytes
+// written parse as the Anomalies proto that the validation would return.
+class SerializedAnomaliesSink : public AnomalySink {
+ public:
+  using Writer = std::function<Status(absl::string_view data)>;
+
+  explicit SerializedAnomaliesSink(Writer write) : write_(std::move(write)) {}
+
+  Status WriteHeader(const metadata::v0::Anomalies& header) override;
+  Status WriteAnomalyInfo(
+      const string& name,
+      const metadata::v0::AnomalyInfo& anomaly_info) override;
+
+ private:
+  const Writer write_;
+  // Reused for each anomaly.
+  string buffer_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_ANOMALY_SINK_H_
@@ -0,0 +1,197 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/basic_stats_accumulators.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+namespace {
+
+using ::tensorflow::metadata::v0::FeatureNameStatistics;
+
+// Sets *type to type if *has_type is false. Otherwise, returns
+// InvalidArgument if type differs from *type.
+Status UpdateType(FeatureNameStatistics::Type type, bool* has_type,
+                  FeatureNameStatistics::Type* current_type) {
+  if (!*has_type) {
+    *has_type = true;
+    *current_type = type;
+  } else if (*current_type != type) {
+    return errors::InvalidArgument(
+        "Found values of types ",
+        FeatureNameStatistics::Type_Name(*current_type), " and ",
+        FeatureNameStatistics::Type_Name(type), ".");
+  }
+  return Status::OK();
+}
+
+// Returns the number of characters of the decimal representation of value.
+template <typename T>
+int64 GetDecimalLength(T value) {
+  int64 length = value < 0 ? 2 : 1;
+  // Dividing a negative value rounds towards zero, so this does not overflow
+  // for the smallest value of T.
+  for (value /= 10; value != 0; value /= 10) {
+    ++length;
+  }
+  return length;
+}
+
+}  // namespace
+
+CommonStatsAccumulator::CommonStatsAccumulator(bool has_weights)
+    : has_weights_(has_weights) {}
+
+void CommonStatsAccumulator::AddMissing(double weight) {
+  ++num_missing_;
+  if (has_weights_) {
+    weighted_num_missing_ += weight;
+  }
+}
+
+Status CommonStatsAccumulator::AddValues(FeatureNameStatistics::Type type,
+                                         int64 num_values, double weight) {
+  TF_RETURN_IF_ERROR(UpdateType(type, &has_type_, &type_));
+  ++num_non_missing_;
+  min_num_values_ = std::min(min_num_values_, num_values);
+  max_num_values_ = std::max(max_num_values_, num_values);
+  total_num_values_ += num_values;
+  if (has_weights_) {
+    weighted_num_non_missing_ += weight;
+    weighted_total_num_values_ += weight * num_values;
+  }
+  num_values_.push_back(num_values);
+  return Status::OK();
+}
+
+NumericStatsAccumulator::NumericStatsAccumulator(bool has_weights)
+    : has_weights_(has_weights) {}
+
+template <typename T>
+Status NumericStatsAccumulator::AddValues(const T* values, int64 num_values,
+                                          double weight) {
+  static_assert(std::is_arithmetic<T>::value, "T must be arithmetic");
+  TF_RETURN_IF_ERROR(UpdateType(std::is_floating_point<T>::value
+                                    ? FeatureNameStatistics::FLOAT
+                                    : FeatureNameStatistics::INT,
+                                &has_type_, &type_));
+  int64 num_nan = 0;
+  if (std::is_floating_point<T>::value) {
+    for (int64 i = 0; i < num_values; ++i) {
+      num_nan += values[i] != values[i];
+    }
+  }
+  // The common case of no NaNs is a single pass over the values, without
+  // branches.
+  double sum = 0.0;
+  double sum_of_squares = 0.0;
+  int64 num_zeros = 0;
+  double min = min_;
+  double max = max_;
+  const size_t first_value = values_.size();
+  if (num_nan == 0) {
+    values_.insert(values_.end(), values, values + num_values);
+    const double* begin = values_.data() + first_value;
+    for (int64 i = 0; i < num_values; ++i) {
+      const double v = begin[i];
+      sum += v;
+      sum_of_squares += v * v;
+      num_zeros += v == 0.0;
+      min = std::min(min, v);
+      max = std::max(max, v);
+    }
+  } else {
+    for (int64 i = 0; i < num_values; ++i) {
+      const double v = values[i];
+      if (v != v) {
+        continue;
+      }
+      values_.push_back(v);
+      sum += v;
+      sum_of_squares += v * v;
+      num_zeros += v == 0.0;
+      min = std::min(min, v);
+      max = std::max(max, v);
+    }
+  }
+  const int64 num_added = num_values - num_nan;
+  sum_ += sum;
+  sum_of_squares_ += sum_of_squares;
+  num_zeros_ += num_zeros;
+  num_nan_ += num_nan;
+  min_ = min;
+  max_ = max;
+  total_num_values_ += num_added;
+  if (has_weights_) {
+    weighted_sum_ += weight * sum;
+    weighted_sum_of_squares_ += weight * sum_of_squares;
+    weighted_total_num_values_ += weight * num_added;
+    weights_.resize(weights_.size() + num_added, weight);
+  }
+  return Status::OK();
+}
+
+template Status NumericStatsAccumulator::AddValues(const int8* values,
+                                                   int64 num_values,
+                                                   double weight);
+template Status NumericStatsAccumulator::AddValues(const int16* values,
+                                                   int64 num_values,
+                                                   double weight);
+template Status NumericStatsAccumulator::AddValues(const int32* values,
+                                                   int64 num_values,
+                                                   double weight);
+template Status NumericStatsAccumulator::AddValues(const int64* values,
+                                                   int64 num_values,
+                                                   double weight);
+template Status NumericStatsAccumulator::AddValues(const float* values,
+                                                   int64 num_values,
+                                                   double weight);
+template Status NumericStatsAccumulator::AddValues(const double* values,
+                                                   int64 num_values,
+                                                   double weight);
+
+void StringStatsAccumulator::AddValues(int64 num_values,
+                                       int64 total_bytes_length) {
+  total_num_values_ += num_values;
+  total_bytes_length_ += total_bytes_length;
+}
+
+template <typename T>
+void StringStatsAccumulator::AddIntValues(const T* values, int64 num_values) {
+  static_assert(std::is_integral<T>::value, "T must be integral");
+  int64 total_bytes_length = 0;
+  for (int64 i = 0; i < num_values; ++i) {
+    total_bytes_length += GetDecimalLength(values[i]);
+  }
+  AddValues(num_values, total_bytes_length);
+}
+
+template void StringStatsAccumulator::AddIntValues(const int8* values,
+                                                   int64 num_values);
+template void StringStatsAccumulator::AddIntValues(const int16* values,
+                                                   int64 num_values);
+template void StringStatsAccumulator::AddIntValues(const int32* values,
+                                                   int64 num_values);
+template void StringStatsAccumulator::AddIntValues(const int64* values,
+                                                   int64 num_values);
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,165 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Native accumulators for the statistics that CommonStatsGenerator,
+// NumericStatsGenerator and StringStatsGenerator update for every value of a
+// feature. Each accumulator takes the values of a feature in the examples of
+// a batch, one example at a time, and is then merged by the Python generator
+// into its partial statistics (see statistics/generators/).
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_BASIC_STATS_ACCUMULATORS_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_BASIC_STATS_ACCUMULATORS_H_
+
+#include <limits>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// Accumulates the statistics of _PartialCommonStats in
+// common_stats_generator.py.
+class CommonStatsAccumulator {
+ public:
+  // If has_weights is false, the weights passed to the methods are ignored.
+  explicit CommonStatsAccumulator(bool has_weights);
+
+  // Adds an example that does not have the feature.
+  void AddMissing(double weight);
+
+  // Adds an example with num_values values of type type. Returns
+  // InvalidArgument if type differs from the type of a previous example.
+  Status AddValues(metadata::v0::FeatureNameStatistics::Type type,
+                   int64 num_values, double weight);
+
+  int64 num_non_missing() const { return num_non_missing_; }
+  int64 num_missing() const { return num_missing_; }
+  // std::numeric_limits<int64>::max() if there are no non-missing examples.
+  int64 min_num_values() const { return min_num_values_; }
+  int64 max_num_values() const { return max_num_values_; }
+  int64 total_num_values() const { return total_num_values_; }
+  double weighted_num_non_missing() const { return weighted_num_non_missing_; }
+  double weighted_num_missing() const { return weighted_num_missing_; }
+  double weighted_total_num_values() const {
+    return weighted_total_num_values_;
+  }
+  // False if there are no non-missing examples.
+  bool has_type() const { return has_type_; }
+  metadata::v0::FeatureNameStatistics::Type type() const { return type_; }
+  // The number of values of each non-missing example, in order.
+  const std::vector<int64>& num_values() const { return num_values_; }
+
+ private:
+  const bool has_weights_;
+  int64 num_non_missing_ = 0;
+  int64 num_missing_ = 0;
+  int64 min_num_values_ = std::numeric_limits<int64>::max();
+  int64 max_num_values_ = 0;
+  int64 total_num_values_ = 0;
+  double weighted_num_non_missing_ = 0.0;
+  double weighted_num_missing_ = 0.0;
+  double weighted_total_num_values_ = 0.0;
+  bool has_type_ = false;
+  metadata::v0::FeatureNameStatistics::Type type_ =
+      metadata::v0::FeatureNameStatistics::INT;
+  std::vector<int64> num_values_;
+};
+
+// Accumulates the statistics of _PartialNumericStats in
+// numeric_stats_generator.py. Sums are kept in double precision.
+class NumericStatsAccumulator {
+ public:
+  // If has_weights is false, the weights passed to AddValues() are ignored.
+  explicit NumericStatsAccumulator(bool has_weights);
+
+  // Adds the values of an example. T must be an integral type (for an INT
+  // feature) or a floating point type (for a FLOAT feature), and the values
+  // of a FLOAT feature that are NaN are only counted. Returns InvalidArgument
+  // if the type of the feature differs from that of a previous example.
+  // This is instantiated for int8, int16, int32, int64, float and double.
+  template <typename T>
+  Status AddValues(const T* values, int64 num_values, double weight);
+
+  double sum() const { return sum_; }
+  double sum_of_squares() const { return sum_of_squares_; }
+  int64 num_zeros() const { return num_zeros_; }
+  int64 num_nan() const { return num_nan_; }
+  // +infinity if there are no values that are not NaN.
+  double min() const { return min_; }
+  // -infinity if there are no values that are not NaN.
+  double max() const { return max_; }
+  // The number of values that are not NaN.
+  int64 total_num_values() const { return total_num_values_; }
+  double weighted_sum() const { return weighted_sum_; }
+  double weighted_sum_of_squares() const { return weighted_sum_of_squares_; }
+  double weighted_total_num_values() const {
+    return weighted_total_num_values_;
+  }
+  // False if no values were added.
+  bool has_type() const { return has_type_; }
+  metadata::v0::FeatureNameStatistics::Type type() const { return type_; }
+  // The values that are not NaN, in order, for the quantiles.
+  const std::vector<double>& values() const { return values_; }
+  // The weight of each of values(), if there are weights.
+  const std::vector<double>& weights() const { return weights_; }
+
+ private:
+  const bool has_weights_;
+  double sum_ = 0.0;
+  double sum_of_squares_ = 0.0;
+  int64 num_zeros_ = 0;
+  int64 num_nan_ = 0;
+  double min_ = std::numeric_limits<double>::infinity();
+  double max_ = -std::numeric_limits<double>::infinity();
+  int64 total_num_values_ = 0;
+  double weighted_sum_ = 0.0;
+  double weighted_sum_of_squares_ = 0.0;
+  double weighted_total_num_values_ = 0.0;
+  bool has_type_ = false;
+  metadata::v0::FeatureNameStatistics::Type type_ =
+      metadata::v0::FeatureNameStatistics::INT;
+  std::vector<double> values_;
+  std::vector<double> weights_;
+};
+
+// Accumulates the statistics of _PartialStringStats in
+// string_stats_generator.py.
+class StringStatsAccumulator {
+ public:
+  StringStatsAccumulator() = default;
+
+  // Adds num_values strings of total_bytes_length characters in all.
+  void AddValues(int64 num_values, int64 total_bytes_length);
+
+  // Adds the values of a categorical INT feature, as strings of their decimal
+  // digits (with a '-' for a negative value). This is instantiated for int8,
+  // int16, int32 and int64.
+  template <typename T>
+  void AddIntValues(const T* values, int64 num_values);
+
+  int64 total_bytes_length() const { return total_bytes_length_; }
+  int64 total_num_values() const { return total_num_values_; }
+
+ private:
+  int64 total_bytes_length_ = 0;
+  int64 total_num_values_ = 0;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_BASIC_STATS_ACCUMULATORS_H_
@@ -0,0 +1,133 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/basic_stats_accumulators.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::tensorflow::metadata::v0::FeatureNameStatistics;
+using ::testing::ElementsAre;
+
+TEST(CommonStatsAccumulatorTest, Basic) {
+  CommonStatsAccumulator accumulator(/*has_weights=*/true);
+  EXPECT_FALSE(accumulator.has_type());
+  EXPECT_EQ(std::numeric_limits<int64>::max(), accumulator.min_num_values());
+  TF_ASSERT_OK(accumulator.AddValues(FeatureNameStatistics::STRING, 3, 2.0));
+  accumulator.AddMissing(0.5);
+  TF_ASSERT_OK(accumulator.AddValues(FeatureNameStatistics::STRING, 0, 1.0));
+  TF_ASSERT_OK(accumulator.AddValues(FeatureNameStatistics::STRING, 2, 1.0));
+  EXPECT_EQ(3, accumulator.num_non_missing());
+  EXPECT_EQ(1, accumulator.num_missing());
+  EXPECT_EQ(0, accumulator.min_num_values());
+  EXPECT_EQ(3, accumulator.max_num_values());
+  EXPECT_EQ(5, accumulator.total_num_values());
+  EXPECT_DOUBLE_EQ(4.0, accumulator.weighted_num_non_missing());
+  EXPECT_DOUBLE_EQ(0.5, accumulator.weighted_num_missing());
+  EXPECT_DOUBLE_EQ(8.0, accumulator.weighted_total_num_values());
+  EXPECT_TRUE(accumulator.has_type());
+  EXPECT_EQ(FeatureNameStatistics::STRING, accumulator.type());
+  EXPECT_THAT(accumulator.num_values(), ElementsAre(3, 0, 2));
+}
+
+TEST(CommonStatsAccumulatorTest, TypeConflict) {
+  CommonStatsAccumulator accumulator(/*has_weights=*/false);
+  TF_ASSERT_OK(accumulator.AddValues(FeatureNameStatistics::INT, 1, 1.0));
+  EXPECT_FALSE(
+      accumulator.AddValues(FeatureNameStatistics::FLOAT, 1, 1.0).ok());
+}
+
+TEST(NumericStatsAccumulatorTest, IntValues) {
+  NumericStatsAccumulator accumulator(/*has_weights=*/false);
+  const std::vector<int64> first = {1, 0, -3};
+  const std::vector<int32> second = {4};
+  TF_ASSERT_OK(accumulator.AddValues(first.data(), first.size(), 1.0));
+  TF_ASSERT_OK(accumulator.AddValues(second.data(), second.size(), 1.0));
+  EXPECT_EQ(FeatureNameStatistics::INT, accumulator.type());
+  EXPECT_DOUBLE_EQ(2.0, accumulator.sum());
+  EXPECT_DOUBLE_EQ(26.0, accumulator.sum_of_squares());
+  EXPECT_EQ(1, accumulator.num_zeros());
+  EXPECT_EQ(0, accumulator.num_nan());
+  EXPECT_DOUBLE_EQ(-3.0, accumulator.min());
+  EXPECT_DOUBLE_EQ(4.0, accumulator.max());
+  EXPECT_EQ(4, accumulator.total_num_values());
+  EXPECT_THAT(accumulator.values(), ElementsAre(1.0, 0.0, -3.0, 4.0));
+  EXPECT_TRUE(accumulator.weights().empty());
+
+  const std::vector<float> floats = {1.0};
+  EXPECT_FALSE(accumulator.AddValues(floats.data(), floats.size(), 1.0).ok());
+}
+
+TEST(NumericStatsAccumulatorTest, WeightedFloatValuesWithNaN) {
+  NumericStatsAccumulator accumulator(/*has_weights=*/true);
+  const std::vector<float> first = {1.5, std::nanf(""), 0.0};
+  const std::vector<double> second = {-2.0};
+  const std::vector<float> all_nan = {std::nanf("")};
+  TF_ASSERT_OK(accumulator.AddValues(first.data(), first.size(), 2.0));
+  TF_ASSERT_OK(accumulator.AddValues(second.data(), second.size(), 3.0));
+  TF_ASSERT_OK(accumulator.AddValues(all_nan.data(), all_nan.size(), 4.0));
+  EXPECT_EQ(FeatureNameStatistics::FLOAT, accumulator.type());
+  EXPECT_DOUBLE_EQ(-0.5, accumulator.sum());
+  EXPECT_DOUBLE_EQ(6.25, accumulator.sum_of_squares());
+  EXPECT_EQ(1, accumulator.num_zeros());
+  EXPECT_EQ(2, accumulator.num_nan());
+  EXPECT_DOUBLE_EQ(-2.0, accumulator.min());
+  EXPECT_DOUBLE_EQ(1.5, accumulator.max());
+  EXPECT_EQ(3, accumulator.total_num_values());
+  EXPECT_DOUBLE_EQ(-3.0, accumulator.weighted_sum());
+  EXPECT_DOUBLE_EQ(16.5, accumulator.weighted_sum_of_squares());
+  EXPECT_DOUBLE_EQ(7.0, accumulator.weighted_total_num_values());
+  EXPECT_THAT(accumulator.values(), ElementsAre(1.5, 0.0, -2.0));
+  EXPECT_THAT(accumulator.weights(), ElementsAre(2.0, 2.0, 3.0));
+}
+
+TEST(NumericStatsAccumulatorTest, OnlyNaN) {
+  NumericStatsAccumulator accumulator(/*has_weights=*/false);
+  const std::vector<double> values = {std::nan("")};
+  TF_ASSERT_OK(accumulator.AddValues(values.data(), values.size(), 1.0));
+  EXPECT_TRUE(accumulator.has_type());
+  EXPECT_EQ(1, accumulator.num_nan());
+  EXPECT_EQ(0, accumulator.total_num_values());
+  EXPECT_TRUE(std::isinf(accumulator.min()));
+  EXPECT_TRUE(accumulator.values().empty());
+}
+
+TEST(StringStatsAccumulatorTest, Basic) {
+  StringStatsAccumulator accumulator;
+  accumulator.AddValues(2, 7);
+  const std::vector<int64> values = {0, 9, -10, 123,
+                                     std::numeric_limits<int64>::min()};
+  accumulator.AddIntValues(values.data(), values.size());
+  const std::vector<int8> small_values = {-128};
+  accumulator.AddIntValues(small_values.data(), small_values.size());
+  EXPECT_EQ(8, accumulator.total_num_values());
+  // "0", "9", "-10", "123", "-9223372036854775808" and "-128".
+  EXPECT_EQ(7 + 1 + 1 + 3 + 3 + 20 + 4, accumulator.total_bytes_length());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/bool_domain_util.h"
 
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -55,14 +56,16 @@ std::set<string> GetFalseValues() {
 BoolDomain BoolDomainFromStringField(const FeatureStatsView& stats) {
   BoolDomain result;
   const std::set<string> true_values = GetTrueValues();
-  for (const string& label : stats.GetStringValues()) {
+  for (const auto& pair : stats.GetStringValuesWithCounts()) {
+    const string& label = pair.first;
     if (ContainsKey(true_values, label)) {
       *result.mutable_true_value() = label;
       break;
     }
   }
   const std::set<string> false_values = GetFalseValues();
-  for (const string& label : stats.GetStringValues()) {
+  for (const auto& pair : stats.GetStringValuesWithCounts()) {
+    const string& label = pair.first;
     if (ContainsKey(false_values, label)) {
       *result.mutable_false_value() = label;
       break;
@@ -124,7 +127,8 @@ bool IsBoolDomainCandidate(const FeatureStatsView& feature_stats) {
     return false;
   }
 
-  const std::vector<string> tokens = feature_stats.GetStringValues();
+  const std::map<string, double>& tokens =
+      feature_stats.GetStringValuesWithCounts();
   if (tokens.size() > 2 || tokens.empty()) {
     return false;
   }
@@ -134,7 +138,8 @@ bool IsBoolDomainCandidate(const FeatureStatsView& feature_stats) {
   std::set<string> valid_false = GetFalseValues();
   bool true_seen = false;
   bool false_seen = false;
-  for (const string& token : tokens) {
+  for (const auto& pair : tokens) {
+    const string& token = pair.first;
     if (!true_seen && ContainsKey(valid_true, token)) {
       true_seen = true;
       continue;
@@ -212,8 +217,8 @@ std::vector<Description> UpdateBoolDomain(const FeatureStatsView& feature_stats,
       const BoolDomain& bool_domain = feature->bool_domain();
       const std::set<string> valid_strings =
           BoolDomainValidStrings(bool_domain);
-      const std::vector<string> string_values = feature_stats.GetStringValues();
-      for (const string& str : string_values) {
+      for (const auto& pair : feature_stats.GetStringValuesWithCounts()) {
+        const string& str = pair.first;
         if (!ContainsKey(valid_strings, str)) {
           // We might be able to replace this with an enum, but since it is
           // in all likelihood an error, let's just wipe the bool_domain.
@@ -0,0 +1,258 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/compiled_schema_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "tensorflow_data_validation/anomalies/schema.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using metadata::v0::StringDomain;
+
+constexpr char kMagic[] = "TFDVSCHM";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+
+// The sections of an image, in order.
+enum Section {
+  kSchemaSection,
+  kStringDomainNamesSection,
+  kStringDomainValuesSection,
+  kFeaturePathsSection,
+  kEnvironmentsSection,
+  kRequiredFeaturesSection,
+  kNumSections
+};
+
+// The magic, the version, the number of sections, and the offset and the
+// size of each section.
+constexpr size_t kHeaderSize = kMagicSize + 2 * 4 + kNumSections * 2 * 4;
+
+// Returns the entry of the required features section for required, where
+// paths is the sorted table of all the serialized paths.
+string GetRequiredFeaturesEntry(const std::vector<Path>& required,
+                                const std::vector<string>& paths) {
+  string entry;
+  for (const Path& path : required) {
+    const auto iter =
+        std::lower_bound(paths.begin(), paths.end(), path.Serialize());
+    core::PutFixed32(&entry, iter - paths.begin());
+  }
+  return entry;
+}
+
+Status CorruptedImageError() {
+  return errors::InvalidArgument("Corrupted compiled schema image.");
+}
+
+}  // namespace
+
+Status CompiledSchemaImage::Init(absl::string_view image) {
+  if (image.size() < kMagicSize + 4 ||
+      std::memcmp(image.data(), kMagic, kMagicSize) != 0) {
+    return errors::InvalidArgument("Not a compiled schema image.");
+  }
+  const uint32 version = core::DecodeFixed32(image.data() + kMagicSize);
+  if (version != kCompiledSchemaImageVersion) {
+    return errors::InvalidArgument(
+        "Unsupported version of compiled schema image: ", version);
+  }
+  if (image.size() < kHeaderSize ||
+      core::DecodeFixed32(image.data() + kMagicSize + 4) != kNumSections) {
+    return CorruptedImageError();
+  }
+  absl::string_view sections[kNumSections];
+  for (int i = 0; i < kNumSections; ++i) {
+    const char* const entry = image.data() + kMagicSize + 2 * 4 + i * 2 * 4;
+    const uint32 offset = core::DecodeFixed32(entry);
+    const uint32 size = core::DecodeFixed32(entry + 4);
+    if (offset > image.size() || size > image.size() - offset) {
+      return CorruptedImageError();
+    }
+    sections[i] = image.substr(offset, size);
+  }
+  schema_ = sections[kSchemaSection];
+  if (!string_domain_names_.Init(sections[kStringDomainNamesSection]) ||
+      !string_domain_values_.Init(sections[kStringDomainValuesSection]) ||
+      !feature_paths_.Init(sections[kFeaturePathsSection]) ||
+      !environments_.Init(sections[kEnvironmentsSection]) ||
+      !required_features_.Init(sections[kRequiredFeaturesSection]) ||
+      string_domain_values_.size() != string_domain_names_.size() ||
+      required_features_.size() != environments_.size() + 1) {
+    return CorruptedImageError();
+  }
+  return Status::OK();
+}
+
+Status CompiledSchemaImage::InitFromFile(const string& filename) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(
+      Env::Default()->NewReadOnlyMemoryRegionFromFile(filename, &region));
+  TF_RETURN_IF_ERROR(
+      Init(absl::string_view(static_cast<const char*>(region->data()),
+                             region->length())));
+  region_ = std::move(region);
+  return Status::OK();
+}
+
+Status CompiledSchemaImage::GetStringDomainTables(
+    absl::flat_hash_map<string, StringTable>* tables) const {
+  tables->clear();
+  tables->reserve(string_domain_names_.size());
+  for (uint32 i = 0; i < string_domain_names_.size(); ++i) {
+    StringTable values;
+    if (!values.Init(string_domain_values_.Get(i))) {
+      return CorruptedImageError();
+    }
+    tables->emplace(string(string_domain_names_.Get(i)), values);
+  }
+  return Status::OK();
+}
+
+Status CompiledSchemaImage::GetRequiredFeatures(
+    const absl::optional<string>& environment,
+    std::vector<Path>* required) const {
+  uint32 entry_index = 0;
+  if (environment) {
+    const int64 index = environments_.Find(*environment);
+    if (index < 0) {
+      return errors::InvalidArgument("Environment ", *environment,
+                                     " is not a default environment.");
+    }
+    entry_index = index + 1;
+  }
+  const absl::string_view entry = required_features_.Get(entry_index);
+  if (entry.size() % 4 != 0) {
+    return CorruptedImageError();
+  }
+  required->clear();
+  required->reserve(entry.size() / 4);
+  for (size_t i = 0; i < entry.size(); i += 4) {
+    const uint32 path_index = core::DecodeFixed32(entry.data() + i);
+    if (path_index >= feature_paths_.size()) {
+      return CorruptedImageError();
+    }
+    Path path;
+    TF_RETURN_IF_ERROR(
+        Path::Deserialize(feature_paths_.Get(path_index), &path));
+    required->push_back(path);
+  }
+  return Status::OK();
+}
+
+Status BuildCompiledSchemaImage(const metadata::v0::Schema& schema_proto,
+                                string* image) {
+  Schema schema;
+  TF_RETURN_IF_ERROR(schema.Init(schema_proto));
+
+  std::vector<string> sections(kNumSections);
+  if (!schema_proto.SerializeToString(&sections[kSchemaSection])) {
+    return errors::Internal("Could not serialize Schema proto to string.");
+  }
+
+  // As in Schema, the first StringDomain with a name wins.
+  std::map<string, const StringDomain*> string_domains;
+  for (const StringDomain& string_domain : schema_proto.string_domain()) {
+    string_domains.emplace(string_domain.name(), &string_domain);
+  }
+  std::vector<string> string_domain_names;
+  std::vector<string> string_domain_values;
+  for (const auto& name_and_string_domain : string_domains) {
+    string_domain_names.push_back(name_and_string_domain.first);
+    const StringDomain& string_domain = *name_and_string_domain.second;
+    const std::set<string> values(string_domain.value().begin(),
+                                  string_domain.value().end());
+    string_domain_values.emplace_back();
+    AppendStringTable(std::vector<string>(values.begin(), values.end()),
+                      &string_domain_values.back());
+  }
+  AppendStringTable(string_domain_names, &sections[kStringDomainNamesSection]);
+  AppendStringTable(string_domain_values,
+                    &sections[kStringDomainValuesSection]);
+
+  const std::set<string> environments(
+      schema_proto.default_environment().begin(),
+      schema_proto.default_environment().end());
+  AppendStringTable(
+      std::vector<string>(environments.begin(), environments.end()),
+      &sections[kEnvironmentsSection]);
+  // The required features of no environment, then of each environment.
+  std::vector<std::vector<Path>> required;
+  required.push_back(schema.GetRequiredFeatures(absl::nullopt));
+  for (const string& environment : environments) {
+    required.push_back(schema.GetRequiredFeatures(environment));
+  }
+
+  std::vector<string> paths;
+  for (const std::vector<Path>& required_paths : required) {
+    for (const Path& path : required_paths) {
+      paths.push_back(path.Serialize());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+  AppendStringTable(paths, &sections[kFeaturePathsSection]);
+
+  std::vector<string> required_features;
+  for (const std::vector<Path>& required_paths : required) {
+    required_features.push_back(
+        GetRequiredFeaturesEntry(required_paths, paths));
+  }
+  AppendStringTable(required_features, &sections[kRequiredFeaturesSection]);
+
+  uint64 image_size = kHeaderSize;
+  for (const string& section : sections) {
+    image_size += section.size();
+  }
+  if (image_size > kuint32max) {
+    return errors::InvalidArgument(
+        "Schema is too large for a compiled schema image.");
+  }
+  image->clear();
+  image->reserve(image_size);
+  image->append(kMagic, kMagicSize);
+  core::PutFixed32(image, kCompiledSchemaImageVersion);
+  core::PutFixed32(image, kNumSections);
+  uint32 offset = kHeaderSize;
+  for (const string& section : sections) {
+    core::PutFixed32(image, offset);
+    core::PutFixed32(image, section.size());
+    offset += section.size();
+  }
+  for (const string& section : sections) {
+    image->append(section);
+  }
+  return Status::OK();
+}
+
+Status WriteCompiledSchemaImage(const metadata::v0::Schema& schema,
+                                const string& filename) {
+  string image;
+  TF_RETURN_IF_ERROR(BuildCompiledSchemaImage(schema, &image));
+  return WriteStringToFile(Env::Default(), filename, image);
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
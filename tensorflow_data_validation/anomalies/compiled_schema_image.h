@@ -0,0 +1,127 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A flat, versioned binary format for a compiled schema (a schema image),
+// which is read in place, e.g., from a memory-mapped file, without being
+// parsed. Besides the serialized Schema proto, an image holds what would
+// otherwise be computed from the schema by each process that validates
+// against it: the values of each StringDomain, which a CompiledSchemaValidator
+// looks up in the image rather than collecting them into sets (or filters),
+// and the required features of no environment and of each default
+// environment (see Schema::Precompute()). The Schema proto itself is still
+// parsed and indexed, as validation updates overlays of it.
+//
+// All the integers of an image are little-endian uint32s. An image starts
+// with the magic "TFDVSCHM", the version of the format, the number of
+// sections, and the offset (from the start of the image) and the size of
+// each section. Most sections are string tables (see string_table.h). The
+// sections are, in order:
+//   - the serialized Schema proto;
+//   - a sorted string table of the names of the StringDomains, where the
+//     first StringDomain with a name wins, as in Schema;
+//   - a string table whose i-th entry is a sorted string table of the
+//     distinct values of the i-th StringDomain;
+//   - a sorted string table of the serialized paths (see Path::Serialize())
+//     of the features that are required in some environment (or in none);
+//   - a sorted string table of the default environments;
+//   - a string table whose first entry lists the required features of no
+//     environment, and whose (i + 1)-th entry lists those of the i-th
+//     default environment, each as the indices of their paths in the table
+//     of paths, in the order in which the features appear in the schema.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_COMPILED_SCHEMA_IMAGE_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_COMPILED_SCHEMA_IMAGE_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow_data_validation/anomalies/path.h"
+#include "tensorflow_data_validation/anomalies/string_table.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/schema.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// The version of the format written by BuildCompiledSchemaImage(). Images of
+// other versions are rejected by CompiledSchemaImage::Init().
+constexpr uint32 kCompiledSchemaImageVersion = 1;
+
+// A read-only view of a schema image. Init() takes time independent of the
+// size of the schema, and so do the lookups, up to a logarithmic factor.
+// This class is thread-compatible, and its const methods can be called
+// concurrently.
+class CompiledSchemaImage {
+ public:
+  CompiledSchemaImage() = default;
+
+  // Disallow copy and move.
+  CompiledSchemaImage(const CompiledSchemaImage&) = delete;
+  CompiledSchemaImage& operator=(const CompiledSchemaImage&) = delete;
+
+  // Views image, which must outlive this object. Returns InvalidArgument if
+  // it is not an image of the current version.
+  Status Init(absl::string_view image);
+
+  // Maps the file named filename into memory (see
+  // Env::NewReadOnlyMemoryRegionFromFile()) and views it.
+  Status InitFromFile(const string& filename);
+
+  // The serialized Schema proto of the image.
+  absl::string_view schema_proto_string() const { return schema_; }
+
+  // Sets *tables to the sorted table of the distinct values of each
+  // StringDomain, keyed by name. The tables are views of the image. Returns
+  // InvalidArgument if the image is corrupted.
+  Status GetStringDomainTables(
+      absl::flat_hash_map<string, StringTable>* tables) const;
+
+  // The sorted table of the default environments of the schema.
+  const StringTable& environments() const { return environments_; }
+
+  // Sets *required to the features that are required to be present in
+  // environment (or in no environment), as Schema::GetRequiredFeatures()
+  // does. Returns InvalidArgument if environment is not a default
+  // environment.
+  Status GetRequiredFeatures(const absl::optional<string>& environment,
+                             std::vector<Path>* required) const;
+
+ private:
+  // The mapped file of InitFromFile(), if any.
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  absl::string_view schema_;
+  StringTable string_domain_names_;
+  StringTable string_domain_values_;
+  StringTable feature_paths_;
+  StringTable environments_;
+  StringTable required_features_;
+};
+
+// Builds the image of schema, which is valid (see Schema::Init()).
+Status BuildCompiledSchemaImage(const metadata::v0::Schema& schema,
+                                string* image);
+
+// Same as above, but writes the image to the file named filename.
+Status WriteCompiledSchemaImage(const metadata::v0::Schema& schema,
+                                const string& filename);
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_COMPILED_SCHEMA_IMAGE_H_
@@ -0,0 +1,154 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/compiled_schema_image.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow_data_validation/anomalies/path.h"
+#include "tensorflow_data_validation/anomalies/schema.h"
+#include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/schema.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using testing::EqualsProto;
+using testing::ParseTextProtoOrDie;
+
+metadata::v0::Schema GetTestSchema() {
+  return ParseTextProtoOrDie<metadata::v0::Schema>(R"(
+    default_environment: "TRAINING"
+    default_environment: "SERVING"
+    string_domain { name: "MyEnum" value: "b" value: "a" value: "b" }
+    string_domain { name: "MyEnum" value: "c" }
+    string_domain { name: "Other" }
+    feature {
+      name: "label"
+      not_in_environment: "SERVING"
+      presence { min_fraction: 1 }
+      type: BYTES
+      domain: "MyEnum"
+    }
+    feature {
+      name: "struct"
+      presence { min_count: 1 }
+      type: STRUCT
+      struct_domain {
+        feature {
+          name: "child"
+          presence { min_fraction: 1 }
+          type: INT
+        }
+      }
+    }
+    feature { name: "optional" type: FLOAT })");
+}
+
+TEST(CompiledSchemaImageTest, ReadsWhatIsBuilt) {
+  const metadata::v0::Schema schema_proto = GetTestSchema();
+  string buffer;
+  TF_ASSERT_OK(BuildCompiledSchemaImage(schema_proto, &buffer));
+  CompiledSchemaImage image;
+  TF_ASSERT_OK(image.Init(buffer));
+
+  metadata::v0::Schema parsed;
+  ASSERT_TRUE(parsed.ParseFromArray(image.schema_proto_string().data(),
+                                    image.schema_proto_string().size()));
+  EXPECT_THAT(parsed, EqualsProto(schema_proto));
+
+  // The first StringDomain named MyEnum wins.
+  absl::flat_hash_map<string, StringTable> tables;
+  TF_ASSERT_OK(image.GetStringDomainTables(&tables));
+  ASSERT_EQ(2, tables.size());
+  const StringTable& values = tables.at("MyEnum");
+  ASSERT_EQ(2, values.size());
+  EXPECT_EQ("a", values.Get(0));
+  EXPECT_EQ("b", values.Get(1));
+  EXPECT_TRUE(values.Contains("b"));
+  EXPECT_FALSE(values.Contains("c"));
+  EXPECT_EQ(0, tables.at("Other").size());
+
+  ASSERT_EQ(2, image.environments().size());
+  EXPECT_EQ("SERVING", image.environments().Get(0));
+  EXPECT_EQ("TRAINING", image.environments().Get(1));
+  Schema schema;
+  TF_ASSERT_OK(schema.Init(schema_proto));
+  for (const absl::optional<string>& environment :
+       {absl::optional<string>(), absl::optional<string>("TRAINING"),
+        absl::optional<string>("SERVING")}) {
+    std::vector<Path> required;
+    TF_ASSERT_OK(image.GetRequiredFeatures(environment, &required));
+    EXPECT_EQ(schema.GetRequiredFeatures(environment), required);
+  }
+  std::vector<Path> required;
+  TF_ASSERT_OK(image.GetRequiredFeatures(string("SERVING"), &required));
+  EXPECT_EQ(std::vector<Path>({Path({"struct"}), Path({"struct", "child"})}),
+            required);
+  EXPECT_FALSE(image.GetRequiredFeatures(string("OTHER"), &required).ok());
+}
+
+TEST(CompiledSchemaImageTest, ReadsFromFile) {
+  const string filename = ::testing::TempDir() + "/compiled_schema_image";
+  TF_ASSERT_OK(WriteCompiledSchemaImage(GetTestSchema(), filename));
+  CompiledSchemaImage image;
+  TF_ASSERT_OK(image.InitFromFile(filename));
+  absl::flat_hash_map<string, StringTable> tables;
+  TF_ASSERT_OK(image.GetStringDomainTables(&tables));
+  EXPECT_TRUE(tables.at("MyEnum").Contains("a"));
+  std::vector<Path> required;
+  TF_ASSERT_OK(image.GetRequiredFeatures(absl::nullopt, &required));
+  EXPECT_EQ(3, required.size());
+}
+
+TEST(CompiledSchemaImageTest, EmptySchema) {
+  string buffer;
+  TF_ASSERT_OK(BuildCompiledSchemaImage(metadata::v0::Schema(), &buffer));
+  CompiledSchemaImage image;
+  TF_ASSERT_OK(image.Init(buffer));
+  EXPECT_TRUE(image.schema_proto_string().empty());
+  absl::flat_hash_map<string, StringTable> tables;
+  TF_ASSERT_OK(image.GetStringDomainTables(&tables));
+  EXPECT_TRUE(tables.empty());
+  std::vector<Path> required;
+  TF_ASSERT_OK(image.GetRequiredFeatures(absl::nullopt, &required));
+  EXPECT_TRUE(required.empty());
+}
+
+TEST(CompiledSchemaImageTest, RejectsInvalidImages) {
+  string buffer;
+  TF_ASSERT_OK(BuildCompiledSchemaImage(GetTestSchema(), &buffer));
+  CompiledSchemaImage image;
+  EXPECT_FALSE(image.Init("").ok());
+  EXPECT_FALSE(image.Init("not a compiled schema image").ok());
+  // A truncated image.
+  EXPECT_FALSE(image.Init(absl::string_view(buffer).substr(
+                              0, buffer.size() - 1))
+                   .ok());
+  // Another version of the format.
+  string other_version = buffer;
+  other_version[8] = static_cast<char>(kCompiledSchemaImageVersion + 1);
+  EXPECT_FALSE(image.Init(other_version).ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
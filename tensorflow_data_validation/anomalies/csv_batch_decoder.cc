@@ -0,0 +1,491 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/csv_batch_decoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/byte_order.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using metadata::v0::FeatureNameStatistics;
+using Kind = FeatureColumn::Kind;
+
+constexpr char kQuote = '"';
+
+// The default field size limit of the csv module.
+constexpr size_t kFieldSizeLimit = 128 * 1024;
+
+constexpr uint64 kOnes = 0x0101010101010101ULL;
+constexpr uint64 kLow7Bits = 0x7f7f7f7f7f7f7f7fULL;
+
+// Returns a word in which the high bit of each byte is set if that byte of
+// word is zero, and every other bit is clear. No carry crosses bytes, so
+// unlike the usual "has a zero byte" test, a zero byte does not mark the
+// bytes after it.
+uint64 ZeroBytes(uint64 word) {
+  return ~(((word & kLow7Bits) + kLow7Bits) | word | kLow7Bits);
+}
+
+// Returns the index in memory of the first byte marked in a nonzero result
+// of ZeroBytes().
+int FirstMarkedByte(uint64 marks) {
+  return (port::kLittleEndian ? __builtin_ctzll(marks)
+                              : __builtin_clzll(marks)) /
+         8;
+}
+
+// Finds the first of a few bytes in a string, comparing 8 bytes at a time
+// to each of them.
+class ByteFinder {
+ public:
+  explicit ByteFinder(std::initializer_list<char> targets) {
+    for (const char target : targets) {
+      broadcast_targets_.push_back(kOnes * static_cast<uint8>(target));
+      is_target_[static_cast<uint8>(target)] = true;
+    }
+  }
+
+  // Returns the position of the first target at or after pos in data, or
+  // data.size() if there is none.
+  size_t Find(absl::string_view data, size_t pos) const {
+    for (; pos + sizeof(uint64) <= data.size(); pos += sizeof(uint64)) {
+      uint64 word;
+      std::memcpy(&word, data.data() + pos, sizeof(word));
+      uint64 marks = 0;
+      for (const uint64 broadcast_target : broadcast_targets_) {
+        marks |= ZeroBytes(word ^ broadcast_target);
+      }
+      if (marks != 0) {
+        return pos + FirstMarkedByte(marks);
+      }
+    }
+    for (; pos < data.size(); ++pos) {
+      if (is_target_[static_cast<uint8>(data[pos])]) {
+        return pos;
+      }
+    }
+    return data.size();
+  }
+
+ private:
+  // Each target, repeated in the 8 bytes of a word.
+  std::vector<uint64> broadcast_targets_;
+  bool is_target_[256] = {};
+};
+
+bool IsLineBreak(char c) { return c == '\r' || c == '\n'; }
+
+// Splits lines as the csv module with the default dialect: cells are
+// separated by the delimiter, a cell that starts with a quote ends at the
+// next quote that is not doubled (and text after that quote is appended to
+// the cell), and a line break outside quotes ends the line.
+class CsvLineSplitter {
+ public:
+  explicit CsvLineSplitter(char delimiter)
+      : delimiter_(delimiter),
+        unquoted_end_({delimiter, '\r', '\n', '\0'}),
+        quoted_end_({kQuote, '\0'}) {}
+
+  // See SplitCsvLine().
+  bool Split(absl::string_view line, std::vector<absl::string_view>* cells,
+             std::deque<string>* unescaped_cells) const {
+    cells->clear();
+    if (delimiter_ == kQuote || delimiter_ == '\0' ||
+        IsLineBreak(delimiter_)) {
+      return false;
+    }
+    if (line.empty()) {
+      return true;
+    }
+    size_t pos = 0;
+    while (true) {
+      // pos is the start of a cell.
+      if (pos == line.size()) {
+        cells->emplace_back();
+        return true;
+      }
+      if (IsLineBreak(line[pos])) {
+        // A line that starts with a line break is blank.
+        if (pos != 0) {
+          cells->emplace_back();
+        }
+        return OnlyLineBreaksFrom(line, pos);
+      }
+      absl::string_view cell;
+      size_t end;
+      if (line[pos] == kQuote) {
+        if (!SplitQuotedCell(line, pos, &cell, &end, unescaped_cells)) {
+          return false;
+        }
+      } else {
+        end = unquoted_end_.Find(line, pos);
+        cell = line.substr(pos, end - pos);
+      }
+      if (cell.size() > kFieldSizeLimit) {
+        return false;
+      }
+      cells->push_back(cell);
+      if (end == line.size()) {
+        return true;
+      }
+      if (line[end] == '\0') {
+        return false;
+      }
+      if (line[end] != delimiter_) {
+        return OnlyLineBreaksFrom(line, end);
+      }
+      pos = end + 1;
+    }
+  }
+
+ private:
+  // The csv module rejects characters after a line break.
+  static bool OnlyLineBreaksFrom(absl::string_view line, size_t pos) {
+    for (; pos < line.size(); ++pos) {
+      if (!IsLineBreak(line[pos])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Splits the cell that starts with the quote at line[pos], and sets *end
+  // to the position after it. Returns false if the quotes do not end.
+  bool SplitQuotedCell(absl::string_view line, size_t pos,
+                       absl::string_view* cell, size_t* end,
+                       std::deque<string>* unescaped_cells) const {
+    size_t begin = pos + 1;
+    size_t quote = quoted_end_.Find(line, begin);
+    if (quote == line.size() || line[quote] == '\0') {
+      return false;
+    }
+    size_t after = quote + 1;
+    if (after == line.size() || line[after] == delimiter_ ||
+        IsLineBreak(line[after])) {
+      // The usual case: there is nothing to unescape.
+      *cell = line.substr(begin, quote - begin);
+      *end = after;
+      return true;
+    }
+    unescaped_cells->emplace_back(line.substr(begin, quote - begin));
+    string* unescaped = &unescaped_cells->back();
+    // A doubled quote is a quote in the cell.
+    while (after < line.size() && line[after] == kQuote) {
+      unescaped->push_back(kQuote);
+      begin = after + 1;
+      quote = quoted_end_.Find(line, begin);
+      if (quote == line.size() || line[quote] == '\0') {
+        return false;
+      }
+      unescaped->append(line.data() + begin, quote - begin);
+      after = quote + 1;
+    }
+    // Text after the closing quote is part of the cell, including quotes.
+    *end = unquoted_end_.Find(line, after);
+    unescaped->append(line.data() + after, *end - after);
+    *cell = *unescaped;
+    return true;
+  }
+
+  const char delimiter_;
+  const ByteFinder unquoted_end_;
+  const ByteFinder quoted_end_;
+};
+
+// The whitespace that int() and float() ignore around a number.
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsSign(char c) { return c == '-' || c == '+'; }
+
+absl::string_view StripSpaces(absl::string_view str) {
+  while (!str.empty() && IsSpace(str.front())) {
+    str.remove_prefix(1);
+  }
+  while (!str.empty() && IsSpace(str.back())) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+enum class IntParseResult { kInt64, kOutOfRange, kNotInt };
+
+// Parses cell as int() does: an optional sign and decimal digits, between
+// whitespace. Sets *value if the result is kInt64.
+IntParseResult ParseInt(absl::string_view cell, int64* value) {
+  cell = StripSpaces(cell);
+  const bool negative = !cell.empty() && cell[0] == '-';
+  if (!cell.empty() && IsSign(cell[0])) {
+    cell.remove_prefix(1);
+  }
+  if (cell.empty()) {
+    return IntParseResult::kNotInt;
+  }
+  const uint64 limit = negative ? uint64{1} << 63 : kint64max;
+  uint64 magnitude = 0;
+  bool out_of_range = false;
+  for (const char c : cell) {
+    if (!IsDigit(c)) {
+      return IntParseResult::kNotInt;
+    }
+    const uint64 digit = c - '0';
+    if (out_of_range || magnitude > (limit - digit) / 10) {
+      out_of_range = true;
+      continue;
+    }
+    magnitude = magnitude * 10 + digit;
+  }
+  if (out_of_range) {
+    return IntParseResult::kOutOfRange;
+  }
+  *value = negative ? static_cast<int64>(0 - magnitude)
+                    : static_cast<int64>(magnitude);
+  return IntParseResult::kInt64;
+}
+
+// Parses cell as float() does: a decimal number with an optional exponent,
+// "inf", "infinity" or "nan" (in any case), with an optional sign, between
+// whitespace. Returns false if cell is not a float.
+bool ParseFloat(absl::string_view cell, double* value) {
+  cell = StripSpaces(cell);
+  absl::string_view unsigned_cell = cell;
+  const bool negative = !cell.empty() && cell[0] == '-';
+  if (!cell.empty() && IsSign(cell[0])) {
+    unsigned_cell.remove_prefix(1);
+  }
+  if (absl::EqualsIgnoreCase(unsigned_cell, "inf") ||
+      absl::EqualsIgnoreCase(unsigned_cell, "infinity")) {
+    *value = negative ? -std::numeric_limits<double>::infinity()
+                      : std::numeric_limits<double>::infinity();
+    return true;
+  }
+  if (absl::EqualsIgnoreCase(unsigned_cell, "nan")) {
+    *value = negative ? -std::numeric_limits<double>::quiet_NaN()
+                      : std::numeric_limits<double>::quiet_NaN();
+    return true;
+  }
+  // absl::SimpleAtod() also accepts numbers that float() does not (such as
+  // hexadecimal ones), so the syntax is checked first.
+  size_t i = 0;
+  int num_digits = 0;
+  for (; i < unsigned_cell.size() && IsDigit(unsigned_cell[i]); ++i) {
+    ++num_digits;
+  }
+  if (i < unsigned_cell.size() && unsigned_cell[i] == '.') {
+    for (++i; i < unsigned_cell.size() && IsDigit(unsigned_cell[i]); ++i) {
+      ++num_digits;
+    }
+  }
+  if (num_digits == 0) {
+    return false;
+  }
+  if (i < unsigned_cell.size() &&
+      (unsigned_cell[i] == 'e' || unsigned_cell[i] == 'E')) {
+    ++i;
+    if (i < unsigned_cell.size() && IsSign(unsigned_cell[i])) {
+      ++i;
+    }
+    int num_exponent_digits = 0;
+    for (; i < unsigned_cell.size() && IsDigit(unsigned_cell[i]); ++i) {
+      ++num_exponent_digits;
+    }
+    if (num_exponent_digits == 0) {
+      return false;
+    }
+  }
+  return i == unsigned_cell.size() && absl::SimpleAtod(cell, value);
+}
+
+// Returns the type that _infer_value_type() in coders/csv_decoder.py infers
+// for cell.
+CsvColumnType InferCellType(absl::string_view cell) {
+  // An empty cell could be a FLOAT or a STRING, and is taken to be a FLOAT.
+  if (cell.empty()) {
+    return FeatureNameStatistics::FLOAT;
+  }
+  int64 int_value;
+  switch (ParseInt(cell, &int_value)) {
+    case IntParseResult::kInt64:
+      return FeatureNameStatistics::INT;
+    case IntParseResult::kOutOfRange:
+      // Integers that do not fit in an int64 are strings.
+      return FeatureNameStatistics::STRING;
+    case IntParseResult::kNotInt:
+      break;
+  }
+  double float_value;
+  return ParseFloat(cell, &float_value) ? FeatureNameStatistics::FLOAT
+                                        : FeatureNameStatistics::STRING;
+}
+
+// Appends the value of a nonempty cell of a column of the given type.
+Status AddCell(absl::string_view cell,
+               const absl::optional<CsvColumnType>& type,
+               FeatureColumn* column) {
+  if (!type) {
+    return errors::InvalidArgument("Cannot determine the type of a column.");
+  }
+  switch (*type) {
+    case FeatureNameStatistics::INT: {
+      int64 value;
+      if (ParseInt(cell, &value) != IntParseResult::kInt64) {
+        return errors::InvalidArgument("Cannot parse ", cell, " as an int64.");
+      }
+      column->kind = Kind::kInt64;
+      column->int64_values.push_back(value);
+      return Status::OK();
+    }
+    case FeatureNameStatistics::FLOAT: {
+      double value;
+      if (!ParseFloat(cell, &value)) {
+        return errors::InvalidArgument("Cannot parse ", cell, " as a float.");
+      }
+      column->kind = Kind::kDouble;
+      column->double_values.push_back(value);
+      return Status::OK();
+    }
+    case FeatureNameStatistics::STRING:
+      column->kind = Kind::kBytes;
+      column->bytes_values.push_back(cell);
+      return Status::OK();
+    default:
+      return errors::InvalidArgument("Unsupported column type: ",
+                                     FeatureNameStatistics::Type_Name(*type));
+  }
+}
+
+}  // namespace
+
+bool SplitCsvLine(absl::string_view line, char delimiter,
+                  std::vector<absl::string_view>* cells,
+                  std::deque<string>* unescaped_cells) {
+  return CsvLineSplitter(delimiter).Split(line, cells, unescaped_cells);
+}
+
+Status InferCsvColumnTypes(const std::vector<absl::string_view>& lines,
+                           char delimiter, bool skip_blank_lines,
+                           int num_columns,
+                           std::vector<CsvColumnType>* column_types) {
+  column_types->clear();
+  const CsvLineSplitter splitter(delimiter);
+  std::vector<absl::string_view> line_cells;
+  std::deque<string> unescaped_cells;
+  // The cells of the lines that are not skipped, line after line.
+  std::vector<absl::string_view> cells;
+  int64 num_rows = 0;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (!splitter.Split(lines[i], &line_cells, &unescaped_cells)) {
+      return errors::InvalidArgument("Cannot split CSV line ", i, ".");
+    }
+    if (line_cells.empty()) {
+      if (skip_blank_lines) {
+        continue;
+      }
+      line_cells.assign(num_columns, absl::string_view());
+    } else if (line_cells.size() != static_cast<size_t>(num_columns)) {
+      return errors::InvalidArgument("CSV line ", i, " has ",
+                                     line_cells.size(), " cells, expected ",
+                                     num_columns, ".");
+    }
+    cells.insert(cells.end(), line_cells.begin(), line_cells.end());
+    ++num_rows;
+  }
+  if (num_rows == 0) {
+    return Status::OK();
+  }
+  // The cells of a column are parsed together, and no longer once one of
+  // them is a STRING.
+  column_types->assign(num_columns, FeatureNameStatistics::INT);
+  for (int column = 0; column < num_columns; ++column) {
+    CsvColumnType& type = (*column_types)[column];
+    for (int64 row = 0; row < num_rows; ++row) {
+      type = std::max(type,
+                      InferCellType(cells[row * num_columns + column]));
+      if (type == FeatureNameStatistics::STRING) {
+        break;
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status DecodeCsvBatch(const std::vector<absl::string_view>& lines,
+                      char delimiter, bool skip_blank_lines,
+                      const std::vector<absl::optional<CsvColumnType>>&
+                          column_types,
+                      CsvBatch* batch) {
+  *batch = CsvBatch();
+  const CsvLineSplitter splitter(delimiter);
+  std::vector<absl::string_view> line_cells;
+  // The cells of the examples, example after example. The cells of example
+  // i are at [row_offsets[i], row_offsets[i + 1]).
+  std::vector<absl::string_view> cells;
+  std::vector<size_t> row_offsets = {0};
+  size_t num_columns = 0;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    if (!splitter.Split(lines[i], &line_cells, &batch->unescaped_cells)) {
+      return errors::InvalidArgument("Cannot split CSV line ", i, ".");
+    }
+    if (line_cells.empty() && skip_blank_lines) {
+      continue;
+    }
+    if (line_cells.size() > column_types.size()) {
+      return errors::InvalidArgument("CSV line ", i, " has ",
+                                     line_cells.size(), " cells, expected ",
+                                     column_types.size(), ".");
+    }
+    cells.insert(cells.end(), line_cells.begin(), line_cells.end());
+    row_offsets.push_back(cells.size());
+    num_columns = std::max(num_columns, line_cells.size());
+  }
+  batch->num_examples = row_offsets.size() - 1;
+
+  batch->columns.resize(num_columns);
+  for (size_t column_index = 0; column_index < num_columns; ++column_index) {
+    FeatureColumn& column = batch->columns[column_index];
+    column.has_values.assign(batch->num_examples, 0);
+    column.row_offsets.reserve(batch->num_examples + 1);
+    column.row_offsets.push_back(0);
+    int64 num_values = 0;
+    for (int64 row = 0; row < batch->num_examples; ++row) {
+      const size_t cell_index = row_offsets[row] + column_index;
+      if (cell_index < row_offsets[row + 1] && !cells[cell_index].empty()) {
+        TF_RETURN_IF_ERROR(
+            AddCell(cells[cell_index], column_types[column_index], &column));
+        column.has_values[row] = 1;
+        ++num_values;
+      }
+      column.row_offsets.push_back(num_values);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,97 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A decoder of batches of CSV lines into per-column features, used by
+// DecodeCSVBatches in coders/csv_decoder.py.
+//
+// The lines are split as by the csv module of Python with the default
+// dialect, but without building a Python object per line or per cell: the
+// delimiters, quotes and line breaks are found 8 bytes at a time, and the
+// cells of a column are then parsed together. The types of the columns are
+// inferred, and the cells are converted, as in coders/csv_decoder.py. Lines
+// that the csv module would reject, or would parse in a way that is not
+// handled here, are reported as errors, so that the caller can fall back to
+// the csv module.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_CSV_BATCH_DECODER_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_CSV_BATCH_DECODER_H_
+
+#include <deque>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow_data_validation/anomalies/feature_column.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// The type of a column: INT, FLOAT or STRING, in increasing order of
+// generality.
+using CsvColumnType = tensorflow::metadata::v0::FeatureNameStatistics::Type;
+
+// Splits line into its cells. Cells without quotes are views of line, and
+// the others are unescaped into *unescaped_cells, which must outlive them.
+// A blank line has no cells. Returns false if the csv module would reject
+// the line: if it has a NUL character, characters after a line break, a
+// quoted cell without an end, or a cell longer than the default field size
+// limit of the csv module.
+bool SplitCsvLine(absl::string_view line, char delimiter,
+                  std::vector<absl::string_view>* cells,
+                  std::deque<string>* unescaped_cells);
+
+// Infers the types of the num_columns columns of lines, as _infer_value_type()
+// in coders/csv_decoder.py does for each cell. A blank line is skipped if
+// skip_blank_lines is true, and has empty cells otherwise. column_types is
+// set to the num_columns types, or cleared if every line is skipped.
+// Returns InvalidArgument if a line cannot be split, or if a line that is
+// not skipped does not have num_columns cells.
+Status InferCsvColumnTypes(const std::vector<absl::string_view>& lines,
+                           char delimiter, bool skip_blank_lines,
+                           int num_columns,
+                           std::vector<CsvColumnType>* column_types);
+
+// A batch of decoded CSV lines.
+struct CsvBatch {
+  // The number of examples, that is, the number of lines less the skipped
+  // blank lines.
+  int64 num_examples = 0;
+  // The columns, up to the largest number of cells of a line. A column has
+  // at most one value per example.
+  std::vector<FeatureColumn> columns;
+  // The unescaped cells that the bytes values of the columns point into.
+  std::deque<string> unescaped_cells;
+};
+
+// Decodes lines into columns of the given types, as _make_example_dict() in
+// coders/csv_decoder.py does: empty cells have no values, INT cells are
+// kInt64 values, FLOAT cells are kDouble values and STRING cells are kBytes
+// values. A blank line is skipped if skip_blank_lines is true, and is an
+// example with no cells otherwise. Returns InvalidArgument if a line cannot
+// be split, if it has more cells than column_types, or if a nonempty cell
+// cannot be converted to the type of its column (or its column has no
+// type).
+Status DecodeCsvBatch(const std::vector<absl::string_view>& lines,
+                      char delimiter, bool skip_blank_lines,
+                      const std::vector<absl::optional<CsvColumnType>>&
+                          column_types,
+                      CsvBatch* batch);
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_CSV_BATCH_DECODER_H_
@@ -0,0 +1,245 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/csv_batch_decoder.h"
+
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using metadata::v0::FeatureNameStatistics;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Returns the cells of line, or {"<error>"} if it cannot be split.
+std::vector<string> Split(absl::string_view line, char delimiter = ',') {
+  std::vector<absl::string_view> cells;
+  std::deque<string> unescaped_cells;
+  if (!SplitCsvLine(line, delimiter, &cells, &unescaped_cells)) {
+    return {"<error>"};
+  }
+  return std::vector<string>(cells.begin(), cells.end());
+}
+
+TEST(CsvBatchDecoderTest, SplitsLines) {
+  EXPECT_THAT(Split("1,2.0,hello"), ElementsAre("1", "2.0", "hello"));
+  EXPECT_THAT(Split(",,"), ElementsAre("", "", ""));
+  EXPECT_THAT(Split("a,"), ElementsAre("a", ""));
+  EXPECT_THAT(Split("  "), ElementsAre("  "));
+  EXPECT_THAT(Split("1 2.0 hello", ' '), ElementsAre("1", "2.0", "hello"));
+  EXPECT_THAT(Split("1\t\thello", '\t'), ElementsAre("1", "", "hello"));
+  // Cells longer than a word.
+  EXPECT_THAT(Split("abcdefghijklmnop,qrstuvwxyz0123456789"),
+              ElementsAre("abcdefghijklmnop", "qrstuvwxyz0123456789"));
+}
+
+TEST(CsvBatchDecoderTest, SplitsBlankLines) {
+  EXPECT_THAT(Split(""), IsEmpty());
+  EXPECT_THAT(Split("\r\n"), IsEmpty());
+  EXPECT_THAT(Split("a,b\r\n"), ElementsAre("a", "b"));
+  EXPECT_THAT(Split("a,\n"), ElementsAre("a", ""));
+}
+
+TEST(CsvBatchDecoderTest, SplitsQuotedCells) {
+  EXPECT_THAT(Split(R"("a,b",c)"), ElementsAre("a,b", "c"));
+  EXPECT_THAT(Split(R"("",c)"), ElementsAre("", "c"));
+  EXPECT_THAT(Split(R"("a ""quoted"" cell in a long line",c)"),
+              ElementsAre(R"(a "quoted" cell in a long line)", "c"));
+  EXPECT_THAT(Split(R"("""")"), ElementsAre(R"(")"));
+  // Text after the closing quote is part of the cell, and quotes that do not
+  // start a cell are part of it.
+  EXPECT_THAT(Split(R"("ab"c"d,e)"), ElementsAre(R"(abc"d)", "e"));
+  EXPECT_THAT(Split(R"(a"b",c)"), ElementsAre(R"(a"b")", "c"));
+  EXPECT_THAT(Split("\"a\nb\",c"), ElementsAre("a\nb", "c"));
+}
+
+TEST(CsvBatchDecoderTest, RejectsLinesThatTheCsvModuleRejects) {
+  EXPECT_THAT(Split(R"("abc,d)"), ElementsAre("<error>"));
+  EXPECT_THAT(Split(R"("abc""d)"), ElementsAre("<error>"));
+  EXPECT_THAT(Split(absl::string_view("a,b\0c", 5)), ElementsAre("<error>"));
+  EXPECT_THAT(Split(absl::string_view("\"a\0\"", 4)), ElementsAre("<error>"));
+  EXPECT_THAT(Split("a\nb"), ElementsAre("<error>"));
+  EXPECT_THAT(Split(string(128 * 1024 + 1, 'a')), ElementsAre("<error>"));
+  EXPECT_THAT(Split(string(128 * 1024, 'a')), ElementsAre(testing::_));
+  EXPECT_THAT(Split("a,b", '"'), ElementsAre("<error>"));
+}
+
+TEST(CsvBatchDecoderTest, InfersColumnTypes) {
+  const std::vector<absl::string_view> lines = {
+      "1,2.0,hello,1,1,,-9223372036854775808,1",
+      " -5 ,12.34,world,2.5,x,,9223372036854775807,9223372036854775808"};
+  std::vector<CsvColumnType> column_types;
+  TF_ASSERT_OK(InferCsvColumnTypes(lines, ',', /*skip_blank_lines=*/true, 8,
+                                   &column_types));
+  EXPECT_THAT(column_types,
+              ElementsAre(FeatureNameStatistics::INT,
+                          FeatureNameStatistics::FLOAT,
+                          FeatureNameStatistics::STRING,
+                          FeatureNameStatistics::FLOAT,
+                          FeatureNameStatistics::STRING,
+                          FeatureNameStatistics::FLOAT,
+                          FeatureNameStatistics::INT,
+                          FeatureNameStatistics::STRING));
+}
+
+TEST(CsvBatchDecoderTest, InfersFloatsAsPythonDoes) {
+  for (const string cell : {"1.", ".5", "1e5", "-1.5E-3", "inf", "-Infinity",
+                            "NaN", " 2.5\t", "1e999", "+.5e+1"}) {
+    std::vector<CsvColumnType> column_types;
+    TF_ASSERT_OK(InferCsvColumnTypes({cell}, ',', true, 1, &column_types));
+    EXPECT_THAT(column_types, ElementsAre(FeatureNameStatistics::FLOAT))
+        << cell;
+  }
+  for (const string cell : {".", "e5", "1e", "0x10", "1.5.5", "nan(1)",
+                            "in", "1_000", "- 5", "1,5"}) {
+    std::vector<CsvColumnType> column_types;
+    TF_ASSERT_OK(InferCsvColumnTypes({absl::StrCat("\"", cell, "\"")}, ',',
+                                     true, 1, &column_types));
+    EXPECT_THAT(column_types, ElementsAre(FeatureNameStatistics::STRING))
+        << cell;
+  }
+}
+
+TEST(CsvBatchDecoderTest, InfersTypesWithBlankLines) {
+  std::vector<CsvColumnType> column_types;
+  TF_ASSERT_OK(InferCsvColumnTypes({"", "1,2"}, ',', /*skip_blank_lines=*/true,
+                                   2, &column_types));
+  EXPECT_THAT(column_types, ElementsAre(FeatureNameStatistics::INT,
+                                        FeatureNameStatistics::INT));
+  TF_ASSERT_OK(InferCsvColumnTypes({"", "1,2"}, ',',
+                                   /*skip_blank_lines=*/false, 2,
+                                   &column_types));
+  EXPECT_THAT(column_types, ElementsAre(FeatureNameStatistics::FLOAT,
+                                        FeatureNameStatistics::FLOAT));
+  TF_ASSERT_OK(InferCsvColumnTypes({"", ""}, ',', /*skip_blank_lines=*/true,
+                                   2, &column_types));
+  EXPECT_THAT(column_types, IsEmpty());
+}
+
+TEST(CsvBatchDecoderTest, InferColumnTypesFailsOnInvalidLines) {
+  std::vector<CsvColumnType> column_types;
+  EXPECT_FALSE(InferCsvColumnTypes({"1,2.0,hello", "5,12.34"}, ',', true, 3,
+                                   &column_types)
+                   .ok());
+  EXPECT_FALSE(
+      InferCsvColumnTypes({"1,\"2"}, ',', true, 2, &column_types).ok());
+}
+
+TEST(CsvBatchDecoderTest, DecodesColumns) {
+  const string line = R"(1,2.0,"a ""b"" c",)";
+  const std::vector<absl::string_view> lines = {line, "", " -5 ,,world,",
+                                                "7,inf,,"};
+  CsvBatch batch;
+  TF_ASSERT_OK(DecodeCsvBatch(
+      lines, ',', /*skip_blank_lines=*/true,
+      {FeatureNameStatistics::INT, FeatureNameStatistics::FLOAT,
+       FeatureNameStatistics::STRING, absl::nullopt},
+      &batch));
+  EXPECT_EQ(3, batch.num_examples);
+  ASSERT_EQ(4, batch.columns.size());
+
+  const FeatureColumn& ints = batch.columns[0];
+  EXPECT_EQ(FeatureColumn::Kind::kInt64, ints.kind);
+  EXPECT_THAT(ints.int64_values, ElementsAre(1, -5, 7));
+  EXPECT_THAT(ints.row_offsets, ElementsAre(0, 1, 2, 3));
+  EXPECT_THAT(ints.has_values, ElementsAre(1, 1, 1));
+
+  const FeatureColumn& floats = batch.columns[1];
+  EXPECT_EQ(FeatureColumn::Kind::kDouble, floats.kind);
+  EXPECT_THAT(floats.double_values,
+              ElementsAre(2.0, std::numeric_limits<double>::infinity()));
+  EXPECT_THAT(floats.row_offsets, ElementsAre(0, 1, 1, 2));
+  EXPECT_THAT(floats.has_values, ElementsAre(1, 0, 1));
+
+  const FeatureColumn& strings = batch.columns[2];
+  EXPECT_EQ(FeatureColumn::Kind::kBytes, strings.kind);
+  EXPECT_THAT(strings.bytes_values, ElementsAre(R"(a "b" c)", "world"));
+  EXPECT_THAT(strings.row_offsets, ElementsAre(0, 1, 2, 2));
+  EXPECT_THAT(strings.has_values, ElementsAre(1, 1, 0));
+
+  // A column without a type may only have empty cells.
+  const FeatureColumn& missing = batch.columns[3];
+  EXPECT_EQ(FeatureColumn::Kind::kNone, missing.kind);
+  EXPECT_THAT(missing.row_offsets, ElementsAre(0, 0, 0, 0));
+  EXPECT_THAT(missing.has_values, ElementsAre(0, 0, 0));
+}
+
+TEST(CsvBatchDecoderTest, DecodesBlankAndShortLines) {
+  CsvBatch batch;
+  TF_ASSERT_OK(DecodeCsvBatch(
+      {"", "1", ""}, ',', /*skip_blank_lines=*/false,
+      {FeatureNameStatistics::INT, FeatureNameStatistics::INT}, &batch));
+  EXPECT_EQ(3, batch.num_examples);
+  // Only the columns of some line are decoded.
+  ASSERT_EQ(1, batch.columns.size());
+  EXPECT_THAT(batch.columns[0].int64_values, ElementsAre(1));
+  EXPECT_THAT(batch.columns[0].has_values, ElementsAre(0, 1, 0));
+
+  TF_ASSERT_OK(DecodeCsvBatch({"", ""}, ',', /*skip_blank_lines=*/true,
+                              {FeatureNameStatistics::INT}, &batch));
+  EXPECT_EQ(0, batch.num_examples);
+  EXPECT_THAT(batch.columns, IsEmpty());
+}
+
+TEST(CsvBatchDecoderTest, DecodesFloatColumnsAsPythonDoes) {
+  CsvBatch batch;
+  TF_ASSERT_OK(DecodeCsvBatch({"5", "99999999999999999999", "-nan", "1e-400"},
+                              ',', true, {FeatureNameStatistics::FLOAT},
+                              &batch));
+  const std::vector<double>& values = batch.columns[0].double_values;
+  ASSERT_EQ(4, values.size());
+  EXPECT_EQ(5.0, values[0]);
+  EXPECT_EQ(1e20, values[1]);
+  EXPECT_TRUE(std::isnan(values[2]));
+  EXPECT_EQ(0.0, values[3]);
+}
+
+TEST(CsvBatchDecoderTest, DecodeFailsOnInvalidCells) {
+  CsvBatch batch;
+  // Too many cells.
+  EXPECT_FALSE(DecodeCsvBatch({"1,2"}, ',', true,
+                              {FeatureNameStatistics::INT}, &batch)
+                   .ok());
+  // Not an int64.
+  EXPECT_FALSE(DecodeCsvBatch({"1.5"}, ',', true,
+                              {FeatureNameStatistics::INT}, &batch)
+                   .ok());
+  EXPECT_FALSE(DecodeCsvBatch({"9223372036854775808"}, ',', true,
+                              {FeatureNameStatistics::INT}, &batch)
+                   .ok());
+  // Not a float.
+  EXPECT_FALSE(DecodeCsvBatch({"a"}, ',', true,
+                              {FeatureNameStatistics::FLOAT}, &batch)
+                   .ok());
+  // No type.
+  EXPECT_FALSE(
+      DecodeCsvBatch({"a"}, ',', true, {absl::nullopt}, &batch).ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,352 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/example_batch_decoder.h"
+
+#include "tensorflow_data_validation/anomalies/wire_reader.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using Kind = FeatureColumn::Kind;
+
+// Field numbers of tensorflow/core/example/{example,feature}.proto.
+constexpr int kExampleFeaturesField = 1;
+constexpr int kFeaturesFeatureField = 1;
+constexpr int kMapEntryKeyField = 1;
+constexpr int kMapEntryValueField = 2;
+constexpr int kFeatureBytesListField = 1;
+constexpr int kFeatureFloatListField = 2;
+constexpr int kFeatureInt64ListField = 3;
+// The field of the values of BytesList, FloatList and Int64List.
+constexpr int kListValueField = 1;
+
+int64 NumValues(const FeatureColumn& column) {
+  switch (column.kind) {
+    case Kind::kInt64:
+      return column.int64_values.size();
+    case Kind::kFloat:
+      return column.float_values.size();
+    case Kind::kBytes:
+      return column.bytes_values.size();
+    case Kind::kDouble:
+    case Kind::kNone:
+      break;
+  }
+  return 0;
+}
+
+void TruncateValues(int64 num_values, FeatureColumn* column) {
+  switch (column->kind) {
+    case Kind::kInt64:
+      column->int64_values.resize(num_values);
+      break;
+    case Kind::kFloat:
+      column->float_values.resize(num_values);
+      break;
+    case Kind::kBytes:
+      column->bytes_values.resize(num_values);
+      break;
+    case Kind::kDouble:
+    case Kind::kNone:
+      break;
+  }
+}
+
+Status ParseError(int64 example_index) {
+  return errors::InvalidArgument("Cannot parse serialized example ",
+                                 example_index);
+}
+
+// Adds empty rows to column for the examples before example_index that did
+// not have the feature.
+void PadColumn(int64 example_index, FeatureColumn* column) {
+  while (static_cast<int64>(column->has_values.size()) < example_index) {
+    column->has_values.push_back(0);
+    column->row_offsets.push_back(column->row_offsets.back());
+  }
+}
+
+// Finds the kind of a serialized Feature, and the fields its values are read
+// from. As the kinds are the fields of a oneof, the values are those of the
+// trailing fields of the last kind (each field is merged into the previous
+// ones of the same kind, and clears the other kinds).
+bool FindKindOfFeature(absl::string_view feature, Kind* kind,
+                       absl::string_view* value_fields) {
+  *kind = Kind::kNone;
+  *value_fields = feature;
+  WireReader reader(feature);
+  while (!reader.done()) {
+    const absl::string_view field_start = reader.remaining();
+    int field, wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    Kind field_kind = Kind::kNone;
+    switch (field) {
+      case kFeatureBytesListField:
+        field_kind = Kind::kBytes;
+        break;
+      case kFeatureFloatListField:
+        field_kind = Kind::kFloat;
+        break;
+      case kFeatureInt64ListField:
+        field_kind = Kind::kInt64;
+        break;
+    }
+    if (field_kind != Kind::kNone) {
+      if (wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        return false;
+      }
+      if (field_kind != *kind) {
+        *kind = field_kind;
+        *value_fields = field_start;
+      }
+    }
+    if (!reader.SkipValue(wire_type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Appends the values of a serialized BytesList, FloatList or Int64List.
+bool AppendValuesOfList(absl::string_view list, Kind kind,
+                        FeatureColumn* column) {
+  WireReader reader(list);
+  while (!reader.done()) {
+    int field, wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    if (field != kListValueField) {
+      if (!reader.SkipValue(wire_type)) {
+        return false;
+      }
+      continue;
+    }
+    switch (kind) {
+      case Kind::kBytes: {
+        absl::string_view value;
+        if (wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+            !reader.ReadLengthDelimited(&value)) {
+          return false;
+        }
+        column->bytes_values.push_back(value);
+        break;
+      }
+      case Kind::kFloat: {
+        float value;
+        if (wire_type == WireFormatLite::WIRETYPE_FIXED32) {
+          if (!reader.ReadFloat(&value)) {
+            return false;
+          }
+          column->float_values.push_back(value);
+          break;
+        }
+        absl::string_view packed;
+        if (wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+            !reader.ReadLengthDelimited(&packed) || packed.size() % 4 != 0) {
+          return false;
+        }
+        WireReader packed_reader(packed);
+        column->float_values.reserve(column->float_values.size() +
+                                     packed.size() / 4);
+        while (!packed_reader.done()) {
+          packed_reader.ReadFloat(&value);
+          column->float_values.push_back(value);
+        }
+        break;
+      }
+      case Kind::kInt64: {
+        uint64 value;
+        if (wire_type == WireFormatLite::WIRETYPE_VARINT) {
+          if (!reader.ReadVarint(&value)) {
+            return false;
+          }
+          column->int64_values.push_back(static_cast<int64>(value));
+          break;
+        }
+        absl::string_view packed;
+        if (wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED ||
+            !reader.ReadLengthDelimited(&packed)) {
+          return false;
+        }
+        WireReader packed_reader(packed);
+        while (!packed_reader.done()) {
+          if (!packed_reader.ReadVarint(&value)) {
+            return false;
+          }
+          column->int64_values.push_back(static_cast<int64>(value));
+        }
+        break;
+      }
+      case Kind::kDouble:
+      case Kind::kNone:
+        return false;
+    }
+  }
+  return true;
+}
+
+// Appends the values of the fields of a serialized Feature found by
+// FindKindOfFeature().
+bool AppendValuesOfFeature(absl::string_view value_fields, Kind kind,
+                           FeatureColumn* column) {
+  WireReader reader(value_fields);
+  while (!reader.done()) {
+    int field, wire_type;
+    absl::string_view list;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    if (wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!reader.SkipValue(wire_type)) {
+        return false;
+      }
+      continue;
+    }
+    if (!reader.ReadLengthDelimited(&list)) {
+      return false;
+    }
+    // The fields of other kinds were skipped by FindKindOfFeature().
+    if ((field == kFeatureBytesListField ||
+         field == kFeatureFloatListField ||
+         field == kFeatureInt64ListField) &&
+        !AppendValuesOfList(list, kind, column)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Adds the feature of example example_index, with a serialized Feature, to
+// its column.
+Status AddFeature(absl::string_view name, absl::string_view feature,
+                  int64 example_index,
+                  absl::flat_hash_map<string, FeatureColumn>* columns) {
+  auto it = columns->find(name);
+  if (it == columns->end()) {
+    it = columns->emplace(string(name), FeatureColumn()).first;
+    it->second.row_offsets.push_back(0);
+  }
+  FeatureColumn& column = it->second;
+  PadColumn(example_index, &column);
+  if (static_cast<int64>(column.has_values.size()) > example_index) {
+    // The example already had the feature, whose last value is kept.
+    TruncateValues(column.row_offsets[example_index], &column);
+    column.row_offsets.pop_back();
+    column.has_values.pop_back();
+  }
+  Kind kind;
+  absl::string_view value_fields;
+  if (!FindKindOfFeature(feature, &kind, &value_fields)) {
+    return ParseError(example_index);
+  }
+  if (kind != Kind::kNone) {
+    if (column.kind == Kind::kNone) {
+      column.kind = kind;
+    } else if (column.kind != kind) {
+      return errors::InvalidArgument("Feature ", name,
+                                     " has values of different kinds.");
+    }
+    if (!AppendValuesOfFeature(value_fields, kind, &column)) {
+      return ParseError(example_index);
+    }
+  }
+  column.has_values.push_back(kind == Kind::kNone ? 0 : 1);
+  column.row_offsets.push_back(NumValues(column));
+  return Status::OK();
+}
+
+Status DecodeExample(absl::string_view example, int64 example_index,
+                     absl::flat_hash_map<string, FeatureColumn>* columns) {
+  WireReader example_reader(example);
+  while (!example_reader.done()) {
+    int field, wire_type;
+    if (!example_reader.ReadTag(&field, &wire_type)) {
+      return ParseError(example_index);
+    }
+    absl::string_view features;
+    if (field != kExampleFeaturesField ||
+        wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!example_reader.SkipValue(wire_type)) {
+        return ParseError(example_index);
+      }
+      continue;
+    }
+    if (!example_reader.ReadLengthDelimited(&features)) {
+      return ParseError(example_index);
+    }
+    WireReader features_reader(features);
+    while (!features_reader.done()) {
+      absl::string_view entry;
+      if (!features_reader.ReadTag(&field, &wire_type)) {
+        return ParseError(example_index);
+      }
+      if (field != kFeaturesFeatureField ||
+          wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        if (!features_reader.SkipValue(wire_type)) {
+          return ParseError(example_index);
+        }
+        continue;
+      }
+      if (!features_reader.ReadLengthDelimited(&entry)) {
+        return ParseError(example_index);
+      }
+      // A map entry without a value has an empty Feature.
+      absl::string_view name;
+      absl::string_view feature;
+      WireReader entry_reader(entry);
+      while (!entry_reader.done()) {
+        if (!entry_reader.ReadTag(&field, &wire_type)) {
+          return ParseError(example_index);
+        }
+        if ((field == kMapEntryKeyField || field == kMapEntryValueField) &&
+            wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+          if (!entry_reader.ReadLengthDelimited(
+                  field == kMapEntryKeyField ? &name : &feature)) {
+            return ParseError(example_index);
+          }
+        } else if (!entry_reader.SkipValue(wire_type)) {
+          return ParseError(example_index);
+        }
+      }
+      TF_RETURN_IF_ERROR(AddFeature(name, feature, example_index, columns));
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+Status DecodeExampleBatch(
+    const std::vector<absl::string_view>& serialized_examples,
+    absl::flat_hash_map<string, FeatureColumn>* columns) {
+  columns->clear();
+  const int64 num_examples = serialized_examples.size();
+  for (int64 i = 0; i < num_examples; ++i) {
+    TF_RETURN_IF_ERROR(DecodeExample(serialized_examples[i], i, columns));
+  }
+  for (auto& name_and_column : *columns) {
+    PadColumn(num_examples, &name_and_column.second);
+  }
+  return Status::OK();
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
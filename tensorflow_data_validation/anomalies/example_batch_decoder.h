@@ -0,0 +1,48 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A decoder of batches of serialized tf.Examples into per-feature columns,
+// used by TFExampleDecoder.decode_batch() in coders/tf_example_decoder.py.
+//
+// The examples are read directly from the protocol buffer wire format: no
+// Example message is built, the int64 and float values of a feature are
+// appended to a single buffer per batch, and the bytes values point into the
+// serialized examples. As when parsing an Example, a feature that appears
+// several times in an example takes its last value.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_EXAMPLE_BATCH_DECODER_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_EXAMPLE_BATCH_DECODER_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/feature_column.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// Decodes serialized tf.Examples into the columns of their features, keyed
+// by feature name. Returns InvalidArgument if an example cannot be parsed,
+// or if a feature has values of different kinds in the batch.
+Status DecodeExampleBatch(
+    const std::vector<absl::string_view>& serialized_examples,
+    absl::flat_hash_map<string, FeatureColumn>* columns);
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_EXAMPLE_BATCH_DECODER_H_
@@ -0,0 +1,206 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/example_batch_decoder.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Serializes examples given as text protos.
+std::vector<string> SerializeExamples(
+    const std::vector<string>& text_examples) {
+  std::vector<string> result;
+  for (const string& text_example : text_examples) {
+    result.push_back(testing::ParseTextProtoOrDie<Example>(text_example)
+                         .SerializeAsString());
+  }
+  return result;
+}
+
+std::vector<absl::string_view> AsViews(const std::vector<string>& strings) {
+  return std::vector<absl::string_view>(strings.begin(), strings.end());
+}
+
+TEST(ExampleBatchDecoderTest, DecodesAllKinds) {
+  const std::vector<string> serialized = SerializeExamples({R"(
+      features {
+        feature {
+          key: "i"
+          value { int64_list { value: [1, -2, 3] } }
+        }
+        feature {
+          key: "f"
+          value { float_list { value: [1.5] } }
+        }
+        feature {
+          key: "b"
+          value { bytes_list { value: ["a", "bc"] } }
+        }
+      })", R"(
+      features {
+        feature {
+          key: "i"
+          value { int64_list { value: [4] } }
+        }
+        feature {
+          key: "b"
+          value { bytes_list { } }
+        }
+      })"});
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  TF_ASSERT_OK(DecodeExampleBatch(AsViews(serialized), &columns));
+  ASSERT_EQ(3, columns.size());
+
+  const FeatureColumn& i = columns.at("i");
+  EXPECT_EQ(FeatureColumn::Kind::kInt64, i.kind);
+  EXPECT_THAT(i.has_values, ElementsAre(1, 1));
+  EXPECT_THAT(i.row_offsets, ElementsAre(0, 3, 4));
+  EXPECT_THAT(i.int64_values, ElementsAre(1, -2, 3, 4));
+
+  const FeatureColumn& f = columns.at("f");
+  EXPECT_EQ(FeatureColumn::Kind::kFloat, f.kind);
+  EXPECT_THAT(f.has_values, ElementsAre(1, 0));
+  EXPECT_THAT(f.row_offsets, ElementsAre(0, 1, 1));
+  EXPECT_THAT(f.float_values, ElementsAre(1.5));
+
+  const FeatureColumn& b = columns.at("b");
+  EXPECT_EQ(FeatureColumn::Kind::kBytes, b.kind);
+  EXPECT_THAT(b.has_values, ElementsAre(1, 1));
+  EXPECT_THAT(b.row_offsets, ElementsAre(0, 2, 2));
+  EXPECT_THAT(b.bytes_values, ElementsAre("a", "bc"));
+}
+
+TEST(ExampleBatchDecoderTest, MissingFeatures) {
+  const std::vector<string> serialized =
+      SerializeExamples({R"(features {})", R"(
+      features {
+        feature {
+          key: "x"
+          value { float_list { value: [1.0, 2.0] } }
+        }
+        feature {
+          key: "y"
+          value { }
+        }
+      })", R"(features {})"});
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  TF_ASSERT_OK(DecodeExampleBatch(AsViews(serialized), &columns));
+  const FeatureColumn& x = columns.at("x");
+  EXPECT_THAT(x.has_values, ElementsAre(0, 1, 0));
+  EXPECT_THAT(x.row_offsets, ElementsAre(0, 0, 2, 2));
+  EXPECT_THAT(x.float_values, ElementsAre(1.0, 2.0));
+
+  // A feature without a list of values is missing.
+  const FeatureColumn& y = columns.at("y");
+  EXPECT_EQ(FeatureColumn::Kind::kNone, y.kind);
+  EXPECT_THAT(y.has_values, ElementsAre(0, 0, 0));
+  EXPECT_THAT(y.row_offsets, ElementsAre(0, 0, 0, 0));
+}
+
+TEST(ExampleBatchDecoderTest, EmptyBatch) {
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  TF_ASSERT_OK(DecodeExampleBatch({}, &columns));
+  EXPECT_THAT(columns, IsEmpty());
+}
+
+TEST(ExampleBatchDecoderTest, RepeatedFeatureKeepsLastValue) {
+  // Concatenated serialized messages are merged: the second value of "x"
+  // replaces the first one.
+  const string first = testing::ParseTextProtoOrDie<Example>(R"(
+      features {
+        feature {
+          key: "x"
+          value { int64_list { value: [1, 2] } }
+        }
+      })").SerializeAsString();
+  const string second = testing::ParseTextProtoOrDie<Example>(R"(
+      features {
+        feature {
+          key: "x"
+          value { int64_list { value: [3] } }
+        }
+      })").SerializeAsString();
+  const string serialized = first + second;
+  Example expected;
+  ASSERT_TRUE(expected.ParseFromString(serialized));
+  ASSERT_EQ(1, expected.features().feature().at("x").int64_list().value_size());
+
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  TF_ASSERT_OK(DecodeExampleBatch({serialized, first}, &columns));
+  const FeatureColumn& x = columns.at("x");
+  EXPECT_THAT(x.row_offsets, ElementsAre(0, 1, 3));
+  EXPECT_THAT(x.int64_values, ElementsAre(3, 1, 2));
+}
+
+TEST(ExampleBatchDecoderTest, UnpackedValues) {
+  // Int64List {value: 7 value: 8} and FloatList {value: 0.5}, not packed.
+  const string int64_list("\x08\x07\x08\x08", 4);
+  const string float_list("\x0d\x00\x00\x00\x3f", 5);
+  const string feature_i = "\x1a" + string(1, int64_list.size()) + int64_list;
+  const string feature_f = "\x12" + string(1, float_list.size()) + float_list;
+  const string entry_i = "\x0a\x01i\x12" + string(1, feature_i.size()) +
+                         feature_i;
+  const string entry_f = "\x0a\x01" "f\x12" + string(1, feature_f.size()) +
+                         feature_f;
+  const string features = "\x0a" + string(1, entry_i.size()) + entry_i +
+                          "\x0a" + string(1, entry_f.size()) + entry_f;
+  const string serialized = "\x0a" + string(1, features.size()) + features;
+
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  TF_ASSERT_OK(DecodeExampleBatch({serialized}, &columns));
+  EXPECT_THAT(columns.at("i").int64_values, ElementsAre(7, 8));
+  EXPECT_THAT(columns.at("f").float_values, ElementsAre(0.5));
+}
+
+TEST(ExampleBatchDecoderTest, DifferentKindsFail) {
+  const std::vector<string> serialized = SerializeExamples({R"(
+      features {
+        feature {
+          key: "x"
+          value { int64_list { value: [1] } }
+        }
+      })", R"(
+      features {
+        feature {
+          key: "x"
+          value { float_list { value: [1.0] } }
+        }
+      })"});
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  EXPECT_FALSE(DecodeExampleBatch(AsViews(serialized), &columns).ok());
+}
+
+TEST(ExampleBatchDecoderTest, MalformedExampleFails) {
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  EXPECT_FALSE(DecodeExampleBatch({"\x0a\x05\x0a"}, &columns).ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
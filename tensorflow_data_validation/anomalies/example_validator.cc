@@ -0,0 +1,501 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/example_validator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+#include "absl/types/optional.h"
+#include "tensorflow_data_validation/anomalies/example_batch_decoder.h"
+#include "tensorflow_data_validation/anomalies/feature_util.h"
+#include "tensorflow_data_validation/anomalies/numeric_string_util.h"
+#include "tensorflow_data_validation/anomalies/path.h"
+#include "tensorflow_data_validation/anomalies/schema.h"
+#include "tensorflow_data_validation/anomalies/string_domain_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+namespace {
+
+using ::tensorflow::metadata::v0::DatasetFeatureStatistics;
+using ::tensorflow::metadata::v0::Feature;
+using ::tensorflow::metadata::v0::FeatureNameStatistics;
+using ::tensorflow::metadata::v0::FeatureType;
+
+// Returns the kind of the values of a tf.Example feature of type, or kNone
+// if it can have any kind.
+FeatureColumn::Kind KindOfFeatureType(FeatureType type) {
+  switch (type) {
+    case tensorflow::metadata::v0::INT:
+      return FeatureColumn::Kind::kInt64;
+    case tensorflow::metadata::v0::FLOAT:
+      return FeatureColumn::Kind::kFloat;
+    case tensorflow::metadata::v0::BYTES:
+      return FeatureColumn::Kind::kBytes;
+    default:
+      return FeatureColumn::Kind::kNone;
+  }
+}
+
+// Returns the type of the statistics of values of kind.
+FeatureNameStatistics::Type StatisticsTypeOfKind(FeatureColumn::Kind kind) {
+  switch (kind) {
+    case FeatureColumn::Kind::kFloat:
+    case FeatureColumn::Kind::kDouble:
+      return FeatureNameStatistics::FLOAT;
+    case FeatureColumn::Kind::kBytes:
+      return FeatureNameStatistics::STRING;
+    default:
+      return FeatureNameStatistics::INT;
+  }
+}
+
+// Adds an occurrence of a value outside the domain to counters, unless
+// there are already too many distinct ones.
+void AddOutOfDomainValue(absl::string_view value, int64 count,
+                         ExampleFeatureCounters* counters) {
+  auto iter = counters->out_of_domain_values.find(string(value));
+  if (iter != counters->out_of_domain_values.end()) {
+    iter->second += count;
+  } else if (counters->out_of_domain_values.size() <
+             ExampleFeatureCounters::kMaxOutOfDomainValues) {
+    counters->out_of_domain_values.emplace(string(value), count);
+  }
+}
+
+}  // namespace
+
+constexpr int ExampleFeatureCounters::kMaxOutOfDomainValues;
+
+void ExampleValidationCounters::Merge(const ExampleValidationCounters& other) {
+  num_examples += other.num_examples;
+  num_unparsable_examples += other.num_unparsable_examples;
+  num_invalid_examples += other.num_invalid_examples;
+  for (const auto& pair : other.features) {
+    const ExampleFeatureCounters& from = pair.second;
+    ExampleFeatureCounters& to = features[pair.first];
+    to.num_present += from.num_present;
+    to.num_missing += from.num_missing;
+    to.num_wrong_type += from.num_wrong_type;
+    to.num_too_few_values += from.num_too_few_values;
+    to.num_too_many_values += from.num_too_many_values;
+    to.num_out_of_domain += from.num_out_of_domain;
+    if (to.kind == FeatureColumn::Kind::kNone) {
+      to.kind = from.kind;
+    }
+    if (to.wrong_kind == FeatureColumn::Kind::kNone) {
+      to.wrong_kind = from.wrong_kind;
+    }
+    to.min_num_values = std::min(to.min_num_values, from.min_num_values);
+    to.max_num_values = std::max(to.max_num_values, from.max_num_values);
+    to.total_num_values += from.total_num_values;
+    to.min_value = std::min(to.min_value, from.min_value);
+    to.max_value = std::max(to.max_value, from.max_value);
+    for (const auto& value_and_count : from.out_of_domain_values) {
+      AddOutOfDomainValue(value_and_count.first, value_and_count.second, &to);
+    }
+  }
+}
+
+Status ExampleValidator::Init(const metadata::v0::Schema& schema_proto,
+                              const gtl::optional<string>& environment,
+                              const ValidationConfig& validation_config) {
+  if (initialized_) {
+    return errors::FailedPrecondition(
+        "ExampleValidator is already initialized");
+  }
+  schema_proto_ = schema_proto;
+  environment_ = environment;
+  TF_RETURN_IF_ERROR(validator_.Init(schema_proto_, validation_config));
+
+  Schema schema;
+  TF_RETURN_IF_ERROR(schema.Init(schema_proto_));
+  std::set<string> required;
+  for (const Path& path : schema.GetRequiredFeatures(environment_)) {
+    if (path.size() == 1) {
+      required.insert(path.last_step());
+    }
+  }
+
+  checks_.reserve(schema_proto_.feature_size());
+  for (const Feature& feature : schema_proto_.feature()) {
+    // tf.Examples are flat, so they cannot have a struct feature.
+    if (feature.type() == tensorflow::metadata::v0::STRUCT ||
+        check_index_.contains(feature.name())) {
+      continue;
+    }
+    FeatureCheck check;
+    check.name = feature.name();
+    check.deprecated = FeatureIsDeprecated(feature);
+    check.kind = KindOfFeatureType(feature.type());
+    check.required = feature.presence().min_fraction() >= 1.0 &&
+                     required.count(feature.name()) > 0;
+    if (feature.has_value_count()) {
+      check.min_num_values = feature.value_count().min();
+      if (feature.value_count().has_max()) {
+        check.max_num_values = feature.value_count().max();
+      }
+    }
+    // A domain that the type of the feature cannot have is an anomaly of
+    // the schema, which the aggregate validation reports: it is not checked.
+    if (IsFeatureTypeAllowed(feature.domain_info_case(), feature.type())) {
+      switch (feature.domain_info_case()) {
+        case Feature::kIntDomain:
+          check.domain = FeatureCheck::Domain::kIntRange;
+          if (feature.int_domain().has_min()) {
+            check.int_min = feature.int_domain().min();
+          }
+          if (feature.int_domain().has_max()) {
+            check.int_max = feature.int_domain().max();
+          }
+          break;
+        case Feature::kFloatDomain:
+          check.domain = FeatureCheck::Domain::kFloatRange;
+          if (feature.float_domain().has_min()) {
+            check.float_min = feature.float_domain().min();
+          }
+          if (feature.float_domain().has_max()) {
+            check.float_max = feature.float_domain().max();
+          }
+          break;
+        case Feature::kBoolDomain:
+          check.domain = FeatureCheck::Domain::kBool;
+          if (feature.bool_domain().has_true_value()) {
+            check.string_values.insert(feature.bool_domain().true_value());
+          }
+          if (feature.bool_domain().has_false_value()) {
+            check.string_values.insert(feature.bool_domain().false_value());
+          }
+          break;
+        case Feature::kStringDomain:
+          check.domain = FeatureCheck::Domain::kStringValues;
+          check.string_values = GetStringDomainValues(feature.string_domain());
+          break;
+        case Feature::kDomain:
+          for (const metadata::v0::StringDomain& string_domain :
+               schema_proto_.string_domain()) {
+            if (string_domain.name() == feature.domain()) {
+              check.domain = FeatureCheck::Domain::kStringValues;
+              check.string_values = GetStringDomainValues(string_domain);
+              break;
+            }
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    check_index_[check.name] = checks_.size();
+    checks_.push_back(std::move(check));
+  }
+  initialized_ = true;
+  return Status::OK();
+}
+
+Status ExampleValidator::ValidateBatch(
+    const std::vector<absl::string_view>& serialized_examples,
+    std::vector<uint8>* example_is_valid,
+    ExampleValidationCounters* counters) const {
+  if (!initialized_) {
+    return errors::FailedPrecondition("ExampleValidator is not initialized");
+  }
+  if (counters == nullptr) {
+    return errors::InvalidArgument("counters must not be null");
+  }
+  const int64 num_examples = serialized_examples.size();
+  if (example_is_valid != nullptr) {
+    example_is_valid->assign(num_examples, 1);
+  }
+  counters->num_examples += num_examples;
+
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  if (DecodeExampleBatch(serialized_examples, &columns).ok()) {
+    ValidateColumns(columns, num_examples, 0, example_is_valid, counters);
+    return Status::OK();
+  }
+  // Some example cannot be parsed, or some feature has values of different
+  // kinds in different examples: the examples are validated one at a time.
+  for (int64 i = 0; i < num_examples; ++i) {
+    if (!DecodeExampleBatch({serialized_examples[i]}, &columns).ok()) {
+      ++counters->num_unparsable_examples;
+      ++counters->num_invalid_examples;
+      if (example_is_valid != nullptr) {
+        (*example_is_valid)[i] = 0;
+      }
+      continue;
+    }
+    ValidateColumns(columns, 1, i, example_is_valid, counters);
+  }
+  return Status::OK();
+}
+
+void ExampleValidator::ValidateColumns(
+    const absl::flat_hash_map<string, FeatureColumn>& columns,
+    int64 num_examples, int64 first_example,
+    std::vector<uint8>* example_is_valid,
+    ExampleValidationCounters* counters) const {
+  // invalid[i] is 1 if example i of the columns failed some check.
+  std::vector<uint8> invalid(num_examples, 0);
+
+  // The columns of the features that are not in the schema are counted
+  // as the others, but are not checked.
+  const FeatureCheck unchecked;
+  const FeatureColumn no_column;
+  struct Work {
+    const FeatureCheck* check;
+    const string* name;
+    const FeatureColumn* column;
+  };
+  std::vector<Work> work;
+  work.reserve(checks_.size() + columns.size());
+  for (const FeatureCheck& check : checks_) {
+    const auto iter = columns.find(check.name);
+    work.push_back({&check, &check.name,
+                    iter == columns.end() ? &no_column : &iter->second});
+  }
+  for (const auto& pair : columns) {
+    if (!check_index_.contains(pair.first)) {
+      work.push_back({&unchecked, &pair.first, &pair.second});
+    }
+  }
+
+  for (const Work& item : work) {
+    const FeatureCheck& check = *item.check;
+    const FeatureColumn& column = *item.column;
+    const bool in_schema = item.check != &unchecked;
+    ExampleFeatureCounters& feature_counters = counters->features[*item.name];
+    const bool checked = in_schema && !check.deprecated;
+
+    if (column.kind == FeatureColumn::Kind::kNone) {
+      feature_counters.num_missing += num_examples;
+      if (checked && check.required) {
+        std::fill(invalid.begin(), invalid.end(), 1);
+      }
+      continue;
+    }
+    // The kind expected is that of the schema or, if it allows any kind,
+    // the first one found.
+    FeatureColumn::Kind expected_kind = check.kind;
+    if (expected_kind == FeatureColumn::Kind::kNone) {
+      if (feature_counters.kind == FeatureColumn::Kind::kNone) {
+        feature_counters.kind = column.kind;
+      }
+      expected_kind = feature_counters.kind;
+    }
+    const bool wrong_type = column.kind != expected_kind;
+    if (wrong_type) {
+      feature_counters.kind = expected_kind;
+      if (feature_counters.wrong_kind == FeatureColumn::Kind::kNone) {
+        feature_counters.wrong_kind = column.kind;
+      }
+    } else {
+      feature_counters.kind = column.kind;
+    }
+
+    for (int64 i = 0; i < num_examples; ++i) {
+      if (!column.has_values[i]) {
+        ++feature_counters.num_missing;
+        if (checked && check.required) {
+          invalid[i] = 1;
+        }
+        continue;
+      }
+      ++feature_counters.num_present;
+      if (wrong_type) {
+        ++feature_counters.num_wrong_type;
+        if (checked) {
+          invalid[i] = 1;
+        }
+        continue;
+      }
+      const int64 begin = column.row_offsets[i];
+      const int64 end = column.row_offsets[i + 1];
+      const int64 num_values = end - begin;
+      feature_counters.min_num_values =
+          std::min(feature_counters.min_num_values, num_values);
+      feature_counters.max_num_values =
+          std::max(feature_counters.max_num_values, num_values);
+      feature_counters.total_num_values += num_values;
+      if (checked && num_values < check.min_num_values) {
+        ++feature_counters.num_too_few_values;
+        invalid[i] = 1;
+      }
+      if (checked && num_values > check.max_num_values) {
+        ++feature_counters.num_too_many_values;
+        invalid[i] = 1;
+      }
+
+      bool out_of_domain = false;
+      switch (column.kind) {
+        case FeatureColumn::Kind::kInt64:
+          for (int64 j = begin; j < end; ++j) {
+            const int64 value = column.int64_values[j];
+            const double as_double = value;
+            feature_counters.min_value =
+                std::min(feature_counters.min_value, as_double);
+            feature_counters.max_value =
+                std::max(feature_counters.max_value, as_double);
+            if (!checked) continue;
+            if (check.domain == FeatureCheck::Domain::kIntRange) {
+              out_of_domain |= value < check.int_min || value > check.int_max;
+            } else if (check.domain == FeatureCheck::Domain::kBool) {
+              out_of_domain |= value != 0 && value != 1;
+            }
+          }
+          break;
+        case FeatureColumn::Kind::kFloat:
+          for (int64 j = begin; j < end; ++j) {
+            const float value = column.float_values[j];
+            // NaNs are in every float domain.
+            if (std::isnan(value)) continue;
+            const double as_double = value;
+            feature_counters.min_value =
+                std::min(feature_counters.min_value, as_double);
+            feature_counters.max_value =
+                std::max(feature_counters.max_value, as_double);
+            if (checked && check.domain == FeatureCheck::Domain::kFloatRange) {
+              out_of_domain |=
+                  value < check.float_min || value > check.float_max;
+            }
+          }
+          break;
+        case FeatureColumn::Kind::kBytes:
+          if (!checked || check.domain == FeatureCheck::Domain::kNone) break;
+          for (int64 j = begin; j < end; ++j) {
+            const absl::string_view value = column.bytes_values[j];
+            bool value_out_of_domain = false;
+            switch (check.domain) {
+              case FeatureCheck::Domain::kIntRange: {
+                int64 parsed;
+                value_out_of_domain = !ParseInt64(value, &parsed) ||
+                                      parsed < check.int_min ||
+                                      parsed > check.int_max;
+                break;
+              }
+              case FeatureCheck::Domain::kFloatRange: {
+                float parsed;
+                value_out_of_domain =
+                    !ParseFloat(value, &parsed) ||
+                    (!std::isnan(parsed) &&
+                     (parsed < check.float_min || parsed > check.float_max));
+                break;
+              }
+              case FeatureCheck::Domain::kBool:
+              case FeatureCheck::Domain::kStringValues:
+                value_out_of_domain = !check.string_values.contains(value);
+                break;
+              default:
+                break;
+            }
+            if (value_out_of_domain) {
+              out_of_domain = true;
+              AddOutOfDomainValue(value, 1, &feature_counters);
+            }
+          }
+          break;
+        default:
+          break;
+      }
+      if (out_of_domain) {
+        ++feature_counters.num_out_of_domain;
+        invalid[i] = 1;
+      }
+    }
+  }
+
+  for (int64 i = 0; i < num_examples; ++i) {
+    if (invalid[i]) {
+      ++counters->num_invalid_examples;
+      if (example_is_valid != nullptr) {
+        (*example_is_valid)[first_example + i] = 0;
+      }
+    }
+  }
+}
+
+DatasetFeatureStatistics ExampleValidator::GetStatistics(
+    const ExampleValidationCounters& counters) const {
+  DatasetFeatureStatistics statistics;
+  statistics.set_num_examples(counters.num_examples -
+                              counters.num_unparsable_examples);
+  for (const auto& pair : counters.features) {
+    const ExampleFeatureCounters& feature_counters = pair.second;
+    // As in the statistics of a dataset, a feature that no example has is
+    // left out.
+    if (feature_counters.num_present == 0) {
+      continue;
+    }
+    FeatureNameStatistics* feature = statistics.add_features();
+    feature->set_name(pair.first);
+    // Examples of the wrong type are reported for that alone: if the
+    // statistics had the type of the schema, the wrong type would be
+    // missed.
+    const bool wrong_type = feature_counters.num_wrong_type > 0;
+    feature->set_type(StatisticsTypeOfKind(
+        wrong_type ? feature_counters.wrong_kind : feature_counters.kind));
+
+    metadata::v0::CommonStatistics* common_stats =
+        feature->type() == FeatureNameStatistics::STRING
+            ? feature->mutable_string_stats()->mutable_common_stats()
+            : feature->mutable_num_stats()->mutable_common_stats();
+    common_stats->set_num_non_missing(feature_counters.num_present);
+    common_stats->set_num_missing(feature_counters.num_missing);
+    const int64 num_counted =
+        feature_counters.num_present - feature_counters.num_wrong_type;
+    if (num_counted > 0) {
+      common_stats->set_min_num_values(feature_counters.min_num_values);
+      common_stats->set_max_num_values(feature_counters.max_num_values);
+      common_stats->set_tot_num_values(feature_counters.total_num_values);
+      common_stats->set_avg_num_values(
+          static_cast<float>(feature_counters.total_num_values) / num_counted);
+    }
+    if (wrong_type) {
+      continue;
+    }
+    if (feature->type() == FeatureNameStatistics::STRING) {
+      metadata::v0::RankHistogram* rank_histogram =
+          feature->mutable_string_stats()->mutable_rank_histogram();
+      for (const auto& value_and_count :
+           feature_counters.out_of_domain_values) {
+        metadata::v0::RankHistogram::Bucket* bucket =
+            rank_histogram->add_buckets();
+        bucket->set_label(value_and_count.first);
+        bucket->set_sample_count(value_and_count.second);
+      }
+      feature->mutable_string_stats()->set_unique(
+          feature_counters.out_of_domain_values.size());
+    } else if (feature_counters.min_value <= feature_counters.max_value) {
+      feature->mutable_num_stats()->set_min(feature_counters.min_value);
+      feature->mutable_num_stats()->set_max(feature_counters.max_value);
+    }
+  }
+  return statistics;
+}
+
+Status ExampleValidator::GetAnomalies(const ExampleValidationCounters& counters,
+                                      metadata::v0::Anomalies* result) const {
+  if (!initialized_) {
+    return errors::FailedPrecondition("ExampleValidator is not initialized");
+  }
+  return validator_.Validate(GetStatistics(counters), environment_,
+                             gtl::nullopt, gtl::nullopt, gtl::nullopt, result);
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,195 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A validator of individual serialized tf.Examples against a schema, e.g.,
+// of the requests of a model at serving time, which are otherwise only
+// validated when the statistics of a dataset of them are.
+//
+// Init() compiles each feature of the schema into a check of its type, its
+// number of values (value_count), its presence (for the features required
+// in every example) and its int, float, bool or string domain. The examples
+// of a batch are decoded into columns (see example_batch_decoder.h), and each
+// check then runs over the column of its feature. The results are counted
+// per feature, and the counters are folded into an Anomalies proto by
+// rebuilding the statistics of the examples that matter to them, which are
+// validated as usual: the anomalies have the same descriptions as those of
+// the statistics of the examples.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_EXAMPLE_VALIDATOR_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_EXAMPLE_VALIDATOR_H_
+
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/feature_column.h"
+#include "tensorflow_data_validation/anomalies/feature_statistics_validator.h"
+#include "tensorflow_data_validation/anomalies/internal_types.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/optional.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/anomalies.pb.h"
+#include "tensorflow_metadata/proto/v0/schema.pb.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// The counts of the checks of a feature over the examples validated.
+struct ExampleFeatureCounters {
+  // The number of examples with and without a list of values for the
+  // feature.
+  int64 num_present = 0;
+  int64 num_missing = 0;
+  // The number of examples with values of another type than the feature in
+  // the schema, with fewer values than value_count.min, with more values
+  // than value_count.max, and with values outside the domain of the feature.
+  int64 num_wrong_type = 0;
+  int64 num_too_few_values = 0;
+  int64 num_too_many_values = 0;
+  int64 num_out_of_domain = 0;
+
+  // The kind of the values of the examples of the right type, and the first
+  // other kind of values found, if any.
+  FeatureColumn::Kind kind = FeatureColumn::Kind::kNone;
+  FeatureColumn::Kind wrong_kind = FeatureColumn::Kind::kNone;
+  // The range of the numbers of values, and their total, over the examples
+  // of the right type.
+  int64 min_num_values = std::numeric_limits<int64>::max();
+  int64 max_num_values = 0;
+  int64 total_num_values = 0;
+  // The range of the int64 or float values, other than NaNs.
+  double min_value = std::numeric_limits<double>::infinity();
+  double max_value = -std::numeric_limits<double>::infinity();
+  // The bytes values outside the domain, with their number of occurrences.
+  // At most kMaxOutOfDomainValues distinct values are kept: the examples with
+  // the others are only counted in num_out_of_domain.
+  std::map<string, int64> out_of_domain_values;
+
+  static constexpr int kMaxOutOfDomainValues = 1000;
+};
+
+// The counts of the checks of the examples validated, e.g., since the last
+// report of their anomalies.
+struct ExampleValidationCounters {
+  int64 num_examples = 0;
+  // The examples that could not be parsed, and those that failed some check
+  // (including those that could not be parsed).
+  int64 num_unparsable_examples = 0;
+  int64 num_invalid_examples = 0;
+  // The counters of each feature found in the examples or required by the
+  // schema, keyed by name.
+  std::map<string, ExampleFeatureCounters> features;
+
+  // Adds the counts of other, e.g., of examples validated on another thread.
+  void Merge(const ExampleValidationCounters& other);
+};
+
+class ExampleValidator {
+ public:
+  ExampleValidator() = default;
+
+  // Disallow copy and move.
+  ExampleValidator(const ExampleValidator&) = delete;
+  ExampleValidator& operator=(const ExampleValidator&) = delete;
+
+  // Compiles the checks of the features of schema_proto, for examples of
+  // environment. validation_config is used by GetAnomalies(). Must be called
+  // once, before the other methods.
+  Status Init(const metadata::v0::Schema& schema_proto,
+              const gtl::optional<string>& environment,
+              const ValidationConfig& validation_config);
+
+  // Validates each of serialized_examples, adding the results to *counters.
+  // If example_is_valid is not null, sets (*example_is_valid)[i] to 1 if
+  // serialized_examples[i] passes all the checks, and to 0 otherwise. An
+  // example that cannot be parsed fails, but does not stop the others from
+  // being validated. Features that are not in the schema are counted, but do
+  // not fail an example. Can be called concurrently.
+  Status ValidateBatch(
+      const std::vector<absl::string_view>& serialized_examples,
+      std::vector<uint8>* example_is_valid,
+      ExampleValidationCounters* counters) const;
+
+  // Fills *result with the anomalies of the examples counted in counters, as
+  // ValidateFeatureStatistics() would find them in statistics of those
+  // examples (other than those that could not be parsed). The statistics
+  // only have the values that matter to the checks. So the anomalies list
+  // the values outside the domains (or at most the first
+  // kMaxOutOfDomainValues of them), and features with examples of the wrong
+  // type are only reported for that.
+  Status GetAnomalies(const ExampleValidationCounters& counters,
+                      metadata::v0::Anomalies* result) const;
+
+  // Returns the statistics that GetAnomalies() validates.
+  metadata::v0::DatasetFeatureStatistics GetStatistics(
+      const ExampleValidationCounters& counters) const;
+
+ private:
+  // The check of a feature of the schema.
+  struct FeatureCheck {
+    enum class Domain {
+      kNone,
+      kIntRange,
+      kFloatRange,
+      kBool,
+      kStringValues,
+    };
+
+    string name;
+    // The kind of the values, or kNone if any kind is allowed.
+    FeatureColumn::Kind kind = FeatureColumn::Kind::kNone;
+    // Whether the feature is deprecated, and so not checked.
+    bool deprecated = false;
+    // Whether every example must have the feature.
+    bool required = false;
+    int64 min_num_values = 0;
+    int64 max_num_values = std::numeric_limits<int64>::max();
+    Domain domain = Domain::kNone;
+    // The bounds of an int or float domain, inclusive.
+    int64 int_min = std::numeric_limits<int64>::min();
+    int64 int_max = std::numeric_limits<int64>::max();
+    float float_min = -std::numeric_limits<float>::infinity();
+    float float_max = std::numeric_limits<float>::infinity();
+    // The strings of a bool domain, or the values of a string domain. These
+    // point into schema_proto_.
+    StringDomainValues string_values;
+  };
+
+  // Validates the columns of a batch of num_examples examples, the first of
+  // which is example first_example of the batch.
+  void ValidateColumns(
+      const absl::flat_hash_map<string, FeatureColumn>& columns,
+      int64 num_examples, int64 first_example,
+      std::vector<uint8>* example_is_valid,
+      ExampleValidationCounters* counters) const;
+
+  // The schema, which the checks point into.
+  metadata::v0::Schema schema_proto_;
+  std::vector<FeatureCheck> checks_;
+  // The index of the check of each feature, by name.
+  absl::flat_hash_map<string, int> check_index_;
+  gtl::optional<string> environment_;
+  // Validates the statistics of GetAnomalies().
+  CompiledSchemaValidator validator_;
+  bool initialized_ = false;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_EXAMPLE_VALIDATOR_H_
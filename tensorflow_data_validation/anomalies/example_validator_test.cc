@@ -0,0 +1,257 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/example_validator.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow/core/example/example.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+// Serializes examples given as text protos.
+std::vector<string> SerializeExamples(
+    const std::vector<string>& text_examples) {
+  std::vector<string> result;
+  for (const string& text_example : text_examples) {
+    result.push_back(testing::ParseTextProtoOrDie<Example>(text_example)
+                         .SerializeAsString());
+  }
+  return result;
+}
+
+std::vector<absl::string_view> AsViews(const std::vector<string>& strings) {
+  return std::vector<absl::string_view>(strings.begin(), strings.end());
+}
+
+metadata::v0::Schema GetTestSchema() {
+  return testing::ParseTextProtoOrDie<metadata::v0::Schema>(R"(
+    feature {
+      name: "i"
+      type: INT
+      presence { min_fraction: 1 min_count: 1 }
+      value_count { min: 1 max: 2 }
+      int_domain { min: 0 max: 10 }
+    }
+    feature {
+      name: "f"
+      type: FLOAT
+      float_domain { min: 0 max: 1 }
+    }
+    feature {
+      name: "s"
+      type: BYTES
+      domain: "colors"
+    }
+    feature {
+      name: "b"
+      type: BYTES
+      bool_domain { true_value: "yes" false_value: "no" }
+    }
+    string_domain { name: "colors" value: [ "red", "blue" ] })");
+}
+
+TEST(ExampleValidatorTest, ValidatesEachExample) {
+  ExampleValidator validator;
+  TF_ASSERT_OK(
+      validator.Init(GetTestSchema(), gtl::nullopt, ValidationConfig()));
+  const std::vector<string> serialized = SerializeExamples({
+      // Valid.
+      R"(features {
+           feature { key: "i" value { int64_list { value: [3] } } }
+           feature { key: "f" value { float_list { value: [nan] } } }
+           feature { key: "s" value { bytes_list { value: ["red"] } } }
+           feature { key: "b" value { bytes_list { value: ["no"] } } }
+         })",
+      // Missing a required feature.
+      R"(features {
+           feature { key: "s" value { bytes_list { value: ["blue"] } } }
+         })",
+      // Too many values, one of which is outside the domain.
+      R"(features {
+           feature { key: "i" value { int64_list { value: [1, 2, 11] } } }
+         })",
+      // Outside the domains.
+      R"(features {
+           feature { key: "i" value { int64_list { value: [0] } } }
+           feature { key: "f" value { float_list { value: [1.5] } } }
+           feature { key: "s" value { bytes_list { value: ["green", "red"] } } }
+           feature { key: "b" value { bytes_list { value: ["maybe"] } } }
+         })",
+      // A feature that is not in the schema is not checked.
+      R"(features {
+           feature { key: "i" value { int64_list { value: [10] } } }
+           feature { key: "new" value { float_list { value: [1] } } }
+         })"});
+  std::vector<uint8> example_is_valid;
+  ExampleValidationCounters counters;
+  TF_ASSERT_OK(validator.ValidateBatch(AsViews(serialized), &example_is_valid,
+                                       &counters));
+  EXPECT_THAT(example_is_valid, ElementsAre(1, 0, 0, 0, 1));
+  EXPECT_EQ(5, counters.num_examples);
+  EXPECT_EQ(0, counters.num_unparsable_examples);
+  EXPECT_EQ(3, counters.num_invalid_examples);
+
+  const ExampleFeatureCounters& int_feature = counters.features.at("i");
+  EXPECT_EQ(4, int_feature.num_present);
+  EXPECT_EQ(1, int_feature.num_missing);
+  EXPECT_EQ(0, int_feature.num_too_few_values);
+  EXPECT_EQ(1, int_feature.num_too_many_values);
+  EXPECT_EQ(1, int_feature.num_out_of_domain);
+  EXPECT_EQ(1, int_feature.min_num_values);
+  EXPECT_EQ(3, int_feature.max_num_values);
+  EXPECT_EQ(6, int_feature.total_num_values);
+  EXPECT_EQ(0, int_feature.min_value);
+  EXPECT_EQ(11, int_feature.max_value);
+
+  const ExampleFeatureCounters& float_feature = counters.features.at("f");
+  EXPECT_EQ(1, float_feature.num_out_of_domain);
+  EXPECT_EQ(1.5, float_feature.min_value);
+
+  const ExampleFeatureCounters& string_feature = counters.features.at("s");
+  EXPECT_EQ(3, string_feature.num_present);
+  EXPECT_EQ(1, string_feature.num_out_of_domain);
+  EXPECT_THAT(string_feature.out_of_domain_values,
+              ElementsAre(Pair("green", 1)));
+
+  EXPECT_THAT(counters.features.at("b").out_of_domain_values,
+              ElementsAre(Pair("maybe", 1)));
+  EXPECT_EQ(1, counters.features.at("new").num_present);
+}
+
+TEST(ExampleValidatorTest, WrongTypeAndUnparsableExamples) {
+  ExampleValidator validator;
+  TF_ASSERT_OK(
+      validator.Init(GetTestSchema(), gtl::nullopt, ValidationConfig()));
+  std::vector<string> serialized = SerializeExamples({
+      R"(features {
+           feature { key: "i" value { int64_list { value: [3] } } }
+         })",
+      R"(features {
+           feature { key: "i" value { bytes_list { value: ["3"] } } }
+         })"});
+  serialized.push_back("\xff\xff not an example");
+  std::vector<uint8> example_is_valid;
+  ExampleValidationCounters counters;
+  TF_ASSERT_OK(validator.ValidateBatch(AsViews(serialized), &example_is_valid,
+                                       &counters));
+  EXPECT_THAT(example_is_valid, ElementsAre(1, 0, 0));
+  EXPECT_EQ(1, counters.num_unparsable_examples);
+  EXPECT_EQ(2, counters.num_invalid_examples);
+  const ExampleFeatureCounters& int_feature = counters.features.at("i");
+  EXPECT_EQ(2, int_feature.num_present);
+  EXPECT_EQ(1, int_feature.num_wrong_type);
+  EXPECT_EQ(FeatureColumn::Kind::kInt64, int_feature.kind);
+  EXPECT_EQ(FeatureColumn::Kind::kBytes, int_feature.wrong_kind);
+}
+
+TEST(ExampleValidatorTest, MergesCounters) {
+  ExampleValidator validator;
+  TF_ASSERT_OK(
+      validator.Init(GetTestSchema(), gtl::nullopt, ValidationConfig()));
+  const std::vector<string> first = SerializeExamples({
+      R"(features {
+           feature { key: "i" value { int64_list { value: [3] } } }
+           feature { key: "s" value { bytes_list { value: ["green"] } } }
+         })"});
+  const std::vector<string> second = SerializeExamples({
+      R"(features {
+           feature { key: "i" value { int64_list { value: [4, 5] } } }
+           feature {
+             key: "s"
+             value { bytes_list { value: ["green", "pink"] } }
+           }
+         })"});
+  ExampleValidationCounters counters;
+  TF_ASSERT_OK(validator.ValidateBatch(AsViews(first), nullptr, &counters));
+  ExampleValidationCounters other;
+  TF_ASSERT_OK(validator.ValidateBatch(AsViews(second), nullptr, &other));
+  counters.Merge(other);
+
+  EXPECT_EQ(2, counters.num_examples);
+  EXPECT_EQ(2, counters.num_invalid_examples);
+  const ExampleFeatureCounters& int_feature = counters.features.at("i");
+  EXPECT_EQ(2, int_feature.num_present);
+  EXPECT_EQ(1, int_feature.min_num_values);
+  EXPECT_EQ(2, int_feature.max_num_values);
+  EXPECT_EQ(3, int_feature.min_value);
+  EXPECT_EQ(5, int_feature.max_value);
+  EXPECT_THAT(counters.features.at("s").out_of_domain_values,
+              ElementsAre(Pair("green", 2), Pair("pink", 1)));
+}
+
+TEST(ExampleValidatorTest, GetAnomalies) {
+  ExampleValidator validator;
+  TF_ASSERT_OK(
+      validator.Init(GetTestSchema(), gtl::nullopt, ValidationConfig()));
+  const std::vector<string> serialized = SerializeExamples({
+      R"(features {
+           feature { key: "i" value { int64_list { value: [3] } } }
+           feature { key: "f" value { float_list { value: [0.5] } } }
+           feature { key: "s" value { bytes_list { value: ["green"] } } }
+         })",
+      R"(features {
+           feature { key: "i" value { int64_list { value: [4] } } }
+           feature { key: "s" value { bytes_list { value: ["red"] } } }
+         })"});
+  ExampleValidationCounters counters;
+  TF_ASSERT_OK(
+      validator.ValidateBatch(AsViews(serialized), nullptr, &counters));
+
+  const metadata::v0::DatasetFeatureStatistics statistics =
+      validator.GetStatistics(counters);
+  EXPECT_EQ(2, statistics.num_examples());
+  EXPECT_EQ(3, statistics.features_size());
+
+  metadata::v0::Anomalies anomalies;
+  TF_ASSERT_OK(validator.GetAnomalies(counters, &anomalies));
+  ASSERT_EQ(1, anomalies.anomaly_info().size());
+  const metadata::v0::AnomalyInfo& anomaly_info =
+      anomalies.anomaly_info().at("s");
+  ASSERT_EQ(1, anomaly_info.reason_size());
+  EXPECT_EQ(metadata::v0::AnomalyInfo::ENUM_TYPE_UNEXPECTED_STRING_VALUES,
+            anomaly_info.reason(0).type());
+
+  // Without examples of the required feature, it is reported missing.
+  metadata::v0::Anomalies no_examples;
+  TF_ASSERT_OK(
+      validator.GetAnomalies(ExampleValidationCounters(), &no_examples));
+  EXPECT_TRUE(no_examples.data_missing());
+}
+
+TEST(ExampleValidatorTest, NotInitialized) {
+  ExampleValidator validator;
+  ExampleValidationCounters counters;
+  EXPECT_FALSE(validator.ValidateBatch({}, nullptr, &counters).ok());
+  TF_ASSERT_OK(
+      validator.Init(GetTestSchema(), gtl::nullopt, ValidationConfig()));
+  EXPECT_FALSE(
+      validator.Init(GetTestSchema(), gtl::nullopt, ValidationConfig()).ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
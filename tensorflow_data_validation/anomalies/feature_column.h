@@ -0,0 +1,54 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// The values of a feature in a batch of examples, as produced by the native
+// decoders of example_batch_decoder.h and csv_batch_decoder.h.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_FEATURE_COLUMN_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_FEATURE_COLUMN_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// The values of a feature in a batch of examples.
+struct FeatureColumn {
+  // tf.Examples have kInt64, kFloat and kBytes values, and CSV files have
+  // kInt64, kDouble and kBytes values.
+  enum class Kind { kNone, kInt64, kFloat, kDouble, kBytes };
+
+  // The kind of the values, or kNone if no example has a list of values for
+  // the feature.
+  Kind kind = Kind::kNone;
+  // has_values[i] is 1 if example i has a list of values for the feature,
+  // and 0 if it does not have the feature or has a feature without a list.
+  std::vector<uint8> has_values;
+  // The values of example i are the values of the kind at indices
+  // [row_offsets[i], row_offsets[i + 1]). There are num_examples + 1 offsets.
+  std::vector<int64> row_offsets;
+  std::vector<int64> int64_values;
+  std::vector<float> float_values;
+  std::vector<double> double_values;
+  // Views of the decoded data, which must outlive them.
+  std::vector<absl::string_view> bytes_values;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_FEATURE_COLUMN_H_
@@ -15,16 +15,38 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/feature_statistics_validator.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "tensorflow_data_validation/anomalies/feature_util.h"
+#include "tensorflow_data_validation/anomalies/map_util.h"
+#include "tensorflow_data_validation/anomalies/metrics.h"
 #include "tensorflow_data_validation/anomalies/schema.h"
 #include "tensorflow_data_validation/anomalies/schema_anomalies.h"
+#include "tensorflow_data_validation/anomalies/statistics_parser.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
+#include "tensorflow_data_validation/anomalies/string_table.h"
+#include "tensorflow_data_validation/anomalies/validation_profiler.h"
+#include "tensorflow_data_validation/anomalies/wire_reader.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_metadata/proto/v0/schema.pb.h"
 
@@ -41,6 +63,15 @@ template<typename T>
   if (!opt) return absl::nullopt;
   return std::move(opt).value();
 }
+
+// Returns a non-owning pointer to statistics, so that the DatasetStatsViews
+// built from it share the caller's proto instead of copying it. All the views
+// built in this file are destroyed before the functions building them return.
+std::shared_ptr<const DatasetFeatureStatistics> Borrow(
+    const DatasetFeatureStatistics& statistics) {
+  return std::shared_ptr<const DatasetFeatureStatistics>(
+      std::shared_ptr<const DatasetFeatureStatistics>(), &statistics);
+}
 }
 
 FeatureStatisticsToProtoConfig GetDefaultFeatureStatisticsToProtoConfig() {
@@ -50,22 +81,38 @@ FeatureStatisticsToProtoConfig GetDefaultFeatureStatisticsToProtoConfig() {
 }
 
 
-tensorflow::Status InferSchema(const string& feature_statistics_proto_string,
-                               const int max_string_domain_size,
-                               string* schema_proto_string) {
-  tensorflow::metadata::v0::DatasetFeatureStatistics feature_statistics;
-  if (!feature_statistics.ParseFromString(feature_statistics_proto_string)) {
+namespace {
+
+// Parses a serialized DatasetFeatureStatistics proto.
+Status ParseStatistics(absl::string_view statistics_proto_string,
+                       DatasetFeatureStatistics* statistics) {
+  if (!statistics->ParseFromArray(statistics_proto_string.data(),
+                                  statistics_proto_string.size())) {
     return tensorflow::errors::InvalidArgument(
         "Failed to parse DatasetFeatureStatistics proto.");
   }
-  FeatureStatisticsToProtoConfig feature_statistics_to_proto_config;
-  feature_statistics_to_proto_config.set_enum_threshold(max_string_domain_size);
+  return Status::OK();
+}
+
+// Parses a serialized Schema proto.
+Status ParseSchema(absl::string_view schema_proto_string,
+                   metadata::v0::Schema* schema) {
+  if (!schema->ParseFromArray(schema_proto_string.data(),
+                              schema_proto_string.size())) {
+    return tensorflow::errors::InvalidArgument("Failed to parse Schema proto.");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+tensorflow::Status InferSchema(
+    absl::string_view feature_statistics_proto_string,
+    const int max_string_domain_size, string* schema_proto_string) {
   tensorflow::metadata::v0::Schema schema;
-  TF_RETURN_IF_ERROR(
-      UpdateSchema(feature_statistics_to_proto_config,
-                   schema, feature_statistics,
-                   /* paths_to_consider= */ gtl::nullopt,
-                   /* environment= */ gtl::nullopt, &schema));
+  TF_RETURN_IF_ERROR(InferSchema(feature_statistics_proto_string,
+                                 max_string_domain_size, /*num_threads=*/1,
+                                 &schema));
   if (!schema.SerializeToString(schema_proto_string)) {
     return tensorflow::errors::Internal(
         "Could not serialize Schema output proto to string.");
@@ -73,6 +120,514 @@ tensorflow::Status InferSchema(const string& feature_statistics_proto_string,
   return tensorflow::Status::OK();
 }
 
+Status InferSchema(absl::string_view feature_statistics_proto_string,
+                   const int max_string_domain_size, int num_threads,
+                   metadata::v0::Schema* schema) {
+  tensorflow::metadata::v0::DatasetFeatureStatistics feature_statistics;
+  TF_RETURN_IF_ERROR(
+      ParseStatistics(feature_statistics_proto_string, &feature_statistics));
+  FeatureStatisticsToProtoConfig feature_statistics_to_proto_config;
+  feature_statistics_to_proto_config.set_enum_threshold(max_string_domain_size);
+  feature_statistics_to_proto_config.set_num_threads(num_threads);
+  schema->Clear();
+  return UpdateSchemaInPlace(feature_statistics_to_proto_config,
+                             feature_statistics,
+                             /* paths_to_consider= */ gtl::nullopt,
+                             /* environment= */ gtl::nullopt, schema);
+}
+
+namespace {
+
+// Returns the FeatureStatisticsToProtoConfig used to validate statistics
+// with validation_config.
+FeatureStatisticsToProtoConfig GetValidationFeatureStatisticsToProtoConfig(
+    const ValidationConfig& validation_config) {
+  FeatureStatisticsToProtoConfig feature_statistics_to_proto_config;
+  feature_statistics_to_proto_config.set_enum_threshold(kDefaultEnumThreshold);
+  feature_statistics_to_proto_config.set_new_features_are_warnings(
+      validation_config.new_features_are_warnings());
+  *feature_statistics_to_proto_config.mutable_skew_thresholds() =
+      validation_config.skew_thresholds();
+  *feature_statistics_to_proto_config.mutable_drift_thresholds() =
+      validation_config.drift_thresholds();
+  feature_statistics_to_proto_config.set_max_values_in_description(
+      validation_config.max_values_in_description());
+  return feature_statistics_to_proto_config;
+}
+
+// Returns the view of feature_statistics to validate, weighted as by_weight,
+// along with the views of the previous and serving statistics, if any. The
+// view borrows all the statistics, which must outlive it.
+DatasetStatsView GetValidationView(
+    const DatasetFeatureStatistics& feature_statistics, bool by_weight,
+    const absl::optional<string>& maybe_environment,
+    const gtl::optional<DatasetFeatureStatistics>& prev_feature_statistics,
+    const gtl::optional<DatasetFeatureStatistics>& serving_feature_statistics) {
+  std::shared_ptr<DatasetStatsView> previous =
+      (prev_feature_statistics)
+          ? std::make_shared<DatasetStatsView>(
+                Borrow(prev_feature_statistics.value()), by_weight,
+                maybe_environment,
+                /* previous= */ nullptr,
+                /* serving= */ nullptr)
+          : nullptr;
+
+  std::shared_ptr<DatasetStatsView> serving =
+      (serving_feature_statistics)
+          ? std::make_shared<DatasetStatsView>(
+                Borrow(serving_feature_statistics.value()), by_weight,
+                maybe_environment,
+                /* previous= */ nullptr,
+                /* serving= */ nullptr)
+          : nullptr;
+
+  return DatasetStatsView(Borrow(feature_statistics), by_weight,
+                          maybe_environment, previous, serving);
+}
+
+// Same as above, but the statistics are weighted if they have weighted
+// statistics.
+DatasetStatsView GetValidationView(
+    const DatasetFeatureStatistics& feature_statistics,
+    const absl::optional<string>& maybe_environment,
+    const gtl::optional<DatasetFeatureStatistics>& prev_feature_statistics,
+    const gtl::optional<DatasetFeatureStatistics>& serving_feature_statistics) {
+  const bool by_weight =
+      DatasetStatsView(Borrow(feature_statistics), /*by_weight=*/false)
+          .WeightedStatisticsExist();
+  return GetValidationView(feature_statistics, by_weight, maybe_environment,
+                           prev_feature_statistics, serving_feature_statistics);
+}
+
+// Finds the anomalies of feature_statistics (which must have examples)
+// against the baseline of *schema_anomalies.
+Status FindChangesAgainstBaseline(
+    const DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    const gtl::optional<DatasetFeatureStatistics>& prev_feature_statistics,
+    const gtl::optional<DatasetFeatureStatistics>& serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config, ValidationProfiler* profiler,
+    SchemaAnomalies* schema_anomalies) {
+  const absl::optional<string> maybe_environment =
+      environment ? absl::optional<string>(*environment)
+                  : absl::optional<string>();
+  schema_anomalies->set_profiler(profiler);
+  absl::optional<DatasetStatsView> training;
+  {
+    ScopedPhaseTimer timer(profiler, ValidationPhase::kViewConstruction);
+    training.emplace(GetValidationView(feature_statistics, maybe_environment,
+                                       prev_feature_statistics,
+                                       serving_feature_statistics));
+  }
+  return schema_anomalies->FindChanges(
+      *training, ToAbslOptional(features_needed),
+      GetValidationFeatureStatisticsToProtoConfig(validation_config),
+      validation_config.num_threads());
+}
+
+// Same as ValidateFeatureStatistics(), but validates against a baseline
+// schema that has already been initialized, so that it can be shared by
+// several validations. The time of validation is recorded in profiler, if it
+// is not null.
+Status ValidateFeatureStatisticsAgainstBaseline(
+    const DatasetFeatureStatistics& feature_statistics,
+    const std::shared_ptr<const Schema>& baseline,
+    const gtl::optional<string>& environment,
+    const gtl::optional<DatasetFeatureStatistics>& prev_feature_statistics,
+    const gtl::optional<DatasetFeatureStatistics>& serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config, ValidationProfiler* profiler,
+    tensorflow::metadata::v0::Anomalies* result) {
+  if (feature_statistics.num_examples() == 0) {
+    *result->mutable_baseline() = baseline->GetSchema();
+    result->set_data_missing(true);
+  } else {
+    SchemaAnomalies schema_anomalies(baseline);
+    TF_RETURN_IF_ERROR(FindChangesAgainstBaseline(
+        feature_statistics, environment, prev_feature_statistics,
+        serving_feature_statistics, features_needed, validation_config,
+        profiler, &schema_anomalies));
+    schema_anomalies.GetSchemaDiff(result);
+  }
+
+  return tensorflow::Status::OK();
+}
+
+// Same as ValidateFeatureStatisticsAgainstBaseline(), but writes the schema
+// diff to sink (see SchemaAnomalies::WriteSchemaDiff()).
+Status ValidateFeatureStatisticsAgainstBaselineToSink(
+    const DatasetFeatureStatistics& feature_statistics,
+    const std::shared_ptr<const Schema>& baseline,
+    const gtl::optional<string>& environment,
+    const gtl::optional<DatasetFeatureStatistics>& prev_feature_statistics,
+    const gtl::optional<DatasetFeatureStatistics>& serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config, bool include_baseline,
+    AnomalySink* sink) {
+  if (feature_statistics.num_examples() == 0) {
+    tensorflow::metadata::v0::Anomalies header;
+    if (include_baseline) {
+      *header.mutable_baseline() = baseline->GetSchema();
+    }
+    header.set_data_missing(true);
+    return sink->WriteHeader(header);
+  }
+  SchemaAnomalies schema_anomalies(baseline);
+  TF_RETURN_IF_ERROR(FindChangesAgainstBaseline(
+      feature_statistics, environment, prev_feature_statistics,
+      serving_feature_statistics, features_needed, validation_config,
+      /*profiler=*/nullptr, &schema_anomalies));
+  return schema_anomalies.WriteSchemaDiff(include_baseline, sink);
+}
+
+// Adds to domain_names the names of the string domains used by feature and
+// its descendants.
+void GetStringDomainNames(const metadata::v0::Feature& feature,
+                          std::set<string>* domain_names) {
+  if (feature.domain_info_case() == metadata::v0::Feature::kDomain) {
+    domain_names->insert(feature.domain());
+  }
+  for (const metadata::v0::Feature& child :
+       feature.struct_domain().feature()) {
+    GetStringDomainNames(child, domain_names);
+  }
+}
+
+// Returns a fingerprint of a feature (or sparse feature) entry of a schema,
+// along with the string domains of the schema named in domain_names.
+uint64 GetSchemaEntryFingerprint(const string& serialized_entry,
+                                 const std::set<string>& domain_names,
+                                 const metadata::v0::Schema& schema_proto) {
+  uint64 fingerprint = Hash64(serialized_entry);
+  for (const metadata::v0::StringDomain& string_domain :
+       schema_proto.string_domain()) {
+    if (ContainsKey(domain_names, string_domain.name())) {
+      fingerprint = Hash64Combine(fingerprint,
+                                  Hash64(string_domain.SerializeAsString()));
+    }
+  }
+  return fingerprint;
+}
+
+// Returns a fingerprint of the statistics of feature and its descendants,
+// along with their previous and serving statistics.
+uint64 GetStatisticsFingerprint(const FeatureStatsView& feature) {
+  // Distinguishes missing previous or serving statistics from any others.
+  const uint64 kMissing = 0x9e3779b97f4a7c15ULL;
+  uint64 fingerprint = feature.GetFingerprint();
+  const absl::optional<FeatureStatsView> previous = feature.GetPrevious();
+  fingerprint = Hash64Combine(
+      fingerprint, previous ? previous->GetFingerprint() : kMissing);
+  const absl::optional<FeatureStatsView> serving = feature.GetServing();
+  fingerprint = Hash64Combine(
+      fingerprint, serving ? serving->GetFingerprint() : kMissing);
+  for (const FeatureStatsView& child : feature.GetChildrenRange()) {
+    fingerprint = Hash64Combine(fingerprint, GetStatisticsFingerprint(child));
+  }
+  return fingerprint;
+}
+
+// Returns a fingerprint of the number of examples in statistics, if any.
+uint64 GetNumExamplesFingerprint(
+    const gtl::optional<DatasetFeatureStatistics>& statistics) {
+  if (!statistics) {
+    return 0;
+  }
+  uint64 fingerprint = Hash64Combine(1, statistics->num_examples());
+  double weighted_num_examples = statistics->weighted_num_examples();
+  uint64 weighted_bits;
+  static_assert(sizeof(weighted_bits) == sizeof(weighted_num_examples),
+                "double is not 64 bits");
+  memcpy(&weighted_bits, &weighted_num_examples, sizeof(weighted_bits));
+  return Hash64Combine(fingerprint, weighted_bits);
+}
+
+// Adds to names the names in the statistics of features and their
+// descendants that have a comparator of comparator_type. The name of a child
+// of a struct is the name of the struct, followed by a period and the name of
+// the child.
+void GetComparedFeatureNames(
+    const string& prefix,
+    const protobuf::RepeatedPtrField<metadata::v0::Feature>& features,
+    ComparatorType comparator_type, std::set<string>* names) {
+  for (const metadata::v0::Feature& feature : features) {
+    const string name = prefix + feature.name();
+    if (FeatureHasComparator(feature, comparator_type)) {
+      names->insert(name);
+    }
+    GetComparedFeatureNames(name + ".", feature.struct_domain().feature(),
+                            comparator_type, names);
+  }
+}
+
+// Returns a filter for the features of statistics that are compared to the
+// statistics being validated with comparators of comparator_type in schema.
+// Structs are always kept, since the paths of the other features depend on
+// them.
+FeatureFilter GetComparedFeatureFilter(const metadata::v0::Schema& schema,
+                                       ComparatorType comparator_type) {
+  auto names = std::make_shared<std::set<string>>();
+  GetComparedFeatureNames("", schema.feature(), comparator_type, names.get());
+  return [names](absl::string_view name,
+                 metadata::v0::FeatureNameStatistics::Type type) {
+    return type == metadata::v0::FeatureNameStatistics::STRUCT ||
+           ContainsKey(*names, string(name));
+  };
+}
+
+// Moves the schema diff of each slice into (*results)[names[i]]. Returns
+// InvalidArgument if two slices have the same name.
+Status CollectSliceAnomalies(
+    const std::vector<string>& names,
+    std::vector<metadata::v0::Anomalies>* anomalies,
+    std::map<string, metadata::v0::Anomalies>* results) {
+  results->clear();
+  for (size_t i = 0; i < names.size(); ++i) {
+    const auto inserted =
+        results->emplace(names[i], metadata::v0::Anomalies());
+    if (!inserted.second) {
+      return errors::InvalidArgument("Duplicate slice name: ", names[i]);
+    }
+    inserted.first->second.Swap(&(*anomalies)[i]);
+  }
+  return Status::OK();
+}
+
+// Calls fn(i) for each i in [0, n) on a pool of num_threads threads, or on the
+// calling thread if num_threads <= 1. Returns the first error in order of i.
+Status RunInParallel(int n, int num_threads,
+                     const std::function<Status(int)>& fn) {
+  std::vector<Status> statuses(n);
+  if (num_threads <= 1 || n <= 1) {
+    for (int i = 0; i < n; ++i) {
+      statuses[i] = fn(i);
+    }
+  } else {
+    // The destructor of the pool waits for all the work to finish.
+    thread::ThreadPool pool(Env::Default(), "validate_batch",
+                            std::min(num_threads, n));
+    for (int i = 0; i < n; ++i) {
+      pool.Schedule([&fn, &statuses, i]() { statuses[i] = fn(i); });
+    }
+  }
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  return Status::OK();
+}
+
+// Same as ValidateFeatureStatisticsAgainstBaseline(), but validates both the
+// unweighted and the weighted statistics, into unweighted_result and
+// weighted_result. The two views share the index of the features, and the
+// two validations run concurrently, each on half of the threads, if
+// validation_config.num_threads() > 1.
+Status ValidateWeightedAndUnweightedAgainstBaseline(
+    const DatasetFeatureStatistics& feature_statistics,
+    const std::shared_ptr<const Schema>& baseline,
+    const gtl::optional<string>& environment,
+    const gtl::optional<DatasetFeatureStatistics>& prev_feature_statistics,
+    const gtl::optional<DatasetFeatureStatistics>& serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* unweighted_result,
+    metadata::v0::Anomalies* weighted_result) {
+  if (feature_statistics.num_examples() == 0) {
+    for (metadata::v0::Anomalies* result :
+         {unweighted_result, weighted_result}) {
+      *result->mutable_baseline() = baseline->GetSchema();
+      result->set_data_missing(true);
+    }
+    return Status::OK();
+  }
+  const absl::optional<string> maybe_environment =
+      environment ? absl::optional<string>(*environment)
+                  : absl::optional<string>();
+  const DatasetStatsView unweighted = GetValidationView(
+      feature_statistics, /*by_weight=*/false, maybe_environment,
+      prev_feature_statistics, serving_feature_statistics);
+  if (!unweighted.WeightedStatisticsExist()) {
+    return tensorflow::errors::InvalidArgument(
+        "The statistics have no weighted statistics.");
+  }
+  const DatasetStatsView weighted = unweighted.WithByWeight(true);
+  const DatasetStatsView* const views[] = {&unweighted, &weighted};
+  metadata::v0::Anomalies* const results[] = {unweighted_result,
+                                              weighted_result};
+  const FeatureStatisticsToProtoConfig feature_statistics_to_proto_config =
+      GetValidationFeatureStatisticsToProtoConfig(validation_config);
+  const int num_threads = validation_config.num_threads();
+  return RunInParallel(2, num_threads, [&](int i) {
+    SchemaAnomalies schema_anomalies(baseline);
+    TF_RETURN_IF_ERROR(schema_anomalies.FindChanges(
+        *views[i], ToAbslOptional(features_needed),
+        feature_statistics_to_proto_config, std::max(1, num_threads / 2)));
+    schema_anomalies.GetSchemaDiff(results[i]);
+    return Status::OK();
+  });
+}
+
+// Returns how far distances are above the thresholds of a drift comparator
+// (see UpdateFeatureComparatorDirect()), relative to them: the largest ratio
+// of a distance that is checked to its threshold, or 0 if none is checked.
+double GetDriftScore(const DistributionDistances& distances,
+                     const metadata::v0::FeatureComparator& comparator,
+                     const DistributionDistanceThresholds& thresholds) {
+  const auto ratio = [](double distance, double threshold) {
+    if (threshold > 0.0) {
+      return distance / threshold;
+    }
+    return distance > 0.0 ? std::numeric_limits<double>::infinity() : 0.0;
+  };
+  double score = 0.0;
+  if (comparator.infinity_norm().has_threshold()) {
+    score = std::max(score, ratio(distances.l_infty,
+                                  comparator.infinity_norm().threshold()));
+  }
+  if (thresholds.jensen_shannon_divergence() > 0.0) {
+    score = std::max(score, ratio(distances.jensen_shannon_divergence,
+                                  thresholds.jensen_shannon_divergence()));
+  }
+  if (thresholds.population_stability_index() > 0.0) {
+    score = std::max(score, ratio(distances.population_stability_index,
+                                  thresholds.population_stability_index()));
+  }
+  return score;
+}
+
+// Adds the statistics of the ancestors of feature to statistics, along with
+// their paths to paths, except for those already in paths.
+void AddAncestorStatistics(const FeatureStatsView& feature,
+                           std::set<Path>* paths,
+                           DatasetFeatureStatistics* statistics) {
+  const absl::optional<FeatureStatsView> parent = feature.GetParent();
+  if (!parent) {
+    return;
+  }
+  if (paths->insert(parent->GetPath()).second) {
+    *statistics->add_features() = parent->feature_name_statistics();
+  }
+  AddAncestorStatistics(*parent, paths, statistics);
+}
+
+// Same as ValidateFeatureStatisticsAgainstBaseline(), but checks drift
+// against the worst span of prev_feature_statistics_window for each feature
+// (see ValidateFeatureStatisticsWithDriftWindow()). Only the drift
+// comparators read the previous statistics, so the statistics of the worst
+// span of each feature are gathered into a single previous statistics,
+// which are then validated against as usual.
+Status ValidateWithDriftWindowAgainstBaseline(
+    const DatasetFeatureStatistics& feature_statistics,
+    const std::shared_ptr<const Schema>& baseline,
+    const gtl::optional<string>& environment,
+    const std::vector<DatasetFeatureStatistics>& prev_feature_statistics_window,
+    const gtl::optional<DatasetFeatureStatistics>& serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* result, std::map<Path, int>* worst_spans) {
+  if (worst_spans != nullptr) {
+    worst_spans->clear();
+  }
+  if (feature_statistics.num_examples() == 0 ||
+      prev_feature_statistics_window.empty()) {
+    return ValidateFeatureStatisticsAgainstBaseline(
+        feature_statistics, baseline, environment,
+        /*prev_feature_statistics=*/gtl::nullopt, serving_feature_statistics,
+        features_needed, validation_config, /*profiler=*/nullptr, result);
+  }
+  const absl::optional<string> maybe_environment =
+      environment ? absl::optional<string>(*environment)
+                  : absl::optional<string>();
+  // The current statistics are indexed once, and their string values are
+  // computed once for all the spans, as the views of the spans share them.
+  const DatasetStatsView current = GetValidationView(
+      feature_statistics, maybe_environment,
+      /*prev_feature_statistics=*/gtl::nullopt, serving_feature_statistics);
+  std::vector<FeatureStatsView> compared;
+  std::vector<const metadata::v0::FeatureComparator*> comparators;
+  for (const FeatureStatsView& feature : current.features_range()) {
+    const metadata::v0::FeatureComparator* comparator =
+        feature.GetPath().empty()
+            ? nullptr
+            : baseline->FindComparator(feature.GetPath(),
+                                       ComparatorType::DRIFT);
+    if (comparator != nullptr) {
+      compared.push_back(feature);
+      comparators.push_back(comparator);
+    }
+  }
+
+  const int num_spans = prev_feature_statistics_window.size();
+  std::vector<DatasetStatsView> spans;
+  spans.reserve(num_spans);
+  for (const DatasetFeatureStatistics& span : prev_feature_statistics_window) {
+    spans.emplace_back(Borrow(span), current.by_weight(), maybe_environment,
+                       /* previous= */ nullptr, /* serving= */ nullptr);
+  }
+  // scores[i][j] is the drift score of compared[j] against span i, or -1 if
+  // the feature is missing from the span.
+  std::vector<std::vector<double>> scores(num_spans);
+  TF_RETURN_IF_ERROR(RunInParallel(
+      num_spans, validation_config.num_threads(), [&](int i) {
+        scores[i].resize(compared.size(), -1.0);
+        for (size_t j = 0; j < compared.size(); ++j) {
+          const absl::optional<FeatureStatsView> previous =
+              spans[i].GetByPath(compared[j].GetPath());
+          if (previous) {
+            scores[i][j] = GetDriftScore(
+                GetDistributionDistances(compared[j], *previous),
+                *comparators[j], validation_config.drift_thresholds());
+          }
+        }
+        return Status::OK();
+      }));
+
+  // The previous statistics of each compared feature are those of its worst
+  // span, the first one on ties. The structs above it are taken from the
+  // current statistics, which gives it the same path.
+  DatasetFeatureStatistics previous;
+  previous.set_num_examples(prev_feature_statistics_window[0].num_examples());
+  previous.set_weighted_num_examples(
+      prev_feature_statistics_window[0].weighted_num_examples());
+  std::set<Path> paths;
+  for (size_t j = 0; j < compared.size(); ++j) {
+    int worst = -1;
+    for (int i = 0; i < num_spans; ++i) {
+      if (scores[i][j] >= 0.0 &&
+          (worst < 0 || scores[i][j] > scores[worst][j])) {
+        worst = i;
+      }
+    }
+    if (worst >= 0 && paths.insert(compared[j].GetPath()).second) {
+      *previous.add_features() =
+          spans[worst]
+              .GetByPath(compared[j].GetPath())
+              ->feature_name_statistics();
+      if (worst_spans != nullptr) {
+        (*worst_spans)[compared[j].GetPath()] = worst;
+      }
+    }
+  }
+  for (const FeatureStatsView& feature : compared) {
+    if (ContainsKey(paths, feature.GetPath())) {
+      AddAncestorStatistics(feature, &paths, &previous);
+    }
+  }
+
+  SchemaAnomalies schema_anomalies(baseline);
+  TF_RETURN_IF_ERROR(schema_anomalies.FindChanges(
+      current.WithPrevious(std::make_shared<DatasetStatsView>(
+          Borrow(previous), current.by_weight(), maybe_environment,
+          /* previous= */ nullptr, /* serving= */ nullptr)),
+      ToAbslOptional(features_needed),
+      GetValidationFeatureStatisticsToProtoConfig(validation_config),
+      validation_config.num_threads()));
+  schema_anomalies.GetSchemaDiff(result);
+  return Status::OK();
+}
+
+}  // namespace
+
 tensorflow::Status ValidateFeatureStatistics(
     const tensorflow::metadata::v0::DatasetFeatureStatistics&
         feature_statistics,
@@ -87,103 +642,218 @@ tensorflow::Status ValidateFeatureStatistics(
     const gtl::optional<FeaturesNeeded>& features_needed,
     const ValidationConfig& validation_config,
     tensorflow::metadata::v0::Anomalies* result) {
-  const absl::optional<string> maybe_environment =
-      environment ? absl::optional<string>(*environment)
-                  : absl::optional<string>();
-  FeatureStatisticsToProtoConfig feature_statistics_to_proto_config;
-  feature_statistics_to_proto_config.set_enum_threshold(kDefaultEnumThreshold);
-  feature_statistics_to_proto_config.set_new_features_are_warnings(
-      validation_config.new_features_are_warnings());
-  const bool by_weight =
-      DatasetStatsView(feature_statistics).WeightedStatisticsExist();
-  if (feature_statistics.num_examples() == 0) {
-    *result->mutable_baseline() = schema_proto;
-    result->set_data_missing(true);
-  } else {
-    SchemaAnomalies schema_anomalies(schema_proto);
-    std::shared_ptr<DatasetStatsView> previous =
-        (prev_feature_statistics)
-            ? std::make_shared<DatasetStatsView>(
-                  prev_feature_statistics.value(), by_weight, maybe_environment,
-                  /* previous= */ nullptr,
-                  /* serving= */ nullptr)
-            : nullptr;
-
-    std::shared_ptr<DatasetStatsView> serving =
-        (serving_feature_statistics) ? std::make_shared<DatasetStatsView>(
-                                           serving_feature_statistics.value(),
-                                           by_weight, maybe_environment,
-                                           /* previous= */ nullptr,
-                                           /* serving= */ nullptr)
-                                     : nullptr;
-
-    const DatasetStatsView training = DatasetStatsView(
-        feature_statistics, by_weight, maybe_environment, previous, serving);
-    TF_RETURN_IF_ERROR(
-        schema_anomalies.FindChanges(training, ToAbslOptional(features_needed),
-                                     feature_statistics_to_proto_config));
-    *result = schema_anomalies.GetSchemaDiff();
-  }
+  return ValidateFeatureStatistics(
+      feature_statistics, schema_proto, environment, prev_feature_statistics,
+      serving_feature_statistics, features_needed, validation_config, result,
+      /*profile=*/nullptr);
+}
 
-  return tensorflow::Status::OK();
+Status ValidateFeatureStatistics(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* result, ValidationProfile* profile) {
+  // Even for a single validation, the precomputed StringDomain values are
+  // shared by all the features that use the same StringDomain.
+  CompiledSchemaValidator validator;
+  TF_RETURN_IF_ERROR(validator.Init(schema_proto, validation_config));
+  return validator.Validate(feature_statistics, environment,
+                            prev_feature_statistics,
+                            serving_feature_statistics, features_needed,
+                            result, profile);
+}
+
+Status ValidateFeatureStatisticsToSink(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config, bool include_baseline,
+    AnomalySink* sink) {
+  CompiledSchemaValidator validator;
+  TF_RETURN_IF_ERROR(validator.Init(schema_proto, validation_config));
+  return validator.ValidateToSink(feature_statistics, environment,
+                                  prev_feature_statistics,
+                                  serving_feature_statistics, features_needed,
+                                  include_baseline, sink);
+}
+
+Status ValidateFeatureStatisticsWeightedAndUnweighted(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* unweighted_result,
+    metadata::v0::Anomalies* weighted_result) {
+  CompiledSchemaValidator validator;
+  TF_RETURN_IF_ERROR(validator.Init(schema_proto, validation_config));
+  return validator.ValidateWeightedAndUnweighted(
+      feature_statistics, environment, prev_feature_statistics,
+      serving_feature_statistics, features_needed, unweighted_result,
+      weighted_result);
+}
+
+Status ValidateFeatureStatisticsWithDriftWindow(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const std::vector<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics_window,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* result, std::map<Path, int>* worst_spans) {
+  CompiledSchemaValidator validator;
+  TF_RETURN_IF_ERROR(validator.Init(schema_proto, validation_config));
+  return validator.ValidateWithDriftWindow(
+      feature_statistics, environment, prev_feature_statistics_window,
+      serving_feature_statistics, features_needed, result, worst_spans);
+}
+
+Status ValidateFeatureStatisticsBatch(
+    const std::vector<DatasetFeatureStatistics>& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const ValidationConfig& validation_config,
+    std::vector<metadata::v0::Anomalies>* results) {
+  // The statistics are already validated in parallel, so each of them is
+  // validated on a single thread.
+  ValidationConfig item_config = validation_config;
+  item_config.set_num_threads(1);
+  CompiledSchemaValidator validator;
+  TF_RETURN_IF_ERROR(validator.Init(schema_proto, item_config));
+  results->clear();
+  results->resize(feature_statistics.size());
+  return RunInParallel(
+      feature_statistics.size(), validation_config.num_threads(),
+      [&](int i) {
+        return validator.Validate(
+            feature_statistics[i], environment,
+            /*prev_feature_statistics=*/gtl::nullopt,
+            /*serving_feature_statistics=*/gtl::nullopt,
+            /*features_needed=*/gtl::nullopt, &(*results)[i]);
+      });
 }
 
 tensorflow::Status ValidateFeatureStatistics(
-    const string& feature_statistics_proto_string,
-    const string& schema_proto_string, const string& environment,
-    const string& previous_statistics_proto_string,
-    const string& serving_statistics_proto_string,
+    absl::string_view feature_statistics_proto_string,
+    absl::string_view schema_proto_string, absl::string_view environment,
+    absl::string_view previous_statistics_proto_string,
+    absl::string_view serving_statistics_proto_string,
     string* anomalies_proto_string) {
-  tensorflow::metadata::v0::Schema schema;
-  if (!schema.ParseFromString(schema_proto_string)) {
-    return tensorflow::errors::InvalidArgument("Failed to parse Schema proto.");
+  tensorflow::metadata::v0::Anomalies anomalies;
+  TF_RETURN_IF_ERROR(ValidateFeatureStatistics(
+      feature_statistics_proto_string, schema_proto_string, environment,
+      previous_statistics_proto_string, serving_statistics_proto_string,
+      &anomalies));
+  if (!anomalies.SerializeToString(anomalies_proto_string)) {
+    return tensorflow::errors::Internal(
+        "Could not serialize Anomalies output proto to string.");
   }
+  return tensorflow::Status::OK();
+}
+
+Status ValidateFeatureStatistics(
+    absl::string_view feature_statistics_proto_string,
+    absl::string_view schema_proto_string, absl::string_view environment,
+    absl::string_view previous_statistics_proto_string,
+    absl::string_view serving_statistics_proto_string,
+    metadata::v0::Anomalies* anomalies) {
+  tensorflow::metadata::v0::Schema schema;
+  TF_RETURN_IF_ERROR(ParseSchema(schema_proto_string, &schema));
 
   tensorflow::metadata::v0::DatasetFeatureStatistics feature_statistics;
-  if (!feature_statistics.ParseFromString(feature_statistics_proto_string)) {
-    return tensorflow::errors::InvalidArgument(
-        "Failed to parse DatasetFeatureStatistics proto.");
-  }
+  TF_RETURN_IF_ERROR(
+      ParseStatistics(feature_statistics_proto_string, &feature_statistics));
 
+  // Only the features with a drift (or skew) comparator are looked up in the
+  // previous (or serving) statistics, so the others are not parsed.
   tensorflow::gtl::optional<tensorflow::metadata::v0::DatasetFeatureStatistics>
-      previous_statistics = tensorflow::gtl::nullopt;
+      previous_statistics;
   if (!previous_statistics_proto_string.empty()) {
-    tensorflow::metadata::v0::DatasetFeatureStatistics tmp_stats;
-    if (!tmp_stats.ParseFromString(previous_statistics_proto_string)) {
-      return tensorflow::errors::InvalidArgument(
-          "Failed to parse DatasetFeatureStatistics proto.");
-    }
-    previous_statistics = tmp_stats;
+    previous_statistics.emplace();
+    TF_RETURN_IF_ERROR(ParseStatisticsOfFeatures(
+        previous_statistics_proto_string,
+        GetComparedFeatureFilter(schema, ComparatorType::DRIFT),
+        &*previous_statistics));
   }
 
   tensorflow::gtl::optional<tensorflow::metadata::v0::DatasetFeatureStatistics>
-      serving_statistics = tensorflow::gtl::nullopt;
+      serving_statistics;
   if (!serving_statistics_proto_string.empty()) {
-    tensorflow::metadata::v0::DatasetFeatureStatistics tmp_stats;
-    if (!tmp_stats.ParseFromString(serving_statistics_proto_string)) {
-      return tensorflow::errors::InvalidArgument(
-          "Failed to parse DatasetFeatureStatistics proto.");
-    }
-    serving_statistics = tmp_stats;
+    serving_statistics.emplace();
+    TF_RETURN_IF_ERROR(ParseStatisticsOfFeatures(
+        serving_statistics_proto_string,
+        GetComparedFeatureFilter(schema, ComparatorType::SKEW),
+        &*serving_statistics));
   }
 
   tensorflow::gtl::optional<string> may_be_environment =
       tensorflow::gtl::nullopt;
   if (!environment.empty()) {
-    may_be_environment = environment;
+    may_be_environment = string(environment);
   }
 
-  tensorflow::metadata::v0::Anomalies anomalies;
-  TF_RETURN_IF_ERROR(ValidateFeatureStatistics(
+  return ValidateFeatureStatistics(
       feature_statistics, schema, may_be_environment, previous_statistics,
       serving_statistics, /*features_needed=*/gtl::nullopt, ValidationConfig(),
-      &anomalies));
+      anomalies);
+}
 
-  if (!anomalies.SerializeToString(anomalies_proto_string)) {
-    return tensorflow::errors::Internal(
-        "Could not serialize Anomalies output proto to string.");
-  }
-  return tensorflow::Status::OK();
+Status ValidateFeatureStatisticsBatch(
+    const std::vector<string>& feature_statistics_proto_strings,
+    absl::string_view schema_proto_string, absl::string_view environment,
+    int num_threads, std::vector<string>* anomalies_proto_strings) {
+  std::vector<metadata::v0::Anomalies> results;
+  TF_RETURN_IF_ERROR(ValidateFeatureStatisticsBatch(
+      std::vector<absl::string_view>(feature_statistics_proto_strings.begin(),
+                                     feature_statistics_proto_strings.end()),
+      schema_proto_string, environment, num_threads, &results));
+  // Serializing is also done in parallel.
+  anomalies_proto_strings->clear();
+  anomalies_proto_strings->resize(results.size());
+  return RunInParallel(results.size(), num_threads, [&](int i) {
+    if (!results[i].SerializeToString(&(*anomalies_proto_strings)[i])) {
+      return tensorflow::errors::Internal(
+          "Could not serialize Anomalies output proto to string.");
+    }
+    return Status::OK();
+  });
+}
+
+Status ValidateFeatureStatisticsBatch(
+    const std::vector<absl::string_view>& feature_statistics_proto_strings,
+    absl::string_view schema_proto_string, absl::string_view environment,
+    int num_threads, std::vector<metadata::v0::Anomalies>* results) {
+  CompiledSchemaValidator validator;
+  TF_RETURN_IF_ERROR(validator.Init(schema_proto_string, ValidationConfig()));
+
+  // Parsing is done inside each task, so that it also runs in parallel.
+  results->clear();
+  results->resize(feature_statistics_proto_strings.size());
+  return RunInParallel(
+      feature_statistics_proto_strings.size(), num_threads, [&](int i) {
+        return validator.Validate(
+            feature_statistics_proto_strings[i], environment,
+            /*previous_statistics_proto_string=*/"",
+            /*serving_statistics_proto_string=*/"", &(*results)[i]);
+      });
 }
 
 tensorflow::Status UpdateSchema(
@@ -194,28 +864,504 @@ tensorflow::Status UpdateSchema(
     const gtl::optional<std::vector<Path>>& paths_to_consider,
     const gtl::optional<string>& environment,
     tensorflow::metadata::v0::Schema* result) {
+  // The copy is updated, so that *result is untouched on an error, and
+  // schema_to_update may be *result.
+  tensorflow::metadata::v0::Schema schema = schema_to_update;
+  TF_RETURN_IF_ERROR(UpdateSchemaInPlace(feature_statistics_to_proto_config,
+                                         feature_statistics, paths_to_consider,
+                                         environment, &schema));
+  *result = std::move(schema);
+  return tensorflow::Status::OK();
+}
+
+tensorflow::Status UpdateSchemaInPlace(
+    const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
+    const tensorflow::metadata::v0::DatasetFeatureStatistics&
+        feature_statistics,
+    const gtl::optional<std::vector<Path>>& paths_to_consider,
+    const gtl::optional<string>& environment,
+    tensorflow::metadata::v0::Schema* schema_proto) {
   const absl::optional<string> maybe_environment =
       environment ? absl::optional<string>(*environment) : absl::nullopt;
 
   const bool by_weight =
-      DatasetStatsView(feature_statistics).WeightedStatisticsExist();
+      DatasetStatsView(Borrow(feature_statistics), /*by_weight=*/false)
+          .WeightedStatisticsExist();
+  // The proto is moved into the schema, and back out of it when done.
   Schema schema;
-  TF_RETURN_IF_ERROR(schema.Init(schema_to_update));
+  TF_RETURN_IF_ERROR(schema.Init(std::move(*schema_proto)));
+  const DatasetStatsView view(Borrow(feature_statistics), by_weight,
+                              maybe_environment,
+                              /* previous= */ nullptr,
+                              /* serving= */ nullptr);
+  tensorflow::Status status;
   if (paths_to_consider) {
-    TF_RETURN_IF_ERROR(schema.Update(
-        DatasetStatsView(feature_statistics, by_weight, maybe_environment,
-                         /* previous= */ nullptr,
-                         /* serving= */ nullptr),
-        feature_statistics_to_proto_config, *paths_to_consider));
+    status = schema.Update(view, feature_statistics_to_proto_config,
+                           *paths_to_consider);
   } else {
-    TF_RETURN_IF_ERROR(schema.Update(
-        DatasetStatsView(feature_statistics, by_weight, maybe_environment,
-                         /* previous= */ nullptr,
-                         /* serving= */ nullptr),
-        feature_statistics_to_proto_config));
+    status = schema.Update(view, feature_statistics_to_proto_config);
   }
-  *result = schema.GetSchema();
-  return tensorflow::Status::OK();
+  schema.ReleaseSchema(schema_proto);
+  return status;
+}
+
+Status CompiledSchemaValidator::Init(
+    const metadata::v0::Schema& schema_proto,
+    const ValidationConfig& validation_config) {
+  return Init(schema_proto, validation_config, /*image=*/nullptr);
+}
+
+Status CompiledSchemaValidator::Init(
+    std::shared_ptr<const CompiledSchemaImage> image,
+    const ValidationConfig& validation_config) {
+  if (image == nullptr) {
+    return tensorflow::errors::InvalidArgument(
+        "CompiledSchemaValidator::Init() called without an image.");
+  }
+  metadata::v0::Schema schema_proto;
+  TF_RETURN_IF_ERROR(ParseSchema(image->schema_proto_string(), &schema_proto));
+  return Init(std::move(schema_proto), validation_config, std::move(image));
+}
+
+Status CompiledSchemaValidator::Init(
+    metadata::v0::Schema schema_proto,
+    const ValidationConfig& validation_config,
+    std::shared_ptr<const CompiledSchemaImage> image) {
+  if (baseline_ != nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::Init() called twice.");
+  }
+  // The filters are computed first, so that the proto can be moved into the
+  // schema.
+  drift_feature_filter_ =
+      GetComparedFeatureFilter(schema_proto, ComparatorType::DRIFT);
+  skew_feature_filter_ =
+      GetComparedFeatureFilter(schema_proto, ComparatorType::SKEW);
+  auto baseline = std::make_shared<Schema>();
+  TF_RETURN_IF_ERROR(baseline->Init(std::move(schema_proto)));
+  if (image == nullptr) {
+    baseline->Precompute(validation_config.approximate_string_domains());
+  } else {
+    std::map<absl::optional<string>, std::vector<Path>> required_features;
+    TF_RETURN_IF_ERROR(image->GetRequiredFeatures(
+        absl::nullopt, &required_features[absl::nullopt]));
+    const StringTable& environments = image->environments();
+    for (uint32 i = 0; i < environments.size(); ++i) {
+      const string environment(environments.Get(i));
+      TF_RETURN_IF_ERROR(image->GetRequiredFeatures(
+          environment, &required_features[environment]));
+    }
+    absl::flat_hash_map<string, StringTable> string_domain_tables;
+    TF_RETURN_IF_ERROR(image->GetStringDomainTables(&string_domain_tables));
+    baseline->Precompute(std::move(required_features),
+                         std::move(string_domain_tables),
+                         validation_config.approximate_string_domains());
+  }
+  image_ = std::move(image);
+  baseline_ = std::move(baseline);
+  validation_config_ = validation_config;
+  return Status::OK();
+}
+
+Status CompiledSchemaValidator::Init(
+    absl::string_view schema_proto_string,
+    const ValidationConfig& validation_config) {
+  metadata::v0::Schema schema_proto;
+  TF_RETURN_IF_ERROR(ParseSchema(schema_proto_string, &schema_proto));
+  return Init(std::move(schema_proto), validation_config, /*image=*/nullptr);
+}
+
+Status CompiledSchemaValidator::Validate(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    metadata::v0::Anomalies* result) const {
+  return Validate(feature_statistics, environment, prev_feature_statistics,
+                  serving_feature_statistics, features_needed, result,
+                  /*profile=*/nullptr);
+}
+
+Status CompiledSchemaValidator::Validate(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    metadata::v0::Anomalies* result, ValidationProfile* profile) const {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::Validate() called before Init().");
+  }
+  std::unique_ptr<ValidationProfiler> profiler;
+  if (profile != nullptr) {
+    profiler = absl::make_unique<ValidationProfiler>(
+        validation_config_.num_slowest_features_to_profile());
+  }
+  TF_RETURN_IF_ERROR(ValidateFeatureStatisticsAgainstBaseline(
+      feature_statistics, baseline_, environment, prev_feature_statistics,
+      serving_feature_statistics, features_needed, validation_config_,
+      profiler.get(), result));
+  if (profiler != nullptr) {
+    profiler->GetProfile(profile);
+  }
+  return Status::OK();
+}
+
+Status CompiledSchemaValidator::ValidateToSink(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    bool include_baseline, AnomalySink* sink) const {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::ValidateToSink() called before Init().");
+  }
+  if (sink == nullptr) {
+    return tensorflow::errors::InvalidArgument("sink must not be null");
+  }
+  return ValidateFeatureStatisticsAgainstBaselineToSink(
+      feature_statistics, baseline_, environment, prev_feature_statistics,
+      serving_feature_statistics, features_needed, validation_config_,
+      include_baseline, sink);
+}
+
+Status CompiledSchemaValidator::ValidateWeightedAndUnweighted(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    metadata::v0::Anomalies* unweighted_result,
+    metadata::v0::Anomalies* weighted_result) const {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::ValidateWeightedAndUnweighted() called "
+        "before Init().");
+  }
+  return ValidateWeightedAndUnweightedAgainstBaseline(
+      feature_statistics, baseline_, environment, prev_feature_statistics,
+      serving_feature_statistics, features_needed, validation_config_,
+      unweighted_result, weighted_result);
+}
+
+Status CompiledSchemaValidator::ValidateWithDriftWindow(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    const std::vector<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics_window,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    metadata::v0::Anomalies* result, std::map<Path, int>* worst_spans) const {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::ValidateWithDriftWindow() called before "
+        "Init().");
+  }
+  return ValidateWithDriftWindowAgainstBaseline(
+      feature_statistics, baseline_, environment,
+      prev_feature_statistics_window, serving_feature_statistics,
+      features_needed, validation_config_, result, worst_spans);
+}
+
+Status CompiledSchemaValidator::Validate(
+    absl::string_view feature_statistics_proto_string,
+    absl::string_view environment,
+    absl::string_view previous_statistics_proto_string,
+    absl::string_view serving_statistics_proto_string,
+    metadata::v0::Anomalies* result) const {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::Validate() called before Init().");
+  }
+  DatasetFeatureStatistics feature_statistics;
+  TF_RETURN_IF_ERROR(
+      ParseStatistics(feature_statistics_proto_string, &feature_statistics));
+  gtl::optional<DatasetFeatureStatistics> previous_statistics;
+  if (!previous_statistics_proto_string.empty()) {
+    previous_statistics.emplace();
+    TF_RETURN_IF_ERROR(ParseStatisticsOfFeatures(
+        previous_statistics_proto_string, drift_feature_filter_,
+        &*previous_statistics));
+  }
+  gtl::optional<DatasetFeatureStatistics> serving_statistics;
+  if (!serving_statistics_proto_string.empty()) {
+    serving_statistics.emplace();
+    TF_RETURN_IF_ERROR(ParseStatisticsOfFeatures(
+        serving_statistics_proto_string, skew_feature_filter_,
+        &*serving_statistics));
+  }
+  gtl::optional<string> may_be_environment = gtl::nullopt;
+  if (!environment.empty()) {
+    may_be_environment = string(environment);
+  }
+  return Validate(feature_statistics, may_be_environment, previous_statistics,
+                  serving_statistics, /*features_needed=*/gtl::nullopt,
+                  result);
+}
+
+Status CompiledSchemaValidator::ValidateSlices(
+    const metadata::v0::DatasetFeatureStatisticsList& statistics_list,
+    const gtl::optional<string>& environment, int num_threads,
+    std::map<string, metadata::v0::Anomalies>* results) const {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::ValidateSlices() called before Init().");
+  }
+  const int num_slices = statistics_list.datasets_size();
+  std::vector<string> names(num_slices);
+  std::vector<metadata::v0::Anomalies> anomalies(num_slices);
+  TF_RETURN_IF_ERROR(RunInParallel(num_slices, num_threads, [&](int i) {
+    names[i] = statistics_list.datasets(i).name();
+    return ValidateSlice(statistics_list.datasets(i), environment,
+                         &anomalies[i]);
+  }));
+  return CollectSliceAnomalies(names, &anomalies, results);
+}
+
+Status CompiledSchemaValidator::ValidateSlices(
+    absl::string_view statistics_list_proto_string,
+    absl::string_view environment, int num_threads,
+    std::map<string, metadata::v0::Anomalies>* results) const {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "CompiledSchemaValidator::ValidateSlices() called before Init().");
+  }
+  // Only the bounds of the slices are read here, so that the slices are
+  // parsed in parallel.
+  std::vector<absl::string_view> slices;
+  WireReader reader(statistics_list_proto_string);
+  while (!reader.done()) {
+    int field, wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return errors::InvalidArgument("Cannot parse statistics list.");
+    }
+    if (field == metadata::v0::DatasetFeatureStatisticsList::
+                     kDatasetsFieldNumber &&
+        wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      absl::string_view slice;
+      if (!reader.ReadLengthDelimited(&slice)) {
+        return errors::InvalidArgument("Cannot parse statistics list.");
+      }
+      slices.push_back(slice);
+    } else if (!reader.SkipValue(wire_type)) {
+      return errors::InvalidArgument("Cannot parse statistics list.");
+    }
+  }
+  gtl::optional<string> may_be_environment = gtl::nullopt;
+  if (!environment.empty()) {
+    may_be_environment = string(environment);
+  }
+  std::vector<string> names(slices.size());
+  std::vector<metadata::v0::Anomalies> anomalies(slices.size());
+  TF_RETURN_IF_ERROR(RunInParallel(slices.size(), num_threads, [&](int i) {
+    DatasetFeatureStatistics feature_statistics;
+    TF_RETURN_IF_ERROR(ParseStatistics(slices[i], &feature_statistics));
+    names[i] = feature_statistics.name();
+    return ValidateSlice(feature_statistics, may_be_environment,
+                         &anomalies[i]);
+  }));
+  return CollectSliceAnomalies(names, &anomalies, results);
+}
+
+Status CompiledSchemaValidator::ValidateSlice(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    metadata::v0::Anomalies* result) const {
+  // The slices are already validated in parallel, so the features of each
+  // slice are validated on a single thread.
+  ValidationConfig slice_config = validation_config_;
+  slice_config.set_num_threads(1);
+  return ValidateFeatureStatisticsAgainstBaseline(
+      feature_statistics, baseline_, environment,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, slice_config, /*profiler=*/nullptr,
+      result);
+}
+
+Status IncrementalSchemaValidator::Init(
+    const metadata::v0::Schema& schema_proto,
+    const ValidationConfig& validation_config) {
+  if (baseline_ != nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "IncrementalSchemaValidator::Init() called twice.");
+  }
+  validation_config_ = validation_config;
+  return ResetSchema(schema_proto);
+}
+
+Status IncrementalSchemaValidator::SetSchema(
+    const metadata::v0::Schema& schema_proto) {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "IncrementalSchemaValidator::SetSchema() called before Init().");
+  }
+  return ResetSchema(schema_proto);
+}
+
+Status IncrementalSchemaValidator::ResetSchema(
+    const metadata::v0::Schema& schema_proto) {
+  auto baseline = std::make_shared<Schema>();
+  TF_RETURN_IF_ERROR(baseline->Init(schema_proto));
+  baseline->Precompute(validation_config_.approximate_string_domains());
+  baseline_ = std::move(baseline);
+
+  // If several entries have the same name, the fingerprint covers all of
+  // them.
+  schema_fingerprints_.clear();
+  for (const metadata::v0::Feature& feature : schema_proto.feature()) {
+    std::set<string> domain_names;
+    GetStringDomainNames(feature, &domain_names);
+    uint64& fingerprint = schema_fingerprints_[feature.name()];
+    fingerprint = Hash64Combine(
+        fingerprint,
+        GetSchemaEntryFingerprint(feature.SerializeAsString(), domain_names,
+                                  schema_proto));
+  }
+  for (const metadata::v0::SparseFeature& sparse_feature :
+       schema_proto.sparse_feature()) {
+    uint64& fingerprint = schema_fingerprints_[sparse_feature.name()];
+    fingerprint = Hash64Combine(
+        fingerprint, GetSchemaEntryFingerprint(
+                         sparse_feature.SerializeAsString(),
+                         /*domain_names=*/{}, schema_proto));
+  }
+  schema_fingerprint_ = Hash64(schema_proto.SerializeAsString());
+  metadata::v0::Schema context = schema_proto;
+  context.clear_feature();
+  context.clear_sparse_feature();
+  context.clear_string_domain();
+  schema_context_fingerprint_ = Hash64(context.SerializeAsString());
+  return Status::OK();
+}
+
+Status IncrementalSchemaValidator::Validate(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    metadata::v0::Anomalies* result) {
+  if (baseline_ == nullptr) {
+    return tensorflow::errors::FailedPrecondition(
+        "IncrementalSchemaValidator::Validate() called before Init().");
+  }
+  num_root_features_validated_ = 0;
+  if (feature_statistics.num_examples() == 0) {
+    root_features_.clear();
+    return ValidateFeatureStatisticsAgainstBaseline(
+        feature_statistics, baseline_, environment, prev_feature_statistics,
+        serving_feature_statistics, features_needed, validation_config_,
+        /*profiler=*/nullptr, result);
+  }
+  const absl::optional<string> maybe_environment =
+      environment ? absl::optional<string>(*environment)
+                  : absl::optional<string>();
+  const DatasetStatsView training =
+      GetValidationView(feature_statistics, maybe_environment,
+                        prev_feature_statistics, serving_feature_statistics);
+
+  uint64 context_fingerprint = Hash64Combine(
+      schema_context_fingerprint_, training.by_weight() ? 1 : 0);
+  context_fingerprint = Hash64Combine(
+      context_fingerprint, environment ? Hash64(*environment) : 0);
+  if (features_needed) {
+    for (const auto& pair : *features_needed) {
+      context_fingerprint = Hash64Combine(
+          context_fingerprint,
+          Hash64(pair.first.AsProto().SerializeAsString()));
+    }
+  }
+  context_fingerprint = Hash64Combine(
+      context_fingerprint, GetNumExamplesFingerprint(feature_statistics));
+  context_fingerprint = Hash64Combine(
+      context_fingerprint, GetNumExamplesFingerprint(prev_feature_statistics));
+  context_fingerprint =
+      Hash64Combine(context_fingerprint,
+                    GetNumExamplesFingerprint(serving_feature_statistics));
+  if (context_fingerprint != context_fingerprint_) {
+    root_features_.clear();
+    context_fingerprint_ = context_fingerprint;
+  }
+
+  // The root features that changed keep an empty state until their
+  // anomalies are found below.
+  std::map<Path, uint64> fingerprints;
+  for (const FeatureStatsView& root : training.GetRootFeaturesRange()) {
+    const auto schema_fingerprint =
+        schema_fingerprints_.find(root.GetPath().last_step());
+    uint64& fingerprint = fingerprints[root.GetPath()];
+    fingerprint = Hash64Combine(
+        fingerprint,
+        Hash64Combine(GetStatisticsFingerprint(root),
+                      schema_fingerprint == schema_fingerprints_.end()
+                          ? schema_fingerprint_
+                          : schema_fingerprint->second));
+  }
+  std::map<Path, RootFeatureState> root_features;
+  std::set<Path> to_validate;
+  for (const auto& pair : fingerprints) {
+    RootFeatureState& state = root_features[pair.first];
+    auto old_state = root_features_.find(pair.first);
+    if (old_state != root_features_.end() &&
+        old_state->second.fingerprint == pair.second) {
+      state = std::move(old_state->second);
+    } else {
+      state.fingerprint = pair.second;
+      to_validate.insert(pair.first);
+    }
+  }
+
+  SchemaAnomalies schema_anomalies(baseline_);
+  TF_RETURN_IF_ERROR(schema_anomalies.FindChanges(
+      training, ToAbslOptional(features_needed),
+      GetValidationFeatureStatisticsToProtoConfig(validation_config_),
+      validation_config_.num_threads(),
+      [&to_validate](const FeatureStatsView& root) {
+        return ContainsKey(to_validate, root.GetPath());
+      }));
+  schema_anomalies.GetSchemaDiff(result);
+  for (const auto& pair : result->anomaly_info()) {
+    const metadata::v0::AnomalyInfo& info = pair.second;
+    if (info.path().step_size() == 0) {
+      continue;
+    }
+    const Path root_path({info.path().step(0)});
+    if (ContainsKey(to_validate, root_path)) {
+      root_features[root_path].anomalies[pair.first] = info;
+    }
+  }
+  // Features missing from the statistics were found again above, so the
+  // anomalies found above take precedence.
+  auto& anomaly_info = *result->mutable_anomaly_info();
+  for (const auto& pair : root_features) {
+    if (ContainsKey(to_validate, pair.first)) {
+      continue;
+    }
+    for (const auto& anomaly : pair.second.anomalies) {
+      if (anomaly_info.count(anomaly.first) == 0) {
+        anomaly_info[anomaly.first] = anomaly.second;
+      }
+    }
+  }
+  root_features_ = std::move(root_features);
+  num_root_features_validated_ = to_validate.size();
+  return Status::OK();
 }
 
 Status FeatureStatisticsValidator::ValidateFeatureStatistics(
@@ -234,6 +1380,18 @@ Status FeatureStatisticsValidator::ValidateFeatureStatistics(
       serving_feature_statistics, features_needed, validation_config, result);
 }
 
+Status FeatureStatisticsValidator::ValidateFeatureStatisticsBatch(
+    const std::vector<metadata::v0::DatasetFeatureStatistics>&
+        feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const ValidationConfig& validation_config,
+    std::vector<metadata::v0::Anomalies>* results) const {
+  return ::tensorflow::data_validation::ValidateFeatureStatisticsBatch(
+      feature_statistics, schema_proto, environment, validation_config,
+      results);
+}
+
 Status FeatureStatisticsValidator::UpdateSchema(
     const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
     const metadata::v0::Schema& schema_to_update,
@@ -18,15 +18,21 @@ limitations under the License.
 #ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_FEATURE_STATISTICS_VALIDATOR_H_
 #define TENSORFLOW_DATA_VALIDATION_ANOMALIES_FEATURE_STATISTICS_VALIDATOR_H_
 
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/anomaly_sink.h"
+#include "tensorflow_data_validation/anomalies/compiled_schema_image.h"
 #include "tensorflow_data_validation/anomalies/features_needed.h"
 #include "tensorflow_data_validation/anomalies/path.h"
 #include "tensorflow_data_validation/anomalies/proto/feature_statistics_to_proto.pb.h"
-
 #include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
+#include "tensorflow_data_validation/anomalies/schema.h"
+#include "tensorflow_data_validation/anomalies/statistics_parser.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/optional.h"
 #include "tensorflow/core/platform/types.h"
@@ -46,9 +52,16 @@ FeatureStatisticsToProtoConfig GetDefaultFeatureStatisticsToProtoConfig();
 // proto string and will output the serialized schema proto string.
 // max_string_domain_size argument refers to the maximum size of the domain of
 // a string feature in order to be interpreted as a categorical feature.
-Status InferSchema(const string& feature_statistics_proto_string,
-                               const int max_string_domain_size,
-                               string* schema_proto_string);
+Status InferSchema(absl::string_view feature_statistics_proto_string,
+                   const int max_string_domain_size,
+                   string* schema_proto_string);
+
+// Same as above, but outputs the schema proto, so that the caller can
+// serialize it where it needs it. The columns of the features are computed
+// on num_threads threads (see FeatureStatisticsToProtoConfig.num_threads).
+Status InferSchema(absl::string_view feature_statistics_proto_string,
+                   const int max_string_domain_size, int num_threads,
+                   metadata::v0::Schema* schema);
 
 // Validates the feature statistics in <feature_statistics> with respect to
 // the <schema_proto> and returns a schema diff proto which captures the
@@ -61,6 +74,11 @@ Status InferSchema(const string& feature_statistics_proto_string,
 // distribution skew between current data and serving data.
 // If an environment is specified, only validate the feature statistics of the
 // fields in that environment. Otherwise, validate all fields.
+// The schema diff is built in place in *result, which may be allocated on a
+// protobuf::Arena. Its sub-messages (the baseline, and each AnomalyInfo with
+// its path and reasons) are then allocated on that arena too, rather than
+// being built on the heap and copied. The intermediate state of the
+// validation (e.g., the schema overlay of each anomaly) stays on the heap.
 Status ValidateFeatureStatistics(
     const metadata::v0::DatasetFeatureStatistics&
         feature_statistics,
@@ -76,16 +94,127 @@ Status ValidateFeatureStatistics(
     const ValidationConfig& validation_config,
     metadata::v0::Anomalies* result);
 
+// Same as above, but if profile is not null, also fills *profile with where
+// the time of validation went (see ValidationProfile). The slowest
+// validation_config.num_slowest_features_to_profile() root features are
+// listed. Profiling adds nothing to the time of validation when profile is
+// null.
+Status ValidateFeatureStatistics(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* result, ValidationProfile* profile);
+
+// Same as ValidateFeatureStatistics(), but writes the schema diff to *sink
+// rather than building it in an Anomalies proto: first the fields other than
+// anomaly_info, and then each anomaly, in order of path. The anomalies are
+// written once the validation has found them all, and each one is released
+// once it is written. The baseline schema is only written if
+// include_baseline, so that a very broken dataset does not need memory for
+// more than the anomalies themselves.
+Status ValidateFeatureStatisticsToSink(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config, bool include_baseline,
+    AnomalySink* sink);
+
+// Same as ValidateFeatureStatistics(), but validates both the unweighted and
+// the weighted statistics of feature_statistics, into *unweighted_result and
+// *weighted_result, instead of only the weighted ones when they exist. The
+// schema is compiled and the statistics are indexed once for both (see
+// CompiledSchemaValidator::ValidateWeightedAndUnweighted()). Returns
+// InvalidArgument if feature_statistics has no weighted statistics.
+Status ValidateFeatureStatisticsWeightedAndUnweighted(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* unweighted_result,
+    metadata::v0::Anomalies* weighted_result);
+
+// Same as ValidateFeatureStatistics(), but checks drift against each of the
+// statistics in prev_feature_statistics_window (e.g., the previous spans,
+// most recent first) instead of a single previous span. Each feature with a
+// drift comparator is compared to its worst span: the one whose distances
+// are the furthest above the thresholds, relative to them (the first one, on
+// ties). If worst_spans is not null, (*worst_spans)[path] is set to the index
+// of that span for each such feature that is in some span. The spans are
+// compared on validation_config.num_threads() threads, and the string values
+// of feature_statistics are computed once for all of them.
+Status ValidateFeatureStatisticsWithDriftWindow(
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const std::vector<metadata::v0::DatasetFeatureStatistics>&
+        prev_feature_statistics_window,
+    const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+        serving_feature_statistics,
+    const gtl::optional<FeaturesNeeded>& features_needed,
+    const ValidationConfig& validation_config,
+    metadata::v0::Anomalies* result, std::map<Path, int>* worst_spans);
+
 // Similar to the above, but takes all the proto parameters as serialized
 // strings. Mainly used for SWIG.
 Status ValidateFeatureStatistics(
-    const string& feature_statistics_proto_string,
-    const string& schema_proto_string,
-    const string& environment,
-    const string& previous_statistics_proto_string,
-    const string& serving_statistics_proto_string,
+    absl::string_view feature_statistics_proto_string,
+    absl::string_view schema_proto_string,
+    absl::string_view environment,
+    absl::string_view previous_statistics_proto_string,
+    absl::string_view serving_statistics_proto_string,
     string* anomalies_proto_string);
 
+// Same as above, but outputs the schema diff proto.
+Status ValidateFeatureStatistics(
+    absl::string_view feature_statistics_proto_string,
+    absl::string_view schema_proto_string, absl::string_view environment,
+    absl::string_view previous_statistics_proto_string,
+    absl::string_view serving_statistics_proto_string,
+    metadata::v0::Anomalies* anomalies);
+
+// Validates each of <feature_statistics> with respect to <schema_proto>, as
+// ValidateFeatureStatistics() does without previous or serving statistics,
+// and sets (*results)[i] to the schema diff for feature_statistics[i].
+// The schema is parsed and indexed once and shared by all the validations,
+// which run on validation_config.num_threads() threads.
+Status ValidateFeatureStatisticsBatch(
+    const std::vector<metadata::v0::DatasetFeatureStatistics>&
+        feature_statistics,
+    const metadata::v0::Schema& schema_proto,
+    const gtl::optional<string>& environment,
+    const ValidationConfig& validation_config,
+    std::vector<metadata::v0::Anomalies>* results);
+
+// Similar to the above, but takes all the proto parameters as serialized
+// strings. Mainly used for SWIG.
+Status ValidateFeatureStatisticsBatch(
+    const std::vector<string>& feature_statistics_proto_strings,
+    absl::string_view schema_proto_string, absl::string_view environment,
+    int num_threads, std::vector<string>* anomalies_proto_strings);
+
+// Same as above, but takes views of the serialized statistics, and outputs
+// the schema diff protos.
+Status ValidateFeatureStatisticsBatch(
+    const std::vector<absl::string_view>& feature_statistics_proto_strings,
+    absl::string_view schema_proto_string, absl::string_view environment,
+    int num_threads, std::vector<metadata::v0::Anomalies>* results);
+
 // Updates an existing schema to match the data characteristics in
 // <feature_statistics>, but only on the paths_to_consider.
 // An empty schema_to_update is a valid input schema.
@@ -103,6 +232,249 @@ Status UpdateSchema(
     const gtl::optional<string>& environment,
     metadata::v0::Schema* result);
 
+// Same as UpdateSchema(), but updates *schema_proto in place, without copying
+// it.
+// This saves the two copies of the whole schema that UpdateSchema() makes,
+// which dominate the update of a few paths_to_consider in a large schema.
+// The schema is updated on the heap, so if *schema_proto is on an arena, it
+// is copied in and out rather than moved.
+// If an error is returned, *schema_proto may be partially updated.
+Status UpdateSchemaInPlace(
+    const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
+    const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+    const gtl::optional<std::vector<Path>>& paths_to_consider,
+    const gtl::optional<string>& environment,
+    metadata::v0::Schema* schema_proto);
+
+// Validates statistics against a fixed schema and ValidationConfig. The
+// schema is parsed, indexed and precomputed (see Schema::Precompute()) once
+// by Init(), so that Validate() only does the work that depends on the
+// statistics. This is for validating many statistics against the same
+// schema, e.g., one for each micro-batch of a stream.
+// Validate() can be called concurrently.
+class CompiledSchemaValidator {
+ public:
+  CompiledSchemaValidator() = default;
+
+  // Disallow copy and move.
+  CompiledSchemaValidator(const CompiledSchemaValidator&) = delete;
+  CompiledSchemaValidator& operator=(const CompiledSchemaValidator&) = delete;
+
+  // Initializes the validator. Must be called once, before Validate().
+  Status Init(const metadata::v0::Schema& schema_proto,
+              const ValidationConfig& validation_config);
+
+  // Same as above, but takes a serialized Schema proto.
+  Status Init(absl::string_view schema_proto_string,
+              const ValidationConfig& validation_config);
+
+  // Same as above, but takes the image of a compiled schema, whose required
+  // features are used instead of being computed from the schema, and whose
+  // tables of the values of the StringDomains are read in place during
+  // validation instead of being collected into sets or filters. The
+  // validator keeps image alive.
+  Status Init(std::shared_ptr<const CompiledSchemaImage> image,
+              const ValidationConfig& validation_config);
+
+  // Same as ValidateFeatureStatistics(), with the schema and the
+  // ValidationConfig passed to Init().
+  Status Validate(
+      const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+      const gtl::optional<string>& environment,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          prev_feature_statistics,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          serving_feature_statistics,
+      const gtl::optional<FeaturesNeeded>& features_needed,
+      metadata::v0::Anomalies* result) const;
+
+  // Same as above, but also fills *profile, if it is not null (see
+  // ValidateFeatureStatistics()).
+  Status Validate(
+      const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+      const gtl::optional<string>& environment,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          prev_feature_statistics,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          serving_feature_statistics,
+      const gtl::optional<FeaturesNeeded>& features_needed,
+      metadata::v0::Anomalies* result, ValidationProfile* profile) const;
+
+  // Same as ValidateFeatureStatisticsToSink(), with the schema and the
+  // ValidationConfig passed to Init().
+  Status ValidateToSink(
+      const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+      const gtl::optional<string>& environment,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          prev_feature_statistics,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          serving_feature_statistics,
+      const gtl::optional<FeaturesNeeded>& features_needed,
+      bool include_baseline, AnomalySink* sink) const;
+
+  // Same as ValidateFeatureStatisticsWeightedAndUnweighted(), with the
+  // schema and the ValidationConfig passed to Init(). The weighted and
+  // unweighted views of the statistics share the index of the features, and
+  // are validated concurrently if the ValidationConfig has num_threads > 1.
+  Status ValidateWeightedAndUnweighted(
+      const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+      const gtl::optional<string>& environment,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          prev_feature_statistics,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          serving_feature_statistics,
+      const gtl::optional<FeaturesNeeded>& features_needed,
+      metadata::v0::Anomalies* unweighted_result,
+      metadata::v0::Anomalies* weighted_result) const;
+
+  // Same as ValidateFeatureStatisticsWithDriftWindow(), with the schema and
+  // the ValidationConfig passed to Init().
+  Status ValidateWithDriftWindow(
+      const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+      const gtl::optional<string>& environment,
+      const std::vector<metadata::v0::DatasetFeatureStatistics>&
+          prev_feature_statistics_window,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          serving_feature_statistics,
+      const gtl::optional<FeaturesNeeded>& features_needed,
+      metadata::v0::Anomalies* result, std::map<Path, int>* worst_spans) const;
+
+  // Same as the serialized-string ValidateFeatureStatistics(), with the
+  // schema and the ValidationConfig passed to Init(). As there, only the
+  // features that have a drift (or skew) comparator in the schema are parsed
+  // from the previous (or serving) statistics, and an empty environment or
+  // statistics string means that there is none.
+  Status Validate(absl::string_view feature_statistics_proto_string,
+                  absl::string_view environment,
+                  absl::string_view previous_statistics_proto_string,
+                  absl::string_view serving_statistics_proto_string,
+                  metadata::v0::Anomalies* result) const;
+
+  // Validates each dataset (i.e., each slice) of statistics_list, as
+  // Validate() does without previous or serving statistics, and sets
+  // (*results)[name] to the schema diff of the slice named name. The slices
+  // are validated on num_threads threads, each slice on a single thread.
+  // Returns InvalidArgument if two slices have the same name.
+  Status ValidateSlices(
+      const metadata::v0::DatasetFeatureStatisticsList& statistics_list,
+      const gtl::optional<string>& environment, int num_threads,
+      std::map<string, metadata::v0::Anomalies>* results) const;
+
+  // Same as above, but takes a serialized DatasetFeatureStatisticsList. Each
+  // slice is parsed by the thread that validates it. An empty environment
+  // means that there is none.
+  Status ValidateSlices(
+      absl::string_view statistics_list_proto_string,
+      absl::string_view environment, int num_threads,
+      std::map<string, metadata::v0::Anomalies>* results) const;
+
+ private:
+  // Validates a slice for ValidateSlices() on the calling thread.
+  Status ValidateSlice(
+      const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+      const gtl::optional<string>& environment,
+      metadata::v0::Anomalies* result) const;
+
+  // Initializes the validator, taking the required features and the values
+  // of the StringDomains from image_ if it is not null.
+  Status Init(metadata::v0::Schema schema_proto,
+              const ValidationConfig& validation_config,
+              std::shared_ptr<const CompiledSchemaImage> image);
+
+  // The image passed to Init(), if any, which baseline_ views.
+  std::shared_ptr<const CompiledSchemaImage> image_;
+  // The schema passed to Init(), which is never modified afterwards.
+  std::shared_ptr<const Schema> baseline_;
+  ValidationConfig validation_config_;
+  // The features to parse from the previous and the serving statistics.
+  FeatureFilter drift_feature_filter_;
+  FeatureFilter skew_feature_filter_;
+};
+
+// Validates a sequence of statistics, such as those of a continuous
+// pipeline, where few features change from one to the next. Each root
+// feature (along with its descendants) is validated again only if its
+// statistics (in any of the training, previous and serving statistics) or
+// its entry in the schema changed since the previous call of Validate().
+// Otherwise, its anomalies from the previous call are reused. If anything
+// that every feature depends on changes (e.g., the number of examples, the
+// environment or features_needed), every feature is validated again.
+// The result of Validate() is always the same as that of
+// ValidateFeatureStatistics().
+// This class is not thread-safe.
+class IncrementalSchemaValidator {
+ public:
+  IncrementalSchemaValidator() = default;
+
+  // Disallow copy and move.
+  IncrementalSchemaValidator(const IncrementalSchemaValidator&) = delete;
+  IncrementalSchemaValidator& operator=(const IncrementalSchemaValidator&) =
+      delete;
+
+  // Initializes the validator. Must be called once, before Validate().
+  Status Init(const metadata::v0::Schema& schema_proto,
+              const ValidationConfig& validation_config);
+
+  // Same as above, but takes a serialized Schema proto.
+  Status Init(absl::string_view schema_proto_string,
+              const ValidationConfig& validation_config);
+
+  // Replaces the schema. Only the features whose entry in the schema changed
+  // (including the string domains that they use) are validated again by the
+  // next call of Validate().
+  Status SetSchema(const metadata::v0::Schema& schema_proto);
+
+  // Same as ValidateFeatureStatistics(), with the schema that was last
+  // passed to Init() or SetSchema() and the ValidationConfig passed to
+  // Init().
+  Status Validate(
+      const metadata::v0::DatasetFeatureStatistics& feature_statistics,
+      const gtl::optional<string>& environment,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          prev_feature_statistics,
+      const gtl::optional<metadata::v0::DatasetFeatureStatistics>&
+          serving_feature_statistics,
+      const gtl::optional<FeaturesNeeded>& features_needed,
+      metadata::v0::Anomalies* result);
+
+  // The number of root features validated by the last call of Validate().
+  int num_root_features_validated() const {
+    return num_root_features_validated_;
+  }
+
+ private:
+  // What is known about a root feature from the last call of Validate().
+  struct RootFeatureState {
+    // A fingerprint of everything that the anomalies of the root feature
+    // and its descendants depend on.
+    uint64 fingerprint = 0;
+    // The anomalies of the root feature and its descendants, keyed by their
+    // serialized path.
+    std::map<string, metadata::v0::AnomalyInfo> anomalies;
+  };
+
+  // Replaces baseline_ and the fingerprints of the schema.
+  Status ResetSchema(const metadata::v0::Schema& schema_proto);
+
+  std::shared_ptr<const Schema> baseline_;
+  ValidationConfig validation_config_;
+  // A fingerprint of the entry in the schema of each root feature (along
+  // with the string domains that it uses), keyed by its name.
+  std::map<string, uint64> schema_fingerprints_;
+  // A fingerprint of the whole schema, for the root features that have no
+  // entry in it (a new entry depends on the existing ones).
+  uint64 schema_fingerprint_ = 0;
+  // A fingerprint of the parts of the schema that are not an entry of any
+  // feature.
+  uint64 schema_context_fingerprint_ = 0;
+  // A fingerprint of everything else that every root feature depends on
+  // (including schema_context_fingerprint_), from the last call of
+  // Validate().
+  uint64 context_fingerprint_ = 0;
+  std::map<Path, RootFeatureState> root_features_;
+  int num_root_features_validated_ = 0;
+};
+
 // A wrapper class of the above functions for mockability.
 class FeatureStatisticsValidator {
  public:
@@ -126,6 +498,14 @@ class FeatureStatisticsValidator {
       const ValidationConfig& validation_config,
       metadata::v0::Anomalies* result) const;
 
+  virtual Status ValidateFeatureStatisticsBatch(
+      const std::vector<metadata::v0::DatasetFeatureStatistics>&
+          feature_statistics,
+      const metadata::v0::Schema& schema_proto,
+      const gtl::optional<string>& environment,
+      const ValidationConfig& validation_config,
+      std::vector<metadata::v0::Anomalies>* results) const;
+
   virtual Status UpdateSchema(
       const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
       const metadata::v0::Schema& schema_to_update,
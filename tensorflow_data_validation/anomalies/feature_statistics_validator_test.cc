@@ -17,11 +17,18 @@ limitations under the License.
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/anomaly_sink.h"
+#include "tensorflow_data_validation/anomalies/compiled_schema_image.h"
+#include "tensorflow_data_validation/anomalies/path.h"
 #include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
 #include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_metadata/proto/v0/anomalies.pb.h"
 #include "tensorflow_metadata/proto/v0/schema.pb.h"
@@ -31,6 +38,7 @@ namespace data_validation {
 namespace {
 
 using ::tensorflow::metadata::v0::DatasetFeatureStatistics;
+using ::tensorflow::metadata::v0::DatasetFeatureStatisticsList;
 using ::tensorflow::metadata::v0::Schema;
 using testing::EqualsProto;
 using testing::ParseTextProtoOrDie;
@@ -468,6 +476,59 @@ TEST(FeatureStatisticsValidatorTest, UpdateSchemaWithColumnsToConsider) {
   EXPECT_THAT(got, EqualsProto(want));
 }
 
+// Updating a schema in place gives the same schema as UpdateSchema(), with
+// or without paths to consider.
+TEST(FeatureStatisticsValidatorTest, UpdateSchemaInPlace) {
+  const Schema old_schema = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: "annotated_enum"
+      value_count { min: 1 max: 1 }
+      type: BYTES
+      domain: "annotated_enum"
+      presence { min_count: 1 }
+    }
+    feature { name: "missing" type: INT presence { min_count: 1 } }
+    string_domain { name: "annotated_enum" value: "E" })");
+
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 1000
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_missing: 3
+              max_num_values: 1
+              num_non_missing: 2
+              avg_num_values: 2
+            }
+            unique: 3
+            rank_histogram: { buckets: { label: "D" sample_count: 1 } }
+          }
+        })");
+
+  // Only a missing feature that is considered is deprecated.
+  const std::vector<gtl::optional<std::vector<Path>>> all_paths_to_consider =
+      {gtl::nullopt, std::vector<Path>({Path({"annotated_enum"})}),
+       std::vector<Path>({Path({"annotated_enum"}), Path({"missing"})})};
+  for (const gtl::optional<std::vector<Path>>& paths_to_consider :
+       all_paths_to_consider) {
+    Schema want;
+    TF_ASSERT_OK(UpdateSchema(GetDefaultFeatureStatisticsToProtoConfig(),
+                              old_schema, statistics, paths_to_consider,
+                              /*environment=*/gtl::nullopt, &want));
+    Schema got = old_schema;
+    TF_ASSERT_OK(UpdateSchemaInPlace(
+        GetDefaultFeatureStatisticsToProtoConfig(), statistics,
+        paths_to_consider, /*environment=*/gtl::nullopt, &got));
+    EXPECT_THAT(got, EqualsProto(want));
+    EXPECT_EQ(paths_to_consider && paths_to_consider->size() == 1,
+              got.feature(1).lifecycle_stage() !=
+                  tensorflow::metadata::v0::DEPRECATED);
+  }
+}
+
 TEST(FeatureStatisticsValidatorTest, UseWeightedStatistics) {
   // Those missing have weight zero.
   // Also, (impossibly) there is an E for the weighted and a D for the
@@ -506,6 +567,83 @@ TEST(FeatureStatisticsValidatorTest, UseWeightedStatistics) {
   TestSchemaUpdate(ValidationConfig(), statistics, Schema(), want);
 }
 
+TEST(FeatureStatisticsValidatorTest, ValidateWeightedAndUnweighted) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" }
+    feature {
+      name: "annotated_enum"
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    })");
+  // The unweighted statistics have an unexpected D, and the weighted ones
+  // an unexpected E.
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 1000
+        weighted_num_examples: 997.0
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_missing: 3
+              num_non_missing: 997
+              max_num_values: 1
+              weighted_common_stats: { num_missing: 0.0 num_non_missing: 997.0 }
+            }
+            unique: 3
+            rank_histogram: { buckets: { label: "D" } }
+            weighted_string_stats: {
+              rank_histogram: { buckets: { label: "E" } }
+            }
+          }
+        })");
+  DatasetFeatureStatistics unweighted_statistics = statistics;
+  unweighted_statistics.clear_weighted_num_examples();
+  for (int num_threads : {1, 4}) {
+    ValidationConfig validation_config;
+    validation_config.set_num_threads(num_threads);
+    tensorflow::metadata::v0::Anomalies expected_weighted;
+    TF_ASSERT_OK(ValidateFeatureStatistics(
+        statistics, schema, /*environment=*/gtl::nullopt,
+        /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, validation_config,
+        &expected_weighted));
+    tensorflow::metadata::v0::Anomalies expected_unweighted;
+    TF_ASSERT_OK(ValidateFeatureStatistics(
+        unweighted_statistics, schema, /*environment=*/gtl::nullopt,
+        /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, validation_config,
+        &expected_unweighted));
+
+    tensorflow::metadata::v0::Anomalies weighted;
+    tensorflow::metadata::v0::Anomalies unweighted;
+    TF_ASSERT_OK(ValidateFeatureStatisticsWeightedAndUnweighted(
+        statistics, schema, /*environment=*/gtl::nullopt,
+        /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, validation_config, &unweighted,
+        &weighted));
+    EXPECT_THAT(weighted, EqualsProto(expected_weighted));
+    EXPECT_THAT(unweighted, EqualsProto(expected_unweighted));
+    EXPECT_NE(weighted.anomaly_info().at("annotated_enum").description(),
+              unweighted.anomaly_info().at("annotated_enum").description());
+  }
+
+  tensorflow::metadata::v0::Anomalies weighted;
+  tensorflow::metadata::v0::Anomalies unweighted;
+  EXPECT_FALSE(ValidateFeatureStatisticsWeightedAndUnweighted(
+                   unweighted_statistics, schema, /*environment=*/gtl::nullopt,
+                   /*prev_feature_statistics=*/gtl::nullopt,
+                   /*serving_feature_statistics=*/gtl::nullopt,
+                   /*features_needed=*/gtl::nullopt, ValidationConfig(),
+                   &unweighted, &weighted)
+                   .ok());
+}
+
 TEST(FeatureStatisticsValidatorTest, UpdateDriftComparatorInSchema) {
   const Schema old_schema = ParseTextProtoOrDie<Schema>(R"(
     feature {
@@ -580,6 +718,1244 @@ TEST(FeatureStatisticsValidatorTest, UpdateDriftComparatorInSchema) {
                                  /*features_needed=*/gtl::nullopt, anomalies);
 }
 
+TEST(FeatureStatisticsValidatorTest, DriftDistanceThresholds) {
+  const Schema old_schema = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: "float_feature"
+      type: FLOAT
+      drift_comparator {}
+    })");
+
+  const DatasetFeatureStatistics statistics = ParseTextProtoOrDie<
+      DatasetFeatureStatistics>(R"(
+    num_examples: 10
+    features: {
+      name: 'float_feature'
+      type: FLOAT
+      num_stats: {
+        common_stats: { num_non_missing: 10 max_num_values: 1 }
+        histograms {
+          buckets { low_value: 5 high_value: 6 sample_count: 10 }
+        }
+      }
+    })");
+
+  const DatasetFeatureStatistics prev_statistics = ParseTextProtoOrDie<
+      DatasetFeatureStatistics>(R"(
+    num_examples: 10
+    features: {
+      name: 'float_feature'
+      type: FLOAT
+      num_stats: {
+        common_stats: { num_non_missing: 10 max_num_values: 1 }
+        histograms {
+          buckets { low_value: 0 high_value: 1 sample_count: 4 }
+          buckets { low_value: 1 high_value: 2 sample_count: 6 }
+        }
+      }
+    })");
+
+  // Without thresholds, there is nothing to check.
+  TestFeatureStatisticsValidator(old_schema, ValidationConfig(), statistics,
+                                 prev_statistics,
+                                 /*environment=*/gtl::nullopt,
+                                 /*features_needed=*/gtl::nullopt, {});
+
+  ValidationConfig validation_config;
+  validation_config.mutable_drift_thresholds()->set_jensen_shannon_divergence(
+      0.1);
+  // The skew thresholds do not apply to the drift comparator.
+  validation_config.mutable_skew_thresholds()->set_population_stability_index(
+      0.1);
+  std::map<string, testing::ExpectedAnomalyInfo> anomalies;
+  anomalies["float_feature"].new_schema = old_schema;
+  anomalies["float_feature"].expected_info_without_diff = ParseTextProtoOrDie<
+      tensorflow::metadata::v0::AnomalyInfo>(R"(
+    description: "The Jensen-Shannon divergence between current and previous is 1 (up to six significant digits), above the threshold 0.1."
+    severity: ERROR
+    short_description: "High Jensen-Shannon divergence between current and previous"
+    reason {
+      type: UNKNOWN_TYPE
+      short_description: "High Jensen-Shannon divergence between current and previous"
+      description: "The Jensen-Shannon divergence between current and previous is 1 (up to six significant digits), above the threshold 0.1."
+    }
+    path: { step: "float_feature" }
+  )");
+  TestFeatureStatisticsValidator(old_schema, validation_config, statistics,
+                                 prev_statistics,
+                                 /*environment=*/gtl::nullopt,
+                                 /*features_needed=*/gtl::nullopt, anomalies);
+}
+
+// anomaly_info is a map, so its entries are compared one at a time.
+void ExpectSameAnomalies(const tensorflow::metadata::v0::Anomalies& expected,
+                         const tensorflow::metadata::v0::Anomalies& actual) {
+  EXPECT_THAT(actual.baseline(), EqualsProto(expected.baseline()));
+  EXPECT_EQ(expected.data_missing(), actual.data_missing());
+  ASSERT_EQ(expected.anomaly_info_size(), actual.anomaly_info_size());
+  for (const auto& pair : expected.anomaly_info()) {
+    ASSERT_EQ(1, actual.anomaly_info().count(pair.first)) << pair.first;
+    EXPECT_THAT(actual.anomaly_info().at(pair.first),
+                EqualsProto(pair.second));
+  }
+}
+
+// Returns statistics of 10 examples with a struct "s", and a STRING feature
+// for each name in counts, with a rank histogram of the counts of the values.
+DatasetFeatureStatistics GetDriftWindowStatistics(
+    const std::map<string, std::map<string, int>>& counts) {
+  DatasetFeatureStatistics result = ParseTextProtoOrDie<
+      DatasetFeatureStatistics>(R"(
+    num_examples: 10
+    features: {
+      name: 's'
+      type: STRUCT
+      struct_stats: { common_stats: { num_non_missing: 10 max_num_values: 1 } }
+    })");
+  for (const auto& feature_counts : counts) {
+    metadata::v0::FeatureNameStatistics* feature = result.add_features();
+    feature->set_name(feature_counts.first);
+    feature->set_type(metadata::v0::FeatureNameStatistics::STRING);
+    metadata::v0::StringStatistics* string_stats =
+        feature->mutable_string_stats();
+    string_stats->mutable_common_stats()->set_num_non_missing(10);
+    string_stats->mutable_common_stats()->set_max_num_values(1);
+    for (const auto& value_count : feature_counts.second) {
+      metadata::v0::RankHistogram::Bucket* bucket =
+          string_stats->mutable_rank_histogram()->add_buckets();
+      bucket->set_label(value_count.first);
+      bucket->set_sample_count(value_count.second);
+    }
+  }
+  return result;
+}
+
+TEST(FeatureStatisticsValidatorTest, ValidateWithDriftWindow) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: "f"
+      type: BYTES
+      drift_comparator { infinity_norm { threshold: 0.1 } }
+    }
+    feature {
+      name: "s"
+      type: STRUCT
+      struct_domain {
+        feature {
+          name: "c"
+          type: BYTES
+          drift_comparator { infinity_norm { threshold: 0.1 } }
+        }
+      }
+    })");
+  const DatasetFeatureStatistics current = GetDriftWindowStatistics(
+      {{"f", {{"a", 5}, {"b", 5}}}, {"s.c", {{"a", 5}, {"b", 5}}}});
+  // The L-infinity distances of f are 0.1, 0.5 and 0.3, and those of s.c
+  // are 0.2, none and 0.4.
+  const std::vector<DatasetFeatureStatistics> window = {
+      GetDriftWindowStatistics(
+          {{"f", {{"a", 6}, {"b", 4}}}, {"s.c", {{"a", 7}, {"b", 3}}}}),
+      GetDriftWindowStatistics({{"f", {{"a", 10}}}}),
+      GetDriftWindowStatistics(
+          {{"f", {{"a", 8}, {"b", 2}}}, {"s.c", {{"a", 9}, {"b", 1}}}})};
+
+  for (int num_threads : {1, 3}) {
+    ValidationConfig validation_config;
+    validation_config.set_num_threads(num_threads);
+    metadata::v0::Anomalies result;
+    std::map<Path, int> worst_spans;
+    TF_ASSERT_OK(ValidateFeatureStatisticsWithDriftWindow(
+        current, schema, /*environment=*/gtl::nullopt, window,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, validation_config, &result,
+        &worst_spans));
+    EXPECT_EQ(worst_spans,
+              (std::map<Path, int>({{Path({"f"}), 1}, {Path({"s", "c"}), 2}})));
+    ASSERT_EQ(result.anomaly_info_size(), 2);
+
+    // Each feature has the anomaly found against its worst span alone.
+    for (const auto& path_and_span : worst_spans) {
+      metadata::v0::Anomalies expected;
+      TF_ASSERT_OK(ValidateFeatureStatistics(
+          current, schema, /*environment=*/gtl::nullopt,
+          window[path_and_span.second],
+          /*serving_feature_statistics=*/gtl::nullopt,
+          /*features_needed=*/gtl::nullopt, validation_config, &expected));
+      const string name = path_and_span.first.Serialize();
+      ASSERT_EQ(1, expected.anomaly_info().count(name));
+      ASSERT_EQ(1, result.anomaly_info().count(name));
+      EXPECT_THAT(result.anomaly_info().at(name),
+                  EqualsProto(expected.anomaly_info().at(name)));
+    }
+  }
+
+  // Without a window, there is no drift.
+  metadata::v0::Anomalies result;
+  std::map<Path, int> worst_spans;
+  TF_ASSERT_OK(ValidateFeatureStatisticsWithDriftWindow(
+      current, schema, /*environment=*/gtl::nullopt, /*window=*/{},
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, ValidationConfig(), &result,
+      &worst_spans));
+  EXPECT_EQ(result.anomaly_info_size(), 0);
+  EXPECT_TRUE(worst_spans.empty());
+}
+
+TEST(FeatureStatisticsValidatorTest, ValidateBatchMatchesValidate) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" value: "C" }
+    feature {
+      name: "annotated_enum"
+      value_count: { min: 1 max: 1 }
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    })");
+
+  std::vector<DatasetFeatureStatistics> statistics;
+  // An unknown value and a new column.
+  statistics.push_back(ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+    num_examples: 10
+    features: {
+      name: 'annotated_enum'
+      type: STRING
+      string_stats: {
+        common_stats: {
+          num_non_missing: 10
+          min_num_values: 1
+          max_num_values: 1
+        }
+        unique: 1
+        rank_histogram: { buckets: { label: "D" sample_count: 10 } }
+      }
+    }
+    features: {
+      name: 'new_column'
+      type: INT
+      num_stats: {
+        common_stats: {
+          num_non_missing: 10
+          min_num_values: 1
+          max_num_values: 1
+        }
+      }
+    })"));
+  // No anomalies.
+  statistics.push_back(ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+    num_examples: 10
+    features: {
+      name: 'annotated_enum'
+      type: STRING
+      string_stats: {
+        common_stats: {
+          num_non_missing: 10
+          min_num_values: 1
+          max_num_values: 1
+        }
+        unique: 1
+        rank_histogram: { buckets: { label: "A" sample_count: 10 } }
+      }
+    })"));
+  // No data.
+  statistics.push_back(
+      ParseTextProtoOrDie<DatasetFeatureStatistics>("num_examples: 0"));
+
+  for (int num_threads : {1, 4}) {
+    ValidationConfig validation_config;
+    validation_config.set_num_threads(num_threads);
+    std::vector<tensorflow::metadata::v0::Anomalies> results;
+    TF_ASSERT_OK(ValidateFeatureStatisticsBatch(
+        statistics, schema, /*environment=*/gtl::nullopt, validation_config,
+        &results));
+    ASSERT_EQ(statistics.size(), results.size());
+    for (int i = 0; i < statistics.size(); ++i) {
+      tensorflow::metadata::v0::Anomalies expected;
+      TF_ASSERT_OK(ValidateFeatureStatistics(
+          statistics[i], schema, /*environment=*/gtl::nullopt,
+          /*prev_feature_statistics=*/gtl::nullopt,
+          /*serving_feature_statistics=*/gtl::nullopt,
+          /*features_needed=*/gtl::nullopt, ValidationConfig(), &expected));
+      ExpectSameAnomalies(expected, results[i]);
+    }
+    EXPECT_EQ(2, results[0].anomaly_info_size());
+    EXPECT_EQ(0, results[1].anomaly_info_size());
+    EXPECT_TRUE(results[2].data_missing());
+  }
+}
+
+TEST(FeatureStatisticsValidatorTest, ValidateBatchInvalidStatistics) {
+  string schema_string;
+  ASSERT_TRUE(Schema().SerializeToString(&schema_string));
+  string statistics_string;
+  ASSERT_TRUE(ParseTextProtoOrDie<DatasetFeatureStatistics>("num_examples: 0")
+                  .SerializeToString(&statistics_string));
+  std::vector<string> anomalies_strings;
+  EXPECT_FALSE(ValidateFeatureStatisticsBatch(
+                   {statistics_string, "not a statistics proto"},
+                   schema_string, /*environment=*/"", /*num_threads=*/2,
+                   &anomalies_strings)
+                   .ok());
+}
+
+TEST(FeatureStatisticsValidatorTest, ValidateBatchOfViews) {
+  const string schema_string = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: "feature"
+      type: INT
+      presence: { min_count: 1 }
+    })").SerializeAsString();
+  const string statistics_string =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 2
+        features: {
+          name: 'feature'
+          type: INT
+          num_stats: { common_stats: { num_non_missing: 2 } }
+        }
+        features: { name: 'new_feature' type: FLOAT num_stats: {} })")
+          .SerializeAsString();
+  const std::vector<string> statistics_strings = {statistics_string, ""};
+  std::vector<string> anomalies_strings;
+  TF_ASSERT_OK(ValidateFeatureStatisticsBatch(
+      statistics_strings, schema_string, /*environment=*/"",
+      /*num_threads=*/2, &anomalies_strings));
+  std::vector<tensorflow::metadata::v0::Anomalies> results;
+  TF_ASSERT_OK(ValidateFeatureStatisticsBatch(
+      std::vector<absl::string_view>(statistics_strings.begin(),
+                                     statistics_strings.end()),
+      schema_string, /*environment=*/"", /*num_threads=*/2, &results));
+  ASSERT_EQ(2, results.size());
+  for (int i = 0; i < 2; ++i) {
+    tensorflow::metadata::v0::Anomalies expected;
+    ASSERT_TRUE(expected.ParseFromString(anomalies_strings[i]));
+    ExpectSameAnomalies(expected, results[i]);
+  }
+  EXPECT_EQ(1, results[0].anomaly_info_size());
+  EXPECT_TRUE(results[1].data_missing());
+}
+
+TEST(FeatureStatisticsValidatorTest, SerializedProtosWithComparators) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: "annotated_enum"
+      type: BYTES
+      domain: "annotated_enum"
+      drift_comparator { infinity_norm { threshold: 0.01 } }
+    }
+    feature {
+      name: "other_enum"
+      type: BYTES
+      domain: "annotated_enum"
+      skew_comparator { infinity_norm { threshold: 0.01 } }
+    }
+    string_domain { name: "annotated_enum" value: "a" value: "b" })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 2
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 2 max_num_values: 1 }
+            rank_histogram {
+              buckets { label: "a" sample_count: 1 }
+              buckets { label: "b" sample_count: 1 }
+            }
+          }
+        }
+        features: {
+          name: 'other_enum'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 2 max_num_values: 1 }
+            rank_histogram {
+              buckets { label: "a" sample_count: 1 }
+              buckets { label: "b" sample_count: 1 }
+            }
+          }
+        })");
+  // Both features differ from statistics in the previous and the serving
+  // statistics, but only one of them is compared in each.
+  DatasetFeatureStatistics other_statistics = statistics;
+  for (auto& feature : *other_statistics.mutable_features()) {
+    feature.mutable_string_stats()
+        ->mutable_rank_histogram()
+        ->mutable_buckets(0)
+        ->set_sample_count(3);
+  }
+
+  tensorflow::metadata::v0::Anomalies expected;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, schema, /*environment=*/gtl::nullopt, other_statistics,
+      other_statistics, /*features_needed=*/gtl::nullopt, ValidationConfig(),
+      &expected));
+  string anomalies_string;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics.SerializeAsString(), schema.SerializeAsString(),
+      /*environment=*/"", other_statistics.SerializeAsString(),
+      other_statistics.SerializeAsString(), &anomalies_string));
+  tensorflow::metadata::v0::Anomalies result;
+  ASSERT_TRUE(result.ParseFromString(anomalies_string));
+  ExpectSameAnomalies(expected, result);
+  EXPECT_EQ(2, result.anomaly_info_size());
+
+  tensorflow::metadata::v0::Anomalies unserialized_result;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics.SerializeAsString(), schema.SerializeAsString(),
+      /*environment=*/"", other_statistics.SerializeAsString(),
+      other_statistics.SerializeAsString(), &unserialized_result));
+  ExpectSameAnomalies(expected, unserialized_result);
+}
+
+TEST(FeatureStatisticsValidatorTest, ValidateIntoArena) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" value: "C" }
+    feature {
+      name: "annotated_enum"
+      value_count: { min: 1 max: 1 }
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+            unique: 1
+            rank_histogram: { buckets: { label: "D" sample_count: 10 } }
+          }
+        }
+        features: {
+          name: 'new_column'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+          }
+        })");
+  tensorflow::metadata::v0::Anomalies expected;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, schema, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, ValidationConfig(), &expected));
+
+  protobuf::Arena arena;
+  // Owned by arena.
+  tensorflow::metadata::v0::Anomalies* result =
+      protobuf::Arena::CreateMessage<tensorflow::metadata::v0::Anomalies>(
+          &arena);
+  // Anything already in the result is replaced.
+  result->set_data_missing(true);
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, schema, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, ValidationConfig(), result));
+  ExpectSameAnomalies(expected, *result);
+  EXPECT_EQ(2, result->anomaly_info_size());
+  // The sub-messages are built in place, so they are on the arena too.
+  EXPECT_EQ(&arena, result->baseline().GetArena());
+  for (const auto& pair : result->anomaly_info()) {
+    EXPECT_EQ(&arena, pair.second.GetArena());
+    EXPECT_EQ(&arena, pair.second.path().GetArena());
+    for (const auto& reason : pair.second.reason()) {
+      EXPECT_EQ(&arena, reason.GetArena());
+    }
+  }
+}
+
+TEST(FeatureStatisticsValidatorTest, ValidateToSink) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" value: "C" }
+    feature {
+      name: "annotated_enum"
+      value_count: { min: 1 max: 1 }
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+            unique: 1
+            rank_histogram: { buckets: { label: "D" sample_count: 10 } }
+          }
+        }
+        features: {
+          name: 'new_column'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+          }
+        })");
+  tensorflow::metadata::v0::Anomalies expected;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, schema, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, ValidationConfig(), &expected));
+
+  // The bytes written parse as the result of ValidateFeatureStatistics().
+  string serialized;
+  SerializedAnomaliesSink serialized_sink(
+      [&serialized](absl::string_view data) {
+        serialized.append(data.data(), data.size());
+        return Status::OK();
+      });
+  TF_ASSERT_OK(ValidateFeatureStatisticsToSink(
+      statistics, schema, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, ValidationConfig(),
+      /*include_baseline=*/true, &serialized_sink));
+  tensorflow::metadata::v0::Anomalies result;
+  ASSERT_TRUE(result.ParseFromString(serialized));
+  ExpectSameAnomalies(expected, result);
+
+  // Without the baseline, and with the anomalies passed one at a time.
+  CompiledSchemaValidator validator;
+  TF_ASSERT_OK(validator.Init(schema, ValidationConfig()));
+  std::vector<string> names;
+  CallbackAnomalySink callback_sink(
+      [&names, &expected](
+          const string& name,
+          const tensorflow::metadata::v0::AnomalyInfo& anomaly_info) {
+        names.push_back(name);
+        EXPECT_THAT(anomaly_info,
+                    EqualsProto(expected.anomaly_info().at(name)));
+        return Status::OK();
+      });
+  TF_ASSERT_OK(validator.ValidateToSink(
+      statistics, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, /*include_baseline=*/false,
+      &callback_sink));
+  EXPECT_EQ(std::vector<string>({"annotated_enum", "new_column"}), names);
+
+  serialized.clear();
+  TF_ASSERT_OK(validator.ValidateToSink(
+      statistics, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, /*include_baseline=*/false,
+      &serialized_sink));
+  ASSERT_TRUE(result.ParseFromString(serialized));
+  EXPECT_FALSE(result.has_baseline());
+  EXPECT_EQ(2, result.anomaly_info_size());
+
+  // An error of the sink is returned.
+  CallbackAnomalySink failing_sink(
+      [](const string& name,
+         const tensorflow::metadata::v0::AnomalyInfo& anomaly_info) {
+        return errors::Internal("Sink is full");
+      });
+  EXPECT_FALSE(validator
+                   .ValidateToSink(statistics, /*environment=*/gtl::nullopt,
+                                   /*prev_feature_statistics=*/gtl::nullopt,
+                                   /*serving_feature_statistics=*/gtl::nullopt,
+                                   /*features_needed=*/gtl::nullopt,
+                                   /*include_baseline=*/false, &failing_sink)
+                   .ok());
+  EXPECT_FALSE(validator
+                   .ValidateToSink(statistics, /*environment=*/gtl::nullopt,
+                                   /*prev_feature_statistics=*/gtl::nullopt,
+                                   /*serving_feature_statistics=*/gtl::nullopt,
+                                   /*features_needed=*/gtl::nullopt,
+                                   /*include_baseline=*/false, nullptr)
+                   .ok());
+}
+
+TEST(FeatureStatisticsValidatorTest, ValidateToSinkDataMissing) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    feature { name: "a" type: INT presence: { min_count: 1 } })");
+  string serialized;
+  SerializedAnomaliesSink sink([&serialized](absl::string_view data) {
+    serialized.append(data.data(), data.size());
+    return Status::OK();
+  });
+  TF_ASSERT_OK(ValidateFeatureStatisticsToSink(
+      DatasetFeatureStatistics(), schema, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, ValidationConfig(),
+      /*include_baseline=*/true, &sink));
+  tensorflow::metadata::v0::Anomalies result;
+  ASSERT_TRUE(result.ParseFromString(serialized));
+  EXPECT_TRUE(result.data_missing());
+  EXPECT_THAT(result.baseline(), EqualsProto(schema));
+  EXPECT_EQ(0, result.anomaly_info_size());
+}
+
+
+TEST(FeatureStatisticsValidatorTest, ValidateWithProfile) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" }
+    feature {
+      name: "annotated_enum"
+      type: BYTES
+      domain: "MyAloneEnum"
+      drift_comparator { infinity_norm { threshold: 0.01 } }
+    }
+    feature { name: "int_feature" type: INT int_domain { min: 0 } }
+    feature { name: "missing_feature" type: INT presence { min_count: 1 } })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 10 max_num_values: 1 }
+            rank_histogram: { buckets: { label: "A" sample_count: 10 } }
+          }
+        }
+        features: {
+          name: 'int_feature'
+          type: INT
+          num_stats: {
+            common_stats: { num_non_missing: 10 max_num_values: 1 }
+            min: -1
+          }
+        }
+        features: {
+          name: 'new_column'
+          type: INT
+          num_stats: { common_stats: { num_non_missing: 10 } }
+        })");
+  const DatasetFeatureStatistics prev_statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 10 max_num_values: 1 }
+            rank_histogram: { buckets: { label: "B" sample_count: 10 } }
+          }
+        })");
+  ValidationConfig validation_config;
+  validation_config.set_num_slowest_features_to_profile(2);
+
+  tensorflow::metadata::v0::Anomalies expected;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, schema, /*environment=*/gtl::nullopt, prev_statistics,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, validation_config, &expected));
+  tensorflow::metadata::v0::Anomalies result;
+  ValidationProfile profile;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, schema, /*environment=*/gtl::nullopt, prev_statistics,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, validation_config, &result,
+      &profile));
+  // Profiling does not change the anomalies.
+  ExpectSameAnomalies(expected, result);
+  EXPECT_EQ(4, result.anomaly_info_size());
+
+  std::map<string, int64> num_calls;
+  for (const ValidationProfile::Phase& phase : profile.phases()) {
+    num_calls[phase.name()] = phase.num_calls();
+    EXPECT_GE(phase.wall_time_seconds(), 0.0);
+  }
+  EXPECT_EQ((std::map<string, int64>{{"view_construction", 1},
+                                     {"find_changes", 1},
+                                     {"missing_paths", 1},
+                                     {"comparators", 1},
+                                     {"schema_diff", 1}}),
+            num_calls);
+  // Only the two slowest of the three root features are kept.
+  ASSERT_EQ(2, profile.slowest_features_size());
+  const std::map<string, string> domain_types = {
+      {"annotated_enum", "domain"},
+      {"int_feature", "int_domain"},
+      {"new_column", "new_feature"}};
+  for (const ValidationProfile::Feature& feature :
+       profile.slowest_features()) {
+    ASSERT_EQ(1, domain_types.count(feature.path())) << feature.path();
+    EXPECT_EQ(domain_types.at(feature.path()), feature.domain_type());
+  }
+  EXPECT_GE(profile.slowest_features(0).wall_time_seconds(),
+            profile.slowest_features(1).wall_time_seconds());
+}
+
+TEST(FeatureStatisticsValidatorTest, CompiledSchemaValidator) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    default_environment: "TRAINING"
+    default_environment: "SERVING"
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" value: "C" }
+    feature {
+      name: "annotated_enum"
+      value_count: { min: 1 max: 1 }
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    }
+    feature {
+      name: "label"
+      not_in_environment: "SERVING"
+      value_count { min: 1 max: 1 }
+      presence { min_count: 1 }
+      type: BYTES
+    })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+            unique: 2
+            rank_histogram: {
+              buckets: { label: "A" sample_count: 5 }
+              buckets: { label: "D" sample_count: 5 }
+            }
+          }
+        })");
+  ValidationConfig validation_config;
+  validation_config.set_new_features_are_warnings(true);
+  CompiledSchemaValidator validator;
+  TF_ASSERT_OK(validator.Init(schema, validation_config));
+  EXPECT_FALSE(validator.Init(schema, validation_config).ok());
+
+  // Each environment is validated twice, to check that nothing is carried
+  // over from one call to the next.
+  for (const gtl::optional<string>& environment :
+       {gtl::optional<string>(), gtl::optional<string>("TRAINING"),
+        gtl::optional<string>("SERVING"), gtl::optional<string>(),
+        gtl::optional<string>("TRAINING"), gtl::optional<string>("SERVING")}) {
+    tensorflow::metadata::v0::Anomalies expected;
+    TF_ASSERT_OK(ValidateFeatureStatistics(
+        statistics, schema, environment,
+        /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, validation_config, &expected));
+    tensorflow::metadata::v0::Anomalies result;
+    TF_ASSERT_OK(validator.Validate(statistics, environment,
+                                    /*prev_feature_statistics=*/gtl::nullopt,
+                                    /*serving_feature_statistics=*/gtl::nullopt,
+                                    /*features_needed=*/gtl::nullopt,
+                                    &result));
+    ExpectSameAnomalies(expected, result);
+    EXPECT_EQ(environment == gtl::optional<string>("SERVING") ? 1 : 2,
+              result.anomaly_info_size());
+  }
+}
+
+TEST(FeatureStatisticsValidatorTest, CompiledSchemaValidatorNotInitialized) {
+  CompiledSchemaValidator validator;
+  tensorflow::metadata::v0::Anomalies result;
+  EXPECT_FALSE(validator
+                   .Validate(DatasetFeatureStatistics(),
+                             /*environment=*/gtl::nullopt,
+                             /*prev_feature_statistics=*/gtl::nullopt,
+                             /*serving_feature_statistics=*/gtl::nullopt,
+                             /*features_needed=*/gtl::nullopt, &result)
+                   .ok());
+}
+
+TEST(FeatureStatisticsValidatorTest, CompiledSchemaValidatorSerialized) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    default_environment: "TRAINING"
+    default_environment: "SERVING"
+    feature {
+      name: "annotated_enum"
+      type: BYTES
+      domain: "annotated_enum"
+      drift_comparator { infinity_norm { threshold: 0.01 } }
+    }
+    feature {
+      name: "label"
+      not_in_environment: "SERVING"
+      presence { min_count: 1 }
+      type: BYTES
+      skew_comparator { infinity_norm { threshold: 0.01 } }
+    }
+    string_domain { name: "annotated_enum" value: "a" value: "b" })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 2
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 2 max_num_values: 1 }
+            rank_histogram {
+              buckets { label: "a" sample_count: 1 }
+              buckets { label: "b" sample_count: 1 }
+            }
+          }
+        }
+        features: {
+          name: 'label'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 2 max_num_values: 1 }
+            rank_histogram {
+              buckets { label: "a" sample_count: 1 }
+              buckets { label: "b" sample_count: 1 }
+            }
+          }
+        })");
+  DatasetFeatureStatistics other_statistics = statistics;
+  for (auto& feature : *other_statistics.mutable_features()) {
+    feature.mutable_string_stats()
+        ->mutable_rank_histogram()
+        ->mutable_buckets(0)
+        ->set_sample_count(3);
+  }
+  const string statistics_string = statistics.SerializeAsString();
+  const string other_statistics_string = other_statistics.SerializeAsString();
+
+  CompiledSchemaValidator validator;
+  TF_ASSERT_OK(validator.Init(schema.SerializeAsString(), ValidationConfig()));
+  for (const char* environment : {"", "TRAINING", "SERVING"}) {
+    for (const string& previous_statistics_string :
+         {string(), other_statistics_string}) {
+      for (const string& serving_statistics_string :
+           {string(), other_statistics_string}) {
+        string expected_string;
+        TF_ASSERT_OK(ValidateFeatureStatistics(
+            statistics_string, schema.SerializeAsString(), environment,
+            previous_statistics_string, serving_statistics_string,
+            &expected_string));
+        tensorflow::metadata::v0::Anomalies expected;
+        ASSERT_TRUE(expected.ParseFromString(expected_string));
+        tensorflow::metadata::v0::Anomalies result;
+        TF_ASSERT_OK(validator.Validate(statistics_string, environment,
+                                        previous_statistics_string,
+                                        serving_statistics_string, &result));
+        ExpectSameAnomalies(expected, result);
+      }
+    }
+  }
+
+  tensorflow::metadata::v0::Anomalies result;
+  EXPECT_FALSE(validator
+                   .Validate("not a statistics proto", /*environment=*/"",
+                             /*previous_statistics_proto_string=*/"",
+                             /*serving_statistics_proto_string=*/"", &result)
+                   .ok());
+  CompiledSchemaValidator invalid_validator;
+  EXPECT_FALSE(
+      invalid_validator.Init("not a schema proto", ValidationConfig()).ok());
+}
+
+TEST(FeatureStatisticsValidatorTest, CompiledSchemaValidatorSlices) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" }
+    feature {
+      name: "annotated_enum"
+      value_count: { min: 1 max: 1 }
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    })");
+  const DatasetFeatureStatisticsList statistics_list =
+      ParseTextProtoOrDie<DatasetFeatureStatisticsList>(R"(
+        datasets {
+          name: "us"
+          num_examples: 10
+          features: {
+            name: 'annotated_enum'
+            type: STRING
+            string_stats: {
+              common_stats: {
+                num_non_missing: 10
+                min_num_values: 1
+                max_num_values: 1
+              }
+              rank_histogram: {
+                buckets: { label: "A" sample_count: 5 }
+                buckets: { label: "D" sample_count: 5 }
+              }
+            }
+          }
+        }
+        datasets {
+          name: "fr"
+          num_examples: 10
+          features: {
+            name: 'annotated_enum'
+            type: STRING
+            string_stats: {
+              common_stats: {
+                num_non_missing: 10
+                min_num_values: 1
+                max_num_values: 1
+              }
+              rank_histogram: { buckets: { label: "B" sample_count: 10 } }
+            }
+          }
+        }
+        datasets { name: "empty" })");
+  CompiledSchemaValidator validator;
+  TF_ASSERT_OK(validator.Init(schema, ValidationConfig()));
+  for (const int num_threads : {1, 4}) {
+    std::map<string, tensorflow::metadata::v0::Anomalies> results;
+    TF_ASSERT_OK(validator.ValidateSlices(statistics_list,
+                                          /*environment=*/gtl::nullopt,
+                                          num_threads, &results));
+    std::map<string, tensorflow::metadata::v0::Anomalies> serialized_results;
+    TF_ASSERT_OK(validator.ValidateSlices(statistics_list.SerializeAsString(),
+                                          /*environment=*/"", num_threads,
+                                          &serialized_results));
+    ASSERT_EQ(3, results.size());
+    ASSERT_EQ(3, serialized_results.size());
+    for (const DatasetFeatureStatistics& slice : statistics_list.datasets()) {
+      tensorflow::metadata::v0::Anomalies expected;
+      TF_ASSERT_OK(validator.Validate(
+          slice, /*environment=*/gtl::nullopt,
+          /*prev_feature_statistics=*/gtl::nullopt,
+          /*serving_feature_statistics=*/gtl::nullopt,
+          /*features_needed=*/gtl::nullopt, &expected));
+      ExpectSameAnomalies(expected, results.at(slice.name()));
+      ExpectSameAnomalies(expected, serialized_results.at(slice.name()));
+    }
+    EXPECT_EQ(1, results.at("us").anomaly_info_size());
+    EXPECT_EQ(0, results.at("fr").anomaly_info_size());
+    EXPECT_TRUE(results.at("empty").data_missing());
+  }
+
+  std::map<string, tensorflow::metadata::v0::Anomalies> results;
+  DatasetFeatureStatisticsList duplicate_list = statistics_list;
+  duplicate_list.mutable_datasets(1)->set_name("us");
+  EXPECT_FALSE(validator
+                   .ValidateSlices(duplicate_list,
+                                   /*environment=*/gtl::nullopt,
+                                   /*num_threads=*/2, &results)
+                   .ok());
+  EXPECT_FALSE(validator
+                   .ValidateSlices("not a statistics list",
+                                   /*environment=*/"", /*num_threads=*/2,
+                                   &results)
+                   .ok());
+}
+
+TEST(FeatureStatisticsValidatorTest, CompiledSchemaValidatorFromImage) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    default_environment: "TRAINING"
+    default_environment: "SERVING"
+    string_domain { name: "MyEnum" value: "A" value: "B" }
+    feature {
+      name: "feature"
+      presence { min_count: 1 }
+      type: BYTES
+    }
+    feature {
+      name: "label"
+      not_in_environment: "SERVING"
+      presence { min_count: 1 }
+      type: BYTES
+    }
+    feature {
+      name: "annotated_enum"
+      presence { min_count: 1 }
+      type: BYTES
+      domain: "MyEnum"
+    })");
+  // The values of annotated_enum are read from the table of the image.
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 10 max_num_values: 1 }
+            unique: 2
+            rank_histogram: {
+              buckets: { label: "A" sample_count: 9 }
+              buckets: { label: "D" sample_count: 1 }
+            }
+          }
+        })");
+  string buffer;
+  TF_ASSERT_OK(BuildCompiledSchemaImage(schema, &buffer));
+  auto image = std::make_shared<CompiledSchemaImage>();
+  TF_ASSERT_OK(image->Init(buffer));
+  CompiledSchemaValidator validator;
+  EXPECT_FALSE(validator.Init(std::shared_ptr<const CompiledSchemaImage>(),
+                              ValidationConfig())
+                   .ok());
+  TF_ASSERT_OK(validator.Init(image, ValidationConfig()));
+  CompiledSchemaValidator expected_validator;
+  TF_ASSERT_OK(expected_validator.Init(schema, ValidationConfig()));
+  for (const gtl::optional<string>& environment :
+       {gtl::optional<string>(), gtl::optional<string>("TRAINING"),
+        gtl::optional<string>("SERVING")}) {
+    tensorflow::metadata::v0::Anomalies expected;
+    TF_ASSERT_OK(expected_validator.Validate(
+        statistics, environment, /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, &expected));
+    tensorflow::metadata::v0::Anomalies result;
+    TF_ASSERT_OK(validator.Validate(
+        statistics, environment, /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, &result));
+    ExpectSameAnomalies(expected, result);
+    EXPECT_EQ(environment == gtl::optional<string>("SERVING") ? 2 : 3,
+              result.anomaly_info_size());
+    EXPECT_EQ(1, result.anomaly_info().count("annotated_enum"));
+  }
+}
+
+// A StringDomain checked with a filter of its values gives the same anomalies
+// as an exact one for values that are clearly missing.
+TEST(FeatureStatisticsValidatorTest,
+     CompiledSchemaValidatorApproximateStringDomains) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" value: "C" }
+    feature {
+      name: "annotated_enum"
+      value_count: { min: 1 max: 1 }
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+              avg_num_values: 1
+            }
+            unique: 2
+            rank_histogram: {
+              buckets: { label: "A" sample_count: 5 }
+              buckets: { label: "D" sample_count: 5 }
+            }
+          }
+        })");
+  CompiledSchemaValidator expected_validator;
+  TF_ASSERT_OK(expected_validator.Init(schema, ValidationConfig()));
+  tensorflow::metadata::v0::Anomalies expected;
+  TF_ASSERT_OK(expected_validator.Validate(
+      statistics, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, &expected));
+  ASSERT_EQ(1, expected.anomaly_info_size());
+
+  ValidationConfig validation_config;
+  validation_config.mutable_approximate_string_domains()->set_min_num_values(
+      1);
+  CompiledSchemaValidator validator;
+  TF_ASSERT_OK(validator.Init(schema, validation_config));
+  // The second call checks that the StringDomain of the schema was not
+  // updated by the first.
+  for (int i = 0; i < 2; ++i) {
+    tensorflow::metadata::v0::Anomalies result;
+    TF_ASSERT_OK(validator.Validate(
+        statistics, /*environment=*/gtl::nullopt,
+        /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, &result));
+    ExpectSameAnomalies(expected, result);
+  }
+}
+
+TEST(FeatureStatisticsValidatorTest, MaxValuesInDescription) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" }
+    feature {
+      name: "annotated_enum"
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+              avg_num_values: 1
+            }
+            unique: 4
+            rank_histogram: {
+              buckets: { label: "A" sample_count: 2 }
+              buckets: { label: "B" sample_count: 2 }
+              buckets: { label: "C" sample_count: 5 }
+              buckets: { label: "D" sample_count: 1 }
+            }
+          }
+        })");
+  ValidationConfig validation_config;
+  validation_config.set_max_values_in_description(1);
+  tensorflow::metadata::v0::Anomalies result;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, schema, /*environment=*/gtl::nullopt,
+      /*prev_feature_statistics=*/gtl::nullopt,
+      /*serving_feature_statistics=*/gtl::nullopt,
+      /*features_needed=*/gtl::nullopt, validation_config, &result));
+  ASSERT_EQ(1, result.anomaly_info_size());
+  const tensorflow::metadata::v0::AnomalyInfo& anomaly_info =
+      result.anomaly_info().at("annotated_enum");
+  EXPECT_EQ(
+      "Examples contain values missing from the schema: C (~50%), and 2 "
+      "other values (~30%). ",
+      anomaly_info.description());
+}
+
+TEST(FeatureStatisticsValidatorTest, IncrementalSchemaValidator) {
+  const Schema schema = ParseTextProtoOrDie<Schema>(R"(
+    string_domain { name: "MyAloneEnum" value: "A" value: "B" value: "C" }
+    feature {
+      name: "annotated_enum"
+      value_count: { min: 1 max: 1 }
+      presence: { min_count: 1 }
+      type: BYTES
+      domain: "MyAloneEnum"
+    }
+    feature {
+      name: "int_feature"
+      value_count: { min: 1 max: 1 }
+      type: INT
+    }
+    feature {
+      name: "label"
+      value_count { min: 1 max: 1 }
+      presence { min_count: 1 }
+      type: BYTES
+    })");
+  Schema new_schema = schema;
+  new_schema.mutable_feature(1)->mutable_value_count()->set_min(2);
+  new_schema.mutable_feature(1)->mutable_value_count()->set_max(2);
+
+  const DatasetFeatureStatistics unknown_value =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+            unique: 1
+            rank_histogram: { buckets: { label: "D" sample_count: 10 } }
+          }
+        }
+        features: {
+          name: 'int_feature'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+          }
+        })");
+  DatasetFeatureStatistics known_value = unknown_value;
+  known_value.mutable_features(0)
+      ->mutable_string_stats()
+      ->mutable_rank_histogram()
+      ->mutable_buckets(0)
+      ->set_label("A");
+  DatasetFeatureStatistics more_examples = known_value;
+  more_examples.set_num_examples(20);
+
+  ValidationConfig validation_config;
+  IncrementalSchemaValidator validator;
+  TF_ASSERT_OK(validator.Init(schema, validation_config));
+  EXPECT_FALSE(validator.Init(schema, validation_config).ok());
+
+  // Each step is the schema and the statistics to validate, and the number
+  // of root features that are expected to be validated.
+  struct Step {
+    const Schema* schema;
+    const DatasetFeatureStatistics* statistics;
+    int num_root_features_validated;
+  };
+  const Schema* current_schema = &schema;
+  for (const Step& step : std::vector<Step>{{&schema, &unknown_value, 2},
+                                            {&schema, &unknown_value, 0},
+                                            {&schema, &known_value, 1},
+                                            {&new_schema, &known_value, 1},
+                                            {&new_schema, &more_examples, 2},
+                                            {&schema, &unknown_value, 2}}) {
+    if (step.schema != current_schema) {
+      TF_ASSERT_OK(validator.SetSchema(*step.schema));
+      current_schema = step.schema;
+    }
+    tensorflow::metadata::v0::Anomalies expected;
+    TF_ASSERT_OK(ValidateFeatureStatistics(
+        *step.statistics, *step.schema, /*environment=*/gtl::nullopt,
+        /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, validation_config, &expected));
+    tensorflow::metadata::v0::Anomalies result;
+    TF_ASSERT_OK(validator.Validate(*step.statistics,
+                                    /*environment=*/gtl::nullopt,
+                                    /*prev_feature_statistics=*/gtl::nullopt,
+                                    /*serving_feature_statistics=*/gtl::nullopt,
+                                    /*features_needed=*/gtl::nullopt,
+                                    &result));
+    ExpectSameAnomalies(expected, result);
+    EXPECT_EQ(step.num_root_features_validated,
+              validator.num_root_features_validated());
+  }
+}
+
+TEST(FeatureStatisticsValidatorTest, IncrementalSchemaValidatorNotInitialized) {
+  IncrementalSchemaValidator validator;
+  EXPECT_FALSE(validator.SetSchema(Schema()).ok());
+  tensorflow::metadata::v0::Anomalies result;
+  EXPECT_FALSE(validator
+                   .Validate(DatasetFeatureStatistics(),
+                             /*environment=*/gtl::nullopt,
+                             /*prev_feature_statistics=*/gtl::nullopt,
+                             /*serving_feature_statistics=*/gtl::nullopt,
+                             /*features_needed=*/gtl::nullopt, &result)
+                   .ok());
+}
+
 }  // namespace
 }  // namespace data_validation
 }  // namespace tensorflow
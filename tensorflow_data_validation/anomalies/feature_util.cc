@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/feature_util.h"
 
+#include <algorithm>
 #include <string>
 
 #include "absl/strings/str_cat.h"
@@ -95,6 +96,41 @@ std::vector<Description> UpdateValueCount(
   return description;
 }
 
+bool IsFeatureTypeAllowed(Feature::DomainInfoCase domain_info_case,
+                          tensorflow::metadata::v0::FeatureType type) {
+  constexpr uint32 kBytes = 1u << tensorflow::metadata::v0::BYTES;
+  constexpr uint32 kInt = 1u << tensorflow::metadata::v0::INT;
+  constexpr uint32 kFloat = 1u << tensorflow::metadata::v0::FLOAT;
+  constexpr uint32 kStruct = 1u << tensorflow::metadata::v0::STRUCT;
+  uint32 allowed_types;
+  switch (domain_info_case) {
+    case Feature::kDomain:
+      allowed_types = kBytes;
+      break;
+    case Feature::kBoolDomain:
+      allowed_types = kInt | kBytes;
+      break;
+    case Feature::kIntDomain:
+      allowed_types = kInt | kBytes;
+      break;
+    case Feature::kFloatDomain:
+      allowed_types = kFloat | kBytes;
+      break;
+    case Feature::kStringDomain:
+      allowed_types = kBytes;
+      break;
+    case Feature::kStructDomain:
+      allowed_types = kStruct;
+      break;
+    case Feature::DOMAIN_INFO_NOT_SET:
+      ABSL_FALLTHROUGH_INTENDED;
+    default:
+      allowed_types = kInt | kFloat | kBytes | kStruct;
+  }
+  // TYPE_UNKNOWN (and any type out of the range of the mask) is not allowed.
+  return type > 0 && type < 32 && (allowed_types & (1u << type)) != 0;
+}
+
 bool FeatureHasComparator(const Feature& feature,
                           ComparatorType comparator_type) {
   switch (comparator_type) {
@@ -165,7 +201,22 @@ bool SparseFeatureIsDeprecated(const SparseFeature& sparse_feature) {
 std::vector<Description> UpdateFeatureComparatorDirect(
     const FeatureStatsView& stats, const ComparatorType comparator_type,
     tensorflow::metadata::v0::FeatureComparator* comparator) {
-  if (!comparator->infinity_norm().has_threshold()) {
+  return UpdateFeatureComparatorDirect(stats, comparator_type,
+                                       DistributionDistanceThresholds(),
+                                       comparator);
+}
+
+std::vector<Description> UpdateFeatureComparatorDirect(
+    const FeatureStatsView& stats, const ComparatorType comparator_type,
+    const DistributionDistanceThresholds& thresholds,
+    tensorflow::metadata::v0::FeatureComparator* comparator) {
+  const bool check_infinity_norm = comparator->infinity_norm().has_threshold();
+  const bool check_jensen_shannon_divergence =
+      thresholds.jensen_shannon_divergence() > 0.0;
+  const bool check_population_stability_index =
+      thresholds.population_stability_index() > 0.0;
+  if (!check_infinity_norm && !check_jensen_shannon_divergence &&
+      !check_population_stability_index) {
     // There is nothing to check.
     return {};
   }
@@ -173,14 +224,16 @@ std::vector<Description> UpdateFeatureComparatorDirect(
   absl::optional<FeatureStatsView> treatment_stats =
       GetTreatmentStats(stats, comparator_type);
   if (treatment_stats) {
+    // All the distances are computed in one pass over the distributions.
+    const DistributionDistances distances =
+        GetDistributionDistances(stats, *treatment_stats);
+    std::vector<Description> descriptions;
     const double threshold = comparator->infinity_norm().threshold();
-    const std::pair<string, double> distance =
-        LInftyDistance(stats, *treatment_stats);
-    const string max_difference_value = distance.first;
-    const double stats_infinity_norm = distance.second;
-    if (stats_infinity_norm > threshold) {
+    const string& max_difference_value = distances.l_infty_value;
+    const double stats_infinity_norm = distances.l_infty;
+    if (check_infinity_norm && stats_infinity_norm > threshold) {
       comparator->mutable_infinity_norm()->set_threshold(stats_infinity_norm);
-      return {
+      descriptions.push_back(
           {tensorflow::metadata::v0::AnomalyInfo::COMPARATOR_L_INFTY_HIGH,
            absl::StrCat("High Linfty distance between ", context.treatment_name,
                         " and ", context.control_name),
@@ -190,12 +243,46 @@ std::vector<Description> UpdateFeatureComparatorDirect(
                         " (up to six significant digits), above the threshold ",
                         absl::SixDigits(threshold),
                         ". The feature value with maximum difference is: ",
-                        max_difference_value)}};
+                        max_difference_value)});
     }
-
+    // The anomaly types in tensorflow_metadata have no reason for these
+    // distances.
+    if (check_jensen_shannon_divergence &&
+        distances.jensen_shannon_divergence >
+            thresholds.jensen_shannon_divergence()) {
+      descriptions.push_back(
+          {tensorflow::metadata::v0::AnomalyInfo::UNKNOWN_TYPE,
+           absl::StrCat("High Jensen-Shannon divergence between ",
+                        context.treatment_name, " and ", context.control_name),
+           absl::StrCat("The Jensen-Shannon divergence between ",
+                        context.treatment_name, " and ", context.control_name,
+                        " is ",
+                        absl::SixDigits(distances.jensen_shannon_divergence),
+                        " (up to six significant digits), above the threshold ",
+                        absl::SixDigits(thresholds.jensen_shannon_divergence()),
+                        ".")});
+    }
+    if (check_population_stability_index &&
+        distances.population_stability_index >
+            thresholds.population_stability_index()) {
+      descriptions.push_back(
+          {tensorflow::metadata::v0::AnomalyInfo::UNKNOWN_TYPE,
+           absl::StrCat("High population stability index between ",
+                        context.treatment_name, " and ", context.control_name),
+           absl::StrCat(
+               "The population stability index between ",
+               context.treatment_name, " and ", context.control_name, " is ",
+               absl::SixDigits(distances.population_stability_index),
+               " (up to six significant digits), above the threshold ",
+               absl::SixDigits(thresholds.population_stability_index()),
+               ".")});
+    }
+    return descriptions;
   } else if (HasTreatmentDataset(stats, comparator_type)) {
     // Treatment is missing.
-    comparator->mutable_infinity_norm()->clear_threshold();
+    if (check_infinity_norm) {
+      comparator->mutable_infinity_norm()->clear_threshold();
+    }
     return {{tensorflow::metadata::v0::AnomalyInfo::
                  COMPARATOR_TREATMENT_DATA_MISSING,
              absl::StrCat(context.treatment_name, " data missing"),
@@ -262,8 +349,13 @@ std::vector<Description> UpdatePresence(
     tensorflow::metadata::v0::FeaturePresence* presence) {
   std::vector<Description> descriptions;
   const optional<double> num_present = feature_stats_view.GetNumPresent();
+  // Over a sample of the examples, the feature is only reported as present in
+  // too few of them if the upper bound of its confidence interval is too low,
+  // so that sampling noise is not reported.
+  const double num_present_upper_bound =
+      feature_stats_view.GetNumPresentUpperBound();
   if (presence->has_min_count() && num_present) {
-    if (*num_present < presence->min_count()) {
+    if (num_present_upper_bound < presence->min_count()) {
       presence->set_min_count(*num_present);
       descriptions.push_back(
           {tensorflow::metadata::v0::AnomalyInfo::
@@ -275,7 +367,12 @@ std::vector<Description> UpdatePresence(
   const optional<double> fraction_present =
       feature_stats_view.GetFractionPresent();
   if (presence->has_min_fraction() && fraction_present) {
-    if (*fraction_present < presence->min_fraction()) {
+    const double num_examples = feature_stats_view.GetNumExamples();
+    const double fraction_present_upper_bound =
+        num_examples > 0.0 ? std::max(*fraction_present,
+                                      num_present_upper_bound / num_examples)
+                           : *fraction_present;
+    if (fraction_present_upper_bound < presence->min_fraction()) {
       presence->set_min_fraction(*fraction_present);
       descriptions.push_back(
           {tensorflow::metadata::v0::AnomalyInfo::
@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow_data_validation/anomalies/internal_types.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
 #include "tensorflow_metadata/proto/v0/schema.pb.h"
 
@@ -38,6 +39,13 @@ std::vector<Description> UpdatePresence(
     const FeatureStatsView& feature_stats_view,
     tensorflow::metadata::v0::FeaturePresence* presence);
 
+// Returns true if a feature with a domain of domain_info_case can have type.
+// This is called for every feature that is updated, so it tests a bit mask
+// rather than building the set of the allowed types.
+bool IsFeatureTypeAllowed(
+    tensorflow::metadata::v0::Feature::DomainInfoCase domain_info_case,
+    tensorflow::metadata::v0::FeatureType type);
+
 bool FeatureHasComparator(const tensorflow::metadata::v0::Feature& feature,
                           ComparatorType comparator_type);
 
@@ -51,6 +59,14 @@ std::vector<Description> UpdateFeatureComparatorDirect(
     const FeatureStatsView& stats, const ComparatorType comparator_type,
     tensorflow::metadata::v0::FeatureComparator* comparator);
 
+// Same as above, but also checks the distances in thresholds. The schema
+// has no place for these thresholds, so unlike the infinity_norm, they are
+// not changed to fit the data.
+std::vector<Description> UpdateFeatureComparatorDirect(
+    const FeatureStatsView& stats, const ComparatorType comparator_type,
+    const DistributionDistanceThresholds& thresholds,
+    tensorflow::metadata::v0::FeatureComparator* comparator);
+
 // Initializes the value count and presence given a feature_stats_view.
 // This is called when a Feature is first created from a FeatureStatsView.
 // It infers OPTIONAL, REPEATED, REQUIRED (in the proto sense),
@@ -109,6 +109,30 @@ TEST(FeatureUtilTest, ClearDomain) {
   EXPECT_EQ(feature.domain_info_case(), Feature::DOMAIN_INFO_NOT_SET);
 }
 
+TEST(FeatureUtilTest, IsFeatureTypeAllowed) {
+  EXPECT_TRUE(IsFeatureTypeAllowed(Feature::kIntDomain,
+                                   tensorflow::metadata::v0::INT));
+  EXPECT_TRUE(IsFeatureTypeAllowed(Feature::kIntDomain,
+                                   tensorflow::metadata::v0::BYTES));
+  EXPECT_FALSE(IsFeatureTypeAllowed(Feature::kIntDomain,
+                                    tensorflow::metadata::v0::FLOAT));
+  EXPECT_TRUE(IsFeatureTypeAllowed(Feature::kFloatDomain,
+                                   tensorflow::metadata::v0::FLOAT));
+  EXPECT_FALSE(IsFeatureTypeAllowed(Feature::kStringDomain,
+                                    tensorflow::metadata::v0::INT));
+  EXPECT_TRUE(IsFeatureTypeAllowed(Feature::kStructDomain,
+                                   tensorflow::metadata::v0::STRUCT));
+  EXPECT_FALSE(IsFeatureTypeAllowed(Feature::kStructDomain,
+                                    tensorflow::metadata::v0::BYTES));
+  EXPECT_TRUE(IsFeatureTypeAllowed(Feature::DOMAIN_INFO_NOT_SET,
+                                   tensorflow::metadata::v0::STRUCT));
+  // A feature of unknown type cannot have a domain, nor lack one.
+  EXPECT_FALSE(IsFeatureTypeAllowed(Feature::DOMAIN_INFO_NOT_SET,
+                                    tensorflow::metadata::v0::TYPE_UNKNOWN));
+  EXPECT_FALSE(IsFeatureTypeAllowed(Feature::kBoolDomain,
+                                    tensorflow::metadata::v0::TYPE_UNKNOWN));
+}
+
 TEST(FeatureUtilTest, FeatureIsDeprecated) {
   for (const auto& test : GetFeatureIsDeprecatedTests()) {
     EXPECT_EQ(FeatureIsDeprecated(test.feature_proto), test.is_deprecated)
@@ -1035,6 +1059,53 @@ TEST(FeatureTypeTest, UpdatePresenceTest) {
   }
 }
 
+TEST(FeatureTypeTest, UpdatePresenceOverSample) {
+  // The feature was present in 3 of the 10 examples sampled, out of 20.
+  DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+          num_examples: 20
+          weighted_num_examples: 20
+          features {
+            name: "sampled"
+            type: INT
+            num_stats: {
+              common_stats: {
+                num_missing: 14
+                num_non_missing: 6
+                min_num_values: 1
+                max_num_values: 1
+                weighted_common_stats { num_non_missing: 6 num_missing: 14 }
+              }
+            }
+            custom_stats { name: "sample_rate" num: 0.5 }
+            custom_stats { name: "num_non_missing_lower_bound" num: 3 }
+            custom_stats { name: "num_non_missing_upper_bound" num: 12 }
+          })");
+  const FeaturePresence original =
+      ParseTextProtoOrDie<FeaturePresence>("min_count: 10 min_fraction: 0.5");
+
+  // The upper bound of the number of examples with the feature is high enough.
+  const DatasetStatsView stats_view(statistics);
+  const absl::optional<FeatureStatsView> feature_stats_view =
+      stats_view.GetByPath(Path({"sampled"}));
+  EXPECT_EQ(0.5, feature_stats_view->GetSampleRate());
+  EXPECT_EQ(12, feature_stats_view->GetNumPresentUpperBound());
+  FeaturePresence to_modify = original;
+  EXPECT_TRUE(UpdatePresence(*feature_stats_view, &to_modify).empty());
+  EXPECT_THAT(to_modify, EqualsProto(original));
+
+  // The weighted statistics have no bounds.
+  const DatasetStatsView weighted_stats_view(
+      std::make_shared<const DatasetFeatureStatistics>(statistics),
+      /*by_weight=*/true);
+  const absl::optional<FeatureStatsView> weighted_feature_stats_view =
+      weighted_stats_view.GetByPath(Path({"sampled"}));
+  EXPECT_EQ(6, weighted_feature_stats_view->GetNumPresentUpperBound());
+  EXPECT_EQ(2,
+            UpdatePresence(*weighted_feature_stats_view, &to_modify).size());
+  EXPECT_THAT(to_modify, EqualsProto("min_count: 6 min_fraction: 0.3"));
+}
+
 TEST(FeatureTypeTest, RareMissingFeatureUnweighted) {
   // Rare feature missing for unweighted stats.
   // Notice that the feature is not technically missing given num_non_missing,
@@ -18,7 +18,6 @@ limitations under the License.
 #include <string>
 #include <vector>
 
-#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
@@ -68,26 +67,14 @@ FloatIntervalResult GetFloatInterval(const FeatureStatsView& feature_stats) {
                            static_cast<float>(feature_stats.num_stats().max())};
     case FeatureNameStatistics::BYTES:
     case FeatureNameStatistics::STRING: {
-      absl::optional<FloatInterval> interval;
-      for (const string& str : feature_stats.GetStringValues()) {
-        float value;
-        if (!absl::SimpleAtof(str, &value)) {
-          return str;
-        }
-        if (!interval) {
-          interval = FloatInterval{value, value};
-        }
-        if (interval->min > value) {
-          interval->min = value;
-        }
-        if (interval->max < value) {
-          interval->max = value;
-        }
+      if (feature_stats.GetStringValuesWithCounts().empty()) {
+        return absl::nullopt;
       }
-      if (interval) {
-        return *interval;
+      const ParsedStringValues& parsed = feature_stats.GetParsedStringValues();
+      if (parsed.non_float_example) {
+        return *parsed.non_float_example;
       }
-      return absl::nullopt;
+      return FloatInterval{parsed.float_min, parsed.float_max};
     }
     case FeatureNameStatistics::INT:
       return absl::nullopt;
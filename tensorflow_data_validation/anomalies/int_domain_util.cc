@@ -18,7 +18,6 @@ limitations under the License.
 #include <string>
 #include <vector>
 
-#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
@@ -63,17 +62,13 @@ using IntIntervalResult =
 // NOTE: if GetIntInterval returns anything but NONEMPTY, result is always
 // [0,0].
 IntIntervalResult GetIntInterval(const FeatureStatsView& feature_stats_view) {
-  // Extract string values upfront as it can be useful for categorical INT
-  // features.
-  const std::vector<string> string_values =
-      feature_stats_view.GetStringValues();
   switch (feature_stats_view.type()) {
     case FeatureNameStatistics::STRUCT:
       return absl::nullopt;
     case FeatureNameStatistics::FLOAT:
       return absl::nullopt;
     case FeatureNameStatistics::INT: {
-      if (string_values.empty()) {
+      if (feature_stats_view.GetStringValuesWithCounts().empty()) {
         return IntInterval{
             static_cast<int64>(feature_stats_view.num_stats().min()),
             static_cast<int64>(feature_stats_view.num_stats().max())};
@@ -84,26 +79,17 @@ IntIntervalResult GetIntInterval(const FeatureStatsView& feature_stats_view) {
     }
     case FeatureNameStatistics::BYTES:
     case FeatureNameStatistics::STRING: {
-      absl::optional<IntInterval> interval;
-      for (const string& str : string_values) {
-        int64 value;
-        if (!absl::SimpleAtoi(str, &value)) {
-          return str;
-        }
-        if (!interval) {
-          interval = IntInterval{value, value};
-        }
-        if (interval->min > value) {
-          interval->min = value;
-        }
-        if (interval->max < value) {
-          interval->max = value;
-        }
+      // The values are parsed once per view, and shared with the other
+      // domain utilities.
+      if (feature_stats_view.GetStringValuesWithCounts().empty()) {
+        return absl::nullopt;
       }
-      if (interval) {
-        return *interval;
+      const ParsedStringValues& parsed =
+          feature_stats_view.GetParsedStringValues();
+      if (parsed.non_int_example) {
+        return *parsed.non_int_example;
       }
-      return absl::nullopt;
+      return IntInterval{parsed.int_min, parsed.int_max};
     }
     default:
       LOG(FATAL) << "Unknown type: " << feature_stats_view.type();
@@ -0,0 +1,97 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/internal_types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+// Returns a string representation of <count>/<total> as a percentage. If
+// the ratio is less than 1% then the string "<1%" is returned, otherwise it
+// returns the string "~x%" where x is the floor of the ratio.
+// If total is 0, return "?".
+string PercentageAsString(double count, double total) {
+  if (total == 0.0) {
+    return "?";
+  }
+  double percent = 100 * count / total;
+  if (percent < 1.0) {
+    return "<1%";
+  } else {
+    return strings::Printf("~%d%%", static_cast<int>(std::floor(percent)));
+  }
+}
+
+}  // namespace
+
+string Description::GetLongDescription(int max_values) const {
+  if (values == nullptr) {
+    return long_description;
+  }
+  const std::vector<std::pair<string, double>>& values_and_counts =
+      values->values_and_counts;
+  // The indices of the values listed.
+  std::vector<size_t> listed(values_and_counts.size());
+  std::iota(listed.begin(), listed.end(), 0);
+  size_t num_others = 0;
+  double others_count = 0;
+  if (max_values > 0 && listed.size() > static_cast<size_t>(max_values)) {
+    // Ties are broken by order, so that the result is deterministic.
+    std::partial_sort(listed.begin(), listed.begin() + max_values,
+                      listed.end(), [&values_and_counts](size_t a, size_t b) {
+                        return values_and_counts[a].second >
+                                   values_and_counts[b].second ||
+                               (values_and_counts[a].second ==
+                                    values_and_counts[b].second &&
+                                a < b);
+                      });
+    for (size_t i = max_values; i < listed.size(); ++i) {
+      others_count += values_and_counts[listed[i]].second;
+    }
+    num_others = listed.size() - max_values;
+    listed.resize(max_values);
+    std::sort(listed.begin(), listed.end());
+  }
+  string result = long_description;
+  for (size_t i = 0; i < listed.size(); ++i) {
+    const std::pair<string, double>& value_and_count =
+        values_and_counts[listed[i]];
+    absl::StrAppend(&result, i == 0 ? "" : ", ",
+                    absl::Utf8SafeCEscape(value_and_count.first), " (",
+                    PercentageAsString(value_and_count.second,
+                                       values->total_count),
+                    ")");
+  }
+  if (num_others > 0) {
+    absl::StrAppend(&result, ", and ", num_others,
+                    num_others == 1 ? " other value (" : " other values (",
+                    PercentageAsString(others_count, values->total_count),
+                    ")");
+  }
+  absl::StrAppend(&result, ". ");
+  return result;
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
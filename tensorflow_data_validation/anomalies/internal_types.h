@@ -16,28 +16,54 @@ limitations under the License.
 #ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_INTERNAL_TYPES_H_
 #define TENSORFLOW_DATA_VALIDATION_ANOMALIES_INTERNAL_TYPES_H_
 
+#include <memory>
+#include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_metadata/proto/v0/anomalies.pb.h"
 
 namespace tensorflow {
 namespace data_validation {
 
+// Values listed in the long description of an anomaly, each with its
+// fraction of a total count, e.g., the values of a feature that are missing
+// from its StringDomain. They are only formatted when the anomaly is reported
+// (see Description::GetLongDescription()), so that nothing is formatted for
+// the descriptions that are dropped, and at most a given number of them are.
+struct DescriptionValues {
+  // The values and their counts, in the order in which they are listed.
+  std::vector<std::pair<string, double>> values_and_counts;
+  // The count that those of the values are fractions of. If 0, the fractions
+  // are unknown.
+  double total_count = 0;
+};
+
 // Represents the description of an anomaly, in short and long form.
 struct Description {
   tensorflow::metadata::v0::AnomalyInfo::Type type;
   string short_description, long_description;
+  // If not null, listed after long_description, followed by ". ".
+  std::shared_ptr<const DescriptionValues> values;
+
+  // Returns long_description, followed by values if they are set. At most
+  // max_values of them are listed (all of them if max_values is 0): the most
+  // frequent ones, in their order, followed by the number of the others and
+  // their total fraction.
+  string GetLongDescription(int max_values = 0) const;
 
   friend bool operator==(const Description& a, const Description& b) {
     return (a.type == b.type && a.short_description == b.short_description &&
-            a.long_description == b.long_description);
+            a.GetLongDescription() == b.GetLongDescription());
   }
 
   friend std::ostream& operator<<(std::ostream& strm, const Description& a) {
     return (strm << "{" << a.type << ", " << a.short_description << ", " <<
-            a.long_description << "}");
+            a.GetLongDescription() << "}");
   }
 };
 
@@ -50,6 +76,11 @@ struct UpdateSummary {
   std::vector<Description> descriptions;
 };
 
+// The set of values of a StringDomain. The values point into the
+// StringDomain they come from, so it must outlive the set, and its values
+// must not be modified.
+using StringDomainValues = absl::flat_hash_set<absl::string_view>;
+
 enum class ComparatorType { SKEW, DRIFT };
 
 // The context for a tensorflow::metadata::v0::FeatureComparator.
@@ -0,0 +1,82 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/internal_types.h"
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/anomalies.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+Description GetDescriptionWithValues() {
+  auto values = std::make_shared<DescriptionValues>();
+  values->values_and_counts = {{"a", 10}, {"b", 50}, {"c", 5}, {"d", 30},
+                               {"e\n", 5}};
+  values->total_count = 200;
+  return {tensorflow::metadata::v0::AnomalyInfo::
+              ENUM_TYPE_UNEXPECTED_STRING_VALUES,
+          "Unexpected string values", "Values: ", std::move(values)};
+}
+
+TEST(DescriptionTest, GetLongDescriptionWithoutValues) {
+  const Description description = {
+      tensorflow::metadata::v0::AnomalyInfo::UNKNOWN_TYPE, "short", "long"};
+  EXPECT_EQ("long", description.GetLongDescription());
+  EXPECT_EQ("long", description.GetLongDescription(/*max_values=*/1));
+}
+
+TEST(DescriptionTest, GetLongDescriptionListsAllValues) {
+  const Description description = GetDescriptionWithValues();
+  const string expected =
+      "Values: a (~5%), b (~25%), c (~2%), d (~15%), e\\n (~2%). ";
+  EXPECT_EQ(expected, description.GetLongDescription());
+  EXPECT_EQ(expected, description.GetLongDescription(/*max_values=*/5));
+}
+
+TEST(DescriptionTest, GetLongDescriptionListsMostFrequentValues) {
+  const Description description = GetDescriptionWithValues();
+  EXPECT_EQ("Values: a (~5%), b (~25%), d (~15%), and 2 other values (~5%). ",
+            description.GetLongDescription(/*max_values=*/3));
+  // Ties are broken by order.
+  EXPECT_EQ(
+      "Values: a (~5%), b (~25%), c (~2%), d (~15%), and 1 other value "
+      "(~2%). ",
+      description.GetLongDescription(/*max_values=*/4));
+}
+
+TEST(DescriptionTest, GetLongDescriptionUnknownTotal) {
+  Description description = GetDescriptionWithValues();
+  auto values = std::make_shared<DescriptionValues>(*description.values);
+  values->total_count = 0;
+  description.values = std::move(values);
+  EXPECT_EQ("Values: b (?), and 4 other values (?). ",
+            description.GetLongDescription(/*max_values=*/1));
+}
+
+TEST(DescriptionTest, Equality) {
+  Description rendered = GetDescriptionWithValues();
+  rendered.long_description = rendered.GetLongDescription();
+  rendered.values.reset();
+  EXPECT_EQ(GetDescriptionWithValues(), rendered);
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -15,14 +15,14 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/metrics.h"
 
+#include <algorithm>
 #include <cmath>
 #include <map>
-#include <numeric>
 #include <string>
 #include <vector>
 
-#include "tensorflow_data_validation/anomalies/map_util.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
 
 using std::map;
 
@@ -31,34 +31,217 @@ namespace data_validation {
 
 namespace {
 
-// Gets the L-infty norm of a vector, represented as a map.
-// This is the largest absolute value of any value.
-// For convenience, the associated key is also returned.
-std::pair<string, double> GetLInftyNorm(const map<string, double>& vec) {
-  std::pair<string, double> best_so_far;
-  for (const auto& pair : vec) {
-    const string& key = pair.first;
-    const double value = std::abs(pair.second);
-    if (value >= best_so_far.second) {
-      best_so_far = {key, value};
+using tensorflow::metadata::v0::Histogram;
+
+// The lower bound on probabilities when computing the population stability
+// index, which is infinite if a probability is zero in only one of the
+// distributions.
+constexpr double kPsiMinProbability = 1e-4;
+
+// Returns the sum of the values, or 1 if they sum to zero, so that dividing
+// by it matches Normalize() in map_util.
+double GetNormalizer(const map<string, double>& counts) {
+  double sum = 0.0;
+  for (const auto& pair : counts) {
+    sum += pair.second;
+  }
+  return sum == 0.0 ? 1.0 : sum;
+}
+
+// Walks the keys of counts_a and counts_b (both sorted) together, and calls
+// fn(key, prob_a, prob_b) for each key in either, in order. prob_a and prob_b
+// are the values normalized as by Normalize(), and are zero if the key is
+// absent. This is a single pass over each map, and does not allocate.
+template <typename Fn>
+void ForEachNormalizedPair(const map<string, double>& counts_a,
+                           const map<string, double>& counts_b, Fn&& fn) {
+  const double sum_a = GetNormalizer(counts_a);
+  const double sum_b = GetNormalizer(counts_b);
+  auto iter_a = counts_a.begin();
+  auto iter_b = counts_b.begin();
+  while (iter_a != counts_a.end() || iter_b != counts_b.end()) {
+    if (iter_b == counts_b.end() ||
+        (iter_a != counts_a.end() && iter_a->first < iter_b->first)) {
+      fn(iter_a->first, iter_a->second / sum_a, 0.0);
+      ++iter_a;
+    } else if (iter_a == counts_a.end() || iter_b->first < iter_a->first) {
+      fn(iter_b->first, 0.0, iter_b->second / sum_b);
+      ++iter_b;
+    } else {
+      fn(iter_a->first, iter_a->second / sum_a, iter_b->second / sum_b);
+      ++iter_a;
+      ++iter_b;
     }
   }
-  return best_so_far;
+}
+
+// Adds the terms of the Jensen-Shannon divergence and the population stability
+// index for an outcome that has probability p in one distribution and q in
+// the other.
+void AddDivergenceTerms(double p, double q, DistributionDistances* result) {
+  const double m = (p + q) / 2.0;
+  if (p > 0.0) {
+    result->jensen_shannon_divergence += 0.5 * p * std::log2(p / m);
+  }
+  if (q > 0.0) {
+    result->jensen_shannon_divergence += 0.5 * q * std::log2(q / m);
+  }
+  const double clipped_p = std::max(p, kPsiMinProbability);
+  const double clipped_q = std::max(q, kPsiMinProbability);
+  result->population_stability_index +=
+      (clipped_p - clipped_q) * std::log(clipped_p / clipped_q);
+}
+
+// Returns the STANDARD histogram of the (weighted) numeric statistics of
+// view, or nullptr if there is none or it has no buckets.
+const Histogram* GetStandardHistogram(const FeatureStatsView& view) {
+  const auto& histograms =
+      view.parent_view().by_weight()
+          ? view.num_stats().weighted_numeric_stats().histograms()
+          : view.num_stats().histograms();
+  for (const Histogram& histogram : histograms) {
+    if (histogram.type() == Histogram::STANDARD &&
+        histogram.buckets_size() > 0) {
+      return &histogram;
+    }
+  }
+  return nullptr;
+}
+
+// Returns the counts of the buckets of control, preceded by a zero count for
+// the values below its range and followed by a zero count for those above.
+std::vector<double> GetCounts(const Histogram& control) {
+  std::vector<double> result;
+  result.reserve(control.buckets_size() + 2);
+  result.push_back(0.0);
+  for (const Histogram::Bucket& bucket : control.buckets()) {
+    result.push_back(bucket.sample_count());
+  }
+  result.push_back(0.0);
+  return result;
+}
+
+// Returns the counts of treatment, assigned to the buckets of GetCounts(
+// control), assuming the values are uniform within each bucket of treatment.
+std::vector<double> GetRebinnedCounts(const Histogram& control,
+                                      const Histogram& treatment) {
+  const int num_buckets = control.buckets_size();
+  const double min = control.buckets(0).low_value();
+  const double max = control.buckets(num_buckets - 1).high_value();
+  std::vector<double> result(num_buckets + 2, 0.0);
+  for (const Histogram::Bucket& bucket : treatment.buckets()) {
+    const double low = bucket.low_value();
+    const double high = bucket.high_value();
+    const double count = bucket.sample_count();
+    if (high <= low) {
+      // All the values are the same: find the bucket containing them.
+      if (low < min) {
+        result.front() += count;
+      } else if (low > max) {
+        result.back() += count;
+      } else {
+        for (int i = 0; i < num_buckets; ++i) {
+          if (low <= control.buckets(i).high_value()) {
+            result[i + 1] += count;
+            break;
+          }
+        }
+      }
+      continue;
+    }
+    const double density = count / (high - low);
+    result.front() += density * std::max(0.0, std::min(high, min) - low);
+    result.back() += density * std::max(0.0, high - std::max(low, max));
+    for (int i = 0; i < num_buckets; ++i) {
+      const Histogram::Bucket& control_bucket = control.buckets(i);
+      const double overlap =
+          std::min(high, control_bucket.high_value()) -
+          std::max(low, control_bucket.low_value());
+      if (overlap > 0.0) {
+        result[i + 1] += density * overlap;
+      }
+    }
+  }
+  return result;
+}
+
+// Returns the sum of the counts, or 1 if they sum to zero.
+double GetNormalizer(const std::vector<double>& counts) {
+  double sum = 0.0;
+  for (const double count : counts) {
+    sum += count;
+  }
+  return sum == 0.0 ? 1.0 : sum;
 }
 
 }  // namespace
 
 std::pair<string, double> LInftyDistance(const map<string, double>& counts_a,
                                          const map<string, double>& counts_b) {
-  return GetLInftyNorm(GetDifference(Normalize(counts_a), Normalize(counts_b)));
+  // Rather than building the normalized maps and their difference, and then
+  // taking the L-infty norm (the largest absolute value) of the difference,
+  // this computes each difference as it goes, and keeps the largest.
+  const string* best_key = nullptr;
+  double best_value = 0.0;
+  ForEachNormalizedPair(
+      counts_a, counts_b,
+      [&best_key, &best_value](const string& key, double prob_a,
+                               double prob_b) {
+        const double value = std::abs(prob_a - prob_b);
+        if (value >= best_value) {
+          best_key = &key;
+          best_value = value;
+        }
+      });
+  return {best_key == nullptr ? "" : *best_key, best_value};
 }
 
 std::pair<string, double> LInftyDistance(const FeatureStatsView& a,
                                          const FeatureStatsView& b) {
-  const map<string, double> prob_a = Normalize(a.GetStringValuesWithCounts());
-  const map<string, double> prob_b = Normalize(b.GetStringValuesWithCounts());
+  return LInftyDistance(a.GetStringValuesWithCounts(),
+                        b.GetStringValuesWithCounts());
+}
 
-  return GetLInftyNorm(GetDifference(prob_a, prob_b));
+DistributionDistances GetDistributionDistances(
+    const FeatureStatsView& control, const FeatureStatsView& treatment) {
+  DistributionDistances result;
+  const map<string, double>& control_values =
+      control.GetStringValuesWithCounts();
+  const map<string, double>& treatment_values =
+      treatment.GetStringValuesWithCounts();
+  if (!control_values.empty() || !treatment_values.empty()) {
+    // As in LInftyDistance(), but sharing the pass with the divergences.
+    const string* l_infty_value = nullptr;
+    ForEachNormalizedPair(
+        control_values, treatment_values,
+        [&l_infty_value, &result](const string& key, double prob_a,
+                                  double prob_b) {
+          const double value = std::abs(prob_a - prob_b);
+          if (value >= result.l_infty) {
+            l_infty_value = &key;
+            result.l_infty = value;
+          }
+          AddDivergenceTerms(prob_a, prob_b, &result);
+        });
+    if (l_infty_value != nullptr) {
+      result.l_infty_value = *l_infty_value;
+    }
+    return result;
+  }
+  const Histogram* control_histogram = GetStandardHistogram(control);
+  const Histogram* treatment_histogram = GetStandardHistogram(treatment);
+  if (control_histogram != nullptr && treatment_histogram != nullptr) {
+    const std::vector<double> control_counts = GetCounts(*control_histogram);
+    const std::vector<double> treatment_counts =
+        GetRebinnedCounts(*control_histogram, *treatment_histogram);
+    const double control_sum = GetNormalizer(control_counts);
+    const double treatment_sum = GetNormalizer(treatment_counts);
+    for (size_t i = 0; i < control_counts.size(); ++i) {
+      AddDivergenceTerms(control_counts[i] / control_sum,
+                         treatment_counts[i] / treatment_sum, &result);
+    }
+  }
+  return result;
 }
 
 }  // namespace data_validation
@@ -39,6 +39,31 @@ std::pair<string, double> LInftyDistance(
     const std::map<string, double>& counts_a,
     const std::map<string, double>& counts_b);
 
+// Distances between the distributions of a feature in two datasets.
+struct DistributionDistances {
+  // The value with the highest deviation, and the L-infinity distance (see
+  // LInftyDistance()). Only computed for string distributions: these are
+  // "" and 0 for numeric ones.
+  string l_infty_value;
+  double l_infty = 0.0;
+  // The Jensen-Shannon divergence, using base 2 logarithms.
+  double jensen_shannon_divergence = 0.0;
+  // The population stability index, where probabilities are clipped below
+  // at 1e-4 so that it is finite.
+  double population_stability_index = 0.0;
+};
+
+// Computes all of the distances between the distributions of control and
+// treatment in one pass.
+// If either has string values, compares the (weighted) rank histograms.
+// Otherwise, if both have a STANDARD histogram in their numeric stats,
+// compares those, assigning the counts of the treatment buckets to the
+// control buckets (and to a bucket below and above the range of control)
+// as if the values were uniform within each bucket.
+// Otherwise, all distances are zero.
+DistributionDistances GetDistributionDistances(
+    const FeatureStatsView& control, const FeatureStatsView& treatment);
+
 }  // namespace data_validation
 }  // namespace tensorflow
 
@@ -15,11 +15,14 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/metrics.h"
 
+#include <cmath>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
 #include "tensorflow_data_validation/anomalies/statistics_view_test_util.h"
 #include "tensorflow_data_validation/anomalies/test_util.h"
 #include "tensorflow/core/platform/types.h"
@@ -96,6 +99,108 @@ TEST(LInftyDistanceTest, All) {
   }
 }
 
+TEST(LInftyDistanceTest, MaxDifferenceValue) {
+  // Of the values with the largest difference, the last is returned.
+  const std::pair<string, double> tie =
+      LInftyDistance({{"a", 1.0}, {"b", 3.0}, {"c", 1.0}},
+                     {{"a", 3.0}, {"b", 1.0}, {"c", 1.0}});
+  EXPECT_EQ(tie.first, "b");
+  EXPECT_NEAR(tie.second, 0.4, 1e-5);
+
+  const std::pair<string, double> disjoint =
+      LInftyDistance({{"a", 1.0}}, {{"b", 2.0}});
+  EXPECT_EQ(disjoint.first, "b");
+  EXPECT_NEAR(disjoint.second, 1.0, 1e-5);
+
+  // Counts that sum to zero are not normalized.
+  const std::pair<string, double> zero =
+      LInftyDistance({{"a", 0.0}}, {{"a", 1.0}, {"b", 3.0}});
+  EXPECT_EQ(zero.first, "b");
+  EXPECT_NEAR(zero.second, 0.75, 1e-5);
+
+  const std::pair<string, double> empty = LInftyDistance({}, {});
+  EXPECT_EQ(empty.first, "");
+  EXPECT_EQ(empty.second, 0.0);
+}
+
+TEST(GetDistributionDistancesTest, StringValues) {
+  const DatasetForTesting control(GetFeatureNameStatisticsWithTokens(
+      {{"a", 1.0}, {"b", 3.0}, {"c", 1.0}}));
+  const DatasetForTesting same(GetFeatureNameStatisticsWithTokens(
+      {{"a", 2.0}, {"b", 6.0}, {"c", 2.0}}));
+  const DatasetForTesting treatment(GetFeatureNameStatisticsWithTokens(
+      {{"a", 3.0}, {"b", 1.0}, {"c", 1.0}}));
+
+  const DistributionDistances zero = GetDistributionDistances(
+      control.feature_stats_view(), same.feature_stats_view());
+  EXPECT_NEAR(zero.l_infty, 0.0, 1e-10);
+  EXPECT_NEAR(zero.jensen_shannon_divergence, 0.0, 1e-10);
+  EXPECT_NEAR(zero.population_stability_index, 0.0, 1e-10);
+
+  const DistributionDistances result = GetDistributionDistances(
+      control.feature_stats_view(), treatment.feature_stats_view());
+  // The same as LInftyDistance().
+  EXPECT_EQ(result.l_infty_value, "b");
+  EXPECT_NEAR(result.l_infty, 0.4, 1e-5);
+  // 2 * (0.5 * 0.2 * log2(0.2 / 0.4) + 0.5 * 0.6 * log2(0.6 / 0.4)).
+  EXPECT_NEAR(result.jensen_shannon_divergence, 0.150978, 1e-5);
+  // 2 * (0.4 * ln(3)).
+  EXPECT_NEAR(result.population_stability_index, 0.878890, 1e-5);
+}
+
+TEST(GetDistributionDistancesTest, DisjointStringValues) {
+  const DatasetForTesting control(
+      GetFeatureNameStatisticsWithTokens({{"a", 1.0}}));
+  const DatasetForTesting treatment(
+      GetFeatureNameStatisticsWithTokens({{"b", 1.0}}));
+  const DistributionDistances result = GetDistributionDistances(
+      control.feature_stats_view(), treatment.feature_stats_view());
+  EXPECT_NEAR(result.jensen_shannon_divergence, 1.0, 1e-10);
+  // Probabilities are clipped at 1e-4.
+  EXPECT_NEAR(result.population_stability_index,
+              2 * (1.0 - 1e-4) * std::log(1e4), 1e-5);
+}
+
+tensorflow::metadata::v0::FeatureNameStatistics GetFloatFeatureNameStatistics(
+    const string& histogram) {
+  return ParseTextProtoOrDie<tensorflow::metadata::v0::FeatureNameStatistics>(
+      absl::StrCat(R"(name: 'bar'
+                      type: FLOAT
+                      num_stats: {
+                        common_stats: { num_non_missing: 1 max_num_values: 1 }
+                        histograms {)",
+                   histogram, "}}"));
+}
+
+TEST(GetDistributionDistancesTest, NumericHistograms) {
+  const DatasetForTesting control(GetFloatFeatureNameStatistics(R"(
+      buckets { low_value: 0 high_value: 1 sample_count: 2 }
+      buckets { low_value: 1 high_value: 2 sample_count: 2 })"));
+  // Assigned to the buckets of control (with a bucket below and above its
+  // range), the counts are {0.5, 1, 1, 0.5}, so the probabilities are
+  // {1/6, 1/3, 1/3, 1/6}, compared to {0, 1/2, 1/2, 0}.
+  const DatasetForTesting treatment(GetFloatFeatureNameStatistics(R"(
+      buckets { low_value: -0.5 high_value: 0.5 sample_count: 1 }
+      buckets { low_value: 0.5 high_value: 1.5 sample_count: 1 }
+      buckets { low_value: 1.5 high_value: 1.5 sample_count: 0.5 }
+      buckets { low_value: 3 high_value: 3 sample_count: 0.5 })"));
+  const DistributionDistances result = GetDistributionDistances(
+      control.feature_stats_view(), treatment.feature_stats_view());
+  // L-infinity is only computed for string values.
+  EXPECT_EQ(result.l_infty, 0.0);
+  EXPECT_NEAR(result.jensen_shannon_divergence, 0.190875, 1e-5);
+  EXPECT_NEAR(result.population_stability_index, 2.60653, 1e-5);
+}
+
+TEST(GetDistributionDistancesTest, NoHistograms) {
+  const DatasetForTesting control(GetFloatFeatureNameStatistics(""));
+  const DatasetForTesting treatment(GetFloatFeatureNameStatistics(""));
+  const DistributionDistances result = GetDistributionDistances(
+      control.feature_stats_view(), treatment.feature_stats_view());
+  EXPECT_EQ(result.jensen_shannon_divergence, 0.0);
+  EXPECT_EQ(result.population_stability_index, 0.0);
+}
+
 }  // namespace
 
 }  // namespace data_validation
@@ -0,0 +1,161 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/numeric_string_util.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+namespace {
+
+// Any 18 digit decimal number fits in an int64.
+constexpr int kMaxFastPathDigits = 18;
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// The characters that absl::SimpleAtoi() and absl::SimpleAtof() skip at
+// the start of a string (see std::isspace()).
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+bool IsSign(char c) { return c == '-' || c == '+'; }
+
+// Returns true if a string starting with c might be a float: that is, c
+// can start a number, "inf", "infinity" or "nan" (in any case), or is
+// skipped.
+bool CanStartFloat(char c) {
+  return IsDigit(c) || IsSign(c) || IsSpace(c) || c == '.' || c == 'i' ||
+         c == 'I' || c == 'n' || c == 'N';
+}
+
+// If str is an optional sign followed by 1 to kMaxFastPathDigits digits,
+// sets *value and returns true. Otherwise, returns false, and str should
+// be parsed by the general routine.
+bool ParsePlainInt64(absl::string_view str, int64* value) {
+  size_t i = 0;
+  const bool negative = !str.empty() && str[0] == '-';
+  if (!str.empty() && IsSign(str[0])) {
+    ++i;
+  }
+  const size_t num_digits = str.size() - i;
+  if (num_digits == 0 || num_digits > kMaxFastPathDigits) {
+    return false;
+  }
+  int64 result = 0;
+  for (; i < str.size(); ++i) {
+    if (!IsDigit(str[i])) {
+      return false;
+    }
+    result = result * 10 + (str[i] - '0');
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+// Same as ParseFloat(str, value), given whether str is an int64 (and if
+// so, its value). Converting a nonzero int64 rounds it to the nearest
+// float, which is what parsing it does. Zero is parsed, as "-0" is -0.0.
+bool ParseFloatGivenInt64(absl::string_view str, bool is_int, int64 int_value,
+                          float* value) {
+  if (is_int && int_value != 0) {
+    *value = static_cast<float>(int_value);
+    return true;
+  }
+  return ParseFloat(str, value);
+}
+
+}  // namespace
+
+bool ParseInt64(absl::string_view str, int64* value) {
+  // absl::SimpleAtoi() only accepts decimal digits, a sign and whitespace.
+  for (char c : str) {
+    if (!IsDigit(c) && !IsSign(c) && !IsSpace(c)) {
+      return false;
+    }
+  }
+  return ParsePlainInt64(str, value) || absl::SimpleAtoi(str, value);
+}
+
+bool ParseFloat(absl::string_view str, float* value) {
+  if (str.empty() || !CanStartFloat(str[0])) {
+    return false;
+  }
+  return absl::SimpleAtof(str, value);
+}
+
+ParsedStringValues ParseStringValues(
+    const std::vector<absl::string_view>& values) {
+  ParsedStringValues result;
+  bool first = true;
+  for (absl::string_view str : values) {
+    if (result.non_int_example && result.non_float_example) {
+      break;
+    }
+    int64 int_value = 0;
+    bool is_int = false;
+    if (result.non_int_example) {
+      // Some earlier value is not an int64.
+    } else if (!ParseInt64(str, &int_value)) {
+      result.non_int_example = string(str);
+      result.int_min = 0;
+      result.int_max = 0;
+    } else {
+      is_int = true;
+      if (first) {
+        result.int_min = int_value;
+        result.int_max = int_value;
+      } else {
+        result.int_min = std::min(result.int_min, int_value);
+        result.int_max = std::max(result.int_max, int_value);
+      }
+    }
+    float float_value;
+    if (result.non_float_example) {
+      // Some earlier value is not a float.
+    } else if (!ParseFloatGivenInt64(str, is_int, int_value, &float_value)) {
+      result.non_float_example = string(str);
+      result.float_min = 0;
+      result.float_max = 0;
+    } else if (first) {
+      result.float_min = float_value;
+      result.float_max = float_value;
+    } else {
+      // Written as comparisons (rather than std::min and std::max) so that
+      // a NaN never replaces the current bound.
+      if (result.float_min > float_value) {
+        result.float_min = float_value;
+      }
+      if (result.float_max < float_value) {
+        result.float_max = float_value;
+      }
+    }
+    first = false;
+  }
+  return result;
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
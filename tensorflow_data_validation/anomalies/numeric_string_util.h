@@ -0,0 +1,67 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_NUMERIC_STRING_UTIL_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_NUMERIC_STRING_UTIL_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// Parses str as an int64. Equivalent to absl::SimpleAtoi(str, value), but
+// plain decimal integers (an optional sign and at most 18 digits) are
+// parsed without the overhead of the general routine, and strings with a
+// character that cannot appear in an integer are rejected without it.
+bool ParseInt64(absl::string_view str, int64* value);
+
+// Parses str as a float. Equivalent to absl::SimpleAtof(str, value), but
+// strings that cannot be floats are rejected from their first character.
+bool ParseFloat(absl::string_view str, float* value);
+
+// The result of parsing a list of strings as numbers.
+struct ParsedStringValues {
+  // The first string that is not an int64 (see ParseInt64()), or nullopt if
+  // every string is one.
+  absl::optional<string> non_int_example;
+  // The range of the strings, if they are all int64 and there is at least
+  // one. Otherwise, [0, 0].
+  int64 int_min = 0;
+  int64 int_max = 0;
+
+  // The first string that is not a float (see ParseFloat()), or nullopt if
+  // every string is one.
+  absl::optional<string> non_float_example;
+  // The range of the strings, if they are all floats and there is at least
+  // one. Otherwise, [0, 0].
+  float float_min = 0;
+  float float_max = 0;
+};
+
+// Parses each of values as an int64 and as a float in a single pass. Stops
+// as soon as a value is neither. A value that is an int64 is converted to a
+// float directly, rather than being parsed again.
+ParsedStringValues ParseStringValues(
+    const std::vector<absl::string_view>& values);
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_NUMERIC_STRING_UTIL_H_
@@ -0,0 +1,223 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/numeric_string_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+// Strings on the boundaries of what the fast paths accept.
+std::vector<string> GetTrickyStrings() {
+  return {"",
+          "0",
+          "-0",
+          "+0",
+          "7",
+          "-7",
+          "+7",
+          "007",
+          "-",
+          "+",
+          "--1",
+          "+-1",
+          "1-",
+          " 12",
+          "12 ",
+          "\t-12\n",
+          "123456789012345678",
+          "-123456789012345678",
+          "9223372036854775807",
+          "-9223372036854775808",
+          "9223372036854775808",
+          "99999999999999999999",
+          "16777217",
+          "3.5",
+          "-.5",
+          ".",
+          "1e3",
+          "1E-3",
+          "0x1A",
+          "inf",
+          "-Infinity",
+          "nan",
+          "NaN",
+          "infant",
+          "1.5.5",
+          "foo",
+          "__BYTES_VALUE__",
+          "TRUE"};
+}
+
+TEST(NumericStringUtilTest, ParseInt64MatchesSimpleAtoi) {
+  for (const string& str : GetTrickyStrings()) {
+    int64 expected = 0;
+    int64 actual = 0;
+    const bool expected_ok = absl::SimpleAtoi(str, &expected);
+    EXPECT_EQ(ParseInt64(str, &actual), expected_ok) << "\"" << str << "\"";
+    if (expected_ok) {
+      EXPECT_EQ(actual, expected) << "\"" << str << "\"";
+    }
+  }
+}
+
+TEST(NumericStringUtilTest, ParseFloatMatchesSimpleAtof) {
+  for (const string& str : GetTrickyStrings()) {
+    float expected = 0;
+    float actual = 0;
+    const bool expected_ok = absl::SimpleAtof(str, &expected);
+    EXPECT_EQ(ParseFloat(str, &actual), expected_ok) << "\"" << str << "\"";
+    if (expected_ok) {
+      // Compare the representations, so that NaN and -0.0 are checked.
+      EXPECT_EQ(std::memcmp(&actual, &expected, sizeof(float)), 0)
+          << "\"" << str << "\"";
+    }
+  }
+}
+
+TEST(NumericStringUtilTest, ParseStringValuesInts) {
+  const ParsedStringValues result =
+      ParseStringValues({"12", "-7", "3", "16777217"});
+  EXPECT_EQ(result.non_int_example, absl::nullopt);
+  EXPECT_EQ(result.int_min, -7);
+  EXPECT_EQ(result.int_max, 16777217);
+  EXPECT_EQ(result.non_float_example, absl::nullopt);
+  EXPECT_EQ(result.float_min, -7.0);
+  // Rounded to the nearest float, as if parsed.
+  EXPECT_EQ(result.float_max, 16777216.0);
+}
+
+TEST(NumericStringUtilTest, ParseStringValuesNegativeZero) {
+  const ParsedStringValues result = ParseStringValues({"-0"});
+  EXPECT_EQ(result.int_min, 0);
+  EXPECT_TRUE(std::signbit(result.float_min));
+}
+
+TEST(NumericStringUtilTest, ParseStringValuesFloats) {
+  const ParsedStringValues result = ParseStringValues({"1", "2.5", "-3"});
+  EXPECT_EQ(result.non_int_example, "2.5");
+  EXPECT_EQ(result.int_min, 0);
+  EXPECT_EQ(result.int_max, 0);
+  EXPECT_EQ(result.non_float_example, absl::nullopt);
+  EXPECT_EQ(result.float_min, -3.0);
+  EXPECT_EQ(result.float_max, 2.5);
+}
+
+TEST(NumericStringUtilTest, ParseStringValuesStrings) {
+  const ParsedStringValues result = ParseStringValues({"1", "foo", "bar"});
+  EXPECT_EQ(result.non_int_example, "foo");
+  EXPECT_EQ(result.non_float_example, "foo");
+  EXPECT_EQ(result.float_min, 0);
+  EXPECT_EQ(result.float_max, 0);
+}
+
+TEST(NumericStringUtilTest, ParseStringValuesEmpty) {
+  const ParsedStringValues result = ParseStringValues({});
+  EXPECT_EQ(result.non_int_example, absl::nullopt);
+  EXPECT_EQ(result.non_float_example, absl::nullopt);
+}
+
+// Returns num_values strings, as in the rank histogram of a numeric feature
+// read from a CSV file.
+std::vector<string> GetNumericStrings(int num_values, bool integers) {
+  std::vector<string> result;
+  result.reserve(num_values);
+  for (int i = 0; i < num_values; ++i) {
+    result.push_back(integers ? absl::StrCat(i * 7919 - 1000000)
+                              : absl::StrCat(i * 0.25 - 1000));
+  }
+  return result;
+}
+
+// The implementation that ParseStringValues() replaces: each string is
+// parsed by absl::SimpleAtoi() and absl::SimpleAtof() separately.
+void ParseStringValuesWithAbsl(const std::vector<absl::string_view>& values,
+                               int64* int_min, float* float_min) {
+  for (absl::string_view str : values) {
+    int64 int_value;
+    if (absl::SimpleAtoi(str, &int_value) && int_value < *int_min) {
+      *int_min = int_value;
+    }
+  }
+  for (absl::string_view str : values) {
+    float float_value;
+    if (absl::SimpleAtof(str, &float_value) && float_value < *float_min) {
+      *float_min = float_value;
+    }
+  }
+}
+
+void RunParseBenchmark(int iters, int num_values, bool integers,
+                       bool with_absl) {
+  tensorflow::testing::StopTiming();
+  const std::vector<string> strings = GetNumericStrings(num_values, integers);
+  const std::vector<absl::string_view> values(strings.begin(), strings.end());
+  int64 int_min = 0;
+  float float_min = 0;
+  tensorflow::testing::ItemsProcessed(static_cast<int64>(iters) * num_values);
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    if (with_absl) {
+      ParseStringValuesWithAbsl(values, &int_min, &float_min);
+    } else {
+      const ParsedStringValues result = ParseStringValues(values);
+      int_min = std::min(int_min, result.int_min);
+      float_min = std::min(float_min, result.float_min);
+    }
+  }
+  tensorflow::testing::StopTiming();
+  CHECK_LE(int_min, 0);
+  CHECK_LE(float_min, 0);
+}
+
+void BM_ParseIntStringValues(int iters, int num_values) {
+  RunParseBenchmark(iters, num_values, /*integers=*/true, /*with_absl=*/false);
+}
+BENCHMARK(BM_ParseIntStringValues)->Arg(1000)->Arg(100000);
+
+void BM_ParseIntStringValuesWithAbsl(int iters, int num_values) {
+  RunParseBenchmark(iters, num_values, /*integers=*/true, /*with_absl=*/true);
+}
+BENCHMARK(BM_ParseIntStringValuesWithAbsl)->Arg(1000)->Arg(100000);
+
+void BM_ParseFloatStringValues(int iters, int num_values) {
+  RunParseBenchmark(iters, num_values, /*integers=*/false,
+                    /*with_absl=*/false);
+}
+BENCHMARK(BM_ParseFloatStringValues)->Arg(1000)->Arg(100000);
+
+void BM_ParseFloatStringValuesWithAbsl(int iters, int num_values) {
+  RunParseBenchmark(iters, num_values, /*integers=*/false, /*with_absl=*/true);
+}
+BENCHMARK(BM_ParseFloatStringValuesWithAbsl)->Arg(1000)->Arg(100000);
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
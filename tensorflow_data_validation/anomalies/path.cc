@@ -1,7 +1,10 @@
 #include "tensorflow_data_validation/anomalies/path.h"
 
-#include <algorithm>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
@@ -10,6 +13,7 @@
 #include "re2/re2.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace data_validation {
@@ -116,20 +120,152 @@ struct StepDelimiter {
 };
 }  // namespace
 
-Path::Path(const tensorflow::metadata::v0::Path& p)
-    : step_(p.step().begin(), p.step().end()) {}
+Path::Path(const std::vector<string>& step) {
+  for (const string& s : step) {
+    const Node* child = GetChildNode(node_, s);
+    Unref(node_);
+    node_ = child;
+  }
+}
 
-// Part of the implementation of Compare().
-bool Path::Equals(const Path& p) const {
-  if (p.step_.size() != step_.size()) {
-    return false;
+Path::Path(const tensorflow::metadata::v0::Path& p) {
+  for (const string& s : p.step()) {
+    const Node* child = GetChildNode(node_, s);
+    Unref(node_);
+    node_ = child;
   }
-  return std::equal(step_.begin(), step_.end(), p.step_.begin());
 }
 
+Path& Path::operator=(const Path& p) {
+  // Refs first, in case p is *this.
+  Ref(p.node_);
+  Unref(node_);
+  node_ = p.node_;
+  return *this;
+}
+
+Path& Path::operator=(Path&& p) {
+  if (this != &p) {
+    Unref(node_);
+    node_ = p.node_;
+    p.node_ = nullptr;
+  }
+  return *this;
+}
+
+namespace {
+
+// The key of a child is its parent and a view of its own step.
+using ChildKey = std::pair<const void*, absl::string_view>;
+
+// The number of shards of the table of nodes, so that threads creating or
+// freeing different paths rarely wait on the same lock.
+constexpr size_t kNumShards = 64;
+
+}  // namespace
+
+struct Path::Shard {
+  // Guards children, and the removal of a node from it when its last
+  // reference is dropped.
+  mutex mu;
+  absl::flat_hash_map<ChildKey, const Node*> children;
+};
+
+Path::Shard& Path::GetShard(const Node* parent, absl::string_view step) {
+  // The shards are never destroyed, so that Paths with static storage
+  // duration stay valid until the end of the process.
+  static Shard* shards = new Shard[kNumShards];
+  return shards[absl::Hash<ChildKey>()(ChildKey(parent, step)) % kNumShards];
+}
+
+const Path::Node* Path::GetChildNode(const Node* parent,
+                                     absl::string_view step) {
+  Shard& shard = GetShard(parent, step);
+  const ChildKey key(parent, step);
+  // A node that is in the table has a reference, and it is only removed from
+  // the table under an exclusive lock, so it can be referenced under a shared
+  // one.
+  {
+    tf_shared_lock lock(shard.mu);
+    const auto iter = shard.children.find(key);
+    if (iter != shard.children.end()) {
+      Ref(iter->second);
+      return iter->second;
+    }
+  }
+  mutex_lock lock(shard.mu);
+  const auto iter = shard.children.find(key);
+  if (iter != shard.children.end()) {
+    Ref(iter->second);
+    return iter->second;
+  }
+  // The caller holds a reference to parent.
+  Ref(parent);
+  const Node* child = new Node(parent, step);
+  shard.children.emplace(ChildKey(parent, child->step), child);
+  return child;
+}
+
+void Path::Unref(const Node* node) {
+  while (node != nullptr) {
+    // Drops a reference that is not the last one without locking.
+    int64 refs = node->refs.load(std::memory_order_relaxed);
+    while (refs > 1) {
+      if (node->refs.compare_exchange_weak(refs, refs - 1,
+                                           std::memory_order_acq_rel)) {
+        return;
+      }
+    }
+    // The last reference is dropped under the lock of the shard, so that
+    // GetChildNode() cannot reference the node while it is being freed.
+    const Node* parent = node->parent;
+    Shard& shard = GetShard(parent, node->step);
+    {
+      mutex_lock lock(shard.mu);
+      if (node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+      }
+      shard.children.erase(ChildKey(parent, node->step));
+    }
+    delete node;
+    // Drops the reference of the node to its parent.
+    node = parent;
+  }
+}
+
+std::vector<const Path::Node*> Path::GetNodes() const {
+  std::vector<const Node*> nodes(size());
+  const Node* node = node_;
+  for (auto iter = nodes.rbegin(); iter != nodes.rend(); ++iter) {
+    *iter = node;
+    node = node->parent;
+  }
+  return nodes;
+}
+
+// Part of the implementation of Compare().
+bool Path::Equals(const Path& p) const { return node_ == p.node_; }
+
 bool Path::Less(const Path& p) const {
-  return std::lexicographical_compare(step_.begin(), step_.end(),
-                                      p.step_.begin(), p.step_.end());
+  // Walks up the longer path to the size of the shorter one. If they are
+  // equal then, the shorter one is a prefix of the longer one.
+  const Node* a = node_;
+  const Node* b = p.node_;
+  for (size_t i = size(); i > p.size(); --i) {
+    a = a->parent;
+  }
+  for (size_t i = p.size(); i > size(); --i) {
+    b = b->parent;
+  }
+  if (a == b) {
+    return size() < p.size();
+  }
+  // Walks up both to the first steps that differ.
+  while (a->parent != b->parent) {
+    a = a->parent;
+    b = b->parent;
+  }
+  return a->step < b->step;
 }
 
 int Path::Compare(const Path& p) const {
@@ -154,39 +290,44 @@ bool operator!=(const Path& a, const Path& b) { return a.Compare(b) != 0; }
 string Path::Serialize() const {
   const string separator = ".";
   std::vector<string> serialized_steps;
-  for (const string& step : step_) {
-    serialized_steps.push_back(SerializeStep(step));
+  for (const Node* node : GetNodes()) {
+    serialized_steps.push_back(SerializeStep(node->step));
   }
   return absl::StrJoin(serialized_steps, separator);
 }
 
 tensorflow::metadata::v0::Path Path::AsProto() const {
   tensorflow::metadata::v0::Path path;
-  for (const string& step : step_) {
-    path.add_step(step);
-  }
+  ToProto(&path);
   return path;
 }
 
+void Path::ToProto(tensorflow::metadata::v0::Path* proto) const {
+  proto->clear_step();
+  proto->mutable_step()->Reserve(size());
+  for (const Node* node : GetNodes()) {
+    proto->add_step(node->step);
+  }
+}
+
 // Deserializes a string created with Serialize().
 // Note: for any path p:
 // p==Path::Deserialize(p.Serialize())
 tensorflow::Status Path::Deserialize(absl::string_view str, Path* result) {
-  result->step_.clear();
+  *result = Path();
   if (str.empty()) {
     return Status::OK();
   }
-  result->step_ = absl::StrSplit(str, StepDelimiter());
-  for (string& step : result->step_) {
+  std::vector<string> steps = absl::StrSplit(str, StepDelimiter());
+  for (string& step : steps) {
     TF_RETURN_IF_ERROR(DeserializeStep(&step));
   }
+  *result = Path(steps);
   return Status::OK();
 }
 
 Path Path::GetChild(absl::string_view last_step) const {
-  std::vector<string> new_steps(step_.begin(), step_.end());
-  new_steps.push_back(string(last_step));
-  return Path(std::move(new_steps));
+  return Path(GetChildNode(node_, last_step));
 }
 
 void PrintTo(const Path& p, std::ostream* o) {
@@ -1,11 +1,14 @@
 #ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_PATH_H_
 #define TENSORFLOW_DATA_VALIDATION_ANOMALIES_PATH_H_
 
+#include <atomic>
 #include <iosfwd>
 #include <string>
+#include <utility>
 #include <vector>
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
 #include "tensorflow_metadata/proto/v0/path.pb.h"
 
 namespace tensorflow {
@@ -42,25 +45,31 @@ namespace data_validation {
 // {foo, ((c), Marty's} becomes foo.'((c)'.'Marty''s'
 // Importantly, note that Serialize is an injection (1-1). For any string
 // generated by Serialize(), Deserialize() will invert the process.
+// Paths are interned: each distinct path is stored once per process, as its
+// last step and a pointer to its parent. So a Path is a single pointer, which
+// is copied, compared for equality and hashed in O(1) time, and GetParent()
+// does not allocate. An interned path is reference counted, and freed once no
+// Path refers to it or to one of its children.
 class Path {
  public:
   Path() = default;
-  explicit Path(std::vector<string> step) : step_(std::move(step)) {}
+  explicit Path(const std::vector<string>& step);
   explicit Path(const tensorflow::metadata::v0::Path& p);
-  Path(const Path& p) = default;
-  Path(Path&& p) = default;
-  Path& operator=(const Path& p) = default;
-  Path& operator=(Path&& p) = default;
+  Path(const Path& p) : node_(p.node_) { Ref(node_); }
+  Path(Path&& p) : node_(p.node_) { p.node_ = nullptr; }
+  Path& operator=(const Path& p);
+  Path& operator=(Path&& p);
+  ~Path() { Unref(node_); }
 
   // Returns -1, 0, 1 if *this is greater than, less than or equal to p.
   int Compare(const Path& p) const;
 
   // Number of steps in a path.
-  size_t size() const { return step_.size(); }
+  size_t size() const { return node_ == nullptr ? 0 : node_->size; }
 
   // Since we store the steps with the separators, sometimes we need to remove
   // the separator.
-  const string& last_step() const { return step_.back(); }
+  const string& last_step() const { return node_->step; }
 
   // Serialize a path into a string that can be Deserialized.
   // Intended to be as human-readable as possible.
@@ -70,6 +79,10 @@ class Path {
   // Serialize the path to a proto.
   tensorflow::metadata::v0::Path AsProto() const;
 
+  // Same as above, but writes the steps into *proto (replacing any steps
+  // there), so that it can be filled in place, e.g., on an arena.
+  void ToProto(tensorflow::metadata::v0::Path* proto) const;
+
   // Deserializes a string created with Serialize().
   // Note: for any path p (i.e. arbitrary steps):
   // Path p2;
@@ -78,16 +91,75 @@ class Path {
   static tensorflow::Status Deserialize(absl::string_view str, Path* result);
 
   // True if there are no steps.
-  bool empty() const { return step_.empty(); }
+  bool empty() const { return node_ == nullptr; }
 
-  // Get the parent path.
+  // Get the parent path. The path must not be empty.
   Path GetParent() const {
-    return Path(std::vector<string>(step_.begin(), step_.end() - 1));
+    Ref(node_->parent);
+    return Path(node_->parent);
   }
 
+  // Get a child path. This only allocates if no Path refers to the child (or
+  // to one of its children).
   Path GetChild(absl::string_view last_step) const;
 
+  // Allows a Path to be used as a key in absl hash containers. Since paths
+  // are interned, the hash does not depend on the steps, so the order of
+  // a hash container of paths may change from one process to the next.
+  template <typename H>
+  friend H AbslHashValue(H h, const Path& p) {
+    return H::combine(std::move(h), p.node_);
+  }
+
  private:
+  // An interned path. There is at most one Node for each distinct nonempty
+  // path.
+  struct Node {
+    Node(const Node* parent, absl::string_view step)
+        : parent(parent),
+          step(step),
+          size(parent == nullptr ? 1 : parent->size + 1) {}
+
+    // The node of the parent, or nullptr if the parent is empty. A node holds
+    // a reference to its parent.
+    const Node* parent;
+    string step;
+    // The number of steps.
+    size_t size;
+    // The number of Paths and child nodes that refer to this node.
+    mutable std::atomic<int64> refs{1};
+  };
+
+  // A shard of the table of nodes.
+  struct Shard;
+
+  // Takes over a reference to node.
+  explicit Path(const Node* node) : node_(node) {}
+
+  // Returns the shard of the table that holds the child of parent with the
+  // given last step.
+  static Shard& GetShard(const Node* parent, absl::string_view step);
+
+  // Returns a new reference to the node of the child of parent (nullptr for
+  // the empty path) with the given last step, creating it if needed. Only
+  // locks the shard of the child. Thread-safe.
+  static const Node* GetChildNode(const Node* parent, absl::string_view step);
+
+  // Adds a reference to node, which may be nullptr. The caller must already
+  // hold a reference to it.
+  static void Ref(const Node* node) {
+    if (node != nullptr) {
+      node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Drops a reference to node, which may be nullptr. Frees the node (and
+  // drops its reference to its parent) when this was the last one.
+  static void Unref(const Node* node);
+
+  // Returns the nodes of the path, from the first step to the last.
+  std::vector<const Node*> GetNodes() const;
+
   // Returns true iff this is equal to p.
   // Part of the implementation of Compare().
   bool Equals(const Path& p) const;
@@ -96,8 +168,8 @@ class Path {
   // Part of the implementation of Compare().
   bool Less(const Path& p) const;
 
-  // The raw steps of a path.
-  std::vector<string> step_;
+  // The node of the last step, or nullptr if the path is empty.
+  const Node* node_ = nullptr;
 };
 
 // Lexicographical ordering on steps.
@@ -1,10 +1,14 @@
 #include "tensorflow_data_validation/anomalies/path.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/hash/hash.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow_data_validation/anomalies/test_util.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow_metadata/proto/v0/path.pb.h"
 
 namespace tensorflow {
@@ -134,6 +138,71 @@ TEST(Path, GetChild) {
   EXPECT_EQ("a", Path().GetChild("a").Serialize());
 }
 
+TEST(Path, Interned) {
+  const Path path({"a", "b", "c"});
+  Path deserialized;
+  TF_ASSERT_OK(Path::Deserialize("a.b.c", &deserialized));
+  for (const Path& other :
+       {deserialized, Path({"a"}).GetChild("b").GetChild("c"),
+        Path({"a", "b", "c", "d"}).GetParent()}) {
+    EXPECT_EQ(path, other);
+    EXPECT_EQ(absl::Hash<Path>()(path), absl::Hash<Path>()(other));
+  }
+  EXPECT_NE(path, Path({"a", "b", "d"}));
+  EXPECT_NE(path, Path({"b", "c"}));
+  EXPECT_TRUE(Path().GetChild("a").GetParent().empty());
+}
+
+// Copies, moves and assignments keep the paths that they refer to, and a path
+// that is freed is interned again when it is created again.
+TEST(Path, Reclaimed) {
+  Path path({"reclaimed", "child"});
+  Path copy = path;
+  Path moved = std::move(path);
+  EXPECT_TRUE(path.empty());
+  path = moved;
+  const Path& self = path;
+  path = self;
+  copy = Path({"other"});
+  EXPECT_EQ("reclaimed.child", path.Serialize());
+  EXPECT_EQ("reclaimed.child", moved.Serialize());
+  EXPECT_EQ("other", copy.Serialize());
+  const Path parent = path.GetParent();
+  path = Path();
+  moved = Path();
+  EXPECT_EQ("reclaimed", parent.Serialize());
+  EXPECT_EQ(parent.GetChild("child"), Path({"reclaimed", "child"}));
+}
+
+// Threads that create and free the same paths concurrently.
+TEST(Path, Concurrent) {
+  {
+    // The destructor of the pool waits for all the work to finish.
+    thread::ThreadPool pool(Env::Default(), "path_test", 8);
+    for (int i = 0; i < 8; ++i) {
+      pool.Schedule([]() {
+        for (int j = 0; j < 1000; ++j) {
+          const Path path({"a", absl::StrCat(j % 10), "b"});
+          const Path copy = path.GetParent().GetChild("b");
+          EXPECT_EQ(path, copy);
+        }
+      });
+    }
+  }
+  EXPECT_EQ(Path({"a", "1", "b"}), Path({"a", "1"}).GetChild("b"));
+}
+
+// Ordering paths with common prefixes of different sizes.
+TEST(Path, CompareCommonPrefix) {
+  EXPECT_LT(Path({"a", "b", "z"}), Path({"a", "c"}));
+  EXPECT_GT(Path({"a", "c"}), Path({"a", "b", "z"}));
+  EXPECT_LT(Path({"a"}), Path({"a", "a"}));
+  EXPECT_LT(Path(), Path({"a"}));
+  EXPECT_LT(Path({"a", "b"}), Path({"b"}));
+  EXPECT_LT(Path({"ab"}), Path({"b", "a"}));
+  EXPECT_GT(Path({"b", "a"}), Path({"a", "b", "c"}));
+}
+
 TEST(Path, size) {
   EXPECT_EQ(3, Path({"a", "b", "c"}).size());
   EXPECT_EQ(0, Path().size());
@@ -0,0 +1,322 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/quantiles_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tensorflow_data_validation/anomalies/proto/quantiles_sketch.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+constexpr int64 QuantilesSketch::kDefaultMaxNumElements;
+
+QuantilesSketch::QuantilesSketch(double epsilon, int64 max_num_elements)
+    : epsilon_(epsilon), max_num_elements_(max_num_elements) {
+  if (epsilon_ <= std::numeric_limits<double>::epsilon()) {
+    // A single exact summary.
+    block_size_ = std::max(max_num_elements_, int64{2});
+    return;
+  }
+  // As in TensorFlow's boosted trees quantile ops, finds the smallest number
+  // of levels such that the hierarchy holds max_num_elements values, with a
+  // block size that keeps the error of all the levels within epsilon.
+  block_size_ = 2;
+  for (int64 num_levels = 1;
+       std::ldexp(static_cast<double>(block_size_), num_levels) <
+       max_num_elements_;
+       ++num_levels) {
+    block_size_ = static_cast<int64>(std::ceil(num_levels / epsilon_)) + 1;
+  }
+}
+
+void QuantilesSketch::Add(double value, double weight) {
+  if (std::isnan(value) || !(weight >= 0.0)) {
+    return;
+  }
+  buffer_.emplace_back(value, weight);
+  if (buffer_.size() >= static_cast<size_t>(block_size_)) {
+    Propagate(BuildSummary(&buffer_), 0);
+  }
+}
+
+void QuantilesSketch::AddValues(const double* values, const double* weights,
+                                int64 num_values) {
+  for (int64 i = 0; i < num_values; ++i) {
+    Add(values[i], weights == nullptr ? 1.0 : weights[i]);
+  }
+}
+
+Status QuantilesSketch::Merge(const QuantilesSketch& other) {
+  if (&other == this) {
+    const QuantilesSketch copy = other;
+    return Merge(copy);
+  }
+  if (other.epsilon_ != epsilon_ ||
+      other.max_num_elements_ != max_num_elements_) {
+    return errors::InvalidArgument(
+        "Cannot merge a quantiles sketch with epsilon ", other.epsilon_,
+        " and max_num_elements ", other.max_num_elements_,
+        " into one with epsilon ", epsilon_, " and max_num_elements ",
+        max_num_elements_);
+  }
+  for (size_t level = 0; level < other.levels_.size(); ++level) {
+    if (!other.levels_[level].empty()) {
+      Propagate(other.levels_[level], level);
+    }
+  }
+  for (const auto& value_and_weight : other.buffer_) {
+    Add(value_and_weight.first, value_and_weight.second);
+  }
+  return Status::OK();
+}
+
+std::vector<double> QuantilesSketch::GetQuantiles(int64 num_quantiles) const {
+  const Summary summary = GetFinalSummary();
+  if (summary.empty()) {
+    return {};
+  }
+  num_quantiles = std::max(num_quantiles, int64{1});
+  const double total_weight = summary.back().max_rank;
+  std::vector<double> result;
+  result.reserve(num_quantiles + 1);
+  result.push_back(summary.front().value);
+  int64 index = 0;
+  for (int64 i = 1; i < num_quantiles; ++i) {
+    index = FindRank(summary, i * total_weight / num_quantiles, index);
+    result.push_back(summary[index].value);
+  }
+  result.push_back(summary.back().value);
+  return result;
+}
+
+double QuantilesSketch::total_weight() const {
+  double result = 0.0;
+  for (const Summary& summary : levels_) {
+    if (!summary.empty()) {
+      result += summary.back().max_rank;
+    }
+  }
+  for (const auto& value_and_weight : buffer_) {
+    result += value_and_weight.second;
+  }
+  return result;
+}
+
+string QuantilesSketch::Serialize() const {
+  QuantilesSketchProto proto;
+  proto.set_epsilon(epsilon_);
+  proto.set_max_num_elements(max_num_elements_);
+  for (const Summary& summary : levels_) {
+    QuantilesSketchProto::Summary* summary_proto = proto.add_levels();
+    summary_proto->mutable_values()->Reserve(summary.size());
+    summary_proto->mutable_weights()->Reserve(summary.size());
+    summary_proto->mutable_min_ranks()->Reserve(summary.size());
+    summary_proto->mutable_max_ranks()->Reserve(summary.size());
+    for (const Entry& entry : summary) {
+      summary_proto->add_values(entry.value);
+      summary_proto->add_weights(entry.weight);
+      summary_proto->add_min_ranks(entry.min_rank);
+      summary_proto->add_max_ranks(entry.max_rank);
+    }
+  }
+  proto.mutable_buffer_values()->Reserve(buffer_.size());
+  proto.mutable_buffer_weights()->Reserve(buffer_.size());
+  for (const auto& value_and_weight : buffer_) {
+    proto.add_buffer_values(value_and_weight.first);
+    proto.add_buffer_weights(value_and_weight.second);
+  }
+  return proto.SerializeAsString();
+}
+
+Status QuantilesSketch::Deserialize(absl::string_view str,
+                                    QuantilesSketch* result) {
+  QuantilesSketchProto proto;
+  if (!proto.ParseFromArray(str.data(), str.size())) {
+    return errors::InvalidArgument("Cannot parse a quantiles sketch.");
+  }
+  if (!(proto.epsilon() >= 0.0) || proto.max_num_elements() <= 0 ||
+      proto.buffer_values_size() != proto.buffer_weights_size()) {
+    return errors::InvalidArgument("Invalid quantiles sketch.");
+  }
+  *result = QuantilesSketch(proto.epsilon(), proto.max_num_elements());
+  for (const QuantilesSketchProto::Summary& summary_proto : proto.levels()) {
+    const int size = summary_proto.values_size();
+    if (summary_proto.weights_size() != size ||
+        summary_proto.min_ranks_size() != size ||
+        summary_proto.max_ranks_size() != size) {
+      return errors::InvalidArgument("Invalid summary in quantiles sketch.");
+    }
+    result->levels_.emplace_back();
+    Summary& summary = result->levels_.back();
+    summary.reserve(size);
+    for (int i = 0; i < size; ++i) {
+      summary.push_back(
+          {summary_proto.values(i), summary_proto.weights(i),
+           summary_proto.min_ranks(i), summary_proto.max_ranks(i)});
+    }
+  }
+  result->buffer_.reserve(proto.buffer_values_size());
+  for (int i = 0; i < proto.buffer_values_size(); ++i) {
+    result->buffer_.emplace_back(proto.buffer_values(i),
+                                 proto.buffer_weights(i));
+  }
+  return Status::OK();
+}
+
+QuantilesSketch::Summary QuantilesSketch::BuildSummary(
+    std::vector<std::pair<double, double>>* buffer) {
+  std::sort(buffer->begin(), buffer->end());
+  Summary result;
+  result.reserve(buffer->size());
+  double rank = 0.0;
+  for (const auto& value_and_weight : *buffer) {
+    const double weight = value_and_weight.second;
+    if (!result.empty() && result.back().value == value_and_weight.first) {
+      result.back().weight += weight;
+      result.back().max_rank += weight;
+    } else {
+      result.push_back({value_and_weight.first, weight, rank, rank + weight});
+    }
+    rank += weight;
+  }
+  buffer->clear();
+  return result;
+}
+
+void QuantilesSketch::Propagate(Summary summary, int64 level) {
+  for (;; ++level) {
+    if (level == static_cast<int64>(levels_.size())) {
+      levels_.emplace_back();
+    }
+    Summary& current = levels_[level];
+    if (current.empty()) {
+      current = std::move(summary);
+      return;
+    }
+    summary = MergeSummaries(current, summary);
+    current.clear();
+    Compress(block_size_, &summary);
+  }
+}
+
+QuantilesSketch::Summary QuantilesSketch::MergeSummaries(const Summary& a,
+                                                         const Summary& b) {
+  if (a.empty()) {
+    return b;
+  }
+  if (b.empty()) {
+    return a;
+  }
+  Summary result;
+  result.reserve(a.size() + b.size());
+  auto a_it = a.begin();
+  auto b_it = b.begin();
+  // The minimum weight of the values of a (resp. b) before a_it (resp. b_it).
+  double a_next_min_rank = 0.0;
+  double b_next_min_rank = 0.0;
+  while (a_it != a.end() && b_it != b.end()) {
+    if (a_it->value < b_it->value) {
+      result.push_back({a_it->value, a_it->weight,
+                        a_it->min_rank + b_next_min_rank,
+                        a_it->max_rank + b_it->PrevMaxRank()});
+      a_next_min_rank = a_it->NextMinRank();
+      ++a_it;
+    } else if (b_it->value < a_it->value) {
+      result.push_back({b_it->value, b_it->weight,
+                        b_it->min_rank + a_next_min_rank,
+                        b_it->max_rank + a_it->PrevMaxRank()});
+      b_next_min_rank = b_it->NextMinRank();
+      ++b_it;
+    } else {
+      result.push_back({a_it->value, a_it->weight + b_it->weight,
+                        a_it->min_rank + b_it->min_rank,
+                        a_it->max_rank + b_it->max_rank});
+      a_next_min_rank = a_it->NextMinRank();
+      b_next_min_rank = b_it->NextMinRank();
+      ++a_it;
+      ++b_it;
+    }
+  }
+  for (; a_it != a.end(); ++a_it) {
+    result.push_back({a_it->value, a_it->weight,
+                      a_it->min_rank + b_next_min_rank,
+                      a_it->max_rank + b.back().max_rank});
+  }
+  for (; b_it != b.end(); ++b_it) {
+    result.push_back({b_it->value, b_it->weight,
+                      b_it->min_rank + a_next_min_rank,
+                      b_it->max_rank + a.back().max_rank});
+  }
+  return result;
+}
+
+void QuantilesSketch::Compress(int64 size, Summary* summary) {
+  size = std::max(size, int64{2});
+  if (summary->size() <= static_cast<size_t>(size) + 1) {
+    return;
+  }
+  const double total_weight = summary->back().max_rank;
+  Summary result;
+  result.reserve(size + 1);
+  result.push_back(summary->front());
+  int64 index = 0;
+  for (int64 i = 1; i < size; ++i) {
+    index = FindRank(*summary, i * total_weight / size, index);
+    if (index != 0 && (*summary)[index].value != result.back().value) {
+      result.push_back((*summary)[index]);
+    }
+  }
+  if (summary->back().value != result.back().value) {
+    result.push_back(summary->back());
+  }
+  *summary = std::move(result);
+}
+
+int64 QuantilesSketch::FindRank(const Summary& summary, double rank,
+                                int64 start) {
+  // As in TensorFlow's boosted trees quantile ops, finds the last entry whose
+  // rank range [min_rank, max_rank] has its middle at most rank, and picks it
+  // or the next entry, whichever is closer.
+  const double double_rank = 2.0 * rank;
+  const int64 size = summary.size();
+  int64 next = start + 1;
+  while (next < size &&
+         double_rank >= summary[next].min_rank + summary[next].max_rank) {
+    ++next;
+  }
+  if (next == size ||
+      double_rank <
+          summary[next - 1].NextMinRank() + summary[next].PrevMaxRank()) {
+    return next - 1;
+  }
+  return next;
+}
+
+QuantilesSketch::Summary QuantilesSketch::GetFinalSummary() const {
+  std::vector<std::pair<double, double>> buffer = buffer_;
+  Summary result = BuildSummary(&buffer);
+  for (const Summary& summary : levels_) {
+    result = MergeSummaries(result, summary);
+  }
+  return result;
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,134 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A mergeable sketch of the quantiles of a stream of weighted values, used by
+// QuantilesCombiner in utils/quantiles_util.py.
+//
+// This is the weighted variant of the Greenwald-Khanna summary used by
+// TensorFlow's boosted trees quantile ops: values are buffered, and each full
+// buffer becomes an exact summary that is merged into a binary hierarchy of
+// summaries of at most block_size() entries. Each level of the hierarchy adds
+// at most 1 / block_size() of the total weight to the error of a rank, and
+// there are enough levels for max_num_elements values, so the rank of a
+// quantile is within epsilon of the total weight.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_QUANTILES_SKETCH_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_QUANTILES_SKETCH_H_
+
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+class QuantilesSketch {
+ public:
+  // The default maximum number of values, as in tf.Transform.
+  static constexpr int64 kDefaultMaxNumElements = int64{1} << 32;
+
+  // epsilon is the maximum error of the rank of a quantile, as a fraction of
+  // the total weight. If epsilon is 0, the quantiles are exact.
+  explicit QuantilesSketch(double epsilon,
+                           int64 max_num_elements = kDefaultMaxNumElements);
+
+  // Adds a value. NaN values and negative weights are ignored.
+  void Add(double value, double weight);
+
+  // Adds num_values values, with the given weights (or 1 for each value if
+  // weights is null).
+  void AddValues(const double* values, const double* weights,
+                 int64 num_values);
+
+  // Adds the values of other. Returns InvalidArgument if other has a
+  // different epsilon or max_num_elements.
+  Status Merge(const QuantilesSketch& other);
+
+  // Returns num_quantiles + 1 boundaries: the minimum value, the
+  // num_quantiles - 1 boundaries between the quantiles, and the maximum
+  // value. Returns an empty vector if no values were added.
+  std::vector<double> GetQuantiles(int64 num_quantiles) const;
+
+  // The total weight of the values added.
+  double total_weight() const;
+
+  // Serializes the sketch to a QuantilesSketchProto, which is packed, so
+  // that the sketch is cheap to shuffle.
+  string Serialize() const;
+
+  // Deserializes a sketch serialized with Serialize().
+  static Status Deserialize(absl::string_view str, QuantilesSketch* result);
+
+  double epsilon() const { return epsilon_; }
+  int64 max_num_elements() const { return max_num_elements_; }
+  // The maximum number of entries of a summary of the hierarchy, which is
+  // also the size of the buffer.
+  int64 block_size() const { return block_size_; }
+
+ private:
+  // An entry of a summary. All the values less than value weigh at least
+  // min_rank and at most max_rank - weight in all, and value weighs weight.
+  struct Entry {
+    double value;
+    double weight;
+    double min_rank;
+    double max_rank;
+
+    // The minimum weight of the values up to and including value.
+    double NextMinRank() const { return min_rank + weight; }
+    // The maximum weight of the values less than value.
+    double PrevMaxRank() const { return max_rank - weight; }
+  };
+
+  // Entries sorted by value, with distinct values.
+  using Summary = std::vector<Entry>;
+
+  // Returns the exact summary of the values in buffer, and clears buffer.
+  static Summary BuildSummary(std::vector<std::pair<double, double>>* buffer);
+
+  // Adds summary to the given level of the hierarchy, and carries the merged
+  // summaries to the higher levels like a binary counter.
+  void Propagate(Summary summary, int64 level);
+
+  // Returns the merge of a and b.
+  static Summary MergeSummaries(const Summary& a, const Summary& b);
+
+  // Keeps at most size + 1 entries of summary, including the first and the
+  // last, which adds at most 1 / size of the total weight to the error.
+  static void Compress(int64 size, Summary* summary);
+
+  // Returns the index of the entry of summary whose rank is closest to rank,
+  // searching from the entry at index start.
+  static int64 FindRank(const Summary& summary, double rank, int64 start);
+
+  // Returns the merge of all the summaries and buffer_.
+  Summary GetFinalSummary() const;
+
+  double epsilon_;
+  int64 max_num_elements_;
+  int64 block_size_;
+
+  // The values (and their weights) not yet in a summary.
+  std::vector<std::pair<double, double>> buffer_;
+  // levels_[i] is empty, or summarizes about block_size_ * 2^i values.
+  std::vector<Summary> levels_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_QUANTILES_SKETCH_H_
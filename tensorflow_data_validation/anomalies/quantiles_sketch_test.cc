@@ -0,0 +1,138 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/quantiles_sketch.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Adds the values from begin to end - 1, each with the given weight.
+void AddRange(int begin, int end, double weight, QuantilesSketch* sketch) {
+  for (int i = begin; i < end; ++i) {
+    sketch->Add(i, weight);
+  }
+}
+
+TEST(QuantilesSketchTest, Empty) {
+  const QuantilesSketch sketch(0.01);
+  EXPECT_THAT(sketch.GetQuantiles(4), IsEmpty());
+  EXPECT_EQ(0.0, sketch.total_weight());
+}
+
+TEST(QuantilesSketchTest, ExactQuantilesOfMergedSketches) {
+  QuantilesSketch sketch(0.00001);
+  QuantilesSketch second(0.00001);
+  QuantilesSketch third(0.00001);
+  AddRange(1, 101, 1.0, &sketch);
+  AddRange(101, 201, 1.0, &second);
+  AddRange(201, 301, 1.0, &third);
+  TF_ASSERT_OK(sketch.Merge(second));
+  TF_ASSERT_OK(sketch.Merge(third));
+  EXPECT_THAT(sketch.GetQuantiles(5),
+              ElementsAre(1.0, 61.0, 121.0, 181.0, 241.0, 300.0));
+  EXPECT_EQ(300.0, sketch.total_weight());
+}
+
+TEST(QuantilesSketchTest, ExactWeightedQuantiles) {
+  QuantilesSketch sketch(0.00001);
+  AddRange(1, 101, 1.0, &sketch);
+  AddRange(101, 201, 2.0, &sketch);
+  AddRange(201, 301, 3.0, &sketch);
+  EXPECT_THAT(sketch.GetQuantiles(5),
+              ElementsAre(1.0, 111.0, 171.0, 221.0, 261.0, 300.0));
+}
+
+TEST(QuantilesSketchTest, IgnoresNaNAndNegativeWeights) {
+  QuantilesSketch sketch(0.01);
+  sketch.Add(std::numeric_limits<double>::quiet_NaN(), 1.0);
+  sketch.Add(1.0, -1.0);
+  sketch.Add(2.0, 1.0);
+  sketch.Add(2.0, 1.0);
+  const std::vector<double> values = {3.0, 4.0};
+  const std::vector<double> weights = {2.0, 1.0};
+  sketch.AddValues(values.data(), weights.data(), values.size());
+  EXPECT_EQ(5.0, sketch.total_weight());
+  EXPECT_THAT(sketch.GetQuantiles(2), ElementsAre(2.0, 3.0, 4.0));
+}
+
+TEST(QuantilesSketchTest, RankErrorIsWithinEpsilon) {
+  const double kEpsilon = 0.01;
+  const int kNumValues = 100000;
+  QuantilesSketch sketch(kEpsilon);
+  // Adds the values 0 to kNumValues - 1 in a scrambled order, in two
+  // sketches that are then merged.
+  QuantilesSketch other(kEpsilon);
+  for (int i = 0; i < kNumValues; ++i) {
+    const int value = (i * 7919) % kNumValues;
+    (i % 3 == 0 ? &other : &sketch)->Add(value, 1.0);
+  }
+  TF_ASSERT_OK(sketch.Merge(other));
+  EXPECT_LT(sketch.block_size(), kNumValues);
+
+  const int kNumQuantiles = 20;
+  const std::vector<double> quantiles = sketch.GetQuantiles(kNumQuantiles);
+  ASSERT_EQ(kNumQuantiles + 1, quantiles.size());
+  EXPECT_EQ(0.0, quantiles.front());
+  EXPECT_EQ(kNumValues - 1, quantiles.back());
+  for (int i = 1; i < kNumQuantiles; ++i) {
+    // The rank of the value v is v.
+    const double expected_rank = i * kNumValues / kNumQuantiles;
+    EXPECT_NEAR(expected_rank, quantiles[i], kEpsilon * kNumValues);
+  }
+}
+
+TEST(QuantilesSketchTest, SerializeAndDeserialize) {
+  QuantilesSketch sketch(0.1);
+  AddRange(0, 1000, 1.0, &sketch);
+  sketch.Add(0.5, 2.0);
+  QuantilesSketch result(0.0);
+  TF_ASSERT_OK(QuantilesSketch::Deserialize(sketch.Serialize(), &result));
+  EXPECT_EQ(sketch.epsilon(), result.epsilon());
+  EXPECT_EQ(sketch.max_num_elements(), result.max_num_elements());
+  EXPECT_EQ(sketch.total_weight(), result.total_weight());
+  EXPECT_EQ(sketch.GetQuantiles(10), result.GetQuantiles(10));
+
+  // The deserialized sketch can be merged with one of the same epsilon.
+  TF_ASSERT_OK(result.Merge(sketch));
+  EXPECT_EQ(2 * sketch.total_weight(), result.total_weight());
+}
+
+TEST(QuantilesSketchTest, DeserializeInvalid) {
+  QuantilesSketch result(0.0);
+  EXPECT_FALSE(QuantilesSketch::Deserialize("not a sketch", &result).ok());
+}
+
+TEST(QuantilesSketchTest, MergeWithDifferentEpsilon) {
+  QuantilesSketch sketch(0.01);
+  const QuantilesSketch other(0.1);
+  EXPECT_FALSE(sketch.Merge(other).ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/schema.h"
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/memory/memory.h"
@@ -34,7 +37,10 @@ limitations under the License.
 #include "tensorflow_data_validation/anomalies/schema_util.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
 #include "tensorflow_data_validation/anomalies/string_domain_util.h"
+#include "tensorflow_data_validation/anomalies/validation_profiler.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
@@ -62,30 +68,6 @@ bool ContainsValue(const Container& a, const string& value) {
   return absl::c_find(a, value) != a.end();
 }
 
-std::set<tensorflow::metadata::v0::FeatureType> AllowedFeatureTypes(
-    Feature::DomainInfoCase domain_info_case) {
-  switch (domain_info_case) {
-    case Feature::kDomain:
-      return {tensorflow::metadata::v0::BYTES};
-    case Feature::kBoolDomain:
-      return {tensorflow::metadata::v0::INT, tensorflow::metadata::v0::BYTES};
-    case Feature::kIntDomain:
-      return {tensorflow::metadata::v0::INT, tensorflow::metadata::v0::BYTES};
-    case Feature::kFloatDomain:
-      return {tensorflow::metadata::v0::FLOAT, tensorflow::metadata::v0::BYTES};
-    case Feature::kStringDomain:
-      return {tensorflow::metadata::v0::BYTES};
-    case Feature::kStructDomain:
-      return {tensorflow::metadata::v0::STRUCT};
-    case Feature::DOMAIN_INFO_NOT_SET:
-      ABSL_FALLTHROUGH_INTENDED;
-    default:
-      return {tensorflow::metadata::v0::INT, tensorflow::metadata::v0::FLOAT,
-              tensorflow::metadata::v0::BYTES,
-              tensorflow::metadata::v0::STRUCT};
-  }
-}
-
 // Remove all elements from the input array for which the input predicate
 // pred is true. Returns number of erased elements.
 template <typename T, typename Predicate>
@@ -105,17 +87,6 @@ int RemoveIf(::tensorflow::protobuf::RepeatedPtrField<T>* array,
   return end - i;
 }
 
-Feature* GetExistingFeatureHelper(
-    const string& last_part,
-    tensorflow::protobuf::RepeatedPtrField<Feature>* features) {
-  for (tensorflow::metadata::v0::Feature& feature : *features) {
-    if (feature.name() == last_part) {
-      return &feature;
-    }
-  }
-  return nullptr;
-}
-
 void ClearStringDomainHelper(
     const string& domain_name,
     tensorflow::protobuf::RepeatedPtrField<Feature>* features) {
@@ -130,16 +101,111 @@ void ClearStringDomainHelper(
   }
 }
 
-SparseFeature* GetExistingSparseFeatureHelper(
-    const string& name,
-    tensorflow::protobuf::RepeatedPtrField<
-        tensorflow::metadata::v0::SparseFeature>* sparse_features) {
-  for (SparseFeature& sparse_feature : *sparse_features) {
-    if (sparse_feature.name() == name) {
-      return &sparse_feature;
+// Copies one field that is set in from into to.
+void CopyField(const tensorflow::protobuf::Message& from,
+               const tensorflow::protobuf::FieldDescriptor* field,
+               tensorflow::protobuf::Message* to) {
+  using FieldDescriptor = tensorflow::protobuf::FieldDescriptor;
+  const tensorflow::protobuf::Reflection* reflection = from.GetReflection();
+  if (!field->is_repeated()) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        reflection->SetInt32(to, field, reflection->GetInt32(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        reflection->SetInt64(to, field, reflection->GetInt64(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        reflection->SetUInt32(to, field, reflection->GetUInt32(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        reflection->SetUInt64(to, field, reflection->GetUInt64(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        reflection->SetDouble(to, field, reflection->GetDouble(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        reflection->SetFloat(to, field, reflection->GetFloat(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        reflection->SetBool(to, field, reflection->GetBool(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        reflection->SetEnumValue(to, field,
+                                 reflection->GetEnumValue(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        reflection->SetString(to, field, reflection->GetString(from, field));
+        break;
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        reflection->MutableMessage(to, field)
+            ->CopyFrom(reflection->GetMessage(from, field));
+        break;
+    }
+    return;
+  }
+  for (int i = 0; i < reflection->FieldSize(from, field); ++i) {
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_INT32:
+        reflection->AddInt32(to, field,
+                             reflection->GetRepeatedInt32(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        reflection->AddInt64(to, field,
+                             reflection->GetRepeatedInt64(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        reflection->AddUInt32(to, field,
+                              reflection->GetRepeatedUInt32(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        reflection->AddUInt64(to, field,
+                              reflection->GetRepeatedUInt64(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        reflection->AddDouble(to, field,
+                              reflection->GetRepeatedDouble(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        reflection->AddFloat(to, field,
+                             reflection->GetRepeatedFloat(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_BOOL:
+        reflection->AddBool(to, field,
+                            reflection->GetRepeatedBool(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_ENUM:
+        reflection->AddEnumValue(
+            to, field, reflection->GetRepeatedEnumValue(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_STRING:
+        reflection->AddString(to, field,
+                              reflection->GetRepeatedString(from, field, i));
+        break;
+      case FieldDescriptor::CPPTYPE_MESSAGE:
+        reflection->AddMessage(to, field)
+            ->CopyFrom(reflection->GetRepeatedMessage(from, field, i));
+        break;
     }
   }
-  return nullptr;
+}
+
+// Copies a feature into an overlay. The children in its struct_domain are
+// left out, so that copying a feature near the root does not copy its whole
+// subtree: they are copied in separately if they are needed.
+void CopyFeatureWithoutChildren(const Feature& from, Feature* to) {
+  if (!from.has_struct_domain()) {
+    *to = from;
+    return;
+  }
+  std::vector<const tensorflow::protobuf::FieldDescriptor*> fields;
+  from.GetReflection()->ListFields(from, &fields);
+  for (const tensorflow::protobuf::FieldDescriptor* field : fields) {
+    if (field->number() != Feature::kStructDomainFieldNumber) {
+      CopyField(from, field, to);
+    }
+  }
+  to->mutable_struct_domain();
 }
 
 // absl::nullopt is the set of all paths.
@@ -151,13 +217,48 @@ bool ContainsPath(const absl::optional<std::set<Path>>& paths_to_consider,
   return ContainsKey(*paths_to_consider, path);
 }
 
+// Adds the environments listed in the in_environment of features, or of
+// their descendants, to environments.
+void AddInEnvironments(
+    const tensorflow::protobuf::RepeatedPtrField<Feature>& features,
+    std::set<string>* environments) {
+  for (const Feature& feature : features) {
+    environments->insert(feature.in_environment().begin(),
+                         feature.in_environment().end());
+    AddInEnvironments(feature.struct_domain().feature(), environments);
+  }
+}
+
 }  // namespace
 
 Status Schema::Init(const tensorflow::metadata::v0::Schema& input) {
+  return Init(tensorflow::metadata::v0::Schema(input));
+}
+
+Status Schema::Init(tensorflow::metadata::v0::Schema&& input) {
   if (!IsEmpty()) {
     return InvalidArgument("Schema is not empty when Init() called.");
   }
-  schema_ = input;
+  schema_ = std::move(input);
+  IndexFeatures(Path(), schema_.mutable_feature(), schema_.sparse_feature());
+  for (StringDomain& string_domain : *schema_.mutable_string_domain()) {
+    string_domain_index_.emplace(string_domain.name(), &string_domain);
+  }
+  return Status::OK();
+}
+
+Status Schema::InitOverlay(std::shared_ptr<const Schema> base) {
+  if (!IsEmpty()) {
+    return InvalidArgument("Schema is not empty when InitOverlay() called.");
+  }
+  if (base == nullptr) {
+    return InvalidArgument("InitOverlay() called without a base.");
+  }
+  base_ = std::move(base);
+  // The environments are the only part of the schema outside of the features
+  // and string domains that is used when updating a feature.
+  *schema_.mutable_default_environment() =
+      base_->schema_.default_environment();
   return Status::OK();
 }
 
@@ -165,6 +266,14 @@ tensorflow::Status Schema::Update(
     const Updater& updater, const FeatureStatsView& feature_stats_view,
     std::vector<Description>* descriptions,
     tensorflow::metadata::v0::AnomalyInfo::Severity* severity) {
+  return Update(updater, feature_stats_view, /*new_columns=*/nullptr,
+                descriptions, severity);
+}
+
+tensorflow::Status Schema::Update(
+    const Updater& updater, const FeatureStatsView& feature_stats_view,
+    NewColumns* new_columns, std::vector<Description>* descriptions,
+    tensorflow::metadata::v0::AnomalyInfo::Severity* severity) {
   *severity = tensorflow::metadata::v0::AnomalyInfo::UNKNOWN;
 
   Feature* feature = GetExistingFeature(feature_stats_view.GetPath());
@@ -181,15 +290,22 @@ tensorflow::Status Schema::Update(
         tensorflow::metadata::v0::AnomalyInfo::SCHEMA_NEW_COLUMN, "New column",
         "New column (column in data but not in schema)"};
     *descriptions = {description};
-    return updater.CreateColumn(feature_stats_view, this, severity);
+    Updater::Column* column = nullptr;
+    if (new_columns != nullptr) {
+      const auto iter = new_columns->find(feature_stats_view.GetPath());
+      if (iter != new_columns->end()) {
+        column = &iter->second;
+      }
+    }
+    return updater.CreateColumn(feature_stats_view, column, this, severity);
   }
   return Status::OK();
 }
 
-bool Schema::FeatureIsDeprecated(const Path& path) {
-  Feature* feature = GetExistingFeature(path);
+bool Schema::FeatureIsDeprecated(const Path& path) const {
+  const Feature* feature = FindFeature(path);
   if (feature == nullptr) {
-    SparseFeature* sparse_feature = GetExistingSparseFeature(path);
+    const SparseFeature* sparse_feature = FindSparseFeature(path);
     if (sparse_feature != nullptr) {
       return ::tensorflow::data_validation::SparseFeatureIsDeprecated(
           *sparse_feature);
@@ -210,18 +326,28 @@ Status Schema::UpdateRecursively(
     const absl::optional<std::set<Path>>& paths_to_consider,
     std::vector<Description>* descriptions,
     tensorflow::metadata::v0::AnomalyInfo::Severity* severity) {
+  return UpdateRecursively(updater, feature_stats_view, paths_to_consider,
+                           /*new_columns=*/nullptr, descriptions, severity);
+}
+
+Status Schema::UpdateRecursively(
+    const Updater& updater, const FeatureStatsView& feature_stats_view,
+    const absl::optional<std::set<Path>>& paths_to_consider,
+    NewColumns* new_columns, std::vector<Description>* descriptions,
+    tensorflow::metadata::v0::AnomalyInfo::Severity* severity) {
   *severity = tensorflow::metadata::v0::AnomalyInfo::UNKNOWN;
   if (!ContainsPath(paths_to_consider, feature_stats_view.GetPath())) {
     return Status::OK();
   }
-  TF_RETURN_IF_ERROR(
-      Update(updater, feature_stats_view, descriptions, severity));
+  TF_RETURN_IF_ERROR(Update(updater, feature_stats_view, new_columns,
+                            descriptions, severity));
   if (!FeatureIsDeprecated(feature_stats_view.GetPath())) {
-    for (const FeatureStatsView& child : feature_stats_view.GetChildren()) {
+    for (const FeatureStatsView& child :
+         feature_stats_view.GetChildrenRange()) {
       std::vector<Description> child_descriptions;
       tensorflow::metadata::v0::AnomalyInfo::Severity child_severity;
       TF_RETURN_IF_ERROR(UpdateRecursively(updater, child, paths_to_consider,
-                                           &child_descriptions,
+                                           new_columns, &child_descriptions,
                                            &child_severity));
       descriptions->insert(descriptions->end(), child_descriptions.begin(),
                            child_descriptions.end());
@@ -242,19 +368,74 @@ Status Schema::Update(const DatasetStatsView& dataset_stats,
   std::vector<Description> dummy_descriptions;
   tensorflow::metadata::v0::AnomalyInfo::Severity dummy_severity;
 
-  for (const auto& feature_stats_view : dataset_stats.GetRootFeatures()) {
+  // The columns of the new features are computed in parallel, and then
+  // added to the schema in the same order as without threads, so that the
+  // result (e.g., the names of the new StringDomains) is the same.
+  NewColumns new_columns;
+  if (updater.num_threads() > 1) {
+    ComputeNewColumns(dataset_stats, updater, paths_to_consider, &new_columns);
+  }
+  for (const auto& feature_stats_view : dataset_stats.GetRootFeaturesRange()) {
     TF_RETURN_IF_ERROR(UpdateRecursively(updater, feature_stats_view,
-                                         paths_to_consider, &dummy_descriptions,
-                                         &dummy_severity));
+                                         paths_to_consider, &new_columns,
+                                         &dummy_descriptions, &dummy_severity));
   }
-  for (const Path& missing_path : GetMissingPaths(dataset_stats)) {
-    if (ContainsPath(paths_to_consider, missing_path)) {
-      DeprecateFeature(missing_path);
-    }
+  // With paths to consider, only they can be deprecated, so the rest of the
+  // schema is not walked.
+  const std::vector<Path> missing_paths =
+      paths_to_consider
+          ? GetMissingPathsAmong(dataset_stats, *paths_to_consider)
+          : GetMissingPaths(dataset_stats);
+  for (const Path& missing_path : missing_paths) {
+    DeprecateFeature(missing_path);
   }
   return Status::OK();
 }
 
+void Schema::ComputeNewColumns(
+    const DatasetStatsView& dataset_stats, const Updater& updater,
+    const absl::optional<std::set<Path>>& paths_to_consider,
+    NewColumns* new_columns) const {
+  // The same features as UpdateRecursively() visits, in the same order,
+  // except that the children of deprecated features are not skipped.
+  std::vector<FeatureStatsView> new_features;
+  std::function<void(const FeatureStatsView&)> collect =
+      [this, &paths_to_consider, &new_features,
+       &collect](const FeatureStatsView& view) {
+        if (!ContainsPath(paths_to_consider, view.GetPath())) {
+          return;
+        }
+        if (!FeatureExists(view.GetPath())) {
+          new_features.push_back(view);
+        }
+        for (const FeatureStatsView& child : view.GetChildrenRange()) {
+          collect(child);
+        }
+      };
+  for (const FeatureStatsView& view : dataset_stats.GetRootFeaturesRange()) {
+    collect(view);
+  }
+
+  std::vector<Updater::Column> columns(new_features.size());
+  // Not a std::vector<bool>, whose elements cannot be written concurrently.
+  std::unique_ptr<bool[]> computed(new bool[new_features.size()]);
+  {
+    thread::ThreadPool pool(Env::Default(), "compute_columns",
+                            updater.num_threads());
+    for (size_t i = 0; i < new_features.size(); ++i) {
+      pool.Schedule([&updater, &new_features, &columns, &computed, i]() {
+        computed[i] = updater.ComputeColumn(new_features[i], &columns[i]);
+      });
+    }
+    // The destructor of pool waits for all the tasks to finish.
+  }
+  for (size_t i = 0; i < new_features.size(); ++i) {
+    if (computed[i]) {
+      new_columns->emplace(new_features[i].GetPath(), std::move(columns[i]));
+    }
+  }
+}
+
 Status Schema::Update(const DatasetStatsView& dataset_stats,
                       const FeatureStatisticsToProtoConfig& config,
                       const std::vector<Path>& paths_to_consider) {
@@ -264,9 +445,14 @@ Status Schema::Update(const DatasetStatsView& dataset_stats,
 }
 
 Schema::Updater::Updater(const FeatureStatisticsToProtoConfig& config)
+    : Updater(config, /*profiler=*/nullptr) {}
+
+Schema::Updater::Updater(const FeatureStatisticsToProtoConfig& config,
+                         ValidationProfiler* profiler)
     : config_(config),
       columns_to_ignore_(config.column_to_ignore().begin(),
-                         config.column_to_ignore().end()) {
+                         config.column_to_ignore().end()),
+      profiler_(profiler) {
   for (const ColumnConstraint& constraint : config.column_constraint()) {
     for (const string& column_name : constraint.column_name()) {
       grouped_enums_[column_name] = constraint.enum_name();
@@ -277,6 +463,14 @@ Schema::Updater::Updater(const FeatureStatisticsToProtoConfig& config)
 Status Schema::Updater::CreateColumn(
     const FeatureStatsView& feature_stats_view, Schema* schema,
     tensorflow::metadata::v0::AnomalyInfo::Severity* severity) const {
+  return CreateColumn(feature_stats_view, /*column=*/nullptr, schema,
+                      severity);
+}
+
+Status Schema::Updater::CreateColumn(
+    const FeatureStatsView& feature_stats_view, Column* column,
+    Schema* schema,
+    tensorflow::metadata::v0::AnomalyInfo::Severity* severity) const {
   if (schema->GetExistingFeature(feature_stats_view.GetPath()) != nullptr) {
     return InvalidArgument("Schema already contains \"",
                            feature_stats_view.name(), "\".");
@@ -286,16 +480,19 @@ Status Schema::Updater::CreateColumn(
                   ? tensorflow::metadata::v0::AnomalyInfo::WARNING
                   : tensorflow::metadata::v0::AnomalyInfo::ERROR;
 
+  Column computed_column;
+  if (column == nullptr &&
+      ComputeColumn(feature_stats_view, &computed_column)) {
+    column = &computed_column;
+  }
+
   Feature* feature = schema->GetNewFeature(feature_stats_view.GetPath());
 
-  feature->set_type(feature_stats_view.GetFeatureType());
-  InitValueCountAndPresence(feature_stats_view, feature);
-  if (ContainsKey(columns_to_ignore_,
-                  feature_stats_view.GetPath().Serialize())) {
-    ::tensorflow::data_validation::DeprecateFeature(feature);
-    return Status::OK();
-  }
-  if (ContainsKey(grouped_enums_, feature_stats_view.name())) {
+  if (column == nullptr) {
+    // The feature shares a StringDomain with the other features of its
+    // ColumnConstraint.
+    feature->set_type(feature_stats_view.GetFeatureType());
+    InitValueCountAndPresence(feature_stats_view, feature);
     const string& enum_name = grouped_enums_.at(feature_stats_view.name());
     StringDomain* result = schema->GetExistingStringDomain(enum_name);
     if (result == nullptr) {
@@ -303,28 +500,52 @@ Status Schema::Updater::CreateColumn(
     }
     UpdateStringDomain(*this, feature_stats_view, 0, result);
     return Status::OK();
+  }
+  column->feature.set_name(feature->name());
+  feature->Swap(&column->feature);
+  if (column->string_domain) {
+    StringDomain* string_domain =
+        schema->GetNewStringDomain(feature_stats_view.name());
+    column->string_domain->set_name(string_domain->name());
+    string_domain->Swap(&*column->string_domain);
+    *feature->mutable_domain() = string_domain->name();
+  }
+  return Status::OK();
+}
+
+bool Schema::Updater::ComputeColumn(const FeatureStatsView& feature_stats_view,
+                                    Column* column) const {
+  Feature* feature = &column->feature;
+  feature->set_type(feature_stats_view.GetFeatureType());
+  InitValueCountAndPresence(feature_stats_view, feature);
+  if (ContainsKey(columns_to_ignore_,
+                  feature_stats_view.GetPath().Serialize())) {
+    ::tensorflow::data_validation::DeprecateFeature(feature);
+    return true;
+  }
+  if (ContainsKey(grouped_enums_, feature_stats_view.name())) {
+    return false;
   } else if (feature_stats_view.HasInvalidUTF8Strings() ||
              feature_stats_view.type() == FeatureNameStatistics::BYTES) {
     // If there are invalid UTF8 strings, or the field should not be further
     // interpreted, add no domain info.
-    return Status::OK();
+    return true;
   } else if (IsBoolDomainCandidate(feature_stats_view)) {
     *feature->mutable_bool_domain() = BoolDomainFromStats(feature_stats_view);
-    return Status::OK();
+    return true;
   } else if (IsIntDomainCandidate(feature_stats_view)) {
     // By default don't set any values.
     feature->mutable_int_domain();
-    return Status::OK();
+    return true;
   } else if (IsStringDomainCandidate(feature_stats_view,
                                      config_.enum_threshold())) {
-    StringDomain* string_domain =
-        schema->GetNewStringDomain(feature_stats_view.name());
-    UpdateStringDomain(*this, feature_stats_view, 0, string_domain);
-    *feature->mutable_domain() = string_domain->name();
-    return Status::OK();
+    column->string_domain.emplace();
+    UpdateStringDomain(*this, feature_stats_view, 0,
+                       &*column->string_domain);
+    return true;
   } else {
     // No domain info for this field.
-    return Status::OK();
+    return true;
   }
 }
 
@@ -335,33 +556,146 @@ bool Schema::Updater::string_domain_too_big(int size) const {
          config_.enum_delete_threshold() <= size;
 }
 
+const DistributionDistanceThresholds& Schema::Updater::distance_thresholds(
+    ComparatorType comparator_type) const {
+  switch (comparator_type) {
+    case ComparatorType::SKEW:
+      return config_.skew_thresholds();
+    case ComparatorType::DRIFT:
+      return config_.drift_thresholds();
+  }
+}
+
 bool Schema::IsEmpty() const {
-  return schema_.feature().empty() && schema_.string_domain().empty();
+  return schema_.feature().empty() && schema_.string_domain().empty() &&
+         base_ == nullptr;
 }
 
-void Schema::Clear() { schema_.Clear(); }
+void Schema::Clear() {
+  schema_.Clear();
+  feature_index_.clear();
+  sparse_feature_index_.clear();
+  string_domain_index_.clear();
+  base_.reset();
+  removed_string_domains_.clear();
+  ClearPrecomputed();
+}
 
-StringDomain* Schema::GetNewStringDomain(const string& candidate_name) {
-  std::set<string> names;
+void Schema::ClearPrecomputed() {
+  if (!required_features_precomputed_) {
+    return;
+  }
+  required_features_.clear();
+  required_features_precomputed_ = false;
+  string_domain_values_.clear();
+  string_domain_filters_.clear();
+  string_domain_tables_.clear();
+}
+
+void Schema::Precompute() {
+  Precompute(ApproximateStringDomainConfig());
+}
+
+void Schema::Precompute(
+    const ApproximateStringDomainConfig& approximate_string_domains) {
+  std::map<absl::optional<string>, std::vector<Path>> required_features;
+  required_features[absl::nullopt] =
+      GetAllRequiredFeatures(Path(), schema_.feature(), absl::nullopt);
+  for (const string& environment : schema_.default_environment()) {
+    required_features[environment] =
+        GetAllRequiredFeatures(Path(), schema_.feature(), environment);
+  }
+  Precompute(std::move(required_features), approximate_string_domains);
+}
+
+void Schema::Precompute(
+    std::map<absl::optional<string>, std::vector<Path>> required_features,
+    const ApproximateStringDomainConfig& approximate_string_domains) {
+  Precompute(std::move(required_features),
+             absl::flat_hash_map<string, StringTable>(),
+             approximate_string_domains);
+}
+
+void Schema::Precompute(
+    std::map<absl::optional<string>, std::vector<Path>> required_features,
+    absl::flat_hash_map<string, StringTable> string_domain_tables,
+    const ApproximateStringDomainConfig& approximate_string_domains) {
+  DCHECK(base_ == nullptr) << "Precompute() called on an overlay.";
+  required_features_ = std::move(required_features);
+  // A feature is only in an environment that is not a default environment
+  // if it lists it in in_environment. So the required features of every
+  // such environment are precomputed, and there are none in the others.
+  std::set<string> environments;
+  AddInEnvironments(schema_.feature(), &environments);
+  for (const string& environment : environments) {
+    if (!ContainsKey(required_features_, environment)) {
+      required_features_[environment] =
+          GetAllRequiredFeatures(Path(), schema_.feature(), environment);
+    }
+  }
+  required_features_precomputed_ = true;
+  string_domain_values_.clear();
+  string_domain_filters_.clear();
+  string_domain_tables_ = std::move(string_domain_tables);
+  const int64 min_num_values = approximate_string_domains.min_num_values();
+  double false_positive_rate = approximate_string_domains.false_positive_rate();
+  if (!(false_positive_rate > 0 && false_positive_rate < 1)) {
+    false_positive_rate = 0.01;
+  }
   for (const StringDomain& string_domain : schema_.string_domain()) {
-    names.insert(string_domain.name());
+    // As in FindStringDomain(), the first StringDomain with a name wins.
+    if (ContainsKey(string_domain_values_, string_domain.name()) ||
+        ContainsKey(string_domain_filters_, string_domain.name()) ||
+        ContainsKey(string_domain_tables_, string_domain.name())) {
+      continue;
+    }
+    if (min_num_values > 0 && string_domain.value_size() >= min_num_values) {
+      string_domain_filters_.emplace(
+          string_domain.name(),
+          make_unique<StringDomainFilter>(string_domain.value(),
+                                          false_positive_rate));
+    } else {
+      string_domain_values_.emplace(string_domain.name(),
+                                    GetStringDomainValues(string_domain));
+    }
+  }
+}
+
+bool Schema::StringDomainExists(const string& name) const {
+  if (ContainsKey(string_domain_index_, name)) {
+    return true;
   }
+  return base_ != nullptr && !ContainsKey(removed_string_domains_, name) &&
+         base_->StringDomainExists(name);
+}
+
+StringDomain* Schema::GetNewStringDomain(const string& candidate_name) {
+  ClearPrecomputed();
   string new_name = candidate_name;
   int index = 1;
-  while (ContainsKey(names, new_name)) {
+  while (StringDomainExists(new_name)) {
     ++index;
     new_name = absl::StrCat(candidate_name, index);
   }
   StringDomain* result = schema_.add_string_domain();
   *result->mutable_name() = new_name;
+  string_domain_index_.emplace(new_name, result);
   return result;
 }
 
 StringDomain* Schema::GetExistingStringDomain(const string& name) {
-  for (int i = 0; i < schema_.string_domain_size(); ++i) {
-    StringDomain* possible = schema_.mutable_string_domain(i);
-    if (possible->name() == name) {
-      return possible;
+  ClearPrecomputed();
+  const auto iter = string_domain_index_.find(name);
+  if (iter != string_domain_index_.end()) {
+    return iter->second;
+  }
+  if (base_ != nullptr && !ContainsKey(removed_string_domains_, name)) {
+    const StringDomain* base_string_domain = base_->FindStringDomain(name);
+    if (base_string_domain != nullptr) {
+      StringDomain* result = schema_.add_string_domain();
+      *result = *base_string_domain;
+      string_domain_index_.emplace(name, result);
+      return result;
     }
   }
 
@@ -369,27 +703,105 @@ StringDomain* Schema::GetExistingStringDomain(const string& name) {
   return nullptr;
 }
 
+const StringDomain* Schema::FindStringDomain(const string& name) const {
+  const auto iter = string_domain_index_.find(name);
+  if (iter != string_domain_index_.end()) {
+    return iter->second;
+  }
+  if (base_ != nullptr && !ContainsKey(removed_string_domains_, name)) {
+    return base_->FindStringDomain(name);
+  }
+  return nullptr;
+}
+
+const StringDomainValues* Schema::FindStringDomainValues(
+    const string& name) const {
+  if (ContainsKey(string_domain_index_, name)) {
+    // The StringDomain of an overlay may have been modified since it was
+    // copied in.
+    if (base_ != nullptr) {
+      return nullptr;
+    }
+    const auto iter = string_domain_values_.find(name);
+    return iter == string_domain_values_.end() ? nullptr : &iter->second;
+  }
+  if (base_ != nullptr && !ContainsKey(removed_string_domains_, name)) {
+    return base_->FindStringDomainValues(name);
+  }
+  return nullptr;
+}
+
+const StringDomainFilter* Schema::FindStringDomainFilter(
+    const string& name) const {
+  if (ContainsKey(string_domain_index_, name)) {
+    // As in FindStringDomainValues().
+    if (base_ != nullptr) {
+      return nullptr;
+    }
+    const auto iter = string_domain_filters_.find(name);
+    return iter == string_domain_filters_.end() ? nullptr : iter->second.get();
+  }
+  if (base_ != nullptr && !ContainsKey(removed_string_domains_, name)) {
+    return base_->FindStringDomainFilter(name);
+  }
+  return nullptr;
+}
+
+const StringTable* Schema::FindStringDomainTable(const string& name) const {
+  if (ContainsKey(string_domain_index_, name)) {
+    // As in FindStringDomainValues().
+    if (base_ != nullptr) {
+      return nullptr;
+    }
+    const auto iter = string_domain_tables_.find(name);
+    return iter == string_domain_tables_.end() ? nullptr : &iter->second;
+  }
+  if (base_ != nullptr && !ContainsKey(removed_string_domains_, name)) {
+    return base_->FindStringDomainTable(name);
+  }
+  return nullptr;
+}
+
 std::vector<std::set<string>> Schema::SimilarEnumTypes(
     const EnumsSimilarConfig& config) const {
-  std::vector<bool> used(schema_.string_domain_size(), false);
-  std::vector<std::set<string>> result;
-  for (int index_a = 0; index_a < schema_.string_domain_size(); ++index_a) {
-    if (!used[index_a]) {
-      const StringDomain& string_domain_a = schema_.string_domain(index_a);
-      std::set<string> similar;
-      for (int index_b = index_a + 1; index_b < schema_.string_domain_size();
+  const int num_string_domains = schema_.string_domain_size();
+  std::vector<StringDomainValues> values;
+  values.reserve(num_string_domains);
+  for (const StringDomain& string_domain : schema_.string_domain()) {
+    values.push_back(GetStringDomainValues(string_domain));
+  }
+
+  // For each string domain, the later string domains that are similar to it.
+  std::vector<std::vector<int>> similar_indices(num_string_domains);
+  const auto check_pair = [&](int index_a, int index_b) {
+    if (IsSimilarStringDomain(values[index_a], values[index_b], config)) {
+      similar_indices[index_a].push_back(index_b);
+    }
+  };
+  if (num_string_domains >= config.lsh_min_num_enums()) {
+    // Only pairs that are likely to be similar are checked.
+    for (const std::pair<int, int>& candidate :
+         GetSimilarStringDomainCandidates(values, config)) {
+      check_pair(candidate.first, candidate.second);
+    }
+  } else {
+    for (int index_a = 0; index_a < num_string_domains; ++index_a) {
+      for (int index_b = index_a + 1; index_b < num_string_domains;
            ++index_b) {
-        if (!used[index_b]) {
-          const StringDomain& string_domain_b = schema_.string_domain(index_b);
-          if (IsSimilarStringDomain(string_domain_a, string_domain_b, config)) {
-            similar.insert(string_domain_b.name());
-          }
-        }
+        check_pair(index_a, index_b);
       }
-      if (!similar.empty()) {
-        similar.insert(string_domain_a.name());
-        result.push_back(similar);
+    }
+  }
+
+  std::vector<std::set<string>> result;
+  for (int index_a = 0; index_a < num_string_domains; ++index_a) {
+    if (!similar_indices[index_a].empty()) {
+      std::set<string> similar;
+      similar.insert(schema_.string_domain(index_a).name());
+      for (int index_b : similar_indices[index_a]) {
+        similar.insert(schema_.string_domain(index_b).name());
       }
+      result.push_back(similar);
     }
   }
   return result;
@@ -419,17 +831,76 @@ std::vector<Path> Schema::GetAllRequiredFeatures(
   return result;
 }
 
-std::vector<Path> Schema::GetMissingPaths(
-    const DatasetStatsView& dataset_stats) {
-  std::set<Path> paths_present;
-  for (const FeatureStatsView& feature_stats_view : dataset_stats.features()) {
-    paths_present.insert(feature_stats_view.GetPath());
+const std::vector<Path>* Schema::FindRequiredFeatures(
+    const absl::optional<string>& environment) const {
+  if (!required_features_precomputed_) {
+    return nullptr;
+  }
+  const auto iter = required_features_.find(environment);
+  if (iter != required_features_.end()) {
+    return &iter->second;
+  }
+  // No feature is in an environment that Precompute() did not see.
+  static const std::vector<Path>* const kNoFeatures = new std::vector<Path>();
+  return kNoFeatures;
+}
+
+std::vector<Path> Schema::GetRequiredFeatures(
+    const absl::optional<string>& environment) const {
+  const std::vector<Path>* required = FindRequiredFeatures(environment);
+  if (required != nullptr) {
+    return *required;
   }
+  return GetAllRequiredFeatures(Path(), schema_.feature(), environment);
+}
+
+std::vector<Path> Schema::GetMissingPaths(
+    const DatasetStatsView& dataset_stats) const {
   std::vector<Path> paths_absent;
 
-  for (const Path& path : GetAllRequiredFeatures(Path(), schema_.feature(),
-                                                 dataset_stats.environment())) {
-    if (!ContainsKey(paths_present, path)) {
+  const std::vector<Path>* precomputed =
+      FindRequiredFeatures(dataset_stats.environment());
+  std::vector<Path> computed;
+  if (precomputed == nullptr) {
+    computed = GetAllRequiredFeatures(Path(), schema_.feature(),
+                                      dataset_stats.environment());
+  }
+  const std::vector<Path>& required =
+      precomputed == nullptr ? computed : *precomputed;
+  for (const Path& path : required) {
+    // This uses the hashed index of the paths, built once per view.
+    if (!dataset_stats.GetByPath(path)) {
+      paths_absent.push_back(path);
+    }
+  }
+  return paths_absent;
+}
+
+std::vector<Path> Schema::GetMissingPathsAmong(
+    const DatasetStatsView& dataset_stats,
+    const std::set<Path>& paths) const {
+  std::vector<Path> paths_absent;
+  for (const Path& path : paths) {
+    const Feature* feature = FindFeature(path);
+    if (feature == nullptr ||
+        !IsExistenceRequired(*feature, dataset_stats.environment()) ||
+        dataset_stats.GetByPath(path)) {
+      continue;
+    }
+    // As in GetAllRequiredFeatures(), the children of a deprecated feature
+    // are not required.
+    bool ancestor_deprecated = false;
+    for (Path ancestor = path.GetParent(); !ancestor.empty();
+         ancestor = ancestor.GetParent()) {
+      const Feature* ancestor_feature = FindFeature(ancestor);
+      if (ancestor_feature != nullptr &&
+          ::tensorflow::data_validation::FeatureIsDeprecated(
+              *ancestor_feature)) {
+        ancestor_deprecated = true;
+        break;
+      }
+    }
+    if (!ancestor_deprecated) {
       paths_absent.push_back(path);
     }
   }
@@ -482,60 +953,203 @@ Status Schema::GetRelatedEnums(const DatasetStatsView& dataset_stats,
 
 tensorflow::metadata::v0::Schema Schema::GetSchema() const { return schema_; }
 
-bool Schema::FeatureExists(const Path& path) {
-  return GetExistingFeature(path) != nullptr ||
-         GetExistingSparseFeature(path) != nullptr;
+void Schema::ReleaseSchema(tensorflow::metadata::v0::Schema* result) {
+  *result = std::move(schema_);
+  Clear();
 }
 
-Feature* Schema::GetExistingFeature(const Path& path) {
-  if (path.size() == 1) {
-    return GetExistingFeatureHelper(path.last_step(),
-                                    schema_.mutable_feature());
-  } else {
-    Path parent = path.GetParent();
-    Feature* parent_feature = GetExistingFeature(parent);
-    if (parent_feature == nullptr) {
-      return nullptr;
+void Schema::GetChanges(tensorflow::metadata::v0::Schema* before,
+                        tensorflow::metadata::v0::Schema* after) const {
+  before->Clear();
+  *after = schema_;
+  if (base_ == nullptr) {
+    return;
+  }
+  // The environments were copied from the base, and are not a change.
+  after->clear_default_environment();
+  GetBaseFeatures(Path(), schema_.feature(), before->mutable_feature());
+  std::set<string> string_domain_names = removed_string_domains_;
+  for (const StringDomain& string_domain : schema_.string_domain()) {
+    string_domain_names.insert(string_domain.name());
+  }
+  for (const string& name : string_domain_names) {
+    const StringDomain* base_string_domain = base_->FindStringDomain(name);
+    if (base_string_domain != nullptr) {
+      *before->add_string_domain() = *base_string_domain;
     }
-    if (!parent_feature->has_struct_domain()) {
-      return nullptr;
+  }
+}
+
+void Schema::GetBaseFeatures(
+    const Path& prefix,
+    const tensorflow::protobuf::RepeatedPtrField<Feature>& features,
+    tensorflow::protobuf::RepeatedPtrField<Feature>* result) const {
+  for (const Feature& feature : features) {
+    const Path path = prefix.GetChild(feature.name());
+    const Feature* base_feature = base_->FindFeature(path);
+    if (base_feature == nullptr) {
+      // The feature is new, and so are all of its descendants.
+      continue;
+    }
+    Feature* copy = result->Add();
+    CopyFeatureWithoutChildren(*base_feature, copy);
+    if (copy->has_struct_domain()) {
+      GetBaseFeatures(path, feature.struct_domain().feature(),
+                      copy->mutable_struct_domain()->mutable_feature());
     }
-    return GetExistingFeatureHelper(
-        path.last_step(),
-        parent_feature->mutable_struct_domain()->mutable_feature());
   }
-  return nullptr;
 }
 
-SparseFeature* Schema::GetExistingSparseFeature(const Path& path) {
-  CHECK(!path.empty());
+bool Schema::FeatureExists(const Path& path) const {
+  return FindFeature(path) != nullptr || FindSparseFeature(path) != nullptr;
+}
+
+string Schema::GetDomainType(const Path& path) const {
+  const Feature* feature = FindFeature(path);
+  if (feature == nullptr) {
+    return "";
+  }
+  const protobuf::FieldDescriptor* domain_field =
+      feature->GetReflection()->GetOneofFieldDescriptor(
+          *feature, Feature::descriptor()->FindOneofByName("domain_info"));
+  return domain_field == nullptr ? "" : domain_field->name();
+}
+
+Feature* Schema::GetExistingFeature(const Path& path) {
+  ClearPrecomputed();
+  auto iter = feature_index_.find(path);
+  if (iter != feature_index_.end()) {
+    return iter->second;
+  }
+  if (base_ == nullptr) {
+    return nullptr;
+  }
+  const Feature* base_feature = base_->FindFeature(path);
+  if (base_feature == nullptr) {
+    return nullptr;
+  }
+  // Copy the feature from the base, after copying its parent (if any).
+  tensorflow::protobuf::RepeatedPtrField<Feature>* features;
   if (path.size() == 1) {
-    return GetExistingSparseFeatureHelper(path.last_step(),
-                                          schema_.mutable_sparse_feature());
+    features = schema_.mutable_feature();
   } else {
     Feature* parent_feature = GetExistingFeature(path.GetParent());
-    if (parent_feature == nullptr) {
+    if (parent_feature == nullptr || !parent_feature->has_struct_domain()) {
       return nullptr;
     }
-    if (!parent_feature->has_struct_domain()) {
-      return nullptr;
+    features = parent_feature->mutable_struct_domain()->mutable_feature();
+  }
+  Feature* result = features->Add();
+  CopyFeatureWithoutChildren(*base_feature, result);
+  if (result->has_domain() &&
+      ContainsKey(removed_string_domains_, result->domain())) {
+    ::tensorflow::data_validation::ClearDomain(result);
+  }
+  feature_index_.emplace(path, result);
+  return result;
+}
+
+const Feature* Schema::FindOwnFeature(const Path& path) const {
+  auto iter = feature_index_.find(path);
+  return iter == feature_index_.end() ? nullptr : iter->second;
+}
+
+const Feature* Schema::FindFeature(const Path& path) const {
+  const Feature* result = FindOwnFeature(path);
+  if (result == nullptr && base_ != nullptr) {
+    return base_->FindFeature(path);
+  }
+  return result;
+}
+
+const SparseFeature* Schema::FindSparseFeature(const Path& path) const {
+  CHECK(!path.empty());
+  auto iter = sparse_feature_index_.find(path);
+  if (iter != sparse_feature_index_.end()) {
+    return iter->second;
+  }
+  // Overlays never copy sparse features, as nothing modifies them.
+  if (base_ != nullptr) {
+    return base_->FindSparseFeature(path);
+  }
+  return nullptr;
+}
+
+void Schema::IndexFeatures(
+    const Path& prefix,
+    tensorflow::protobuf::RepeatedPtrField<Feature>* features,
+    const tensorflow::protobuf::RepeatedPtrField<SparseFeature>&
+        sparse_features) {
+  for (Feature& feature : *features) {
+    const Path path = prefix.GetChild(feature.name());
+    if (feature_index_.emplace(path, &feature).second &&
+        feature.has_struct_domain()) {
+      IndexFeatures(path, feature.mutable_struct_domain()->mutable_feature(),
+                    feature.struct_domain().sparse_feature());
     }
-    return GetExistingSparseFeatureHelper(
-        path.last_step(),
-        parent_feature->mutable_struct_domain()->mutable_sparse_feature());
+  }
+  for (const SparseFeature& sparse_feature : sparse_features) {
+    sparse_feature_index_.emplace(prefix.GetChild(sparse_feature.name()),
+                                  &sparse_feature);
   }
 }
+
+void Schema::RemoveDescendantsFromIndex(const Feature& feature) {
+  std::set<const void*> descendants;
+  std::vector<const Feature*> to_visit = {&feature};
+  while (!to_visit.empty()) {
+    const Feature* current = to_visit.back();
+    to_visit.pop_back();
+    for (const Feature& child : current->struct_domain().feature()) {
+      descendants.insert(&child);
+      to_visit.push_back(&child);
+    }
+    for (const SparseFeature& child :
+         current->struct_domain().sparse_feature()) {
+      descendants.insert(&child);
+    }
+  }
+  if (descendants.empty()) {
+    return;
+  }
+  for (auto iter = feature_index_.begin(); iter != feature_index_.end();) {
+    if (ContainsKey(descendants, iter->second)) {
+      feature_index_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+  for (auto iter = sparse_feature_index_.begin();
+       iter != sparse_feature_index_.end();) {
+    if (ContainsKey(descendants, iter->second)) {
+      sparse_feature_index_.erase(iter++);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void Schema::ClearFeatureDomain(Feature* feature) {
+  if (feature->has_struct_domain()) {
+    RemoveDescendantsFromIndex(*feature);
+  }
+  ::tensorflow::data_validation::ClearDomain(feature);
+}
+
 Feature* Schema::GetNewFeature(const Path& path) {
   CHECK(!path.empty());
+  ClearPrecomputed();
   if (path.size() > 1) {
     Path parent = path.GetParent();
     Feature* parent_feature = CHECK_NOTNULL(GetExistingFeature(parent));
     Feature* result = parent_feature->mutable_struct_domain()->add_feature();
     *result->mutable_name() = path.last_step();
+    feature_index_.emplace(path, result);
     return result;
   } else {
     Feature* result = schema_.add_feature();
     *result->mutable_name() = path.last_step();
+    feature_index_.emplace(path, result);
     return result;
   }
 }
@@ -628,17 +1242,17 @@ std::vector<Description> Schema::UpdateFeatureSelf(Feature* feature) {
                             "max should not be less than min"});
     feature->mutable_value_count()->set_max(feature->value_count().min());
   }
-  if (!ContainsKey(AllowedFeatureTypes(feature->domain_info_case()),
-                   feature->type())) {
+  if (!::tensorflow::data_validation::IsFeatureTypeAllowed(
+          feature->domain_info_case(), feature->type())) {
     // Note that this clears the oneof field domain_info.
-    ::tensorflow::data_validation::ClearDomain(feature);
+    ClearFeatureDomain(feature);
     descriptions.push_back({tensorflow::metadata::v0::AnomalyInfo::UNKNOWN_TYPE,
                             "The domain does not match the type"});
   }
 
   switch (feature->domain_info_case()) {
     case Feature::kDomain:
-      if (GetExistingStringDomain(feature->domain()) == nullptr) {
+      if (!StringDomainExists(feature->domain())) {
         // Note that this clears the oneof field domain_info.
         feature->clear_domain();
         descriptions.push_back(
@@ -695,7 +1309,7 @@ std::vector<Description> Schema::UpdateFeatureSelf(Feature* feature) {
           {tensorflow::metadata::v0::AnomalyInfo::UNKNOWN_TYPE,
            "internal issue: unknown domain_info type"});
       // Note that this clears the oneof field domain_info.
-      ::tensorflow::data_validation::ClearDomain(feature);
+      ClearFeatureDomain(feature);
   }
 
   return descriptions;
@@ -713,12 +1327,33 @@ std::vector<Description> Schema::UpdateSkewComparator(
   return {};
 }
 
+const tensorflow::metadata::v0::FeatureComparator* Schema::FindComparator(
+    const Path& path, ComparatorType comparator_type) const {
+  const Feature* feature = FindFeature(path);
+  if (feature == nullptr || !FeatureHasComparator(*feature, comparator_type)) {
+    return nullptr;
+  }
+  switch (comparator_type) {
+    case ComparatorType::DRIFT:
+      return &feature->drift_comparator();
+    case ComparatorType::SKEW:
+      return &feature->skew_comparator();
+  }
+}
+
 void Schema::ClearStringDomain(const string& domain_name) {
+  ClearPrecomputed();
   ClearStringDomainHelper(domain_name, schema_.mutable_feature());
   RemoveIf(schema_.mutable_string_domain(),
            [domain_name](const StringDomain* string_domain) {
              return (string_domain->name() == domain_name);
            });
+  string_domain_index_.erase(domain_name);
+  if (base_ != nullptr) {
+    // Features referring to the domain that are copied in later are cleared
+    // in GetExistingFeature().
+    removed_string_domains_.insert(domain_name);
+  }
 }
 
 std::vector<Description> Schema::UpdateFeatureInternal(
@@ -833,7 +1468,7 @@ std::vector<Description> Schema::UpdateFeatureInternal(
       feature->domain_info_case() !=
           tensorflow::metadata::v0::Feature::DOMAIN_INFO_NOT_SET) {
     // Note that this clears the oneof field domain_info.
-    ::tensorflow::data_validation::ClearDomain(feature);
+    ClearFeatureDomain(feature);
     descriptions.push_back({tensorflow::metadata::v0::AnomalyInfo::UNKNOWN_TYPE,
                             "Data is marked as BYTES that indicates the data "
                             " should not be analyzed: this is incompatible "
@@ -841,12 +1476,20 @@ std::vector<Description> Schema::UpdateFeatureInternal(
   }
   switch (feature->domain_info_case()) {
     case Feature::kDomain: {
+      // The StringDomain is only copied into an overlay if it is updated.
       UpdateSummary update_summary =
           ::tensorflow::data_validation::UpdateStringDomain(
               updater, view,
               ::tensorflow::data_validation::GetMaxOffDomain(
                   feature->distribution_constraints()),
-              CHECK_NOTNULL(GetExistingStringDomain(feature->domain())));
+              FindStringDomainValues(feature->domain()),
+              FindStringDomainFilter(feature->domain()),
+              FindStringDomainTable(feature->domain()),
+              *CHECK_NOTNULL(FindStringDomain(feature->domain())),
+              [this, feature]() {
+                return CHECK_NOTNULL(
+                    GetExistingStringDomain(feature->domain()));
+              });
 
       descriptions.insert(descriptions.end(),
                           update_summary.descriptions.begin(),
@@ -897,8 +1540,9 @@ std::vector<Description> Schema::UpdateFeatureInternal(
   // Handle comparators here.
   for (const auto& comparator_type : all_comparator_types) {
     if (FeatureHasComparator(*feature, comparator_type)) {
+      ScopedPhaseTimer timer(updater.profiler(), ValidationPhase::kComparators);
       add_to_descriptions(UpdateFeatureComparatorDirect(
-          view, comparator_type,
+          view, comparator_type, updater.distance_thresholds(comparator_type),
           GetFeatureComparator(feature, comparator_type)));
     }
   }
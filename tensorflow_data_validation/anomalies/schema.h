@@ -22,11 +22,16 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/types/optional.h"
 #include "tensorflow_data_validation/anomalies/internal_types.h"
 #include "tensorflow_data_validation/anomalies/path.h"
 #include "tensorflow_data_validation/anomalies/proto/feature_statistics_to_proto.pb.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
+#include "tensorflow_data_validation/anomalies/string_domain_filter.h"
+#include "tensorflow_data_validation/anomalies/string_table.h"
+#include "tensorflow_data_validation/anomalies/validation_profiler.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
@@ -59,8 +64,23 @@ class Schema {
   // FeatureStatisticsToProtoConfig. Used in SchemaAnomaly and SchemaAnomalies.
   class Updater {
    public:
+    // The column of a new feature, computed from its statistics alone by
+    // ComputeColumn(). As this does not read the schema, the columns of
+    // different features can be computed concurrently, and then added to the
+    // schema in order by CreateColumn().
+    struct Column {
+      tensorflow::metadata::v0::Feature feature;
+      // A new StringDomain that the feature refers to. Its name is chosen
+      // (see GetNewStringDomain()) when the column is added to the schema.
+      absl::optional<tensorflow::metadata::v0::StringDomain> string_domain;
+    };
+
     // Creates a factory for new FeatureTypes, based on a config.
     explicit Updater(const FeatureStatisticsToProtoConfig& config);
+    // Same as above, but times the comparators in profiler, if it is not
+    // null. profiler must outlive the factory.
+    Updater(const FeatureStatisticsToProtoConfig& config,
+            ValidationProfiler* profiler);
     // Creates a column from the statistics object, based upon the
     // configuration in the factory.
     // Updates the severity of the change.
@@ -68,10 +88,37 @@ class Schema {
         const FeatureStatsView& feature_stats_view, Schema* schema,
         tensorflow::metadata::v0::AnomalyInfo::Severity* severity) const;
 
+    // Same as above, but if column is not null, it holds the result of
+    // ComputeColumn() for feature_stats_view, which is moved into the schema
+    // instead of being computed again.
+    tensorflow::Status CreateColumn(
+        const FeatureStatsView& feature_stats_view, Column* column,
+        Schema* schema,
+        tensorflow::metadata::v0::AnomalyInfo::Severity* severity) const;
+
+    // Computes the column that CreateColumn() creates for
+    // feature_stats_view, and returns true, unless the column depends on the
+    // schema (i.e., a ColumnConstraint puts the feature in a shared
+    // StringDomain). Can be called concurrently.
+    bool ComputeColumn(const FeatureStatsView& feature_stats_view,
+                       Column* column) const;
+
+    // The number of threads on which Schema::Update() computes the columns
+    // of new features.
+    int num_threads() const { return config_.num_threads(); }
+
     // Returns true if there is a limit on the size of a string domain and it
     // should be deleted.
     bool string_domain_too_big(int size) const;
 
+    // Returns the thresholds on the distances checked by comparators of type
+    // comparator_type, in addition to their infinity_norm.
+    const DistributionDistanceThresholds& distance_thresholds(
+        ComparatorType comparator_type) const;
+
+    // The profiler to record time in, or null.
+    ValidationProfiler* profiler() const { return profiler_; }
+
    private:
     // The config being used to create the schema.
     const FeatureStatisticsToProtoConfig config_;
@@ -79,12 +126,18 @@ class Schema {
     const std::set<string> columns_to_ignore_;
     // A map from a key to an enum, extracted from config_.
     std::map<string, string> grouped_enums_;
+    ValidationProfiler* const profiler_;
   };
 
   // This creates an empty schema. In order to populate it, either call
   // Init(...) or Update(...).
   Schema() = default;
 
+  // The feature index points into the proto held by the schema, so it cannot
+  // be copied.
+  Schema(const Schema&) = delete;
+  Schema& operator=(const Schema&) = delete;
+
   // Initializes a schema from a protocol buffer.
   // Schema must be empty (i.e. it was just created), or the method will return
   // an InvalidArgumentException.
@@ -92,6 +145,52 @@ class Schema {
   // InvalidArgumentException.
   tensorflow::Status Init(const tensorflow::metadata::v0::Schema& input);
 
+  // Same as above, but takes input over instead of copying it.
+  tensorflow::Status Init(tensorflow::metadata::v0::Schema&& input);
+
+  // Initializes a schema as a copy-on-write overlay of base. The overlay
+  // starts out holding none of the features or string domains of base: each
+  // one is copied in (without its children) the first time it is looked up
+  // for modification, and lookups that do not modify anything go straight to
+  // base. This makes it cheap to create one overlay per anomaly.
+  // Methods that walk the whole schema (e.g., GetMissingPaths) only see what
+  // has been copied in, so they should be called on base instead.
+  // Schema must be empty, or the method will return an InvalidArgument.
+  // base must not be modified while the overlay is alive.
+  tensorflow::Status InitOverlay(std::shared_ptr<const Schema> base);
+
+  // Precomputes state that validation would otherwise recompute for every
+  // DatasetStatsView: the required features of each environment, and the
+  // values of each StringDomain. This is for a schema that is validated
+  // against many times, and is used through overlays of it (see
+  // InitOverlay()). Any modification of the schema afterwards discards the
+  // precomputed state, which is then computed on demand again.
+  void Precompute();
+
+  // Same as above, but the StringDomains selected by
+  // approximate_string_domains are precomputed as filters of their values
+  // rather than as sets of them (see ApproximateStringDomainConfig).
+  void Precompute(
+      const ApproximateStringDomainConfig& approximate_string_domains);
+
+  // Same as above, but takes the required features of no environment and of
+  // each of the default environments, keyed by environment, instead of
+  // computing them (e.g., from a CompiledSchemaImage). Those of the other
+  // environments in the schema are computed.
+  void Precompute(
+      std::map<absl::optional<string>, std::vector<Path>> required_features,
+      const ApproximateStringDomainConfig& approximate_string_domains);
+
+  // Same as above, but the values of the StringDomains in
+  // string_domain_tables, keyed by name, are looked up in those sorted tables
+  // of their distinct values (e.g., the tables of a CompiledSchemaImage)
+  // rather than being precomputed. The tables must outlive the schema and
+  // its overlays.
+  void Precompute(
+      std::map<absl::optional<string>, std::vector<Path>> required_features,
+      absl::flat_hash_map<string, StringTable> string_domain_tables,
+      const ApproximateStringDomainConfig& approximate_string_domains);
+
   // Updates Schema given new data. If you have a new, previously unseen column,
   // then config is used to create it.
   tensorflow::Status Update(const DatasetStatsView& dataset_stats,
@@ -112,19 +211,41 @@ class Schema {
       tensorflow::metadata::v0::AnomalyInfo::Severity* severity);
 
   // Returns true iff there is a feature corresponding to the path.
-  bool FeatureExists(const Path& path);
+  bool FeatureExists(const Path& path) const;
 
   // Returns true if the feature corresponding to the view is deprecated,
   // false if it is not. If there is no feature corresponding to the
   // view, the result is undefined.
-  bool FeatureIsDeprecated(const Path& path);
+  bool FeatureIsDeprecated(const Path& path) const;
+
+  // Returns the name of the field of domain_info set in the feature
+  // corresponding to the path (e.g., "int_domain"), or the empty string if
+  // none is set or there is no such feature.
+  string GetDomainType(const Path& path) const;
 
   // Deprecates a feature.
   void DeprecateFeature(const Path& path);
 
   // Gets the schema that represents the proto.
+  // For an overlay, this only has the features and string domains that were
+  // copied in or created.
   tensorflow::metadata::v0::Schema GetSchema() const;
 
+  // Same as GetSchema(), but moves the proto into *result instead of copying
+  // it, and leaves the schema empty (i.e., IsEmpty()==true).
+  void ReleaseSchema(tensorflow::metadata::v0::Schema* result);
+
+  // Gets what an overlay changed. after holds the features and string domains
+  // of the overlay (i.e., the ones that were modified or created, along with
+  // the ancestors of the features), and before holds the same features and
+  // string domains as they are in the base. Features and string domains that
+  // are new are absent from before, and string domains that were deleted are
+  // absent from after. Children of features are only included if they were
+  // changed too.
+  // If this is not an overlay, after is the whole schema and before is empty.
+  void GetChanges(tensorflow::metadata::v0::Schema* before,
+                  tensorflow::metadata::v0::Schema* after) const;
+
   // Populates FeatureStatisticsToProtoConfig with groups of enums that seem
   // similar. config is the original config, and dataset_stats has
   // the relevant data.
@@ -145,12 +266,23 @@ class Schema {
   std::vector<Description> UpdateSkewComparator(
       const FeatureStatsView& feature_stats_view);
 
+  // Returns the comparator of comparator_type of the feature at path, or null
+  // if there is no such feature or it has no such comparator.
+  const tensorflow::metadata::v0::FeatureComparator* FindComparator(
+      const Path& path, ComparatorType comparator_type) const;
+
   // Clears the schema, so that IsEmpty()==true.
   void Clear();
 
+  // Returns the features that are required to be present in environment (or
+  // in no environment), in the order in which they appear in the schema.
+  std::vector<Path> GetRequiredFeatures(
+      const absl::optional<string>& environment) const;
+
   // Returns columns that are required to be present but are absent
   // (i.e., no FeatureNameStatistics).
-  std::vector<Path> GetMissingPaths(const DatasetStatsView& dataset_stats);
+  std::vector<Path> GetMissingPaths(
+      const DatasetStatsView& dataset_stats) const;
 
   // Updates Schema given new data, but only on the columns specified.
   // If you have a new, previously unseen column on the list of columns to
@@ -164,6 +296,33 @@ class Schema {
   using Feature = tensorflow::metadata::v0::Feature;
   using SparseFeature = tensorflow::metadata::v0::SparseFeature;
   using StringDomain = tensorflow::metadata::v0::StringDomain;
+  // The columns computed in advance for new features, by path.
+  using NewColumns = absl::flat_hash_map<Path, Updater::Column>;
+
+  // Same as the public UpdateRecursively() and Update() of a single column,
+  // but if new_columns is not null, the new features with a column in
+  // *new_columns are created from it.
+  tensorflow::Status UpdateRecursively(
+      const Updater& updater, const FeatureStatsView& feature_stats_view,
+      const absl::optional<std::set<Path>>& paths_to_consider,
+      NewColumns* new_columns, std::vector<Description>* descriptions,
+      tensorflow::metadata::v0::AnomalyInfo::Severity* severity);
+  tensorflow::Status Update(
+      const Updater& updater, const FeatureStatsView& feature_stats_view,
+      NewColumns* new_columns, std::vector<Description>* descriptions,
+      tensorflow::metadata::v0::AnomalyInfo::Severity* severity);
+
+  // Computes the columns of the features in dataset_stats (and in
+  // paths_to_consider) that are not in the schema, on updater.num_threads()
+  // threads. If several features have the same path, only the first one gets
+  // a column, as the others are updated rather than created.
+  void ComputeNewColumns(
+      const DatasetStatsView& dataset_stats, const Updater& updater,
+      const absl::optional<std::set<Path>>& paths_to_consider,
+      NewColumns* new_columns) const;
+
+  // Returns true if name is the name of a StringDomain of the schema.
+  bool StringDomainExists(const string& name) const;
   // Gets a map from a simple enum name to the columns that are using it.
   // Used in GetRelatedEnums().
   std::map<string, std::set<Path>> EnumNameToPaths() const;
@@ -179,8 +338,34 @@ class Schema {
       const EnumsSimilarConfig& config) const;
 
   // Gets an existing StringDomain. If it does not already exist, returns null.
+  // For an overlay, copies the StringDomain from the base if necessary.
   StringDomain* GetExistingStringDomain(const string& name);
 
+  // Finds an existing StringDomain without copying it into an overlay.
+  // Returns null if it does not exist.
+  const StringDomain* FindStringDomain(const string& name) const;
+
+  // Returns the values of the StringDomain precomputed by Precompute(), or
+  // null if they were not precomputed. For an overlay, values are only
+  // returned for StringDomains that have not been copied in.
+  const StringDomainValues* FindStringDomainValues(const string& name) const;
+
+  // Same as above, for the StringDomains precomputed as filters.
+  const StringDomainFilter* FindStringDomainFilter(const string& name) const;
+
+  // Same as above, for the StringDomains whose values are in tables.
+  const StringTable* FindStringDomainTable(const string& name) const;
+
+  // Discards what Precompute() computed, if anything. Called by every method
+  // that can modify the schema, as the precomputed state (e.g., the views of
+  // the values of the StringDomains) would be stale otherwise.
+  void ClearPrecomputed();
+
+  // Returns the required features of environment, or null if they were not
+  // precomputed.
+  const std::vector<Path>* FindRequiredFeatures(
+      const absl::optional<string>& environment) const;
+
   // Finds all names and of features in the environment.
   std::vector<Path> GetAllRequiredFeatures(
       const Path& prefix,
@@ -224,10 +409,48 @@ class Schema {
   StringDomain* GetStringDomain(const string& name);
 
   // Gets an existing feature, and returns null if it doesn't exist.
+  // For an overlay, copies the feature (and its ancestors) from the base if
+  // necessary.
   Feature* GetExistingFeature(const Path& path);
 
-  // Gets an existing sparse feature, and returns null if it doesn't exist.
-  SparseFeature* GetExistingSparseFeature(const Path& path);
+  // Finds an existing feature without copying it into an overlay.
+  // Returns null if it doesn't exist.
+  const Feature* FindFeature(const Path& path) const;
+
+  // Same as GetMissingPaths(), but only looks at the features in paths, so
+  // that it does not walk the whole schema. Returns the paths in order.
+  std::vector<Path> GetMissingPathsAmong(
+      const DatasetStatsView& dataset_stats,
+      const std::set<Path>& paths) const;
+
+  // Finds a feature in schema_ only, ignoring the base of an overlay.
+  const Feature* FindOwnFeature(const Path& path) const;
+
+  // Adds features (whose parent has the path prefix) and their descendants
+  // to feature_index_, and sparse_features to sparse_feature_index_.
+  void IndexFeatures(
+      const Path& prefix,
+      tensorflow::protobuf::RepeatedPtrField<Feature>* features,
+      const tensorflow::protobuf::RepeatedPtrField<SparseFeature>&
+          sparse_features);
+
+  // Adds the features of base_ with the same paths as features to result.
+  // prefix is the path of the parent of features.
+  void GetBaseFeatures(
+      const Path& prefix,
+      const tensorflow::protobuf::RepeatedPtrField<Feature>& features,
+      tensorflow::protobuf::RepeatedPtrField<Feature>* result) const;
+
+  // Removes the descendants of feature from the indexes.
+  void RemoveDescendantsFromIndex(const Feature& feature);
+
+  // Clears the domain_info of a feature. If it is a struct_domain, this
+  // deletes the children of the feature, so they are removed from the
+  // indexes as well.
+  void ClearFeatureDomain(Feature* feature);
+
+  // Finds an existing sparse feature, and returns null if it doesn't exist.
+  const SparseFeature* FindSparseFeature(const Path& path) const;
 
   // Gets a new feature. Assumes that the feature does not already exist.
   Feature* GetNewFeature(const Path& path);
@@ -240,6 +463,43 @@ class Schema {
   // Note: do not manually add string_domains or features.
   // Call GetNewEnum() or GetNewFeature().
   tensorflow::metadata::v0::Schema schema_;
+
+  // Every feature in schema_, indexed by path. If there are several features
+  // with the same path, only the first one is indexed, as that is the one a
+  // linear search would find.
+  absl::flat_hash_map<Path, Feature*> feature_index_;
+
+  // Every sparse feature in schema_, indexed by path.
+  absl::flat_hash_map<Path, const SparseFeature*> sparse_feature_index_;
+
+  // Every StringDomain in schema_, indexed by name. If there are several
+  // StringDomains with the same name, only the first one is indexed.
+  absl::flat_hash_map<string, StringDomain*> string_domain_index_;
+
+  // If this is an overlay, the schema it was created from. Otherwise, null.
+  std::shared_ptr<const Schema> base_;
+
+  // The string domains of base_ that were deleted from the overlay.
+  std::set<string> removed_string_domains_;
+
+  // The result of GetAllRequiredFeatures() for the whole schema, keyed by
+  // environment: no environment, the default environments and those listed
+  // in the in_environment of some feature. Only set by Precompute().
+  std::map<absl::optional<string>, std::vector<Path>> required_features_;
+  // True from Precompute() until ClearPrecomputed().
+  bool required_features_precomputed_ = false;
+
+  // The values of each StringDomain, keyed by name. Only set by Precompute().
+  absl::flat_hash_map<string, StringDomainValues> string_domain_values_;
+
+  // The filters of the values of the StringDomains that are approximated,
+  // keyed by name, instead of their values. Only set by Precompute().
+  absl::flat_hash_map<string, std::unique_ptr<StringDomainFilter>>
+      string_domain_filters_;
+
+  // The sorted tables of the values of the StringDomains that are not
+  // precomputed, keyed by name. Only set by Precompute().
+  absl::flat_hash_map<string, StringTable> string_domain_tables_;
 };
 
 }  // namespace data_validation
@@ -33,8 +33,11 @@ limitations under the License.
 #include "tensorflow_data_validation/anomalies/schema.h"
 #include "tensorflow_data_validation/anomalies/schema_util.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
+#include "tensorflow_data_validation/anomalies/validation_profiler.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
@@ -105,6 +108,23 @@ Description UnifyDescriptions(const std::vector<Description>& descriptions) {
       });
 }
 
+// Returns the path of the root feature that path belongs to.
+Path GetRootPath(const Path& path) {
+  Path result = path;
+  while (result.size() > 1) {
+    result = result.GetParent();
+  }
+  return result;
+}
+
+std::shared_ptr<const Schema> MakeBaseline(
+    const tensorflow::metadata::v0::Schema& schema) {
+  auto baseline = std::make_shared<Schema>();
+  // Init() only fails if the schema is not empty.
+  TF_CHECK_OK(baseline->Init(schema));
+  return baseline;
+}
+
 bool ShouldCreateFeature(const absl::optional<std::set<Path>>& features_needed,
                          const FeatureStatsView& feature) {
   return !features_needed ||
@@ -117,9 +137,9 @@ SchemaAnomaly::SchemaAnomaly()
     : severity_(tensorflow::metadata::v0::AnomalyInfo::UNKNOWN) {}
 
 tensorflow::Status SchemaAnomaly::InitSchema(
-    const tensorflow::metadata::v0::Schema& schema) {
+    std::shared_ptr<const Schema> baseline) {
   schema_ = absl::make_unique<Schema>();
-  return schema_->Init(schema);
+  return schema_->InitOverlay(std::move(baseline));
 }
 
 SchemaAnomaly::SchemaAnomaly(SchemaAnomaly&& schema_anomaly)
@@ -141,15 +161,32 @@ void SchemaAnomaly::UpgradeSeverity(
   severity_ = MaxSeverity(severity_, new_severity);
 }
 
-tensorflow::metadata::v0::AnomalyInfo SchemaAnomaly::GetAnomalyInfoCommon(
-    const string& existing_schema, const string& new_schema) const {
+tensorflow::metadata::v0::AnomalyInfo SchemaAnomaly::GetAnomalyInfo() const {
   tensorflow::metadata::v0::AnomalyInfo anomaly_info;
-  *anomaly_info.mutable_path() = path_.AsProto();
-  const std::vector<Description> filtered_descriptions =
+  GetAnomalyInfo(&anomaly_info);
+  return anomaly_info;
+}
+
+void SchemaAnomaly::GetAnomalyInfo(
+    tensorflow::metadata::v0::AnomalyInfo* anomaly_info) const {
+  GetAnomalyInfo(/*max_values_in_description=*/0, anomaly_info);
+}
+
+void SchemaAnomaly::GetAnomalyInfo(
+    int max_values_in_description,
+    tensorflow::metadata::v0::AnomalyInfo* anomaly_info) const {
+  path_.ToProto(anomaly_info->mutable_path());
+  std::vector<Description> filtered_descriptions =
       FilterDescriptions(descriptions_);
-  for (const Description& description : filtered_descriptions) {
+  anomaly_info->mutable_reason()->Reserve(filtered_descriptions.size());
+  for (Description& description : filtered_descriptions) {
+    // This is the only place where the values of a description are
+    // formatted.
+    description.long_description =
+        description.GetLongDescription(max_values_in_description);
+    description.values.reset();
     tensorflow::metadata::v0::AnomalyInfo::Reason& reason =
-        *anomaly_info.add_reason();
+        *anomaly_info->add_reason();
     reason.set_type(description.type);
     reason.set_short_description(description.short_description);
     reason.set_description(description.long_description);
@@ -158,18 +195,22 @@ tensorflow::metadata::v0::AnomalyInfo SchemaAnomaly::GetAnomalyInfoCommon(
     // Set description of entire anomaly.
     const Description unified_description =
         UnifyDescriptions(filtered_descriptions);
-    anomaly_info.set_description(unified_description.long_description);
-    anomaly_info.set_short_description(unified_description.short_description);
-    anomaly_info.set_severity(severity_);
+    anomaly_info->set_description(unified_description.long_description);
+    anomaly_info->set_short_description(
+        unified_description.short_description);
+    anomaly_info->set_severity(severity_);
   }
-  return anomaly_info;
 }
 
-tensorflow::metadata::v0::AnomalyInfo SchemaAnomaly::GetAnomalyInfo(
-    const tensorflow::metadata::v0::Schema& baseline) const {
-  const string baseline_text = baseline.DebugString();
-  const string new_schema_text = schema_->GetSchema().DebugString();
-  return GetAnomalyInfoCommon(baseline_text, new_schema_text);
+string SchemaAnomaly::GetChangeText() const {
+  if (!schema_) {
+    return "";
+  }
+  tensorflow::metadata::v0::Schema before;
+  tensorflow::metadata::v0::Schema after;
+  schema_->GetChanges(&before, &after);
+  return absl::StrCat("before {\n", before.DebugString(), "}\nafter {\n",
+                      after.DebugString(), "}\n");
 }
 
 void SchemaAnomaly::ObserveMissing() {
@@ -230,38 +271,82 @@ bool SchemaAnomaly::FeatureIsDeprecated(const Path& path) {
   return false;
 }
 
+SchemaAnomalies::SchemaAnomalies(
+    const tensorflow::metadata::v0::Schema& schema)
+    : SchemaAnomalies(MakeBaseline(schema)) {}
+
+SchemaAnomalies::SchemaAnomalies(std::shared_ptr<const Schema> baseline)
+    : baseline_(std::move(baseline)) {
+  CHECK(baseline_ != nullptr);
+}
+
 tensorflow::metadata::v0::Anomalies SchemaAnomalies::GetSchemaDiff() const {
-  const tensorflow::metadata::v0::Schema& schema_proto = serialized_baseline_;
   tensorflow::metadata::v0::Anomalies result;
-  result.set_anomaly_name_format(
+  GetSchemaDiff(&result);
+  return result;
+}
+
+void SchemaAnomalies::GetSchemaDiff(
+    tensorflow::metadata::v0::Anomalies* result) const {
+  ScopedPhaseTimer timer(profiler_, ValidationPhase::kSchemaDiff);
+  result->Clear();
+  result->set_anomaly_name_format(
       tensorflow::metadata::v0::Anomalies::SERIALIZED_PATH);
-  *result.mutable_baseline() = schema_proto;
+  *result->mutable_baseline() = baseline_->GetSchema();
   ::tensorflow::protobuf::Map<string, tensorflow::metadata::v0::AnomalyInfo>&
-      result_schemas = *result.mutable_anomaly_info();
+      result_schemas = *result->mutable_anomaly_info();
   for (const auto& pair : anomalies_) {
     const Path& feature_path = pair.first;
     const SchemaAnomaly& anomaly = pair.second;
-    result_schemas[feature_path.Serialize()] =
-        anomaly.GetAnomalyInfo(schema_proto);
+    anomaly.GetAnomalyInfo(max_values_in_description_,
+                           &result_schemas[feature_path.Serialize()]);
   }
-  return result;
 }
 
-tensorflow::Status SchemaAnomalies::InitSchema(Schema* schema) const {
-  return schema->Init(serialized_baseline_);
+tensorflow::Status SchemaAnomalies::WriteSchemaDiff(bool include_baseline,
+                                                    AnomalySink* sink) {
+  ScopedPhaseTimer timer(profiler_, ValidationPhase::kSchemaDiff);
+  {
+    tensorflow::metadata::v0::Anomalies header;
+    header.set_anomaly_name_format(
+        tensorflow::metadata::v0::Anomalies::SERIALIZED_PATH);
+    if (include_baseline) {
+      *header.mutable_baseline() = baseline_->GetSchema();
+    }
+    TF_RETURN_IF_ERROR(sink->WriteHeader(header));
+  }
+  tensorflow::metadata::v0::AnomalyInfo anomaly_info;
+  while (!anomalies_.empty()) {
+    const auto iter = anomalies_.begin();
+    anomaly_info.Clear();
+    iter->second.GetAnomalyInfo(max_values_in_description_, &anomaly_info);
+    TF_RETURN_IF_ERROR(
+        sink->WriteAnomalyInfo(iter->first.Serialize(), anomaly_info));
+    anomalies_.erase(iter);
+  }
+  return Status::OK();
 }
+
+std::map<Path, string> SchemaAnomalies::GetChangeTexts() const {
+  std::map<Path, string> result;
+  for (const auto& pair : anomalies_) {
+    result[pair.first] = pair.second.GetChangeText();
+  }
+  return result;
+}
+
 tensorflow::Status SchemaAnomalies::GenericUpdate(
     const std::function<tensorflow::Status(SchemaAnomaly* anomaly)>& update,
-    const Path& path) {
-  if (ContainsKey(anomalies_, path)) {
-    return update(&anomalies_[path]);
+    const Path& path, std::map<Path, SchemaAnomaly>* anomalies) const {
+  if (ContainsKey(*anomalies, path)) {
+    return update(&(*anomalies)[path]);
   } else {
     SchemaAnomaly schema_anomaly;
-    TF_RETURN_IF_ERROR(schema_anomaly.InitSchema(serialized_baseline_));
+    TF_RETURN_IF_ERROR(schema_anomaly.InitSchema(baseline_));
     schema_anomaly.set_path(path);
     TF_RETURN_IF_ERROR(update(&schema_anomaly));
     if (schema_anomaly.is_problem()) {
-      anomalies_[path] = std::move(schema_anomaly);
+      (*anomalies)[path] = std::move(schema_anomaly);
     }
   }
   return Status::OK();
@@ -270,49 +355,153 @@ tensorflow::Status SchemaAnomalies::GenericUpdate(
 tensorflow::Status SchemaAnomalies::FindChangesRecursively(
     const FeatureStatsView& feature_stats_view,
     const absl::optional<std::set<Path>>& features_needed,
-    const Schema::Updater& updater) {
-  Schema baseline;
-  TF_RETURN_IF_ERROR(InitSchema(&baseline));
-  if (baseline.FeatureExists(feature_stats_view.GetPath())) {
-    if (baseline.FeatureIsDeprecated(feature_stats_view.GetPath())) {
+    const Schema::Updater& updater,
+    std::map<Path, SchemaAnomaly>* anomalies) const {
+  if (baseline_->FeatureExists(feature_stats_view.GetPath())) {
+    if (baseline_->FeatureIsDeprecated(feature_stats_view.GetPath())) {
       return Status::OK();
     }
     TF_RETURN_IF_ERROR(GenericUpdate(
         [&feature_stats_view, &updater](SchemaAnomaly* schema_anomaly) {
           return schema_anomaly->Update(updater, feature_stats_view);
         },
-        feature_stats_view.GetPath()));
-    if (ContainsKey(anomalies_, feature_stats_view.GetPath()) &&
-        anomalies_[feature_stats_view.GetPath()].FeatureIsDeprecated(
+        feature_stats_view.GetPath(), anomalies));
+    if (ContainsKey(*anomalies, feature_stats_view.GetPath()) &&
+        (*anomalies)[feature_stats_view.GetPath()].FeatureIsDeprecated(
             feature_stats_view.GetPath())) {
       return Status::OK();
     }
-    for (const FeatureStatsView& child : feature_stats_view.GetChildren()) {
+    for (const FeatureStatsView& child :
+         feature_stats_view.GetChildrenRange()) {
       TF_RETURN_IF_ERROR(
-          FindChangesRecursively(child, features_needed, updater));
+          FindChangesRecursively(child, features_needed, updater, anomalies));
     }
   } else if (ShouldCreateFeature(features_needed, feature_stats_view)) {
     // Feature doesn't exist. Need to recursively create it.
 
-    if (!ContainsKey(anomalies_, feature_stats_view.GetPath())) {
+    if (!ContainsKey(*anomalies, feature_stats_view.GetPath())) {
       SchemaAnomaly anomaly;
-      TF_RETURN_IF_ERROR(anomaly.InitSchema(serialized_baseline_));
+      TF_RETURN_IF_ERROR(anomaly.InitSchema(baseline_));
       anomaly.set_path(feature_stats_view.GetPath());
-      anomalies_[feature_stats_view.GetPath()] = std::move(anomaly);
+      (*anomalies)[feature_stats_view.GetPath()] = std::move(anomaly);
     }
     // Since these features are all new,
     // features_needed == features_to_update.
-    TF_RETURN_IF_ERROR(anomalies_[feature_stats_view.GetPath()].CreateNewField(
-        updater, features_needed, feature_stats_view));
+    TF_RETURN_IF_ERROR(
+        (*anomalies)[feature_stats_view.GetPath()].CreateNewField(
+            updater, features_needed, feature_stats_view));
   }
   return Status::OK();
 }
 
+tensorflow::Status SchemaAnomalies::FindChangesForRoot(
+    const FeatureStatsView& root,
+    const absl::optional<std::set<Path>>& features_needed,
+    const Schema::Updater& updater,
+    std::map<Path, SchemaAnomaly>* anomalies) const {
+  if (profiler_ == nullptr) {
+    return FindChangesRecursively(root, features_needed, updater, anomalies);
+  }
+  const uint64 start_micros = Env::Default()->NowMicros();
+  const Status status =
+      FindChangesRecursively(root, features_needed, updater, anomalies);
+  const Path& path = root.GetPath();
+  profiler_->AddFeatureTime(
+      path,
+      baseline_->FeatureExists(path) ? baseline_->GetDomainType(path)
+                                     : "new_feature",
+      Env::Default()->NowMicros() - start_micros);
+  return status;
+}
+
+tensorflow::Status SchemaAnomalies::FindChangesInParallel(
+    const std::vector<FeatureStatsView>& roots,
+    const absl::optional<std::set<Path>>& features_needed,
+    const Schema::Updater& updater, int num_threads) {
+  // The anomalies for a root feature and its descendants all have the path of
+  // the root as a prefix, so each task gets its own map of anomalies. Roots
+  // with the same path go in the same task, in their original order.
+  struct Task {
+    std::vector<const FeatureStatsView*> roots;
+    std::map<Path, SchemaAnomaly> anomalies;
+    Status status;
+  };
+  std::vector<Task> tasks;
+  std::map<Path, int> task_index;
+  for (const FeatureStatsView& root : roots) {
+    auto inserted = task_index.emplace(root.GetPath(), tasks.size());
+    if (inserted.second) {
+      tasks.emplace_back();
+    }
+    tasks[inserted.first->second].roots.push_back(&root);
+  }
+  // Hand any anomalies found previously to the task that may update them.
+  for (auto iter = anomalies_.begin(); iter != anomalies_.end();) {
+    auto task = task_index.find(GetRootPath(iter->first));
+    if (task == task_index.end()) {
+      ++iter;
+      continue;
+    }
+    tasks[task->second].anomalies[iter->first] = std::move(iter->second);
+    iter = anomalies_.erase(iter);
+  }
+
+  {
+    thread::ThreadPool pool(Env::Default(), "find_changes", num_threads);
+    for (Task& task : tasks) {
+      pool.Schedule([this, &task, &features_needed, &updater]() {
+        for (const FeatureStatsView* root : task.roots) {
+          task.status = FindChangesForRoot(*root, features_needed, updater,
+                                           &task.anomalies);
+          if (!task.status.ok()) {
+            return;
+          }
+        }
+      });
+    }
+    // The destructor of pool waits for all the tasks to finish.
+  }
+
+  // Different tasks have disjoint anomalies, so merging them in any order
+  // gives the same result.
+  Status status;
+  for (Task& task : tasks) {
+    for (auto& pair : task.anomalies) {
+      anomalies_[pair.first] = std::move(pair.second);
+    }
+    status.Update(task.status);
+  }
+  return status;
+}
+
 tensorflow::Status SchemaAnomalies::FindChanges(
     const DatasetStatsView& statistics,
     const absl::optional<FeaturesNeeded>& features_needed,
     const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config) {
-  Schema::Updater updater(feature_statistics_to_proto_config);
+  return FindChanges(statistics, features_needed,
+                     feature_statistics_to_proto_config, /*num_threads=*/1);
+}
+
+tensorflow::Status SchemaAnomalies::FindChanges(
+    const DatasetStatsView& statistics,
+    const absl::optional<FeaturesNeeded>& features_needed,
+    const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
+    int num_threads) {
+  return FindChanges(statistics, features_needed,
+                     feature_statistics_to_proto_config, num_threads,
+                     [](const FeatureStatsView&) { return true; });
+}
+
+tensorflow::Status SchemaAnomalies::FindChanges(
+    const DatasetStatsView& statistics,
+    const absl::optional<FeaturesNeeded>& features_needed,
+    const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
+    int num_threads,
+    const std::function<bool(const FeatureStatsView&)>& should_validate) {
+  ScopedPhaseTimer timer(profiler_, ValidationPhase::kFindChanges);
+  Schema::Updater updater(feature_statistics_to_proto_config, profiler_);
+  max_values_in_description_ =
+      feature_statistics_to_proto_config.max_values_in_description();
   absl::optional<std::set<Path>> feature_set_to_create;
   if (features_needed) {
     feature_set_to_create = std::set<Path>();
@@ -322,25 +511,37 @@ tensorflow::Status SchemaAnomalies::FindChanges(
     }
   }
 
-  for (const FeatureStatsView& feature_stats_view :
-       statistics.GetRootFeatures()) {
-    TF_RETURN_IF_ERROR(FindChangesRecursively(feature_stats_view,
-                                              feature_set_to_create, updater));
+  std::vector<FeatureStatsView> roots;
+  for (const FeatureStatsView& root : statistics.GetRootFeaturesRange()) {
+    if (should_validate(root)) {
+      roots.push_back(root);
+    }
   }
-  Schema baseline;
-  TF_RETURN_IF_ERROR(InitSchema(&baseline));
-  for (const Path& path : baseline.GetMissingPaths(statistics)) {
-    TF_RETURN_IF_ERROR(GenericUpdate(
-        [](SchemaAnomaly* schema_anomaly) {
-          schema_anomaly->ObserveMissing();
-          return Status::OK();
-        },
-        path));
+  if (num_threads > 1 && roots.size() > 1) {
+    TF_RETURN_IF_ERROR(FindChangesInParallel(roots, feature_set_to_create,
+                                             updater, num_threads));
+  } else {
+    for (const FeatureStatsView& feature_stats_view : roots) {
+      TF_RETURN_IF_ERROR(FindChangesForRoot(
+          feature_stats_view, feature_set_to_create, updater, &anomalies_));
+    }
+  }
+  {
+    ScopedPhaseTimer missing_paths_timer(profiler_,
+                                         ValidationPhase::kMissingPaths);
+    for (const Path& path : baseline_->GetMissingPaths(statistics)) {
+      TF_RETURN_IF_ERROR(GenericUpdate(
+          [](SchemaAnomaly* schema_anomaly) {
+            schema_anomaly->ObserveMissing();
+            return Status::OK();
+          },
+          path, &anomalies_));
+    }
   }
   if (features_needed) {
     for (const auto& p : *features_needed) {
       const Path& path = p.first;
-      if (!statistics.GetByPath(path) && !baseline.FeatureExists(path)) {
+      if (!statistics.GetByPath(path) && !baseline_->FeatureExists(path)) {
         LOG(ERROR) << "Required feature missing from data and schema: "
                    << path.Serialize();
       }
@@ -351,18 +552,135 @@ tensorflow::Status SchemaAnomalies::FindChanges(
 
 tensorflow::Status SchemaAnomalies::FindSkew(
     const DatasetStatsView& dataset_stats_view) {
+  return FindSkew(dataset_stats_view, /*num_threads=*/1,
+                  /*feature_errors=*/nullptr);
+}
+
+tensorflow::Status SchemaAnomalies::FindSkew(
+    const DatasetStatsView& dataset_stats_view, int num_threads,
+    std::map<Path, tensorflow::Status>* feature_errors) {
+  if (num_threads > 1) {
+    return FindSkewInParallel(dataset_stats_view, num_threads, feature_errors);
+  }
+  Status status;
   for (const FeatureStatsView& feature_stats_view :
-       dataset_stats_view.features()) {
-    // This is a simplified version of finding skew, that ignores the feature
-    // if there is no training data for it.
-    TF_CHECK_OK(GenericUpdate(
-        [&feature_stats_view](SchemaAnomaly* schema_anomaly) {
-          schema_anomaly->UpdateSkewComparator(feature_stats_view);
-          return Status::OK();
-        },
-        feature_stats_view.GetPath()));
+       dataset_stats_view.features_range()) {
+    const Status feature_status = FindSkewForFeature(feature_stats_view,
+                                                     &anomalies_);
+    if (!feature_status.ok()) {
+      if (feature_errors != nullptr) {
+        (*feature_errors)[feature_stats_view.GetPath()] = feature_status;
+      } else {
+        status.Update(feature_status);
+      }
+    }
   }
-  return Status::OK();
+  return status;
+}
+
+tensorflow::Status SchemaAnomalies::FindSkewInParallel(
+    const DatasetStatsView& dataset_stats_view, int num_threads,
+    std::map<Path, tensorflow::Status>* feature_errors) {
+  // Each task gets its own map of anomalies, as in FindChangesInParallel().
+  struct Task {
+    std::vector<size_t> feature_indices;
+    std::map<Path, SchemaAnomaly> anomalies;
+  };
+  const std::vector<FeatureStatsView> features = dataset_stats_view.features();
+  // Parallel to features.
+  std::vector<Status> statuses(features.size());
+  std::vector<Task> tasks;
+  std::map<Path, int> task_index;
+  for (size_t i = 0; i < features.size(); ++i) {
+    auto inserted = task_index.emplace(features[i].GetPath(), tasks.size());
+    if (inserted.second) {
+      tasks.emplace_back();
+    }
+    tasks[inserted.first->second].feature_indices.push_back(i);
+  }
+  for (const auto& pair : task_index) {
+    auto iter = anomalies_.find(pair.first);
+    if (iter != anomalies_.end()) {
+      tasks[pair.second].anomalies[iter->first] = std::move(iter->second);
+      anomalies_.erase(iter);
+    }
+  }
+
+  {
+    thread::ThreadPool pool(Env::Default(), "find_skew", num_threads);
+    for (Task& task : tasks) {
+      pool.Schedule([this, &task, &features, &statuses]() {
+        for (size_t i : task.feature_indices) {
+          statuses[i] = FindSkewForFeature(features[i], &task.anomalies);
+        }
+      });
+    }
+    // The destructor of pool waits for all the tasks to finish.
+  }
+
+  for (Task& task : tasks) {
+    for (auto& pair : task.anomalies) {
+      anomalies_[pair.first] = std::move(pair.second);
+    }
+  }
+  // The errors are reported in the order of the features, as on the calling
+  // thread.
+  Status status;
+  for (size_t i = 0; i < features.size(); ++i) {
+    if (statuses[i].ok()) {
+      continue;
+    }
+    if (feature_errors != nullptr) {
+      (*feature_errors)[features[i].GetPath()] = statuses[i];
+    } else {
+      status.Update(statuses[i]);
+    }
+  }
+  return status;
+}
+
+tensorflow::Status SchemaAnomalies::FindSkewForFeature(
+    const FeatureStatsView& feature_stats_view,
+    std::map<Path, SchemaAnomaly>* anomalies) const {
+  // This is a simplified version of finding skew, that ignores the feature
+  // if there is no training data for it.
+  return GenericUpdate(
+      [&feature_stats_view](SchemaAnomaly* schema_anomaly) {
+        schema_anomaly->UpdateSkewComparator(feature_stats_view);
+        return Status::OK();
+      },
+      feature_stats_view.GetPath(), anomalies);
+}
+
+tensorflow::Status SchemaAnomalies::FindSkewForEachServing(
+    const DatasetStatsView& training,
+    const std::vector<std::shared_ptr<DatasetStatsView>>& servings,
+    int num_threads, std::vector<tensorflow::metadata::v0::Anomalies>* results,
+    std::vector<std::map<Path, tensorflow::Status>>* feature_errors) const {
+  for (size_t i = 0; i < servings.size(); ++i) {
+    if (servings[i] == nullptr) {
+      return errors::InvalidArgument("Serving statistics ", i, " are null.");
+    }
+  }
+  results->clear();
+  results->resize(servings.size());
+  if (feature_errors != nullptr) {
+    feature_errors->clear();
+    feature_errors->resize(servings.size());
+  }
+  Status status;
+  for (size_t i = 0; i < servings.size(); ++i) {
+    SchemaAnomalies skew(baseline_);
+    skew.set_profiler(profiler_);
+    skew.max_values_in_description_ = max_values_in_description_;
+    // Views of training share the string values of training, so they are
+    // only computed for the first serving statistics.
+    status.Update(skew.FindSkew(
+        training.WithServing(servings[i]), num_threads,
+        feature_errors != nullptr ? &(*feature_errors)[i] : nullptr));
+    skew.GetSchemaDiff(&(*results)[i]);
+  }
+  return status;
 }
 
 }  // namespace data_validation
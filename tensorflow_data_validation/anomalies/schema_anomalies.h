@@ -22,11 +22,13 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "tensorflow_data_validation/anomalies/anomaly_sink.h"
 #include "tensorflow_data_validation/anomalies/features_needed.h"
 #include "tensorflow_data_validation/anomalies/internal_types.h"
 #include "tensorflow_data_validation/anomalies/proto/feature_statistics_to_proto.pb.h"
 #include "tensorflow_data_validation/anomalies/schema.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
+#include "tensorflow_data_validation/anomalies/validation_profiler.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_metadata/proto/v0/anomalies.pb.h"
@@ -44,9 +46,9 @@ class SchemaAnomaly {
 
   SchemaAnomaly& operator=(SchemaAnomaly&& schema_anomaly);
 
-  // Initializes schema_.
-  tensorflow::Status InitSchema(
-      const tensorflow::metadata::v0::Schema& schema);
+  // Initializes schema_ as an overlay of baseline, so that only the parts of
+  // the schema changed by this anomaly are copied.
+  tensorflow::Status InitSchema(std::shared_ptr<const Schema> baseline);
 
   // Updates based upon the relevant current feature statistics.
   tensorflow::Status Update(const Schema::Updater& updater,
@@ -75,9 +77,23 @@ class SchemaAnomaly {
       tensorflow::metadata::v0::AnomalyInfo::Severity new_severity);
 
   // Returns an AnomalyInfo representing the change.
-  // baseline is the original schema.
-  tensorflow::metadata::v0::AnomalyInfo GetAnomalyInfo(
-      const tensorflow::metadata::v0::Schema& baseline) const;
+  tensorflow::metadata::v0::AnomalyInfo GetAnomalyInfo() const;
+
+  // Same as above, but fills *anomaly_info in place. *anomaly_info must be
+  // empty.
+  void GetAnomalyInfo(
+      tensorflow::metadata::v0::AnomalyInfo* anomaly_info) const;
+
+  // Same as above, but lists at most max_values_in_description values in
+  // each description (see Description::GetLongDescription()).
+  void GetAnomalyInfo(
+      int max_values_in_description,
+      tensorflow::metadata::v0::AnomalyInfo* anomaly_info) const;
+
+  // Returns a human-readable rendering of the change to the schema. Only the
+  // features and string domains changed by this anomaly are rendered, both
+  // before and after the change.
+  string GetChangeText() const;
 
   // Identifies if there is an issue.
   bool is_problem() {
@@ -90,13 +106,8 @@ class SchemaAnomaly {
   bool FeatureIsDeprecated(const Path& path);
 
  private:
-  // Returns an AnomalyInfo representing the change. Takes as an input the
-  // text version of the existing schema and the new schema.
-  // Called as part of GetAnomalyInfoV0(...) and GetAnomalyInfoV1(...) to do
-  // the part of the work that is common between them.
-  tensorflow::metadata::v0::AnomalyInfo GetAnomalyInfoCommon(
-      const string& existing_schema, const string& new_schema) const;
-  // A new schema that will make the anomaly go away.
+  // A new schema that will make the anomaly go away. This is an overlay of
+  // the baseline, holding only the features that were changed.
   std::unique_ptr<Schema> schema_;
   // The name of the feature being fixed.
   Path path_;
@@ -110,9 +121,12 @@ class SchemaAnomaly {
 // created the anomaly.
 class SchemaAnomalies {
  public:
-  explicit SchemaAnomalies(
-      const tensorflow::metadata::v0::Schema& schema)
-      : serialized_baseline_(schema) {}
+  explicit SchemaAnomalies(const tensorflow::metadata::v0::Schema& schema);
+
+  // Shares a baseline that has already been initialized (e.g., when the same
+  // schema is used to validate several statistics). baseline must not be
+  // modified afterwards.
+  explicit SchemaAnomalies(std::shared_ptr<const Schema> baseline);
 
   // Finds any columns that have issues, and creates a new Schema proto
   // involving only the changes for that column. Returns a map where the key is
@@ -125,11 +139,80 @@ class SchemaAnomalies {
       const absl::optional<FeaturesNeeded>& features_needed,
       const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config);
 
+  // Same as above, but validates the root features (each along with its
+  // descendants) on num_threads threads. The result does not depend on
+  // num_threads. If num_threads <= 1, runs on the calling thread.
+  tensorflow::Status FindChanges(
+      const DatasetStatsView& statistics,
+      const absl::optional<FeaturesNeeded>& features_needed,
+      const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
+      int num_threads);
+
+  // Same as above, but only validates the root features (each along with its
+  // descendants) for which should_validate returns true. Features that are
+  // missing from the statistics are always found.
+  tensorflow::Status FindChanges(
+      const DatasetStatsView& statistics,
+      const absl::optional<FeaturesNeeded>& features_needed,
+      const FeatureStatisticsToProtoConfig& feature_statistics_to_proto_config,
+      int num_threads,
+      const std::function<bool(const FeatureStatsView&)>& should_validate);
+
+  // Finds skew between each feature of dataset_stats_view and the same
+  // feature of its serving statistics, for the features with a
+  // skew_comparator in the schema. Features without serving statistics are
+  // ignored. An error for a feature does not stop the others from being
+  // compared; the first error, in the order of the features, is returned.
   tensorflow::Status FindSkew(const DatasetStatsView& dataset_stats_view);
 
+  // Same as above, but compares the features on num_threads threads. The
+  // result does not depend on num_threads. If num_threads <= 1, runs on the
+  // calling thread. If feature_errors is not null, the error for each
+  // feature is recorded there instead, keyed by its path, and OK is
+  // returned.
+  tensorflow::Status FindSkew(
+      const DatasetStatsView& dataset_stats_view, int num_threads,
+      std::map<Path, tensorflow::Status>* feature_errors);
+
+  // Finds skew between training and each of servings, as FindSkew() of
+  // training.WithServing(servings[i]), and records the anomalies found as
+  // (*results)[i]. Only skew anomalies are recorded, and the anomalies of
+  // this object are not changed. The string values of training are computed
+  // once for all of servings. If feature_errors is not null, it is filled
+  // in parallel to servings.
+  tensorflow::Status FindSkewForEachServing(
+      const DatasetStatsView& training,
+      const std::vector<std::shared_ptr<DatasetStatsView>>& servings,
+      int num_threads,
+      std::vector<tensorflow::metadata::v0::Anomalies>* results,
+      std::vector<std::map<Path, tensorflow::Status>>* feature_errors) const;
+
+  // Times FindChanges() and GetSchemaDiff() in profiler, along with each root
+  // feature validated, if profiler is not null. profiler must outlive this.
+  void set_profiler(ValidationProfiler* profiler) { profiler_ = profiler; }
+
   // Records current anomalies as a schema diff.
+  // This does not render the changes as text, which can be expensive when
+  // there are many anomalies. Use GetChangeTexts() for that.
   tensorflow::metadata::v0::Anomalies GetSchemaDiff() const;
 
+  // Same as above, but fills *result in place (replacing its contents),
+  // rather than building the diff in another message and copying it. If
+  // *result is on an arena, its sub-messages are allocated there too.
+  void GetSchemaDiff(tensorflow::metadata::v0::Anomalies* result) const;
+
+  // Same as above, but writes the schema diff to *sink: first the header,
+  // with the baseline only if include_baseline, then each anomaly, in order
+  // of path. Each anomaly is released once it is written, so that no more
+  // than one AnomalyInfo is held at a time: afterwards, there are no
+  // anomalies left.
+  tensorflow::Status WriteSchemaDiff(bool include_baseline, AnomalySink* sink);
+
+  // Returns a human-readable rendering of the change to the schema made by
+  // each anomaly (see SchemaAnomaly::GetChangeText()), keyed by the path of
+  // the anomaly.
+  std::map<Path, string> GetChangeTexts() const;
+
  private:
   // Checks a particular column for any issues, and:
   // 1. If the column is not in the schema, creates a new Schema proto
@@ -138,28 +221,68 @@ class SchemaAnomalies {
   //    A. If it is deprecated after repair, do nothing.
   //    B. Otherwise, recursively check all its children, returning separate
   //       anomalies for each child.
+  // The anomalies found are added to anomalies. This only reads and writes
+  // anomalies for feature_stats_view and its descendants, so it can be
+  // called concurrently for different root features.
   tensorflow::Status FindChangesRecursively(
       const FeatureStatsView& feature_stats_view,
       const absl::optional<std::set<Path>>& features_needed,
-      const Schema::Updater& updater);
+      const Schema::Updater& updater,
+      std::map<Path, SchemaAnomaly>* anomalies) const;
+
+  // Calls FindChangesRecursively() for a root feature, recording its time in
+  // profiler_ if it is not null.
+  tensorflow::Status FindChangesForRoot(
+      const FeatureStatsView& root,
+      const absl::optional<std::set<Path>>& features_needed,
+      const Schema::Updater& updater,
+      std::map<Path, SchemaAnomaly>* anomalies) const;
+
+  // Calls FindChangesForRoot() for each of roots on a pool of
+  // num_threads threads, and merges the results into anomalies_.
+  tensorflow::Status FindChangesInParallel(
+      const std::vector<FeatureStatsView>& roots,
+      const absl::optional<std::set<Path>>& features_needed,
+      const Schema::Updater& updater, int num_threads);
 
-  // 1. If there is a SchemaAnomaly for feature_name, applies update,
+  // 1. If there is a SchemaAnomaly for feature_name in anomalies, applies
+  // update,
   // 2. otherwise, creates a new SchemaAnomaly for the feature_name and
-  // initializes it using the serialized_baseline_. Then, it tries the
+  // initializes it as an overlay of baseline_. Then, it tries the
   // update(...) function. If there is a problem, then the new SchemaAnomaly
-  // gets added.
+  // gets added to anomalies.
   tensorflow::Status GenericUpdate(
       const std::function<tensorflow::Status(SchemaAnomaly* anomaly)>& update,
-      const Path& path);
+      const Path& path, std::map<Path, SchemaAnomaly>* anomalies) const;
 
-  // Initialize a schema from the serialized_baseline_.
-  tensorflow::Status InitSchema(Schema* schema) const;
+  // Finds skew for a single feature (see FindSkew()), adding the anomaly
+  // found to anomalies. This only reads and writes the anomaly for the path
+  // of feature_stats_view, so it can be called concurrently for different
+  // paths.
+  tensorflow::Status FindSkewForFeature(
+      const FeatureStatsView& feature_stats_view,
+      std::map<Path, SchemaAnomaly>* anomalies) const;
+
+  // Same as FindChangesInParallel(), for FindSkew(): the features with the
+  // same path are compared in the same task, in their original order.
+  tensorflow::Status FindSkewInParallel(
+      const DatasetStatsView& dataset_stats_view, int num_threads,
+      std::map<Path, tensorflow::Status>* feature_errors);
 
   // A map from feature columns to anomalies in that column.
   std::map<Path, SchemaAnomaly> anomalies_;
 
-  // The initial schema. Each SchemaAnomaly is initialized from this.
-  tensorflow::metadata::v0::Schema serialized_baseline_;
+  // The initial schema, which is never modified. The schema of each
+  // SchemaAnomaly is an overlay of this.
+  const std::shared_ptr<const Schema> baseline_;
+
+  // Where to record the time of validation, or null.
+  ValidationProfiler* profiler_ = nullptr;
+
+  // The maximum number of values listed in each description, as
+  // FeatureStatisticsToProtoConfig.max_values_in_description of the last call
+  // to FindChanges().
+  int max_values_in_description_ = 0;
 };
 
 }  // namespace data_validation
@@ -15,10 +15,14 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/schema_anomalies.h"
 
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <gtest/gtest.h>
 #include "tensorflow_data_validation/anomalies/feature_util.h"
+#include "tensorflow_data_validation/anomalies/map_util.h"
 #include "tensorflow_data_validation/anomalies/statistics_view_test_util.h"
 #include "tensorflow_data_validation/anomalies/test_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
@@ -284,6 +288,140 @@ TEST(SchemaAnomalies, FindSkew) {
   TestAnomalies(skew.GetSchemaDiff(), schema_proto, expected_anomalies);
 }
 
+// Returns statistics with a STRING feature for each name in names_and_values,
+// whose rank histogram has one bucket per character of its values.
+DatasetFeatureStatistics GetStringStatistics(
+    const std::vector<std::pair<string, string>>& names_and_values) {
+  DatasetFeatureStatistics result;
+  result.set_num_examples(10);
+  for (const auto& name_and_values : names_and_values) {
+    FeatureNameStatistics* feature = result.add_features();
+    feature->set_name(name_and_values.first);
+    feature->set_type(FeatureNameStatistics::STRING);
+    tensorflow::metadata::v0::StringStatistics* string_stats =
+        feature->mutable_string_stats();
+    string_stats->mutable_common_stats()->set_num_non_missing(10);
+    string_stats->mutable_common_stats()->set_max_num_values(1);
+    for (char c : name_and_values.second) {
+      tensorflow::metadata::v0::RankHistogram::Bucket* bucket =
+          string_stats->mutable_rank_histogram()->add_buckets();
+      bucket->set_label(string(1, c));
+      bucket->set_sample_count(1);
+    }
+  }
+  return result;
+}
+
+TEST(SchemaAnomalies, FindSkewMultipleThreads) {
+  const Schema schema_proto = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: 'foo'
+      type: BYTES
+      skew_comparator { infinity_norm: { threshold: 0.1 } }
+    }
+    feature {
+      name: 'bar'
+      type: BYTES
+      skew_comparator { infinity_norm: { threshold: 0.1 } }
+    }
+    feature {
+      name: 'same'
+      type: BYTES
+      skew_comparator { infinity_norm: { threshold: 0.1 } }
+    }
+    feature { name: 'no_comparator' type: BYTES })");
+  const DatasetStatsView view(
+      GetStringStatistics({{"foo", "ab"},
+                           {"bar", "abcd"},
+                           {"same", "ab"},
+                           {"no_comparator", "ab"}}),
+      /*by_weight=*/false, /*environment=*/absl::nullopt,
+      /*previous=*/nullptr,
+      std::make_shared<DatasetStatsView>(
+          GetStringStatistics({{"foo", "cd"},
+                               {"bar", "a"},
+                               {"same", "ab"},
+                               {"no_comparator", "cd"}})));
+
+  SchemaAnomalies sequential(schema_proto);
+  TF_ASSERT_OK(sequential.FindSkew(view));
+  const tensorflow::metadata::v0::Anomalies expected =
+      sequential.GetSchemaDiff();
+  ASSERT_EQ(expected.anomaly_info_size(), 2);
+  EXPECT_TRUE(ContainsKey(expected.anomaly_info(), "foo"));
+  EXPECT_TRUE(ContainsKey(expected.anomaly_info(), "bar"));
+  for (int num_threads : {2, 4}) {
+    SchemaAnomalies parallel(schema_proto);
+    std::map<Path, tensorflow::Status> feature_errors;
+    TF_ASSERT_OK(parallel.FindSkew(view, num_threads, &feature_errors));
+    EXPECT_TRUE(feature_errors.empty());
+    const tensorflow::metadata::v0::Anomalies actual =
+        parallel.GetSchemaDiff();
+    ASSERT_EQ(actual.anomaly_info_size(), expected.anomaly_info_size());
+    for (const auto& pair : expected.anomaly_info()) {
+      ASSERT_TRUE(ContainsKey(actual.anomaly_info(), pair.first));
+      EXPECT_THAT(actual.anomaly_info().at(pair.first),
+                  testing::EqualsProto(pair.second));
+    }
+  }
+}
+
+TEST(SchemaAnomalies, FindSkewForEachServing) {
+  const Schema schema_proto = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: 'foo'
+      type: BYTES
+      skew_comparator { infinity_norm: { threshold: 0.1 } }
+    }
+    feature {
+      name: 'bar'
+      type: BYTES
+      skew_comparator { infinity_norm: { threshold: 0.1 } }
+    })");
+  const DatasetStatsView training(
+      GetStringStatistics({{"foo", "ab"}, {"bar", "ab"}}));
+  const std::vector<std::shared_ptr<DatasetStatsView>> servings = {
+      std::make_shared<DatasetStatsView>(
+          GetStringStatistics({{"foo", "ab"}, {"bar", "ab"}})),
+      std::make_shared<DatasetStatsView>(
+          GetStringStatistics({{"foo", "cd"}, {"bar", "ab"}})),
+      std::make_shared<DatasetStatsView>(
+          GetStringStatistics({{"foo", "cd"}, {"bar", "c"}}))};
+
+  const SchemaAnomalies skew(schema_proto);
+  std::vector<tensorflow::metadata::v0::Anomalies> results;
+  std::vector<std::map<Path, tensorflow::Status>> feature_errors;
+  TF_ASSERT_OK(skew.FindSkewForEachServing(training, servings,
+                                           /*num_threads=*/2, &results,
+                                           &feature_errors));
+  ASSERT_EQ(results.size(), 3);
+  ASSERT_EQ(feature_errors.size(), 3);
+  EXPECT_EQ(results[0].anomaly_info_size(), 0);
+  EXPECT_EQ(results[1].anomaly_info_size(), 1);
+  EXPECT_TRUE(ContainsKey(results[1].anomaly_info(), "foo"));
+  EXPECT_EQ(results[2].anomaly_info_size(), 2);
+  for (size_t i = 0; i < servings.size(); ++i) {
+    EXPECT_TRUE(feature_errors[i].empty());
+    EXPECT_THAT(results[i].baseline(), testing::EqualsProto(schema_proto));
+    // Each result is the same as FindSkew() of that serving alone.
+    SchemaAnomalies alone(schema_proto);
+    TF_ASSERT_OK(alone.FindSkew(training.WithServing(servings[i])));
+    const tensorflow::metadata::v0::Anomalies expected =
+        alone.GetSchemaDiff();
+    ASSERT_EQ(results[i].anomaly_info_size(), expected.anomaly_info_size());
+    for (const auto& pair : expected.anomaly_info()) {
+      ASSERT_TRUE(ContainsKey(results[i].anomaly_info(), pair.first));
+      EXPECT_THAT(results[i].anomaly_info().at(pair.first),
+                  testing::EqualsProto(pair.second));
+    }
+  }
+
+  EXPECT_FALSE(skew.FindSkewForEachServing(training, {nullptr},
+                                           /*num_threads=*/1, &results,
+                                           /*feature_errors=*/nullptr)
+                   .ok());
+}
+
 TEST(Schema, FindChangesEmptySchemaProto) {
   const DatasetFeatureStatistics statistics =
       ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
@@ -648,6 +786,43 @@ TEST(SchemaAnomalies, GetSchemaDiffTwoReasons) {
   TestAnomalies(anomalies.GetSchemaDiff(), initial, expected_anomalies);
 }
 
+// The text of a change only has the feature that changed.
+TEST(SchemaAnomalies, GetChangeTexts) {
+  const Schema initial = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: "foo"
+      presence: { min_count: 1 }
+      type: INT
+    }
+    feature {
+      name: "unchanged"
+      type: INT
+    })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'unchanged'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+          }
+        })");
+  SchemaAnomalies anomalies(initial);
+  TF_ASSERT_OK(anomalies.FindChanges(DatasetStatsView(statistics),
+                                     absl::nullopt,
+                                     FeatureStatisticsToProtoConfig()));
+  const std::map<Path, string> change_texts = anomalies.GetChangeTexts();
+  ASSERT_EQ(change_texts.size(), 1);
+  const string& text = change_texts.at(Path({"foo"}));
+  EXPECT_NE(text.find("lifecycle_stage: DEPRECATED"), string::npos);
+  EXPECT_EQ(text.find("unchanged"), string::npos);
+}
+
 TEST(GetSchemaDiff, TwoChanges) {
   const DatasetFeatureStatistics statistics =
       ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
@@ -721,6 +896,125 @@ TEST(GetSchemaDiff, TwoChanges) {
                   FeatureStatisticsToProtoConfig(), expected_anomalies);
 }
 
+// Validating on several threads gives the same anomalies as validating on
+// the calling thread, including anomalies found before by FindSkew.
+TEST(SchemaAnomalies, FindChangesMultipleThreads) {
+  const Schema initial = ParseTextProtoOrDie<Schema>(R"(
+    feature {
+      name: "missing"
+      presence: { min_count: 1 }
+      type: INT
+    }
+    feature {
+      name: "too_many"
+      value_count: { min: 1 max: 1 }
+      type: INT
+      skew_comparator: { infinity_norm: { threshold: 0.1 } }
+    }
+    feature {
+      name: "struct"
+      type: STRUCT
+      struct_domain {
+        feature {
+          name: "child"
+          value_count: { min: 1 max: 1 }
+          type: INT
+        }
+      }
+    })");
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'too_many'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 2
+            }
+          }
+        }
+        features: {
+          name: 'new'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+          }
+        }
+        features: {
+          name: 'struct'
+          type: STRUCT
+          struct_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+          }
+        }
+        features: {
+          name: 'struct.child'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 3
+            }
+          }
+        })");
+  const DatasetFeatureStatistics serving =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'too_many'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+          }
+        })");
+  const DatasetStatsView view(
+      statistics, /*by_weight=*/false, /*environment=*/absl::nullopt,
+      /*previous=*/nullptr,
+      std::make_shared<DatasetStatsView>(serving, /*by_weight=*/false));
+
+  SchemaAnomalies sequential(initial);
+  TF_ASSERT_OK(sequential.FindSkew(view));
+  TF_ASSERT_OK(sequential.FindChanges(view, absl::nullopt,
+                                      FeatureStatisticsToProtoConfig(),
+                                      /*num_threads=*/1));
+  const tensorflow::metadata::v0::Anomalies expected =
+      sequential.GetSchemaDiff();
+  EXPECT_EQ(expected.anomaly_info_size(), 4);
+  for (int num_threads : {2, 4}) {
+    SchemaAnomalies parallel(initial);
+    TF_ASSERT_OK(parallel.FindSkew(view));
+    TF_ASSERT_OK(parallel.FindChanges(
+        view, absl::nullopt, FeatureStatisticsToProtoConfig(), num_threads));
+    const tensorflow::metadata::v0::Anomalies actual =
+        parallel.GetSchemaDiff();
+    EXPECT_THAT(actual.baseline(), testing::EqualsProto(expected.baseline()));
+    // Maps do not have a deterministic serialization, so anomalies are
+    // compared one at a time.
+    ASSERT_EQ(actual.anomaly_info_size(), expected.anomaly_info_size());
+    for (const auto& pair : expected.anomaly_info()) {
+      ASSERT_TRUE(ContainsKey(actual.anomaly_info(), pair.first));
+      EXPECT_THAT(actual.anomaly_info().at(pair.first),
+                  testing::EqualsProto(pair.second));
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace data_validation
@@ -15,11 +15,13 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/schema.h"
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
 #include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
 #include "tensorflow_data_validation/anomalies/statistics_view_test_util.h"
 #include "tensorflow_data_validation/anomalies/test_schema_protos.h"
@@ -631,6 +633,443 @@ TEST(SchemaTest, DeprecateFeature) {
                 })"));
 }
 
+// A schema initialized from a moved proto can be released back into a proto,
+// which leaves it empty.
+TEST(SchemaTest, InitFromMovedProtoAndReleaseSchema) {
+  // The child of a deprecated feature is not required, so it is not
+  // deprecated even if it is missing and considered.
+  tensorflow::metadata::v0::Schema schema_proto =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        feature {
+          name: "parent"
+          type: STRUCT
+          lifecycle_stage: DEPRECATED
+          struct_domain {
+            feature { name: "child" type: INT presence { min_count: 1 } }
+          }
+        }
+        feature { name: "missing" type: INT presence { min_count: 1 } })");
+
+  Schema schema;
+  TF_ASSERT_OK(schema.Init(std::move(schema_proto)));
+  const DatasetFeatureStatistics dataset_statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>("num_examples: 1");
+  DatasetStatsView stats(dataset_statistics, false);
+  TF_ASSERT_OK(schema.Update(stats, FeatureStatisticsToProtoConfig(),
+                             {Path({"parent", "child"}), Path({"missing"})}));
+  tensorflow::metadata::v0::Schema released;
+  schema.ReleaseSchema(&released);
+  EXPECT_TRUE(schema.IsEmpty());
+  EXPECT_THAT(released, EqualsProto(R"(
+                feature {
+                  name: "parent"
+                  type: STRUCT
+                  lifecycle_stage: DEPRECATED
+                  struct_domain {
+                    feature {
+                      name: "child"
+                      type: INT
+                      presence { min_count: 1 }
+                    }
+                  }
+                }
+                feature {
+                  name: "missing"
+                  type: INT
+                  presence { min_count: 1 }
+                  lifecycle_stage: DEPRECATED
+                })"));
+}
+
+// When the struct_domain of a feature is cleared, its children are no longer
+// found.
+TEST(SchemaTest, ClearStructDomainRemovesChildren) {
+  Schema schema;
+  TF_ASSERT_OK(schema.Init(
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        feature {
+          name: "struct"
+          type: INT
+          struct_domain {
+            feature { name: "child" type: INT }
+            sparse_feature { name: "sparse_child" }
+          }
+        })")));
+  EXPECT_TRUE(schema.FeatureExists(Path({"struct", "child"})));
+  EXPECT_TRUE(schema.FeatureExists(Path({"struct", "sparse_child"})));
+
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 1
+        features: {
+          name: 'struct'
+          type: INT
+          num_stats: {
+            common_stats: {
+              num_non_missing: 1
+              max_num_values: 1
+              min_num_values: 1
+            }
+          }
+        })");
+  const DatasetStatsView view(statistics);
+  std::vector<Description> descriptions;
+  tensorflow::metadata::v0::AnomalyInfo::Severity severity;
+  TF_ASSERT_OK(schema.Update(Schema::Updater(FeatureStatisticsToProtoConfig()),
+                             *view.GetByPath(Path({"struct"})), &descriptions,
+                             &severity));
+  EXPECT_TRUE(schema.FeatureExists(Path({"struct"})));
+  EXPECT_FALSE(schema.FeatureExists(Path({"struct", "child"})));
+  EXPECT_FALSE(schema.FeatureExists(Path({"struct", "sparse_child"})));
+}
+
+// An overlay only copies the features it changes (and their ancestors,
+// without their other children), and leaves the base untouched.
+TEST(SchemaTest, OverlayDeprecateFeature) {
+  const tensorflow::metadata::v0::Schema schema_proto =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        feature { name: "foo" type: INT }
+        feature {
+          name: "struct"
+          type: STRUCT
+          struct_domain {
+            feature { name: "bar" type: INT }
+            feature { name: "baz" type: FLOAT }
+          }
+        })");
+  auto base = std::make_shared<Schema>();
+  TF_ASSERT_OK(base->Init(schema_proto));
+
+  Schema overlay;
+  TF_ASSERT_OK(overlay.InitOverlay(base));
+  EXPECT_TRUE(overlay.FeatureExists(Path({"foo"})));
+  EXPECT_FALSE(overlay.FeatureIsDeprecated(Path({"struct", "bar"})));
+  overlay.DeprecateFeature(Path({"struct", "bar"}));
+  EXPECT_TRUE(overlay.FeatureIsDeprecated(Path({"struct", "bar"})));
+  EXPECT_FALSE(overlay.FeatureIsDeprecated(Path({"struct", "baz"})));
+  EXPECT_THAT(overlay.GetSchema(), EqualsProto(R"(
+                feature {
+                  name: "struct"
+                  type: STRUCT
+                  struct_domain {
+                    feature {
+                      name: "bar"
+                      type: INT
+                      lifecycle_stage: DEPRECATED
+                    }
+                  }
+                })"));
+  EXPECT_FALSE(base->FeatureIsDeprecated(Path({"struct", "bar"})));
+  EXPECT_THAT(base->GetSchema(), EqualsProto(schema_proto));
+}
+
+TEST(SchemaTest, OverlayGetChanges) {
+  const tensorflow::metadata::v0::Schema schema_proto =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        default_environment: "TRAINING"
+        feature { name: "foo" type: INT }
+        feature {
+          name: "struct"
+          type: STRUCT
+          struct_domain {
+            feature { name: "bar" type: INT }
+            feature { name: "baz" type: FLOAT }
+          }
+        })");
+  auto base = std::make_shared<Schema>();
+  TF_ASSERT_OK(base->Init(schema_proto));
+  Schema overlay;
+  TF_ASSERT_OK(overlay.InitOverlay(base));
+  overlay.DeprecateFeature(Path({"struct", "bar"}));
+
+  tensorflow::metadata::v0::Schema before;
+  tensorflow::metadata::v0::Schema after;
+  overlay.GetChanges(&before, &after);
+  EXPECT_THAT(before, EqualsProto(R"(
+                feature {
+                  name: "struct"
+                  type: STRUCT
+                  struct_domain { feature { name: "bar" type: INT } }
+                })"));
+  EXPECT_THAT(after, EqualsProto(R"(
+                feature {
+                  name: "struct"
+                  type: STRUCT
+                  struct_domain {
+                    feature {
+                      name: "bar"
+                      type: INT
+                      lifecycle_stage: DEPRECATED
+                    }
+                  }
+                })"));
+}
+
+// A string domain is copied into an overlay when it is updated, and deleting
+// it from the overlay does not delete it from the base.
+TEST(SchemaTest, OverlayStringDomainTooLarge) {
+  const tensorflow::metadata::v0::Schema initial =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        string_domain {
+          name: "MyAloneEnum"
+          value: "4"
+          value: "5"
+          value: "6"
+          value: "ALONE_BUT_NORMAL"
+        }
+        feature {
+          name: "annotated_enum"
+          value_count: { min: 1 max: 1 }
+          type: BYTES
+          domain: "MyAloneEnum"
+        }
+        feature { name: "other" type: INT })");
+  auto base = std::make_shared<Schema>();
+  TF_ASSERT_OK(base->Init(initial));
+  Schema overlay;
+  TF_ASSERT_OK(overlay.InitOverlay(base));
+
+  FeatureStatisticsToProtoConfig config;
+  config.set_enum_threshold(4);
+  config.set_enum_delete_threshold(4);
+  const DatasetFeatureStatistics stats =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(
+          R"(
+            num_examples: 10
+            features {
+              name: 'annotated_enum'
+              type: STRING
+              string_stats: {
+                common_stats: {
+                  num_missing: 0
+                  num_non_missing: 10
+                  min_num_values: 1
+                  max_num_values: 1
+                }
+                rank_histogram {
+                  buckets { label: "a" sample_count: 1 }
+                  buckets { label: "b" sample_count: 2 }
+                  buckets { label: "c" sample_count: 7 }
+                }
+              }
+            })");
+  const DatasetStatsView view(stats);
+  std::vector<Description> descriptions;
+  tensorflow::metadata::v0::AnomalyInfo::Severity severity;
+  TF_ASSERT_OK(overlay.Update(Schema::Updater(config),
+                              *view.GetByPath(Path({"annotated_enum"})),
+                              &descriptions, &severity));
+  EXPECT_EQ(severity, tensorflow::metadata::v0::AnomalyInfo::ERROR);
+  EXPECT_THAT(overlay.GetSchema(), EqualsProto(R"(
+                feature {
+                  name: "annotated_enum"
+                  value_count: { min: 1 max: 1 }
+                  type: BYTES
+                })"));
+  EXPECT_THAT(base->GetSchema(), EqualsProto(initial));
+}
+
+// Precompute() does not change what GetMissingPaths() returns, whether or
+// not the environment is one of the default environments.
+TEST(SchemaTest, PrecomputeGetMissingPaths) {
+  const tensorflow::metadata::v0::Schema initial =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        default_environment: "TRAINING"
+        default_environment: "SERVING"
+        feature {
+          name: "label"
+          not_in_environment: "SERVING"
+          presence: { min_count: 1 }
+          type: INT
+        }
+        feature {
+          name: "other"
+          in_environment: "OTHER"
+          presence: { min_count: 1 }
+          type: INT
+        }
+        feature {
+          name: "struct"
+          presence: { min_count: 1 }
+          type: STRUCT
+          struct_domain {
+            feature {
+              name: "foo"
+              presence: { min_count: 1 }
+              type: INT
+            }
+          }
+        })");
+  Schema schema;
+  TF_ASSERT_OK(schema.Init(initial));
+  Schema precomputed;
+  TF_ASSERT_OK(precomputed.Init(initial));
+  precomputed.Precompute();
+
+  const DatasetFeatureStatistics stats =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features { name: 'struct' type: STRUCT })");
+  for (const absl::optional<string>& environment :
+       {absl::optional<string>(), absl::optional<string>("TRAINING"),
+        absl::optional<string>("SERVING"), absl::optional<string>("OTHER"),
+        absl::optional<string>("UNKNOWN")}) {
+    const DatasetStatsView view(stats, /*by_weight=*/false, environment,
+                                /*previous=*/nullptr, /*serving=*/nullptr);
+    EXPECT_EQ(schema.GetMissingPaths(view), precomputed.GetMissingPaths(view));
+    EXPECT_EQ(schema.GetRequiredFeatures(environment),
+              precomputed.GetRequiredFeatures(environment));
+  }
+  EXPECT_THAT(precomputed.GetRequiredFeatures(string("OTHER")),
+              ::testing::Contains(Path({"other"})));
+  EXPECT_THAT(precomputed.GetRequiredFeatures(string("UNKNOWN")),
+              ::testing::IsEmpty());
+
+  // The required features of the environments that are not given, e.g., by
+  // a CompiledSchemaImage, are computed.
+  Schema from_image;
+  TF_ASSERT_OK(from_image.Init(initial));
+  std::map<absl::optional<string>, std::vector<Path>> required_features;
+  required_features[absl::nullopt] =
+      schema.GetRequiredFeatures(absl::nullopt);
+  from_image.Precompute(std::move(required_features),
+                        ApproximateStringDomainConfig());
+  EXPECT_EQ(schema.GetRequiredFeatures(string("OTHER")),
+            from_image.GetRequiredFeatures(string("OTHER")));
+  const DatasetStatsView serving_view(stats, /*by_weight=*/false, "SERVING",
+                                      /*previous=*/nullptr,
+                                      /*serving=*/nullptr);
+  EXPECT_THAT(precomputed.GetMissingPaths(serving_view),
+              ::testing::AllOf(
+                  ::testing::Contains(Path({"struct", "foo"})),
+                  ::testing::Not(::testing::Contains(Path({"label"})))));
+}
+
+// Modifying a schema after Precompute() discards what was precomputed, so
+// that the required features and the values of the StringDomains follow the
+// modifications.
+TEST(SchemaTest, PrecomputeThenModify) {
+  const tensorflow::metadata::v0::Schema initial =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        string_domain { name: "MyAloneEnum" value: "A" }
+        feature {
+          name: "annotated_enum"
+          value_count: { min: 1 max: 1 }
+          type: BYTES
+          domain: "MyAloneEnum"
+        }
+        feature {
+          name: "required"
+          presence: { min_count: 1 }
+          type: INT
+        })");
+  Schema schema;
+  TF_ASSERT_OK(schema.Init(initial));
+  schema.Precompute();
+
+  const DatasetFeatureStatistics stats =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+            rank_histogram {
+              buckets { label: "A" sample_count: 3 }
+              buckets { label: "C" sample_count: 7 }
+            }
+          }
+        })");
+  const DatasetStatsView view(stats);
+  EXPECT_EQ(std::vector<Path>({Path({"required"})}),
+            schema.GetMissingPaths(view));
+  schema.DeprecateFeature(Path({"required"}));
+  EXPECT_THAT(schema.GetMissingPaths(view), ::testing::IsEmpty());
+  EXPECT_THAT(schema.GetRequiredFeatures(absl::nullopt), ::testing::IsEmpty());
+
+  // The first update adds C to the StringDomain, so the second one finds
+  // nothing wrong.
+  for (const auto expected_severity :
+       {tensorflow::metadata::v0::AnomalyInfo::ERROR,
+        tensorflow::metadata::v0::AnomalyInfo::UNKNOWN}) {
+    std::vector<Description> descriptions;
+    tensorflow::metadata::v0::AnomalyInfo::Severity severity =
+        tensorflow::metadata::v0::AnomalyInfo::UNKNOWN;
+    TF_ASSERT_OK(schema.Update(
+        Schema::Updater(FeatureStatisticsToProtoConfig()),
+        *view.GetByPath(Path({"annotated_enum"})), &descriptions, &severity));
+    EXPECT_EQ(expected_severity, severity);
+  }
+  EXPECT_THAT(schema.GetSchema().string_domain(0), EqualsProto(R"(
+                name: "MyAloneEnum" value: "A" value: "C")"));
+}
+
+// The string domain values precomputed in the base are used to update an
+// overlay, and the base is left unchanged.
+TEST(SchemaTest, PrecomputeOverlayStringDomain) {
+  const tensorflow::metadata::v0::Schema initial =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        string_domain { name: "MyAloneEnum" value: "A" value: "B" }
+        feature {
+          name: "annotated_enum"
+          value_count: { min: 1 max: 1 }
+          type: BYTES
+          domain: "MyAloneEnum"
+        })");
+  auto base = std::make_shared<Schema>();
+  TF_ASSERT_OK(base->Init(initial));
+  base->Precompute();
+
+  const DatasetFeatureStatistics stats =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features {
+          name: 'annotated_enum'
+          type: STRING
+          string_stats: {
+            common_stats: {
+              num_non_missing: 10
+              min_num_values: 1
+              max_num_values: 1
+            }
+            rank_histogram {
+              buckets { label: "A" sample_count: 3 }
+              buckets { label: "C" sample_count: 7 }
+            }
+          }
+        })");
+  const DatasetStatsView view(stats);
+  for (int i = 0; i < 2; ++i) {
+    Schema overlay;
+    TF_ASSERT_OK(overlay.InitOverlay(base));
+    std::vector<Description> descriptions;
+    tensorflow::metadata::v0::AnomalyInfo::Severity severity;
+    TF_ASSERT_OK(overlay.Update(
+        Schema::Updater(FeatureStatisticsToProtoConfig()),
+        *view.GetByPath(Path({"annotated_enum"})), &descriptions, &severity));
+    EXPECT_EQ(severity, tensorflow::metadata::v0::AnomalyInfo::ERROR);
+    EXPECT_THAT(overlay.GetSchema(), EqualsProto(R"(
+                  feature {
+                    name: "annotated_enum"
+                    value_count: { min: 1 max: 1 }
+                    type: BYTES
+                    domain: "MyAloneEnum"
+                  }
+                  string_domain {
+                    name: "MyAloneEnum"
+                    value: "A"
+                    value: "B"
+                    value: "C"
+                  })"));
+  }
+  EXPECT_THAT(base->GetSchema(), EqualsProto(initial));
+}
+
 // For now, just checks if the environments are passed through.
 TEST(SchemaTest, DefaultEnvironments) {
   const tensorflow::metadata::v0::Schema schema_proto =
@@ -2014,6 +2453,93 @@ TEST(SchemaTest, RequiredFeatures) {
                 })"));
 }
 
+// The columns of new features can be computed in parallel. The string
+// domains must then still get the names that a serial update gives them.
+TEST(SchemaTest, UpdateWithThreads) {
+  const DatasetFeatureStatistics statistics =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: "foo"
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 10 max_num_values: 1 }
+            rank_histogram {
+              buckets { label: "a" sample_count: 4 }
+              buckets { label: "b" sample_count: 6 }
+            }
+          }
+        }
+        features: {
+          name: "struct"
+          type: STRUCT
+          struct_stats {
+            common_stats { num_non_missing: 10 max_num_values: 1 }
+          }
+        }
+        features: {
+          name: "struct.foo"
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 10 max_num_values: 1 }
+            rank_histogram {
+              buckets { label: "c" sample_count: 10 }
+            }
+          }
+        }
+        features: {
+          name: "bar"
+          type: INT
+          num_stats: {
+            common_stats: { num_non_missing: 10 max_num_values: 1 }
+          }
+        })");
+  const tensorflow::metadata::v0::Schema initial =
+      ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
+        string_domain { name: "foo" value: "x" })");
+  for (const int num_threads : {1, 4}) {
+    Schema schema;
+    TF_ASSERT_OK(schema.Init(initial));
+    FeatureStatisticsToProtoConfig config;
+    config.set_enum_threshold(10);
+    config.set_num_threads(num_threads);
+    TF_ASSERT_OK(schema.Update(DatasetStatsView(statistics), config));
+    EXPECT_THAT(schema.GetSchema(), EqualsProto(R"(
+                  feature {
+                    name: "foo"
+                    value_count { min: 1 max: 1 }
+                    type: BYTES
+                    domain: "foo2"
+                    presence { min_count: 1 }
+                  }
+                  feature {
+                    name: "struct"
+                    value_count { min: 1 max: 1 }
+                    type: STRUCT
+                    presence { min_count: 1 }
+                    struct_domain {
+                      feature {
+                        name: "foo"
+                        value_count { min: 1 max: 1 }
+                        type: BYTES
+                        domain: "struct.foo"
+                        presence { min_count: 1 }
+                      }
+                    }
+                  }
+                  feature {
+                    name: "bar"
+                    value_count { min: 1 max: 1 }
+                    type: INT
+                    presence { min_count: 1 }
+                  }
+                  string_domain { name: "foo" value: "x" }
+                  string_domain { name: "foo2" value: "a" value: "b" }
+                  string_domain { name: "struct.foo" value: "c" })"))
+        << "num_threads: " << num_threads;
+  }
+}
+
 // As requested in b/62826201, if the data is always present, then even if it
 // is a repeated field, we infer that it will always be there in the future.
 TEST(SchemaTest, RequiredRepeatedFeatures) {
@@ -2532,6 +3058,43 @@ TEST(Schema, GetRelatedEnums) {
                 })"));
 }
 
+// With many enums, GetRelatedEnums() only compares the pairs of enums found
+// by locality-sensitive hashing, which here finds the same ones.
+TEST(Schema, GetRelatedEnumsWithLsh) {
+  DatasetFeatureStatistics statistics;
+  for (int feature = 0; feature < 20; ++feature) {
+    tensorflow::metadata::v0::FeatureNameStatistics* feature_stats =
+        statistics.add_features();
+    feature_stats->set_name(absl::StrCat("field_", feature));
+    feature_stats->set_type(
+        tensorflow::metadata::v0::FeatureNameStatistics::STRING);
+    tensorflow::metadata::v0::StringStatistics* string_stats =
+        feature_stats->mutable_string_stats();
+    string_stats->mutable_common_stats()->set_min_num_values(1);
+    string_stats->mutable_common_stats()->set_max_num_values(1);
+    // Features 2k and 2k+1 have similar values, with a Jaccard similarity
+    // of 0.8. Features with different k have none in common. The values are
+    // not numbers, so each feature gets a string domain.
+    const int first_value = (feature / 2) * 100 + (feature % 2) * 2;
+    for (int value = first_value; value < first_value + 18; ++value) {
+      string_stats->mutable_rank_histogram()->add_buckets()->set_label(
+          absl::StrCat("value_", value));
+    }
+  }
+  FeatureStatisticsToProtoConfig exact_config =
+      ParseTextProtoOrDie<FeatureStatisticsToProtoConfig>(
+          R"(enum_threshold: 400)");
+  FeatureStatisticsToProtoConfig lsh_config = exact_config;
+  lsh_config.mutable_enums_similar_config()->set_lsh_min_num_enums(0);
+  TF_ASSERT_OK(Schema::GetRelatedEnums(DatasetStatsView(statistics, false),
+                                       &exact_config));
+  TF_ASSERT_OK(Schema::GetRelatedEnums(DatasetStatsView(statistics, false),
+                                       &lsh_config));
+  EXPECT_EQ(10, exact_config.column_constraint_size());
+  lsh_config.clear_enums_similar_config();
+  EXPECT_THAT(lsh_config, EqualsProto(exact_config));
+}
+
 TEST(Schema, MissingColumns) {
   const tensorflow::metadata::v0::Schema initial =
       ParseTextProtoOrDie<tensorflow::metadata::v0::Schema>(R"(
@@ -0,0 +1,159 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/statistics_merger.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow_data_validation/anomalies/wire_reader.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using metadata::v0::CommonStatistics;
+using metadata::v0::DatasetFeatureStatistics;
+using metadata::v0::DatasetFeatureStatisticsList;
+using metadata::v0::FeatureNameStatistics;
+
+void AppendVarint(uint64 value, string* output) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+void AppendTag(int field, int wire_type, string* output) {
+  AppendVarint((static_cast<uint64>(field) << 3) | wire_type, output);
+}
+
+void AppendLengthDelimited(int field, absl::string_view value,
+                           string* output) {
+  AppendTag(field, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, output);
+  AppendVarint(value.size(), output);
+  output->append(value.data(), value.size());
+}
+
+// Reads the name of a serialized FeatureNameStatistics, which is that of its
+// last name field. Returns false if the message is malformed.
+bool ReadFeatureName(absl::string_view feature, absl::string_view* name) {
+  *name = absl::string_view();
+  WireReader reader(feature);
+  while (!reader.done()) {
+    int field, wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    if (field == FeatureNameStatistics::kNameFieldNumber &&
+        wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!reader.ReadLengthDelimited(name)) {
+        return false;
+      }
+    } else if (!reader.SkipValue(wire_type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the common statistics of feature that set the number of examples,
+// or null if there are none.
+const CommonStatistics* GetCommonStatistics(
+    const FeatureNameStatistics& feature) {
+  if (feature.stats_case() == FeatureNameStatistics::kNumStats) {
+    return feature.num_stats().has_common_stats()
+               ? &feature.num_stats().common_stats()
+               : nullptr;
+  }
+  return feature.string_stats().has_common_stats()
+             ? &feature.string_stats().common_stats()
+             : nullptr;
+}
+
+}  // namespace
+
+Status MergeDatasetFeatureStatistics(
+    const std::vector<absl::string_view>& serialized_statistics,
+    string* serialized_statistics_list) {
+  // The merged statistics of each feature, in the order in which the
+  // features first appear, and the index of each feature name.
+  std::vector<string> features;
+  absl::flat_hash_map<string, size_t> feature_indices;
+  for (size_t i = 0; i < serialized_statistics.size(); ++i) {
+    WireReader reader(serialized_statistics[i]);
+    while (!reader.done()) {
+      int field, wire_type;
+      if (!reader.ReadTag(&field, &wire_type)) {
+        return errors::InvalidArgument("Cannot parse statistics ", i);
+      }
+      if (field != DatasetFeatureStatistics::kFeaturesFieldNumber ||
+          wire_type != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+        if (!reader.SkipValue(wire_type)) {
+          return errors::InvalidArgument("Cannot parse statistics ", i);
+        }
+        continue;
+      }
+      absl::string_view feature;
+      absl::string_view name;
+      if (!reader.ReadLengthDelimited(&feature) ||
+          !ReadFeatureName(feature, &name)) {
+        return errors::InvalidArgument("Cannot parse statistics ", i);
+      }
+      const auto inserted =
+          feature_indices.emplace(string(name), features.size());
+      if (inserted.second) {
+        features.emplace_back(feature);
+      } else {
+        features[inserted.first->second].append(feature.data(),
+                                                feature.size());
+      }
+    }
+  }
+
+  uint64 num_examples = 0;
+  for (const string& feature : features) {
+    FeatureNameStatistics merged_feature;
+    if (!merged_feature.ParseFromString(feature)) {
+      return errors::InvalidArgument("Cannot parse merged statistics of a "
+                                     "feature.");
+    }
+    const CommonStatistics* common_stats = GetCommonStatistics(merged_feature);
+    if (common_stats != nullptr) {
+      num_examples =
+          common_stats->num_non_missing() + common_stats->num_missing();
+      break;
+    }
+  }
+
+  string dataset;
+  if (num_examples != 0) {
+    AppendTag(DatasetFeatureStatistics::kNumExamplesFieldNumber,
+              WireFormatLite::WIRETYPE_VARINT, &dataset);
+    AppendVarint(num_examples, &dataset);
+  }
+  for (const string& feature : features) {
+    AppendLengthDelimited(DatasetFeatureStatistics::kFeaturesFieldNumber,
+                          feature, &dataset);
+  }
+  serialized_statistics_list->clear();
+  AppendLengthDelimited(DatasetFeatureStatisticsList::kDatasetsFieldNumber,
+                        dataset, serialized_statistics_list);
+  return Status::OK();
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,50 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A merge of the DatasetFeatureStatistics protos output by the statistics
+// generators, used by GenerateStatisticsImpl in statistics/stats_impl.py.
+//
+// The protos are merged in their serialized form: as parsing the
+// concatenation of serialized messages is the same as merging them with
+// MergeFrom(), the statistics of a feature are merged by concatenating them,
+// and only the feature names are read.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_STATISTICS_MERGER_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_STATISTICS_MERGER_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// Merges serialized DatasetFeatureStatistics protos into a serialized
+// DatasetFeatureStatisticsList proto with a single dataset, which holds the
+// features of the inputs and no other field but num_examples. The statistics
+// of each feature are merged, as with MergeFrom(), in the order of the
+// inputs, and the features are in the order in which they first appear.
+// num_examples is that of the first feature with common statistics in its
+// num_stats or its string_stats. Returns InvalidArgument if an input cannot
+// be parsed.
+Status MergeDatasetFeatureStatistics(
+    const std::vector<absl::string_view>& serialized_statistics,
+    string* serialized_statistics_list);
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_STATISTICS_MERGER_H_
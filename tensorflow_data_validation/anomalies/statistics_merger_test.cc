@@ -0,0 +1,165 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/statistics_merger.h"
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using metadata::v0::DatasetFeatureStatistics;
+using metadata::v0::DatasetFeatureStatisticsList;
+using testing::EqualsProto;
+using testing::ParseTextProtoOrDie;
+
+// Merges DatasetFeatureStatistics given as text protos.
+DatasetFeatureStatisticsList Merge(const std::vector<string>& text_protos) {
+  std::vector<string> serialized;
+  for (const string& text_proto : text_protos) {
+    serialized.push_back(ParseTextProtoOrDie<DatasetFeatureStatistics>(
+                             text_proto)
+                             .SerializeAsString());
+  }
+  string merged;
+  TF_CHECK_OK(MergeDatasetFeatureStatistics(
+      std::vector<absl::string_view>(serialized.begin(), serialized.end()),
+      &merged));
+  DatasetFeatureStatisticsList result;
+  CHECK(result.ParseFromString(merged));
+  return result;
+}
+
+TEST(StatisticsMergerTest, MergesFeaturesByName) {
+  EXPECT_THAT(Merge({R"(
+                num_examples: 7
+                features {
+                  name: 'feature1'
+                  type: STRING
+                  string_stats {
+                    common_stats { num_missing: 3 num_non_missing: 4 }
+                  }
+                }
+                features {
+                  name: 'feature2'
+                  type: INT
+                  num_stats { mean: 1.5 histograms { num_nan: 1 } }
+                })",
+                     R"(
+                features {
+                  name: 'feature2'
+                  num_stats { max: 2 histograms { num_nan: 2 } }
+                  custom_stats { name: 'c' num: 1 }
+                }
+                features {
+                  name: 'feature1'
+                  type: STRING
+                  string_stats { unique: 3 }
+                })"}),
+              EqualsProto(R"(
+                datasets {
+                  num_examples: 7
+                  features {
+                    name: 'feature1'
+                    type: STRING
+                    string_stats {
+                      common_stats { num_missing: 3 num_non_missing: 4 }
+                      unique: 3
+                    }
+                  }
+                  features {
+                    name: 'feature2'
+                    type: INT
+                    num_stats {
+                      mean: 1.5
+                      max: 2
+                      histograms { num_nan: 1 }
+                      histograms { num_nan: 2 }
+                    }
+                    custom_stats { name: 'c' num: 1 }
+                  }
+                })"));
+}
+
+TEST(StatisticsMergerTest, TakesNumExamplesFromTheFirstCommonStats) {
+  // The input num_examples and the other dataset fields are dropped.
+  EXPECT_THAT(Merge({R"(
+                name: 'dataset'
+                num_examples: 10
+                features { name: 'a' bytes_stats { unique: 1 } }
+                features { name: 'b' string_stats { unique: 1 } }
+                features {
+                  name: 'c'
+                  num_stats {
+                    common_stats { num_missing: 1 num_non_missing: 2 }
+                  }
+                }
+                features {
+                  name: 'd'
+                  string_stats {
+                    common_stats { num_missing: 5 num_non_missing: 5 }
+                  }
+                })"}),
+              EqualsProto(R"(
+                datasets {
+                  num_examples: 3
+                  features { name: 'a' bytes_stats { unique: 1 } }
+                  features { name: 'b' string_stats { unique: 1 } }
+                  features {
+                    name: 'c'
+                    num_stats {
+                      common_stats { num_missing: 1 num_non_missing: 2 }
+                    }
+                  }
+                  features {
+                    name: 'd'
+                    string_stats {
+                      common_stats { num_missing: 5 num_non_missing: 5 }
+                    }
+                  }
+                })"));
+}
+
+TEST(StatisticsMergerTest, MergesNothing) {
+  EXPECT_THAT(Merge({}), EqualsProto("datasets {}"));
+  EXPECT_THAT(Merge({""}), EqualsProto("datasets {}"));
+}
+
+TEST(StatisticsMergerTest, FailsOnInvalidStatistics) {
+  string merged;
+  // A features field that is longer than the input.
+  EXPECT_FALSE(
+      MergeDatasetFeatureStatistics({absl::string_view("\x1a\x05\x0a", 3)},
+                                    &merged)
+          .ok());
+  // A feature with a truncated name.
+  EXPECT_FALSE(MergeDatasetFeatureStatistics(
+                   {absl::string_view("\x1a\x02\x0a\x05", 4)}, &merged)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
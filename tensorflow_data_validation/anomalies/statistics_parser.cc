@@ -0,0 +1,128 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/statistics_parser.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/wire_reader.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+namespace {
+
+using ::tensorflow::metadata::v0::DatasetFeatureStatistics;
+using ::tensorflow::metadata::v0::FeatureNameStatistics;
+
+// The numbers of the fields that are read by the scan.
+constexpr int kFeaturesFieldNumber = 3;  // DatasetFeatureStatistics.features
+constexpr int kNameFieldNumber = 1;      // FeatureNameStatistics.name
+constexpr int kTypeFieldNumber = 2;      // FeatureNameStatistics.type
+
+Status ParseError() {
+  return errors::InvalidArgument(
+      "Failed to parse DatasetFeatureStatistics proto.");
+}
+
+// Reads the name and type of a serialized FeatureNameStatistics. As when
+// parsing, if a field appears several times, the last value is used.
+bool ScanFeature(absl::string_view feature, absl::string_view* name,
+                 FeatureNameStatistics::Type* type) {
+  *name = absl::string_view();
+  *type = FeatureNameStatistics::INT;
+  WireReader reader(feature);
+  while (!reader.done()) {
+    int field, wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return false;
+    }
+    if (field == kNameFieldNumber &&
+        wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      if (!reader.ReadLengthDelimited(name)) {
+        return false;
+      }
+    } else if (field == kTypeFieldNumber &&
+               wire_type == WireFormatLite::WIRETYPE_VARINT) {
+      uint64 value;
+      if (!reader.ReadVarint(&value)) {
+        return false;
+      }
+      *type = static_cast<FeatureNameStatistics::Type>(value);
+    } else if (!reader.SkipValue(wire_type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status ParseStatisticsOfFeatures(absl::string_view serialized,
+                                 const FeatureFilter& should_parse,
+                                 DatasetFeatureStatistics* statistics) {
+  // The fields other than the features are copied as they are, and parsed
+  // together at the end.
+  string other_fields;
+  std::vector<absl::string_view> features;
+  WireReader reader(serialized);
+  while (!reader.done()) {
+    const absl::string_view field_start = reader.remaining();
+    int field, wire_type;
+    if (!reader.ReadTag(&field, &wire_type)) {
+      return ParseError();
+    }
+    if (field == kFeaturesFieldNumber &&
+        wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      absl::string_view feature;
+      absl::string_view name;
+      FeatureNameStatistics::Type type;
+      if (!reader.ReadLengthDelimited(&feature) ||
+          !ScanFeature(feature, &name, &type)) {
+        return ParseError();
+      }
+      if (should_parse(name, type)) {
+        features.push_back(feature);
+      }
+    } else {
+      if (!reader.SkipValue(wire_type)) {
+        return ParseError();
+      }
+      const absl::string_view field_bytes = field_start.substr(
+          0, field_start.size() - reader.remaining().size());
+      other_fields.append(field_bytes.data(), field_bytes.size());
+    }
+  }
+  if (!statistics->ParseFromString(other_fields)) {
+    return ParseError();
+  }
+  statistics->mutable_features()->Reserve(features.size());
+  for (const absl::string_view feature : features) {
+    if (!statistics->add_features()->ParseFromArray(feature.data(),
+                                                    feature.size())) {
+      return ParseError();
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,47 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_STATISTICS_PARSER_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_STATISTICS_PARSER_H_
+
+#include <functional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// Returns true if the feature with the given name and type should be parsed.
+using FeatureFilter = std::function<bool(
+    absl::string_view name,
+    metadata::v0::FeatureNameStatistics::Type type)>;
+
+// Parses a serialized DatasetFeatureStatistics proto, but only the
+// FeatureNameStatistics for which should_parse returns true. The other
+// features are skipped by a scan of the wire format, which only reads their
+// name and type, and are left out of *statistics. Everything else is parsed
+// as usual.
+Status ParseStatisticsOfFeatures(absl::string_view serialized,
+                                 const FeatureFilter& should_parse,
+                                 metadata::v0::DatasetFeatureStatistics*
+                                     statistics);
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_STATISTICS_PARSER_H_
@@ -0,0 +1,117 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/statistics_parser.h"
+
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::tensorflow::metadata::v0::DatasetFeatureStatistics;
+using ::tensorflow::metadata::v0::FeatureNameStatistics;
+using testing::EqualsProto;
+using testing::ParseTextProtoOrDie;
+
+DatasetFeatureStatistics GetStatistics() {
+  return ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+    name: 'dataset'
+    num_examples: 10
+    weighted_num_examples: 7.5
+    features {
+      name: 'foo'
+      type: INT
+      num_stats: { common_stats: { num_missing: 3 max_num_values: 2 } }
+    }
+    features {
+      name: 'bar'
+      type: STRUCT
+      struct_stats: { common_stats: { num_non_missing: 10 } }
+    }
+    features {
+      name: 'bar.baz'
+      type: STRING
+      string_stats: {
+        common_stats: { num_non_missing: 5 }
+        rank_histogram: { buckets: { label: "a" sample_count: 5 } }
+      }
+    })");
+}
+
+TEST(StatisticsParserTest, ParseAllFeatures) {
+  const DatasetFeatureStatistics expected = GetStatistics();
+  DatasetFeatureStatistics statistics;
+  TF_ASSERT_OK(ParseStatisticsOfFeatures(
+      expected.SerializeAsString(),
+      [](absl::string_view, FeatureNameStatistics::Type) { return true; },
+      &statistics));
+  EXPECT_THAT(statistics, EqualsProto(expected));
+}
+
+TEST(StatisticsParserTest, ParseSomeFeatures) {
+  DatasetFeatureStatistics expected = GetStatistics();
+  expected.mutable_features()->DeleteSubrange(0, 1);
+  expected.mutable_features()->DeleteSubrange(1, 1);
+  DatasetFeatureStatistics statistics;
+  TF_ASSERT_OK(ParseStatisticsOfFeatures(
+      GetStatistics().SerializeAsString(),
+      [](absl::string_view name, FeatureNameStatistics::Type type) {
+        return name != "foo" && type == FeatureNameStatistics::STRUCT;
+      },
+      &statistics));
+  EXPECT_THAT(statistics, EqualsProto(expected));
+}
+
+TEST(StatisticsParserTest, ParseNoFeatures) {
+  DatasetFeatureStatistics expected = GetStatistics();
+  expected.clear_features();
+  // Also replaces what was in statistics.
+  DatasetFeatureStatistics statistics = GetStatistics();
+  TF_ASSERT_OK(ParseStatisticsOfFeatures(
+      GetStatistics().SerializeAsString(),
+      [](absl::string_view, FeatureNameStatistics::Type) { return false; },
+      &statistics));
+  EXPECT_THAT(statistics, EqualsProto(expected));
+}
+
+TEST(StatisticsParserTest, InvalidStatistics) {
+  const string serialized = GetStatistics().SerializeAsString();
+  DatasetFeatureStatistics statistics;
+  for (const string& invalid :
+       {string("not a statistics proto"),
+        serialized.substr(0, serialized.size() - 1)}) {
+    EXPECT_FALSE(
+        ParseStatisticsOfFeatures(
+            invalid,
+            [](absl::string_view, FeatureNameStatistics::Type) {
+              return false;
+            },
+            &statistics)
+            .ok());
+  }
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -15,12 +15,20 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/call_once.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "tensorflow_data_validation/anomalies/map_util.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 namespace tensorflow {
@@ -35,6 +43,27 @@ const bool IsStrictPrefix(const string& a, const string& b) {
   return a.length() < b.length() && b.substr(0, a.length()) == a;
 }
 
+// The custom statistics that the statistics generators add to the features of
+// statistics computed over a sample of the examples.
+constexpr char kSampleRateCustomStat[] = "sample_rate";
+constexpr char kNumNonMissingUpperBoundCustomStat[] =
+    "num_non_missing_upper_bound";
+
+// Returns the numeric value of the custom statistic of feature named name, if
+// it has one.
+absl::optional<double> GetNumericCustomStat(
+    const FeatureNameStatistics& feature, absl::string_view name) {
+  for (const tensorflow::metadata::v0::CustomStatistic& custom_stat :
+       feature.custom_stats()) {
+    if (custom_stat.name() == name &&
+        custom_stat.val_case() ==
+            tensorflow::metadata::v0::CustomStatistic::kNum) {
+      return custom_stat.num();
+    }
+  }
+  return absl::nullopt;
+}
+
 }  // namespace
 
 // Context of a feature.
@@ -46,86 +75,166 @@ struct FeatureContext {
   Path path;
 };
 
+// The structure of the features of a DatasetFeatureStatistics. It does not
+// depend on the weighting, so the weighted and unweighted views of the same
+// statistics share it (see DatasetStatsView::WithByWeight()).
+struct FeatureIndex {
+  explicit FeatureIndex(const DatasetFeatureStatistics& data);
+
+  // Context of each feature: parents and children.
+  // parallel to features() array in data.
+  std::vector<FeatureContext> context;
+
+  // Map from path to the index of the FeatureStatistics containing the
+  // statistics for that path.
+  absl::flat_hash_map<Path, int> path_location;
+
+  // The indices of all the features, and of those without a parent, in
+  // increasing order, for the ranges of features.
+  std::vector<int> feature_indices;
+  std::vector<int> root_indices;
+};
+
+// The string values of the features of a DatasetFeatureStatistics, computed
+// on demand. They depend on the weighting, but not on the environment,
+// previous or serving statistics, so views that only differ in those share
+// them (see DatasetStatsView::WithServing() and WithPrevious()).
+struct StringValuesCache {
+  // A value that is computed by the first call that requests it. As views can
+  // be shared across threads, concurrent calls for the same entry wait for
+  // that one, but calls for other entries do not.
+  template <typename T>
+  struct Entry {
+    absl::once_flag once;
+    // Never changed once set, so references to it stay valid.
+    std::unique_ptr<const T> value;
+  };
+
+  explicit StringValuesCache(int num_features)
+      : string_values(num_features), parsed_string_values(num_features) {}
+
+  // The result of GetStringValuesWithCounts() for each feature. Parallel to
+  // features() array in data.
+  std::vector<Entry<std::map<string, double>>> string_values;
+
+  // The result of GetParsedStringValues() for each feature. Parallel to
+  // features() array in data.
+  std::vector<Entry<ParsedStringValues>> parsed_string_values;
+};
+
+FeatureIndex::FeatureIndex(const DatasetFeatureStatistics& data) {
+  // It takes O(n log n) time to sort the locations of the features in
+  // data.features() by name. If several features have the same name,
+  // only the last one is kept. The others have an empty path and no
+  // parent or children.
+  std::vector<int> sorted(data.features_size());
+  for (int i = 0; i < data.features_size(); ++i) {
+    sorted[i] = i;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), [&data](int a, int b) {
+    return data.features(a).name() < data.features(b).name();
+  });
+  std::vector<int> location;
+  location.reserve(sorted.size());
+  for (int index : sorted) {
+    if (!location.empty() && data.features(location.back()).name() ==
+                                 data.features(index).name()) {
+      location.back() = index;
+    } else {
+      location.push_back(index);
+    }
+  }
+  context.resize(data.features_size());
+  path_location.reserve(location.size());
+
+  // After we sort the features, we iterate over the names of features
+  // alphabetically. Note that:
+  // If feature a is right after feature b alphabetically, the ancestors
+  // of feature b are a subset of the ancestors of feature a and possibly
+  // feature a itself.
+  // Since current_ancestors stores the ancestors by increasing name length,
+  // then the last of the current ancestors is the parent of the next field.
+  // Moreover, since every ancestor is added from current_ancestors once,
+  // and removed from the list once, the runtime of this whole operation
+  // is O(# features)
+  std::vector<int> current_ancestors;
+
+  for (int index : location) {
+    const string& name = data.features(index).name();
+    while (!current_ancestors.empty() &&
+           !IsStrictPrefix(data.features(current_ancestors.back()).name(),
+                           name)) {
+      current_ancestors.pop_back();
+    }
+    if (!current_ancestors.empty()) {
+      int parent_index = current_ancestors.back();
+      const string& parent_name = data.features(parent_index).name();
+      const string& name = data.features(index).name();
+      context[index].parent_index = parent_index;
+      context[index].path = context[parent_index].path.GetChild(
+          absl::string_view(name).substr(parent_name.size() + 1));
+      context[parent_index].child_indices.push_back(index);
+    } else {
+      context[index].path = Path({data.features(index).name()});
+    }
+    path_location[context[index].path] = index;
+    if (data.features(index).type() ==
+        tensorflow::metadata::v0::FeatureNameStatistics::STRUCT) {
+      current_ancestors.push_back(index);
+    }
+  }
+  feature_indices.resize(data.features_size());
+  for (int i = 0; i < data.features_size(); ++i) {
+    feature_indices[i] = i;
+    if (!context[i].parent_index) {
+      root_indices.push_back(i);
+    }
+  }
+}
+
 // A class that summarizes the information from the DatasetFeatureStatistics.
-// Takes O(#features log #features) time to initialize,
-// O(# features) space, and:
-// GetRootFeatures() takes O(# features) time
+// Takes O(#features log #features) time to initialize (O(#features) if the
+// FeatureIndex is shared), O(# features) space, and:
+// GetRootFeatures() takes O(# root features) time
 // GetChildren() takes O(# children) time
 // GetParent() takes O(1) time
-// GetByPath() takes O(log # features) time.
+// GetByPath() takes O(1) expected time.
 class DatasetStatsViewImpl {
  public:
-  DatasetStatsViewImpl(const DatasetFeatureStatistics& data, bool by_weight,
+  // If index is null, it is built from data. Otherwise, it must be the index
+  // of data. Likewise, if string_values is null, it is created empty.
+  // Otherwise, it must be the cache of a view of data with the same
+  // by_weight.
+  DatasetStatsViewImpl(std::shared_ptr<const DatasetFeatureStatistics> data,
+                       bool by_weight,
                        const absl::optional<string>& environment,
                        const std::shared_ptr<DatasetStatsView>& previous,
-                       const std::shared_ptr<DatasetStatsView>& serving)
-      : data_(data),
+                       const std::shared_ptr<DatasetStatsView>& serving,
+                       std::shared_ptr<const FeatureIndex> index,
+                       std::shared_ptr<StringValuesCache> string_values)
+      : data_(std::move(data)),
         by_weight_(by_weight),
         environment_(environment),
         previous_(previous),
-        serving_(serving) {
-    // It takes O(n log n) time to construct location, a BST from the name
-    // of a feature to its location in data_.features().
-    // Map from name to location.
-    // data_.features(location[foo]).name() == foo
-    std::map<string, int> location;
-
-    for (int i = 0; i < data_.features_size(); ++i) {
-      location[data_.features(i).name()] = i;
-      context_.push_back(FeatureContext());
-    }
-
-    // After we construct the map, we iterate over the names of features
-    // alphabetically. Note that:
-    // If feature a is right after feature b alphabetically, the ancestors
-    // of feature b are a subset of the ancestors of feature a and possibly
-    // feature a itself.
-    // Since current_ancestors stores the ancestors by increasing name length,
-    // then the last of the current ancestors is the parent of the next field.
-    // Moreover, since every ancestor is added from current_ancestors once,
-    // and removed from the list once, the runtime of this whole operation
-    // is O(# features)
-    std::vector<int> current_ancestors;
-
-    for (const auto& pair : location) {
-      const string& name = pair.first;
-      int index = pair.second;
-      while (!current_ancestors.empty() &&
-             !IsStrictPrefix(data_.features()[current_ancestors.back()].name(),
-                             name)) {
-        current_ancestors.pop_back();
-      }
-      if (!current_ancestors.empty()) {
-        int parent_index = current_ancestors.back();
-        const string& parent_name = data_.features(parent_index).name();
-        const string& name = data_.features(index).name();
-        context_[index].parent_index = parent_index;
-        context_[index].path = context_[parent_index].path.GetChild(
-            name.substr(parent_name.size() + 1));
-        context_[parent_index].child_indices.push_back(index);
-      } else {
-        context_[index].path = Path({data_.features(index).name()});
-      }
-      path_location_[context_[index].path] = index;
-      if (data_.features(index).type() ==
-          tensorflow::metadata::v0::FeatureNameStatistics::STRUCT) {
-        current_ancestors.push_back(index);
-      }
-    }
-  }
+        serving_(serving),
+        index_(index != nullptr ? std::move(index)
+                                : std::make_shared<const FeatureIndex>(
+                                      *CHECK_NOTNULL(data_.get()))),
+        string_values_(string_values != nullptr
+                           ? std::move(string_values)
+                           : std::make_shared<StringValuesCache>(
+                                 data_->features_size())) {}
 
-  const DatasetFeatureStatistics& data() const { return data_; }
+  const DatasetFeatureStatistics& data() const { return *data_; }
 
   absl::optional<FeatureStatsView> GetByPath(const DatasetStatsView& view,
                                              const Path& path) const {
-    auto ref = path_location_.find(path);
-    if (ref == path_location_.end()) {
-      VLOG(0) << "DatasetStatsViewImpl::GetByPath() can't find: "
+    auto ref = index_->path_location.find(path);
+    if (ref == index_->path_location.end()) {
+      // Misses are expected, e.g., for the features of the current
+      // statistics that are missing from the previous ones.
+      VLOG(1) << "DatasetStatsViewImpl::GetByPath() can't find: "
               << path.Serialize();
-      for (const FeatureStatsView& feature_view : view.features()) {
-        VLOG(0) << "  DatasetStatsViewImpl::GetByPath(): path: "
-                << feature_view.GetPath().Serialize();
-      }
       return absl::nullopt;
     } else {
       return FeatureStatsView(ref->second, view);
@@ -133,12 +242,13 @@ class DatasetStatsViewImpl {
   }
 
   const Path& GetPath(const FeatureStatsView& view) const {
-    return context_[view.index_].path;
+    return index_->context[view.index_].path;
   }
 
   absl::optional<FeatureStatsView> GetParent(
       const FeatureStatsView& view) const {
-    absl::optional<int> opt_parent_index = context_[view.index_].parent_index;
+    absl::optional<int> opt_parent_index =
+        index_->context[view.index_].parent_index;
     if (opt_parent_index) {
       return FeatureStatsView(*opt_parent_index, view.parent_view_);
     } else {
@@ -146,19 +256,55 @@ class DatasetStatsViewImpl {
     }
   }
 
-  std::vector<FeatureStatsView> GetChildren(
+  const std::vector<int>& GetChildIndices(const FeatureStatsView& view) const {
+    return index_->context[view.index_].child_indices;
+  }
+
+  const std::map<string, double>& GetStringValuesWithCounts(
       const FeatureStatsView& view) const {
-    std::vector<FeatureStatsView> result;
-    for (int i : context_[view.index_].child_indices) {
-      result.emplace_back(i, view.parent_view_);
-    }
-    return result;
+    StringValuesCache::Entry<std::map<string, double>>& entry =
+        string_values_->string_values[view.index_];
+    absl::call_once(entry.once, [this, &view, &entry]() {
+      auto string_values = absl::make_unique<std::map<string, double>>();
+      const tensorflow::metadata::v0::RankHistogram& histogram =
+          by_weight_ ? view.data()
+                           .string_stats()
+                           .weighted_string_stats()
+                           .rank_histogram()
+                     : view.data().string_stats().rank_histogram();
+      for (const tensorflow::metadata::v0::RankHistogram::Bucket& bucket :
+           histogram.buckets()) {
+        string_values->insert({bucket.label(), bucket.sample_count()});
+      }
+      entry.value = std::move(string_values);
+    });
+    return *entry.value;
+  }
+
+  const ParsedStringValues& GetParsedStringValues(
+      const FeatureStatsView& view) const {
+    StringValuesCache::Entry<ParsedStringValues>& entry =
+        string_values_->parsed_string_values[view.index_];
+    absl::call_once(entry.once, [this, &view, &entry]() {
+      const std::map<string, double>& string_values =
+          GetStringValuesWithCounts(view);
+      std::vector<absl::string_view> values;
+      values.reserve(string_values.size());
+      for (const auto& pair : string_values) {
+        values.push_back(pair.first);
+      }
+      entry.value =
+          absl::make_unique<ParsedStringValues>(ParseStringValues(values));
+    });
+    return *entry.value;
   }
 
  private:
+
   friend DatasetStatsView;
-  // Underlying data.
-  const DatasetFeatureStatistics data_;
+  // Underlying data. Either a private copy, or shared with the caller (see
+  // the DatasetStatsView constructors). Never null.
+  const std::shared_ptr<const DatasetFeatureStatistics> data_;
 
   // Whether DatasetFeatureStatistics is accessed by weight or not.
   const bool by_weight_;
@@ -176,13 +322,15 @@ class DatasetStatsViewImpl {
 
   /*********** Cached information below, derivable from data_ *****************/
 
-  // Context of each feature: parents and children.
-  // parallel to features() array in data.
-  std::vector<FeatureContext> context_;
+  // The structure of the features. Never null.
+  const std::shared_ptr<const FeatureIndex> index_;
 
-  // Map from path to the index of the FeatureStatistics containing the
-  // statistics for that path.
-  std::map<Path, int> path_location_;
+  /*********** Cached information below, computed on demand *******************/
+
+  // The string values of the features. Never null. Shared by the views of
+  // data with the same by_weight_ (see DatasetStatsView::WithServing() and
+  // WithPrevious()).
+  const std::shared_ptr<StringValuesCache> string_values_;
 };
 
 DatasetStatsView::DatasetStatsView(const DatasetFeatureStatistics& data,
@@ -190,29 +338,82 @@ DatasetStatsView::DatasetStatsView(const DatasetFeatureStatistics& data,
                                    const absl::optional<string>& environment,
                                    std::shared_ptr<DatasetStatsView> previous,
                                    std::shared_ptr<DatasetStatsView> serving)
-    : impl_(new DatasetStatsViewImpl(data, by_weight, environment, previous,
-                                     serving)) {}
+    : DatasetStatsView(std::make_shared<const DatasetFeatureStatistics>(data),
+                       by_weight, environment, std::move(previous),
+                       std::move(serving)) {}
 
 DatasetStatsView::DatasetStatsView(const DatasetFeatureStatistics& data,
                                    bool by_weight)
-    : impl_(new DatasetStatsViewImpl(data, by_weight, absl::nullopt,
-                                     std::shared_ptr<DatasetStatsView>(),
-                                     std::shared_ptr<DatasetStatsView>())) {}
+    : DatasetStatsView(std::make_shared<const DatasetFeatureStatistics>(data),
+                       by_weight) {}
 
 DatasetStatsView::DatasetStatsView(
     const tensorflow::metadata::v0::DatasetFeatureStatistics& data)
-    : impl_(new DatasetStatsViewImpl(data, false, absl::nullopt,
-                                     std::shared_ptr<DatasetStatsView>(),
-                                     std::shared_ptr<DatasetStatsView>())) {}
+    : DatasetStatsView(data, false) {}
 
-std::vector<FeatureStatsView> DatasetStatsView::features() const {
-  std::vector<FeatureStatsView> result;
-  for (int i = 0; i < impl_->data().features_size(); ++i) {
-    result.push_back(FeatureStatsView(i, *this));
+DatasetStatsView::DatasetStatsView(
+    std::shared_ptr<const DatasetFeatureStatistics> data, bool by_weight)
+    : DatasetStatsView(std::move(data), by_weight, absl::nullopt,
+                       std::shared_ptr<DatasetStatsView>(),
+                       std::shared_ptr<DatasetStatsView>()) {}
+
+DatasetStatsView::DatasetStatsView(
+    std::shared_ptr<const DatasetFeatureStatistics> data, bool by_weight,
+    const absl::optional<string>& environment,
+    std::shared_ptr<DatasetStatsView> previous,
+    std::shared_ptr<DatasetStatsView> serving)
+    : impl_(new DatasetStatsViewImpl(std::move(data), by_weight, environment,
+                                     previous, serving, /*index=*/nullptr,
+                                     /*string_values=*/nullptr)) {}
+
+DatasetStatsView DatasetStatsView::WithByWeight(bool by_weight) const {
+  if (by_weight == impl_->by_weight_) {
+    return *this;
+  }
+  std::shared_ptr<DatasetStatsView> previous;
+  if (impl_->previous_ != nullptr) {
+    previous = std::make_shared<DatasetStatsView>(
+        impl_->previous_->WithByWeight(by_weight));
+  }
+  std::shared_ptr<DatasetStatsView> serving;
+  if (impl_->serving_ != nullptr) {
+    serving = std::make_shared<DatasetStatsView>(
+        impl_->serving_->WithByWeight(by_weight));
   }
+  DatasetStatsView result(*this);
+  result.impl_ = std::make_shared<const DatasetStatsViewImpl>(
+      impl_->data_, by_weight, impl_->environment_, previous, serving,
+      impl_->index_, /*string_values=*/nullptr);
+  return result;
+}
+
+DatasetStatsView DatasetStatsView::WithServing(
+    std::shared_ptr<DatasetStatsView> serving) const {
+  DatasetStatsView result(*this);
+  result.impl_ = std::make_shared<const DatasetStatsViewImpl>(
+      impl_->data_, impl_->by_weight_, impl_->environment_, impl_->previous_,
+      std::move(serving), impl_->index_, impl_->string_values_);
   return result;
 }
 
+DatasetStatsView DatasetStatsView::WithPrevious(
+    std::shared_ptr<DatasetStatsView> previous) const {
+  DatasetStatsView result(*this);
+  result.impl_ = std::make_shared<const DatasetStatsViewImpl>(
+      impl_->data_, impl_->by_weight_, impl_->environment_, std::move(previous),
+      impl_->serving_, impl_->index_, impl_->string_values_);
+  return result;
+}
+
+std::vector<FeatureStatsView> DatasetStatsView::features() const {
+  const FeatureStatsViewRange range = features_range();
+  return std::vector<FeatureStatsView>(range.begin(), range.end());
+}
+
+FeatureStatsViewRange DatasetStatsView::features_range() const {
+  return FeatureStatsViewRange(*this, impl_->index_->feature_indices);
+}
+
 const tensorflow::metadata::v0::FeatureNameStatistics&
 DatasetStatsView::feature_name_statistics(int index) const {
   CHECK_GE(index, 0);
@@ -242,19 +443,34 @@ const Path& DatasetStatsView::GetPath(const FeatureStatsView& view) const {
   return impl_->GetPath(view);
 }
 
+const std::map<string, double>& DatasetStatsView::GetStringValuesWithCounts(
+    const FeatureStatsView& view) const {
+  return impl_->GetStringValuesWithCounts(view);
+}
+
+const ParsedStringValues& DatasetStatsView::GetParsedStringValues(
+    const FeatureStatsView& view) const {
+  return impl_->GetParsedStringValues(view);
+}
+
 std::vector<FeatureStatsView> DatasetStatsView::GetChildren(
     const FeatureStatsView& view) const {
-  return impl_->GetChildren(view);
+  const FeatureStatsViewRange range = GetChildrenRange(view);
+  return std::vector<FeatureStatsView>(range.begin(), range.end());
+}
+
+FeatureStatsViewRange DatasetStatsView::GetChildrenRange(
+    const FeatureStatsView& view) const {
+  return FeatureStatsViewRange(*this, impl_->GetChildIndices(view));
 }
 
 std::vector<FeatureStatsView> DatasetStatsView::GetRootFeatures() const {
-  std::vector<FeatureStatsView> result;
-  for (const FeatureStatsView& feature : features()) {
-    if (!feature.GetParent()) {
-      result.push_back(feature);
-    }
-  }
-  return result;
+  const FeatureStatsViewRange range = GetRootFeaturesRange();
+  return std::vector<FeatureStatsView>(range.begin(), range.end());
+}
+
+FeatureStatsViewRange DatasetStatsView::GetRootFeaturesRange() const {
+  return FeatureStatsViewRange(*this, impl_->index_->root_indices);
 }
 
 // Returns true if the weighted statistics exist.
@@ -262,7 +478,7 @@ bool DatasetStatsView::WeightedStatisticsExist() const {
   if (impl_->data().weighted_num_examples() == 0.0) {
     return false;
   }
-  for (const FeatureStatsView& feature_stats_view : features()) {
+  for (const FeatureStatsView& feature_stats_view : features_range()) {
     if (!feature_stats_view.WeightedStatisticsExist()) {
       return false;
     }
@@ -337,22 +553,38 @@ double FeatureStatsView::GetNumPresent() const {
   return GetCommonStatistics().num_non_missing();
 }
 
-std::map<string, double> FeatureStatsView::GetStringValuesWithCounts() const {
-  std::map<string, double> result;
-  const tensorflow::metadata::v0::RankHistogram& histogram =
-      (parent_view_.by_weight())
-          ? data().string_stats().weighted_string_stats().rank_histogram()
-          : data().string_stats().rank_histogram();
-  for (const tensorflow::metadata::v0::RankHistogram::Bucket& bucket :
-       histogram.buckets()) {
-    result.insert({bucket.label(), bucket.sample_count()});
+double FeatureStatsView::GetSampleRate() const {
+  const absl::optional<double> sample_rate =
+      GetNumericCustomStat(data(), kSampleRateCustomStat);
+  if (!sample_rate || *sample_rate <= 0.0 || *sample_rate > 1.0) {
+    return 1.0;
   }
-  return result;
+  return *sample_rate;
+}
+
+double FeatureStatsView::GetNumPresentUpperBound() const {
+  const double num_present = GetNumPresent();
+  if (parent_view_.by_weight() || GetSampleRate() == 1.0) {
+    return num_present;
+  }
+  const absl::optional<double> upper_bound =
+      GetNumericCustomStat(data(), kNumNonMissingUpperBoundCustomStat);
+  return upper_bound ? std::max(num_present, *upper_bound) : num_present;
+}
+
+const std::map<string, double>& FeatureStatsView::GetStringValuesWithCounts()
+    const {
+  return parent_view_.GetStringValuesWithCounts(*this);
+}
+
+const ParsedStringValues& FeatureStatsView::GetParsedStringValues() const {
+  return parent_view_.GetParsedStringValues(*this);
 }
 
 std::vector<string> FeatureStatsView::GetStringValues() const {
   std::vector<string> result;
-  std::map<string, double> counts = GetStringValuesWithCounts();
+  const std::map<string, double>& counts = GetStringValuesWithCounts();
+  result.reserve(counts.size());
   for (const auto& pair : counts) {
     const string& string_value = pair.first;
     result.push_back(string_value);
@@ -360,6 +592,10 @@ std::vector<string> FeatureStatsView::GetStringValues() const {
   return result;
 }
 
+uint64 FeatureStatsView::GetFingerprint() const {
+  return Hash64(data().SerializeAsString());
+}
+
 bool FeatureStatsView::HasInvalidUTF8Strings() const {
   // Instead of writing non-UTF8 strings to the statistics summary, the
   // generator writes __BYTES_VALUE__.
@@ -440,6 +676,10 @@ std::vector<FeatureStatsView> FeatureStatsView::GetChildren() const {
   return parent_view_.GetChildren(*this);
 }
 
+FeatureStatsViewRange FeatureStatsView::GetChildrenRange() const {
+  return parent_view_.GetChildrenRange(*this);
+}
+
 const Path& FeatureStatsView::GetPath() const {
   return parent_view_.GetPath(*this);
 }
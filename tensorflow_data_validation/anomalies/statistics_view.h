@@ -17,13 +17,18 @@ limitations under the License.
 #define TENSORFLOW_DATA_VALIDATION_ANOMALIES_STATISTICS_VIEW_H_
 
 #include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "tensorflow_data_validation/anomalies/numeric_string_util.h"
 #include "tensorflow_data_validation/anomalies/path.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_metadata/proto/v0/schema.pb.h"
 #include "tensorflow_metadata/proto/v0/statistics.pb.h"
@@ -33,6 +38,8 @@ namespace data_validation {
 
 class FeatureStatsView;
 
+class FeatureStatsViewRange;
+
 class DatasetStatsViewImpl;
 
 // Wrapper for statistics.
@@ -54,6 +61,38 @@ class DatasetStatsView {
   explicit DatasetStatsView(
       const tensorflow::metadata::v0::DatasetFeatureStatistics& data);
 
+  // The constructors above copy data. These share it instead, so the view
+  // costs no more than its index. data must not be null, and must not be
+  // modified while the view (or any copy of it) is alive.
+  DatasetStatsView(
+      std::shared_ptr<const tensorflow::metadata::v0::DatasetFeatureStatistics>
+          data,
+      bool by_weight);
+
+  DatasetStatsView(
+      std::shared_ptr<const tensorflow::metadata::v0::DatasetFeatureStatistics>
+          data,
+      bool by_weight, const absl::optional<string>& environment,
+      std::shared_ptr<DatasetStatsView> previous,
+      std::shared_ptr<DatasetStatsView> serving);
+
+  // Returns a view of the same statistics, environment, previous and serving
+  // statistics, weighted as by_weight. The index of the features is shared
+  // with this view rather than rebuilt, so this takes O(# features) time.
+  DatasetStatsView WithByWeight(bool by_weight) const;
+
+  // Returns a view of the same statistics, weighting, environment and
+  // previous statistics, with serving as the serving statistics. Both the
+  // index of the features and the string values computed on demand (see
+  // GetStringValuesWithCounts()) are shared with this view, so comparing the
+  // same statistics against many serving statistics only computes them once.
+  DatasetStatsView WithServing(std::shared_ptr<DatasetStatsView> serving) const;
+
+  // Same as above, but with previous as the previous statistics, e.g., to
+  // compare the same statistics against several previous spans.
+  DatasetStatsView WithPrevious(
+      std::shared_ptr<DatasetStatsView> previous) const;
+
   // Perform shallow copies of object, sharing the same
   // DatasetStatsViewImpl through a shared_ptr.
   DatasetStatsView(const DatasetStatsView& other) = default;
@@ -65,6 +104,12 @@ class DatasetStatsView {
   // Only includes FeatureStatsViews without parents.
   std::vector<FeatureStatsView> GetRootFeatures() const;
 
+  // Same as features() and GetRootFeatures(), but without a vector: each
+  // FeatureStatsView is only built as it is iterated over. The range must not
+  // outlive this object.
+  FeatureStatsViewRange features_range() const;
+  FeatureStatsViewRange GetRootFeaturesRange() const;
+
   // If returns zero, it could just be the default value.
   double GetNumExamples() const;
 
@@ -96,9 +141,23 @@ class DatasetStatsView {
 
   const Path& GetPath(const FeatureStatsView& view) const;
 
+  // Returns the strings that occur in the data of a FeatureStatsView, along
+  // with the (weighted) counts. The map is built the first time it is
+  // requested for each feature, and shared by all copies of this view.
+  const std::map<string, double>& GetStringValuesWithCounts(
+      const FeatureStatsView& view) const;
+
+  // Returns the string values of a FeatureStatsView parsed as numbers. Like
+  // GetStringValuesWithCounts(), this is computed once for each feature.
+  const ParsedStringValues& GetParsedStringValues(
+      const FeatureStatsView& view) const;
+
   // Gets the children of a FeatureStatsView.
   std::vector<FeatureStatsView> GetChildren(const FeatureStatsView& view) const;
 
+  // Same as above, but as a range (see features_range()).
+  FeatureStatsViewRange GetChildrenRange(const FeatureStatsView& view) const;
+
   const absl::optional<string>& environment() const;
 
   const absl::optional<DatasetStatsView> GetPrevious() const;
@@ -140,6 +199,17 @@ class FeatureStatsView {
   // feature is present.
   double GetNumPresent() const;
 
+  // Gets the rate at which the examples were sampled to compute the
+  // statistics of this feature (its sample_rate custom statistic), or 1.0
+  // if they were not sampled.
+  double GetSampleRate() const;
+
+  // Gets the upper bound of the confidence interval of GetNumPresent() (its
+  // num_non_missing_upper_bound custom statistic) if the statistics were
+  // computed over a sample, and GetNumPresent() otherwise. The weighted
+  // statistics have no bound.
+  double GetNumPresentUpperBound() const;
+
   // The number of values should never be negative: instead of propagating
   // such an error, we treat it as zero.
   int min_num_values() const {
@@ -153,12 +223,24 @@ class FeatureStatsView {
 
   // Returns the strings that occur in the data, along with the (weighted)
   // counts. If there are no string stats, then it returns an empty map.
-  std::map<string, double> GetStringValuesWithCounts() const;
+  // The map is computed once, and lives as long as the parent view.
+  const std::map<string, double>& GetStringValuesWithCounts() const;
+
+  // Returns the result of parsing each of GetStringValuesWithCounts() as an
+  // int64 and as a float. This is computed once, and lives as long as the
+  // parent view, so that the int and float domain utilities do not each
+  // reparse the values.
+  const ParsedStringValues& GetParsedStringValues() const;
 
   // Returns the strings that occur in the data.
   // If there are no string stats, then it returns an empty map.
   std::vector<string> GetStringValues() const;
 
+  // Returns a fingerprint of the statistics of this feature. It does not
+  // cover the children of the feature, or the feature in the previous or
+  // serving statistics.
+  uint64 GetFingerprint() const;
+
   // Returns true if the column is a string column and there are some invalid
   // UTF8 strings present.
   bool HasInvalidUTF8Strings() const;
@@ -183,19 +265,32 @@ class FeatureStatsView {
 
   const DatasetStatsView& parent_view() const { return parent_view_; }
 
-  // Returns the list of custom_stats of the underlying FeatureNameStatistics.
-  std::vector<tensorflow::metadata::v0::CustomStatistic> custom_stats() const {
-    return {data().custom_stats().begin(), data().custom_stats().end()};
+  // Returns the list of custom_stats of the underlying FeatureNameStatistics,
+  // without copying them.
+  const protobuf::RepeatedPtrField<tensorflow::metadata::v0::CustomStatistic>&
+  custom_stats() const {
+    return data().custom_stats();
   }
 
   std::vector<FeatureStatsView> GetChildren() const;
 
+  // Same as above, but as a range (see DatasetStatsView::features_range()),
+  // which must not outlive this object.
+  FeatureStatsViewRange GetChildrenRange() const;
+
   absl::optional<FeatureStatsView> GetParent() const;
 
   bool is_struct() const {
     return type() == tensorflow::metadata::v0::FeatureNameStatistics::STRUCT;
   }
 
+  // The statistics of the feature in the DatasetFeatureStatistics, e.g., to
+  // copy them into other statistics.
+  const tensorflow::metadata::v0::FeatureNameStatistics&
+  feature_name_statistics() const {
+    return data();
+  }
+
   // Object is assumed to be created from DatasetStatsView::features().
   FeatureStatsView(int index, const DatasetStatsView& parent_view)
       : parent_view_(parent_view), index_(index) {}
@@ -219,6 +314,78 @@ class FeatureStatsView {
   const int index_;
 };
 
+// The FeatureStatsViews of some features of a DatasetStatsView, given by
+// their indices, which belong to the DatasetStatsView. Unlike a vector of
+// FeatureStatsViews, a range allocates nothing: each FeatureStatsView is
+// built when its iterator is dereferenced. The DatasetStatsView must outlive
+// the range.
+class FeatureStatsViewRange {
+ public:
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = FeatureStatsView;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const FeatureStatsView*;
+    using reference = FeatureStatsView;
+
+    const_iterator(const DatasetStatsView* view, const int* index)
+        : view_(view), index_(index) {}
+
+    FeatureStatsView operator*() const {
+      return FeatureStatsView(*index_, *view_);
+    }
+
+    const_iterator& operator++() {
+      ++index_;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator result = *this;
+      ++index_;
+      return result;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.index_ == b.index_;
+    }
+
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) {
+      return a.index_ != b.index_;
+    }
+
+   private:
+    const DatasetStatsView* view_;
+    const int* index_;
+  };
+
+  FeatureStatsViewRange(const DatasetStatsView& view,
+                        absl::Span<const int> indices)
+      : view_(&view), indices_(indices) {}
+
+  const_iterator begin() const {
+    return const_iterator(view_, indices_.data());
+  }
+  const_iterator end() const {
+    return const_iterator(view_, indices_.data() + indices_.size());
+  }
+
+  size_t size() const { return indices_.size(); }
+  bool empty() const { return indices_.empty(); }
+
+  FeatureStatsView operator[](size_t i) const {
+    return FeatureStatsView(indices_[i], *view_);
+  }
+
+  // The indices of the features in the DatasetFeatureStatistics.
+  absl::Span<const int> indices() const { return indices_; }
+
+ private:
+  const DatasetStatsView* view_;
+  absl::Span<const int> indices_;
+};
+
 }  // namespace data_validation
 }  // namespace tensorflow
 
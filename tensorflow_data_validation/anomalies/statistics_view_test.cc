@@ -15,13 +15,18 @@ limitations under the License.
 
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 #include "tensorflow_data_validation/anomalies/statistics_view_test_util.h"
 #include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow_metadata/proto/v0/statistics.pb.h"
 
@@ -351,6 +356,15 @@ TEST(DatasetStatsView, GetRootFeatures) {
   std::vector<FeatureStatsView> roots = stats.GetRootFeatures();
   ASSERT_EQ(roots.size(), 1);
   EXPECT_EQ(roots[0].name(), "foo");
+
+  const FeatureStatsViewRange root_range = stats.GetRootFeaturesRange();
+  ASSERT_EQ(root_range.size(), 1);
+  EXPECT_EQ(root_range[0].name(), "foo");
+  std::vector<string> names;
+  for (const FeatureStatsView& feature : stats.features_range()) {
+    names.push_back(feature.name());
+  }
+  EXPECT_EQ(names, std::vector<string>({"foo.bar", "foo"}));
 }
 
 TEST(FeatureStatsView, GetNumExamplesWeighted) {
@@ -427,6 +441,150 @@ TEST(FeatureStatsView, GetStringValuesWithCountsNotString) {
   EXPECT_THAT(actual, ::testing::IsEmpty());
 }
 
+// The map is built once per feature, and shared by copies of the view.
+TEST(FeatureStatsView, GetStringValuesWithCountsIsShared) {
+  const DatasetFeatureStatistics input =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        weighted_num_examples: 5
+        features {
+          name: 'bar'
+          type: STRING
+          string_stats: {
+            common_stats: { num_missing: 3 max_num_values: 2 }
+            rank_histogram: { buckets: { label: "foo" sample_count: 1 } }
+            weighted_string_stats: {
+              rank_histogram: { buckets: { label: "foo" sample_count: 0.5 } }
+            }
+          }
+        })");
+  const DatasetStatsView view(input, /*by_weight=*/false);
+  const DatasetStatsView weighted_view(input, /*by_weight=*/true);
+  const FeatureStatsView feature = *view.GetByPath(Path({"bar"}));
+  const std::map<string, double>& values = feature.GetStringValuesWithCounts();
+  EXPECT_THAT(values, ::testing::ElementsAre(::testing::Pair("foo", 1)));
+  EXPECT_EQ(&values, &feature.GetStringValuesWithCounts());
+  const DatasetStatsView view_copy = view;
+  EXPECT_EQ(&values,
+            &view_copy.GetByPath(Path({"bar"}))->GetStringValuesWithCounts());
+  EXPECT_THAT(
+      weighted_view.GetByPath(Path({"bar"}))->GetStringValuesWithCounts(),
+      ::testing::ElementsAre(::testing::Pair("foo", 0.5)));
+}
+
+// Threads that request the string values of the features of one view
+// concurrently, each in a different order, all get the same maps.
+TEST(FeatureStatsView, GetStringValuesWithCountsConcurrently) {
+  constexpr int kNumFeatures = 50;
+  constexpr int kNumThreads = 8;
+  DatasetFeatureStatistics input;
+  input.set_num_examples(10);
+  for (int i = 0; i < kNumFeatures; ++i) {
+    FeatureNameStatistics* feature = input.add_features();
+    feature->set_name(absl::StrCat("feature", i));
+    feature->set_type(FeatureNameStatistics::STRING);
+    for (int j = 0; j < 100; ++j) {
+      auto* bucket = feature->mutable_string_stats()
+                         ->mutable_rank_histogram()
+                         ->add_buckets();
+      bucket->set_label(absl::StrCat(j));
+      bucket->set_sample_count(j);
+    }
+  }
+  const DatasetStatsView view(input, /*by_weight=*/false);
+  std::vector<std::vector<const std::map<string, double>*>> values(
+      kNumThreads);
+  std::vector<std::vector<const ParsedStringValues*>> parsed(kNumThreads);
+  {
+    // The destructor of the pool waits for all the work to finish.
+    thread::ThreadPool pool(Env::Default(), "statistics_view_test",
+                            kNumThreads);
+    for (int t = 0; t < kNumThreads; ++t) {
+      pool.Schedule([&view, &values, &parsed, t]() {
+        values[t].resize(kNumFeatures);
+        parsed[t].resize(kNumFeatures);
+        for (int j = 0; j < kNumFeatures; ++j) {
+          const int i = (j + t * 7) % kNumFeatures;
+          const FeatureStatsView feature =
+              *view.GetByPath(Path({absl::StrCat("feature", i)}));
+          parsed[t][i] = &feature.GetParsedStringValues();
+          values[t][i] = &feature.GetStringValuesWithCounts();
+        }
+      });
+    }
+  }
+  for (int t = 1; t < kNumThreads; ++t) {
+    EXPECT_EQ(values[0], values[t]);
+    EXPECT_EQ(parsed[0], parsed[t]);
+  }
+  for (const std::map<string, double>* feature_values : values[0]) {
+    EXPECT_EQ(100, feature_values->size());
+  }
+}
+
+TEST(FeatureStatsView, GetParsedStringValues) {
+  const DatasetFeatureStatistics input =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features {
+          name: 'ints'
+          type: STRING
+          string_stats: {
+            rank_histogram: {
+              buckets: { label: "3" sample_count: 1 }
+              buckets: { label: "-7" sample_count: 1 }
+              buckets: { label: "12" sample_count: 1 }
+            }
+          }
+        }
+        features {
+          name: 'floats'
+          type: STRING
+          string_stats: {
+            rank_histogram: {
+              buckets: { label: "1.5" sample_count: 1 }
+              buckets: { label: "2" sample_count: 1 }
+            }
+          }
+        }
+        features {
+          name: 'strings'
+          type: STRING
+          string_stats: {
+            rank_histogram: {
+              buckets: { label: "4" sample_count: 1 }
+              buckets: { label: "foo" sample_count: 1 }
+              buckets: { label: "bar" sample_count: 1 }
+            }
+          }
+        })");
+  const DatasetStatsView view(input, /*by_weight=*/false);
+
+  const FeatureStatsView ints = *view.GetByPath(Path({"ints"}));
+  const ParsedStringValues& parsed_ints = ints.GetParsedStringValues();
+  EXPECT_EQ(parsed_ints.non_int_example, absl::nullopt);
+  EXPECT_EQ(parsed_ints.int_min, -7);
+  EXPECT_EQ(parsed_ints.int_max, 12);
+  EXPECT_EQ(parsed_ints.non_float_example, absl::nullopt);
+  EXPECT_EQ(parsed_ints.float_min, -7.0);
+  EXPECT_EQ(parsed_ints.float_max, 12.0);
+  // The result is computed once for each feature.
+  EXPECT_EQ(&parsed_ints, &ints.GetParsedStringValues());
+
+  const ParsedStringValues& parsed_floats =
+      view.GetByPath(Path({"floats"}))->GetParsedStringValues();
+  EXPECT_EQ(parsed_floats.non_int_example, "1.5");
+  EXPECT_EQ(parsed_floats.non_float_example, absl::nullopt);
+  EXPECT_EQ(parsed_floats.float_min, 1.5);
+  EXPECT_EQ(parsed_floats.float_max, 2.0);
+
+  // The examples are the first values in sorted order.
+  const ParsedStringValues& parsed_strings =
+      view.GetByPath(Path({"strings"}))->GetParsedStringValues();
+  EXPECT_EQ(parsed_strings.non_int_example, "bar");
+  EXPECT_EQ(parsed_strings.non_float_example, "bar");
+}
+
 TEST(FeatureStatsView, HasInvalidUTF8Strings) {
   const FeatureNameStatistics input =
       ParseTextProtoOrDie<FeatureNameStatistics>(R"(
@@ -696,6 +854,25 @@ TEST(DatasetStatsView, Features) {
       testing::DatasetForTesting(input).dataset_stats_view().features().size());
 }
 
+TEST(DatasetStatsView, SharedData) {
+  const auto current = std::make_shared<const DatasetFeatureStatistics>(
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features {
+          name: 'bar'
+          type: FLOAT
+          num_stats: {
+            common_stats: { num_missing: 3 min_num_values: 3 max_num_values: 7 }
+          }
+        })"));
+
+  const DatasetStatsView view(current, /*by_weight=*/false);
+  // The view reads the shared proto instead of a copy of it.
+  EXPECT_EQ(&current->features(0), &view.feature_name_statistics(0));
+  EXPECT_EQ(10, view.GetNumExamples());
+  EXPECT_EQ("bar", view.GetByPath(Path({"bar"}))->name());
+}
+
 TEST(DatasetStatsView, GetNumExamples) {
   const FeatureNameStatistics input =
       ParseTextProtoOrDie<FeatureNameStatistics>(R"(
@@ -757,6 +934,96 @@ TEST(DatasetStatsView, ByWeight) {
   EXPECT_TRUE(dataset_true.dataset_stats_view().by_weight());
 }
 
+TEST(DatasetStatsView, WithByWeight) {
+  const DatasetFeatureStatistics input =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        weighted_num_examples: 5
+        features: {
+          name: 'foo'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 10 }
+            rank_histogram: { buckets: { label: "a" sample_count: 10 } }
+            weighted_string_stats: {
+              rank_histogram: { buckets: { label: "b" sample_count: 5 } }
+            }
+          }
+        })");
+  const DatasetStatsView unweighted(
+      input, /*by_weight=*/false, /*environment=*/absl::nullopt,
+      /*previous=*/std::make_shared<DatasetStatsView>(input),
+      /*serving=*/nullptr);
+  const DatasetStatsView weighted = unweighted.WithByWeight(true);
+  EXPECT_FALSE(unweighted.by_weight());
+  EXPECT_TRUE(weighted.by_weight());
+  EXPECT_EQ(10, unweighted.GetNumExamples());
+  EXPECT_EQ(5, weighted.GetNumExamples());
+  ASSERT_TRUE(weighted.GetPrevious());
+  EXPECT_TRUE(weighted.GetPrevious()->by_weight());
+  EXPECT_FALSE(weighted.GetServing());
+
+  const absl::optional<FeatureStatsView> foo =
+      weighted.GetByPath(Path({"foo"}));
+  ASSERT_TRUE(foo);
+  EXPECT_EQ(foo->GetStringValues(), std::vector<string>({"b"}));
+  EXPECT_EQ(unweighted.GetByPath(Path({"foo"}))->GetStringValues(),
+            std::vector<string>({"a"}));
+  EXPECT_EQ(weighted.WithByWeight(true).GetNumExamples(), 5);
+}
+
+TEST(DatasetStatsView, WithServingAndPrevious) {
+  const DatasetFeatureStatistics input =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 10
+        features: {
+          name: 'foo'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 10 }
+            rank_histogram: { buckets: { label: "a" sample_count: 10 } }
+          }
+        })");
+  const DatasetFeatureStatistics serving =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        num_examples: 3
+        features: {
+          name: 'foo'
+          type: STRING
+          string_stats: {
+            common_stats: { num_non_missing: 3 }
+            rank_histogram: { buckets: { label: "b" sample_count: 3 } }
+          }
+        })");
+  const DatasetStatsView training(input, /*by_weight=*/false,
+                                  /*environment=*/string("TRAINING"),
+                                  /*previous=*/nullptr, /*serving=*/nullptr);
+  const std::map<string, double>& values =
+      training.GetByPath(Path({"foo"}))->GetStringValuesWithCounts();
+  const DatasetStatsView with_serving =
+      training.WithServing(std::make_shared<DatasetStatsView>(serving));
+  EXPECT_FALSE(training.GetServing());
+  ASSERT_TRUE(with_serving.GetServing());
+  EXPECT_EQ(3, with_serving.GetServing()->GetNumExamples());
+  EXPECT_EQ(10, with_serving.GetNumExamples());
+  EXPECT_EQ(string("TRAINING"), with_serving.environment());
+
+  const absl::optional<FeatureStatsView> foo =
+      with_serving.GetByPath(Path({"foo"}));
+  ASSERT_TRUE(foo);
+  // The string values computed for the training statistics are shared.
+  EXPECT_EQ(&values, &foo->GetStringValuesWithCounts());
+  EXPECT_EQ(foo->GetServing()->GetStringValues(), std::vector<string>({"b"}));
+
+  const DatasetStatsView with_previous =
+      with_serving.WithPrevious(std::make_shared<DatasetStatsView>(serving));
+  ASSERT_TRUE(with_previous.GetPrevious());
+  ASSERT_TRUE(with_previous.GetServing());
+  EXPECT_EQ(3, with_previous.GetPrevious()->GetNumExamples());
+  EXPECT_EQ(&values, &with_previous.GetByPath(Path({"foo"}))
+                          ->GetStringValuesWithCounts());
+}
+
 TEST(DatasetStatsView, GetByPathOrNull) {
   const testing::DatasetForTesting dataset(
       ParseTextProtoOrDie<FeatureNameStatistics>(R"(
@@ -777,6 +1044,38 @@ TEST(DatasetStatsView, GetByPathOrNull) {
             dataset.dataset_stats_view().GetByPath(Path({"imaginary_field"})));
 }
 
+// If several features have the same name, the last one is found.
+TEST(DatasetStatsView, GetByPathDuplicateName) {
+  const DatasetFeatureStatistics current =
+      ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+        features {
+          name: 'bar'
+          type: FLOAT
+          num_stats: { common_stats: { max_num_values: 1 } }
+        }
+        features {
+          name: 'foo'
+          type: STRUCT
+          struct_stats: { common_stats: { max_num_values: 2 } }
+        }
+        features {
+          name: 'bar'
+          type: FLOAT
+          num_stats: { common_stats: { max_num_values: 3 } }
+        }
+        features {
+          name: 'foo.baz'
+          type: INT
+          num_stats: { common_stats: { max_num_values: 4 } }
+        })");
+  const DatasetStatsView view(current, false);
+  EXPECT_EQ(3, view.GetByPath(Path({"bar"}))->max_num_values());
+  EXPECT_EQ(4, view.GetByPath(Path({"foo", "baz"}))->max_num_values());
+  EXPECT_EQ(2, view.GetByPath(Path({"foo", "baz"}))->GetParent()
+                   ->max_num_values());
+  EXPECT_EQ(absl::nullopt, view.GetByPath(Path({"foo.baz"})));
+}
+
 TEST(DatasetStatsView, WeightedStatisticsExist) {
   const DatasetFeatureStatistics statistics =
       ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
@@ -908,6 +1207,26 @@ TEST(DatasetStatsView, GetChildren) {
   std::vector<FeatureStatsView> children = parent->GetChildren();
   ASSERT_EQ(children.size(), 1);
   EXPECT_EQ(children[0].name(), "foo.bar");
+
+  const FeatureStatsViewRange child_range = parent->GetChildrenRange();
+  ASSERT_EQ(child_range.size(), 1);
+  EXPECT_EQ((*child_range.begin()).name(), "foo.bar");
+  EXPECT_TRUE(children[0].GetChildrenRange().empty());
+}
+
+TEST(FeatureStatsView, CustomStats) {
+  const FeatureNameStatistics input =
+      ParseTextProtoOrDie<FeatureNameStatistics>(R"(
+        name: 'bar'
+        type: FLOAT
+        num_stats: { common_stats: { num_non_missing: 1 } }
+        custom_stats: { name: 'first' num: 1 }
+        custom_stats: { name: 'second' str: 'two' })");
+  const testing::DatasetForTesting dataset(input);
+  const FeatureStatsView view = dataset.feature_stats_view();
+  ASSERT_EQ(view.custom_stats().size(), 2);
+  EXPECT_EQ(view.custom_stats().Get(0).name(), "first");
+  EXPECT_EQ(view.custom_stats().Get(1).str(), "two");
 }
 
 }  // namespace data_validation
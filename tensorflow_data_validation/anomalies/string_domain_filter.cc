@@ -0,0 +1,77 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/string_domain_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow/core/lib/hash/hash.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+// The number of hash functions is at most this, whatever the rate.
+constexpr int kMaxNumHashes = 30;
+
+// The two hashes from which those of the filter are derived (see "Less
+// Hashing, Same Performance: Building a Better Bloom Filter", Kirsch and
+// Mitzenmacher). The second is odd, so that it is never 0.
+void GetHashes(absl::string_view value, uint64* hash_a, uint64* hash_b) {
+  const uint64 hash = Hash64(value.data(), value.size());
+  *hash_a = hash;
+  *hash_b = ((hash >> 32) | (hash << 32)) | 1;
+}
+
+}  // namespace
+
+StringDomainFilter::StringDomainFilter(
+    const protobuf::RepeatedPtrField<string>& values,
+    double false_positive_rate)
+    : false_positive_rate_(false_positive_rate) {
+  // The optimal size and number of hashes for the rate.
+  const double log2 = std::log(2.0);
+  const double bits_per_value = -std::log(false_positive_rate) / (log2 * log2);
+  num_bits_ = std::max<uint64>(
+      64, std::ceil(std::max(values.size(), 1) * bits_per_value));
+  num_hashes_ = std::min(
+      kMaxNumHashes,
+      std::max(1, static_cast<int>(std::round(bits_per_value * log2))));
+  bits_.assign((num_bits_ + 63) / 64, 0);
+  for (const string& value : values) {
+    uint64 hash_a, hash_b;
+    GetHashes(value, &hash_a, &hash_b);
+    for (int i = 0; i < num_hashes_; ++i) {
+      const uint64 bit = (hash_a + i * hash_b) % num_bits_;
+      bits_[bit / 64] |= uint64{1} << (bit % 64);
+    }
+  }
+}
+
+bool StringDomainFilter::MayContain(absl::string_view value) const {
+  uint64 hash_a, hash_b;
+  GetHashes(value, &hash_a, &hash_b);
+  for (int i = 0; i < num_hashes_; ++i) {
+    const uint64 bit = (hash_a + i * hash_b) % num_bits_;
+    if ((bits_[bit / 64] & (uint64{1} << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
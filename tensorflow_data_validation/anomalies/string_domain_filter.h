@@ -0,0 +1,63 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A Bloom filter of the values of a StringDomain, for the domains that are
+// too large to hold a hash set of their values (see
+// ApproximateStringDomainConfig).
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_DOMAIN_FILTER_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_DOMAIN_FILTER_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+class StringDomainFilter {
+ public:
+  // Builds a filter of values, which accepts a value that is not one of them
+  // with a probability of about false_positive_rate, in (0, 1). The filter
+  // takes about -log2(false_positive_rate) * 1.44 bits per value, e.g., less
+  // than 10 bits per value for a rate of 1%.
+  StringDomainFilter(const protobuf::RepeatedPtrField<string>& values,
+                     double false_positive_rate);
+
+  // Disallow copy and move.
+  StringDomainFilter(const StringDomainFilter&) = delete;
+  StringDomainFilter& operator=(const StringDomainFilter&) = delete;
+
+  // True if value may be one of the values of the filter. Always true if it
+  // is one of them.
+  bool MayContain(absl::string_view value) const;
+
+  double false_positive_rate() const { return false_positive_rate_; }
+
+  // The size of the filter, in bits.
+  uint64 num_bits() const { return num_bits_; }
+
+ private:
+  double false_positive_rate_;
+  uint64 num_bits_;
+  int num_hashes_;
+  std::vector<uint64> bits_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_DOMAIN_FILTER_H_
@@ -0,0 +1,65 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/string_domain_filter.h"
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+protobuf::RepeatedPtrField<string> GetValues(const string& prefix, int size) {
+  protobuf::RepeatedPtrField<string> values;
+  for (int i = 0; i < size; ++i) {
+    *values.Add() = absl::StrCat(prefix, i);
+  }
+  return values;
+}
+
+TEST(StringDomainFilterTest, ContainsAllValues) {
+  const protobuf::RepeatedPtrField<string> values = GetValues("value", 10000);
+  const StringDomainFilter filter(values, 0.01);
+  for (const string& value : values) {
+    EXPECT_TRUE(filter.MayContain(value)) << value;
+  }
+  // Less than 10 bits per value.
+  EXPECT_LT(filter.num_bits(), 10 * 10000);
+}
+
+TEST(StringDomainFilterTest, FalsePositiveRate) {
+  const StringDomainFilter filter(GetValues("value", 10000), 0.01);
+  int false_positives = 0;
+  for (const string& other : GetValues("other", 10000)) {
+    if (filter.MayContain(other)) {
+      ++false_positives;
+    }
+  }
+  EXPECT_LT(false_positives, 300);
+}
+
+TEST(StringDomainFilterTest, EmptyValues) {
+  const StringDomainFilter filter(protobuf::RepeatedPtrField<string>(), 0.01);
+  EXPECT_EQ(64, filter.num_bits());
+  EXPECT_FALSE(filter.MayContain(""));
+  EXPECT_FALSE(filter.MayContain("value"));
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -16,11 +16,14 @@ limitations under the License.
 #include "tensorflow_data_validation/anomalies/string_domain_util.h"
 
 #include <stddef.h>
+#include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
 #include "tensorflow_data_validation/anomalies/internal_types.h"
 #include "tensorflow_data_validation/anomalies/proto/feature_statistics_to_proto.pb.h"
 #include "tensorflow_data_validation/anomalies/statistics_view_test_util.h"
@@ -44,11 +47,15 @@ FeatureStatisticsToProtoConfig GetDefaultFeatureStatisticsToProtoConfig() {
 using ::tensorflow::metadata::v0::FeatureNameStatistics;
 using ::tensorflow::metadata::v0::StringDomain;
 using ::testing::ElementsAre;
-using ::testing::Field;
 using ::testing::HasSubstr;
+using ::testing::ResultOf;
 using testing::EqualsProto;
 using testing::ParseTextProtoOrDie;
 
+string GetLongDescription(const Description& description) {
+  return description.GetLongDescription();
+}
+
 struct EnumTypeIsValidTest {
   const string name;
   const std::vector<string> values;
@@ -248,6 +255,52 @@ TEST(EnumType, IsValidWithMassConstraint) {
               sample_count: 2.001
             }}})"),
        false},
+      // Over a sample of 10 values, 3 values off domain can be noise.
+      {"sampled_not_enough_mass_in_domain", kDomain,
+       ParseTextProtoOrDie<FeatureNameStatistics>(R"(
+        name: 'bar'
+        type: STRING
+        string_stats: {
+          common_stats: {
+            tot_num_values: 20
+            num_non_missing: 20
+            avg_num_values: 1
+          }
+          unique: 2
+          rank_histogram: {
+            buckets: {
+              label: "a"
+              sample_count: 7
+            }
+            buckets: {
+              label: "c"
+              sample_count: 3
+            }}}
+        custom_stats: { name: "sample_rate" num: 0.5 })"),
+       true},
+      // Over a sample of 1000 values, 300 values off domain are not.
+      {"large_sample_not_enough_mass_in_domain", kDomain,
+       ParseTextProtoOrDie<FeatureNameStatistics>(R"(
+        name: 'bar'
+        type: STRING
+        string_stats: {
+          common_stats: {
+            tot_num_values: 2000
+            num_non_missing: 2000
+            avg_num_values: 1
+          }
+          unique: 2
+          rank_histogram: {
+            buckets: {
+              label: "a"
+              sample_count: 700
+            }
+            buckets: {
+              label: "c"
+              sample_count: 300
+            }}}
+        custom_stats: { name: "sample_rate" num: 0.5 })"),
+       false},
   };
 
   for (const auto& test : tests) {
@@ -394,8 +447,8 @@ TEST(EnumType, SurfaceFrequenciesOfMissingValues) {
                                .feature_stats_view(),
                            0, &string_domain);
     EXPECT_THAT(summary.descriptions,
-                ElementsAre(Field(&Description::long_description,
-                                  HasSubstr("gamma (~30%)"))));
+                ElementsAre(ResultOf(&GetLongDescription,
+                                     HasSubstr("gamma (~30%)"))));
   }
 
   // Case: percentage of value < 1%.
@@ -430,8 +483,8 @@ TEST(EnumType, SurfaceFrequenciesOfMissingValues) {
                                .feature_stats_view(),
                            0, &string_domain);
     EXPECT_THAT(summary.descriptions,
-                ElementsAre(Field(&Description::long_description,
-                                  HasSubstr("gamma (<1%)"))));
+                ElementsAre(ResultOf(&GetLongDescription,
+                                     HasSubstr("gamma (<1%)"))));
   }
 }
 
@@ -472,10 +525,10 @@ TEST(EnumType, DomainSizeLimit) {
     EXPECT_TRUE(summary.clear_field);
     EXPECT_THAT(summary.descriptions,
                 ElementsAre(
-                    Field(&Description::long_description,
-                                  HasSubstr("gamma (~30%)")),
-                    Field(&Description::long_description,
-                                  HasSubstr("too many values"))
+                    ResultOf(&GetLongDescription,
+                                     HasSubstr("gamma (~30%)")),
+                    ResultOf(&GetLongDescription,
+                                     HasSubstr("too many values"))
                     ));
   }
   // Don't delete.
@@ -513,8 +566,8 @@ TEST(EnumType, DomainSizeLimit) {
                            0, &string_domain);
     EXPECT_FALSE(summary.clear_field);
     EXPECT_THAT(summary.descriptions,
-                ElementsAre(Field(&Description::long_description,
-                                  HasSubstr("gamma (~30%)"))));
+                ElementsAre(ResultOf(&GetLongDescription,
+                                     HasSubstr("gamma (~30%)"))));
   }
 }
 
@@ -623,6 +676,93 @@ TEST(Enum, IsSimilar) {
   EXPECT_TRUE(IsSimilarStringDomain(domain, domain, EnumsSimilarConfig()));
 }
 
+// Repeated values are only counted once.
+TEST(Enum, IsSimilarRepeatedValues) {
+  const StringDomain a = ParseTextProtoOrDie<StringDomain>(R"(
+      name: "EnumA"
+      value: "foo"
+      value: "bar"
+      value: "foo"
+      )");
+  const StringDomain b = ParseTextProtoOrDie<StringDomain>(R"(
+      name: "EnumB"
+      value: "bar"
+      value: "foo"
+      )");
+  EXPECT_TRUE(IsSimilarStringDomain(a, b, EnumsSimilarConfig()));
+  EXPECT_THAT(GetStringDomainValues(a),
+              ::testing::UnorderedElementsAre("foo", "bar"));
+}
+
+// The precomputed values are used instead of the ones in the StringDomain.
+TEST(Enum, UpdateWithDomainValues) {
+  const FeatureNameStatistics stats =
+      ParseTextProtoOrDie<FeatureNameStatistics>(R"(
+        name: 'bar'
+        type: STRING
+        string_stats: {
+          common_stats: { num_non_missing: 10 max_num_values: 1 }
+          rank_histogram: {
+            buckets: { label: "alpha" sample_count: 5 }
+            buckets: { label: "beta" sample_count: 5 }
+          }
+        })");
+  const StringDomain original = ParseTextProtoOrDie<StringDomain>(
+      R"(name: "MyEnum" value: "alpha" value: "beta")");
+  const StringDomainValues domain_values = GetStringDomainValues(original);
+  StringDomain to_modify = ParseTextProtoOrDie<StringDomain>(
+      R"(name: "MyEnum" value: "alpha")");
+  const testing::DatasetForTesting dataset(stats);
+  const UpdateSummary summary = UpdateStringDomain(
+      Schema::Updater(GetDefaultFeatureStatisticsToProtoConfig()),
+      dataset.feature_stats_view(), 0, &domain_values, &to_modify);
+  EXPECT_TRUE(summary.descriptions.empty());
+  EXPECT_THAT(to_modify, EqualsProto(R"(name: "MyEnum" value: "alpha")"));
+}
+
+TEST(Enum, GetSimilarStringDomainCandidates) {
+  std::vector<StringDomain> domains;
+  // Domains 0 and 2 are identical, and domains 1 and 3 have a Jaccard
+  // similarity of 0.9. Domain 4 shares nothing with the others.
+  for (int i = 0; i < 5; ++i) {
+    domains.emplace_back();
+  }
+  for (int value = 0; value < 100; ++value) {
+    domains[0].add_value(absl::StrCat("a", value));
+    domains[2].add_value(absl::StrCat("a", value));
+    domains[4].add_value(absl::StrCat("c", value));
+  }
+  for (int value = 0; value < 95; ++value) {
+    domains[1].add_value(absl::StrCat("b", value));
+    domains[3].add_value(absl::StrCat("b", value + 5));
+  }
+  // Small identical domains are similar whatever min_count is.
+  domains.emplace_back();
+  domains.back().add_value("x");
+  domains.push_back(domains.back());
+
+  std::vector<StringDomainValues> values;
+  for (const StringDomain& domain : domains) {
+    values.push_back(GetStringDomainValues(domain));
+  }
+  for (double min_jaccard_similarity : {0.0, 0.5, 0.8, 1.0}) {
+    EnumsSimilarConfig config;
+    config.set_min_jaccard_similarity(min_jaccard_similarity);
+    const std::vector<std::pair<int, int>> candidates =
+        GetSimilarStringDomainCandidates(values, config);
+    EXPECT_THAT(candidates, ::testing::Contains(std::make_pair(0, 2)));
+    EXPECT_THAT(candidates, ::testing::Contains(std::make_pair(5, 6)));
+    if (min_jaccard_similarity < 0.9) {
+      EXPECT_THAT(candidates, ::testing::Contains(std::make_pair(1, 3)));
+    }
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_THAT(candidates,
+                  ::testing::Not(::testing::Contains(std::make_pair(i, 4))));
+    }
+    EXPECT_TRUE(std::is_sorted(candidates.begin(), candidates.end()));
+  }
+}
+
 TEST(Enum, IsCandidate) {
   const FeatureNameStatistics stats =
       ParseTextProtoOrDie<FeatureNameStatistics>(R"(
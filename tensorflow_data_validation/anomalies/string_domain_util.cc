@@ -16,20 +16,25 @@ limitations under the License.
 #include "tensorflow_data_validation/anomalies/string_domain_util.h"
 
 #include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
-#include "absl/strings/escaping.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
-#include "absl/types/optional.h"
 #include "tensorflow_data_validation/anomalies/map_util.h"
 #include "tensorflow_data_validation/anomalies/proto/feature_statistics_to_proto.pb.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
@@ -43,23 +48,20 @@ namespace {
 using ::tensorflow::metadata::v0::StringDomain;
 using ::tensorflow::strings::Printf;
 
-std::set<string> GetStringDomainValues(const StringDomain& string_domain) {
-  std::set<string> result;
-  for (const string& value : string_domain.value()) {
-    result.insert(value);
-  }
-  return result;
-}
+// The z-score of the confidence intervals of the statistics computed over a
+// sample of the examples, as in the statistics generators.
+constexpr double kSamplingZScore = 1.96;
 
-std::map<string, double> StringDomainGetMissing(
-    const FeatureStatsView& stats, const StringDomain& string_domain) {
+// Returns the values in <stats> for which is_valid(value) is false.
+template <typename IsValid>
+std::map<string, double> StringDomainGetMissing(const FeatureStatsView& stats,
+                                                const IsValid& is_valid) {
   // Missing values and their frequencies.
-  const std::set<string> valid = GetStringDomainValues(string_domain);
   std::map<string, double> missing;
   // Iterate over values in <stats> and mark those that are missing.
   for (const auto& p : stats.GetStringValuesWithCounts()) {
     const string& value = p.first;
-    if (!ContainsKey(valid, value)) {
+    if (!is_valid(value)) {
       missing.insert(p);
     }
   }
@@ -74,34 +76,97 @@ void StringDomainAddMissing(const std::map<string, double>& missing,
   }
 }
 
-// Returns a string representation of <count>/<total> as a percentage. If
-// the ratio is less than 1% then the string "<1%" is returned, otherwise it
-// returns the string "~x%" where x is the floor of the ratio.
-// If total is undefined, return "?".
-string PercentageAsString(double count, absl::optional<double> total) {
-  if ((total == absl::nullopt) || (*total == 0.0)) {
-    return "?";
-  }
-  double percent = 100 * count / *total;
-  if (percent < 1.0) {
-    return "<1%";
-  } else {
-    return Printf("~%d%%", static_cast<int>(floor(percent)));
+// The largest number of rows and bands used for locality-sensitive hashing.
+constexpr int kMaxRowsPerBand = 8;
+constexpr int kMaxBands = 64;
+// The probability to aim for of missing a pair of domains whose Jaccard
+// similarity is exactly min_jaccard_similarity.
+constexpr double kMaxMissProbability = 0.01;
+
+// Chooses the number of rows per band and of bands for locality-sensitive
+// hashing. Two domains with a Jaccard similarity s agree on a band with
+// probability s^rows_per_band, so they are missed with probability
+// (1 - s^rows_per_band)^num_bands. This chooses the most rows per band (i.e.,
+// the fewest pairs of dissimilar domains) such that the pairs with
+// s == min_jaccard_similarity are missed with probability at most
+// kMaxMissProbability, using at most kMaxBands bands.
+void GetLshParameters(double min_jaccard_similarity, int* rows_per_band,
+                      int* num_bands) {
+  if (min_jaccard_similarity >= 1.0) {
+    // Only identical domains are similar, and those always agree.
+    *rows_per_band = kMaxRowsPerBand;
+    *num_bands = 1;
+    return;
+  }
+  // Domains with no overlap are never similar (unless both are empty, which
+  // the exact check handles), so a small positive threshold is used instead.
+  const double threshold = std::max(min_jaccard_similarity, 0.01);
+  for (int rows = kMaxRowsPerBand; rows >= 1; --rows) {
+    const double band_probability = std::pow(threshold, rows);
+    const double bands = std::ceil(std::log(kMaxMissProbability) /
+                                   std::log1p(-band_probability));
+    if (bands <= kMaxBands) {
+      *rows_per_band = rows;
+      *num_bands = std::max(static_cast<int>(bands), 1);
+      return;
+    }
+  }
+  *rows_per_band = 1;
+  *num_bands = kMaxBands;
+}
+
+// Returns x scrambled, so that different inputs give independent-looking
+// outputs (the finalizer of SplitMix64).
+uint64 Scramble(uint64 x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Sets signature to the MinHash signature of values: for each of
+// signature_size hash functions, the smallest hash of a value.
+void GetMinHashSignature(const StringDomainValues& values, int signature_size,
+                         std::vector<uint64>* signature) {
+  signature->assign(signature_size, std::numeric_limits<uint64>::max());
+  for (const absl::string_view value : values) {
+    const uint64 value_hash = Hash64(value.data(), value.size());
+    for (int i = 0; i < signature_size; ++i) {
+      // Each hash function scrambles the hash of the value differently.
+      const uint64 hash =
+          Scramble(value_hash + (i + 1) * 0x9e3779b97f4a7c15ULL);
+      (*signature)[i] = std::min((*signature)[i], hash);
+    }
   }
 }
 
 }  // namespace
 
+StringDomainValues GetStringDomainValues(const StringDomain& string_domain) {
+  StringDomainValues result;
+  result.reserve(string_domain.value_size());
+  for (const string& value : string_domain.value()) {
+    result.insert(value);
+  }
+  return result;
+}
+
 bool IsSimilarStringDomain(const StringDomain& a, const StringDomain& b,
                            const EnumsSimilarConfig& config) {
+  return IsSimilarStringDomain(GetStringDomainValues(a),
+                               GetStringDomainValues(b), config);
+}
+
+bool IsSimilarStringDomain(const StringDomainValues& set_a,
+                           const StringDomainValues& set_b,
+                           const EnumsSimilarConfig& config) {
   // Check the overlap between the valid values in the two enums.
   int overlap = 0;
 
-  const std::set<string> set_a = GetStringDomainValues(a);
-  const std::set<string> set_b = GetStringDomainValues(b);
-
-  for (const auto& value : set_b) {
-    if (ContainsKey(set_a, value)) {
+  for (const absl::string_view value : set_b) {
+    if (set_a.contains(value)) {
       ++overlap;
     }
   }
@@ -115,15 +180,57 @@ bool IsSimilarStringDomain(const StringDomain& a, const StringDomain& b,
           jaccard_similarity == 1.0);
 }
 
+std::vector<std::pair<int, int>> GetSimilarStringDomainCandidates(
+    const std::vector<StringDomainValues>& domains,
+    const EnumsSimilarConfig& config) {
+  int rows_per_band;
+  int num_bands;
+  GetLshParameters(config.min_jaccard_similarity(), &rows_per_band,
+                   &num_bands);
+  const int signature_size = rows_per_band * num_bands;
+
+  // For each band, the domains whose signatures agree on all the rows of the
+  // band, keyed by a hash of those rows.
+  std::vector<absl::flat_hash_map<uint64, std::vector<int>>> buckets(
+      num_bands);
+  std::vector<uint64> signature;
+  for (int i = 0; i < domains.size(); ++i) {
+    GetMinHashSignature(domains[i], signature_size, &signature);
+    for (int band = 0; band < num_bands; ++band) {
+      uint64 key = 0;
+      for (int row = 0; row < rows_per_band; ++row) {
+        key = Hash64Combine(key, signature[band * rows_per_band + row]);
+      }
+      buckets[band][key].push_back(i);
+    }
+  }
+
+  // Indices within a bucket are increasing, as domains were added in order.
+  std::vector<std::pair<int, int>> result;
+  for (const auto& band_buckets : buckets) {
+    for (const auto& bucket : band_buckets) {
+      const std::vector<int>& indices = bucket.second;
+      for (int a = 0; a < indices.size(); ++a) {
+        for (int b = a + 1; b < indices.size(); ++b) {
+          result.emplace_back(indices[a], indices[b]);
+        }
+      }
+    }
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
 bool IsStringDomainCandidate(const FeatureStatsView& feature_stats,
                              const int enum_threshold) {
-  // HasInvalidUTF8Strings() and GetStringValues() both create a map
-  // of all the tokens in feature_stats to their frequency. Theoretically, we
-  // could do this once, but we sacrifice speed for simplicity.
+  // The map of all the tokens in feature_stats to their frequency is only
+  // built once, and shared with HasInvalidUTF8Strings().
   if (feature_stats.HasInvalidUTF8Strings()) {
     return false;
   }
-  const std::vector<string> values = feature_stats.GetStringValues();
+  const std::map<string, double>& values =
+      feature_stats.GetStringValuesWithCounts();
   return values.size() <= enum_threshold && !values.empty();
 }
 
@@ -156,6 +263,27 @@ UpdateSummary UpdateStringDomain(const Schema::Updater& updater,
                                  const FeatureStatsView& stats,
                                  double max_off_domain,
                                  StringDomain* string_domain) {
+  return UpdateStringDomain(updater, stats, max_off_domain,
+                            /*domain_values=*/nullptr, string_domain);
+}
+
+UpdateSummary UpdateStringDomain(const Schema::Updater& updater,
+                                 const FeatureStatsView& stats,
+                                 double max_off_domain,
+                                 const StringDomainValues* domain_values,
+                                 StringDomain* string_domain) {
+  return UpdateStringDomain(updater, stats, max_off_domain, domain_values,
+                            /*domain_filter=*/nullptr,
+                            /*domain_table=*/nullptr, *string_domain,
+                            [string_domain]() { return string_domain; });
+}
+
+UpdateSummary UpdateStringDomain(
+    const Schema::Updater& updater, const FeatureStatsView& stats,
+    double max_off_domain, const StringDomainValues* domain_values,
+    const StringDomainFilter* domain_filter, const StringTable* domain_table,
+    const StringDomain& string_domain,
+    const std::function<StringDomain*()>& mutable_string_domain) {
   UpdateSummary summary;
   if (stats.HasInvalidUTF8Strings()) {
     summary.descriptions.push_back(
@@ -167,42 +295,71 @@ UpdateSummary UpdateStringDomain(const Schema::Updater& updater,
     summary.clear_field = true;
     return summary;
   }
-  const std::map<string, double> missing =
-      StringDomainGetMissing(stats, *string_domain);
+  std::map<string, double> missing;
+  if (domain_table != nullptr) {
+    missing = StringDomainGetMissing(stats, [domain_table](const string& v) {
+      return domain_table->Contains(v);
+    });
+  } else if (domain_filter != nullptr) {
+    missing = StringDomainGetMissing(stats, [domain_filter](const string& v) {
+      return domain_filter->MayContain(v);
+    });
+  } else {
+    StringDomainValues collected_values;
+    if (domain_values == nullptr) {
+      collected_values = GetStringDomainValues(string_domain);
+      domain_values = &collected_values;
+    }
+    missing = StringDomainGetMissing(stats, [domain_values](const string& v) {
+      return domain_values->contains(v);
+    });
+  }
+  int domain_size = string_domain.value().size();
   // Total number of values in the dataset that do not appear in the schema.
-  const double missing_count = absl::c_accumulate(
+  double missing_count = absl::c_accumulate(
       missing, /*init=*/0.0,
       [](double count, const std::pair<const string, double>& p) -> double {
         return count + p.second;
       });
-  const double total_value_count = stats.GetTotalValueCountInExamples();
-  if ((missing_count / total_value_count) > max_off_domain ||
+  // Over a sample of the examples, the common statistics are scaled to all the
+  // examples, but the counts of the values are those of the sample.
+  const double sample_rate = stats.GetSampleRate();
+  const double total_value_count =
+      stats.GetTotalValueCountInExamples() * sample_rate;
+  if (domain_table == nullptr && domain_filter != nullptr) {
+    // The filter lets through about false_positive_rate of the values that are
+    // missing, so they are estimated from those that it catches.
+    missing_count = std::min(
+        total_value_count,
+        missing_count / (1.0 - domain_filter->false_positive_rate()));
+  }
+  double off_domain_fraction = missing_count / total_value_count;
+  if (sample_rate < 1.0 && total_value_count > 0.0) {
+    // Only the lower bound of the confidence interval of the fraction is
+    // compared with max_off_domain, so that sampling noise is not reported.
+    off_domain_fraction = std::max(
+        0.0, off_domain_fraction -
+                 kSamplingZScore *
+                     std::sqrt(off_domain_fraction *
+                               (1.0 - off_domain_fraction) /
+                               total_value_count));
+  }
+  if (off_domain_fraction > max_off_domain ||
       (max_off_domain == 0 && !missing.empty())) {
-    const Description description = {
-        tensorflow::metadata::v0::AnomalyInfo::
-            ENUM_TYPE_UNEXPECTED_STRING_VALUES,
-        "Unexpected string values",
-        absl::StrCat(
-            "Examples contain values missing from the schema: ",
-            absl::StrJoin(
-                missing, ", ",
-                [total_value_count](
-                    string* out,
-                    const std::pair<string, int64>& value_and_freq) {
-                  absl::StrAppend(
-                      out,
-                      Printf(
-                          "%s (%s)",
-                          absl::Utf8SafeCEscape(value_and_freq.first).c_str(),
-                          PercentageAsString(value_and_freq.second,
-                                             total_value_count)
-                              .c_str()));
-                }),
-            ". ")};
-    summary.descriptions.push_back(description);
-    StringDomainAddMissing(missing, string_domain);
-  }
-  const int domain_size = string_domain->value().size();
+    StringDomain* const updated_string_domain = mutable_string_domain();
+    StringDomainAddMissing(missing, updated_string_domain);
+    domain_size = updated_string_domain->value().size();
+    // The values are only formatted when the anomaly is reported.
+    auto values = std::make_shared<DescriptionValues>();
+    values->values_and_counts.assign(missing.begin(), missing.end());
+    values->total_count = total_value_count;
+    summary.descriptions.push_back(
+        {tensorflow::metadata::v0::AnomalyInfo::
+             ENUM_TYPE_UNEXPECTED_STRING_VALUES,
+         "Unexpected string values",
+         "Examples contain values missing from the schema: ",
+         std::move(values)});
+  }
   if (updater.string_domain_too_big(domain_size)) {
     summary.clear_field = true;
 
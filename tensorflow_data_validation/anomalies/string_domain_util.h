@@ -16,17 +16,26 @@ limitations under the License.
 #ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_DOMAIN_UTIL_H_
 #define TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_DOMAIN_UTIL_H_
 
+#include <functional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow_data_validation/anomalies/internal_types.h"
 #include "tensorflow_data_validation/anomalies/proto/feature_statistics_to_proto.pb.h"
 #include "tensorflow_data_validation/anomalies/schema.h"
 #include "tensorflow_data_validation/anomalies/statistics_view.h"
+#include "tensorflow_data_validation/anomalies/string_domain_filter.h"
+#include "tensorflow_data_validation/anomalies/string_table.h"
 #include "tensorflow_metadata/proto/v0/schema.pb.h"
 
 namespace tensorflow {
 namespace data_validation {
 
+// Returns the set of values of a string domain.
+StringDomainValues GetStringDomainValues(
+    const tensorflow::metadata::v0::StringDomain& string_domain);
+
 // True if two domains are similar. If they are "small" according to the
 // config.min_count, then they must be identical. Otherwise, they must
 // have a large jaccard similarity.
@@ -34,6 +43,22 @@ bool IsSimilarStringDomain(const tensorflow::metadata::v0::StringDomain& a,
                            const tensorflow::metadata::v0::StringDomain& b,
                            const EnumsSimilarConfig& config);
 
+// Same as above, for the values of two domains.
+bool IsSimilarStringDomain(const StringDomainValues& a,
+                           const StringDomainValues& b,
+                           const EnumsSimilarConfig& config);
+
+// Returns the pairs (i, j), with i < j, of domains that may be similar
+// according to config, sorted. This uses MinHash signatures and
+// locality-sensitive hashing, so it takes roughly linear time in the total
+// number of values, and pairs that are not similar are only returned with a
+// small probability. Identical domains are always returned; a pair of
+// domains whose Jaccard similarity is above config.min_jaccard_similarity()
+// is returned with a probability of about 99% or more.
+std::vector<std::pair<int, int>> GetSimilarStringDomainCandidates(
+    const std::vector<StringDomainValues>& domains,
+    const EnumsSimilarConfig& config);
+
 // Returns true if this feature_stats has less than enum_threshold number of
 // unique string values.
 bool IsStringDomainCandidate(const FeatureStatsView& feature_stats,
@@ -55,6 +80,33 @@ UpdateSummary UpdateStringDomain(
     const FeatureStatsView& stats, double max_off_domain,
     tensorflow::metadata::v0::StringDomain* string_domain);
 
+// Same as above, but if domain_values is not null, it holds the values of
+// string_domain (see GetStringDomainValues()), so that they are not
+// collected again.
+UpdateSummary UpdateStringDomain(
+    const Schema::Updater& updater,
+    const FeatureStatsView& stats, double max_off_domain,
+    const StringDomainValues* domain_values,
+    tensorflow::metadata::v0::StringDomain* string_domain);
+
+// Same as above, but only reads string_domain, and calls
+// mutable_string_domain() to get it for writing (e.g., after copying it into
+// an overlay) only if values must be added to it. If domain_filter is not
+// null, it holds the values of string_domain, and is used rather than
+// domain_values: the values missing from the domain are then an
+// approximation (see ApproximateStringDomainConfig). If domain_table is not
+// null, it is the sorted table of the distinct values of string_domain (see
+// CompiledSchemaImage), and is used rather than the other two.
+UpdateSummary UpdateStringDomain(
+    const Schema::Updater& updater,
+    const FeatureStatsView& stats, double max_off_domain,
+    const StringDomainValues* domain_values,
+    const StringDomainFilter* domain_filter,
+    const StringTable* domain_table,
+    const tensorflow::metadata::v0::StringDomain& string_domain,
+    const std::function<tensorflow::metadata::v0::StringDomain*()>&
+        mutable_string_domain);
+
 }  // namespace data_validation
 }  // namespace tensorflow
 
@@ -0,0 +1,84 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/string_table.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/coding.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+void AppendStringTable(const std::vector<string>& entries, string* output) {
+  core::PutFixed32(output, entries.size());
+  uint32 offset = 0;
+  core::PutFixed32(output, offset);
+  for (const string& entry : entries) {
+    offset += entry.size();
+    core::PutFixed32(output, offset);
+  }
+  for (const string& entry : entries) {
+    output->append(entry);
+  }
+}
+
+bool StringTable::Init(absl::string_view data) {
+  if (data.size() < 4) {
+    return false;
+  }
+  const uint32 size = core::DecodeFixed32(data.data());
+  const uint64 offsets_size = (static_cast<uint64>(size) + 1) * 4;
+  if (data.size() - 4 < offsets_size) {
+    return false;
+  }
+  size_ = size;
+  offsets_ = data.data() + 4;
+  entries_ = data.substr(4 + offsets_size);
+  return true;
+}
+
+absl::string_view StringTable::Get(uint32 i) const {
+  // The offsets are clamped, so that a corrupted table is never read out of
+  // bounds.
+  const size_t begin = std::min<size_t>(
+      core::DecodeFixed32(offsets_ + 4 * static_cast<size_t>(i)),
+      entries_.size());
+  const size_t end = std::min<size_t>(
+      core::DecodeFixed32(offsets_ + 4 * (static_cast<size_t>(i) + 1)),
+      entries_.size());
+  return entries_.substr(begin, end > begin ? end - begin : 0);
+}
+
+int64 StringTable::Find(absl::string_view value) const {
+  uint32 low = 0;
+  uint32 high = size_;
+  while (low < high) {
+    const uint32 middle = low + (high - low) / 2;
+    const int comparison = Get(middle).compare(value);
+    if (comparison == 0) {
+      return middle;
+    }
+    if (comparison < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return -1;
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,66 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A flat table of strings that is read in place (e.g., from a memory-mapped
+// CompiledSchemaImage) without being parsed. A table holds, as little-endian
+// uint32s, the number n of entries and n + 1 offsets of the entries from the
+// end of the offsets, followed by the entries. The entries of a sorted string
+// table are in increasing byte order.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_TABLE_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_TABLE_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// A view of a string table. A corrupted table may give wrong entries, but is
+// never read out of bounds.
+class StringTable {
+ public:
+  StringTable() = default;
+
+  // Views data, which must outlive this object. Only checks that the offsets
+  // fit in data. Returns false if they do not.
+  bool Init(absl::string_view data);
+
+  uint32 size() const { return size_; }
+
+  // Returns the i-th entry, where i < size().
+  absl::string_view Get(uint32 i) const;
+
+  // Returns the index of value in a sorted string table, or -1 if it is not
+  // there, in O(log(size())) time.
+  int64 Find(absl::string_view value) const;
+
+  bool Contains(absl::string_view value) const { return Find(value) >= 0; }
+
+ private:
+  uint32 size_ = 0;
+  // The offsets of the entries, followed by the entries.
+  const char* offsets_ = nullptr;
+  absl::string_view entries_;
+};
+
+// Appends a string table of entries to output.
+void AppendStringTable(const std::vector<string>& entries, string* output);
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_STRING_TABLE_H_
@@ -0,0 +1,68 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/string_table.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+TEST(StringTableTest, ReadsWhatIsAppended) {
+  const std::vector<string> entries = {"", "a", "bc", "bd"};
+  string data;
+  AppendStringTable(entries, &data);
+  StringTable table;
+  ASSERT_TRUE(table.Init(data));
+  ASSERT_EQ(entries.size(), table.size());
+  for (uint32 i = 0; i < table.size(); ++i) {
+    EXPECT_EQ(entries[i], table.Get(i));
+    EXPECT_EQ(i, table.Find(entries[i]));
+  }
+  EXPECT_TRUE(table.Contains("bc"));
+  EXPECT_FALSE(table.Contains("b"));
+  EXPECT_FALSE(table.Contains("c"));
+}
+
+TEST(StringTableTest, EmptyTable) {
+  string data;
+  AppendStringTable({}, &data);
+  StringTable table;
+  ASSERT_TRUE(table.Init(data));
+  EXPECT_EQ(0, table.size());
+  EXPECT_FALSE(table.Contains(""));
+}
+
+TEST(StringTableTest, NeverReadsOutOfBounds) {
+  string data;
+  AppendStringTable({"abc", "def"}, &data);
+  StringTable table;
+  // The offsets do not fit.
+  EXPECT_FALSE(table.Init(absl::string_view(data).substr(0, 10)));
+  // The entries are truncated, so the second one is empty.
+  ASSERT_TRUE(table.Init(absl::string_view(data).substr(0, data.size() - 3)));
+  EXPECT_EQ("abc", table.Get(0));
+  EXPECT_EQ("", table.Get(1));
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
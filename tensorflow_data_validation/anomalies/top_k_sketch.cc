@@ -0,0 +1,214 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/top_k_sketch.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow_data_validation/anomalies/proto/top_k_sketch.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+// Orders counters by decreasing count, then by decreasing value.
+bool IsMoreFrequent(const TopKSketch::Counter& a, const TopKSketch::Counter& b) {
+  if (a.count != b.count) {
+    return a.count > b.count;
+  }
+  return a.value > b.value;
+}
+
+}  // namespace
+
+TopKSketch::TopKSketch(int64 num_counters) : num_counters_(num_counters) {}
+
+void TopKSketch::Add(absl::string_view value, double weight) {
+  if (!(weight > 0.0)) {
+    return;
+  }
+  const auto it = index_.find(value);
+  if (it != index_.end()) {
+    counters_[it->second].count += weight;
+    SiftDown(heap_position_[it->second]);
+    return;
+  }
+  if (static_cast<int64>(counters_.size()) < num_counters_) {
+    const int64 index = counters_.size();
+    counters_.push_back({string(value), weight, 0.0});
+    index_[counters_.back().value] = index;
+    heap_.push_back(index);
+    heap_position_.push_back(index);
+    SiftUp(index);
+    return;
+  }
+  // Replaces the value with the smallest count.
+  const int64 index = heap_[0];
+  Counter& counter = counters_[index];
+  index_.erase(counter.value);
+  counter.value = string(value);
+  counter.error = counter.count;
+  counter.count += weight;
+  index_[counter.value] = index;
+  SiftDown(0);
+}
+
+void TopKSketch::Merge(const TopKSketch& other) {
+  if (&other == this) {
+    const TopKSketch copy = other;
+    Merge(copy);
+    return;
+  }
+  // A value that is not counted by a sketch weighs at most its min_count().
+  const double min_count = this->min_count();
+  const double other_min_count = other.min_count();
+  std::vector<Counter> merged;
+  merged.reserve(counters_.size() + other.counters_.size());
+  for (const Counter& counter : counters_) {
+    const auto it = other.index_.find(counter.value);
+    if (it == other.index_.end()) {
+      merged.push_back({counter.value, counter.count + other_min_count,
+                        counter.error + other_min_count});
+    } else {
+      const Counter& other_counter = other.counters_[it->second];
+      merged.push_back({counter.value, counter.count + other_counter.count,
+                        counter.error + other_counter.error});
+    }
+  }
+  for (const Counter& other_counter : other.counters_) {
+    if (index_.find(other_counter.value) == index_.end()) {
+      merged.push_back({other_counter.value, other_counter.count + min_count,
+                        other_counter.error + min_count});
+    }
+  }
+  Reset(std::move(merged));
+}
+
+std::vector<TopKSketch::Counter> TopKSketch::GetTopK(int64 k) const {
+  std::vector<Counter> result = counters_;
+  std::sort(result.begin(), result.end(), IsMoreFrequent);
+  if (static_cast<int64>(result.size()) > k) {
+    result.resize(std::max(k, int64{0}));
+  }
+  return result;
+}
+
+double TopKSketch::min_count() const {
+  if (static_cast<int64>(counters_.size()) < num_counters_) {
+    return 0.0;
+  }
+  return counters_[heap_[0]].count;
+}
+
+string TopKSketch::Serialize() const {
+  TopKSketchProto proto;
+  proto.set_num_counters(num_counters_);
+  proto.mutable_values()->Reserve(counters_.size());
+  proto.mutable_counts()->Reserve(counters_.size());
+  proto.mutable_errors()->Reserve(counters_.size());
+  for (const Counter& counter : counters_) {
+    proto.add_values(counter.value);
+    proto.add_counts(counter.count);
+    proto.add_errors(counter.error);
+  }
+  return proto.SerializeAsString();
+}
+
+Status TopKSketch::Deserialize(absl::string_view str, TopKSketch* result) {
+  TopKSketchProto proto;
+  if (!proto.ParseFromArray(str.data(), str.size())) {
+    return errors::InvalidArgument("Cannot parse a top-k sketch.");
+  }
+  const int size = proto.values_size();
+  if (proto.num_counters() <= 0 || size > proto.num_counters() ||
+      proto.counts_size() != size || proto.errors_size() != size) {
+    return errors::InvalidArgument("Invalid top-k sketch.");
+  }
+  std::vector<Counter> counters;
+  counters.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    counters.push_back({proto.values(i), proto.counts(i), proto.errors(i)});
+  }
+  *result = TopKSketch(proto.num_counters());
+  result->Reset(std::move(counters));
+  if (static_cast<int>(result->index_.size()) != size) {
+    return errors::InvalidArgument("Invalid top-k sketch: repeated values.");
+  }
+  return Status::OK();
+}
+
+void TopKSketch::SiftDown(int64 pos) {
+  const int64 size = heap_.size();
+  for (;;) {
+    const int64 left = 2 * pos + 1;
+    if (left >= size) {
+      return;
+    }
+    int64 child = left;
+    if (left + 1 < size &&
+        counters_[heap_[left + 1]].count < counters_[heap_[left]].count) {
+      child = left + 1;
+    }
+    if (!(counters_[heap_[child]].count < counters_[heap_[pos]].count)) {
+      return;
+    }
+    SwapInHeap(pos, child);
+    pos = child;
+  }
+}
+
+void TopKSketch::SiftUp(int64 pos) {
+  while (pos > 0) {
+    const int64 parent = (pos - 1) / 2;
+    if (!(counters_[heap_[pos]].count < counters_[heap_[parent]].count)) {
+      return;
+    }
+    SwapInHeap(pos, parent);
+    pos = parent;
+  }
+}
+
+void TopKSketch::SwapInHeap(int64 a, int64 b) {
+  std::swap(heap_[a], heap_[b]);
+  heap_position_[heap_[a]] = a;
+  heap_position_[heap_[b]] = b;
+}
+
+void TopKSketch::Reset(std::vector<Counter> counters) {
+  if (static_cast<int64>(counters.size()) > num_counters_) {
+    std::nth_element(counters.begin(), counters.begin() + num_counters_,
+                     counters.end(), IsMoreFrequent);
+    counters.resize(num_counters_);
+  }
+  counters_ = std::move(counters);
+  const int64 size = counters_.size();
+  index_.clear();
+  index_.reserve(size);
+  heap_.resize(size);
+  heap_position_.resize(size);
+  for (int64 i = 0; i < size; ++i) {
+    index_[counters_[i].value] = i;
+    heap_[i] = i;
+    heap_position_[i] = i;
+  }
+  for (int64 pos = size / 2 - 1; pos >= 0; --pos) {
+    SiftDown(pos);
+  }
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,104 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A mergeable sketch of the most frequent values of a stream of weighted
+// strings, used by ApproximateTopKStatsGenerator in
+// statistics/generators/top_k_stats_generator.py.
+//
+// This is the weighted SpaceSaving algorithm: the sketch counts at most
+// num_counters values. A value that is not counted replaces the value with
+// the smallest count, and inherits that count as its error. The count of a
+// value overestimates its weight by at most its error, and any value that is
+// not counted weighs at most min_count(). Merging two sketches as in
+// "Parallel Space Saving on Multi and Many-Core Processors" (Cafaro et al.)
+// keeps these bounds.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_TOP_K_SKETCH_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_TOP_K_SKETCH_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+class TopKSketch {
+ public:
+  struct Counter {
+    string value;
+    // An upper bound on the weight of value.
+    double count;
+    // count - error is a lower bound on the weight of value.
+    double error;
+  };
+
+  // num_counters must be positive.
+  explicit TopKSketch(int64 num_counters);
+
+  // Adds a value. Non-positive weights (and NaN) are ignored.
+  void Add(absl::string_view value, double weight);
+
+  // Adds the values of other, keeping num_counters() counters.
+  void Merge(const TopKSketch& other);
+
+  // Returns up to k counters with the largest counts. Counters with the same
+  // count are ordered by decreasing value, so that the result does not
+  // depend on the order of the values.
+  std::vector<Counter> GetTopK(int64 k) const;
+
+  // The smallest count if all the counters are used, and 0 otherwise. This
+  // is an upper bound on the weight of any value that is not counted.
+  double min_count() const;
+
+  // Serializes the sketch to a TopKSketchProto.
+  string Serialize() const;
+
+  // Deserializes a sketch serialized with Serialize().
+  static Status Deserialize(absl::string_view str, TopKSketch* result);
+
+  int64 num_counters() const { return num_counters_; }
+
+ private:
+  // Restores the heap order of the counter at position pos of heap_, whose
+  // count increased.
+  void SiftDown(int64 pos);
+
+  // Restores the heap order of the counter at position pos of heap_, which
+  // was just added.
+  void SiftUp(int64 pos);
+
+  // Swaps the counters at positions a and b of heap_.
+  void SwapInHeap(int64 a, int64 b);
+
+  // Replaces the counters with the num_counters_ largest of counters.
+  void Reset(std::vector<Counter> counters);
+
+  int64 num_counters_;
+  std::vector<Counter> counters_;
+  // The indices of counters_ in a min-heap ordered by count.
+  std::vector<int64> heap_;
+  // heap_position_[i] is the position of counters_[i] in heap_.
+  std::vector<int64> heap_position_;
+  // The index in counters_ of the counter of each value.
+  absl::flat_hash_map<string, int64> index_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_TOP_K_SKETCH_H_
@@ -0,0 +1,128 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/top_k_sketch.h"
+
+#include <map>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::testing::ElementsAre;
+
+MATCHER_P3(CounterIs, value, count, error, "") {
+  return arg.value == value && arg.count == count && arg.error == error;
+}
+
+TEST(TopKSketchTest, ExactWhileCountersAreLeft) {
+  TopKSketch sketch(3);
+  sketch.Add("a", 1.0);
+  sketch.Add("b", 2.0);
+  sketch.Add("a", 2.0);
+  EXPECT_EQ(0.0, sketch.min_count());
+  sketch.Add("c", 3.0);
+  // Values with no weight are ignored.
+  sketch.Add("d", 0.0);
+  EXPECT_EQ(2.0, sketch.min_count());
+  // "a" and "c" have the same count, so the larger value comes first.
+  EXPECT_THAT(sketch.GetTopK(5),
+              ElementsAre(CounterIs("c", 3.0, 0.0), CounterIs("a", 3.0, 0.0),
+                          CounterIs("b", 2.0, 0.0)));
+  EXPECT_THAT(sketch.GetTopK(1), ElementsAre(CounterIs("c", 3.0, 0.0)));
+}
+
+TEST(TopKSketchTest, ReplacesTheSmallestCount) {
+  TopKSketch sketch(2);
+  sketch.Add("a", 5.0);
+  sketch.Add("b", 1.0);
+  sketch.Add("c", 2.0);
+  EXPECT_EQ(3.0, sketch.min_count());
+  EXPECT_THAT(sketch.GetTopK(2),
+              ElementsAre(CounterIs("a", 5.0, 0.0), CounterIs("c", 3.0, 1.0)));
+}
+
+// Returns the true weights of the values added by AddSkewedValues.
+std::map<string, double> AddSkewedValues(int begin, int end,
+                                         TopKSketch* sketch) {
+  std::map<string, double> weights;
+  for (int i = begin; i < end; ++i) {
+    // Value v appears about 1000 / (v + 1) times.
+    for (int v = 0; v < 50; ++v) {
+      if (i % (v + 1) == 0) {
+        const string value = absl::StrCat("v", v);
+        sketch->Add(value, 1.0);
+        weights[value] += 1.0;
+      }
+    }
+    // Many values that appear once.
+    const string value = absl::StrCat("rare", i);
+    sketch->Add(value, 1.0);
+    weights[value] += 1.0;
+  }
+  return weights;
+}
+
+TEST(TopKSketchTest, MergedCountsAreWithinTheirErrors) {
+  TopKSketch sketch(20);
+  TopKSketch other(20);
+  std::map<string, double> weights = AddSkewedValues(0, 500, &sketch);
+  for (const auto& value_and_weight : AddSkewedValues(500, 1000, &other)) {
+    weights[value_and_weight.first] += value_and_weight.second;
+  }
+  sketch.Merge(other);
+  const std::vector<TopKSketch::Counter> top_k = sketch.GetTopK(5);
+  ASSERT_EQ(5, top_k.size());
+  EXPECT_EQ("v0", top_k[0].value);
+  EXPECT_EQ("v1", top_k[1].value);
+  for (const TopKSketch::Counter& counter : top_k) {
+    const double weight = weights[counter.value];
+    EXPECT_GE(counter.count, weight) << counter.value;
+    EXPECT_LE(counter.count - counter.error, weight) << counter.value;
+  }
+}
+
+TEST(TopKSketchTest, SerializeAndDeserialize) {
+  TopKSketch sketch(2);
+  sketch.Add("a", 5.0);
+  sketch.Add(string("\0\xff", 2), 1.0);
+  sketch.Add("c", 2.0);
+  TopKSketch result(1);
+  TF_ASSERT_OK(TopKSketch::Deserialize(sketch.Serialize(), &result));
+  EXPECT_EQ(2, result.num_counters());
+  EXPECT_EQ(sketch.min_count(), result.min_count());
+  EXPECT_THAT(result.GetTopK(2),
+              ElementsAre(CounterIs("a", 5.0, 0.0), CounterIs("c", 3.0, 1.0)));
+
+  // The deserialized sketch can still be updated.
+  result.Add("c", 3.0);
+  EXPECT_THAT(result.GetTopK(1), ElementsAre(CounterIs("c", 6.0, 1.0)));
+}
+
+TEST(TopKSketchTest, DeserializeInvalid) {
+  TopKSketch result(1);
+  EXPECT_FALSE(TopKSketch::Deserialize("not a sketch", &result).ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,206 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/uniques_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tensorflow_data_validation/anomalies/proto/uniques_sketch.pb.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+// Returns a hash of value in which every bit depends on every bit of the
+// fingerprint, as HyperLogLog reads the leading bits. The hash must not
+// change across processes, so that sketches can be merged.
+uint64 HashValue(absl::string_view value) {
+  // The finalizer of MurmurHash3.
+  uint64 hash = Hash64(value.data(), value.size());
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+}  // namespace
+
+constexpr int UniquesSketch::kMinPrecision;
+constexpr int UniquesSketch::kMaxPrecision;
+
+UniquesSketch::UniquesSketch(int precision) : precision_(precision) {}
+
+void UniquesSketch::Add(absl::string_view value) {
+  const uint64 hash = HashValue(value);
+  if (!is_sparse()) {
+    AddToRegisters(hash);
+    return;
+  }
+  hashes_.insert(hash);
+  // Converts once the hashes take more space than the registers.
+  if (hashes_.size() * sizeof(uint64) > (size_t{1} << precision_)) {
+    ConvertToDense();
+  }
+}
+
+Status UniquesSketch::Merge(const UniquesSketch& other) {
+  if (other.precision_ != precision_) {
+    return errors::InvalidArgument(
+        "Cannot merge a uniques sketch with precision ", other.precision_,
+        " into one with precision ", precision_);
+  }
+  if (&other == this) {
+    return Status::OK();
+  }
+  if (other.is_sparse()) {
+    for (const uint64 hash : other.hashes_) {
+      if (!is_sparse()) {
+        AddToRegisters(hash);
+        continue;
+      }
+      hashes_.insert(hash);
+      if (hashes_.size() * sizeof(uint64) > (size_t{1} << precision_)) {
+        ConvertToDense();
+      }
+    }
+    return Status::OK();
+  }
+  if (is_sparse()) {
+    ConvertToDense();
+  }
+  for (size_t i = 0; i < registers_.size(); ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+  return Status::OK();
+}
+
+double UniquesSketch::Estimate() const {
+  if (is_sparse()) {
+    return hashes_.size();
+  }
+  const double num_registers = registers_.size();
+  double sum = 0.0;
+  int64 num_zeros = 0;
+  for (const uint8 rank : registers_) {
+    sum += std::ldexp(1.0, -rank);
+    if (rank == 0) {
+      ++num_zeros;
+    }
+  }
+  double alpha;
+  switch (registers_.size()) {
+    case 16:
+      alpha = 0.673;
+      break;
+    case 32:
+      alpha = 0.697;
+      break;
+    case 64:
+      alpha = 0.709;
+      break;
+    default:
+      alpha = 0.7213 / (1.0 + 1.079 / num_registers);
+  }
+  const double estimate = alpha * num_registers * num_registers / sum;
+  if (estimate <= 2.5 * num_registers && num_zeros > 0) {
+    // Linear counting.
+    return num_registers * std::log(num_registers / num_zeros);
+  }
+  return estimate;
+}
+
+double UniquesSketch::relative_error() const {
+  if (is_sparse()) {
+    return 0.0;
+  }
+  return 1.04 / std::sqrt(static_cast<double>(registers_.size()));
+}
+
+string UniquesSketch::Serialize() const {
+  UniquesSketchProto proto;
+  proto.set_precision(precision_);
+  if (is_sparse()) {
+    std::vector<uint64> hashes(hashes_.begin(), hashes_.end());
+    std::sort(hashes.begin(), hashes.end());
+    proto.mutable_hashes()->Reserve(hashes.size());
+    for (const uint64 hash : hashes) {
+      proto.add_hashes(hash);
+    }
+  } else {
+    proto.set_registers(string(registers_.begin(), registers_.end()));
+  }
+  return proto.SerializeAsString();
+}
+
+Status UniquesSketch::Deserialize(absl::string_view str,
+                                  UniquesSketch* result) {
+  UniquesSketchProto proto;
+  if (!proto.ParseFromArray(str.data(), str.size())) {
+    return errors::InvalidArgument("Cannot parse a uniques sketch.");
+  }
+  const int precision = proto.precision();
+  if (precision < kMinPrecision || precision > kMaxPrecision) {
+    return errors::InvalidArgument("Invalid uniques sketch precision: ",
+                                   precision);
+  }
+  *result = UniquesSketch(precision);
+  if (proto.registers().empty()) {
+    result->hashes_.insert(proto.hashes().begin(), proto.hashes().end());
+    return Status::OK();
+  }
+  if (proto.hashes_size() > 0 ||
+      proto.registers().size() != (size_t{1} << precision)) {
+    return errors::InvalidArgument("Invalid uniques sketch.");
+  }
+  result->registers_.assign(proto.registers().begin(),
+                            proto.registers().end());
+  for (const uint8 rank : result->registers_) {
+    if (rank > 64 - precision + 1) {
+      return errors::InvalidArgument("Invalid uniques sketch register.");
+    }
+  }
+  return Status::OK();
+}
+
+void UniquesSketch::AddToRegisters(uint64 hash) {
+  const uint64 index = hash >> (64 - precision_);
+  // The rank is the position of the first 1 bit after the index bits.
+  const int max_rank = 64 - precision_ + 1;
+  uint64 bits = hash << precision_;
+  int rank = 1;
+  while (rank < max_rank && (bits & (uint64{1} << 63)) == 0) {
+    bits <<= 1;
+    ++rank;
+  }
+  if (registers_[index] < rank) {
+    registers_[index] = rank;
+  }
+}
+
+void UniquesSketch::ConvertToDense() {
+  registers_.assign(size_t{1} << precision_, 0);
+  for (const uint64 hash : hashes_) {
+    AddToRegisters(hash);
+  }
+  absl::flat_hash_set<uint64>().swap(hashes_);
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
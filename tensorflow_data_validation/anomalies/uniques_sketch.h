@@ -0,0 +1,89 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A mergeable sketch of the number of distinct strings in a stream, used by
+// ApproximateUniquesStatsGenerator in
+// statistics/generators/uniques_stats_generator.py.
+//
+// This is HyperLogLog with the 64-bit hashes and the sparse representation
+// of HyperLogLog++: the sketch keeps the distinct hashes of the values (so
+// that the count is exact, up to hash collisions) until they would take more
+// space than the 2^precision registers of HyperLogLog. The empirical bias
+// correction of HyperLogLog++ is not applied; instead, as in HyperLogLog, small
+// cardinalities are estimated by linear counting.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_UNIQUES_SKETCH_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_UNIQUES_SKETCH_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+class UniquesSketch {
+ public:
+  static constexpr int kMinPrecision = 4;
+  static constexpr int kMaxPrecision = 18;
+
+  // precision must be between kMinPrecision and kMaxPrecision.
+  explicit UniquesSketch(int precision);
+
+  void Add(absl::string_view value);
+
+  // Adds the values of other. Returns InvalidArgument if other has a
+  // different precision.
+  Status Merge(const UniquesSketch& other);
+
+  // Returns the estimated number of distinct values.
+  double Estimate() const;
+
+  // The standard error of Estimate(), relative to the number of distinct
+  // values: 0 while the sketch is sparse, and 1.04 / sqrt(2^precision)
+  // afterwards.
+  double relative_error() const;
+
+  // Serializes the sketch to a UniquesSketchProto.
+  string Serialize() const;
+
+  // Deserializes a sketch serialized with Serialize().
+  static Status Deserialize(absl::string_view str, UniquesSketch* result);
+
+  int precision() const { return precision_; }
+  bool is_sparse() const { return registers_.empty(); }
+
+ private:
+  // Adds a hash to the registers.
+  void AddToRegisters(uint64 hash);
+
+  // Moves the hashes to the registers.
+  void ConvertToDense();
+
+  int precision_;
+  // The distinct hashes, while the sketch is sparse.
+  absl::flat_hash_set<uint64> hashes_;
+  // The 2^precision_ registers, once the sketch is dense. Each holds the
+  // largest rank (the position of the first 1 bit after the register index)
+  // of the hashes of the register.
+  std::vector<uint8> registers_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_UNIQUES_SKETCH_H_
@@ -0,0 +1,90 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/uniques_sketch.h"
+
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+// Adds the values "x<begin>" to "x<end - 1>", twice each.
+void AddRange(int begin, int end, UniquesSketch* sketch) {
+  for (int i = begin; i < end; ++i) {
+    sketch->Add(absl::StrCat("x", i));
+    sketch->Add(absl::StrCat("x", i));
+  }
+}
+
+TEST(UniquesSketchTest, ExactWhileSparse) {
+  UniquesSketch sketch(14);
+  AddRange(0, 1000, &sketch);
+  EXPECT_TRUE(sketch.is_sparse());
+  EXPECT_EQ(1000.0, sketch.Estimate());
+  EXPECT_EQ(0.0, sketch.relative_error());
+}
+
+TEST(UniquesSketchTest, EstimateIsWithinTheRelativeError) {
+  for (const int num_values : {5000, 30000, 200000}) {
+    UniquesSketch sketch(12);
+    UniquesSketch other(12);
+    // The two sketches overlap by half of their values.
+    AddRange(0, num_values * 2 / 3, &sketch);
+    AddRange(num_values / 3, num_values, &other);
+    TF_ASSERT_OK(sketch.Merge(other));
+    EXPECT_FALSE(sketch.is_sparse());
+    EXPECT_NEAR(num_values, sketch.Estimate(),
+                3 * sketch.relative_error() * num_values);
+  }
+}
+
+TEST(UniquesSketchTest, MergeSparseIntoDense) {
+  UniquesSketch sketch(4);
+  AddRange(0, 100, &sketch);
+  UniquesSketch other(4);
+  AddRange(0, 1, &other);
+  EXPECT_TRUE(other.is_sparse());
+  const double estimate = sketch.Estimate();
+  TF_ASSERT_OK(sketch.Merge(other));
+  EXPECT_EQ(estimate, sketch.Estimate());
+  TF_ASSERT_OK(other.Merge(sketch));
+  EXPECT_EQ(estimate, other.Estimate());
+}
+
+TEST(UniquesSketchTest, SerializeAndDeserialize) {
+  for (const int num_values : {10, 10000}) {
+    UniquesSketch sketch(10);
+    AddRange(0, num_values, &sketch);
+    UniquesSketch result(4);
+    TF_ASSERT_OK(UniquesSketch::Deserialize(sketch.Serialize(), &result));
+    EXPECT_EQ(10, result.precision());
+    EXPECT_EQ(sketch.is_sparse(), result.is_sparse());
+    EXPECT_EQ(sketch.Estimate(), result.Estimate());
+  }
+}
+
+TEST(UniquesSketchTest, MergeWithDifferentPrecision) {
+  UniquesSketch sketch(10);
+  EXPECT_FALSE(sketch.Merge(UniquesSketch(12)).ok());
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -14,8 +14,22 @@ limitations under the License.
 ==============================================================================*/
 
 %{
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow_data_validation/anomalies/basic_stats_accumulators.h"
+#include "tensorflow_data_validation/anomalies/csv_batch_decoder.h"
+#include "tensorflow_data_validation/anomalies/example_batch_decoder.h"
 #include "tensorflow_data_validation/anomalies/feature_statistics_validator.h"
+#include "tensorflow_data_validation/anomalies/quantiles_sketch.h"
+#include "tensorflow_data_validation/anomalies/statistics_merger.h"
+#include "tensorflow_data_validation/anomalies/top_k_sketch.h"
+#include "tensorflow_data_validation/anomalies/uniques_sketch.h"
 
 #ifdef HAS_GLOBAL_STRING
   using ::string;
@@ -26,38 +40,1382 @@ limitations under the License.
 PyObject* ConvertToPythonString(const string& input_str) {
   return PyBytes_FromStringAndSize(input_str.data(), input_str.size());
 }
+
+namespace {
+
+// Owns a reference to a Python object.
+class PyObjectRef {
+ public:
+  explicit PyObjectRef(PyObject* object) : object_(object) {}
+  ~PyObjectRef() { Py_XDECREF(object_); }
+  PyObjectRef(const PyObjectRef&) = delete;
+  PyObjectRef& operator=(const PyObjectRef&) = delete;
+
+  PyObject* get() const { return object_; }
+
+ private:
+  PyObject* const object_;
+};
+
+// Views of a sequence of bytes objects.
+class BytesSequence {
+ public:
+  // Returns false (with a Python error set) if sequence is not a sequence of
+  // bytes objects. name is the name of the items in the error messages.
+  bool Init(PyObject* sequence, const string& name) {
+    items_.reset(new PyObjectRef(PySequence_Fast(
+        sequence, (name + " must be a sequence.").c_str())));
+    if (items_->get() == NULL) return false;
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(items_->get());
+    views_.reserve(size);
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      PyObject* item = PySequence_Fast_GET_ITEM(items_->get(), i);
+      if (!PyBytes_Check(item)) {
+        PyErr_SetString(PyExc_TypeError,
+                        (name + " must be bytes objects.").c_str());
+        return false;
+      }
+      views_.emplace_back(PyBytes_AS_STRING(item), PyBytes_GET_SIZE(item));
+    }
+    return true;
+  }
+
+  const std::vector<absl::string_view>& views() const { return views_; }
+
+ private:
+  // Keeps the bytes objects alive.
+  std::unique_ptr<PyObjectRef> items_;
+  std::vector<absl::string_view> views_;
+};
+
+// Converts a status that is not OK to a RuntimeError.
+PyObject* SetRuntimeError(const tensorflow::Status& status) {
+  PyErr_SetString(PyExc_RuntimeError, status.error_message().c_str());
+  return NULL;
+}
+
+// Serializes message into a new bytes object, without an intermediate string.
+// The GIL is released while the message is serialized.
+PyObject* SerializeToPythonBytes(
+    const google::protobuf::MessageLite& message) {
+  const size_t size = message.ByteSizeLong();
+  PyObject* result = PyBytes_FromStringAndSize(NULL, size);
+  if (result == NULL) return NULL;
+  uint8_t* const data =
+      reinterpret_cast<uint8_t*>(PyBytes_AS_STRING(result));
+  Py_BEGIN_ALLOW_THREADS
+  message.SerializeWithCachedSizesToArray(data);
+  Py_END_ALLOW_THREADS
+  return result;
+}
+
+}  // namespace
 %}
 
 %{
-PyObject* InferSchema(const string& statistics_proto_string,
-                      int max_string_domain_size) {
-  string schema_proto_string;
-  const tensorflow::Status status = tensorflow::data_validation::InferSchema(
-    statistics_proto_string, max_string_domain_size, &schema_proto_string);
+// The validation functions release the GIL while they run, so that they run in
+// parallel when called from several Python threads. Their arguments are views
+// of the buffers of bytes objects (see the absl::string_view typemap below),
+// which are immutable and which the caller keeps alive during the call.
+
+PyObject* InferSchema(absl::string_view statistics_proto_string,
+                      int max_string_domain_size, int num_threads) {
+  tensorflow::metadata::v0::Schema schema;
+  tensorflow::Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = tensorflow::data_validation::InferSchema(
+      statistics_proto_string, max_string_domain_size, num_threads, &schema);
+  Py_END_ALLOW_THREADS
+  if (!status.ok()) return SetRuntimeError(status);
+  return SerializeToPythonBytes(schema);
+}
+
+
+PyObject* ValidateFeatureStatistics(
+  absl::string_view statistics_proto_string,
+  absl::string_view schema_proto_string,
+  absl::string_view environment,
+  absl::string_view previous_statistics_proto_string,
+  absl::string_view serving_statistics_proto_string) {
+  tensorflow::metadata::v0::Anomalies anomalies;
+  tensorflow::Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = tensorflow::data_validation::ValidateFeatureStatistics(
+      statistics_proto_string, schema_proto_string, environment,
+      previous_statistics_proto_string, serving_statistics_proto_string,
+      &anomalies);
+  Py_END_ALLOW_THREADS
+  if (!status.ok()) return SetRuntimeError(status);
+  return SerializeToPythonBytes(anomalies);
+}
+
+PyObject* ValidateFeatureStatisticsBatch(
+  PyObject* statistics_proto_strings,
+  absl::string_view schema_proto_string,
+  absl::string_view environment,
+  int num_threads) {
+  BytesSequence statistics;
+  if (!statistics.Init(statistics_proto_strings, "statistics_proto_strings")) {
+    return NULL;
+  }
+  std::vector<tensorflow::metadata::v0::Anomalies> anomalies;
+  tensorflow::Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = tensorflow::data_validation::ValidateFeatureStatisticsBatch(
+      statistics.views(), schema_proto_string, environment, num_threads,
+      &anomalies);
+  Py_END_ALLOW_THREADS
+  if (!status.ok()) return SetRuntimeError(status);
+  PyObject* result = PyList_New(anomalies.size());
+  if (result == NULL) return NULL;
+  for (size_t i = 0; i < anomalies.size(); ++i) {
+    PyObject* item = SerializeToPythonBytes(anomalies[i]);
+    if (item == NULL) {
+      Py_DECREF(result);
+      return NULL;
+    }
+    // PyList_SET_ITEM steals the reference to item.
+    PyList_SET_ITEM(result, i, item);
+  }
+  return result;
+}
+%}
+
+%{
+// Native loops for the add_input() of the basic statistics generators (see
+// basic_stats_accumulators.h). Each function takes the values of a feature in
+// the examples of a batch (a sequence of numpy arrays or None) and returns a
+// dict of the partial statistics of the batch, or None if the values cannot
+// be read natively. In that case (e.g., for an unusual dtype, or if the type
+// of the feature changes within the batch), the generator falls back to its
+// Python loop, which also raises the errors.
+
+namespace {
+
+using tensorflow::int64;
+using tensorflow::data_validation::CommonStatsAccumulator;
+using tensorflow::data_validation::NumericStatsAccumulator;
+using tensorflow::data_validation::StringStatsAccumulator;
+using tensorflow::metadata::v0::FeatureNameStatistics;
+
+// Returns numpy.ndarray, or null if numpy cannot be imported.
+PyObject* GetNdarrayType() {
+  static PyObject* const ndarray_type = []() -> PyObject* {
+    PyObjectRef numpy(PyImport_ImportModule("numpy"));
+    PyObject* type = numpy.get() == NULL
+                         ? NULL
+                         : PyObject_GetAttrString(numpy.get(), "ndarray");
+    if (type == NULL) PyErr_Clear();
+    return type;
+  }();
+  return ndarray_type;
+}
+
+// Appends the UTF-8 encoding of a code point to *result.
+void AppendUtf8(char32_t code_point, string* result) {
+  if (code_point < 0x80) {
+    result->push_back(code_point);
+  } else if (code_point < 0x800) {
+    result->push_back(0xC0 | (code_point >> 6));
+    result->push_back(0x80 | (code_point & 0x3F));
+  } else if (code_point < 0x10000) {
+    result->push_back(0xE0 | (code_point >> 12));
+    result->push_back(0x80 | ((code_point >> 6) & 0x3F));
+    result->push_back(0x80 | (code_point & 0x3F));
+  } else {
+    result->push_back(0xF0 | (code_point >> 18));
+    result->push_back(0x80 | ((code_point >> 12) & 0x3F));
+    result->push_back(0x80 | ((code_point >> 6) & 0x3F));
+    result->push_back(0x80 | (code_point & 0x3F));
+  }
+}
+
+// The values of a feature in an example: a 1-D numpy array, read through
+// the buffer protocol if it is numeric or of fixed-size strings, or through
+// its items if it is an array of bytes or unicode objects.
+class ExampleValues {
+ public:
+  enum class Kind {
+    kInt8, kInt16, kInt32, kInt64, kFloat, kDouble, kStrings,
+  };
+
+  ExampleValues() = default;
+  ~ExampleValues() {
+    if (has_buffer_) PyBuffer_Release(&buffer_);
+  }
+  ExampleValues(const ExampleValues&) = delete;
+  ExampleValues& operator=(const ExampleValues&) = delete;
+
+  // Reads array, which must be a numpy.ndarray. Returns false if it cannot be
+  // read natively. Never leaves a Python error set.
+  bool Init(PyObject* array) {
+    if (PyObject_GetBuffer(array, &buffer_,
+                           PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) == 0) {
+      has_buffer_ = true;
+      return buffer_.ndim == 1 && InitFromBuffer();
+    }
+    // Arrays of objects do not export a buffer.
+    PyErr_Clear();
+    return InitFromObjects(array);
+  }
+
+  Kind kind() const { return kind_; }
+  FeatureNameStatistics::Type type() const {
+    switch (kind_) {
+      case Kind::kFloat:
+      case Kind::kDouble:
+        return FeatureNameStatistics::FLOAT;
+      case Kind::kStrings:
+        return FeatureNameStatistics::STRING;
+      default:
+        return FeatureNameStatistics::INT;
+    }
+  }
+  bool is_int() const { return type() == FeatureNameStatistics::INT; }
+  int64 size() const { return size_; }
+  // The total length of the values, if kind() is kStrings.
+  int64 total_string_length() const { return total_string_length_; }
+  // The values, if they are numeric.
+  const void* data() const { return buffer_.buf; }
+
+  // Calls fn(absl::string_view) on each value, if kind() is kStrings, with
+  // unicode values encoded in UTF-8. Returns false (with a Python error set)
+  // if a value cannot be encoded.
+  template <typename Fn>
+  bool VisitStrings(Fn fn) const {
+    if (items_ == nullptr) {
+      VisitPaddedStrings(fn);
+      return true;
+    }
+    PyObject** item = PySequence_Fast_ITEMS(items_->get());
+    for (int64 i = 0; i < size_; ++i) {
+      if (PyBytes_Check(item[i])) {
+        fn(absl::string_view(PyBytes_AS_STRING(item[i]),
+                             PyBytes_GET_SIZE(item[i])));
+        continue;
+      }
+#if PY_MAJOR_VERSION >= 3
+      Py_ssize_t length;
+      const char* utf8 = PyUnicode_AsUTF8AndSize(item[i], &length);
+      if (utf8 == NULL) return false;
+      fn(absl::string_view(utf8, length));
+#else
+      PyObjectRef utf8(PyUnicode_AsUTF8String(item[i]));
+      if (utf8.get() == NULL) return false;
+      fn(absl::string_view(PyBytes_AS_STRING(utf8.get()),
+                           PyBytes_GET_SIZE(utf8.get())));
+#endif
+    }
+    return true;
+  }
+
+ private:
+  bool InitFromBuffer() {
+    size_ = buffer_.shape[0];
+    const char* format = buffer_.format == NULL ? "B" : buffer_.format;
+    switch (*format) {
+      case '@':
+      case '=':
+        ++format;
+        break;
+      case '<':
+        if (!PY_LITTLE_ENDIAN) return false;
+        ++format;
+        break;
+      case '>':
+      case '!':
+        if (PY_LITTLE_ENDIAN) return false;
+        ++format;
+        break;
+    }
+    while (*format >= '0' && *format <= '9') ++format;
+    if (format[0] == '\0' || format[1] != '\0') return false;
+    const Py_ssize_t itemsize = buffer_.itemsize;
+    switch (*format) {
+      case 'b':
+      case 'h':
+      case 'i':
+      case 'l':
+      case 'q':
+        switch (itemsize) {
+          case 1: kind_ = Kind::kInt8; return true;
+          case 2: kind_ = Kind::kInt16; return true;
+          case 4: kind_ = Kind::kInt32; return true;
+          case 8: kind_ = Kind::kInt64; return true;
+        }
+        return false;
+      case 'f':
+        kind_ = Kind::kFloat;
+        return itemsize == sizeof(float);
+      case 'd':
+        kind_ = Kind::kDouble;
+        return itemsize == sizeof(double);
+      case 's':
+        // numpy.bytes_ values, padded with trailing NULs.
+        kind_ = Kind::kStrings;
+        char_size_ = 1;
+        total_string_length_ = GetPaddedLength<char>(itemsize);
+        return true;
+      case 'w':
+        // numpy.unicode_ values, in UCS4 padded with trailing NULs.
+        kind_ = Kind::kStrings;
+        if (itemsize % 4 != 0) return false;
+        char_size_ = 4;
+        total_string_length_ = GetPaddedLength<char32_t>(itemsize / 4);
+        return true;
+    }
+    return false;
+  }
+
+  // Returns the total length of size_ values of item_size characters of type
+  // C, excluding trailing NULs, as len() counts them.
+  template <typename C>
+  int64 GetPaddedLength(Py_ssize_t item_size) const {
+    const C* chars = static_cast<const C*>(buffer_.buf);
+    int64 result = 0;
+    for (int64 i = 0; i < size_; ++i) {
+      Py_ssize_t length = item_size;
+      while (length > 0 && chars[i * item_size + length - 1] == 0) --length;
+      result += length;
+    }
+    return result;
+  }
+
+  // Calls fn on the values of a buffer of numpy.bytes_ or numpy.unicode_.
+  template <typename Fn>
+  void VisitPaddedStrings(Fn fn) const {
+    const char* chars = static_cast<const char*>(buffer_.buf);
+    const Py_ssize_t itemsize = buffer_.itemsize;
+    string utf8;
+    for (int64 i = 0; i < size_; ++i) {
+      const char* item = chars + i * itemsize;
+      if (char_size_ == 1) {
+        Py_ssize_t length = itemsize;
+        while (length > 0 && item[length - 1] == 0) --length;
+        fn(absl::string_view(item, length));
+        continue;
+      }
+      const char32_t* code_points = reinterpret_cast<const char32_t*>(item);
+      Py_ssize_t length = itemsize / 4;
+      while (length > 0 && code_points[length - 1] == 0) --length;
+      utf8.clear();
+      for (Py_ssize_t j = 0; j < length; ++j) {
+        AppendUtf8(code_points[j], &utf8);
+      }
+      fn(absl::string_view(utf8));
+    }
+  }
+
+  bool InitFromObjects(PyObject* array) {
+    items_.reset(new PyObjectRef(PySequence_Fast(array, "")));
+    if (items_->get() == NULL) {
+      PyErr_Clear();
+      return false;
+    }
+    kind_ = Kind::kStrings;
+    size_ = PySequence_Fast_GET_SIZE(items_->get());
+    PyObject** item = PySequence_Fast_ITEMS(items_->get());
+    for (int64 i = 0; i < size_; ++i) {
+      if (PyBytes_Check(item[i])) {
+        total_string_length_ += PyBytes_GET_SIZE(item[i]);
+      } else if (PyUnicode_Check(item[i])) {
+#if PY_MAJOR_VERSION >= 3
+        total_string_length_ += PyUnicode_GetLength(item[i]);
+#else
+        total_string_length_ += PyUnicode_GET_SIZE(item[i]);
+#endif
+      } else {
+        // E.g., the items of a 2-D array, or numbers.
+        return false;
+      }
+    }
+    return true;
+  }
+
+  Py_buffer buffer_;
+  bool has_buffer_ = false;
+  Kind kind_ = Kind::kStrings;
+  int64 size_ = 0;
+  int64 total_string_length_ = 0;
+  // The size of a character of a buffer of strings: 1 for numpy.bytes_, and
+  // 4 for numpy.unicode_.
+  int char_size_ = 1;
+  // The values, if they are objects rather than a buffer.
+  std::unique_ptr<PyObjectRef> items_;
+};
+
+// Calls fn(const T* values, int64 size) on the values of a numeric example.
+template <typename Fn>
+auto VisitNumericValues(const ExampleValues& values, Fn fn)
+    -> decltype(fn(static_cast<const int64*>(nullptr), 0)) {
+  switch (values.kind()) {
+    case ExampleValues::Kind::kInt8:
+      return fn(static_cast<const tensorflow::int8*>(values.data()),
+                values.size());
+    case ExampleValues::Kind::kInt16:
+      return fn(static_cast<const tensorflow::int16*>(values.data()),
+                values.size());
+    case ExampleValues::Kind::kInt32:
+      return fn(static_cast<const tensorflow::int32*>(values.data()),
+                values.size());
+    case ExampleValues::Kind::kInt64:
+      return fn(static_cast<const int64*>(values.data()), values.size());
+    case ExampleValues::Kind::kFloat:
+      return fn(static_cast<const float*>(values.data()), values.size());
+    default:
+      return fn(static_cast<const double*>(values.data()), values.size());
+  }
+}
+
+struct AddNumericValues {
+  template <typename T>
+  tensorflow::Status operator()(const T* values, int64 size) const {
+    return accumulator->AddValues(values, size, weight);
+  }
+  NumericStatsAccumulator* accumulator;
+  double weight;
+};
+
+struct AddCategoricalValues {
+  template <typename T>
+  void operator()(const T* values, int64 size) const {
+    accumulator->AddIntValues(values, size);
+  }
+  // Only called for integral values.
+  void operator()(const float*, int64) const {}
+  void operator()(const double*, int64) const {}
+  StringStatsAccumulator* accumulator;
+};
+
+// The weights of the examples of a batch: None, or a 1-D array of float64
+// with one weight for each example.
+class ExampleWeights {
+ public:
+  ExampleWeights() = default;
+  ~ExampleWeights() {
+    if (has_buffer_) PyBuffer_Release(&buffer_);
+  }
+  ExampleWeights(const ExampleWeights&) = delete;
+  ExampleWeights& operator=(const ExampleWeights&) = delete;
+
+  // Returns false (with a Python error set) if weights are invalid.
+  bool Init(PyObject* weights, int64 num_examples) {
+    if (weights == Py_None) return true;
+    if (PyObject_GetBuffer(weights, &buffer_,
+                           PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0) {
+      return false;
+    }
+    has_buffer_ = true;
+    if (buffer_.ndim != 1 || buffer_.shape[0] != num_examples ||
+        buffer_.itemsize != sizeof(double) || buffer_.format == NULL ||
+        buffer_.format[strspn(buffer_.format, "@=")] != 'd') {
+      PyErr_SetString(PyExc_TypeError,
+                      "weights must be a float64 array with one weight for "
+                      "each example.");
+      return false;
+    }
+    return true;
+  }
+
+  bool has_weights() const { return has_buffer_; }
+  // The weight of example i, or 1 if there are no weights.
+  double weight(int64 i) const {
+    return has_buffer_ ? static_cast<const double*>(buffer_.buf)[i] : 1.0;
+  }
+
+ private:
+  Py_buffer buffer_;
+  bool has_buffer_ = false;
+};
+
+// Sets dict[key] to value, taking the reference to value.
+bool SetItem(PyObject* dict, const char* key, PyObject* value) {
+  if (value == NULL) return false;
+  const int result = PyDict_SetItemString(dict, key, value);
+  Py_DECREF(value);
+  return result == 0;
+}
+
+PyObject* ToPythonInt(int64 value) { return PyLong_FromLongLong(value); }
+
+PyObject* ToPythonType(bool has_type, FeatureNameStatistics::Type type) {
+  if (!has_type) {
+    Py_INCREF(Py_None);
+    return Py_None;
+  }
+  return ToPythonInt(type);
+}
+
+// Returns the values as a bytes object, which numpy.frombuffer() reads
+// without a copy.
+template <typename T>
+PyObject* ToPythonBytes(const std::vector<T>& values) {
+  return PyBytes_FromStringAndSize(reinterpret_cast<const char*>(values.data()),
+                                   values.size() * sizeof(T));
+}
+
+// Returns the values as a bytearray, which numpy.frombuffer() views without a
+// copy as a writable array.
+template <typename T>
+PyObject* ToPythonByteArray(const std::vector<T>& values) {
+  return PyByteArray_FromStringAndSize(
+      reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+// A fast sequence of the examples of a batch, along with their weights.
+class ExampleBatch {
+ public:
+  // Returns false (with a Python error set) if the batch is invalid.
+  bool Init(PyObject* values, PyObject* weights) {
+    items_.reset(new PyObjectRef(
+        PySequence_Fast(values, "values must be a sequence.")));
+    if (items_->get() == NULL) return false;
+    return weights_.Init(weights, size());
+  }
+
+  int64 size() const { return PySequence_Fast_GET_SIZE(items_->get()); }
+  PyObject* item(int64 i) const {
+    return PySequence_Fast_GET_ITEM(items_->get(), i);
+  }
+  // Returns true if item(i) is a numpy array.
+  bool is_array(int64 i) const {
+    return PyObject_TypeCheck(item(i),
+                              reinterpret_cast<PyTypeObject*>(
+                                  GetNdarrayType()));
+  }
+  const ExampleWeights& weights() const { return weights_; }
+
+ private:
+  std::unique_ptr<PyObjectRef> items_;
+  ExampleWeights weights_;
+};
+
+}  // namespace
+
+PyObject* GetCommonStatsOfBatch(PyObject* values, PyObject* weights) {
+  if (GetNdarrayType() == NULL) Py_RETURN_NONE;
+  ExampleBatch batch;
+  if (!batch.Init(values, weights)) return NULL;
+  CommonStatsAccumulator accumulator(batch.weights().has_weights());
+  for (int64 i = 0; i < batch.size(); ++i) {
+    const double weight = batch.weights().weight(i);
+    if (batch.item(i) == Py_None) {
+      accumulator.AddMissing(weight);
+      continue;
+    }
+    ExampleValues example;
+    if (!batch.is_array(i) || !example.Init(batch.item(i)) ||
+        !accumulator.AddValues(example.type(), example.size(), weight).ok()) {
+      Py_RETURN_NONE;
+    }
+  }
+  PyObjectRef result(PyDict_New());
+  if (result.get() == NULL ||
+      !SetItem(result.get(), "num_non_missing",
+               ToPythonInt(accumulator.num_non_missing())) ||
+      !SetItem(result.get(), "num_missing",
+               ToPythonInt(accumulator.num_missing())) ||
+      !SetItem(result.get(), "min_num_values",
+               ToPythonInt(accumulator.min_num_values())) ||
+      !SetItem(result.get(), "max_num_values",
+               ToPythonInt(accumulator.max_num_values())) ||
+      !SetItem(result.get(), "total_num_values",
+               ToPythonInt(accumulator.total_num_values())) ||
+      !SetItem(result.get(), "weighted_num_non_missing",
+               PyFloat_FromDouble(accumulator.weighted_num_non_missing())) ||
+      !SetItem(result.get(), "weighted_num_missing",
+               PyFloat_FromDouble(accumulator.weighted_num_missing())) ||
+      !SetItem(result.get(), "weighted_total_num_values",
+               PyFloat_FromDouble(accumulator.weighted_total_num_values())) ||
+      !SetItem(result.get(), "type",
+               ToPythonType(accumulator.has_type(), accumulator.type())) ||
+      !SetItem(result.get(), "num_values",
+               ToPythonBytes(accumulator.num_values()))) {
+    return NULL;
+  }
+  Py_INCREF(result.get());
+  return result.get();
+}
+
+PyObject* GetNumericStatsOfBatch(PyObject* values, PyObject* weights) {
+  if (GetNdarrayType() == NULL) Py_RETURN_NONE;
+  ExampleBatch batch;
+  if (!batch.Init(values, weights)) return NULL;
+  NumericStatsAccumulator accumulator(batch.weights().has_weights());
+  for (int64 i = 0; i < batch.size(); ++i) {
+    // Like NumericStatsGenerator, skips missing, empty and string values.
+    if (!batch.is_array(i)) continue;
+    ExampleValues example;
+    if (!example.Init(batch.item(i))) Py_RETURN_NONE;
+    if (example.size() == 0 ||
+        example.kind() == ExampleValues::Kind::kStrings) {
+      continue;
+    }
+    if (!VisitNumericValues(example,
+                            AddNumericValues{&accumulator,
+                                             batch.weights().weight(i)})
+             .ok()) {
+      Py_RETURN_NONE;
+    }
+  }
+  PyObjectRef result(PyDict_New());
+  if (result.get() == NULL ||
+      !SetItem(result.get(), "sum", PyFloat_FromDouble(accumulator.sum())) ||
+      !SetItem(result.get(), "sum_of_squares",
+               PyFloat_FromDouble(accumulator.sum_of_squares())) ||
+      !SetItem(result.get(), "num_zeros",
+               ToPythonInt(accumulator.num_zeros())) ||
+      !SetItem(result.get(), "num_nan", ToPythonInt(accumulator.num_nan())) ||
+      !SetItem(result.get(), "min", PyFloat_FromDouble(accumulator.min())) ||
+      !SetItem(result.get(), "max", PyFloat_FromDouble(accumulator.max())) ||
+      !SetItem(result.get(), "total_num_values",
+               ToPythonInt(accumulator.total_num_values())) ||
+      !SetItem(result.get(), "weighted_sum",
+               PyFloat_FromDouble(accumulator.weighted_sum())) ||
+      !SetItem(result.get(), "weighted_sum_of_squares",
+               PyFloat_FromDouble(accumulator.weighted_sum_of_squares())) ||
+      !SetItem(result.get(), "weighted_total_num_values",
+               PyFloat_FromDouble(accumulator.weighted_total_num_values())) ||
+      !SetItem(result.get(), "type",
+               ToPythonType(accumulator.has_type(), accumulator.type())) ||
+      !SetItem(result.get(), "values", ToPythonBytes(accumulator.values())) ||
+      !SetItem(result.get(), "weights",
+               ToPythonBytes(accumulator.weights()))) {
+    return NULL;
+  }
+  Py_INCREF(result.get());
+  return result.get();
+}
+
+PyObject* GetStringStatsOfBatch(PyObject* values, bool is_categorical) {
+  if (GetNdarrayType() == NULL) Py_RETURN_NONE;
+  ExampleBatch batch;
+  if (!batch.Init(values, Py_None)) return NULL;
+  StringStatsAccumulator accumulator;
+  for (int64 i = 0; i < batch.size(); ++i) {
+    // Like StringStatsGenerator, skips missing and empty values, and values
+    // that are not strings of a feature that is not categorical.
+    if (!batch.is_array(i)) continue;
+    ExampleValues example;
+    if (!example.Init(batch.item(i))) Py_RETURN_NONE;
+    if (example.size() == 0) continue;
+    if (is_categorical) {
+      // Other values of a categorical feature are converted to str, which
+      // is left to Python.
+      if (!example.is_int()) Py_RETURN_NONE;
+      VisitNumericValues(example, AddCategoricalValues{&accumulator});
+    } else if (example.kind() == ExampleValues::Kind::kStrings) {
+      accumulator.AddValues(example.size(), example.total_string_length());
+    }
+  }
+  PyObjectRef result(PyDict_New());
+  if (result.get() == NULL ||
+      !SetItem(result.get(), "total_bytes_length",
+               ToPythonInt(accumulator.total_bytes_length())) ||
+      !SetItem(result.get(), "total_num_values",
+               ToPythonInt(accumulator.total_num_values()))) {
+    return NULL;
+  }
+  Py_INCREF(result.get());
+  return result.get();
+}
+%}
+
+%{
+// A QuantilesSketch (see quantiles_sketch.h) for QuantilesCombiner in
+// utils/quantiles_util.py, held by a capsule.
+
+namespace {
+
+using tensorflow::data_validation::QuantilesSketch;
+
+constexpr char kQuantilesSketchCapsuleName[] = "QuantilesSketch";
+
+template <typename T>
+void DeleteCapsule(PyObject* capsule) {
+  delete static_cast<T*>(
+      PyCapsule_GetPointer(capsule, PyCapsule_GetName(capsule)));
+}
+
+// Returns a capsule named name that owns object.
+template <typename T>
+PyObject* ToPythonCapsule(std::unique_ptr<T> object, const char* name) {
+  PyObject* capsule = PyCapsule_New(object.get(), name, DeleteCapsule<T>);
+  if (capsule != NULL) object.release();
+  return capsule;
+}
+
+// Returns the object of capsule, or null (with a Python error set) if
+// capsule is not named name.
+template <typename T>
+T* FromPythonCapsule(PyObject* capsule, const char* name) {
+  return static_cast<T*>(PyCapsule_GetPointer(capsule, name));
+}
+
+QuantilesSketch* GetQuantilesSketch(PyObject* capsule) {
+  return FromPythonCapsule<QuantilesSketch>(capsule,
+                                            kQuantilesSketchCapsuleName);
+}
+
+// A 1-D array of float64, read through the buffer protocol.
+class Float64Array {
+ public:
+  Float64Array() = default;
+  ~Float64Array() {
+    if (has_buffer_) PyBuffer_Release(&buffer_);
+  }
+  Float64Array(const Float64Array&) = delete;
+  Float64Array& operator=(const Float64Array&) = delete;
+
+  // Returns false (with a Python error set) if array is not a 1-D array of
+  // float64. name is the name of the array in the error.
+  bool Init(PyObject* array, const char* name) {
+    if (PyObject_GetBuffer(array, &buffer_,
+                           PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0) {
+      return false;
+    }
+    has_buffer_ = true;
+    if (buffer_.ndim != 1 || buffer_.itemsize != sizeof(double) ||
+        buffer_.format == NULL ||
+        buffer_.format[strspn(buffer_.format, "@=")] != 'd') {
+      PyErr_Format(PyExc_TypeError, "%s must be a 1-D float64 array.", name);
+      return false;
+    }
+    return true;
+  }
+
+  const double* data() const {
+    return static_cast<const double*>(buffer_.buf);
+  }
+  int64 size() const { return buffer_.shape[0]; }
+
+ private:
+  Py_buffer buffer_;
+  bool has_buffer_ = false;
+};
+
+}  // namespace
+
+PyObject* CreateQuantilesSketch(double epsilon) {
+  if (!(epsilon >= 0.0)) {
+    PyErr_SetString(PyExc_ValueError, "epsilon must not be negative.");
+    return NULL;
+  }
+  return ToPythonCapsule(
+      std::unique_ptr<QuantilesSketch>(new QuantilesSketch(epsilon)),
+      kQuantilesSketchCapsuleName);
+}
+
+PyObject* AddToQuantilesSketch(PyObject* sketch, PyObject* values,
+                               PyObject* weights) {
+  QuantilesSketch* const quantiles_sketch = GetQuantilesSketch(sketch);
+  if (quantiles_sketch == NULL) return NULL;
+  Float64Array values_array;
+  if (!values_array.Init(values, "values")) return NULL;
+  Float64Array weights_array;
+  if (weights != Py_None) {
+    if (!weights_array.Init(weights, "weights")) return NULL;
+    if (weights_array.size() != values_array.size()) {
+      PyErr_SetString(PyExc_ValueError,
+                      "values and weights must have the same size.");
+      return NULL;
+    }
+  }
+  quantiles_sketch->AddValues(
+      values_array.data(), weights == Py_None ? nullptr : weights_array.data(),
+      values_array.size());
+  Py_RETURN_NONE;
+}
+
+PyObject* MergeQuantilesSketches(PyObject* sketch, PyObject* other) {
+  QuantilesSketch* const quantiles_sketch = GetQuantilesSketch(sketch);
+  if (quantiles_sketch == NULL) return NULL;
+  const QuantilesSketch* const other_sketch = GetQuantilesSketch(other);
+  if (other_sketch == NULL) return NULL;
+  const tensorflow::Status status = quantiles_sketch->Merge(*other_sketch);
   if (!status.ok()) {
     PyErr_SetString(PyExc_RuntimeError, status.error_message().c_str());
     return NULL;
   }
-  return ConvertToPythonString(schema_proto_string);
+  Py_RETURN_NONE;
 }
 
+// Returns the boundaries of QuantilesSketch::GetQuantiles() as the bytes of
+// float64 values.
+PyObject* GetQuantilesOfSketch(PyObject* sketch, int num_quantiles) {
+  const QuantilesSketch* const quantiles_sketch = GetQuantilesSketch(sketch);
+  if (quantiles_sketch == NULL) return NULL;
+  return ToPythonBytes(quantiles_sketch->GetQuantiles(num_quantiles));
+}
 
-PyObject* ValidateFeatureStatistics(
-  const string& statistics_proto_string,
-  const string& schema_proto_string,
-  const string& environment,
-  const string& previous_statistics_proto_string,
-  const string& serving_statistics_proto_string) {
-  string anomalies_proto_string;
-  const tensorflow::Status status = tensorflow::data_validation::ValidateFeatureStatistics(
-    statistics_proto_string, schema_proto_string, environment,
-    previous_statistics_proto_string, serving_statistics_proto_string,
-    &anomalies_proto_string);
+PyObject* SerializeQuantilesSketch(PyObject* sketch) {
+  const QuantilesSketch* const quantiles_sketch = GetQuantilesSketch(sketch);
+  if (quantiles_sketch == NULL) return NULL;
+  return ConvertToPythonString(quantiles_sketch->Serialize());
+}
+
+PyObject* DeserializeQuantilesSketch(const string& serialized_sketch) {
+  std::unique_ptr<QuantilesSketch> sketch(new QuantilesSketch(0.0));
+  const tensorflow::Status status =
+      QuantilesSketch::Deserialize(serialized_sketch, sketch.get());
   if (!status.ok()) {
     PyErr_SetString(PyExc_RuntimeError, status.error_message().c_str());
     return NULL;
   }
-  return ConvertToPythonString(anomalies_proto_string);
+  return ToPythonCapsule(std::move(sketch), kQuantilesSketchCapsuleName);
+}
+%}
+
+%{
+// A TopKSketch (see top_k_sketch.h) for ApproximateTopKStatsGenerator, and a
+// UniquesSketch (see uniques_sketch.h) for ApproximateUniquesStatsGenerator,
+// each held by a capsule. Each sketch is updated with the string values of a
+// feature in the examples of a batch (a sequence of numpy arrays or None).
+
+namespace {
+
+using tensorflow::data_validation::TopKSketch;
+using tensorflow::data_validation::UniquesSketch;
+
+constexpr char kTopKSketchCapsuleName[] = "TopKSketch";
+constexpr char kUniquesSketchCapsuleName[] = "UniquesSketch";
+
+// Calls fn(absl::string_view value, double weight) on the values of the
+// examples of batch that are not None. Returns false (with a Python error
+// set) if an example is not an array of strings.
+template <typename Fn>
+bool VisitStringValues(const ExampleBatch& batch, Fn fn) {
+  for (int64 i = 0; i < batch.size(); ++i) {
+    if (batch.item(i) == Py_None) continue;
+    ExampleValues example;
+    if (!batch.is_array(i) || !example.Init(batch.item(i)) ||
+        example.kind() != ExampleValues::Kind::kStrings) {
+      PyErr_SetString(PyExc_TypeError,
+                      "values must be arrays of bytes or unicode.");
+      return false;
+    }
+    const double weight = batch.weights().weight(i);
+    if (!example.VisitStrings(
+            [&fn, weight](absl::string_view value) { fn(value, weight); })) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+PyObject* CreateTopKSketch(int num_counters) {
+  if (num_counters <= 0) {
+    PyErr_SetString(PyExc_ValueError, "num_counters must be positive.");
+    return NULL;
+  }
+  return ToPythonCapsule(
+      std::unique_ptr<TopKSketch>(new TopKSketch(num_counters)),
+      kTopKSketchCapsuleName);
+}
+
+PyObject* AddToTopKSketch(PyObject* sketch, PyObject* values,
+                          PyObject* weights) {
+  TopKSketch* const top_k_sketch =
+      FromPythonCapsule<TopKSketch>(sketch, kTopKSketchCapsuleName);
+  if (top_k_sketch == NULL) return NULL;
+  ExampleBatch batch;
+  if (!batch.Init(values, weights)) return NULL;
+  if (!VisitStringValues(batch, [top_k_sketch](absl::string_view value,
+                                               double weight) {
+        top_k_sketch->Add(value, weight);
+      })) {
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
+PyObject* MergeTopKSketches(PyObject* sketch, PyObject* other) {
+  TopKSketch* const top_k_sketch =
+      FromPythonCapsule<TopKSketch>(sketch, kTopKSketchCapsuleName);
+  if (top_k_sketch == NULL) return NULL;
+  const TopKSketch* const other_sketch =
+      FromPythonCapsule<TopKSketch>(other, kTopKSketchCapsuleName);
+  if (other_sketch == NULL) return NULL;
+  top_k_sketch->Merge(*other_sketch);
+  Py_RETURN_NONE;
+}
+
+// Returns the counters of TopKSketch::GetTopK() as a list of
+// (value, count, error) tuples, where value is bytes.
+PyObject* GetTopKOfSketch(PyObject* sketch, int k) {
+  const TopKSketch* const top_k_sketch =
+      FromPythonCapsule<TopKSketch>(sketch, kTopKSketchCapsuleName);
+  if (top_k_sketch == NULL) return NULL;
+  const std::vector<TopKSketch::Counter> top_k = top_k_sketch->GetTopK(k);
+  PyObjectRef result(PyList_New(top_k.size()));
+  if (result.get() == NULL) return NULL;
+  for (size_t i = 0; i < top_k.size(); ++i) {
+    PyObject* counter = PyTuple_New(3);
+    if (counter == NULL) return NULL;
+    PyList_SET_ITEM(result.get(), i, counter);
+    PyObject* value = PyBytes_FromStringAndSize(top_k[i].value.data(),
+                                                top_k[i].value.size());
+    if (value == NULL) return NULL;
+    PyTuple_SET_ITEM(counter, 0, value);
+    PyObject* count = PyFloat_FromDouble(top_k[i].count);
+    if (count == NULL) return NULL;
+    PyTuple_SET_ITEM(counter, 1, count);
+    PyObject* error = PyFloat_FromDouble(top_k[i].error);
+    if (error == NULL) return NULL;
+    PyTuple_SET_ITEM(counter, 2, error);
+  }
+  Py_INCREF(result.get());
+  return result.get();
+}
+
+PyObject* SerializeTopKSketch(PyObject* sketch) {
+  const TopKSketch* const top_k_sketch =
+      FromPythonCapsule<TopKSketch>(sketch, kTopKSketchCapsuleName);
+  if (top_k_sketch == NULL) return NULL;
+  return ConvertToPythonString(top_k_sketch->Serialize());
+}
+
+PyObject* DeserializeTopKSketch(const string& serialized_sketch) {
+  std::unique_ptr<TopKSketch> sketch(new TopKSketch(1));
+  const tensorflow::Status status =
+      TopKSketch::Deserialize(serialized_sketch, sketch.get());
+  if (!status.ok()) return SetRuntimeError(status);
+  return ToPythonCapsule(std::move(sketch), kTopKSketchCapsuleName);
+}
+
+PyObject* CreateUniquesSketch(int precision) {
+  if (precision < UniquesSketch::kMinPrecision ||
+      precision > UniquesSketch::kMaxPrecision) {
+    PyErr_Format(PyExc_ValueError, "precision must be between %d and %d.",
+                 UniquesSketch::kMinPrecision, UniquesSketch::kMaxPrecision);
+    return NULL;
+  }
+  return ToPythonCapsule(
+      std::unique_ptr<UniquesSketch>(new UniquesSketch(precision)),
+      kUniquesSketchCapsuleName);
+}
+
+PyObject* AddToUniquesSketch(PyObject* sketch, PyObject* values) {
+  UniquesSketch* const uniques_sketch =
+      FromPythonCapsule<UniquesSketch>(sketch, kUniquesSketchCapsuleName);
+  if (uniques_sketch == NULL) return NULL;
+  ExampleBatch batch;
+  if (!batch.Init(values, Py_None)) return NULL;
+  if (!VisitStringValues(batch,
+                         [uniques_sketch](absl::string_view value, double) {
+                           uniques_sketch->Add(value);
+                         })) {
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
+PyObject* MergeUniquesSketches(PyObject* sketch, PyObject* other) {
+  UniquesSketch* const uniques_sketch =
+      FromPythonCapsule<UniquesSketch>(sketch, kUniquesSketchCapsuleName);
+  if (uniques_sketch == NULL) return NULL;
+  const UniquesSketch* const other_sketch =
+      FromPythonCapsule<UniquesSketch>(other, kUniquesSketchCapsuleName);
+  if (other_sketch == NULL) return NULL;
+  const tensorflow::Status status = uniques_sketch->Merge(*other_sketch);
+  if (!status.ok()) return SetRuntimeError(status);
+  Py_RETURN_NONE;
+}
+
+// Returns the (estimate, relative_error) tuple of the sketch.
+PyObject* GetUniquesOfSketch(PyObject* sketch) {
+  const UniquesSketch* const uniques_sketch =
+      FromPythonCapsule<UniquesSketch>(sketch, kUniquesSketchCapsuleName);
+  if (uniques_sketch == NULL) return NULL;
+  return Py_BuildValue("(dd)", uniques_sketch->Estimate(),
+                       uniques_sketch->relative_error());
+}
+
+PyObject* SerializeUniquesSketch(PyObject* sketch) {
+  const UniquesSketch* const uniques_sketch =
+      FromPythonCapsule<UniquesSketch>(sketch, kUniquesSketchCapsuleName);
+  if (uniques_sketch == NULL) return NULL;
+  return ConvertToPythonString(uniques_sketch->Serialize());
+}
+
+PyObject* DeserializeUniquesSketch(const string& serialized_sketch) {
+  std::unique_ptr<UniquesSketch> sketch(
+      new UniquesSketch(UniquesSketch::kMinPrecision));
+  const tensorflow::Status status =
+      UniquesSketch::Deserialize(serialized_sketch, sketch.get());
+  if (!status.ok()) return SetRuntimeError(status);
+  return ToPythonCapsule(std::move(sketch), kUniquesSketchCapsuleName);
+}
+%}
+
+%{
+// Decodes a sequence of serialized tf.Examples (bytes objects) for
+// TFExampleDecoder.decode_batch() in coders/tf_example_decoder.py. Returns a
+// dict from each feature name to the (kind, values, row_offsets, has_values)
+// tuple of its FeatureColumn (see example_batch_decoder.h), where kind is one
+// of 'int64', 'float' and 'bytes', or None if no example has values; values
+// is a bytearray of int64 or float32 values, or a list of bytes objects;
+// row_offsets is a bytearray of int64 values and has_values one of uint8
+// values. Raises ValueError if the examples cannot be decoded.
+
+namespace {
+
+using tensorflow::data_validation::FeatureColumn;
+
+// Returns the values of column as described above.
+PyObject* ToPythonValues(const FeatureColumn& column) {
+  switch (column.kind) {
+    case FeatureColumn::Kind::kInt64:
+      return ToPythonByteArray(column.int64_values);
+    case FeatureColumn::Kind::kFloat:
+      return ToPythonByteArray(column.float_values);
+    case FeatureColumn::Kind::kDouble:
+      return ToPythonByteArray(column.double_values);
+    case FeatureColumn::Kind::kBytes:
+      break;
+    case FeatureColumn::Kind::kNone:
+      return PyList_New(0);
+  }
+  PyObjectRef result(PyList_New(column.bytes_values.size()));
+  if (result.get() == NULL) return NULL;
+  for (size_t i = 0; i < column.bytes_values.size(); ++i) {
+    PyObject* value = PyBytes_FromStringAndSize(
+        column.bytes_values[i].data(), column.bytes_values[i].size());
+    if (value == NULL) return NULL;
+    PyList_SET_ITEM(result.get(), i, value);
+  }
+  Py_INCREF(result.get());
+  return result.get();
+}
+
+const char* KindName(FeatureColumn::Kind kind) {
+  switch (kind) {
+    case FeatureColumn::Kind::kInt64:
+      return "int64";
+    case FeatureColumn::Kind::kFloat:
+      return "float";
+    case FeatureColumn::Kind::kDouble:
+      return "double";
+    case FeatureColumn::Kind::kBytes:
+      return "bytes";
+    case FeatureColumn::Kind::kNone:
+      break;
+  }
+  // Py_BuildValue() converts null to None.
+  return NULL;
+}
+
+// Returns the (kind, values, row_offsets, has_values) tuple of column.
+PyObject* ToPythonColumn(const FeatureColumn& column) {
+  PyObject* values = ToPythonValues(column);
+  if (values == NULL) return NULL;
+  PyObject* row_offsets = ToPythonByteArray(column.row_offsets);
+  if (row_offsets == NULL) {
+    Py_DECREF(values);
+    return NULL;
+  }
+  PyObject* has_values = ToPythonByteArray(column.has_values);
+  if (has_values == NULL) {
+    Py_DECREF(values);
+    Py_DECREF(row_offsets);
+    return NULL;
+  }
+  // Steals the references to the values, row offsets and has_values.
+  return Py_BuildValue("(sNNN)", KindName(column.kind), values, row_offsets,
+                       has_values);
+}
+
+}  // namespace
+
+PyObject* DecodeExampleBatch(PyObject* serialized_examples) {
+  BytesSequence examples;
+  if (!examples.Init(serialized_examples, "serialized examples")) return NULL;
+  absl::flat_hash_map<string, FeatureColumn> columns;
+  const tensorflow::Status status =
+      tensorflow::data_validation::DecodeExampleBatch(examples.views(),
+                                                      &columns);
+  if (!status.ok()) {
+    PyErr_SetString(PyExc_ValueError, status.error_message().c_str());
+    return NULL;
+  }
+
+  PyObjectRef result(PyDict_New());
+  if (result.get() == NULL) return NULL;
+  for (const auto& name_and_column : columns) {
+    PyObjectRef name(PyUnicode_DecodeUTF8(name_and_column.first.data(),
+                                          name_and_column.first.size(),
+                                          NULL));
+    if (name.get() == NULL) return NULL;
+    PyObjectRef decoded_column(ToPythonColumn(name_and_column.second));
+    if (decoded_column.get() == NULL ||
+        PyDict_SetItem(result.get(), name.get(), decoded_column.get()) < 0) {
+      return NULL;
+    }
+  }
+  Py_INCREF(result.get());
+  return result.get();
+}
+%}
+
+%{
+// Decode batches of CSV lines for DecodeCSVBatches in coders/csv_decoder.py
+// (see csv_batch_decoder.h). The lines are a sequence of bytes or unicode
+// objects (which are encoded in UTF-8), and the delimiter is a bytes object
+// of one character. Both functions raise ValueError if the lines cannot be
+// decoded.
+//
+// InferCSVColumnTypes() returns the list of the FeatureNameStatistics.Type of
+// each column, or an empty list if every line is skipped. DecodeCSVBatch()
+// takes the list of the types of the columns (None for a column without a
+// type), and returns a (num_examples, columns) tuple, where columns is the
+// list of the (kind, values, row_offsets, has_values) tuples of the columns,
+// as returned by DecodeExampleBatch(). The kind of FLOAT columns is 'double',
+// with float64 values.
+
+namespace {
+
+using tensorflow::data_validation::CsvBatch;
+using tensorflow::data_validation::CsvColumnType;
+
+// Views of a sequence of CSV lines.
+class CsvLines {
+ public:
+  // Returns false (with a Python error set) if the lines are invalid.
+  bool Init(PyObject* lines) {
+    items_.reset(
+        new PyObjectRef(PySequence_Fast(lines, "lines must be a sequence.")));
+    if (items_->get() == NULL) return false;
+    const Py_ssize_t num_lines = PySequence_Fast_GET_SIZE(items_->get());
+    views_.reserve(num_lines);
+    for (Py_ssize_t i = 0; i < num_lines; ++i) {
+      PyObject* line = PySequence_Fast_GET_ITEM(items_->get(), i);
+      if (PyBytes_Check(line)) {
+        views_.emplace_back(PyBytes_AS_STRING(line), PyBytes_GET_SIZE(line));
+        continue;
+      }
+      if (!PyUnicode_Check(line)) {
+        PyErr_SetString(PyExc_TypeError,
+                        "lines must be bytes or unicode objects.");
+        return false;
+      }
+#if PY_MAJOR_VERSION >= 3
+      // The UTF-8 encoding is cached in the line.
+      Py_ssize_t length;
+      const char* utf8 = PyUnicode_AsUTF8AndSize(line, &length);
+      if (utf8 == NULL) return false;
+      views_.emplace_back(utf8, length);
+#else
+      PyObjectRef utf8(PyUnicode_AsUTF8String(line));
+      if (utf8.get() == NULL) return false;
+      encoded_lines_.emplace_back(PyBytes_AS_STRING(utf8.get()),
+                                  PyBytes_GET_SIZE(utf8.get()));
+      views_.push_back(encoded_lines_.back());
+#endif
+    }
+    return true;
+  }
+
+  const std::vector<absl::string_view>& views() const { return views_; }
+
+ private:
+  std::unique_ptr<PyObjectRef> items_;
+  // The UTF-8 encodings of the unicode lines, without a cache in Python 2.
+  std::deque<string> encoded_lines_;
+  std::vector<absl::string_view> views_;
+};
+
+// Returns false (with a Python error set) if delimiter is not a single
+// character.
+bool GetDelimiter(const string& delimiter, char* result) {
+  if (delimiter.size() != 1) {
+    PyErr_SetString(PyExc_ValueError,
+                    "delimiter must be a one-character string.");
+    return false;
+  }
+  *result = delimiter[0];
+  return true;
+}
+
+}  // namespace
+
+PyObject* InferCSVColumnTypes(PyObject* lines, const string& delimiter,
+                              bool skip_blank_lines, int num_columns) {
+  CsvLines csv_lines;
+  if (!csv_lines.Init(lines)) return NULL;
+  char delimiter_char;
+  if (!GetDelimiter(delimiter, &delimiter_char)) return NULL;
+  std::vector<CsvColumnType> column_types;
+  const tensorflow::Status status =
+      tensorflow::data_validation::InferCsvColumnTypes(
+          csv_lines.views(), delimiter_char, skip_blank_lines, num_columns,
+          &column_types);
+  if (!status.ok()) {
+    PyErr_SetString(PyExc_ValueError, status.error_message().c_str());
+    return NULL;
+  }
+  PyObject* result = PyList_New(column_types.size());
+  if (result == NULL) return NULL;
+  for (size_t i = 0; i < column_types.size(); ++i) {
+    PyObject* type = PyLong_FromLong(column_types[i]);
+    if (type == NULL) {
+      Py_DECREF(result);
+      return NULL;
+    }
+    PyList_SET_ITEM(result, i, type);
+  }
+  return result;
+}
+
+PyObject* DecodeCSVBatch(PyObject* lines, const string& delimiter,
+                         bool skip_blank_lines, PyObject* column_types) {
+  CsvLines csv_lines;
+  if (!csv_lines.Init(lines)) return NULL;
+  char delimiter_char;
+  if (!GetDelimiter(delimiter, &delimiter_char)) return NULL;
+  PyObjectRef types(
+      PySequence_Fast(column_types, "column_types must be a sequence."));
+  if (types.get() == NULL) return NULL;
+  std::vector<absl::optional<CsvColumnType>> types_vector;
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(types.get()); ++i) {
+    PyObject* type = PySequence_Fast_GET_ITEM(types.get(), i);
+    if (type == Py_None) {
+      types_vector.emplace_back();
+      continue;
+    }
+    const long type_value = PyLong_AsLong(type);
+    if (type_value == -1 && PyErr_Occurred()) return NULL;
+    if (!FeatureNameStatistics::Type_IsValid(type_value)) {
+      PyErr_SetString(PyExc_ValueError, "Invalid column type.");
+      return NULL;
+    }
+    types_vector.push_back(static_cast<CsvColumnType>(type_value));
+  }
+
+  CsvBatch batch;
+  const tensorflow::Status status =
+      tensorflow::data_validation::DecodeCsvBatch(
+          csv_lines.views(), delimiter_char, skip_blank_lines, types_vector,
+          &batch);
+  if (!status.ok()) {
+    PyErr_SetString(PyExc_ValueError, status.error_message().c_str());
+    return NULL;
+  }
+  PyObjectRef columns(PyList_New(batch.columns.size()));
+  if (columns.get() == NULL) return NULL;
+  for (size_t i = 0; i < batch.columns.size(); ++i) {
+    PyObject* column = ToPythonColumn(batch.columns[i]);
+    if (column == NULL) return NULL;
+    PyList_SET_ITEM(columns.get(), i, column);
+  }
+  return Py_BuildValue("(LO)", static_cast<long long>(batch.num_examples),
+                       columns.get());
+}
+%}
+
+%{
+// Merges a sequence of serialized DatasetFeatureStatistics protos (bytes
+// objects) for GenerateStatisticsImpl in statistics/stats_impl.py, and returns
+// the serialized DatasetFeatureStatisticsList proto of the merged statistics
+// (see statistics_merger.h). Raises RuntimeError if a proto cannot be parsed.
+PyObject* MergeDatasetFeatureStatistics(PyObject* serialized_statistics) {
+  BytesSequence statistics;
+  if (!statistics.Init(serialized_statistics, "serialized statistics")) {
+    return NULL;
+  }
+  string merged;
+  const tensorflow::Status status =
+      tensorflow::data_validation::MergeDatasetFeatureStatistics(
+          statistics.views(), &merged);
+  if (!status.ok()) return SetRuntimeError(status);
+  return ConvertToPythonString(merged);
+}
+%}
+
+%{
+// A CompiledSchemaValidator (see feature_statistics_validator.h) for
+// SchemaValidator in api/validation_api.py, held by a capsule, so that the
+// schema is parsed and indexed once for many validations.
+
+namespace {
+
+using tensorflow::data_validation::CompiledSchemaValidator;
+
+constexpr char kCompiledSchemaValidatorCapsuleName[] =
+    "CompiledSchemaValidator";
+
+}  // namespace
+
+PyObject* CreateCompiledSchemaValidator(absl::string_view schema_proto_string) {
+  std::unique_ptr<CompiledSchemaValidator> validator(
+      new CompiledSchemaValidator());
+  tensorflow::Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = validator->Init(schema_proto_string,
+                           tensorflow::data_validation::ValidationConfig());
+  Py_END_ALLOW_THREADS
+  if (!status.ok()) return SetRuntimeError(status);
+  return ToPythonCapsule(std::move(validator),
+                         kCompiledSchemaValidatorCapsuleName);
+}
+
+// Same as ValidateFeatureStatistics, with the schema of validator. The GIL is
+// released, and validator can be used from several threads at once.
+PyObject* ValidateWithCompiledSchemaValidator(
+    PyObject* validator, absl::string_view statistics_proto_string,
+    absl::string_view environment,
+    absl::string_view previous_statistics_proto_string,
+    absl::string_view serving_statistics_proto_string) {
+  const CompiledSchemaValidator* compiled_validator =
+      FromPythonCapsule<CompiledSchemaValidator>(
+          validator, kCompiledSchemaValidatorCapsuleName);
+  if (compiled_validator == NULL) return NULL;
+  tensorflow::metadata::v0::Anomalies anomalies;
+  tensorflow::Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = compiled_validator->Validate(
+      statistics_proto_string, environment, previous_statistics_proto_string,
+      serving_statistics_proto_string, &anomalies);
+  Py_END_ALLOW_THREADS
+  if (!status.ok()) return SetRuntimeError(status);
+  return SerializeToPythonBytes(anomalies);
+}
+
+// Validates each slice of a serialized DatasetFeatureStatisticsList with the
+// schema of validator, on num_threads threads. Returns a dict from the name
+// of each slice to its serialized Anomalies.
+PyObject* ValidateSlicesWithCompiledSchemaValidator(
+    PyObject* validator, absl::string_view statistics_list_proto_string,
+    absl::string_view environment, int num_threads) {
+  const CompiledSchemaValidator* compiled_validator =
+      FromPythonCapsule<CompiledSchemaValidator>(
+          validator, kCompiledSchemaValidatorCapsuleName);
+  if (compiled_validator == NULL) return NULL;
+  std::map<string, tensorflow::metadata::v0::Anomalies> slice_anomalies;
+  tensorflow::Status status;
+  Py_BEGIN_ALLOW_THREADS
+  status = compiled_validator->ValidateSlices(
+      statistics_list_proto_string, environment, num_threads,
+      &slice_anomalies);
+  Py_END_ALLOW_THREADS
+  if (!status.ok()) return SetRuntimeError(status);
+
+  PyObjectRef result(PyDict_New());
+  if (result.get() == NULL) return NULL;
+  for (const auto& name_and_anomalies : slice_anomalies) {
+    PyObjectRef name(PyUnicode_DecodeUTF8(name_and_anomalies.first.data(),
+                                          name_and_anomalies.first.size(),
+                                          NULL));
+    if (name.get() == NULL) return NULL;
+    PyObjectRef anomalies(SerializeToPythonBytes(name_and_anomalies.second));
+    if (anomalies.get() == NULL ||
+        PyDict_SetItem(result.get(), name.get(), anomalies.get()) < 0) {
+      return NULL;
+    }
+  }
+  Py_INCREF(result.get());
+  return result.get();
 }
 %}
 
@@ -70,12 +1428,93 @@ PyObject* ValidateFeatureStatistics(
   $1 = &temp;
 }
 
-PyObject* InferSchema(const string& statistics_proto_string,
-                      int max_string_domain_size);
+// Typemap to view the buffer of a bytes object as an absl::string_view,
+// without copying it.
+%typemap(in) absl::string_view {
+  char *buf;
+  Py_ssize_t len;
+  if (PyBytes_AsStringAndSize($input, &buf, &len) == -1) SWIG_fail;
+  $1 = absl::string_view(buf, len);
+}
+
+PyObject* InferSchema(absl::string_view statistics_proto_string,
+                      int max_string_domain_size, int num_threads);
 
 PyObject* ValidateFeatureStatistics(
-  const string& statistics_proto_string,
-  const string& schema_proto_string,
-  const string& environment,
-  const string& previous_statistics_proto_string,
-  const string& serving_statistics_proto_string);
+  absl::string_view statistics_proto_string,
+  absl::string_view schema_proto_string,
+  absl::string_view environment,
+  absl::string_view previous_statistics_proto_string,
+  absl::string_view serving_statistics_proto_string);
+
+PyObject* ValidateFeatureStatisticsBatch(
+  PyObject* statistics_proto_strings,
+  absl::string_view schema_proto_string,
+  absl::string_view environment,
+  int num_threads);
+
+PyObject* GetCommonStatsOfBatch(PyObject* values, PyObject* weights);
+
+PyObject* GetNumericStatsOfBatch(PyObject* values, PyObject* weights);
+
+PyObject* GetStringStatsOfBatch(PyObject* values, bool is_categorical);
+
+PyObject* CreateQuantilesSketch(double epsilon);
+
+PyObject* AddToQuantilesSketch(PyObject* sketch, PyObject* values,
+                               PyObject* weights);
+
+PyObject* MergeQuantilesSketches(PyObject* sketch, PyObject* other);
+
+PyObject* GetQuantilesOfSketch(PyObject* sketch, int num_quantiles);
+
+PyObject* SerializeQuantilesSketch(PyObject* sketch);
+
+PyObject* DeserializeQuantilesSketch(const string& serialized_sketch);
+
+PyObject* CreateTopKSketch(int num_counters);
+
+PyObject* AddToTopKSketch(PyObject* sketch, PyObject* values,
+                          PyObject* weights);
+
+PyObject* MergeTopKSketches(PyObject* sketch, PyObject* other);
+
+PyObject* GetTopKOfSketch(PyObject* sketch, int k);
+
+PyObject* SerializeTopKSketch(PyObject* sketch);
+
+PyObject* DeserializeTopKSketch(const string& serialized_sketch);
+
+PyObject* CreateUniquesSketch(int precision);
+
+PyObject* AddToUniquesSketch(PyObject* sketch, PyObject* values);
+
+PyObject* MergeUniquesSketches(PyObject* sketch, PyObject* other);
+
+PyObject* GetUniquesOfSketch(PyObject* sketch);
+
+PyObject* SerializeUniquesSketch(PyObject* sketch);
+
+PyObject* DeserializeUniquesSketch(const string& serialized_sketch);
+
+PyObject* DecodeExampleBatch(PyObject* serialized_examples);
+
+PyObject* InferCSVColumnTypes(PyObject* lines, const string& delimiter,
+                              bool skip_blank_lines, int num_columns);
+
+PyObject* DecodeCSVBatch(PyObject* lines, const string& delimiter,
+                         bool skip_blank_lines, PyObject* column_types);
+
+PyObject* MergeDatasetFeatureStatistics(PyObject* serialized_statistics);
+
+PyObject* CreateCompiledSchemaValidator(absl::string_view schema_proto_string);
+
+PyObject* ValidateWithCompiledSchemaValidator(
+    PyObject* validator, absl::string_view statistics_proto_string,
+    absl::string_view environment,
+    absl::string_view previous_statistics_proto_string,
+    absl::string_view serving_statistics_proto_string);
+
+PyObject* ValidateSlicesWithCompiledSchemaValidator(
+    PyObject* validator, absl::string_view statistics_list_proto_string,
+    absl::string_view environment, int num_threads);
@@ -0,0 +1,343 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks of validation and schema inference on synthetic statistics and
+// schemas, to catch superlinear behavior in the number of features, the
+// depth of structs, the size of string domains and the number of values in
+// rank histograms. Each benchmark reports the time per feature (as items
+// processed) and the number of allocations per feature (as its label).
+// Run with:
+// bazel run -c opt :validation_benchmark -- --benchmarks=all
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tensorflow_data_validation/anomalies/feature_statistics_validator.h"
+#include "tensorflow_data_validation/anomalies/proto/feature_statistics_to_proto.pb.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
+#include "tensorflow_data_validation/anomalies/schema_anomalies.h"
+#include "tensorflow_data_validation/anomalies/statistics_view.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/anomalies.pb.h"
+#include "tensorflow_metadata/proto/v0/schema.pb.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace {
+// The number of calls of the global operator new.
+std::atomic<tensorflow::int64> num_allocations(0);
+}  // namespace
+
+void* operator new(size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* result = std::malloc(size == 0 ? 1 : size);
+  if (result == nullptr) {
+    throw std::bad_alloc();
+  }
+  return result;
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::tensorflow::metadata::v0::DatasetFeatureStatistics;
+using ::tensorflow::metadata::v0::Feature;
+using ::tensorflow::metadata::v0::FeatureNameStatistics;
+using ::tensorflow::metadata::v0::Schema;
+
+// The shape of synthetic statistics and of the schema that they are
+// validated against.
+struct SyntheticShape {
+  // The number of leaf features, half of which are strings and half ints.
+  int num_features = 1000;
+  // The number of structs above each leaf feature. Each struct holds ten
+  // leaves (or ten structs of the level below).
+  int struct_depth = 0;
+  // The number of values in the string domain of each string feature.
+  int string_domain_size = 10;
+  // The number of buckets in the rank histogram of each string feature.
+  // Values beyond the string domain are anomalies.
+  int rank_histogram_size = 10;
+};
+
+constexpr int kNumExamples = 1000;
+
+// Returns the names of the structs above leaf feature i, from the root.
+std::vector<string> GetStructNames(const SyntheticShape& shape, int i) {
+  std::vector<string> names(shape.struct_depth);
+  int group = i;
+  for (int level = shape.struct_depth - 1; level >= 0; --level) {
+    group /= 10;
+    names[level] = absl::StrCat("struct_", level, "_", group);
+  }
+  return names;
+}
+
+FeatureNameStatistics::Type GetLeafType(int i) {
+  return i % 2 == 0 ? FeatureNameStatistics::STRING
+                    : FeatureNameStatistics::INT;
+}
+
+// Returns statistics of shape.num_features leaves (and their structs), each
+// present in every example with one value.
+DatasetFeatureStatistics GetSyntheticStatistics(const SyntheticShape& shape) {
+  DatasetFeatureStatistics statistics;
+  statistics.set_num_examples(kNumExamples);
+  std::vector<string> previous_struct_names;
+  for (int i = 0; i < shape.num_features; ++i) {
+    const std::vector<string> struct_names = GetStructNames(shape, i);
+    string name;
+    for (int level = 0; level < struct_names.size(); ++level) {
+      absl::StrAppend(&name, struct_names[level]);
+      if (level >= previous_struct_names.size() ||
+          previous_struct_names[level] != struct_names[level]) {
+        FeatureNameStatistics& feature = *statistics.add_features();
+        feature.set_name(name);
+        feature.set_type(FeatureNameStatistics::STRUCT);
+        auto& common_stats =
+            *feature.mutable_struct_stats()->mutable_common_stats();
+        common_stats.set_num_non_missing(kNumExamples);
+        common_stats.set_min_num_values(1);
+        common_stats.set_max_num_values(1);
+      }
+      absl::StrAppend(&name, ".");
+    }
+    previous_struct_names = struct_names;
+
+    FeatureNameStatistics& feature = *statistics.add_features();
+    feature.set_name(absl::StrCat(name, "feature_", i));
+    feature.set_type(GetLeafType(i));
+    metadata::v0::CommonStatistics* common_stats;
+    if (feature.type() == FeatureNameStatistics::STRING) {
+      auto& string_stats = *feature.mutable_string_stats();
+      string_stats.set_unique(shape.rank_histogram_size);
+      for (int j = 0; j < shape.rank_histogram_size; ++j) {
+        auto& bucket = *string_stats.mutable_rank_histogram()->add_buckets();
+        bucket.set_label(absl::StrCat("value_", j));
+        bucket.set_sample_count(kNumExamples / shape.rank_histogram_size);
+      }
+      common_stats = string_stats.mutable_common_stats();
+    } else {
+      auto& num_stats = *feature.mutable_num_stats();
+      num_stats.set_min(0);
+      num_stats.set_max(100);
+      common_stats = num_stats.mutable_common_stats();
+    }
+    common_stats->set_num_non_missing(kNumExamples);
+    common_stats->set_min_num_values(1);
+    common_stats->set_max_num_values(1);
+  }
+  return statistics;
+}
+
+// Sets the constraints of a feature present in every example with one value.
+void SetRequired(Feature* feature) {
+  feature->mutable_presence()->set_min_count(1);
+  feature->mutable_value_count()->set_min(1);
+  feature->mutable_value_count()->set_max(1);
+}
+
+// Returns a schema with an entry for each feature of
+// GetSyntheticStatistics(shape), and a string domain for each string
+// feature.
+Schema GetSyntheticSchema(const SyntheticShape& shape) {
+  Schema schema;
+  std::vector<string> previous_struct_names;
+  std::vector<Feature*> structs;
+  for (int i = 0; i < shape.num_features; ++i) {
+    const std::vector<string> struct_names = GetStructNames(shape, i);
+    for (int level = 0; level < struct_names.size(); ++level) {
+      if (level >= previous_struct_names.size() ||
+          previous_struct_names[level] != struct_names[level]) {
+        structs.resize(level);
+        Feature* feature =
+            level == 0
+                ? schema.add_feature()
+                : structs.back()->mutable_struct_domain()->add_feature();
+        feature->set_name(struct_names[level]);
+        feature->set_type(metadata::v0::STRUCT);
+        SetRequired(feature);
+        structs.push_back(feature);
+        previous_struct_names.resize(level);
+        previous_struct_names.push_back(struct_names[level]);
+      }
+    }
+
+    Feature* feature =
+        structs.empty()
+            ? schema.add_feature()
+            : structs.back()->mutable_struct_domain()->add_feature();
+    feature->set_name(absl::StrCat("feature_", i));
+    SetRequired(feature);
+    if (GetLeafType(i) == FeatureNameStatistics::STRING) {
+      feature->set_type(metadata::v0::BYTES);
+      const string domain_name = absl::StrCat("domain_", i);
+      feature->set_domain(domain_name);
+      auto& string_domain = *schema.add_string_domain();
+      string_domain.set_name(domain_name);
+      for (int j = 0; j < shape.string_domain_size; ++j) {
+        string_domain.add_value(absl::StrCat("value_", j));
+      }
+    } else {
+      feature->set_type(metadata::v0::INT);
+    }
+  }
+  return schema;
+}
+
+// Runs fn iters times, reporting the features processed and the allocations
+// per feature.
+void RunBenchmark(int iters, int num_features,
+                  const std::function<void()>& fn) {
+  testing::UseRealTime();
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_features);
+  const int64 allocations_before = num_allocations.load();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    fn();
+  }
+  testing::StopTiming();
+  const double allocations_per_feature =
+      static_cast<double>(num_allocations.load() - allocations_before) /
+      (static_cast<double>(iters) * num_features);
+  testing::SetLabel(
+      absl::StrCat("allocations/feature: ", allocations_per_feature));
+}
+
+void RunValidateBenchmark(int iters, const SyntheticShape& shape) {
+  testing::StopTiming();
+  const DatasetFeatureStatistics statistics = GetSyntheticStatistics(shape);
+  const Schema schema = GetSyntheticSchema(shape);
+  RunBenchmark(iters, shape.num_features, [&]() {
+    metadata::v0::Anomalies anomalies;
+    TF_CHECK_OK(ValidateFeatureStatistics(
+        statistics, schema, /*environment=*/gtl::nullopt,
+        /*prev_feature_statistics=*/gtl::nullopt,
+        /*serving_feature_statistics=*/gtl::nullopt,
+        /*features_needed=*/gtl::nullopt, ValidationConfig(), &anomalies));
+  });
+}
+
+void BM_ValidateByNumFeatures(int iters, int num_features) {
+  SyntheticShape shape;
+  shape.num_features = num_features;
+  RunValidateBenchmark(iters, shape);
+}
+BENCHMARK(BM_ValidateByNumFeatures)->Arg(1000)->Arg(10000)->Arg(100000);
+
+void BM_ValidateByStructDepth(int iters, int struct_depth) {
+  SyntheticShape shape;
+  shape.struct_depth = struct_depth;
+  RunValidateBenchmark(iters, shape);
+}
+BENCHMARK(BM_ValidateByStructDepth)->Arg(0)->Arg(1)->Arg(2)->Arg(3);
+
+void BM_ValidateByStringDomainSize(int iters, int string_domain_size) {
+  SyntheticShape shape;
+  shape.string_domain_size = string_domain_size;
+  RunValidateBenchmark(iters, shape);
+}
+BENCHMARK(BM_ValidateByStringDomainSize)->Arg(10)->Arg(100)->Arg(1000);
+
+// Values beyond the string domain are anomalies, so this also measures
+// describing them.
+void BM_ValidateByRankHistogramSize(int iters, int rank_histogram_size) {
+  SyntheticShape shape;
+  shape.rank_histogram_size = rank_histogram_size;
+  RunValidateBenchmark(iters, shape);
+}
+BENCHMARK(BM_ValidateByRankHistogramSize)->Arg(10)->Arg(100)->Arg(1000);
+
+void BM_InferSchema(int iters, int num_features) {
+  testing::StopTiming();
+  SyntheticShape shape;
+  shape.num_features = num_features;
+  const string statistics = GetSyntheticStatistics(shape).SerializeAsString();
+  RunBenchmark(iters, num_features, [&]() {
+    string schema;
+    TF_CHECK_OK(InferSchema(statistics, /*max_string_domain_size=*/100,
+                            &schema));
+  });
+}
+BENCHMARK(BM_InferSchema)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Updates a schema where the string domains miss most of the values.
+void BM_UpdateSchema(int iters, int num_features) {
+  testing::StopTiming();
+  SyntheticShape shape;
+  shape.num_features = num_features;
+  shape.rank_histogram_size = 20;
+  const DatasetFeatureStatistics statistics = GetSyntheticStatistics(shape);
+  const Schema schema = GetSyntheticSchema(shape);
+  RunBenchmark(iters, num_features, [&]() {
+    Schema result;
+    TF_CHECK_OK(UpdateSchema(GetDefaultFeatureStatisticsToProtoConfig(),
+                             schema, statistics,
+                             /*paths_to_consider=*/gtl::nullopt,
+                             /*environment=*/gtl::nullopt, &result));
+  });
+}
+BENCHMARK(BM_UpdateSchema)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Updates a single feature of a large schema in place, which should not
+// depend on the number of features.
+void BM_UpdateSchemaInPlace(int iters, int num_features) {
+  testing::StopTiming();
+  SyntheticShape shape;
+  shape.num_features = num_features;
+  shape.rank_histogram_size = 20;
+  const DatasetFeatureStatistics statistics = GetSyntheticStatistics(shape);
+  Schema schema = GetSyntheticSchema(shape);
+  const std::vector<Path> paths_to_consider = {Path({"feature_0"})};
+  RunBenchmark(iters, /*num_features=*/1, [&]() {
+    TF_CHECK_OK(UpdateSchemaInPlace(GetDefaultFeatureStatisticsToProtoConfig(),
+                                    statistics, paths_to_consider,
+                                    /*environment=*/gtl::nullopt, &schema));
+  });
+}
+BENCHMARK(BM_UpdateSchemaInPlace)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Only measures GetSchemaDiff(), with an anomaly for each string feature.
+void BM_GetSchemaDiff(int iters, int num_features) {
+  testing::StopTiming();
+  SyntheticShape shape;
+  shape.num_features = num_features;
+  shape.rank_histogram_size = 20;
+  const DatasetStatsView view(GetSyntheticStatistics(shape),
+                              /*by_weight=*/false);
+  SchemaAnomalies schema_anomalies(GetSyntheticSchema(shape));
+  TF_CHECK_OK(schema_anomalies.FindChanges(
+      view, /*features_needed=*/absl::nullopt,
+      GetDefaultFeatureStatisticsToProtoConfig()));
+  RunBenchmark(iters, num_features, [&]() {
+    CHECK(!schema_anomalies.GetSchemaDiff().anomaly_info().empty());
+  });
+}
+BENCHMARK(BM_GetSchemaDiff)->Arg(1000)->Arg(10000)->Arg(100000);
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
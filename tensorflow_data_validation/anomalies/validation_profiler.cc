@@ -0,0 +1,123 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/validation_profiler.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+namespace {
+
+const char* GetPhaseName(ValidationPhase phase) {
+  switch (phase) {
+    case ValidationPhase::kViewConstruction:
+      return "view_construction";
+    case ValidationPhase::kFindChanges:
+      return "find_changes";
+    case ValidationPhase::kMissingPaths:
+      return "missing_paths";
+    case ValidationPhase::kComparators:
+      return "comparators";
+    case ValidationPhase::kSchemaDiff:
+      return "schema_diff";
+  }
+}
+
+double MicrosToSeconds(uint64 micros) { return micros * 1e-6; }
+
+}  // namespace
+
+ValidationProfiler::ValidationProfiler(int num_slowest_features)
+    : num_slowest_features_(std::max(num_slowest_features, 0)) {}
+
+void ValidationProfiler::AddPhaseTime(ValidationPhase phase, uint64 micros) {
+  mutex_lock l(mu_);
+  PhaseTime& phase_time = phases_[static_cast<int>(phase)];
+  ++phase_time.num_calls;
+  phase_time.micros += micros;
+}
+
+void ValidationProfiler::AddFeatureTime(const Path& path,
+                                        const string& domain_type,
+                                        uint64 micros) {
+  if (num_slowest_features_ == 0) {
+    return;
+  }
+  const auto slower = [](const FeatureTime& a, const FeatureTime& b) {
+    return a.micros > b.micros;
+  };
+  mutex_lock l(mu_);
+  if (slowest_features_.size() ==
+      static_cast<size_t>(num_slowest_features_)) {
+    if (micros <= slowest_features_.front().micros) {
+      return;
+    }
+    std::pop_heap(slowest_features_.begin(), slowest_features_.end(), slower);
+    slowest_features_.pop_back();
+  }
+  slowest_features_.push_back({path, domain_type, micros});
+  std::push_heap(slowest_features_.begin(), slowest_features_.end(), slower);
+}
+
+void ValidationProfiler::GetProfile(ValidationProfile* profile) const {
+  profile->Clear();
+  mutex_lock l(mu_);
+  for (int i = 0; i < phases_.size(); ++i) {
+    if (phases_[i].num_calls == 0) {
+      continue;
+    }
+    ValidationProfile::Phase* phase = profile->add_phases();
+    phase->set_name(GetPhaseName(static_cast<ValidationPhase>(i)));
+    phase->set_num_calls(phases_[i].num_calls);
+    phase->set_wall_time_seconds(MicrosToSeconds(phases_[i].micros));
+  }
+  std::vector<const FeatureTime*> features;
+  for (const FeatureTime& feature : slowest_features_) {
+    features.push_back(&feature);
+  }
+  std::sort(features.begin(), features.end(),
+            [](const FeatureTime* a, const FeatureTime* b) {
+              if (a->micros != b->micros) {
+                return a->micros > b->micros;
+              }
+              return a->path < b->path;
+            });
+  for (const FeatureTime* feature : features) {
+    ValidationProfile::Feature* result = profile->add_slowest_features();
+    result->set_path(feature->path.Serialize());
+    result->set_domain_type(feature->domain_type);
+    result->set_wall_time_seconds(MicrosToSeconds(feature->micros));
+  }
+}
+
+ScopedPhaseTimer::ScopedPhaseTimer(ValidationProfiler* profiler,
+                                   ValidationPhase phase)
+    : profiler_(profiler),
+      phase_(phase),
+      start_micros_(profiler == nullptr ? 0 : Env::Default()->NowMicros()) {}
+
+ScopedPhaseTimer::~ScopedPhaseTimer() {
+  if (profiler_ != nullptr) {
+    profiler_->AddPhaseTime(phase_, Env::Default()->NowMicros() -
+                                        start_micros_);
+  }
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
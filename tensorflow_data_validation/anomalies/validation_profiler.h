@@ -0,0 +1,111 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_VALIDATION_PROFILER_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_VALIDATION_PROFILER_H_
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "tensorflow_data_validation/anomalies/path.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// The phases of validation that are timed by a ValidationProfiler.
+enum class ValidationPhase {
+  // Building the views of the statistics.
+  kViewConstruction = 0,
+  // SchemaAnomalies::FindChanges(), including the two phases below.
+  kFindChanges,
+  // Finding the features of the schema that are missing from the statistics.
+  kMissingPaths,
+  // Checking the skew and drift comparators of the features.
+  kComparators,
+  // Writing the anomalies found as a schema diff.
+  kSchemaDiff,
+};
+
+// Collects the time spent in each phase of validation, and the slowest root
+// features. All methods are thread-safe.
+// Validation code takes a ValidationProfiler*, which is null when no profile
+// is requested, so that timing costs nothing unless it is on.
+class ValidationProfiler {
+ public:
+  // num_slowest_features is the number of root features kept by
+  // AddFeatureTime(). If it is not positive, no features are kept.
+  explicit ValidationProfiler(int num_slowest_features);
+
+  ValidationProfiler(const ValidationProfiler&) = delete;
+  ValidationProfiler& operator=(const ValidationProfiler&) = delete;
+
+  // Records one call of phase taking micros microseconds.
+  void AddPhaseTime(ValidationPhase phase, uint64 micros);
+
+  // Records that validating the root feature path (and its descendants) took
+  // micros microseconds. domain_type is reported as is (see
+  // ValidationProfile.Feature).
+  void AddFeatureTime(const Path& path, const string& domain_type,
+                      uint64 micros);
+
+  // Writes the phases that ran at least once, in the order of ValidationPhase,
+  // and the slowest features, slowest first. Replaces the contents of
+  // *profile.
+  void GetProfile(ValidationProfile* profile) const;
+
+ private:
+  struct PhaseTime {
+    int64 num_calls = 0;
+    uint64 micros = 0;
+  };
+  struct FeatureTime {
+    Path path;
+    string domain_type;
+    uint64 micros;
+  };
+
+  const int num_slowest_features_;
+  mutable mutex mu_;
+  std::array<PhaseTime, static_cast<int>(ValidationPhase::kSchemaDiff) + 1>
+      phases_ GUARDED_BY(mu_);
+  // A min-heap by micros of the slowest features seen so far.
+  std::vector<FeatureTime> slowest_features_ GUARDED_BY(mu_);
+};
+
+// Adds the wall time from construction to destruction to a phase of a
+// profiler. Does nothing if profiler is null.
+class ScopedPhaseTimer {
+ public:
+  ScopedPhaseTimer(ValidationProfiler* profiler, ValidationPhase phase);
+  ~ScopedPhaseTimer();
+
+  ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+  ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+ private:
+  ValidationProfiler* const profiler_;
+  const ValidationPhase phase_;
+  const uint64 start_micros_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_VALIDATION_PROFILER_H_
@@ -0,0 +1,87 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/validation_profiler.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow_data_validation/anomalies/path.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+TEST(ValidationProfilerTest, PhaseTimes) {
+  ValidationProfiler profiler(/*num_slowest_features=*/0);
+  profiler.AddPhaseTime(ValidationPhase::kSchemaDiff, 3000000);
+  profiler.AddPhaseTime(ValidationPhase::kFindChanges, 1000000);
+  profiler.AddPhaseTime(ValidationPhase::kFindChanges, 500000);
+  ValidationProfile profile;
+  profiler.GetProfile(&profile);
+  // Phases that never ran are left out, and the rest are in the order of
+  // ValidationPhase.
+  ASSERT_EQ(2, profile.phases_size());
+  EXPECT_EQ("find_changes", profile.phases(0).name());
+  EXPECT_EQ(2, profile.phases(0).num_calls());
+  EXPECT_DOUBLE_EQ(1.5, profile.phases(0).wall_time_seconds());
+  EXPECT_EQ("schema_diff", profile.phases(1).name());
+  EXPECT_EQ(1, profile.phases(1).num_calls());
+  EXPECT_DOUBLE_EQ(3.0, profile.phases(1).wall_time_seconds());
+  EXPECT_EQ(0, profile.slowest_features_size());
+}
+
+TEST(ValidationProfilerTest, SlowestFeatures) {
+  ValidationProfiler profiler(/*num_slowest_features=*/2);
+  profiler.AddFeatureTime(Path({"a"}), "int_domain", 2000000);
+  profiler.AddFeatureTime(Path({"b"}), "", 1000000);
+  profiler.AddFeatureTime(Path({"c"}), "domain", 4000000);
+  profiler.AddFeatureTime(Path({"d"}), "new_feature", 3000000);
+  ValidationProfile profile;
+  profiler.GetProfile(&profile);
+  ASSERT_EQ(2, profile.slowest_features_size());
+  EXPECT_EQ("c", profile.slowest_features(0).path());
+  EXPECT_EQ("domain", profile.slowest_features(0).domain_type());
+  EXPECT_DOUBLE_EQ(4.0, profile.slowest_features(0).wall_time_seconds());
+  EXPECT_EQ("d", profile.slowest_features(1).path());
+  EXPECT_EQ("new_feature", profile.slowest_features(1).domain_type());
+  EXPECT_DOUBLE_EQ(3.0, profile.slowest_features(1).wall_time_seconds());
+}
+
+TEST(ValidationProfilerTest, ScopedPhaseTimer) {
+  ValidationProfiler profiler(/*num_slowest_features=*/0);
+  {
+    ScopedPhaseTimer timer(&profiler, ValidationPhase::kComparators);
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  {
+    // A timer without a profiler does nothing.
+    ScopedPhaseTimer timer(nullptr, ValidationPhase::kComparators);
+  }
+  ValidationProfile profile;
+  profiler.GetProfile(&profile);
+  ASSERT_EQ(1, profile.phases_size());
+  EXPECT_EQ("comparators", profile.phases(0).name());
+  EXPECT_EQ(1, profile.phases(0).num_calls());
+  EXPECT_GE(profile.phases(0).wall_time_seconds(), 1e-3);
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
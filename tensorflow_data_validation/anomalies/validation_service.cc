@@ -0,0 +1,149 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/validation_service.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+namespace {
+
+// Returns validation_config, with the validations on the calling thread.
+ValidationConfig SingleThreaded(const ValidationConfig& validation_config) {
+  ValidationConfig result = validation_config;
+  result.set_num_threads(1);
+  return result;
+}
+
+}  // namespace
+
+CompiledSchemaCache::CompiledSchemaCache(
+    int capacity, const ValidationConfig& validation_config)
+    : capacity_(std::max(1, capacity)),
+      validation_config_(validation_config) {}
+
+Status CompiledSchemaCache::Get(
+    absl::string_view schema_proto_string,
+    std::shared_ptr<const CompiledSchemaValidator>* validator) {
+  const uint64 fingerprint =
+      Hash64(schema_proto_string.data(), schema_proto_string.size());
+  {
+    mutex_lock l(mu_);
+    const auto iter = index_.find(fingerprint);
+    if (iter != index_.end() &&
+        iter->second->schema_proto_string == schema_proto_string) {
+      ++num_hits_;
+      entries_.splice(entries_.begin(), entries_, iter->second);
+      *validator = entries_.front().validator;
+      return Status::OK();
+    }
+    ++num_misses_;
+  }
+
+  // The schema is compiled without holding the lock, so that the other
+  // schemas can be found meanwhile.
+  auto compiled = std::make_shared<CompiledSchemaValidator>();
+  TF_RETURN_IF_ERROR(compiled->Init(schema_proto_string, validation_config_));
+  *validator = compiled;
+
+  mutex_lock l(mu_);
+  const auto iter = index_.find(fingerprint);
+  if (iter != index_.end()) {
+    // Another thread compiled the same schema meanwhile, or a schema with
+    // the same fingerprint is cached: the newest one replaces it.
+    entries_.erase(iter->second);
+    index_.erase(iter);
+  }
+  entries_.push_front(
+      {fingerprint, string(schema_proto_string), std::move(compiled)});
+  index_[fingerprint] = entries_.begin();
+  while (entries_.size() > static_cast<size_t>(capacity_)) {
+    index_.erase(entries_.back().fingerprint);
+    entries_.pop_back();
+  }
+  return Status::OK();
+}
+
+int64 CompiledSchemaCache::num_hits() const {
+  mutex_lock l(mu_);
+  return num_hits_;
+}
+
+int64 CompiledSchemaCache::num_misses() const {
+  mutex_lock l(mu_);
+  return num_misses_;
+}
+
+ValidationService::ValidationService(const ValidationServiceOptions& options)
+    : options_(options),
+      schema_cache_(options.schema_cache_capacity,
+                    SingleThreaded(options.validation_config)),
+      workers_(new thread::ThreadPool(Env::Default(), "validation_service",
+                                      std::max(1, options.num_threads))) {}
+
+ValidationService::~ValidationService() {
+  // The destructor of the pool waits for all the work to finish.
+  workers_.reset();
+}
+
+Status ValidationService::Validate(ValidationRequest request,
+                                   ValidationCallback done) {
+  {
+    mutex_lock l(mu_);
+    if (num_pending_requests_ >= options_.max_pending_requests) {
+      return errors::Unavailable("Too many pending validations: ",
+                                 num_pending_requests_);
+    }
+    ++num_pending_requests_;
+  }
+  // The request is moved into the closure, which std::function must be
+  // able to copy, so it is shared.
+  auto shared_request =
+      std::make_shared<ValidationRequest>(std::move(request));
+  workers_->Schedule([this, shared_request, done]() {
+    metadata::v0::Anomalies result;
+    const Status status = ValidateNow(*shared_request, &result);
+    done(status, std::move(result));
+    mutex_lock l(mu_);
+    --num_pending_requests_;
+  });
+  return Status::OK();
+}
+
+int ValidationService::num_pending_requests() const {
+  mutex_lock l(mu_);
+  return num_pending_requests_;
+}
+
+Status ValidationService::ValidateNow(const ValidationRequest& request,
+                                      metadata::v0::Anomalies* result) {
+  std::shared_ptr<const CompiledSchemaValidator> validator;
+  TF_RETURN_IF_ERROR(
+      schema_cache_.Get(request.schema_proto_string, &validator));
+  return validator->Validate(request.feature_statistics_proto_string,
+                             request.environment,
+                             request.previous_statistics_proto_string,
+                             request.serving_statistics_proto_string, result);
+}
+
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,155 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A long-running validation service, for a server that validates many
+// statistics, mostly against a few schemas. It saves the work that a
+// validation per call to ValidateFeatureStatistics() repeats: the schemas
+// are compiled once and kept in a cache, and the validations run on worker
+// threads that live as long as the service.
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_VALIDATION_SERVICE_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_VALIDATION_SERVICE_H_
+
+#include <functional>
+#include <list>
+#include <memory>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_data_validation/anomalies/feature_statistics_validator.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/anomalies.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+// A cache of the validators of the most recently used schemas, keyed by
+// the fingerprint of their serialized Schema protos. Can be used
+// concurrently.
+class CompiledSchemaCache {
+ public:
+  // The cache keeps the validators of at most capacity schemas, which are
+  // compiled with validation_config.
+  CompiledSchemaCache(int capacity, const ValidationConfig& validation_config);
+
+  // Disallow copy and move.
+  CompiledSchemaCache(const CompiledSchemaCache&) = delete;
+  CompiledSchemaCache& operator=(const CompiledSchemaCache&) = delete;
+
+  // Sets *validator to the validator of schema_proto_string, compiling it
+  // (and evicting the least recently used schema if the cache is full) if it
+  // is not in the cache. A schema that cannot be compiled is not cached.
+  Status Get(absl::string_view schema_proto_string,
+             std::shared_ptr<const CompiledSchemaValidator>* validator);
+
+  // The number of calls to Get() that found the schema in the cache, and
+  // that did not.
+  int64 num_hits() const;
+  int64 num_misses() const;
+
+ private:
+  struct Entry {
+    uint64 fingerprint;
+    // Compared on a hit, so that two schemas with the same fingerprint are
+    // not mistaken for each other.
+    string schema_proto_string;
+    std::shared_ptr<const CompiledSchemaValidator> validator;
+  };
+
+  const int capacity_;
+  const ValidationConfig validation_config_;
+  mutable mutex mu_;
+  // The entries, from the most to the least recently used.
+  std::list<Entry> entries_ GUARDED_BY(mu_);
+  absl::flat_hash_map<uint64, std::list<Entry>::iterator> index_
+      GUARDED_BY(mu_);
+  int64 num_hits_ GUARDED_BY(mu_) = 0;
+  int64 num_misses_ GUARDED_BY(mu_) = 0;
+};
+
+struct ValidationServiceOptions {
+  // The number of worker threads.
+  int num_threads = 4;
+  // The largest number of requests that are queued or being validated:
+  // Validate() rejects more.
+  int max_pending_requests = 1024;
+  // The number of compiled schemas kept.
+  int schema_cache_capacity = 64;
+  // The config of every validation. Each request is validated on a single
+  // worker thread, whatever its num_threads.
+  ValidationConfig validation_config;
+};
+
+// A request to validate statistics against a schema, as the
+// serialized-string ValidateFeatureStatistics() does: an empty environment
+// or statistics string means that there is none.
+struct ValidationRequest {
+  string schema_proto_string;
+  string feature_statistics_proto_string;
+  string environment;
+  string previous_statistics_proto_string;
+  string serving_statistics_proto_string;
+};
+
+// Called, on a worker thread, with the status of a validation and its
+// result if it is OK.
+using ValidationCallback =
+    std::function<void(const Status& status, metadata::v0::Anomalies result)>;
+
+class ValidationService {
+ public:
+  explicit ValidationService(const ValidationServiceOptions& options);
+
+  // Finishes the validations of the requests accepted, then stops the
+  // workers.
+  ~ValidationService();
+
+  // Disallow copy and move.
+  ValidationService(const ValidationService&) = delete;
+  ValidationService& operator=(const ValidationService&) = delete;
+
+  // Queues request, and calls done when it is validated. Returns
+  // Unavailable, without calling done, if max_pending_requests requests are
+  // pending (i.e., their callbacks have not returned), so that the caller
+  // can back off. Can be called concurrently.
+  Status Validate(ValidationRequest request, ValidationCallback done);
+
+  // The number of requests that are queued or being validated.
+  int num_pending_requests() const;
+
+  const CompiledSchemaCache& schema_cache() const { return schema_cache_; }
+
+ private:
+  // Validates request on the calling thread.
+  Status ValidateNow(const ValidationRequest& request,
+                     metadata::v0::Anomalies* result);
+
+  const ValidationServiceOptions options_;
+  CompiledSchemaCache schema_cache_;
+  mutable mutex mu_;
+  int num_pending_requests_ GUARDED_BY(mu_) = 0;
+  // Destroyed first, so that the pending validations finish while the rest
+  // of the service is still alive.
+  std::unique_ptr<thread::ThreadPool> workers_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_VALIDATION_SERVICE_H_
@@ -0,0 +1,187 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/validation_service.h"
+
+#include <future>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "tensorflow_data_validation/anomalies/feature_statistics_validator.h"
+#include "tensorflow_data_validation/anomalies/proto/validation_config.pb.h"
+#include "tensorflow_data_validation/anomalies/test_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow_metadata/proto/v0/anomalies.pb.h"
+#include "tensorflow_metadata/proto/v0/schema.pb.h"
+#include "tensorflow_metadata/proto/v0/statistics.pb.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+using ::tensorflow::metadata::v0::DatasetFeatureStatistics;
+using ::tensorflow::metadata::v0::Schema;
+using testing::EqualsProto;
+using testing::ParseTextProtoOrDie;
+
+Schema GetSchema(const string& feature_name) {
+  return ParseTextProtoOrDie<Schema>(
+      absl::StrCat("feature { name: '", feature_name,
+                   "' type: INT presence { min_count: 1 } }"));
+}
+
+string GetSchemaString(const string& feature_name) {
+  return GetSchema(feature_name).SerializeAsString();
+}
+
+DatasetFeatureStatistics GetStatistics() {
+  return ParseTextProtoOrDie<DatasetFeatureStatistics>(R"(
+    num_examples: 10
+    features: {
+      name: 'a'
+      type: INT
+      num_stats: {
+        common_stats: {
+          num_non_missing: 10
+          min_num_values: 1
+          max_num_values: 1
+        }
+      }
+    }
+    features: {
+      name: 'b'
+      type: INT
+      num_stats: {
+        common_stats: {
+          num_non_missing: 10
+          min_num_values: 1
+          max_num_values: 1
+        }
+      }
+    })");
+}
+
+TEST(CompiledSchemaCacheTest, HitsAndEvictions) {
+  CompiledSchemaCache cache(1, ValidationConfig());
+  std::shared_ptr<const CompiledSchemaValidator> first;
+  TF_ASSERT_OK(cache.Get(GetSchemaString("a"), &first));
+  std::shared_ptr<const CompiledSchemaValidator> second;
+  TF_ASSERT_OK(cache.Get(GetSchemaString("a"), &second));
+  EXPECT_EQ(first.get(), second.get());
+  EXPECT_EQ(1, cache.num_hits());
+  EXPECT_EQ(1, cache.num_misses());
+
+  // The schema of "b" evicts the schema of "a".
+  std::shared_ptr<const CompiledSchemaValidator> other;
+  TF_ASSERT_OK(cache.Get(GetSchemaString("b"), &other));
+  EXPECT_NE(first.get(), other.get());
+  std::shared_ptr<const CompiledSchemaValidator> third;
+  TF_ASSERT_OK(cache.Get(GetSchemaString("a"), &third));
+  EXPECT_NE(first.get(), third.get());
+  EXPECT_EQ(1, cache.num_hits());
+  EXPECT_EQ(3, cache.num_misses());
+}
+
+TEST(CompiledSchemaCacheTest, InvalidSchemaIsNotCached) {
+  CompiledSchemaCache cache(2, ValidationConfig());
+  std::shared_ptr<const CompiledSchemaValidator> validator;
+  EXPECT_FALSE(cache.Get("not a schema", &validator).ok());
+  EXPECT_FALSE(cache.Get("not a schema", &validator).ok());
+  EXPECT_EQ(0, cache.num_hits());
+  EXPECT_EQ(2, cache.num_misses());
+}
+
+TEST(ValidationServiceTest, ValidatesAsValidateFeatureStatistics) {
+  const DatasetFeatureStatistics statistics = GetStatistics();
+  metadata::v0::Anomalies expected;
+  TF_ASSERT_OK(ValidateFeatureStatistics(
+      statistics, GetSchema("a"),
+      gtl::nullopt, gtl::nullopt, gtl::nullopt, gtl::nullopt,
+      ValidationConfig(), &expected));
+
+  ValidationServiceOptions options;
+  options.num_threads = 4;
+  ValidationService service(options);
+  const int kNumRequests = 20;
+  std::vector<std::promise<metadata::v0::Anomalies>> results(kNumRequests);
+  for (int i = 0; i < kNumRequests; ++i) {
+    ValidationRequest request;
+    request.schema_proto_string = GetSchemaString("a");
+    request.feature_statistics_proto_string = statistics.SerializeAsString();
+    std::promise<metadata::v0::Anomalies>* result = &results[i];
+    TF_ASSERT_OK(service.Validate(
+        std::move(request),
+        [result](const Status& status, metadata::v0::Anomalies anomalies) {
+          TF_EXPECT_OK(status);
+          result->set_value(std::move(anomalies));
+        }));
+  }
+  for (std::promise<metadata::v0::Anomalies>& result : results) {
+    EXPECT_THAT(result.get_future().get(), EqualsProto(expected));
+  }
+  // The schema is only compiled by the first few validations.
+  EXPECT_EQ(kNumRequests, service.schema_cache().num_hits() +
+                              service.schema_cache().num_misses());
+  EXPECT_LE(service.schema_cache().num_misses(), options.num_threads);
+}
+
+TEST(ValidationServiceTest, ReportsErrors) {
+  ValidationService service(ValidationServiceOptions{});
+  ValidationRequest request;
+  request.schema_proto_string = "not a schema";
+  std::promise<Status> result;
+  TF_ASSERT_OK(service.Validate(
+      std::move(request),
+      [&result](const Status& status, metadata::v0::Anomalies anomalies) {
+        result.set_value(status);
+      }));
+  EXPECT_FALSE(result.get_future().get().ok());
+}
+
+TEST(ValidationServiceTest, RejectsRequestsWhenFull) {
+  ValidationServiceOptions options;
+  options.num_threads = 1;
+  options.max_pending_requests = 1;
+  ValidationService service(options);
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  std::promise<void> done;
+
+  ValidationRequest request;
+  request.schema_proto_string = GetSchemaString("a");
+  request.feature_statistics_proto_string =
+      GetStatistics().SerializeAsString();
+  TF_ASSERT_OK(service.Validate(
+      request, [released, &done](const Status& status,
+                                 metadata::v0::Anomalies anomalies) {
+        released.wait();
+        done.set_value();
+      }));
+  // The first request is pending until its callback returns.
+  EXPECT_EQ(1, service.num_pending_requests());
+  EXPECT_TRUE(errors::IsUnavailable(service.Validate(
+      request, [](const Status& status, metadata::v0::Anomalies anomalies) {
+        ADD_FAILURE() << "A rejected request was validated";
+      })));
+  release.set_value();
+  done.get_future().wait();
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -0,0 +1,130 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A reader of the protocol buffer wire format, for the native code that reads
+// serialized messages without parsing them (see example_batch_decoder.h,
+// statistics_merger.h and statistics_parser.h).
+#ifndef TENSORFLOW_DATA_VALIDATION_ANOMALIES_WIRE_READER_H_
+#define TENSORFLOW_DATA_VALIDATION_ANOMALIES_WIRE_READER_H_
+
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+
+using WireFormatLite = ::tensorflow::protobuf::internal::WireFormatLite;
+
+// Reads the fields of a serialized message. The values are read by a
+// protobuf::io::CodedInputStream over the message, so the bounds checks are
+// those of protobuf, and the length-delimited values are views of the
+// message. Each method returns false if the message is malformed.
+class WireReader {
+ public:
+  explicit WireReader(absl::string_view data)
+      : data_(data),
+        input_(reinterpret_cast<const uint8*>(data.data()), data.size()) {}
+
+  // Disallow copy and move, as CodedInputStream does.
+  WireReader(const WireReader&) = delete;
+  WireReader& operator=(const WireReader&) = delete;
+
+  bool done() const {
+    return static_cast<size_t>(input_.CurrentPosition()) == data_.size();
+  }
+
+  // The bytes that have not been read yet.
+  absl::string_view remaining() const {
+    return data_.substr(input_.CurrentPosition());
+  }
+
+  // Sets *wire_type to one of the WireFormatLite::WireType values.
+  bool ReadTag(int* field, int* wire_type) {
+    // A tag of 0 is invalid, and is also what is returned on an error.
+    const uint32 tag = input_.ReadTagNoLastTag();
+    if (tag == 0) {
+      return false;
+    }
+    *field = WireFormatLite::GetTagFieldNumber(tag);
+    *wire_type = WireFormatLite::GetTagWireType(tag);
+    return true;
+  }
+
+  bool ReadVarint(uint64* value) {
+    protobuf_uint64 result;
+    if (!input_.ReadVarint64(&result)) {
+      return false;
+    }
+    *value = result;
+    return true;
+  }
+
+  bool ReadFloat(float* value) {
+    uint32 bits;
+    if (!input_.ReadLittleEndian32(&bits)) {
+      return false;
+    }
+    *value = WireFormatLite::DecodeFloat(bits);
+    return true;
+  }
+
+  bool ReadLengthDelimited(absl::string_view* value) {
+    uint32 size;
+    if (!input_.ReadVarint32(&size)) {
+      return false;
+    }
+    const int begin = input_.CurrentPosition();
+    if (!input_.Skip(size)) {
+      return false;
+    }
+    *value = data_.substr(begin, size);
+    return true;
+  }
+
+  // Skips the value of a field of type wire_type.
+  bool SkipValue(int wire_type) {
+    switch (wire_type) {
+      case WireFormatLite::WIRETYPE_VARINT: {
+        protobuf_uint64 value;
+        return input_.ReadVarint64(&value);
+      }
+      case WireFormatLite::WIRETYPE_FIXED64: {
+        protobuf_uint64 value;
+        return input_.ReadLittleEndian64(&value);
+      }
+      case WireFormatLite::WIRETYPE_LENGTH_DELIMITED: {
+        absl::string_view value;
+        return ReadLengthDelimited(&value);
+      }
+      case WireFormatLite::WIRETYPE_FIXED32: {
+        uint32 value;
+        return input_.ReadLittleEndian32(&value);
+      }
+      default:
+        // Groups are not used by the messages that are read.
+        return false;
+    }
+  }
+
+ private:
+  const absl::string_view data_;
+  protobuf::io::CodedInputStream input_;
+};
+
+}  // namespace data_validation
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_DATA_VALIDATION_ANOMALIES_WIRE_READER_H_
@@ -0,0 +1,100 @@
+/* Copyright 2018 Google LLC
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    https://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow_data_validation/anomalies/wire_reader.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace data_validation {
+namespace {
+
+// Field 1 is the bytes "ab", field 2 the varint 300, and field 3 the float
+// 1.0.
+const char kMessage[] = "\x0a\x02" "ab" "\x10\xac\x02" "\x1d\x00\x00\x80\x3f";
+
+absl::string_view GetMessage() {
+  return absl::string_view(kMessage, sizeof(kMessage) - 1);
+}
+
+TEST(WireReaderTest, ReadsFields) {
+  WireReader reader(GetMessage());
+  int field, wire_type;
+  ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+  EXPECT_EQ(1, field);
+  EXPECT_EQ(WireFormatLite::WIRETYPE_LENGTH_DELIMITED, wire_type);
+  absl::string_view bytes;
+  ASSERT_TRUE(reader.ReadLengthDelimited(&bytes));
+  EXPECT_EQ("ab", bytes);
+  // The value is a view of the message.
+  EXPECT_EQ(GetMessage().data() + 2, bytes.data());
+
+  ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+  EXPECT_EQ(2, field);
+  EXPECT_EQ(WireFormatLite::WIRETYPE_VARINT, wire_type);
+  uint64 varint;
+  ASSERT_TRUE(reader.ReadVarint(&varint));
+  EXPECT_EQ(uint64{300}, varint);
+  EXPECT_EQ(GetMessage().substr(7), reader.remaining());
+
+  ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+  EXPECT_EQ(3, field);
+  EXPECT_EQ(WireFormatLite::WIRETYPE_FIXED32, wire_type);
+  float value;
+  ASSERT_TRUE(reader.ReadFloat(&value));
+  EXPECT_EQ(1.0, value);
+  EXPECT_TRUE(reader.done());
+}
+
+TEST(WireReaderTest, SkipsValues) {
+  WireReader reader(GetMessage());
+  int num_fields = 0;
+  while (!reader.done()) {
+    int field, wire_type;
+    ASSERT_TRUE(reader.ReadTag(&field, &wire_type));
+    ASSERT_TRUE(reader.SkipValue(wire_type));
+    ++num_fields;
+  }
+  EXPECT_EQ(3, num_fields);
+}
+
+TEST(WireReaderTest, RejectsMalformedMessages) {
+  int field, wire_type;
+  // Field 0 is invalid.
+  EXPECT_FALSE(WireReader(absl::string_view("\x00", 1))
+                   .ReadTag(&field, &wire_type));
+  // A truncated varint.
+  uint64 varint;
+  EXPECT_FALSE(WireReader("\xac").ReadVarint(&varint));
+  // A length past the end of the message.
+  absl::string_view bytes;
+  EXPECT_FALSE(WireReader("\x05" "ab").ReadLengthDelimited(&bytes));
+  // A truncated float.
+  float value;
+  EXPECT_FALSE(WireReader("\x00\x00\x80").ReadFloat(&value));
+  // Groups are not supported.
+  WireReader group_reader("\x0b");
+  ASSERT_TRUE(group_reader.ReadTag(&field, &wire_type));
+  EXPECT_EQ(WireFormatLite::WIRETYPE_START_GROUP, wire_type);
+  EXPECT_FALSE(group_reader.SkipValue(wire_type));
+}
+
+}  // namespace
+}  // namespace data_validation
+}  // namespace tensorflow
@@ -30,6 +30,10 @@ generators:
      of string type.
   5) UniqueStatsGenerator, which computes the number of unique values for
      features of string type.
+If StatsOptions.approximate_top_k_and_uniques is set, the last two are replaced
+by ApproximateTopKStatsGenerator and ApproximateUniquesStatsGenerator, which
+estimate these statistics with fixed-size sketches instead of shuffling the
+values.
 
 Additional generators can be implemented and added to the default set to
 compute additional custom statistics.
@@ -45,7 +49,6 @@ from __future__ import division
 
 from __future__ import print_function
 
-import random
 import apache_beam as beam
 from tensorflow_data_validation import types
 from tensorflow_data_validation.statistics import stats_impl
@@ -138,6 +141,11 @@ class GenerateStatistics(beam.PTransform):
     if options.sample_rate is not None and not 0 < options.sample_rate <= 1:
       raise ValueError('Invalid sample_rate %f' % options.sample_rate)
 
+    if (options.desired_batch_bytes is not None and
+        options.desired_batch_bytes < 1):
+      raise ValueError(
+          'Invalid desired_batch_bytes %d' % options.desired_batch_bytes)
+
     if options.num_values_histogram_buckets < 1:
       raise ValueError('Invalid num_values_histogram_buckets %d' %
                        options.num_values_histogram_buckets)
@@ -151,6 +159,33 @@ class GenerateStatistics(beam.PTransform):
                        options.num_quantiles_histogram_buckets)
 
   def expand(self, dataset):
+    # Sample input data if sample_count option is provided. The examples are
+    # sampled at sample_rate once they are batched.
+    if self._options.sample_count is not None:
+      # beam.combiners.Sample.FixedSizeGlobally returns a
+      # PCollection[List[types.Example]], which we then flatten to get a
+      # PCollection[types.Example].
+      dataset |= ('SampleExamples(%s)' % self._options.sample_count >>
+                  beam.combiners.Sample.FixedSizeGlobally(
+                      self._options.sample_count)
+                  | 'FlattenExamples' >> beam.FlatMap(lambda lst: lst))
+
+    # Batch the input examples.
+    desired_batch_size = (None if self._options.sample_count is None else
+                          self._options.sample_count)
+    dataset = (dataset | 'BatchExamples' >> batch_util.BatchExamples(
+        desired_batch_size=desired_batch_size,
+        desired_batch_bytes=self._options.desired_batch_bytes))
+
+    return self._generate_statistics_from_batches(dataset)
+
+  def _generate_statistics_from_batches(self, dataset):
+    """Runs the statistics generators on batches of examples."""
+    # Sample the batches if sample_rate option is provided.
+    if self._options.sample_rate is not None:
+      dataset |= ('SampleExamplesAtRate(%s)' % self._options.sample_rate >>
+                  batch_util.SampleBatches(self._options.sample_rate))
+
     # Initialize a list of stats generators to run.
     stats_generators = [
         # Create common stats generator.
@@ -159,7 +194,8 @@ class GenerateStatistics(beam.PTransform):
             weight_feature=self._options.weight_feature,
             num_values_histogram_buckets=\
                 self._options.num_values_histogram_buckets,
-            epsilon=self._options.epsilon),
+            epsilon=self._options.epsilon,
+            sample_rate=self._options.sample_rate),
 
         # Create numeric stats generator.
         numeric_stats_generator.NumericStatsGenerator(
@@ -168,62 +204,90 @@ class GenerateStatistics(beam.PTransform):
             num_histogram_buckets=self._options.num_histogram_buckets,
             num_quantiles_histogram_buckets=\
                 self._options.num_quantiles_histogram_buckets,
-            epsilon=self._options.epsilon),
+            epsilon=self._options.epsilon,
+            sample_rate=self._options.sample_rate),
 
         # Create string stats generator.
         string_stats_generator.StringStatsGenerator(
-            schema=self._options.schema),
-
-        # Create topk stats generator.
-        top_k_stats_generator.TopKStatsGenerator(
-            schema=self._options.schema,
-            weight_feature=self._options.weight_feature,
-            num_top_values=self._options.num_top_values,
-            num_rank_histogram_buckets=\
-                self._options.num_rank_histogram_buckets),
-
-        # Create uniques stats generator.
-        uniques_stats_generator.UniquesStatsGenerator(
             schema=self._options.schema)
     ]
+    if self._options.approximate_top_k_and_uniques:
+      stats_generators.extend([
+          # Create approximate topk stats generator.
+          top_k_stats_generator.ApproximateTopKStatsGenerator(
+              schema=self._options.schema,
+              weight_feature=self._options.weight_feature,
+              num_top_values=self._options.num_top_values,
+              num_rank_histogram_buckets=\
+                  self._options.num_rank_histogram_buckets),
+
+          # Create approximate uniques stats generator.
+          uniques_stats_generator.ApproximateUniquesStatsGenerator(
+              schema=self._options.schema)
+      ])
+    else:
+      stats_generators.extend([
+          # Create topk stats generator.
+          top_k_stats_generator.TopKStatsGenerator(
+              schema=self._options.schema,
+              weight_feature=self._options.weight_feature,
+              num_top_values=self._options.num_top_values,
+              num_rank_histogram_buckets=\
+                  self._options.num_rank_histogram_buckets),
+
+          # Create uniques stats generator.
+          uniques_stats_generator.UniquesStatsGenerator(
+              schema=self._options.schema)
+      ])
     if self._options.generators is not None:
       # Add custom stats generators.
       stats_generators.extend(self._options.generators)
 
-    # Sample input data if sample_count option is provided.
-    if self._options.sample_count is not None:
-      # beam.combiners.Sample.FixedSizeGlobally returns a
-      # PCollection[List[types.Example]], which we then flatten to get a
-      # PCollection[types.Example].
-      dataset |= ('SampleExamples(%s)' % self._options.sample_count >>
-                  beam.combiners.Sample.FixedSizeGlobally(
-                      self._options.sample_count)
-                  | 'FlattenExamples' >> beam.FlatMap(lambda lst: lst))
-    elif self._options.sample_rate is not None:
-      dataset |= ('SampleExamplesAtRate(%s)' % self._options.sample_rate >>
-                  beam.FlatMap(_sample_at_rate,
-                               sample_rate=self._options.sample_rate))
-
-    # Batch the input examples.
-    desired_batch_size = (None if self._options.sample_count is None else
-                          self._options.sample_count)
-    dataset = (dataset | 'BatchExamples' >> batch_util.BatchExamples(
-        desired_batch_size=desired_batch_size))
-
     # If a set of whitelist features are provided, keep only those features.
     if self._options.feature_whitelist:
       dataset |= ('RemoveNonWhitelistedFeatures' >> beam.Map(
           _filter_features, feature_whitelist=self._options.feature_whitelist))
 
     return (dataset | 'RunStatsGenerators' >>
-            stats_impl.GenerateStatisticsImpl(stats_generators))
+            stats_impl.GenerateStatisticsImpl(
+                stats_generators,
+                fuse_combiners=self._options.fuse_combiner_generators))
+
+
+@beam.typehints.with_input_types(types.ExampleBatch)
+@beam.typehints.with_output_types(statistics_pb2.DatasetFeatureStatisticsList)
+class GenerateStatisticsFromBatches(GenerateStatistics):
+  """API for generating data statistics on batches of examples.
+
+  This is GenerateStatistics on input that is already batched in the format of
+  batch_util.BatchExamples, such as the output of
+  tf_example_decoder.DecodeTFExampleBatches, which decodes batches of examples
+  natively. As the input is batched, the examples can be sampled at a rate
+  (sample_rate), but not to a count (sample_count).
+
+  Example:
+
+  ```python
+    with beam.Pipeline(runner=...) as p:
+      _ = (p
+           | 'ReadData' >> beam.io.ReadFromTFRecord(data_location)
+           | 'DecodeData' >> DecodeTFExampleBatches()
+           | 'GenerateStatistics' >> GenerateStatisticsFromBatches()
+           | 'WriteStatsOutput' >> beam.io.WriteToTFRecord(
+               output_path, shard_name_template='',
+               coder=beam.coders.ProtoCoder(
+                   statistics_pb2.DatasetFeatureStatisticsList)))
+  ```
+  """
 
+  def _check_options(self, options):
+    super(GenerateStatisticsFromBatches, self)._check_options(options)
+    if options.sample_count is not None:
+      raise ValueError('sample_count is not supported on batches of '
+                       'examples.')
 
-def _sample_at_rate(example, sample_rate
-                   ):
-  """Sample examples at input sampling rate."""
-  if random.random() <= sample_rate:
-    yield example
+  def expand(self, dataset):
+    return self._generate_statistics_from_batches(dataset)
 
 
 def _filter_features(
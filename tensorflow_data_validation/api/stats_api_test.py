@@ -806,6 +806,83 @@ class StatsAPITest(absltest.TestCase):
         options = stats_options.StatsOptions(sample_rate=-1)
         _ = (p | beam.Create(examples) | stats_api.GenerateStatistics(options))
 
+  def test_invalid_desired_batch_bytes(self):
+    with self.assertRaises(ValueError):
+      stats_api.GenerateStatistics(
+          stats_options.StatsOptions(desired_batch_bytes=0))
+
+  def test_stats_pipeline_with_desired_batch_bytes(self):
+    examples = [{'a': np.array([float(i)], dtype=np.floating)}
+                for i in range(100)]
+
+    def _matcher(actual):
+      self.assertEqual(1, len(actual))
+      self.assertEqual(1, len(actual[0].datasets))
+      dataset = actual[0].datasets[0]
+      self.assertEqual(100, dataset.num_examples)
+      self.assertEqual(['a'], [feature.name for feature in dataset.features])
+      self.assertEqual(100, dataset.features[0].num_stats.common_stats
+                       .num_non_missing)
+
+    with beam.Pipeline() as p:
+      result = (
+          p | beam.Create(examples)
+          | stats_api.GenerateStatistics(
+              stats_options.StatsOptions(desired_batch_bytes=64)))
+      util.assert_that(result, _matcher)
+
+  def test_stats_from_batches_with_sample_count(self):
+    with self.assertRaisesRegexp(ValueError, '.*not supported on batches.*'):
+      stats_api.GenerateStatisticsFromBatches(
+          stats_options.StatsOptions(sample_count=1))
+
+  def test_stats_from_batches(self):
+    batches = [{'a': np.array([np.array(['x', 'y']), np.array(['x'])],
+                              dtype=np.object)}]
+    options = stats_options.StatsOptions(
+        num_top_values=1, num_rank_histogram_buckets=1)
+    with beam.Pipeline() as p:
+      from_batches = (
+          p | 'CreateBatches' >> beam.Create(batches)
+          | 'FromBatches' >> stats_api.GenerateStatisticsFromBatches(options))
+      from_examples = (
+          p | 'CreateExamples' >> beam.Create(
+              [{'a': np.array(['x', 'y'], dtype=np.object)},
+               {'a': np.array(['x'], dtype=np.object)}])
+          | 'FromExamples' >> stats_api.GenerateStatistics(options))
+      util.assert_that(
+          (from_batches, from_examples)
+          | beam.Flatten()
+          | beam.Map(lambda stats: stats.SerializeToString())
+          | beam.combiners.Count.PerElement()
+          | beam.Map(lambda serialized_and_count: serialized_and_count[1]),
+          util.equal_to([2]))
+
+  def test_stats_from_batches_with_sample_rate(self):
+    batches = [{'a': np.array([np.array(['x', 'y']), np.array(['x'])],
+                              dtype=np.object)}]
+    with beam.Pipeline() as p:
+      from_batches = (
+          p | 'CreateBatches' >> beam.Create(batches)
+          | 'FromBatches' >> stats_api.GenerateStatisticsFromBatches(
+              stats_options.StatsOptions(
+                  sample_rate=1.0, num_top_values=1,
+                  num_rank_histogram_buckets=1)))
+      from_examples = (
+          p | 'CreateExamples' >> beam.Create(
+              [{'a': np.array(['x', 'y'], dtype=np.object)},
+               {'a': np.array(['x'], dtype=np.object)}])
+          | 'FromExamples' >> stats_api.GenerateStatistics(
+              stats_options.StatsOptions(
+                  num_top_values=1, num_rank_histogram_buckets=1)))
+      util.assert_that(
+          (from_batches, from_examples)
+          | beam.Flatten()
+          | beam.Map(lambda stats: stats.SerializeToString())
+          | beam.combiners.Count.PerElement()
+          | beam.Map(lambda serialized_and_count: serialized_and_count[1]),
+          util.equal_to([2]))
+
   def test_custom_generators(self):
 
     # Dummy PTransform that returns two DatasetFeatureStatistics protos.
@@ -32,7 +32,8 @@ from tensorflow_metadata.proto.v0 import statistics_pb2
 
 def infer_schema(statistics,
                  infer_feature_shape = True,
-                 max_string_domain_size = 100
+                 max_string_domain_size = 100,
+                 num_threads = 1
                 ):
   """Infer schema from the input statistics.
 
@@ -44,6 +45,8 @@ def infer_schema(statistics,
         to be inferred from the statistics.
     max_string_domain_size: Maximum size of the domain of a string feature in
         order to be interpreted as a categorical feature.
+    num_threads: The number of threads used to infer the features of the
+        schema. The inferred schema does not depend on it.
 
   Returns:
     A Schema protocol buffer.
@@ -65,7 +68,7 @@ def infer_schema(statistics,
 
   schema_proto_string = pywrap_tensorflow_data_validation.InferSchema(
       tf.compat.as_bytes(statistics.datasets[0].SerializeToString()),
-      max_string_domain_size)
+      max_string_domain_size, num_threads)
 
   # Parse the serialized Schema proto.
   result = schema_pb2.Schema()
@@ -139,14 +142,7 @@ def validate_statistics(
     TypeError: If any of the input arguments is not of the expected type.
     ValueError: If the input statistics proto does not have only one dataset.
   """
-  if not isinstance(statistics, statistics_pb2.DatasetFeatureStatisticsList):
-    raise TypeError(
-        'statistics is of type %s, should be '
-        'a DatasetFeatureStatisticsList proto.' % type(statistics).__name__)
-
-  if len(statistics.datasets) != 1:
-    raise ValueError('statistics proto contains multiple datasets. Only '
-                     'one dataset is currently supported for validation.')
+  serialized_stats = _serialize_statistics(statistics, 'statistics')
 
   if not isinstance(schema, schema_pb2.Schema):
     raise TypeError('schema is of type %s, should be a Schema proto.' %
@@ -158,50 +154,15 @@ def validate_statistics(
   else:
     environment = ''
 
-  _check_for_unsupported_stats_fields(statistics.datasets[0], 'statistics')
   _check_for_unsupported_schema_fields(schema)
 
-  if previous_statistics is not None:
-    if not isinstance(
-        previous_statistics, statistics_pb2.DatasetFeatureStatisticsList):
-      raise TypeError(
-          'previous_statistics is of type %s, should be '
-          'a DatasetFeatureStatisticsList proto.'
-          % type(previous_statistics).__name__)
-
-    if len(previous_statistics.datasets) != 1:
-      raise ValueError(
-          'previous_statistics proto contains multiple datasets. '
-          'Only one dataset is currently supported for validation.')
-
-    _check_for_unsupported_stats_fields(previous_statistics.datasets[0],
-                                        'previous_statistics')
-
-  if serving_statistics is not None:
-    if not isinstance(
-        serving_statistics, statistics_pb2.DatasetFeatureStatisticsList):
-      raise TypeError(
-          'serving_statistics is of type %s, should be '
-          'a DatasetFeatureStatisticsList proto.'
-          % type(serving_statistics).__name__)
-
-    if len(serving_statistics.datasets) != 1:
-      raise ValueError(
-          'serving_statistics proto contains multiple datasets. '
-          'Only one dataset is currently supported for validation.')
-
-    _check_for_unsupported_stats_fields(serving_statistics.datasets[0],
-                                        'serving_statistics')
-
-  # Serialize the input protos.
-  serialized_schema = schema.SerializeToString()
-  serialized_stats = statistics.datasets[0].SerializeToString()
   serialized_previous_stats = (
-      previous_statistics.datasets[0].SerializeToString()
+      _serialize_statistics(previous_statistics, 'previous_statistics')
       if previous_statistics is not None else '')
   serialized_serving_stats = (
-      serving_statistics.datasets[0].SerializeToString()
+      _serialize_statistics(serving_statistics, 'serving_statistics')
       if serving_statistics is not None else '')
+  serialized_schema = schema.SerializeToString()
 
   anomalies_proto_string = (
       pywrap_tensorflow_data_validation.ValidateFeatureStatistics(
@@ -217,6 +178,253 @@ def validate_statistics(
   return result
 
 
+def validate_statistics_batch(
+    statistics_list,
+    schema,
+    environment = None,
+    num_threads = 1,
+):
+  """Validate each of the input statistics against the provided input schema.
+
+  This is equivalent to calling `validate_statistics` on each element of
+  `statistics_list` without previous or serving statistics, but the schema is
+  only processed once, and the statistics are validated concurrently.
+
+  Args:
+    statistics_list: A list of DatasetFeatureStatisticsList protocol buffers,
+        each of which must contain a single DatasetFeatureStatistics proto.
+    schema: A Schema protocol buffer.
+    environment: An optional string denoting the validation environment.
+        Must be one of the default environments specified in the schema.
+        See `validate_statistics` for details.
+    num_threads: The number of threads used to validate the statistics.
+
+  Returns:
+    A list of Anomalies protocol buffers, one for each of `statistics_list`,
+    in the same order.
+
+  Raises:
+    TypeError: If any of the input arguments is not of the expected type.
+    ValueError: If any of the input statistics protos does not have only one
+        dataset.
+  """
+  if not isinstance(statistics_list, list):
+    raise TypeError('statistics_list is of type %s, should be a list.' %
+                    type(statistics_list).__name__)
+
+  for statistics in statistics_list:
+    if not isinstance(statistics, statistics_pb2.DatasetFeatureStatisticsList):
+      raise TypeError(
+          'statistics_list contains an element of type %s, should be '
+          'a DatasetFeatureStatisticsList proto.' % type(statistics).__name__)
+
+    if len(statistics.datasets) != 1:
+      raise ValueError('statistics proto contains multiple datasets. Only '
+                       'one dataset is currently supported for validation.')
+
+  if not isinstance(schema, schema_pb2.Schema):
+    raise TypeError('schema is of type %s, should be a Schema proto.' %
+                    type(schema).__name__)
+
+  if environment is not None:
+    if environment not in schema.default_environment:
+      raise ValueError('Environment %s not found in the schema.' % environment)
+  else:
+    environment = ''
+
+  for statistics in statistics_list:
+    _check_for_unsupported_stats_fields(statistics.datasets[0], 'statistics')
+  _check_for_unsupported_schema_fields(schema)
+
+  anomalies_proto_strings = (
+      pywrap_tensorflow_data_validation.ValidateFeatureStatisticsBatch(
+          [tf.compat.as_bytes(statistics.datasets[0].SerializeToString())
+           for statistics in statistics_list],
+          tf.compat.as_bytes(schema.SerializeToString()),
+          tf.compat.as_bytes(environment),
+          num_threads))
+
+  # Parse the serialized Anomalies protos.
+  results = []
+  for anomalies_proto_string in anomalies_proto_strings:
+    result = anomalies_pb2.Anomalies()
+    result.ParseFromString(anomalies_proto_string)
+    results.append(result)
+  return results
+
+
+class SchemaValidator(object):
+  """Validates statistics against a fixed schema.
+
+  The schema is serialized, parsed and indexed once, when the SchemaValidator
+  is created, rather than on each validation as in `validate_statistics`. This
+  is for validating many statistics against the same schema, e.g., in a loop
+  that validates new data every hour. `validate` can be called concurrently
+  from several threads, which then run in parallel.
+  """
+
+  def __init__(self, schema):
+    """Initializes the SchemaValidator.
+
+    Args:
+      schema: A Schema protocol buffer.
+
+    Raises:
+      TypeError: If the schema is not a Schema protocol buffer.
+    """
+    if not isinstance(schema, schema_pb2.Schema):
+      raise TypeError('schema is of type %s, should be a Schema proto.' %
+                      type(schema).__name__)
+    _check_for_unsupported_schema_fields(schema)
+    self._default_environments = set(schema.default_environment)
+    self._validator = (
+        pywrap_tensorflow_data_validation.CreateCompiledSchemaValidator(
+            tf.compat.as_bytes(schema.SerializeToString())))
+
+  def validate(
+      self,
+      statistics,
+      environment = None,
+      previous_statistics = None,
+      serving_statistics = None,
+  ):
+    """Validates the input statistics against the schema.
+
+    This is equivalent to `validate_statistics` with the schema of the
+    SchemaValidator.
+
+    Args:
+      statistics: A DatasetFeatureStatisticsList protocol buffer, which must
+          contain a single DatasetFeatureStatistics proto.
+      environment: An optional string denoting the validation environment.
+          See `validate_statistics`.
+      previous_statistics: An optional DatasetFeatureStatisticsList protocol
+          buffer for drift detection. See `validate_statistics`.
+      serving_statistics: An optional DatasetFeatureStatisticsList protocol
+          buffer for skew detection. See `validate_statistics`.
+
+    Returns:
+      An Anomalies protocol buffer.
+
+    Raises:
+      TypeError: If any of the input arguments is not of the expected type.
+      ValueError: If any of the input statistics protos does not have only one
+          dataset, or if the environment is not in the schema.
+    """
+    serialized_stats = _serialize_statistics(statistics, 'statistics')
+    if environment is not None:
+      if environment not in self._default_environments:
+        raise ValueError(
+            'Environment %s not found in the schema.' % environment)
+    else:
+      environment = ''
+    serialized_previous_stats = (
+        _serialize_statistics(previous_statistics, 'previous_statistics')
+        if previous_statistics is not None else '')
+    serialized_serving_stats = (
+        _serialize_statistics(serving_statistics, 'serving_statistics')
+        if serving_statistics is not None else '')
+
+    anomalies_proto_string = (
+        pywrap_tensorflow_data_validation.ValidateWithCompiledSchemaValidator(
+            self._validator,
+            tf.compat.as_bytes(serialized_stats),
+            tf.compat.as_bytes(environment),
+            tf.compat.as_bytes(serialized_previous_stats),
+            tf.compat.as_bytes(serialized_serving_stats)))
+
+    # Parse the serialized Anomalies proto.
+    result = anomalies_pb2.Anomalies()
+    result.ParseFromString(anomalies_proto_string)
+    return result
+
+  def validate_slices(
+      self,
+      statistics,
+      environment = None,
+      num_threads = 1
+  ):
+    """Validates each slice of the input statistics against the schema.
+
+    Each dataset of the statistics is a slice, e.g., the statistics of the
+    examples of a country, and is validated as `validate` would validate it,
+    without previous or serving statistics. The slices are validated in
+    parallel, and the schema is shared by all of them.
+
+    Args:
+      statistics: A DatasetFeatureStatisticsList protocol buffer, whose
+          datasets have distinct names.
+      environment: An optional string denoting the validation environment.
+          See `validate_statistics`.
+      num_threads: The number of threads on which to validate the slices.
+
+    Returns:
+      A dict from the name of each slice to its Anomalies protocol buffer.
+
+    Raises:
+      TypeError: If statistics is not a DatasetFeatureStatisticsList proto.
+      ValueError: If the environment is not in the schema.
+      RuntimeError: If two slices have the same name.
+    """
+    if not isinstance(statistics, statistics_pb2.DatasetFeatureStatisticsList):
+      raise TypeError(
+          'statistics is of type %s, should be '
+          'a DatasetFeatureStatisticsList proto.' % type(statistics).__name__)
+    for dataset in statistics.datasets:
+      _check_for_unsupported_stats_fields(dataset, 'statistics')
+    if environment is not None:
+      if environment not in self._default_environments:
+        raise ValueError(
+            'Environment %s not found in the schema.' % environment)
+    else:
+      environment = ''
+
+    anomalies_proto_strings = (
+        pywrap_tensorflow_data_validation
+        .ValidateSlicesWithCompiledSchemaValidator(
+            self._validator,
+            tf.compat.as_bytes(statistics.SerializeToString()),
+            tf.compat.as_bytes(environment), num_threads))
+
+    # Parse the serialized Anomalies protos.
+    result = {}
+    for name, anomalies_proto_string in anomalies_proto_strings.items():
+      result[name] = anomalies_pb2.Anomalies()
+      result[name].ParseFromString(anomalies_proto_string)
+    return result
+
+
+def _serialize_statistics(
+    statistics,
+    stats_type):
+  """Checks and serializes the single dataset of the statistics.
+
+  Args:
+    statistics: A DatasetFeatureStatisticsList protocol buffer.
+    stats_type: The name of the statistics in the errors and warnings.
+
+  Returns:
+    The serialized DatasetFeatureStatistics proto of the statistics.
+
+  Raises:
+    TypeError: If statistics is not a DatasetFeatureStatisticsList proto.
+    ValueError: If statistics does not have only one dataset.
+  """
+  if not isinstance(statistics, statistics_pb2.DatasetFeatureStatisticsList):
+    raise TypeError(
+        '%s is of type %s, should be '
+        'a DatasetFeatureStatisticsList proto.' %
+        (stats_type, type(statistics).__name__))
+
+  if len(statistics.datasets) != 1:
+    raise ValueError('%s proto contains multiple datasets. Only '
+                     'one dataset is currently supported for validation.' %
+                     stats_type)
+
+  _check_for_unsupported_stats_fields(statistics.datasets[0], stats_type)
+  return statistics.datasets[0].SerializeToString()
+
+
 def _check_for_unsupported_schema_fields(schema):
   """Log warnings when we encounter unsupported fields in the schema."""
   if schema.sparse_feature:
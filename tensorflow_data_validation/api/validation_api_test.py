@@ -136,6 +136,9 @@ class ValidationApiTest(absltest.TestCase):
     # Infer the schema from the stats.
     actual_schema = validation_api.infer_schema(statistics)
     self.assertEqual(actual_schema, expected_schema)
+    # The inferred schema does not depend on the number of threads.
+    actual_schema = validation_api.infer_schema(statistics, num_threads=4)
+    self.assertEqual(actual_schema, expected_schema)
 
   def test_infer_schema_without_string_domain(self):
     statistics = text_format.Parse(
@@ -571,6 +574,209 @@ class ValidationApiTest(absltest.TestCase):
         statistics, schema, environment='SERVING')
     self._assert_equal_anomalies(anomalies_serving, {})
 
+  def test_validate_stats_batch(self):
+    schema = text_format.Parse(
+        """
+        default_environment: "TRAINING"
+        default_environment: "SERVING"
+        feature {
+          name: "label"
+          not_in_environment: "SERVING"
+          value_count { min: 1 max: 1 }
+          presence { min_count: 1 }
+          type: BYTES
+        }
+        """, schema_pb2.Schema())
+    with_label = text_format.Parse(
+        """
+        datasets {
+          num_examples: 1000
+          features {
+            name: 'label'
+            type: STRING
+            string_stats {
+              common_stats {
+                num_non_missing: 1000
+                min_num_values: 1
+                max_num_values: 1
+              }
+              unique: 3
+            }
+          }
+        }""", statistics_pb2.DatasetFeatureStatisticsList())
+    without_label = text_format.Parse(
+        """
+        datasets {
+          num_examples: 1000
+        }""", statistics_pb2.DatasetFeatureStatisticsList())
+    statistics_list = [with_label, without_label, with_label]
+
+    for environment in ['TRAINING', 'SERVING']:
+      anomalies_list = validation_api.validate_statistics_batch(
+          statistics_list, schema, environment=environment, num_threads=2)
+      self.assertEqual(len(anomalies_list), len(statistics_list))
+      for statistics, anomalies in zip(statistics_list, anomalies_list):
+        self.assertEqual(
+            anomalies,
+            validation_api.validate_statistics(
+                statistics, schema, environment=environment))
+
+  def test_validate_stats_batch_invalid_statistics_input(self):
+    schema = schema_pb2.Schema()
+    with self.assertRaisesRegexp(TypeError, '.*should be a list.*'):
+      _ = validation_api.validate_statistics_batch(
+          statistics_pb2.DatasetFeatureStatisticsList(), schema)
+    with self.assertRaisesRegexp(
+        ValueError, '.*statistics proto contains multiple datasets.*'):
+      _ = validation_api.validate_statistics_batch(
+          [statistics_pb2.DatasetFeatureStatisticsList()], schema)
+
+  def test_schema_validator(self):
+    schema = text_format.Parse(
+        """
+        default_environment: "TRAINING"
+        default_environment: "SERVING"
+        feature {
+          name: "label"
+          not_in_environment: "SERVING"
+          value_count { min: 1 max: 1 }
+          presence { min_count: 1 }
+          type: BYTES
+          skew_comparator { infinity_norm { threshold: 0.1 } }
+        }
+        """, schema_pb2.Schema())
+    with_label = text_format.Parse(
+        """
+        datasets {
+          num_examples: 1000
+          features {
+            name: 'label'
+            type: STRING
+            string_stats {
+              common_stats {
+                num_non_missing: 1000
+                min_num_values: 1
+                max_num_values: 1
+              }
+              unique: 2
+              rank_histogram {
+                buckets { label: "a" sample_count: 500 }
+                buckets { label: "b" sample_count: 500 }
+              }
+            }
+          }
+        }""", statistics_pb2.DatasetFeatureStatisticsList())
+    skewed_label = text_format.Parse(
+        """
+        datasets {
+          num_examples: 1000
+          features {
+            name: 'label'
+            type: STRING
+            string_stats {
+              common_stats {
+                num_non_missing: 1000
+                min_num_values: 1
+                max_num_values: 1
+              }
+              unique: 2
+              rank_histogram {
+                buckets { label: "a" sample_count: 900 }
+                buckets { label: "b" sample_count: 100 }
+              }
+            }
+          }
+        }""", statistics_pb2.DatasetFeatureStatisticsList())
+    without_label = text_format.Parse(
+        """
+        datasets {
+          num_examples: 1000
+        }""", statistics_pb2.DatasetFeatureStatisticsList())
+
+    validator = validation_api.SchemaValidator(schema)
+    # The validator is used twice for each input, to check that nothing is
+    # carried over from one validation to the next.
+    for _ in range(2):
+      for statistics in [with_label, without_label]:
+        for environment in [None, 'TRAINING', 'SERVING']:
+          self.assertEqual(
+              validator.validate(statistics, environment=environment),
+              validation_api.validate_statistics(
+                  statistics, schema, environment=environment))
+      anomalies = validator.validate(
+          with_label, serving_statistics=skewed_label)
+      self.assertEqual(
+          anomalies,
+          validation_api.validate_statistics(
+              with_label, schema, serving_statistics=skewed_label))
+      self.assertIn('label', anomalies.anomaly_info)
+
+  def test_schema_validator_validate_slices(self):
+    schema = text_format.Parse(
+        """
+        feature {
+          name: "label"
+          value_count { min: 1 max: 1 }
+          presence { min_count: 1 }
+          type: BYTES
+        }
+        """, schema_pb2.Schema())
+    statistics = text_format.Parse(
+        """
+        datasets {
+          name: 'with_label'
+          num_examples: 10
+          features {
+            name: 'label'
+            type: STRING
+            string_stats {
+              common_stats {
+                num_non_missing: 10
+                min_num_values: 1
+                max_num_values: 1
+              }
+            }
+          }
+        }
+        datasets {
+          name: 'without_label'
+          num_examples: 10
+        }""", statistics_pb2.DatasetFeatureStatisticsList())
+
+    validator = validation_api.SchemaValidator(schema)
+    for num_threads in [1, 2]:
+      anomalies = validator.validate_slices(statistics, num_threads=num_threads)
+      self.assertEqual(set(anomalies), set(['with_label', 'without_label']))
+      for dataset in statistics.datasets:
+        slice_statistics = statistics_pb2.DatasetFeatureStatisticsList()
+        slice_statistics.datasets.add().CopyFrom(dataset)
+        self.assertEqual(anomalies[dataset.name],
+                         validator.validate(slice_statistics))
+      self.assertNotIn('label', anomalies['with_label'].anomaly_info)
+      self.assertIn('label', anomalies['without_label'].anomaly_info)
+
+    statistics.datasets[1].name = 'with_label'
+    with self.assertRaisesRegexp(RuntimeError, '.*Duplicate slice name.*'):
+      _ = validator.validate_slices(statistics)
+
+  def test_schema_validator_invalid_input(self):
+    with self.assertRaisesRegexp(TypeError, '.*should be a Schema proto.*'):
+      _ = validation_api.SchemaValidator({})
+    validator = validation_api.SchemaValidator(schema_pb2.Schema())
+    with self.assertRaisesRegexp(
+        TypeError, '.*should be a DatasetFeatureStatisticsList proto.*'):
+      _ = validator.validate({})
+    statistics = statistics_pb2.DatasetFeatureStatisticsList()
+    statistics.datasets.add()
+    with self.assertRaisesRegexp(
+        ValueError, '.*previous_statistics proto contains multiple datasets.*'):
+      _ = validator.validate(
+          statistics,
+          previous_statistics=statistics_pb2.DatasetFeatureStatisticsList())
+    with self.assertRaisesRegexp(
+        ValueError, '.*Environment.*not found in the schema.*'):
+      _ = validator.validate(statistics, environment='TRAINING')
+
   def test_validate_stats_with_previous_and_serving_stats(self):
     statistics = text_format.Parse(
         """
@@ -23,6 +23,8 @@ import csv
 import apache_beam as beam
 import numpy as np
 from tensorflow_data_validation import types
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
+from tensorflow_data_validation.utils import batch_util
 from tensorflow_data_validation.types_compat import Dict, List, Optional, Text, Union
 
 from tensorflow_metadata.proto.v0 import schema_pb2
@@ -105,6 +107,87 @@ class DecodeCSV(beam.PTransform):
         column_info=column_info))
 
 
+@beam.typehints.with_input_types(CSVRecord)
+@beam.typehints.with_output_types(types.ExampleBatch)
+class DecodeCSVBatches(beam.PTransform):
+  """Decodes CSV records into batches in the format of
+  batch_util.BatchExamples, for GenerateStatisticsFromBatches.
+
+  The result is that of DecodeCSV followed by batch_util.BatchExamples, but
+  each batch of records is split, typed and converted natively, with a buffer
+  of values per column, without a Python object per record or per cell. A
+  batch with a record that the native decoder does not handle (such as a
+  quoted cell without an end) is decoded with the csv module, which also
+  raises the errors.
+  """
+
+  def __init__(self,
+               column_names,
+               delimiter = ',',
+               skip_blank_lines = True,
+               schema = None,
+               infer_type_from_schema = False,
+               desired_batch_size = None):
+    """Initializes the CSV batch decoder.
+
+    Args:
+      column_names: List of feature names. Order must match the order in the
+          CSV file.
+      delimiter: A one-character string used to separate fields.
+      skip_blank_lines: A boolean to indicate whether to skip over blank lines
+          rather than interpreting them as missing values.
+      schema: An optional schema of the input data.
+      infer_type_from_schema: A boolean to indicate whether the feature types
+          should be inferred from the schema. If set to True, an input schema
+          must be provided.
+      desired_batch_size: Optional batch size for batching examples when
+          computing data statistics.
+    """
+    if not isinstance(column_names, list):
+      raise TypeError('column_names is of type %s, should be a list' %
+                      type(column_names).__name__)
+    self._column_names = column_names
+    self._delimiter = delimiter
+    self._skip_blank_lines = skip_blank_lines
+    self._schema = schema
+    self._infer_type_from_schema = infer_type_from_schema
+    self._desired_batch_size = desired_batch_size
+
+  def expand(self, lines):
+    """Decodes batches of CSV records.
+
+    Args:
+      lines: A PCollection of strings representing the lines in the CSV file.
+
+    Returns:
+      A PCollection of dicts representing batches of CSV records.
+    """
+    batch_args = {}
+    if self._desired_batch_size:
+      batch_args = dict(
+          min_batch_size=self._desired_batch_size,
+          max_batch_size=self._desired_batch_size)
+    batches = lines | 'BatchCSVRecords' >> beam.BatchElements(**batch_args)
+
+    if self._infer_type_from_schema:
+      column_info = _get_feature_types_from_schema(self._schema,
+                                                   self._column_names)
+    else:
+      column_info = (
+          batches | 'InferFeatureTypes' >> beam.CombineGlobally(
+              _BatchFeatureTypeInferrer(
+                  column_names=self._column_names,
+                  skip_blank_lines=self._skip_blank_lines,
+                  delimiter=self._delimiter)))
+      column_info = beam.pvalue.AsSingleton(column_info)
+
+    return (batches | 'DecodeCSVBatches' >> beam.FlatMap(
+        _decode_csv_batch,
+        delimiter=self._delimiter,
+        skip_blank_lines=self._skip_blank_lines,
+        column_info=column_info))
+
+
 def _get_feature_types_from_schema(schema,
                                    column_names
                                   ):
@@ -231,6 +314,44 @@ def _make_example_dict(
   return [result]
 
 
+def _decode_csv_batch(
+    lines, delimiter,
+    skip_blank_lines,
+    column_info):
+  """Creates the in-memory representation of a batch of CSV records.
+
+  Args:
+    lines: List of CSV records.
+    delimiter: A one-character string used to separate fields.
+    skip_blank_lines: A boolean to indicate whether to skip over blank lines
+      rather than interpreting them as missing values.
+    column_info: List of tuples specifying column name and its type.
+
+  Returns:
+    A list containing the batch of the input CSV records, or an empty list if
+    every record is skipped.
+  """
+  try:
+    num_examples, columns = pywrap_tensorflow_data_validation.DecodeCSVBatch(
+        lines, _to_utf8_string(delimiter), skip_blank_lines,
+        [feature_type for _, feature_type in column_info])
+  except ValueError:
+    parser = CSVParser(delimiter=delimiter)
+    examples = []
+    for line in lines:
+      examples.extend(_make_example_dict(
+          parser.parse(line), skip_blank_lines, column_info))
+    return [batch_util.merge_single_batch(examples)] if examples else []
+  if not num_examples:
+    return []
+  result = {}
+  for index, (kind, values, row_offsets, has_values) in enumerate(columns):
+    result[column_info[index].name] = (
+        batch_util.decoded_column_to_batch_value(
+            kind, values, row_offsets, has_values, num_examples))
+  return [result]
+
+
 _INT64_MIN = np.iinfo(np.int64).min
 _INT64_MAX = np.iinfo(np.int64).max
 
@@ -350,3 +471,49 @@ class _FeatureTypeInferrer(beam.CombineFn):
         ColumnInfo(col_name, accumulator.get(col_name, None))
         for col_name in self._column_names
     ]
+
+
+@beam.typehints.with_input_types(List[CSVRecord])
+@beam.typehints.with_output_types(beam.typehints.List[ColumnInfo])
+class _BatchFeatureTypeInferrer(_FeatureTypeInferrer):
+  """Class to infer feature types from batches of CSV records."""
+
+  def __init__(self, column_names,
+               skip_blank_lines, delimiter):
+    """Initializes a feature type inferrer combiner."""
+    super(_BatchFeatureTypeInferrer, self).__init__(
+        column_names=column_names, skip_blank_lines=skip_blank_lines)
+    self._delimiter = delimiter
+
+  def add_input(
+      self,
+      accumulator,
+      input_lines
+  ):
+    """Updates the feature types in the accumulator using a batch of records.
+
+    Args:
+      accumulator: A dict containing the already inferred feature types.
+      input_lines: A list of CSV records.
+
+    Returns:
+      A dict containing the updated feature types based on input records.
+
+    Raises:
+      ValueError: If the columns do not match the specified csv headers.
+    """
+    try:
+      column_types = pywrap_tensorflow_data_validation.InferCSVColumnTypes(
+          input_lines, _to_utf8_string(self._delimiter),
+          self._skip_blank_lines, len(self._column_names))
+    except ValueError:
+      parser = CSVParser(delimiter=self._delimiter)
+      for line in input_lines:
+        accumulator = super(_BatchFeatureTypeInferrer, self).add_input(
+            accumulator, parser.parse(line))
+      return accumulator
+    for feature_name, current_type in zip(self._column_names, column_types):
+      previous_type = accumulator.get(feature_name, None)
+      if previous_type is None or current_type > previous_type:
+        accumulator[feature_name] = current_type
+    return accumulator
@@ -403,6 +403,118 @@ class CSVDecoderTest(absltest.TestCase):
             result,
             test_util.make_example_dict_equal_fn(self, None))
 
+  def _assert_batches_equal(self, expected_batches):
+    """Returns a matcher of the batches output by DecodeCSVBatches."""
+
+    def _matcher(actual_batches):
+      self.assertEqual(len(actual_batches), len(expected_batches))
+      for actual, expected in zip(actual_batches, expected_batches):
+        self.assertEqual(sorted(actual.keys()), sorted(expected.keys()))
+        for key in actual:
+          self.assertEqual(len(actual[key]), len(expected[key]))
+          for actual_values, expected_values in zip(actual[key],
+                                                    expected[key]):
+            if expected_values is None:
+              self.assertIsNone(actual_values)
+            else:
+              self.assertEqual(actual_values.dtype, expected_values.dtype)
+              np.testing.assert_equal(actual_values, expected_values)
+
+    return _matcher
+
+  def test_csv_batch_decoder(self):
+    input_lines = ['1,2.0,hello,',
+                   '',
+                   ' -5 ,,"a ""quoted"", string",',
+                   '7,inf,world,']
+    column_names = ['int_feature', 'float_feature', 'str_feature',
+                    'empty_feature']
+    expected_batch = {
+        'int_feature': [np.array([1], dtype=np.integer),
+                        np.array([-5], dtype=np.integer),
+                        np.array([7], dtype=np.integer)],
+        'float_feature': [np.array([2.0], dtype=np.floating), None,
+                          np.array([np.inf], dtype=np.floating)],
+        'str_feature': [np.array([b'hello'], dtype=np.object),
+                        np.array([b'a "quoted", string'], dtype=np.object),
+                        np.array([b'world'], dtype=np.object)],
+        'empty_feature': [None, None, None]}
+
+    with beam.Pipeline() as p:
+      result = (p | beam.Create(input_lines) |
+                csv_decoder.DecodeCSVBatches(
+                    column_names=column_names,
+                    desired_batch_size=len(input_lines)))
+      util.assert_that(result, self._assert_batches_equal([expected_batch]))
+
+  def test_csv_batch_decoder_with_schema(self):
+    input_lines = ['1,1,2.0,hello',
+                   '5,5,12.34,world']
+    column_names = ['int_feature_parsed_as_float', 'int_feature',
+                    'float_feature', 'str_feature']
+    schema = text_format.Parse(
+        """
+        feature { name: "int_feature_parsed_as_float" type: FLOAT }
+        feature { name: "int_feature" type: INT }
+        feature { name: "float_feature" type: FLOAT }
+        feature { name: "str_feature" type: BYTES }
+        """, schema_pb2.Schema())
+    expected_batch = {
+        'int_feature_parsed_as_float': [np.array([1], dtype=np.floating),
+                                        np.array([5], dtype=np.floating)],
+        'int_feature': [np.array([1], dtype=np.integer),
+                        np.array([5], dtype=np.integer)],
+        'float_feature': [np.array([2.0], dtype=np.floating),
+                          np.array([12.34], dtype=np.floating)],
+        'str_feature': [np.array([b'hello'], dtype=np.object),
+                        np.array([b'world'], dtype=np.object)]}
+
+    with beam.Pipeline() as p:
+      result = (p | beam.Create(input_lines) |
+                csv_decoder.DecodeCSVBatches(
+                    column_names=column_names, schema=schema,
+                    infer_type_from_schema=True,
+                    desired_batch_size=len(input_lines)))
+      util.assert_that(result, self._assert_batches_equal([expected_batch]))
+
+  def test_csv_batch_decoder_consider_blank_line(self):
+    input_lines = ['',
+                   '1,2']
+    column_names = ['float_feature1', 'float_feature2']
+    expected_batch = {
+        'float_feature1': [None, np.array([1.0], dtype=np.floating)],
+        'float_feature2': [None, np.array([2.0], dtype=np.floating)]}
+
+    with beam.Pipeline() as p:
+      result = (p | beam.Create(input_lines) |
+                csv_decoder.DecodeCSVBatches(
+                    column_names=column_names, skip_blank_lines=False,
+                    desired_batch_size=len(input_lines)))
+      util.assert_that(result, self._assert_batches_equal([expected_batch]))
+
+  def test_csv_batch_decoder_skip_blank_lines(self):
+    input_lines = ['', '']
+    column_names = ['int_feature']
+
+    with beam.Pipeline() as p:
+      result = (p | beam.Create(input_lines) |
+                csv_decoder.DecodeCSVBatches(
+                    column_names=column_names,
+                    desired_batch_size=len(input_lines)))
+      util.assert_that(result, self._assert_batches_equal([]))
+
+  def test_csv_batch_decoder_invalid_row(self):
+    input_lines = ['1,2.0,hello',
+                   '5,12.34']
+    column_names = ['int_feature', 'float_feature', 'str_feature']
+
+    with self.assertRaisesRegexp(
+        ValueError, '.*Columns do not match specified csv headers.*'):
+      with beam.Pipeline() as p:
+        result = (p | beam.Create(input_lines) |
+                  csv_decoder.DecodeCSVBatches(column_names=column_names))
+        util.assert_that(result, self._assert_batches_equal([]))
+
 
 if __name__ == '__main__':
   absltest.main()
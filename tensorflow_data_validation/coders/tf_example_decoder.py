@@ -21,9 +21,12 @@ from __future__ import print_function
 
 import apache_beam as beam
 import numpy as np
+import six
 import tensorflow as tf
 from tensorflow_data_validation import types
-from tensorflow_data_validation.types_compat import Optional
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
+from tensorflow_data_validation.utils import batch_util
+from tensorflow_data_validation.types_compat import List, Optional
 
 
 def _convert_to_example_dict_value(feature
@@ -58,6 +61,38 @@ class TFExampleDecoder(object):
         for feature_name in feature_map
     }
 
+  def decode_batch(self, serialized_example_protos
+                  ):
+    """Decodes serialized tf.Examples to a tf data validation input batch.
+
+    The result is the batch_util.merge_single_batch() of the decoded examples,
+    but the examples are decoded natively into a single buffer of values per
+    feature, of which the values of each example are a view.
+
+    Args:
+      serialized_example_protos: A list of serialized tf.Examples.
+
+    Returns:
+      A dict from feature name to a numpy array holding, for each example,
+      the numpy array of values of the feature or None.
+    """
+    try:
+      columns = pywrap_tensorflow_data_validation.DecodeExampleBatch(
+          serialized_example_protos)
+    except ValueError:
+      # The native decoder handles neither features that have values of
+      # different kinds in the batch nor malformed examples, which are
+      # decoded (or reported) one at a time.
+      return batch_util.merge_single_batch(
+          [self.decode(example) for example in serialized_example_protos])
+    num_examples = len(serialized_example_protos)
+    return {
+        feature_name: batch_util.decoded_column_to_batch_value(
+            kind, values, row_offsets, has_values, num_examples)
+        for feature_name, (kind, values, row_offsets, has_values)
+        in six.iteritems(columns)
+    }
+
 
 @beam.typehints.with_input_types(bytes)
 @beam.typehints.with_output_types(types.Example)
@@ -78,3 +113,55 @@ class DecodeTFExample(beam.PTransform):
       A PCollection of dicts representing the TF examples.
     """
     return examples | 'ParseTFExamples' >> beam.Map(self._decoder.decode)
+
+
+@beam.typehints.with_input_types(bytes)
+@beam.typehints.with_output_types(types.ExampleBatch)
+class DecodeTFExampleBatches(beam.PTransform):
+  """Decodes TF examples into batches in the format of
+  batch_util.BatchExamples, for GenerateStatisticsFromBatches."""
+
+  def __init__(self, desired_batch_size = None,
+               desired_batch_bytes = None):
+    """Initializes DecodeTFExampleBatches ptransform.
+
+    Args:
+      desired_batch_size: Optional batch size for batching examples when
+        computing data statistics.
+      desired_batch_bytes: Optional budget of bytes of the serialized examples
+        of a batch (see batch_util.BatchElementsByBytes). If specified, the
+        number of examples of a batch adapts to the time that decoding it
+        takes, up to desired_batch_size if it is specified.
+    """
+    self._decoder = TFExampleDecoder()
+    self._desired_batch_size = desired_batch_size
+    self._desired_batch_bytes = desired_batch_bytes
+
+  def expand(self, examples):
+    """Decodes batches of serialized TF examples.
+
+    Args:
+      examples: A PCollection of strings representing serialized TF examples.
+
+    Returns:
+      A PCollection of dicts representing batches of TF examples.
+    """
+    if self._desired_batch_bytes:
+      batch_args = {}
+      if self._desired_batch_size:
+        batch_args = dict(max_batch_size=self._desired_batch_size)
+      return (examples
+              | 'BatchAndParseTFExamplesByBytes' >>
+              batch_util.BatchElementsByBytes(
+                  len, self._desired_batch_bytes,
+                  batch_fn=self._decoder.decode_batch, **batch_args))
+    batch_args = {}
+    if self._desired_batch_size:
+      batch_args = dict(
+          min_batch_size=self._desired_batch_size,
+          max_batch_size=self._desired_batch_size)
+    batches = (examples
+               | 'BatchSerializedTFExamples' >>
+               beam.BatchElements(**batch_args))
+    return batches | 'ParseTFExampleBatches' >> beam.Map(
+        self._decoder.decode_batch)
@@ -23,6 +23,7 @@ from apache_beam.testing import util
 import numpy as np
 import tensorflow as tf
 from tensorflow_data_validation.coders import tf_example_decoder
+from tensorflow_data_validation.utils import batch_util
 from tensorflow_data_validation.utils import test_util
 
 from google.protobuf import text_format
@@ -143,6 +144,101 @@ class TFExampleDecoderTest(parameterized.TestCase):
     self._check_decoding_results(
         decoder.decode(example.SerializeToString()), decoded_example)
 
+  @parameterized.named_parameters(*TF_EXAMPLE_DECODER_TESTS)
+  def test_decode_batch_of_single_example(self, example_proto_text,
+                                          decoded_example):
+    example = tf.train.Example()
+    text_format.Merge(example_proto_text, example)
+    decoder = tf_example_decoder.TFExampleDecoder()
+    batch = decoder.decode_batch([example.SerializeToString()])
+    self._check_decoding_results(
+        {key: values[0] for key, values in batch.items()}, decoded_example)
+
+  def _check_batch_decoding_results(self, actual, expected):
+    self.assertEqual(sorted(actual.keys()), sorted(expected.keys()))
+    for key in actual:
+      self.assertEqual(len(actual[key]), len(expected[key]))
+      for actual_values, expected_values in zip(actual[key], expected[key]):
+        if expected_values is None:
+          self.assertIsNone(actual_values)
+        else:
+          self.assertEqual(actual_values.dtype, expected_values.dtype)
+          np.testing.assert_equal(actual_values, expected_values)
+
+  def test_decode_batch(self):
+    example_proto_texts = [
+        """
+        features {
+          feature { key: "int_feature"
+                    value { int64_list { value: [ 1, 2, 3 ] } } }
+          feature { key: "str_feature"
+                    value { bytes_list { value: [ 'a', 'b' ] } } }
+        }
+        """,
+        """
+        features {
+          feature { key: "float_feature"
+                    value { float_list { value: [ 4.0, 5.0 ] } } }
+          feature { key: "str_feature"
+                    value { } }
+        }
+        """,
+        """
+        features {
+          feature { key: "int_feature"
+                    value { int64_list { } } }
+          feature { key: "str_feature"
+                    value { bytes_list { value: [ 'c' ] } } }
+        }
+        """
+    ]
+    serialized_examples = []
+    for example_proto_text in example_proto_texts:
+      example = tf.train.Example()
+      text_format.Merge(example_proto_text, example)
+      serialized_examples.append(example.SerializeToString())
+    decoder = tf_example_decoder.TFExampleDecoder()
+    expected = {
+        'int_feature': [np.array([1, 2, 3], dtype=np.integer), None,
+                        np.array([], dtype=np.integer)],
+        'float_feature': [None, np.array([4.0, 5.0], dtype=np.floating),
+                          None],
+        'str_feature': [np.array([b'a', b'b'], dtype=np.object), None,
+                        np.array([b'c'], dtype=np.object)],
+    }
+    self._check_batch_decoding_results(
+        decoder.decode_batch(serialized_examples), expected)
+    self._check_batch_decoding_results(
+        decoder.decode_batch(serialized_examples),
+        batch_util.merge_single_batch(
+            [decoder.decode(example) for example in serialized_examples]))
+
+  def test_decode_batch_with_different_kinds(self):
+    # The native decoder does not support a feature with values of different
+    # kinds, so the batch is then decoded one example at a time.
+    example1 = tf.train.Example()
+    text_format.Merge("""
+        features {
+          feature { key: "x" value { int64_list { value: [ 1 ] } } }
+        }
+        """, example1)
+    example2 = tf.train.Example()
+    text_format.Merge("""
+        features {
+          feature { key: "x" value { float_list { value: [ 2.0 ] } } }
+        }
+        """, example2)
+    decoder = tf_example_decoder.TFExampleDecoder()
+    self._check_batch_decoding_results(
+        decoder.decode_batch([example1.SerializeToString(),
+                              example2.SerializeToString()]),
+        {'x': [np.array([1], dtype=np.integer),
+               np.array([2.0], dtype=np.floating)]})
+
+  def test_decode_empty_batch(self):
+    self.assertEqual(tf_example_decoder.TFExampleDecoder().decode_batch([]),
+                     {})
+
   def test_decode_example_with_beam_pipeline(self):
     example_proto_text = """
     features {
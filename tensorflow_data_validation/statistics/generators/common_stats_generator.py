@@ -34,6 +34,7 @@ import apache_beam as beam
 import numpy as np
 import six
 from tensorflow_data_validation import types
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
 from tensorflow_data_validation.statistics.generators import stats_generator
 from tensorflow_data_validation.utils import quantiles_util
 from tensorflow_data_validation.utils import schema_util
@@ -124,6 +125,23 @@ def _update_common_stats(common_stats,
                     (feature_name, type(value).__name__))
 
 
+def _make_partial_common_stats(batch_stats,
+                               has_weights):
+  """Make partial common statistics from the native statistics of a batch."""
+  result = _PartialCommonStats(has_weights)
+  result.num_non_missing = batch_stats['num_non_missing']
+  result.num_missing = batch_stats['num_missing']
+  result.min_num_values = batch_stats['min_num_values']
+  result.max_num_values = batch_stats['max_num_values']
+  result.total_num_values = batch_stats['total_num_values']
+  result.type = batch_stats['type']
+  if has_weights:
+    result.weighted_num_non_missing = batch_stats['weighted_num_non_missing']
+    result.weighted_num_missing = batch_stats['weighted_num_missing']
+    result.weighted_total_num_values = batch_stats['weighted_total_num_values']
+  return result
+
+
 def _merge_common_stats(left, right,
                         feature_name, has_weights
                        ):
@@ -163,6 +181,32 @@ def _merge_common_stats(left, right,
   return result
 
 
+def _scale_sampled_common_stats(common_stats,
+                                sample_rate,
+                                has_weights):
+  """Scales the counts of partial common stats computed over a sample to
+  estimate those over all the examples."""
+  result = _PartialCommonStats(has_weights)
+  result.num_non_missing = stats_util.scale_sampled_count(
+      common_stats.num_non_missing, sample_rate)
+  result.num_missing = stats_util.scale_sampled_count(
+      common_stats.num_missing, sample_rate)
+  result.min_num_values = common_stats.min_num_values
+  result.max_num_values = common_stats.max_num_values
+  result.total_num_values = stats_util.scale_sampled_count(
+      common_stats.total_num_values, sample_rate)
+  result.type = common_stats.type
+  result.num_values_summary = common_stats.num_values_summary
+  if has_weights:
+    result.weighted_num_non_missing = (
+        common_stats.weighted_num_non_missing / sample_rate)
+    result.weighted_num_missing = (
+        common_stats.weighted_num_missing / sample_rate)
+    result.weighted_total_num_values = (
+        common_stats.weighted_total_num_values / sample_rate)
+  return result
+
+
 def _make_feature_stats_proto(
     common_stats, feature_name,
     q_combiner,
@@ -325,7 +369,8 @@ class CommonStatsGenerator(stats_generator.CombinerStatsGenerator):
       schema = None,
       weight_feature = None,
       num_values_histogram_buckets = 10,
-      epsilon = 0.01):
+      epsilon = 0.01,
+      sample_rate = None):
     """Initializes a common statistics generator.
 
     Args:
@@ -341,12 +386,19 @@ class CommonStatsGenerator(stats_generator.CombinerStatsGenerator):
           of epsilon increase the quantile approximation, and hence result in
           more unequal buckets, but could improve performance, and resource
           consumption.
+      sample_rate: An optional rate at which each example was sampled before
+          the generator. If it is below 1, the counts are scaled to estimate
+          those over all the examples, and the sample rate and the confidence
+          interval of num_non_missing are added to the custom_stats of each
+          feature.
     """
     super(CommonStatsGenerator, self).__init__(name, schema)
     self._categorical_features = set(
         schema_util.get_categorical_numeric_features(schema) if schema else [])
     self._weight_feature = weight_feature
     self._num_values_histogram_buckets = num_values_histogram_buckets
+    self._sample_rate = (
+        sample_rate if sample_rate is not None and sample_rate < 1 else None)
     # Initialize quantiles combiner.
     self._quantiles_combiner = quantiles_util.QuantilesCombiner(
         self._num_values_histogram_buckets, epsilon)
@@ -362,8 +414,11 @@ class CommonStatsGenerator(stats_generator.CombinerStatsGenerator):
   def add_input(self, accumulator,
                 input_batch
                ):
+    has_weights = self._weight_feature is not None
+    weights_array = None
     if self._weight_feature:
       weights = stats_util.get_weight_feature(input_batch, self._weight_feature)
+      weights_array = stats_util.get_weights_array(weights)
 
     # Iterate through each feature and update the partial common stats.
     for feature_name, values in six.iteritems(input_batch):
@@ -379,19 +434,30 @@ class CommonStatsGenerator(stats_generator.CombinerStatsGenerator):
             self._quantiles_combiner.create_accumulator())
         accumulator[feature_name] = partial_stats
 
-      # Update the common statistics for every example in the batch.
-      num_values = []
-
-      for i, value in enumerate(values):
-        _update_common_stats(accumulator[feature_name], value, feature_name,
-                             weights[i][0] if self._weight_feature else None)
-        # Keep track of the number of values in non-missing examples.
-        if isinstance(value, np.ndarray):
-          num_values.append(value.size)
+      # Update the common statistics for every example in the batch, in a
+      # native loop if the values can be read natively.
+      batch_stats = pywrap_tensorflow_data_validation.GetCommonStatsOfBatch(
+          values, weights_array)
+      if batch_stats is not None:
+        num_values_summary = accumulator[feature_name].num_values_summary
+        accumulator[feature_name] = _merge_common_stats(
+            accumulator[feature_name],
+            _make_partial_common_stats(batch_stats, has_weights),
+            feature_name, has_weights)
+        accumulator[feature_name].num_values_summary = num_values_summary
+        num_values = np.frombuffer(batch_stats['num_values'], dtype=np.int64)
+      else:
+        num_values = []
+        for i, value in enumerate(values):
+          _update_common_stats(accumulator[feature_name], value, feature_name,
+                               weights[i][0] if self._weight_feature else None)
+          # Keep track of the number of values in non-missing examples.
+          if isinstance(value, np.ndarray):
+            num_values.append(value.size)
 
       # Update the num_vals_histogram summary for the feature based on the
       # current batch.
-      if num_values:
+      if len(num_values) > 0:
         accumulator[feature_name].num_values_summary = (
             self._quantiles_combiner.add_input(
                 accumulator[feature_name].num_values_summary, [num_values]))
@@ -436,14 +502,21 @@ class CommonStatsGenerator(stats_generator.CombinerStatsGenerator):
     # Create a new DatasetFeatureStatistics proto.
     result = statistics_pb2.DatasetFeatureStatistics()
 
+    has_weights = self._weight_feature is not None
     for feature_name, common_stats in accumulator.items():
+      sampled_num_non_missing = common_stats.num_non_missing
+      if self._sample_rate is not None:
+        common_stats = _scale_sampled_common_stats(
+            common_stats, self._sample_rate, has_weights)
       # Construct the FeatureNameStatistics proto from the partial
       # common stats.
       feature_stats_proto = _make_feature_stats_proto(
           common_stats, feature_name, self._quantiles_combiner,
           self._num_values_histogram_buckets,
-          feature_name in self._categorical_features,
-          self._weight_feature is not None)
+          feature_name in self._categorical_features, has_weights)
+      if self._sample_rate is not None:
+        stats_util.add_sampling_custom_stats(
+            feature_stats_proto, sampled_num_non_missing, self._sample_rate)
       # Copy the constructed FeatureNameStatistics proto into the
       # DatasetFeatureStatistics proto.
       new_feature_stats_proto = result.features.add()
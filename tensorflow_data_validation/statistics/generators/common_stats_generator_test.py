@@ -80,6 +80,66 @@ class CommonStatsGeneratorTest(test_util.CombinerStatsGeneratorTest):
         num_values_histogram_buckets=4)
     self.assertCombinerOutputEqual(batches, generator, expected_result)
 
+  def test_common_stats_generator_with_sample_rate(self):
+    # input with a single batch of four examples, sampled at a rate of 0.5.
+    batches = [{'a': np.array([np.array([1.0, 2.0]),
+                               np.array([3.0, 4.0, 5.0]),
+                               np.array([1.0]), None])}]
+    expected_result = {
+        'a': text_format.Parse(
+            """
+            name: 'a'
+            type: FLOAT
+            num_stats {
+              common_stats {
+                num_non_missing: 6
+                num_missing: 2
+                min_num_values: 1
+                max_num_values: 3
+                avg_num_values: 2.0
+                tot_num_values: 12
+                num_values_histogram {
+                  buckets {
+                    low_value: 1.0
+                    high_value: 1.0
+                    sample_count: 1.5
+                  }
+                  buckets {
+                    low_value: 1.0
+                    high_value: 2.0
+                    sample_count: 1.5
+                  }
+                  buckets {
+                    low_value: 2.0
+                    high_value: 3.0
+                    sample_count: 1.5
+                  }
+                  buckets {
+                    low_value: 3.0
+                    high_value: 3.0
+                    sample_count: 1.5
+                  }
+                  type: QUANTILES
+                }
+              }
+            }
+            custom_stats {
+              name: 'sample_rate'
+              num: 0.5
+            }
+            custom_stats {
+              name: 'num_non_missing_lower_bound'
+              num: 3.0
+            }
+            custom_stats {
+              name: 'num_non_missing_upper_bound'
+              num: 10.8009999
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    generator = common_stats_generator.CommonStatsGenerator(
+        num_values_histogram_buckets=4, sample_rate=0.5)
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
   def test_common_stats_generator_with_weight_feature(self):
     # input with two batches: first batch has two examples and second batch
     # has a single example.
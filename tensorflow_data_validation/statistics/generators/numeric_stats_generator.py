@@ -34,6 +34,7 @@ import sys
 import numpy as np
 import six
 from tensorflow_data_validation import types
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
 from tensorflow_data_validation.statistics.generators import stats_generator
 from tensorflow_data_validation.utils import quantiles_util
 from tensorflow_data_validation.utils import schema_util
@@ -124,6 +125,25 @@ def _update_numeric_stats(
     numeric_stats.type = feature_type
 
 
+def _make_partial_numeric_stats(
+    batch_stats, has_weights):
+  """Make partial numeric statistics from the native statistics of a batch."""
+  result = _PartialNumericStats(has_weights)
+  result.sum = batch_stats['sum']
+  result.sum_of_squares = batch_stats['sum_of_squares']
+  result.num_zeros = batch_stats['num_zeros']
+  result.num_nan = batch_stats['num_nan']
+  result.min = batch_stats['min']
+  result.max = batch_stats['max']
+  result.total_num_values = batch_stats['total_num_values']
+  result.type = batch_stats['type']
+  if has_weights:
+    result.weighted_sum = batch_stats['weighted_sum']
+    result.weighted_sum_of_squares = batch_stats['weighted_sum_of_squares']
+    result.weighted_total_num_values = batch_stats['weighted_total_num_values']
+  return result
+
+
 def _merge_numeric_stats(
     left, right,
     feature_name, has_weights
@@ -157,6 +177,51 @@ def _merge_numeric_stats(
   return result
 
 
+def _scale_sampled_numeric_stats(
+    numeric_stats, sample_rate,
+    has_weights):
+  """Scales the counts and sums of partial numeric stats computed over a sample
+  to estimate those over all the examples."""
+  result = _PartialNumericStats(has_weights)
+  result.sum = numeric_stats.sum / sample_rate
+  result.sum_of_squares = numeric_stats.sum_of_squares / sample_rate
+  result.num_zeros = stats_util.scale_sampled_count(numeric_stats.num_zeros,
+                                                    sample_rate)
+  result.num_nan = stats_util.scale_sampled_count(numeric_stats.num_nan,
+                                                  sample_rate)
+  result.min = numeric_stats.min
+  result.max = numeric_stats.max
+  result.total_num_values = stats_util.scale_sampled_count(
+      numeric_stats.total_num_values, sample_rate)
+  result.type = numeric_stats.type
+  result.quantiles_summary = numeric_stats.quantiles_summary
+  if has_weights:
+    result.weighted_sum = numeric_stats.weighted_sum / sample_rate
+    result.weighted_sum_of_squares = (
+        numeric_stats.weighted_sum_of_squares / sample_rate)
+    result.weighted_total_num_values = (
+        numeric_stats.weighted_total_num_values / sample_rate)
+    result.weighted_quantiles_summary = (
+        numeric_stats.weighted_quantiles_summary)
+  return result
+
+
+def _add_sampled_mean_bounds(
+    feature_stats_proto,
+    sampled_total_num_values):
+  """Adds the confidence interval of the mean of a feature, computed over a
+  sample with sampled_total_num_values values, to its custom_stats."""
+  num_stats = feature_stats_proto.num_stats
+  margin = (stats_util.SAMPLING_Z_SCORE * num_stats.std_dev /
+            math.sqrt(sampled_total_num_values))
+  feature_stats_proto.custom_stats.add(
+      name=stats_util.MEAN_LOWER_BOUND_CUSTOM_STAT,
+      num=num_stats.mean - margin)
+  feature_stats_proto.custom_stats.add(
+      name=stats_util.MEAN_UPPER_BOUND_CUSTOM_STAT,
+      num=num_stats.mean + margin)
+
+
 def _make_feature_stats_proto(
     numeric_stats, feature_name,
     quantiles_combiner,
@@ -278,7 +343,8 @@ class NumericStatsGenerator(stats_generator.CombinerStatsGenerator):
       weight_feature = None,
       num_histogram_buckets = 10,
       num_quantiles_histogram_buckets = 10,
-      epsilon = 0.01):
+      epsilon = 0.01,
+      sample_rate = None):
     """Initializes a numeric statistics generator.
 
     Args:
@@ -295,6 +361,10 @@ class NumericStatsGenerator(stats_generator.CombinerStatsGenerator):
           of epsilon increase the quantile approximation, and hence result in
           more unequal buckets, but could improve performance, and resource
           consumption.
+      sample_rate: An optional rate at which each example was sampled before
+          the generator. If it is below 1, the counts are scaled to estimate
+          those over all the examples, and the confidence interval of the mean
+          is added to the custom_stats of each feature.
     """
     super(NumericStatsGenerator, self).__init__(name)
     self._categorical_features = set(
@@ -302,6 +372,8 @@ class NumericStatsGenerator(stats_generator.CombinerStatsGenerator):
     self._weight_feature = weight_feature
     self._num_histogram_buckets = num_histogram_buckets
     self._num_quantiles_histogram_buckets = num_quantiles_histogram_buckets
+    self._sample_rate = (
+        sample_rate if sample_rate is not None and sample_rate < 1 else None)
     num_buckets = max(
         self._num_quantiles_histogram_buckets,
         _NUM_QUANTILES_FACTOR_FOR_STD_HISTOGRAM * self._num_histogram_buckets)
@@ -321,8 +393,11 @@ class NumericStatsGenerator(stats_generator.CombinerStatsGenerator):
                 accumulator,
                 input_batch
                ):
+    has_weights = self._weight_feature is not None
+    weights_array = None
     if self._weight_feature:
       weights = stats_util.get_weight_feature(input_batch, self._weight_feature)
+      weights_array = stats_util.get_weights_array(weights)
 
     # Iterate through each feature and update the partial numeric stats.
     for feature_name, values in six.iteritems(input_batch):
@@ -339,43 +414,68 @@ class NumericStatsGenerator(stats_generator.CombinerStatsGenerator):
       # that we store the values in the current batch so that we invoke the
       # quantiles combiner only once per feature for the input batch.
       current_batch = [[], []]  # stores values and weights
-      for i, value in enumerate(values):
-        # Check if we have a numpy array with at least one value.
-        if not isinstance(value, np.ndarray) or value.size == 0:
-          continue
-
-        # Check if the numpy array is of numeric type.
-        feature_type = get_feature_type(value.dtype)
-        if feature_type not in [
-            statistics_pb2.FeatureNameStatistics.INT,
-            statistics_pb2.FeatureNameStatistics.FLOAT
-        ]:
-          continue
-
-        # If we encounter this feature for the first time, create a
-        # new partial numeric stats.
+      # Use a native loop if the values can be read natively.
+      batch_stats = pywrap_tensorflow_data_validation.GetNumericStatsOfBatch(
+          values, weights_array)
+      if batch_stats is None:
+        for i, value in enumerate(values):
+          # Check if we have a numpy array with at least one value.
+          if not isinstance(value, np.ndarray) or value.size == 0:
+            continue
+
+          # Check if the numpy array is of numeric type.
+          feature_type = get_feature_type(value.dtype)
+          if feature_type not in [
+              statistics_pb2.FeatureNameStatistics.INT,
+              statistics_pb2.FeatureNameStatistics.FLOAT
+          ]:
+            continue
+
+          # If we encounter this feature for the first time, create a
+          # new partial numeric stats.
+          if feature_name not in accumulator:
+            partial_stats = _PartialNumericStats(has_weights)
+            # Store empty summary.
+            partial_stats.quantiles_summary = (
+                self._quantiles_combiner.create_accumulator())
+            accumulator[feature_name] = partial_stats
+
+          # Update the partial numeric stats and append values
+          # to the current batch.
+          _update_numeric_stats(
+              accumulator[feature_name], value, feature_name, feature_type,
+              current_batch, weights[i][0] if self._weight_feature else None)
+      elif batch_stats['type'] is not None:
+        # We have at least one numeric value for the feature.
         if feature_name not in accumulator:
-          partial_stats = _PartialNumericStats(self._weight_feature is not None)
-          # Store empty summary.
+          partial_stats = _PartialNumericStats(has_weights)
           partial_stats.quantiles_summary = (
               self._quantiles_combiner.create_accumulator())
           accumulator[feature_name] = partial_stats
-
-        # Update the partial numeric stats and append values
-        # to the current batch.
-        _update_numeric_stats(
-            accumulator[feature_name], value, feature_name, feature_type,
-            current_batch, weights[i][0] if self._weight_feature else None)
+        current_stats = accumulator[feature_name]
+        accumulator[feature_name] = _merge_numeric_stats(
+            current_stats,
+            _make_partial_numeric_stats(batch_stats, has_weights),
+            feature_name, has_weights)
+        accumulator[feature_name].quantiles_summary = (
+            current_stats.quantiles_summary)
+        if has_weights:
+          accumulator[feature_name].weighted_quantiles_summary = (
+              current_stats.weighted_quantiles_summary)
+        current_batch = [
+            np.frombuffer(batch_stats['values'], dtype=np.float64),
+            np.frombuffer(batch_stats['weights'], dtype=np.float64)
+        ]
 
       # Update the quantiles summary of the feature based on the current batch.
-      if current_batch[0]:
-        # For the unweighted case, explicitly set the weights to be 1. We do
-        # this so that we can use the same weighted quantiles combiner for both
-        # scenarios.
+      if len(current_batch[0]) > 0:
+        # For the unweighted case, pass no weights, so that each value has
+        # weight 1. We do this so that we can use the same weighted quantiles
+        # combiner for both scenarios.
         accumulator[feature_name].quantiles_summary = (
             self._quantiles_combiner.add_input(
                 accumulator[feature_name].quantiles_summary,
-                [current_batch[0], [1] * len(current_batch[0])]))
+                [current_batch[0]]))
 
         if self._weight_feature:
           accumulator[feature_name].weighted_quantiles_summary = (
@@ -436,14 +536,20 @@ class NumericStatsGenerator(stats_generator.CombinerStatsGenerator):
     # Create a new DatasetFeatureStatistics proto.
     result = statistics_pb2.DatasetFeatureStatistics()
 
+    has_weights = self._weight_feature is not None
     for feature_name, numeric_stats in accumulator.items():
+      sampled_total_num_values = numeric_stats.total_num_values
+      if self._sample_rate is not None:
+        numeric_stats = _scale_sampled_numeric_stats(
+            numeric_stats, self._sample_rate, has_weights)
       # Construct the FeatureNameStatistics proto from the partial
       # numeric stats.
       feature_stats_proto = _make_feature_stats_proto(
           numeric_stats, feature_name, self._quantiles_combiner,
           self._num_histogram_buckets,
-          self._num_quantiles_histogram_buckets,
-          self._weight_feature is not None)
+          self._num_quantiles_histogram_buckets, has_weights)
+      if self._sample_rate is not None and sampled_total_num_values > 0:
+        _add_sampled_mean_bounds(feature_stats_proto, sampled_total_num_values)
       # Copy the constructed FeatureNameStatistics proto into the
       # DatasetFeatureStatistics proto.
       new_feature_stats_proto = result.features.add()
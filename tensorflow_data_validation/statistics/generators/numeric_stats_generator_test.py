@@ -95,6 +95,79 @@ class NumericStatsGeneratorTest(test_util.CombinerStatsGeneratorTest):
         num_histogram_buckets=3, num_quantiles_histogram_buckets=4)
     self.assertCombinerOutputEqual(batches, generator, expected_result)
 
+  def test_numeric_stats_generator_with_sample_rate(self):
+    # input with two batches, sampled at a rate of 0.5.
+    batches = [{'a': np.array([np.array([1.0, 2.0]),
+                               np.array([3.0, 4.0, 5.0])])},
+               {'a': np.array([np.array([1.0])])}]
+    expected_result = {
+        'a': text_format.Parse(
+            """
+            name: 'a'
+            type: FLOAT
+            num_stats {
+              mean: 2.66666666
+              std_dev: 1.49071198
+              num_zeros: 0
+              min: 1.0
+              max: 5.0
+              median: 3.0
+              histograms {
+                buckets {
+                  low_value: 1.0
+                  high_value: 2.3333333
+                  sample_count: 5.9733333
+                }
+                buckets {
+                  low_value: 2.3333333
+                  high_value: 3.6666667
+                  sample_count: 2.0133333
+                }
+                buckets {
+                  low_value: 3.6666667
+                  high_value: 5.0
+                  sample_count: 4.0133333
+                }
+                type: STANDARD
+              }
+              histograms {
+                buckets {
+                  low_value: 1.0
+                  high_value: 1.0
+                  sample_count: 3.0
+                }
+                buckets {
+                  low_value: 1.0
+                  high_value: 3.0
+                  sample_count: 3.0
+                }
+                buckets {
+                  low_value: 3.0
+                  high_value: 4.0
+                  sample_count: 3.0
+                }
+                buckets {
+                  low_value: 4.0
+                  high_value: 5.0
+                  sample_count: 3.0
+                }
+                type: QUANTILES
+              }
+            }
+            custom_stats {
+              name: 'mean_lower_bound'
+              num: 1.47384865
+            }
+            custom_stats {
+              name: 'mean_upper_bound'
+              num: 3.85948468
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    generator = numeric_stats_generator.NumericStatsGenerator(
+        num_histogram_buckets=3, num_quantiles_histogram_buckets=4,
+        sample_rate=0.5)
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
   def test_numeric_stats_generator_with_entire_feature_value_list_missing(self):
     # input with two batches: first batch has three examples and second batch
     # has two examples.
@@ -26,6 +26,7 @@ from __future__ import print_function
 import numpy as np
 import six
 from tensorflow_data_validation import types
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
 from tensorflow_data_validation.statistics.generators import stats_generator
 from tensorflow_data_validation.utils import schema_util
 from tensorflow_data_validation.utils.stats_util import get_feature_type
@@ -104,6 +105,20 @@ class StringStatsGenerator(stats_generator.CombinerStatsGenerator):
     for feature_name, values in six.iteritems(input_batch):
       is_categorical_feature = feature_name in self._categorical_features
 
+      # Use a native loop if the values can be read natively.
+      batch_stats = pywrap_tensorflow_data_validation.GetStringStatsOfBatch(
+          values, is_categorical_feature)
+      if batch_stats is not None:
+        # We have at least one string value for the feature.
+        if batch_stats['total_num_values'] > 0:
+          partial_stats = _PartialStringStats()
+          partial_stats.total_bytes_length = batch_stats['total_bytes_length']
+          partial_stats.total_num_values = batch_stats['total_num_values']
+          accumulator[feature_name] = (
+              _merge_string_stats(accumulator[feature_name], partial_stats)
+              if feature_name in accumulator else partial_stats)
+        continue
+
       # Update the string statistics for every example in the batch.
       for value in values:
         # Check if we have a numpy array with at least one value.
@@ -158,6 +158,24 @@ class StringStatsGeneratorTest(test_util.CombinerStatsGeneratorTest):
     generator = string_stats_generator.StringStatsGenerator()
     self.assertCombinerOutputEqual(batches, generator, expected_result)
 
+  def test_string_stats_generator_fixed_width_bytes_feature(self):
+    # Values of a fixed-width bytes array are padded with NULs, which are not
+    # part of their length.
+    batches = [{'a': np.array([np.array([b'xyz', b'q'], dtype=np.bytes_),
+                               np.array([b'ab'], dtype='S5')],
+                              dtype=np.object)}]
+    expected_result = {
+        'a': text_format.Parse(
+            """
+            name: 'a'
+            type: STRING
+            string_stats {
+              avg_length: 2.0
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    generator = string_stats_generator.StringStatsGenerator()
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
   def test_string_stats_generator_categorical_feature(self):
     # input with two batches: first batch has two examples and second batch
     # has a single example.
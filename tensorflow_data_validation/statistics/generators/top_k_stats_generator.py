@@ -24,6 +24,7 @@ import apache_beam as beam
 import numpy as np
 import six
 from tensorflow_data_validation import types
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
 from tensorflow_data_validation.statistics.generators import stats_generator
 from tensorflow_data_validation.utils import schema_util
 from tensorflow_data_validation.utils import stats_util
@@ -320,3 +321,183 @@ class TopKStatsGenerator(stats_generator.TransformStatsGenerator):
             num_top_values=num_top_values,
             num_rank_histogram_buckets=num_rank_histogram_buckets)
     )
+
+
+
+class _TopKSketch(object):
+  """A picklable handle of a native top-k sketch (see anomalies/top_k_sketch.h).
+
+  The sketch is pickled in its serialized form.
+  """
+
+  __slots__ = ['handle']
+
+  def __init__(self, handle):
+    self.handle = handle
+
+  def __reduce__(self):
+    return _deserialize_top_k_sketch, (
+        pywrap_tensorflow_data_validation.SerializeTopKSketch(self.handle),)
+
+
+def _deserialize_top_k_sketch(serialized_sketch):
+  return _TopKSketch(
+      pywrap_tensorflow_data_validation.DeserializeTopKSketch(
+          serialized_sketch))
+
+
+class _PartialTopKStats(object):
+  """Holds the top-k sketches of a single feature."""
+
+  __slots__ = ['sketch', 'weighted_sketch']
+
+  def __init__(self, sketch,
+               weighted_sketch):
+    # The sketch of the values.
+    self.sketch = sketch
+    # The sketch of the values weighted by the weight feature. None if there
+    # is no weight feature.
+    self.weighted_sketch = weighted_sketch
+
+
+class ApproximateTopKStatsGenerator(stats_generator.CombinerStatsGenerator):
+  """A combiner statistics generator that approximates the top-k most frequent
+  feature values for string features.
+
+  Unlike TopKStatsGenerator, it does not shuffle the values: each feature is
+  counted by a fixed-size SpaceSaving sketch that keeps num_sketch_counters
+  values. The count of a value overestimates its frequency by at most the
+  error of its counter; the largest error of the reported values is output as
+  the custom statistic 'approximate_top_values_max_error' (and
+  'approximate_weighted_top_values_max_error' for the weighted counts). The
+  counts are exact while a feature has at most num_sketch_counters distinct
+  values.
+  """
+
+  def __init__(self,
+               name = 'ApproximateTopKStatsGenerator',
+               schema = None,
+               weight_feature = None,
+               num_top_values = 2,
+               num_rank_histogram_buckets = 1000,
+               num_sketch_counters = None):
+    """Initializes an approximate top-k stats generator.
+
+    Args:
+      name: An optional unique name associated with the statistics generator.
+      schema: An optional schema for the dataset.
+      weight_feature: An optional feature name whose numeric value
+          (must be of type INT or FLOAT) represents the weight of an example.
+      num_top_values: An optional number of most frequent feature values to keep
+          for string features (defaults to 2).
+      num_rank_histogram_buckets: An optional number of buckets in the rank
+          histogram for string features (defaults to 1000).
+      num_sketch_counters: An optional number of values counted by the sketch
+          of each feature (defaults to 10 times the number of values to
+          output). More counters reduce the error of the counts.
+    """
+    super(ApproximateTopKStatsGenerator, self).__init__(name, schema)
+    self._categorical_features = set(
+        schema_util.get_categorical_numeric_features(schema) if schema else [])
+    self._weight_feature = weight_feature
+    self._num_top_values = num_top_values
+    self._num_rank_histogram_buckets = num_rank_histogram_buckets
+    self._k = max(num_top_values, num_rank_histogram_buckets)
+    self._num_sketch_counters = (
+        num_sketch_counters if num_sketch_counters is not None
+        else 10 * self._k)
+    if self._num_sketch_counters < self._k:
+      raise ValueError(
+          'num_sketch_counters must be at least %d, got %d' %
+          (self._k, self._num_sketch_counters))
+
+  def _create_sketch(self):
+    return _TopKSketch(pywrap_tensorflow_data_validation.CreateTopKSketch(
+        self._num_sketch_counters))
+
+  # Create an accumulator, which maps feature name to the partial stats
+  # associated with the feature.
+  def create_accumulator(self):
+    return {}
+
+  # Incorporates the input (a Python dict whose keys are feature names and
+  # values are numpy arrays representing a batch of examples) into the
+  # accumulator.
+  def add_input(self, accumulator,
+                input_batch
+               ):
+    # Group the value lists (and weights) of the batch by feature, so that
+    # each sketch is updated by a single native call.
+    feature_values = collections.defaultdict(list)
+    feature_weights = collections.defaultdict(list)
+    for entry in _unbatch_input_to_feature_values_with_weights(
+        input_batch, self._categorical_features, self._weight_feature):
+      feature_values[entry.feature_name].append(entry.value_list)
+      feature_weights[entry.feature_name].append(entry.weight)
+
+    for feature_name, value_lists in six.iteritems(feature_values):
+      partial_stats = accumulator.get(feature_name)
+      if partial_stats is None:
+        partial_stats = _PartialTopKStats(
+            self._create_sketch(),
+            self._create_sketch() if self._weight_feature else None)
+        accumulator[feature_name] = partial_stats
+      pywrap_tensorflow_data_validation.AddToTopKSketch(
+          partial_stats.sketch.handle, value_lists, None)
+      if partial_stats.weighted_sketch is not None:
+        pywrap_tensorflow_data_validation.AddToTopKSketch(
+            partial_stats.weighted_sketch.handle, value_lists,
+            np.asarray(feature_weights[feature_name], dtype=np.float64))
+    return accumulator
+
+  # Merge together a list of accumulators.
+  def merge_accumulators(
+      self, accumulators
+  ):
+    result = {}
+    for accumulator in accumulators:
+      for feature_name, partial_stats in six.iteritems(accumulator):
+        if feature_name not in result:
+          result[feature_name] = partial_stats
+          continue
+        merged = result[feature_name]
+        pywrap_tensorflow_data_validation.MergeTopKSketches(
+            merged.sketch.handle, partial_stats.sketch.handle)
+        if merged.weighted_sketch is not None:
+          pywrap_tensorflow_data_validation.MergeTopKSketches(
+              merged.weighted_sketch.handle,
+              partial_stats.weighted_sketch.handle)
+    return result
+
+  def _make_feature_stats_proto(self, feature_name,
+                                sketch,
+                                is_weighted_stats
+                               ):
+    """Makes a FeatureNameStatistics proto from the top-k of a sketch."""
+    top_k = pywrap_tensorflow_data_validation.GetTopKOfSketch(
+        sketch.handle, self._k)
+    result = _make_feature_stats_proto(
+        feature_name, [(value, count) for value, count, _ in top_k],
+        feature_name in self._categorical_features, is_weighted_stats,
+        self._num_top_values, self._num_rank_histogram_buckets)
+    max_error = result.custom_stats.add()
+    max_error.name = ('approximate_weighted_top_values_max_error'
+                      if is_weighted_stats else
+                      'approximate_top_values_max_error')
+    max_error.num = max([error for _, _, error in top_k] or [0.0])
+    return result
+
+  # Return final stats as a DatasetFeatureStatistics proto.
+  def extract_output(self,
+                     accumulator
+                    ):
+    result = statistics_pb2.DatasetFeatureStatistics()
+    for feature_name, partial_stats in six.iteritems(accumulator):
+      feature_stats_proto = self._make_feature_stats_proto(
+          feature_name, partial_stats.sketch, is_weighted_stats=False)
+      if partial_stats.weighted_sketch is not None:
+        feature_stats_proto.MergeFrom(self._make_feature_stats_proto(
+            feature_name, partial_stats.weighted_sketch,
+            is_weighted_stats=True))
+      result.features.add().CopyFrom(feature_stats_proto)
+    return result
@@ -18,6 +18,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import pickle
+
 from absl.testing import absltest
 import numpy as np
 from tensorflow_data_validation.statistics.generators import top_k_stats_generator
@@ -574,5 +576,224 @@ class TopKStatsGeneratorTest(test_util.TransformStatsGeneratorTest):
     self.assertTransformOutputEqual(batches, generator, [expected_result_fa])
 
 
+
+class ApproximateTopKStatsGeneratorTest(test_util.CombinerStatsGeneratorTest):
+  """Tests for ApproximateTopKStatsGenerator."""
+
+  def test_approximate_topk_with_weights(self):
+    # non-weighted ordering
+    # 3 'a', 2 'e', 2 'd', 2 'c', 1 'b'
+    # weighted ordering
+    # fa: 20 'e', 20 'd', 15 'a', 10 'c', 5 'b'
+    batches = [{'fa': np.array([np.array(['a', 'b', 'c', 'e']),
+                                np.array(['a', 'c', 'd', 'a'])],
+                               dtype=np.object),
+                'w': np.array([np.array([5.0]), np.array([5.0])])},
+               {'fa': np.array([np.array(['d', 'e'])], dtype=np.object),
+                'w': np.array([np.array([15.0])])}]
+    expected_result = {
+        'fa': text_format.Parse(
+            """
+            name: 'fa'
+            type: STRING
+            string_stats {
+              top_values {
+                value: 'a'
+                frequency: 3.0
+              }
+              top_values {
+                value: 'e'
+                frequency: 2.0
+              }
+              rank_histogram {
+                buckets {
+                  low_rank: 0
+                  high_rank: 0
+                  label: "a"
+                  sample_count: 3.0
+                }
+                buckets {
+                  low_rank: 1
+                  high_rank: 1
+                  label: "e"
+                  sample_count: 2.0
+                }
+                buckets {
+                  low_rank: 2
+                  high_rank: 2
+                  label: "d"
+                  sample_count: 2.0
+                }
+              }
+              weighted_string_stats {
+                top_values {
+                  value: 'e'
+                  frequency: 20.0
+                }
+                top_values {
+                  value: 'd'
+                  frequency: 20.0
+                }
+                rank_histogram {
+                  buckets {
+                    low_rank: 0
+                    high_rank: 0
+                    label: "e"
+                    sample_count: 20.0
+                  }
+                  buckets {
+                    low_rank: 1
+                    high_rank: 1
+                    label: "d"
+                    sample_count: 20.0
+                  }
+                  buckets {
+                    low_rank: 2
+                    high_rank: 2
+                    label: "a"
+                    sample_count: 15.0
+                  }
+                }
+              }
+            }
+            custom_stats {
+              name: 'approximate_top_values_max_error'
+              num: 0.0
+            }
+            custom_stats {
+              name: 'approximate_weighted_top_values_max_error'
+              num: 0.0
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    generator = top_k_stats_generator.ApproximateTopKStatsGenerator(
+        weight_feature='w', num_top_values=2, num_rank_histogram_buckets=3)
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
+  def test_approximate_topk_with_few_counters(self):
+    # With 2 counters, 'c' replaces 'b' and inherits its count as error.
+    batches = [{'fa': np.array([np.array(['a', 'a', 'a', 'b', 'c'])],
+                               dtype=np.object)}]
+    expected_result = {
+        'fa': text_format.Parse(
+            """
+            name: 'fa'
+            type: STRING
+            string_stats {
+              top_values {
+                value: 'a'
+                frequency: 3.0
+              }
+              top_values {
+                value: 'c'
+                frequency: 2.0
+              }
+              rank_histogram {
+                buckets {
+                  low_rank: 0
+                  high_rank: 0
+                  label: "a"
+                  sample_count: 3.0
+                }
+                buckets {
+                  low_rank: 1
+                  high_rank: 1
+                  label: "c"
+                  sample_count: 2.0
+                }
+              }
+            }
+            custom_stats {
+              name: 'approximate_top_values_max_error'
+              num: 1.0
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    generator = top_k_stats_generator.ApproximateTopKStatsGenerator(
+        num_top_values=2, num_rank_histogram_buckets=2, num_sketch_counters=2)
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
+  def test_approximate_topk_with_pickled_accumulators(self):
+    batches = [{'fa': np.array([np.array(['a', 'b']), np.array(['a'])],
+                               dtype=np.object)},
+               {'fa': np.array([np.array(['b', 'a'])], dtype=np.object)}]
+    generator = top_k_stats_generator.ApproximateTopKStatsGenerator(
+        num_top_values=2, num_rank_histogram_buckets=0)
+    accumulators = [
+        pickle.loads(pickle.dumps(
+            generator.add_input(generator.create_accumulator(), batch)))
+        for batch in batches
+    ]
+    result = generator.extract_output(
+        generator.merge_accumulators(accumulators))
+    expected_result = text_format.Parse(
+        """
+        features {
+          name: 'fa'
+          type: STRING
+          string_stats {
+            top_values {
+              value: 'a'
+              frequency: 3.0
+            }
+            top_values {
+              value: 'b'
+              frequency: 2.0
+            }
+          }
+          custom_stats {
+            name: 'approximate_top_values_max_error'
+            num: 0.0
+          }
+        }""", statistics_pb2.DatasetFeatureStatistics())
+    self.assertEqual(result, expected_result)
+
+  def test_approximate_topk_with_categorical_feature(self):
+    batches = [{'fa': np.array([np.array([12, 23, 34, 12]),
+                                np.array([45, 23])])},
+               {'fa': np.array([np.array([12, 12, 34, 45])])}]
+    expected_result = {
+        'fa': text_format.Parse(
+            """
+            name: 'fa'
+            type: INT
+            string_stats {
+              top_values {
+                value: '12'
+                frequency: 4
+              }
+              rank_histogram {
+                buckets {
+                  low_rank: 0
+                  high_rank: 0
+                  label: "12"
+                  sample_count: 4.0
+                }
+              }
+            }
+            custom_stats {
+              name: 'approximate_top_values_max_error'
+              num: 0.0
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    schema = text_format.Parse(
+        """
+        feature {
+          name: "fa"
+          type: INT
+          int_domain {
+            is_categorical: true
+          }
+        }
+        """, schema_pb2.Schema())
+    generator = top_k_stats_generator.ApproximateTopKStatsGenerator(
+        schema=schema, num_top_values=1, num_rank_histogram_buckets=1)
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
+  def test_approximate_topk_with_too_few_counters(self):
+    with self.assertRaisesRegexp(ValueError, 'num_sketch_counters'):
+      top_k_stats_generator.ApproximateTopKStatsGenerator(
+          num_top_values=2, num_rank_histogram_buckets=3,
+          num_sketch_counters=2)
+
+
 if __name__ == '__main__':
   absltest.main()
@@ -23,6 +23,7 @@ import apache_beam as beam
 import numpy as np
 import six
 from tensorflow_data_validation import types
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
 from tensorflow_data_validation.statistics.generators import stats_generator
 from tensorflow_data_validation.utils import schema_util
 from tensorflow_data_validation.utils.stats_util import get_feature_type
@@ -134,3 +135,126 @@ class UniquesStatsGenerator(stats_generator.TransformStatsGenerator):
     """
     super(UniquesStatsGenerator, self).__init__(
         name, schema=schema, ptransform=_UniquesStatsGeneratorImpl(schema))
+
+
+
+class _UniquesSketch(object):
+  """A picklable handle of a native uniques sketch (see
+  anomalies/uniques_sketch.h).
+
+  The sketch is pickled in its serialized form.
+  """
+
+  __slots__ = ['handle']
+
+  def __init__(self, handle):
+    self.handle = handle
+
+  def __reduce__(self):
+    return _deserialize_uniques_sketch, (
+        pywrap_tensorflow_data_validation.SerializeUniquesSketch(self.handle),)
+
+
+def _deserialize_uniques_sketch(serialized_sketch):
+  return _UniquesSketch(
+      pywrap_tensorflow_data_validation.DeserializeUniquesSketch(
+          serialized_sketch))
+
+
+class ApproximateUniquesStatsGenerator(stats_generator.CombinerStatsGenerator):
+  """A combiner statistics generator that estimates the number of unique values
+  for string features.
+
+  Unlike UniquesStatsGenerator, it does not shuffle the values: each feature is
+  counted by a HyperLogLog sketch of 2^precision bytes. The count is exact (up
+  to hash collisions) while the sketch holds at most 2^precision / 8
+  distinct values, and has a relative standard error of
+  1.04 / sqrt(2^precision) afterwards, which is output as the custom statistic
+  'approximate_unique_relative_error'.
+  """
+
+  def __init__(self,
+               name = 'ApproximateUniquesStatsGenerator',
+               schema = None,
+               precision = 14):
+    """Initializes an approximate uniques stats generator.
+
+    Args:
+      name: An optional unique name associated with the statistics generator.
+      schema: An optional schema for the dataset.
+      precision: An optional base 2 logarithm of the number of registers of
+          the sketch of each feature, between 4 and 18 (defaults to 14, a
+          relative error of 0.8%).
+    """
+    super(ApproximateUniquesStatsGenerator, self).__init__(name, schema)
+    self._categorical_features = set(
+        schema_util.get_categorical_numeric_features(schema) if schema else [])
+    self._precision = precision
+    # Fails early on an invalid precision.
+    pywrap_tensorflow_data_validation.CreateUniquesSketch(precision)
+
+  # Create an accumulator, which maps feature name to the sketch of the
+  # feature.
+  def create_accumulator(self):
+    return {}
+
+  # Incorporates the input (a Python dict whose keys are feature names and
+  # values are numpy arrays representing a batch of examples) into the
+  # accumulator.
+  def add_input(self, accumulator,
+                input_batch
+               ):
+    for feature_name, values_batch in six.iteritems(input_batch):
+      is_categorical = feature_name in self._categorical_features
+      value_lists = []
+      for values in values_batch:
+        # Check if we have a numpy array with at least one value.
+        if not isinstance(values, np.ndarray) or values.size == 0:
+          continue
+        # If the feature is neither categorical nor of string type, then
+        # skip the feature.
+        if not (is_categorical or get_feature_type(
+            values.dtype) == statistics_pb2.FeatureNameStatistics.STRING):
+          continue
+        value_lists.append(values.astype(str) if is_categorical else values)
+      if not value_lists:
+        continue
+
+      if feature_name not in accumulator:
+        accumulator[feature_name] = _UniquesSketch(
+            pywrap_tensorflow_data_validation.CreateUniquesSketch(
+                self._precision))
+      pywrap_tensorflow_data_validation.AddToUniquesSketch(
+          accumulator[feature_name].handle, value_lists)
+    return accumulator
+
+  # Merge together a list of accumulators.
+  def merge_accumulators(
+      self, accumulators
+  ):
+    result = {}
+    for accumulator in accumulators:
+      for feature_name, sketch in six.iteritems(accumulator):
+        if feature_name not in result:
+          result[feature_name] = sketch
+        else:
+          pywrap_tensorflow_data_validation.MergeUniquesSketches(
+              result[feature_name].handle, sketch.handle)
+    return result
+
+  # Return final stats as a DatasetFeatureStatistics proto.
+  def extract_output(self,
+                     accumulator
+                    ):
+    result = statistics_pb2.DatasetFeatureStatistics()
+    for feature_name, sketch in six.iteritems(accumulator):
+      estimate, relative_error = (
+          pywrap_tensorflow_data_validation.GetUniquesOfSketch(sketch.handle))
+      feature_stats_proto = _make_feature_stats_proto(
+          feature_name, int(round(estimate)),
+          feature_name in self._categorical_features)
+      error = feature_stats_proto.custom_stats.add()
+      error.name = 'approximate_unique_relative_error'
+      error.num = relative_error
+      result.features.add().CopyFrom(feature_stats_proto)
+    return result
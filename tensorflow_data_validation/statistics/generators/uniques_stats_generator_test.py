@@ -18,6 +18,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import pickle
+
 from absl.testing import absltest
 import numpy as np
 from tensorflow_data_validation.statistics.generators import uniques_stats_generator
@@ -179,5 +181,106 @@ class UniquesStatsGeneratorTest(test_util.TransformStatsGeneratorTest):
     generator = uniques_stats_generator.UniquesStatsGenerator(schema=schema)
     self.assertTransformOutputEqual(batches, generator, [expected_result_fa])
 
+
+class ApproximateUniquesStatsGeneratorTest(
+    test_util.CombinerStatsGeneratorTest):
+  """Tests for ApproximateUniquesStatsGenerator."""
+
+  def test_approximate_uniques_with_few_values(self):
+    # fa: 'a', 'b', 'c', 'd', 'e'
+    # fb: 'a', 'b', 'c'
+    batches = [{'fa': np.array([np.array(['a', 'b', 'c', 'e']), None,
+                                np.array(['a', 'c', 'd'])], dtype=np.object),
+                'fb': np.array([np.array(['a', 'c', 'c']), np.array(['b']),
+                                None], dtype=np.object)},
+               {'fa': np.array([np.array(['a', 'a', 'b', 'c', 'd']), None],
+                               dtype=np.object),
+                'fb': np.array([None, np.array([1.0])], dtype=np.object)}]
+    expected_result = {
+        'fa': text_format.Parse(
+            """
+            name: 'fa'
+            type: STRING
+            string_stats {
+              unique: 5
+            }
+            custom_stats {
+              name: 'approximate_unique_relative_error'
+              num: 0.0
+            }
+            """, statistics_pb2.FeatureNameStatistics()),
+        'fb': text_format.Parse(
+            """
+            name: 'fb'
+            type: STRING
+            string_stats {
+              unique: 3
+            }
+            custom_stats {
+              name: 'approximate_unique_relative_error'
+              num: 0.0
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    generator = uniques_stats_generator.ApproximateUniquesStatsGenerator()
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
+  def test_approximate_uniques_with_categorical_feature(self):
+    batches = [{'fa': np.array([np.array([12, 23, 34, 12]),
+                                np.array([45, 23])])},
+               {'fa': np.array([np.array([12, 12, 34, 45])])}]
+    expected_result = {
+        'fa': text_format.Parse(
+            """
+            name: 'fa'
+            type: INT
+            string_stats {
+              unique: 4
+            }
+            custom_stats {
+              name: 'approximate_unique_relative_error'
+              num: 0.0
+            }
+            """, statistics_pb2.FeatureNameStatistics())}
+    schema = text_format.Parse(
+        """
+        feature {
+          name: "fa"
+          type: INT
+          int_domain {
+            is_categorical: true
+          }
+        }
+        """, schema_pb2.Schema())
+    generator = uniques_stats_generator.ApproximateUniquesStatsGenerator(
+        schema=schema)
+    self.assertCombinerOutputEqual(batches, generator, expected_result)
+
+  def test_approximate_uniques_with_many_values(self):
+    # 4000 distinct values, half of them in both batches.
+    batches = [
+        {'fa': np.array([np.array([str(i) for i in range(3000)])])},
+        {'fa': np.array([np.array([str(i) for i in range(1000, 4000)])])}]
+    generator = uniques_stats_generator.ApproximateUniquesStatsGenerator(
+        precision=10)
+    accumulators = [
+        pickle.loads(pickle.dumps(
+            generator.add_input(generator.create_accumulator(), batch)))
+        for batch in batches
+    ]
+    result = generator.extract_output(
+        generator.merge_accumulators(accumulators))
+    self.assertLen(result.features, 1)
+    feature_stats = result.features[0]
+    relative_error = feature_stats.custom_stats[0].num
+    self.assertAlmostEqual(relative_error, 1.04 / 32)
+    # Within 4 standard errors.
+    self.assertLess(abs(feature_stats.string_stats.unique - 4000),
+                    4 * relative_error * 4000)
+
+  def test_approximate_uniques_with_invalid_precision(self):
+    with self.assertRaises(ValueError):
+      uniques_stats_generator.ApproximateUniquesStatsGenerator(precision=30)
+
+
 if __name__ == '__main__':
   absltest.main()
@@ -21,6 +21,7 @@ from __future__ import print_function
 
 import apache_beam as beam
 from tensorflow_data_validation import types
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
 from tensorflow_data_validation.statistics.generators import stats_generator
 from tensorflow_data_validation.types_compat import List, TypeVar
 
@@ -34,18 +35,33 @@ class GenerateStatisticsImpl(beam.PTransform):
 
   def __init__(
       self,
-      generators):
+      generators,
+      fuse_combiners = False):
+    """Initializes the PTransform.
+
+    Args:
+      generators: The statistics generators to apply.
+      fuse_combiners: If True, all the CombinerStatsGenerators are run by a
+          single beam.CombineFn, so that each batch is read once rather than
+          once per generator.
+    """
     self._generators = generators
+    self._fuse_combiners = fuse_combiners
 
   def expand(self, pcoll):
     result_protos = []
+    combiner_generators = []
     # Iterate over the stats generators. For each generator,
     #   a) if it is a CombinerStatsGenerator, wrap it as a beam.CombineFn
-    #      and run it.
+    #      and run it (or, if the combiners are fused, run it later with the
+    #      other CombinerStatsGenerators).
     #   b) if it is a TransformStatsGenerator, wrap it as a beam.PTransform
     #      and run it.
     for generator in self._generators:
       if isinstance(generator, stats_generator.CombinerStatsGenerator):
+        if self._fuse_combiners:
+          combiner_generators.append(generator)
+          continue
         result_protos.append(
             pcoll |
             generator.name >> beam.CombineGlobally(
@@ -59,6 +75,11 @@ class GenerateStatisticsImpl(beam.PTransform):
                         'CombinerStatsGenerator or TransformStatsGenerator, '
                         'found object of type %s' %
                         type(generator).__class__.__name__)
+    if combiner_generators:
+      result_protos.append(
+          pcoll |
+          'RunCombinerStatsGenerators' >> beam.CombineGlobally(
+              _FusedCombineFnWrapper(combiner_generators)))
 
     # Each stats generator will output a PCollection of DatasetFeatureStatistics
     # protos. We now flatten the list of PCollections into a single PCollection,
@@ -66,9 +87,7 @@ class GenerateStatisticsImpl(beam.PTransform):
     # single DatasetFeatureStatisticsList proto.
     return (result_protos | 'FlattenFeatureStatistics' >> beam.Flatten()
             | 'MergeDatasetFeatureStatisticsProtos' >>
-            beam.CombineGlobally(_merge_dataset_feature_stats_protos)
-            | 'MakeDatasetFeatureStatisticsListProto' >>
-            beam.Map(_make_dataset_feature_statistics_list_proto))
+            beam.CombineGlobally(_MergeDatasetFeatureStatisticsFn()))
 
 
 def _merge_dataset_feature_stats_protos(
@@ -82,66 +101,60 @@ def _merge_dataset_feature_stats_protos(
   Returns:
     The merged DatasetFeatureStatistics proto.
   """
-  stats_per_feature = {}
-  # Iterate over each DatasetFeatureStatistics proto and merge the
-  # FeatureNameStatistics protos per feature.
-  for stats_proto in stats_protos:
-    for feature_stats_proto in stats_proto.features:
-      if feature_stats_proto.name not in stats_per_feature:
-        stats_per_feature[feature_stats_proto.name] = feature_stats_proto
-      else:
-        stats_per_feature[feature_stats_proto.name].MergeFrom(
-            feature_stats_proto)
-
-  # Create a new DatasetFeatureStatistics proto.
-  result = statistics_pb2.DatasetFeatureStatistics()
-  num_examples = None
-  for feature_stats_proto in stats_per_feature.values():
-    # Add the merged FeatureNameStatistics proto for the feature
-    # into the DatasetFeatureStatistics proto.
-    new_feature_stats_proto = result.features.add()
-    new_feature_stats_proto.CopyFrom(feature_stats_proto)
-
-    # Get the number of examples from one of the features that
-    # has common stats.
-    if num_examples is None:
-      stats_type = feature_stats_proto.WhichOneof('stats')
-      stats_proto = None
-      if stats_type == 'num_stats':
-        stats_proto = feature_stats_proto.num_stats
-      else:
-        stats_proto = feature_stats_proto.string_stats
-
-      if stats_proto.HasField('common_stats'):
-        num_examples = (stats_proto.common_stats.num_non_missing +
-                        stats_proto.common_stats.num_missing)
-
-  # Set the num_examples field.
-  if num_examples is not None:
-    result.num_examples = num_examples
-  return result
+  return _merge_serialized_dataset_feature_stats_protos(
+      [stats_proto.SerializeToString() for stats_proto in stats_protos]
+  ).datasets[0]
 
 
-def _make_dataset_feature_statistics_list_proto(
-    stats_proto
+def _merge_serialized_dataset_feature_stats_protos(
+    serialized_stats_protos
 ):
-  """Constructs a DatasetFeatureStatisticsList proto.
+  """Merge together a list of serialized DatasetFeatureStatistics protos.
+
+  The FeatureNameStatistics protos are merged per feature, and the number of
+  examples is taken from one of the features that has common stats.
 
   Args:
-    stats_proto: The input DatasetFeatureStatistics proto.
+    serialized_stats_protos: A list of serialized DatasetFeatureStatistics
+        protos to merge.
 
   Returns:
-    The DatasetFeatureStatisticsList proto containing the input stats proto.
+    A DatasetFeatureStatisticsList proto containing the merged
+    DatasetFeatureStatistics proto.
+  """
+  return statistics_pb2.DatasetFeatureStatisticsList.FromString(
+      pywrap_tensorflow_data_validation.MergeDatasetFeatureStatistics(
+          serialized_stats_protos))
+
+
+@beam.typehints.with_input_types(statistics_pb2.DatasetFeatureStatistics)
+@beam.typehints.with_output_types(statistics_pb2.DatasetFeatureStatisticsList)
+class _MergeDatasetFeatureStatisticsFn(beam.CombineFn):
+  """A beam.CombineFn that merges DatasetFeatureStatistics protos into a
+  DatasetFeatureStatisticsList proto.
+
+  The accumulator is the list of the serialized input protos, which are merged
+  (without being parsed) once all of them have been accumulated.
   """
-  # Create a new DatasetFeatureStatisticsList proto.
-  result = statistics_pb2.DatasetFeatureStatisticsList()
 
-  # Add the input DatasetFeatureStatistics proto.
-  dataset_stats_proto = result.datasets.add()
-  dataset_stats_proto.CopyFrom(stats_proto)
-  return result
+  def create_accumulator(self):
+    return []
+
+  def add_input(self, accumulator,
+                stats_proto):
+    accumulator.append(stats_proto.SerializeToString())
+    return accumulator
 
+  def merge_accumulators(self, accumulators):
+    result = []
+    for accumulator in accumulators:
+      result.extend(accumulator)
+    return result
 
+  def extract_output(
+      self, accumulator
+  ):
+    return _merge_serialized_dataset_feature_stats_protos(accumulator)
 
 
 @beam.typehints.with_input_types(types.ExampleBatch)
@@ -174,3 +187,55 @@ class _CombineFnWrapper(beam.CombineFn):
       accumulator
   ):  # pytype: disable=invalid-annotation
     return self._generator.extract_output(accumulator)
+
+
+@beam.typehints.with_input_types(types.ExampleBatch)
+@beam.typehints.with_output_types(
+    statistics_pb2.DatasetFeatureStatistics)
+class _FusedCombineFnWrapper(beam.CombineFn):
+  """Class to wrap a list of CombinerStatsGenerators as a single
+  beam.CombineFn.
+
+  The accumulator is the list of the accumulators of the generators, and the
+  output holds the features of the outputs of all the generators (which
+  _MergeDatasetFeatureStatisticsFn then merges per feature).
+  """
+
+  def __init__(
+      self,
+      generators):
+    self._generators = generators
+
+  def __reduce__(self):
+    return _FusedCombineFnWrapper, (self._generators,)
+
+  def create_accumulator(self
+                        ):  # pytype: disable=invalid-annotation
+    return [generator.create_accumulator() for generator in self._generators]
+
+  def add_input(self, accumulator,
+                input_batch):
+    return [generator.add_input(generator_accumulator, input_batch)
+            for generator, generator_accumulator in zip(self._generators,
+                                                        accumulator)]
+
+  def merge_accumulators(self, accumulators):
+    # Transpose the accumulators to get the list of accumulators of each
+    # generator.
+    accumulators = list(accumulators)
+    return [
+        generator.merge_accumulators(
+            [accumulator[i] for accumulator in accumulators])
+        for i, generator in enumerate(self._generators)
+    ]
+
+  def extract_output(
+      self,
+      accumulator
+  ):  # pytype: disable=invalid-annotation
+    result = statistics_pb2.DatasetFeatureStatistics()
+    for generator, generator_accumulator in zip(self._generators,
+                                                accumulator):
+      result.features.extend(
+          generator.extract_output(generator_accumulator).features)
+    return result
@@ -68,6 +68,61 @@ class StatsImplTest(absltest.TestCase):
           test_util.make_dataset_feature_stats_list_proto_equal_fn(
               self, expected_result))
 
+  def test_generate_stats_impl_with_fused_combiners(self):
+    batches = [{'a': np.array([np.array(['xyz']), np.array(['qwe'])])},
+               {'a': np.array([np.array(['ab'])])}]
+
+    generator1 = string_stats_generator.StringStatsGenerator()
+    generator2 = uniques_stats_generator.ApproximateUniquesStatsGenerator()
+    generator3 = uniques_stats_generator.UniquesStatsGenerator(
+        name='ExactUniquesStatsGenerator')
+
+    expected_result = text_format.Parse(
+        """
+        datasets {
+          features {
+            name: 'a'
+            type: STRING
+            string_stats {
+              avg_length: 2.66666666
+              unique: 3
+            }
+            custom_stats {
+              name: 'approximate_unique_relative_error'
+              num: 0.0
+            }
+          }
+        }
+        """, statistics_pb2.DatasetFeatureStatisticsList())
+
+    with beam.Pipeline() as p:
+      result = (p | beam.Create(batches) |
+                stats_impl.GenerateStatisticsImpl(
+                    generators=[generator1, generator2, generator3],
+                    fuse_combiners=True))
+      util.assert_that(
+          result,
+          test_util.make_dataset_feature_stats_list_proto_equal_fn(
+              self, expected_result))
+
+  def test_fused_combine_fn_wrapper(self):
+    batches = [{'a': np.array([np.array(['xyz']), np.array(['qwe'])])},
+               {'a': np.array([np.array(['ab'])])}]
+    combine_fn = stats_impl._FusedCombineFnWrapper(
+        [string_stats_generator.StringStatsGenerator(),
+         uniques_stats_generator.ApproximateUniquesStatsGenerator()])
+    accumulators = [
+        combine_fn.add_input(combine_fn.create_accumulator(), batch)
+        for batch in batches
+    ]
+    result = combine_fn.extract_output(
+        combine_fn.merge_accumulators(iter(accumulators)))
+    self.assertEqual([feature.name for feature in result.features],
+                     ['a', 'a'])
+    self.assertAlmostEqual(result.features[0].string_stats.avg_length,
+                           8 / 3)
+    self.assertEqual(result.features[1].string_stats.unique, 3)
+
   def test_merge_dataset_feature_stats_protos(self):
     proto1 = text_format.Parse(
         """
@@ -160,13 +215,43 @@ class StatsImplTest(absltest.TestCase):
     self.assertEqual(stats_impl._merge_dataset_feature_stats_protos([]),
                      statistics_pb2.DatasetFeatureStatistics())
 
-  def test_make_dataset_feature_statistics_list_proto(self):
-    input_proto = text_format.Parse(
+  def test_merge_dataset_feature_statistics_fn(self):
+    proto1 = text_format.Parse(
         """
-        num_examples: 7
         features: {
           name: 'feature1'
           type: STRING
+          string_stats: {
+            common_stats: {
+              num_missing: 3
+              num_non_missing: 4
+            }
+          }
+        }
+        features: {
+          name: 'feature2'
+          type: INT
+          num_stats: {
+            mean: 1.5
+          }
+        }
+        """, statistics_pb2.DatasetFeatureStatistics())
+
+    proto2 = text_format.Parse(
+        """
+        features: {
+          name: 'feature2'
+          type: INT
+          num_stats: {
+            max: 2
+          }
+        }
+        features: {
+          name: 'feature1'
+          type: STRING
+          string_stats: {
+            unique: 3
+          }
         }
         """, statistics_pb2.DatasetFeatureStatistics())
 
@@ -177,12 +262,31 @@ class StatsImplTest(absltest.TestCase):
           features: {
             name: 'feature1'
             type: STRING
+            string_stats: {
+              common_stats: {
+                num_missing: 3
+                num_non_missing: 4
+              }
+              unique: 3
+            }
+          }
+          features: {
+            name: 'feature2'
+            type: INT
+            num_stats: {
+              mean: 1.5
+              max: 2
+            }
           }
         }
         """, statistics_pb2.DatasetFeatureStatisticsList())
 
+    combine_fn = stats_impl._MergeDatasetFeatureStatisticsFn()
+    accumulator1 = combine_fn.add_input(combine_fn.create_accumulator(), proto1)
+    accumulator2 = combine_fn.add_input(combine_fn.create_accumulator(), proto2)
     self.assertEqual(
-        stats_impl._make_dataset_feature_statistics_list_proto(input_proto),
+        combine_fn.extract_output(
+            combine_fn.merge_accumulators([accumulator1, accumulator2])),
         expected)
 
   def test_tfdv_telemetry(self):
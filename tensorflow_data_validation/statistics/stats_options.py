@@ -45,7 +45,10 @@ class StatsOptions(object):
       num_histogram_buckets = 10,
       num_quantiles_histogram_buckets = 10,
       epsilon = 0.01,
-      infer_type_from_schema = False
+      infer_type_from_schema = False,
+      approximate_top_k_and_uniques = False,
+      fuse_combiner_generators = False,
+      desired_batch_bytes = None
       ):
     """Initializes statistics options.
 
@@ -63,7 +66,10 @@ class StatsOptions(object):
         specified, statistics is computed over the sample. Only one of
         sample_count or sample_rate can be specified.
       sample_rate: An optional sampling rate. If specified, statistics is
-        computed over the sample. Only one of sample_count or sample_rate can
+        computed over a sample in which each example is kept with this
+        probability, and the counts of the common and numeric statistics are
+        scaled to estimate those over all the examples, with their confidence
+        intervals in custom_stats. Only one of sample_count or sample_rate can
         be specified.
       num_top_values: An optional number of most frequent feature values to keep
         for string features.
@@ -85,6 +91,22 @@ class StatsOptions(object):
           should be inferred from the schema. If set to True, an input schema
           must be provided. This flag is used only when generating statistics
           on CSV data.
+      approximate_top_k_and_uniques: A boolean to indicate whether the top-k
+          values and the number of unique values of string features should be
+          approximated with fixed-size sketches (see
+          ApproximateTopKStatsGenerator and ApproximateUniquesStatsGenerator)
+          instead of being computed exactly. The exact computation shuffles
+          every distinct value of every string feature.
+      fuse_combiner_generators: A boolean to indicate whether the statistics
+          generators that extend CombinerStatsGenerator should be run by a
+          single combiner, which reads each batch of examples once, instead of
+          one combiner per generator.
+      desired_batch_bytes: An optional budget of bytes of the values of a batch
+          of examples. If specified, the examples are batched up to this
+          budget, and the number of examples of a batch adapts to the time
+          that merging them into a batch takes (see
+          batch_util.BatchElementsByBytes), instead of the batches having a
+          number of examples that ignores their sizes.
     """
     self.generators = generators
     self.feature_whitelist = feature_whitelist
@@ -99,3 +121,6 @@ class StatsOptions(object):
     self.num_quantiles_histogram_buckets = num_quantiles_histogram_buckets
     self.epsilon = epsilon
     self.infer_type_from_schema = infer_type_from_schema
+    self.approximate_top_k_and_uniques = approximate_top_k_and_uniques
+    self.fuse_combiner_generators = fuse_combiner_generators
+    self.desired_batch_bytes = desired_batch_bytes
@@ -19,7 +19,10 @@ from __future__ import division
 
 from __future__ import print_function
 
+import time
+
 import apache_beam as beam
+from apache_beam.transforms import window
 import numpy as np
 from tensorflow_data_validation import types
 from tensorflow_data_validation.types_compat import List, Optional
@@ -38,12 +41,257 @@ def merge_single_batch(batch):
   return result
 
 
+def decoded_column_to_batch_value(
+    kind, values, row_offsets,
+    has_values, num_examples):
+  """Converts a natively decoded feature column to its batch value.
+
+  Args:
+    kind: The kind of the values of the column, one of 'int64', 'float',
+      'double' and 'bytes', or None if no example has values.
+    values: A bytearray holding the int64, float32 or float64 values of the
+      column, or a list of its bytes values.
+    row_offsets: A bytearray holding the num_examples + 1 int64 offsets of
+      the values of each example in values.
+    has_values: A bytearray holding num_examples uint8 values, 1 for the
+      examples with values for the feature.
+    num_examples: The number of examples in the batch.
+
+  Returns:
+    A numpy array holding, for each example, the numpy array of its values or
+    None.
+  """
+  result = np.empty(num_examples, dtype=np.object)
+  if kind is None:
+    return result
+  # The int64 and float64 values are a writable view of the buffer of the
+  # column, which is not copied; the float32 values are widened to a copy.
+  if kind == 'int64':
+    values = np.frombuffer(values, dtype=np.int64).astype(
+        np.integer, copy=False)
+  elif kind == 'float':
+    values = np.frombuffer(values, dtype=np.float32).astype(np.floating)
+  elif kind == 'double':
+    values = np.frombuffer(values, dtype=np.float64).astype(
+        np.floating, copy=False)
+  else:
+    values = np.array(values, dtype=np.object)
+  row_offsets = np.frombuffer(row_offsets, dtype=np.int64)
+  # The values of each example are a view of the values of the column.
+  for i in np.flatnonzero(np.frombuffer(has_values, dtype=np.uint8)):
+    result[i] = values[row_offsets[i]:row_offsets[i + 1]]
+  return result
+
+
+def get_example_size(example):
+  """Estimates the size in bytes of the values of an example.
+
+  Args:
+    example: A dict of feature name to a numpy array of values (or None).
+
+  Returns:
+    The number of bytes of the numeric values, plus the lengths of the bytes
+    and string values.
+  """
+  size = 0
+  for values in example.values():
+    if values is None:
+      continue
+    if values.dtype == np.object:
+      size += sum(len(value) for value in values)
+    else:
+      size += values.nbytes
+  return size
+
+
+class _BatchSizeEstimator(object):
+  """Adapts the number of elements of the batches to the time that batch_fn
+  takes to process each batch."""
+
+  def __init__(self, min_batch_size, max_batch_size,
+               target_batch_duration_secs):
+    self._min_batch_size = min_batch_size
+    self._max_batch_size = max_batch_size
+    self._target_batch_duration_secs = target_batch_duration_secs
+    self._batch_size = min_batch_size
+
+  def next_batch_size(self):
+    return self._batch_size
+
+  def record_batch(self, batch_size, duration_secs):
+    """Records that a batch of batch_size elements took duration_secs."""
+    if duration_secs > self._target_batch_duration_secs:
+      # Shrink the batches in proportion to how much they overran.
+      self._batch_size = max(
+          self._min_batch_size,
+          int(batch_size * self._target_batch_duration_secs / duration_secs))
+    elif (duration_secs < self._target_batch_duration_secs / 2 and
+          batch_size >= self._batch_size):
+      # Only full batches (rather than those cut by the byte budget) show
+      # that larger ones would fit.
+      self._batch_size = min(self._max_batch_size, 2 * self._batch_size)
+
+
+class _BatchElementsByBytesDoFn(beam.DoFn):
+  """A beam.DoFn that batches elements up to a byte budget."""
+
+  def __init__(self, element_size_fn, batch_fn, max_batch_bytes,
+               min_batch_size, max_batch_size,
+               target_batch_duration_secs, clock = time.time):
+    self._element_size_fn = element_size_fn
+    self._batch_fn = batch_fn
+    self._max_batch_bytes = max_batch_bytes
+    self._min_batch_size = min_batch_size
+    self._max_batch_size = max_batch_size
+    self._target_batch_duration_secs = target_batch_duration_secs
+    self._clock = clock
+    self._estimator = None
+    self._batch = []
+    self._batch_bytes = 0
+
+  def start_bundle(self):
+    # The estimator is kept from one bundle to the next.
+    if self._estimator is None:
+      self._estimator = _BatchSizeEstimator(self._min_batch_size,
+                                            self._max_batch_size,
+                                            self._target_batch_duration_secs)
+    self._batch = []
+    self._batch_bytes = 0
+
+  def process(self, element):
+    self._batch.append(element)
+    self._batch_bytes += self._element_size_fn(element)
+    if (len(self._batch) >= self._estimator.next_batch_size() or
+        self._batch_bytes >= self._max_batch_bytes):
+      batch = self._batch
+      self._batch = []
+      self._batch_bytes = 0
+      # Only batch_fn is timed, and not the downstream transforms that are
+      # fused with this one and process the result before the yield returns.
+      start = self._clock()
+      result = self._batch_fn(batch)
+      self._estimator.record_batch(len(batch), self._clock() - start)
+      yield result
+
+  def finish_bundle(self):
+    if self._batch:
+      yield window.GlobalWindows.windowed_value(self._batch_fn(self._batch))
+      self._batch = []
+      self._batch_bytes = 0
+
+
+@beam.ptransform_fn
+def BatchElementsByBytes(  # pylint: disable=invalid-name
+    elements,
+    element_size_fn,
+    max_batch_bytes,
+    batch_fn = lambda batch: batch,
+    min_batch_size = 1,
+    max_batch_size = 10000,
+    target_batch_duration_secs = 1.0):
+  """Batches elements into lists, up to a budget of bytes per batch.
+
+  A batch is emitted once its elements reach max_batch_bytes, so that a few
+  large elements do not make a batch that does not fit in memory (an element
+  larger than the budget makes a batch of its own), or once it reaches a
+  number of elements, between min_batch_size and max_batch_size, which grows
+  while batch_fn processes the batches faster than
+  target_batch_duration_secs, and shrinks when it is slower. The elements
+  must be in the global window.
+
+  Args:
+    elements: PCollection of elements.
+    element_size_fn: A function that estimates the size in bytes of an
+      element.
+    max_batch_bytes: The budget of bytes of a batch.
+    batch_fn: A function that is applied to each list of elements, e.g., to
+      merge or decode them. Only its time is measured to adapt the batches.
+    min_batch_size: The smallest number of elements of a batch (unless the
+      budget of bytes is reached first).
+    max_batch_size: The largest number of elements of a batch.
+    target_batch_duration_secs: The time in which batch_fn should process a
+      batch.
+
+  Returns:
+    PCollection of the results of batch_fn on lists of elements.
+  """
+  return elements | 'BatchElementsByBytes' >> beam.ParDo(
+      _BatchElementsByBytesDoFn(element_size_fn, batch_fn, max_batch_bytes,
+                                min_batch_size, max_batch_size,
+                                target_batch_duration_secs))
+
+
+def sample_batch(batch,
+                 sample_rate,
+                 random_state
+                ):
+  """Samples the examples of a batch, keeping each with probability sample_rate.
+
+  Args:
+    batch: A batch of examples in the format of BatchExamples.
+    sample_rate: The probability with which each example is kept.
+    random_state: The numpy RandomState that draws the examples to keep.
+
+  Returns:
+    A batch of the examples kept, or None if no example is kept.
+  """
+  if not batch:
+    return batch
+  num_examples = len(next(iter(batch.values())))
+  keep = random_state.random_sample(num_examples) < sample_rate
+  if not keep.any():
+    return None
+  return {feature: values[keep] for feature, values in batch.items()}
+
+
+class _SampleBatchesDoFn(beam.DoFn):
+  """A beam.DoFn that samples the examples of batches."""
+
+  def __init__(self, sample_rate):
+    self._sample_rate = sample_rate
+    self._random_state = None
+
+  def start_bundle(self):
+    # Seeded per bundle, so that the workers draw different samples.
+    self._random_state = np.random.RandomState()
+
+  def process(self, batch
+             ):
+    result = sample_batch(batch, self._sample_rate, self._random_state)
+    if result is not None:
+      yield result
+
+
+@beam.ptransform_fn
+@beam.typehints.with_input_types(types.ExampleBatch)
+@beam.typehints.with_output_types(types.ExampleBatch)
+def SampleBatches(  # pylint: disable=invalid-name
+    batches,
+    sample_rate):
+  """Samples the examples of batches in the format of BatchExamples.
+
+  Each example is kept with probability sample_rate (a Bernoulli sample), with
+  one vectorized draw per batch rather than one per example, and the batches
+  with no example kept are dropped.
+
+  Args:
+    batches: PCollection of batches of examples.
+    sample_rate: The probability with which each example is kept.
+
+  Returns:
+    PCollection of the batches of the examples kept.
+  """
+  return batches | 'SampleBatches' >> beam.ParDo(
+      _SampleBatchesDoFn(sample_rate))
+
+
 @beam.ptransform_fn
 @beam.typehints.with_input_types(types.Example)
 @beam.typehints.with_output_types(types.ExampleBatch)
 def BatchExamples(  # pylint: disable=invalid-name
     examples,
-    desired_batch_size = None):
+    desired_batch_size = None,
+    desired_batch_bytes = None):
   """Batches input examples to proper batch format.
 
   Each input example is a dict of feature name to np.ndarray of feature values.
@@ -72,14 +320,24 @@ def BatchExamples(  # pylint: disable=invalid-name
       feature name to a numpy array of values (OK to be empty).
     desired_batch_size: Optional batch size for batching examples when
       computing data statistics.
+    desired_batch_bytes: Optional budget of bytes of the values of a batch
+      (see BatchElementsByBytes). If specified, the number of examples of a
+      batch adapts to the time that merging them into a batch takes, up to
+      desired_batch_size if it is specified.
 
   Returns:
     PCollection of batched examples.
   """
+  if desired_batch_bytes:
+    batch_args = {}
+    if desired_batch_size:
+      batch_args = dict(max_batch_size=desired_batch_size)
+    return examples | 'BatchExamplesByBytes' >> BatchElementsByBytes(
+        get_example_size, desired_batch_bytes, batch_fn=merge_single_batch,
+        **batch_args)
   batch_args = {}
   if desired_batch_size:
     batch_args = dict(
         min_batch_size=desired_batch_size, max_batch_size=desired_batch_size)
-  return (examples
-          | 'BatchExamples' >> beam.BatchElements(**batch_args)
-          | 'MergeBatch' >> beam.Map(merge_single_batch))
+  batches = examples | 'BatchExamples' >> beam.BatchElements(**batch_args)
+  return batches | 'MergeBatch' >> beam.Map(merge_single_batch)
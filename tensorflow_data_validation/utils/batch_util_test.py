@@ -70,6 +70,126 @@ class BatchUtilTest(absltest.TestCase):
       util.assert_that(
           result, _batched_example_equal_fn(expected_batched_examples))
 
+  def test_batch_examples_by_bytes(self):
+    # Each example has 16 bytes of values.
+    examples = [{'a': np.array([float(i), 1.0], dtype=np.float64)}
+                for i in range(10)]
+
+    def _matcher(actual_batches):
+      batch_sizes = [len(batch['a']) for batch in actual_batches]
+      self.assertEqual(10, sum(batch_sizes))
+      # A batch does not exceed the budget of 32 bytes.
+      self.assertLessEqual(max(batch_sizes), 2)
+
+    with beam.Pipeline() as p:
+      result = (p
+                | beam.Create(examples)
+                | batch_util.BatchExamples(desired_batch_bytes=32))
+      util.assert_that(result, _matcher)
+
+  def test_get_example_size(self):
+    self.assertEqual(
+        16 + 5,
+        batch_util.get_example_size({
+            'a': np.array([1, 2], dtype=np.int64),
+            'b': np.array([b'abc', b'de'], dtype=np.object),
+            'c': None
+        }))
+
+  def test_batch_size_estimator(self):
+    estimator = batch_util._BatchSizeEstimator(
+        min_batch_size=1, max_batch_size=8, target_batch_duration_secs=1.0)
+    self.assertEqual(1, estimator.next_batch_size())
+    # Fast batches grow, up to max_batch_size.
+    for expected_batch_size in [2, 4, 8, 8]:
+      estimator.record_batch(estimator.next_batch_size(), 0.1)
+      self.assertEqual(expected_batch_size, estimator.next_batch_size())
+    # A batch cut by the byte budget does not grow them.
+    estimator.record_batch(2, 0.1)
+    self.assertEqual(8, estimator.next_batch_size())
+    # Slow batches shrink them in proportion.
+    estimator.record_batch(8, 4.0)
+    self.assertEqual(2, estimator.next_batch_size())
+    estimator.record_batch(2, 100.0)
+    self.assertEqual(1, estimator.next_batch_size())
+
+  def test_decoded_column_to_batch_value(self):
+    values = bytearray(np.array([1, 2, 3], dtype=np.int64).tobytes())
+    row_offsets = bytearray(np.array([0, 2, 2, 3], dtype=np.int64).tobytes())
+    has_values = bytearray(np.array([1, 0, 1], dtype=np.uint8).tobytes())
+    result = batch_util.decoded_column_to_batch_value(
+        'int64', values, row_offsets, has_values, 3)
+    np.testing.assert_array_equal(result[0], np.array([1, 2]))
+    self.assertIsNone(result[1])
+    np.testing.assert_array_equal(result[2], np.array([3]))
+    # The values are a writable view of the buffer of the column.
+    self.assertTrue(result[0].flags.writeable)
+    result[0][0] = 4
+    np.testing.assert_array_equal(result[0], np.array([4, 2]))
+    np.testing.assert_array_equal(result[2], np.array([3]))
+    self.assertEqual(
+        bytearray(np.array([4, 2, 3], dtype=np.int64).tobytes()), values)
+
+  def test_batch_elements_by_bytes_times_only_batch_fn(self):
+    now = [0.0]
+
+    def _batch_fn(batch):
+      # Each batch takes 0.1 seconds to process.
+      now[0] += 0.1
+      return batch
+
+    do_fn = batch_util._BatchElementsByBytesDoFn(
+        len, _batch_fn, max_batch_bytes=100, min_batch_size=1,
+        max_batch_size=8, target_batch_duration_secs=1.0,
+        clock=lambda: now[0])
+    do_fn.start_bundle()
+    for batch in do_fn.process(b'a'):
+      self.assertEqual([b'a'], batch)
+      # The time of the downstream transforms is not measured.
+      now[0] += 100.0
+    # The batch took 0.1 seconds rather than 100.1, so the batches grow.
+    self.assertEqual(2, do_fn._estimator.next_batch_size())
+
+  def test_batch_elements_by_bytes_budget(self):
+    do_fn = batch_util._BatchElementsByBytesDoFn(
+        len, lambda batch: batch, max_batch_bytes=10, min_batch_size=100,
+        max_batch_size=100, target_batch_duration_secs=1.0)
+    do_fn.start_bundle()
+    batches = []
+    for element in [b'abcd', b'efgh', b'ijkl', b'0123456789abc', b'xy']:
+      batches.extend(do_fn.process(element))
+    self.assertEqual([[b'abcd', b'efgh', b'ijkl'], [b'0123456789abc']],
+                     batches)
+    # The last batch is emitted at the end of the bundle.
+    last_batches = list(do_fn.finish_bundle())
+    self.assertEqual(1, len(last_batches))
+    self.assertEqual([b'xy'], last_batches[0].value)
+
+  def test_sample_batch(self):
+    batch = {
+        'a': np.array([np.array([1]), None, np.array([3]), np.array([4])],
+                      dtype=np.object),
+        'b': np.array([None, np.array(['b']), np.array(['c']), None],
+                      dtype=np.object)
+    }
+    random_state = np.random.RandomState(0)
+    # The draws of RandomState(0) are 0.55, 0.72, 0.60 and 0.54.
+    sampled = batch_util.sample_batch(batch, 0.58, random_state)
+    self.assertCountEqual(['a', 'b'], sampled.keys())
+    np.testing.assert_array_equal(sampled['a'], batch['a'][[0, 3]])
+    np.testing.assert_array_equal(sampled['b'], batch['b'][[0, 3]])
+
+  def test_sample_batch_keeps_nothing(self):
+    batch = {'a': np.array([np.array([1]), None], dtype=np.object)}
+    random_state = np.random.RandomState(0)
+    self.assertIsNone(batch_util.sample_batch(batch, 0.01, random_state))
+
+  def test_sample_batch_keeps_everything(self):
+    batch = {'a': np.array([np.array([1]), None], dtype=np.object)}
+    random_state = np.random.RandomState(0)
+    sampled = batch_util.sample_batch(batch, 1.0, random_state)
+    np.testing.assert_array_equal(sampled['a'], batch['a'])
+
 
 if __name__ == '__main__':
   absltest.main()
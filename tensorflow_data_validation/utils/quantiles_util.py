@@ -23,15 +23,40 @@ import bisect
 import collections
 
 import numpy as np
-from tensorflow_transform import analyzers
+from tensorflow_data_validation.anomalies import pywrap_tensorflow_data_validation
 from tensorflow_data_validation.types_compat import List, Union
 from tensorflow_metadata.proto.v0 import statistics_pb2
 
 
+class QuantilesSketch(object):
+  """A picklable handle of a native quantiles sketch.
+
+  The sketch is pickled in its compact serialized form.
+  """
+
+  __slots__ = ['handle']
+
+  def __init__(self, handle):
+    self.handle = handle
+
+  def __reduce__(self):
+    return _deserialize_quantiles_sketch, (
+        pywrap_tensorflow_data_validation.SerializeQuantilesSketch(
+            self.handle),)
+
+
+def _deserialize_quantiles_sketch(serialized_sketch):
+  return QuantilesSketch(
+      pywrap_tensorflow_data_validation.DeserializeQuantilesSketch(
+          serialized_sketch))
+
+
 class QuantilesCombiner(object):
   """Computes quantiles using a combiner function.
 
-  This class wraps tf.transform's QuantilesCombiner.
+  The accumulator is a QuantilesSketch, a native mergeable sketch of weighted
+  values (see anomalies/quantiles_sketch.h), in which the rank of a quantile
+  is within epsilon of the total weight.
   """
 
   def __init__(self, num_quantiles, epsilon,
@@ -39,33 +64,46 @@ class QuantilesCombiner(object):
     self._num_quantiles = num_quantiles
     self._epsilon = epsilon
     self._has_weights = has_weights
-    self._quantiles_spec = analyzers.QuantilesCombiner(
-        num_quantiles=num_quantiles, epsilon=epsilon,
-        bucket_numpy_dtype=np.float32, always_return_num_quantiles=True,
-        has_weights=has_weights)
-    # Initializes non-pickleable local state of the combiner spec.
-    self._quantiles_spec.initialize_local_state()
 
   def __reduce__(self):
     return QuantilesCombiner, (self._num_quantiles, self._epsilon,
                                self._has_weights)
 
   def create_accumulator(self):
-    return self._quantiles_spec.create_accumulator()
+    return QuantilesSketch(
+        pywrap_tensorflow_data_validation.CreateQuantilesSketch(self._epsilon))
 
+  # Adds a batch to the summary, in place. The batch is a list holding the
+  # values and, if the combiner has weights, optionally their weights. If
+  # there are no weights, each value has weight 1.
   def add_input(self, summary,
                 input_batch):
-    return self._quantiles_spec.add_input(summary, input_batch)
-
+    weights = None
+    if self._has_weights and len(input_batch) > 1:
+      weights = np.asarray(input_batch[1], dtype=np.float64)
+    pywrap_tensorflow_data_validation.AddToQuantilesSketch(
+        summary.handle, np.asarray(input_batch[0], dtype=np.float64), weights)
+    return summary
+
+  # Merges the summaries into the first one.
   def merge_accumulators(self, summaries):
-    return self._quantiles_spec.merge_accumulators(summaries)
-
+    summaries = iter(summaries)
+    result = next(summaries, None)
+    if result is None:
+      return self.create_accumulator()
+    for summary in summaries:
+      pywrap_tensorflow_data_validation.MergeQuantilesSketches(
+          result.handle, summary.handle)
+    return result
+
+  # Returns the num_quantiles - 1 boundaries between the quantiles, which are
+  # empty if there are no values.
   def extract_output(self, summary):
-    quantiles = self._quantiles_spec.extract_output(summary)
-    # The output of the combiner spec is a list containing a
-    # single numpy array which contains the quantile boundaries.
-    assert len(quantiles) == 1
-    return quantiles[0]
+    quantiles = np.frombuffer(
+        pywrap_tensorflow_data_validation.GetQuantilesOfSketch(
+            summary.handle, self._num_quantiles), dtype=np.float64)
+    # The sketch also returns the minimum and the maximum.
+    return quantiles[1:-1]
 
 
 def find_median(quantiles):
@@ -19,6 +19,8 @@ from __future__ import division
 
 from __future__ import print_function
 
+import pickle
+
 from absl.testing import absltest
 import numpy as np
 from tensorflow_data_validation.utils import quantiles_util
@@ -59,7 +61,7 @@ class QuantilesUtilTest(absltest.TestCase):
     batches = [[np.linspace(1, 100, 100)],
                [np.linspace(101, 200, 100)],
                [np.linspace(201, 300, 100)]]
-    expected_result = np.array([61.0, 121.0, 181.0, 241.0], dtype=np.float32)
+    expected_result = np.array([61.0, 121.0, 181.0, 241.0], dtype=np.float64)
     q_combiner = quantiles_util.QuantilesCombiner(5, 0.00001)
     _run_quantiles_combiner_test(self, q_combiner, batches, expected_result)
 
@@ -67,13 +69,31 @@ class QuantilesUtilTest(absltest.TestCase):
     batches = [[np.linspace(1, 100, 100), [1] * 100],
                [np.linspace(101, 200, 100), [2] * 100],
                [np.linspace(201, 300, 100), [3] * 100]]
-    expected_result = np.array([111.0, 171.0, 221.0, 261.0], dtype=np.float32)
+    expected_result = np.array([111.0, 171.0, 221.0, 261.0], dtype=np.float64)
     q_combiner = quantiles_util.QuantilesCombiner(5, 0.00001, has_weights=True)
     _run_quantiles_combiner_test(self, q_combiner, batches, expected_result)
 
+  def test_quantiles_combiner_pickled_summaries(self):
+    # Summaries are pickled when they are shuffled.
+    q_combiner = quantiles_util.QuantilesCombiner(5, 0.00001)
+    summaries = [
+        pickle.loads(pickle.dumps(q_combiner.add_input(
+            q_combiner.create_accumulator(), batch)))
+        for batch in [[np.linspace(1, 150, 150)],
+                      [np.linspace(151, 300, 150)]]]
+    result = q_combiner.extract_output(
+        q_combiner.merge_accumulators(summaries))
+    np.testing.assert_array_equal(result, [61.0, 121.0, 181.0, 241.0])
+
+  def test_quantiles_combiner_empty_summary(self):
+    q_combiner = quantiles_util.QuantilesCombiner(5, 0.01)
+    self.assertEqual(
+        q_combiner.extract_output(q_combiner.merge_accumulators(
+            [q_combiner.create_accumulator()])).size, 0)
+
   def test_generate_quantiles_histogram(self):
     result = quantiles_util.generate_quantiles_histogram(
-        quantiles=np.array([61.0, 121.0, 181.0, 241.0], dtype=np.float32),
+        quantiles=np.array([61.0, 121.0, 181.0, 241.0], dtype=np.float64),
         min_val=1.0, max_val=300.0, total_count=300.0, num_buckets=5)
     expected_result = text_format.Parse(
         """
@@ -109,7 +129,7 @@ class QuantilesUtilTest(absltest.TestCase):
   def test_generate_quantiles_histogram_diff_num_buckets_multiple(self):
     result = quantiles_util.generate_quantiles_histogram(
         quantiles=np.array([61.0, 121.0, 181.0, 241.0, 301.0],
-                           dtype=np.float32),
+                           dtype=np.float64),
         min_val=1.0, max_val=360.0, total_count=360.0, num_buckets=3)
     expected_result = text_format.Parse(
         """
@@ -135,7 +155,7 @@ class QuantilesUtilTest(absltest.TestCase):
   def test_generate_quantiles_histogram_diff_num_buckets_non_multiple(self):
     result = quantiles_util.generate_quantiles_histogram(
         quantiles=np.array([61.0, 121.0, 181.0, 241.0],
-                           dtype=np.float32),
+                           dtype=np.float64),
         min_val=1.0, max_val=300.0, total_count=300.0, num_buckets=4)
     expected_result = text_format.Parse(
         """
@@ -165,7 +185,7 @@ class QuantilesUtilTest(absltest.TestCase):
 
   def test_generate_equi_width_histogram(self):
     result = quantiles_util.generate_equi_width_histogram(
-        quantiles=np.array([1, 5, 10, 15, 20], dtype=np.float32),
+        quantiles=np.array([1, 5, 10, 15, 20], dtype=np.float64),
         min_val=0, max_val=24.0, total_count=18, num_buckets=3)
     expected_result = text_format.Parse(
         """
@@ -77,11 +77,24 @@ def generate_statistics_from_tfrecord(
   with beam.Pipeline(options=pipeline_options) as p:
     # Auto detect tfrecord file compression format based on input data
     # path suffix.
-    _ = (
+    examples = (
         p
-        | 'ReadData' >> beam.io.ReadFromTFRecord(file_pattern=data_location)
-        | 'DecodeData' >> beam.Map(tf_example_decoder.TFExampleDecoder().decode)
-        | 'GenerateStatistics' >> stats_api.GenerateStatistics(stats_options)
+        | 'ReadData' >> beam.io.ReadFromTFRecord(file_pattern=data_location))
+    if stats_options.sample_count is None and stats_options.sample_rate is None:
+      # Decode whole batches of examples natively.
+      stats = (
+          examples
+          | 'DecodeData' >> tf_example_decoder.DecodeTFExampleBatches()
+          | 'GenerateStatistics' >>
+          stats_api.GenerateStatisticsFromBatches(stats_options))
+    else:
+      stats = (
+          examples
+          | 'DecodeData' >> beam.Map(
+              tf_example_decoder.TFExampleDecoder().decode)
+          | 'GenerateStatistics' >> stats_api.GenerateStatistics(stats_options))
+    _ = (
+        stats
         | 'WriteStatsOutput' >> beam.io.WriteToTFRecord(
             output_path,
             shard_name_template='',
@@ -142,15 +155,30 @@ def generate_statistics_from_csv(
     skip_header_lines = 1 if column_names is None else 0
     if column_names is None:
       column_names = _get_csv_header(data_location, delimiter)
-    _ = (
+    lines = (
         p
         | 'ReadData' >> beam.io.textio.ReadFromText(
-            file_pattern=data_location, skip_header_lines=skip_header_lines)
-        | 'DecodeData' >> csv_decoder.DecodeCSV(
-            column_names=column_names, delimiter=delimiter,
-            schema=stats_options.schema,
-            infer_type_from_schema=stats_options.infer_type_from_schema)
-        | 'GenerateStatistics' >> stats_api.GenerateStatistics(stats_options)
+            file_pattern=data_location, skip_header_lines=skip_header_lines))
+    if stats_options.sample_count is None and stats_options.sample_rate is None:
+      # Decode whole batches of records natively.
+      stats = (
+          lines
+          | 'DecodeData' >> csv_decoder.DecodeCSVBatches(
+              column_names=column_names, delimiter=delimiter,
+              schema=stats_options.schema,
+              infer_type_from_schema=stats_options.infer_type_from_schema)
+          | 'GenerateStatistics' >>
+          stats_api.GenerateStatisticsFromBatches(stats_options))
+    else:
+      stats = (
+          lines
+          | 'DecodeData' >> csv_decoder.DecodeCSV(
+              column_names=column_names, delimiter=delimiter,
+              schema=stats_options.schema,
+              infer_type_from_schema=stats_options.infer_type_from_schema)
+          | 'GenerateStatistics' >> stats_api.GenerateStatistics(stats_options))
+    _ = (
+        stats
         | 'WriteStatsOutput' >> beam.io.WriteToTFRecord(
             output_path,
             shard_name_template='',
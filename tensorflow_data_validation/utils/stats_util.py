@@ -18,6 +18,8 @@ from __future__ import division
 
 from __future__ import print_function
 
+import math
+
 import numpy as np
 from tensorflow_data_validation import types
 from tensorflow_data_validation.types_compat import Dict, Optional
@@ -42,6 +44,19 @@ _NP_TYPE_TO_FEATURE_TYPE = {
     np.unicode_: statistics_pb2.FeatureNameStatistics.STRING,
 }
 
+# The names of the custom statistics of the features of statistics that are
+# computed over a sample of the examples. The validator reads them (see
+# FeatureStatsView::GetSampleRate()) so that it does not report sampling noise
+# as anomalies.
+SAMPLE_RATE_CUSTOM_STAT = 'sample_rate'
+NUM_NON_MISSING_LOWER_BOUND_CUSTOM_STAT = 'num_non_missing_lower_bound'
+NUM_NON_MISSING_UPPER_BOUND_CUSTOM_STAT = 'num_non_missing_upper_bound'
+MEAN_LOWER_BOUND_CUSTOM_STAT = 'mean_lower_bound'
+MEAN_UPPER_BOUND_CUSTOM_STAT = 'mean_upper_bound'
+
+# The z-score of the (95%) confidence intervals of the statistics of a sample.
+SAMPLING_Z_SCORE = 1.96
+
 
 def get_feature_type(
     dtype):
@@ -156,3 +171,74 @@ def get_weight_feature(input_batch,
       raise ValueError('Weight feature "{}" must have a single value. '
                        'Found {}.'.format(weight_feature, w))
   return weights
+
+
+def get_weights_array(weights):
+  """Gets the weights of the examples in a batch as a float64 numpy array.
+
+  Args:
+    weights: The weights returned by get_weight_feature.
+
+  Returns:
+    A 1-D float64 numpy array with the weight of each example.
+  """
+  return np.array([w[0] for w in weights], dtype=np.float64)
+
+
+def scale_sampled_count(count, sample_rate):
+  """Estimates a count over all the examples from its count over a sample.
+
+  Args:
+    count: A count over a sample in which each example was kept with
+        probability sample_rate.
+    sample_rate: The rate at which the examples were sampled.
+
+  Returns:
+    The estimated count over all the examples.
+  """
+  return int(round(count / sample_rate))
+
+
+def get_sampled_count_bounds(count, sample_rate
+                            ):
+  """Gets the confidence interval of a count over all the examples.
+
+  Args:
+    count: A count of examples over a sample in which each example was kept
+        with probability sample_rate.
+    sample_rate: The rate at which the examples were sampled.
+
+  Returns:
+    The lower and upper bounds of the confidence interval of the count over
+    all the examples.
+  """
+  # Each of the N examples counted is sampled with probability sample_rate,
+  # so the variance of count is N * sample_rate * (1 - sample_rate). It is
+  # estimated with count (or 1 if count is 0, so that a feature missing from
+  # the sample can still be present in the data).
+  estimate = count / sample_rate
+  margin = (SAMPLING_Z_SCORE * math.sqrt(max(count, 1) * (1 - sample_rate)) /
+            sample_rate)
+  # The count over all the examples is at least the count over the sample.
+  return max(float(count), estimate - margin), estimate + margin
+
+
+def add_sampling_custom_stats(
+    feature_stats_proto,
+    num_non_missing, sample_rate):
+  """Adds the sample rate and the bounds of num_non_missing to custom_stats.
+
+  Args:
+    feature_stats_proto: The FeatureNameStatistics proto of a feature, computed
+        over a sample of the examples.
+    num_non_missing: The number of examples of the sample with the feature.
+    sample_rate: The rate at which the examples were sampled.
+  """
+  lower_bound, upper_bound = get_sampled_count_bounds(num_non_missing,
+                                                      sample_rate)
+  feature_stats_proto.custom_stats.add(
+      name=SAMPLE_RATE_CUSTOM_STAT, num=sample_rate)
+  feature_stats_proto.custom_stats.add(
+      name=NUM_NON_MISSING_LOWER_BOUND_CUSTOM_STAT, num=lower_bound)
+  feature_stats_proto.custom_stats.add(
+      name=NUM_NON_MISSING_UPPER_BOUND_CUSTOM_STAT, num=upper_bound)
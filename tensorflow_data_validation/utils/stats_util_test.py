@@ -140,6 +140,12 @@ class StatsUtilTest(absltest.TestCase):
     with self.assertRaisesRegexp(ValueError, 'Weight feature.*single value'):
       stats_util.get_weight_feature(batch, 'w')
 
+  def test_get_weights_array(self):
+    weights = np.array([np.array([10]), np.array([2.5])])
+    actual = stats_util.get_weights_array(weights)
+    self.assertEqual(np.float64, actual.dtype)
+    np.testing.assert_equal(actual, [10.0, 2.5])
+
 
 if __name__ == '__main__':
   absltest.main()